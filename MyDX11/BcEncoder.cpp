@@ -0,0 +1,1017 @@
+#include "BcEncoder.h"
+#include <emmintrin.h>
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+	//channel order inside a Block and a palette entry
+	enum Channel {
+
+		R,
+		G,
+		B,
+		A,
+	};
+
+	//one 4x4 block, channel major so four texels of one channel load into one register
+	struct Block {
+
+		alignas(16) float c[4][16];
+	};
+
+	//expanded palette entry, same channel order as Block
+	struct Color4 {
+
+		float v[4];
+	};
+
+	//fraction of the second endpoint for each BC1 index in 4 color mode
+	constexpr float colorLerp[4] = { 0.0f,1.0f,1.0f / 3.0f,2.0f / 3.0f };
+
+	//BC7 4 bit index weights out of 64
+	constexpr int bc7Weights[16] = { 0,4,9,13,17,21,26,30,34,38,43,47,51,55,60,64 };
+
+	constexpr float rgbWeights[4] = { 1.0f,1.0f,1.0f,0.0f };
+	constexpr float rgbaWeights[4] = { 1.0f,1.0f,1.0f,1.0f };
+
+	inline float Clamp255(float v) noexcept
+	{
+		return std::min(255.0f, std::max(0.0f, v));
+	}
+
+	inline float HorizontalSum(__m128 v) noexcept
+	{
+		alignas(16) float f[4];
+		_mm_store_ps(f, v);
+
+		return f[0] + f[1] + f[2] + f[3];
+	}
+
+	void LoadBlock(const uint32_t* pSrc, unsigned int width, unsigned int height, unsigned int bx, unsigned int by, Block& block) noexcept
+	{
+		for (unsigned int y = 0; y < 4u; y++) {
+
+			const auto sy = std::min(by * 4u + y, height - 1u);
+
+			for (unsigned int x = 0; x < 4u; x++) {
+
+				const auto sx = std::min(bx * 4u + x, width - 1u);
+				const auto texel = pSrc[(size_t)sy * width + sx];
+				const auto i = y * 4u + x;
+
+				block.c[R][i] = (float)((texel >> 16u) & 0xFFu);
+				block.c[G][i] = (float)((texel >> 8u) & 0xFFu);
+				block.c[B][i] = (float)(texel & 0xFFu);
+				block.c[A][i] = (float)(texel >> 24u);
+			}
+		}
+	}
+
+	//nearest palette entry for every texel over the weighted channels, returns the summed squared error
+	float FitIndices(const Block& block, const float weights[4], const Color4* pPalette, unsigned int count, unsigned int* pIndices) noexcept
+	{
+		__m128 total = _mm_setzero_ps();
+
+		for (unsigned int i = 0; i < 16u; i += 4u) {
+
+			__m128 channels[4];
+
+			for (unsigned int c = 0; c < 4u; c++) {
+
+				channels[c] = _mm_load_ps(&block.c[c][i]);
+			}
+
+			__m128 best = _mm_set1_ps(FLT_MAX);
+			__m128 bestIndex = _mm_setzero_ps();
+
+			for (unsigned int k = 0; k < count; k++) {
+
+				__m128 dist = _mm_setzero_ps();
+
+				for (unsigned int c = 0; c < 4u; c++) {
+
+					if (weights[c] != 0.0f) {
+
+						const __m128 diff = _mm_sub_ps(channels[c], _mm_set1_ps(pPalette[k].v[c]));
+						dist = _mm_add_ps(dist, _mm_mul_ps(_mm_mul_ps(diff, diff), _mm_set1_ps(weights[c])));
+					}
+				}
+
+				//strictly closer keeps the lowest index on ties
+				const __m128 closer = _mm_cmplt_ps(dist, best);
+
+				best = _mm_min_ps(dist, best);
+				bestIndex = _mm_or_ps(_mm_and_ps(closer, _mm_set1_ps((float)k)), _mm_andnot_ps(closer, bestIndex));
+			}
+
+			total = _mm_add_ps(total, best);
+
+			alignas(16) int32_t indices[4];
+			_mm_store_si128(reinterpret_cast<__m128i*>(indices), _mm_cvttps_epi32(bestIndex));
+
+			for (unsigned int j = 0; j < 4u; j++) {
+
+				pIndices[i + j] = (unsigned int)indices[j];
+			}
+		}
+
+		return HorizontalSum(total);
+	}
+
+	//mean and dominant direction (unit length, zero for flat blocks) over the weighted channels
+	void PrincipalAxis(const Block& block, const float weights[4], float mean[4], float axis[4]) noexcept
+	{
+		__m128 centered[4][4];
+		float range[4];
+
+		for (unsigned int c = 0; c < 4u; c++) {
+
+			__m128 sum = _mm_setzero_ps();
+			__m128 lo = _mm_set1_ps(FLT_MAX);
+			__m128 hi = _mm_set1_ps(-FLT_MAX);
+
+			for (unsigned int i = 0; i < 16u; i += 4u) {
+
+				const __m128 v = _mm_load_ps(&block.c[c][i]);
+
+				sum = _mm_add_ps(sum, v);
+				lo = _mm_min_ps(lo, v);
+				hi = _mm_max_ps(hi, v);
+			}
+
+			alignas(16) float los[4], his[4];
+			_mm_store_ps(los, lo);
+			_mm_store_ps(his, hi);
+
+			mean[c] = HorizontalSum(sum) / 16.0f;
+			range[c] = weights[c] * (std::max(std::max(his[0], his[1]), std::max(his[2], his[3])) -
+				std::min(std::min(los[0], los[1]), std::min(los[2], los[3])));
+
+			const __m128 m = _mm_set1_ps(mean[c]);
+			const __m128 w = _mm_set1_ps(weights[c]);
+
+			for (unsigned int i = 0; i < 4u; i++) {
+
+				centered[c][i] = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(&block.c[c][i * 4u]), m), w);
+			}
+		}
+
+		float cov[4][4];
+
+		for (unsigned int i = 0; i < 4u; i++) {
+
+			for (unsigned int j = i; j < 4u; j++) {
+
+				__m128 sum = _mm_setzero_ps();
+
+				for (unsigned int k = 0; k < 4u; k++) {
+
+					sum = _mm_add_ps(sum, _mm_mul_ps(centered[i][k], centered[j][k]));
+				}
+
+				cov[i][j] = cov[j][i] = HorizontalSum(sum);
+			}
+		}
+
+		//power iteration from the channel ranges, which already point roughly the right way
+		float v[4] = { range[0],range[1],range[2],range[3] };
+
+		for (unsigned int iteration = 0; iteration < 8u; iteration++) {
+
+			float next[4];
+			float largest = 0.0f;
+
+			for (unsigned int i = 0; i < 4u; i++) {
+
+				next[i] = cov[i][0] * v[0] + cov[i][1] * v[1] + cov[i][2] * v[2] + cov[i][3] * v[3];
+				largest = std::max(largest, std::abs(next[i]));
+			}
+
+			if (largest == 0.0f) {
+
+				break;
+			}
+
+			for (unsigned int i = 0; i < 4u; i++) {
+
+				v[i] = next[i] / largest;
+			}
+		}
+
+		const float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2] + v[3] * v[3]);
+
+		for (unsigned int i = 0; i < 4u; i++) {
+
+			axis[i] = length > 0.0f ? v[i] / length : 0.0f;
+		}
+	}
+
+	//extremes of the block projected on the axis
+	void AxisEndpoints(const Block& block, const float mean[4], const float axis[4], float e0[4], float e1[4]) noexcept
+	{
+		__m128 lo = _mm_set1_ps(FLT_MAX);
+		__m128 hi = _mm_set1_ps(-FLT_MAX);
+
+		for (unsigned int i = 0; i < 16u; i += 4u) {
+
+			__m128 t = _mm_setzero_ps();
+
+			for (unsigned int c = 0; c < 4u; c++) {
+
+				t = _mm_add_ps(t, _mm_mul_ps(_mm_sub_ps(_mm_load_ps(&block.c[c][i]), _mm_set1_ps(mean[c])), _mm_set1_ps(axis[c])));
+			}
+
+			lo = _mm_min_ps(lo, t);
+			hi = _mm_max_ps(hi, t);
+		}
+
+		alignas(16) float los[4], his[4];
+		_mm_store_ps(los, lo);
+		_mm_store_ps(his, hi);
+
+		const float tMin = std::min(std::min(los[0], los[1]), std::min(los[2], los[3]));
+		const float tMax = std::max(std::max(his[0], his[1]), std::max(his[2], his[3]));
+
+		for (unsigned int c = 0; c < 4u; c++) {
+
+			e0[c] = Clamp255(mean[c] + axis[c] * tMin);
+			e1[c] = Clamp255(mean[c] + axis[c] * tMax);
+		}
+	}
+
+	//endpoints with the least squared error for fixed indices,
+	//false when every texel uses the same weight and the system has no unique answer
+	bool FitEndpoints(const Block& block, const unsigned int* pIndices, const float* pLerp, float e0[4], float e1[4]) noexcept
+	{
+		float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+		float ax[4] = {}, bx[4] = {};
+
+		for (unsigned int i = 0; i < 16u; i++) {
+
+			const float b = pLerp[pIndices[i]];
+			const float a = 1.0f - b;
+
+			aa += a * a;
+			ab += a * b;
+			bb += b * b;
+
+			for (unsigned int c = 0; c < 4u; c++) {
+
+				ax[c] += a * block.c[c][i];
+				bx[c] += b * block.c[c][i];
+			}
+		}
+
+		const float det = aa * bb - ab * ab;
+
+		if (std::abs(det) < 1e-6f) {
+
+			return false;
+		}
+
+		for (unsigned int c = 0; c < 4u; c++) {
+
+			e0[c] = Clamp255((ax[c] * bb - bx[c] * ab) / det);
+			e1[c] = Clamp255((bx[c] * aa - ax[c] * ab) / det);
+		}
+
+		return true;
+	}
+
+	//sets bits from the lowest up, the destination has to start zeroed
+	class BitWriter {
+
+	public:
+
+		explicit BitWriter(uint8_t* pDst) noexcept
+			:
+			m_pDst(pDst)
+		{}
+
+		void Put(unsigned int value, unsigned int bits) noexcept
+		{
+			for (unsigned int b = 0; b < bits; b++, m_pos++) {
+
+				if ((value >> b) & 1u) {
+
+					m_pDst[m_pos >> 3u] |= (uint8_t)(1u << (m_pos & 7u));
+				}
+			}
+		}
+
+	private:
+
+		uint8_t* m_pDst;
+		unsigned int m_pos = 0u;
+	};
+
+	class BitReader {
+
+	public:
+
+		explicit BitReader(const uint8_t* pSrc) noexcept
+			:
+			m_pSrc(pSrc)
+		{}
+
+		unsigned int Get(unsigned int bits) noexcept
+		{
+			unsigned int value = 0u;
+
+			for (unsigned int b = 0; b < bits; b++, m_pos++) {
+
+				value |= ((m_pSrc[m_pos >> 3u] >> (m_pos & 7u)) & 1u) << b;
+			}
+
+			return value;
+		}
+
+	private:
+
+		const uint8_t* m_pSrc;
+		unsigned int m_pos = 0u;
+	};
+
+	/// BC1 color block
+
+	uint16_t To565(const float c[4]) noexcept
+	{
+		const auto r = (unsigned int)std::lround(c[R] * 31.0f / 255.0f);
+		const auto g = (unsigned int)std::lround(c[G] * 63.0f / 255.0f);
+		const auto b = (unsigned int)std::lround(c[B] * 31.0f / 255.0f);
+
+		return (uint16_t)((r << 11u) | (g << 5u) | b);
+	}
+
+	//565 endpoint to 8 bit channels the way the hardware expands it
+	Color4 From565(uint16_t v) noexcept
+	{
+		const unsigned int r = v >> 11u;
+		const unsigned int g = (v >> 5u) & 0x3Fu;
+		const unsigned int b = v & 0x1Fu;
+
+		return { (float)((r << 3u) | (r >> 2u)),(float)((g << 2u) | (g >> 4u)),(float)((b << 3u) | (b >> 2u)),255.0f };
+	}
+
+	//4 color mode palette, interpolants rounded down like the reference decoder
+	void ColorPalette(uint16_t c0, uint16_t c1, Color4 palette[4]) noexcept
+	{
+		palette[0] = From565(c0);
+		palette[1] = From565(c1);
+
+		for (unsigned int c = 0; c < 4u; c++) {
+
+			const auto a = (unsigned int)palette[0].v[c];
+			const auto b = (unsigned int)palette[1].v[c];
+
+			palette[2].v[c] = (float)((2u * a + b) / 3u);
+			palette[3].v[c] = (float)((a + 2u * b) / 3u);
+		}
+	}
+
+	void EncodeColorBlock(const Block& block, uint8_t* pDst) noexcept
+	{
+		float mean[4], axis[4], e0[4], e1[4];
+
+		PrincipalAxis(block, rgbWeights, mean, axis);
+		AxisEndpoints(block, mean, axis, e0, e1);
+
+		uint16_t c0 = To565(e0);
+		uint16_t c1 = To565(e1);
+
+		Color4 palette[4];
+		unsigned int indices[16];
+
+		ColorPalette(c0, c1, palette);
+		float error = FitIndices(block, rgbWeights, palette, 4u, indices);
+
+		//the axis extremes overshoot on spread out blocks, least squares pulls them in
+		for (unsigned int iteration = 0; iteration < 2u && error > 0.0f; iteration++) {
+
+			if (!FitEndpoints(block, indices, colorLerp, e0, e1)) {
+
+				break;
+			}
+
+			const uint16_t n0 = To565(e0);
+			const uint16_t n1 = To565(e1);
+
+			if (n0 == c0 && n1 == c1) {
+
+				break;
+			}
+
+			unsigned int newIndices[16];
+
+			ColorPalette(n0, n1, palette);
+			const float newError = FitIndices(block, rgbWeights, palette, 4u, newIndices);
+
+			if (newError >= error) {
+
+				break;
+			}
+
+			c0 = n0;
+			c1 = n1;
+			error = newError;
+			std::copy(newIndices, newIndices + 16u, indices);
+		}
+
+		//4 color mode needs c0 > c1, swapping the endpoints swaps 0<->1 and 2<->3
+		if (c0 < c1) {
+
+			std::swap(c0, c1);
+
+			for (auto& i : indices) {
+
+				i ^= 1u;
+			}
+		}
+		else if (c0 == c1) {
+
+			std::fill(indices, indices + 16u, 0u);
+		}
+
+		uint32_t bits = 0u;
+
+		for (unsigned int i = 0; i < 16u; i++) {
+
+			bits |= indices[i] << (i * 2u);
+		}
+
+		pDst[0] = (uint8_t)(c0 & 0xFFu);
+		pDst[1] = (uint8_t)(c0 >> 8u);
+		pDst[2] = (uint8_t)(c1 & 0xFFu);
+		pDst[3] = (uint8_t)(c1 >> 8u);
+
+		for (unsigned int i = 0; i < 4u; i++) {
+
+			pDst[4u + i] = (uint8_t)((bits >> (i * 8u)) & 0xFFu);
+		}
+	}
+
+	//BC3 color blocks always interpolate 4 colors, BC1 switches to 3 + transparent when c0 <= c1
+	void DecodeColorBlock(const uint8_t* pSrc, bool alwaysFourColor, uint32_t texels[16]) noexcept
+	{
+		const uint16_t c0 = (uint16_t)(pSrc[0] | (pSrc[1] << 8u));
+		const uint16_t c1 = (uint16_t)(pSrc[2] | (pSrc[3] << 8u));
+
+		Color4 palette[4];
+		ColorPalette(c0, c1, palette);
+
+		if (!alwaysFourColor && c0 <= c1) {
+
+			for (unsigned int c = 0; c < 3u; c++) {
+
+				palette[2].v[c] = (float)(((unsigned int)palette[0].v[c] + (unsigned int)palette[1].v[c]) / 2u);
+				palette[3].v[c] = 0.0f;
+			}
+
+			palette[3].v[A] = 0.0f;
+		}
+
+		const uint32_t bits = pSrc[4] | (pSrc[5] << 8u) | (pSrc[6] << 16u) | ((uint32_t)pSrc[7] << 24u);
+
+		for (unsigned int i = 0; i < 16u; i++) {
+
+			const auto& p = palette[(bits >> (i * 2u)) & 3u];
+
+			texels[i] = ((uint32_t)p.v[A] << 24u) | ((uint32_t)p.v[R] << 16u) | ((uint32_t)p.v[G] << 8u) | (uint32_t)p.v[B];
+		}
+	}
+
+	/// 8 value block (BC3 alpha, BC4 and both BC5 channels)
+
+	//a0 > a1 interpolates 6 values between them, otherwise 4 plus the constants 0 and 255
+	void ValuePalette(unsigned int a0, unsigned int a1, float palette[8]) noexcept
+	{
+		palette[0] = (float)a0;
+		palette[1] = (float)a1;
+
+		if (a0 > a1) {
+
+			for (unsigned int k = 2u; k < 8u; k++) {
+
+				palette[k] = (float)(((8u - k) * a0 + (k - 1u) * a1) / 7u);
+			}
+		}
+		else {
+
+			for (unsigned int k = 2u; k < 6u; k++) {
+
+				palette[k] = (float)(((6u - k) * a0 + (k - 1u) * a1) / 5u);
+			}
+
+			palette[6] = 0.0f;
+			palette[7] = 255.0f;
+		}
+	}
+
+	float FitValues(const float* pValues, const float palette[8], unsigned int* pIndices) noexcept
+	{
+		__m128 total = _mm_setzero_ps();
+
+		for (unsigned int i = 0; i < 16u; i += 4u) {
+
+			const __m128 v = _mm_load_ps(pValues + i);
+
+			__m128 best = _mm_set1_ps(FLT_MAX);
+			__m128 bestIndex = _mm_setzero_ps();
+
+			for (unsigned int k = 0; k < 8u; k++) {
+
+				const __m128 diff = _mm_sub_ps(v, _mm_set1_ps(palette[k]));
+				const __m128 dist = _mm_mul_ps(diff, diff);
+				const __m128 closer = _mm_cmplt_ps(dist, best);
+
+				best = _mm_min_ps(dist, best);
+				bestIndex = _mm_or_ps(_mm_and_ps(closer, _mm_set1_ps((float)k)), _mm_andnot_ps(closer, bestIndex));
+			}
+
+			total = _mm_add_ps(total, best);
+
+			alignas(16) int32_t indices[4];
+			_mm_store_si128(reinterpret_cast<__m128i*>(indices), _mm_cvttps_epi32(bestIndex));
+
+			for (unsigned int j = 0; j < 4u; j++) {
+
+				pIndices[i + j] = (unsigned int)indices[j];
+			}
+		}
+
+		return HorizontalSum(total);
+	}
+
+	//pValues is one 16 float channel of a Block
+	void EncodeValueBlock(const float* pValues, uint8_t* pDst) noexcept
+	{
+		unsigned int lo = 255u, hi = 0u;
+		unsigned int innerLo = 255u, innerHi = 0u;
+
+		for (unsigned int i = 0; i < 16u; i++) {
+
+			const auto v = (unsigned int)pValues[i];
+
+			lo = std::min(lo, v);
+			hi = std::max(hi, v);
+
+			if (v != 0u && v != 255u) {
+
+				innerLo = std::min(innerLo, v);
+				innerHi = std::max(innerHi, v);
+			}
+		}
+
+		float palette[8];
+		unsigned int indices[16];
+
+		//8 interpolated values over the full range
+		unsigned int a0 = hi, a1 = lo;
+
+		ValuePalette(a0, a1, palette);
+		float error = FitValues(pValues, palette, indices);
+
+		//blocks that touch 0 or 255 may do better spending the interpolants on the rest
+		if (error > 0.0f && (lo == 0u || hi == 255u)) {
+
+			const unsigned int b0 = innerLo <= innerHi ? innerLo : 0u;
+			const unsigned int b1 = innerLo <= innerHi ? innerHi : 0u;
+
+			float otherPalette[8];
+			unsigned int otherIndices[16];
+
+			ValuePalette(b0, b1, otherPalette);
+			const float otherError = FitValues(pValues, otherPalette, otherIndices);
+
+			if (otherError < error) {
+
+				a0 = b0;
+				a1 = b1;
+				std::copy(otherIndices, otherIndices + 16u, indices);
+			}
+		}
+
+		uint64_t bits = 0u;
+
+		for (unsigned int i = 0; i < 16u; i++) {
+
+			bits |= (uint64_t)indices[i] << (i * 3u);
+		}
+
+		pDst[0] = (uint8_t)a0;
+		pDst[1] = (uint8_t)a1;
+
+		for (unsigned int i = 0; i < 6u; i++) {
+
+			pDst[2u + i] = (uint8_t)((bits >> (i * 8u)) & 0xFFu);
+		}
+	}
+
+	void DecodeValueBlock(const uint8_t* pSrc, uint8_t values[16]) noexcept
+	{
+		float palette[8];
+		ValuePalette(pSrc[0], pSrc[1], palette);
+
+		uint64_t bits = 0u;
+
+		for (unsigned int i = 0; i < 6u; i++) {
+
+			bits |= (uint64_t)pSrc[2u + i] << (i * 8u);
+		}
+
+		for (unsigned int i = 0; i < 16u; i++) {
+
+			values[i] = (uint8_t)palette[(bits >> (i * 3u)) & 7u];
+		}
+	}
+
+	/// BC7 mode 6
+
+	//7 bit endpoint plus the p bit shared by its four channels
+	struct Bc7Endpoint {
+
+		unsigned int q[4];
+		unsigned int p;
+	};
+
+	//picks the p bit that lands closest over all four channels
+	Bc7Endpoint QuantizeBc7(const float e[4]) noexcept
+	{
+		Bc7Endpoint best = {};
+		float bestError = FLT_MAX;
+
+		for (unsigned int p = 0; p < 2u; p++) {
+
+			Bc7Endpoint candidate = {};
+			candidate.p = p;
+
+			float error = 0.0f;
+
+			for (unsigned int c = 0; c < 4u; c++) {
+
+				const auto q = std::min(127l, std::max(0l, std::lround((e[c] - (float)p) / 2.0f)));
+				const float diff = (float)(((unsigned int)q << 1u) | p) - e[c];
+
+				candidate.q[c] = (unsigned int)q;
+				error += diff * diff;
+			}
+
+			if (error < bestError) {
+
+				bestError = error;
+				best = candidate;
+			}
+		}
+
+		return best;
+	}
+
+	void Bc7Palette(const Bc7Endpoint& e0, const Bc7Endpoint& e1, Color4 palette[16]) noexcept
+	{
+		for (unsigned int c = 0; c < 4u; c++) {
+
+			const int a = (int)((e0.q[c] << 1u) | e0.p);
+			const int b = (int)((e1.q[c] << 1u) | e1.p);
+
+			for (unsigned int k = 0; k < 16u; k++) {
+
+				palette[k].v[c] = (float)(((64 - bc7Weights[k]) * a + bc7Weights[k] * b + 32) >> 6);
+			}
+		}
+	}
+
+	bool SameEndpoint(const Bc7Endpoint& a, const Bc7Endpoint& b) noexcept
+	{
+		return a.p == b.p && std::equal(a.q, a.q + 4u, b.q);
+	}
+
+	void EncodeBc7Block(const Block& block, uint8_t* pDst) noexcept
+	{
+		float lerp[16];
+
+		for (unsigned int k = 0; k < 16u; k++) {
+
+			lerp[k] = bc7Weights[k] / 64.0f;
+		}
+
+		float mean[4], axis[4], f0[4], f1[4];
+
+		PrincipalAxis(block, rgbaWeights, mean, axis);
+		AxisEndpoints(block, mean, axis, f0, f1);
+
+		auto e0 = QuantizeBc7(f0);
+		auto e1 = QuantizeBc7(f1);
+
+		Color4 palette[16];
+		unsigned int indices[16];
+
+		Bc7Palette(e0, e1, palette);
+		float error = FitIndices(block, rgbaWeights, palette, 16u, indices);
+
+		for (unsigned int iteration = 0; iteration < 2u && error > 0.0f; iteration++) {
+
+			if (!FitEndpoints(block, indices, lerp, f0, f1)) {
+
+				break;
+			}
+
+			const auto n0 = QuantizeBc7(f0);
+			const auto n1 = QuantizeBc7(f1);
+
+			if (SameEndpoint(n0, e0) && SameEndpoint(n1, e1)) {
+
+				break;
+			}
+
+			unsigned int newIndices[16];
+
+			Bc7Palette(n0, n1, palette);
+			const float newError = FitIndices(block, rgbaWeights, palette, 16u, newIndices);
+
+			if (newError >= error) {
+
+				break;
+			}
+
+			e0 = n0;
+			e1 = n1;
+			error = newError;
+			std::copy(newIndices, newIndices + 16u, indices);
+		}
+
+		//the first index is stored without its top bit, so it has to be below 8
+		if (indices[0] >= 8u) {
+
+			std::swap(e0, e1);
+
+			for (auto& i : indices) {
+
+				i = 15u - i;
+			}
+		}
+
+		std::memset(pDst, 0, 16u);
+		BitWriter writer(pDst);
+
+		//mode 6 is a one in bit 6
+		writer.Put(1u << 6u, 7u);
+
+		for (unsigned int c = 0; c < 4u; c++) {
+
+			writer.Put(e0.q[c], 7u);
+			writer.Put(e1.q[c], 7u);
+		}
+
+		writer.Put(e0.p, 1u);
+		writer.Put(e1.p, 1u);
+
+		writer.Put(indices[0], 3u);
+
+		for (unsigned int i = 1u; i < 16u; i++) {
+
+			writer.Put(indices[i], 4u);
+		}
+	}
+
+	void DecodeBc7Block(const uint8_t* pSrc, uint32_t texels[16]) noexcept
+	{
+		BitReader reader(pSrc);
+
+		const auto mode = reader.Get(7u);
+		assert("Only BC7 mode 6 blocks can be decoded" && mode == (1u << 6u));
+		(void)mode;
+
+		Bc7Endpoint e0 = {}, e1 = {};
+
+		for (unsigned int c = 0; c < 4u; c++) {
+
+			e0.q[c] = reader.Get(7u);
+			e1.q[c] = reader.Get(7u);
+		}
+
+		e0.p = reader.Get(1u);
+		e1.p = reader.Get(1u);
+
+		Color4 palette[16];
+		Bc7Palette(e0, e1, palette);
+
+		for (unsigned int i = 0; i < 16u; i++) {
+
+			const auto& p = palette[reader.Get(i == 0u ? 3u : 4u)];
+
+			texels[i] = ((uint32_t)p.v[A] << 24u) | ((uint32_t)p.v[R] << 16u) | ((uint32_t)p.v[G] << 8u) | (uint32_t)p.v[B];
+		}
+	}
+}
+
+size_t BcEncoder::GetBlockBytes(BcFormat format) noexcept
+{
+	return format == BcFormat::BC1 || format == BcFormat::BC4 ? 8u : 16u;
+}
+
+unsigned int BcEncoder::CountBlocks(unsigned int size) noexcept
+{
+	return std::max(1u, (size + 3u) / 4u);
+}
+
+size_t BcEncoder::GetRowPitch(BcFormat format, unsigned int width) noexcept
+{
+	return CountBlocks(width) * GetBlockBytes(format);
+}
+
+size_t BcEncoder::GetLevelBytes(BcFormat format, unsigned int width, unsigned int height) noexcept
+{
+	return GetRowPitch(format, width) * CountBlocks(height);
+}
+
+double BcEncoder::Psnr(BcFormat format, const uint32_t* pA, const uint32_t* pB, size_t count) noexcept
+{
+	//byte masks of the channels the format stores, B8G8R8A8 order
+	uint32_t mask = 0xFFFFFFFFu;
+	unsigned int channels = 4u;
+
+	switch (format)
+	{
+	case BcFormat::BC1:
+
+		mask = 0x00FFFFFFu;
+		channels = 3u;
+		break;
+
+	case BcFormat::BC4:
+
+		mask = 0x00FF0000u;
+		channels = 1u;
+		break;
+
+	case BcFormat::BC5:
+
+		mask = 0x00FFFF00u;
+		channels = 2u;
+		break;
+
+	default:
+
+		break;
+	}
+
+	double sum = 0.0;
+
+	for (size_t i = 0; i < count; i++) {
+
+		const auto a = pA[i] & mask;
+		const auto b = pB[i] & mask;
+
+		for (unsigned int shift = 0; shift < 32u; shift += 8u) {
+
+			const double diff = (double)((a >> shift) & 0xFFu) - (double)((b >> shift) & 0xFFu);
+			sum += diff * diff;
+		}
+	}
+
+	if (sum == 0.0 || count == 0u) {
+
+		return std::numeric_limits<double>::infinity();
+	}
+
+	const double mse = sum / ((double)count * channels);
+
+	return 10.0 * std::log10(255.0 * 255.0 / mse);
+}
+
+BcEncoder::BcEncoder(BcFormat format) noexcept
+	:
+	m_format(format)
+{}
+
+BcFormat BcEncoder::GetFormat() const noexcept
+{
+	return m_format;
+}
+
+void BcEncoder::Run(const uint32_t* pSrc, unsigned int width, unsigned int height, uint8_t* pDst, unsigned int firstRow, unsigned int lastRow) const noexcept
+{
+	assert("Block compressing an empty image" && width != 0u && height != 0u);
+
+	const auto blocksAcross = CountBlocks(width);
+	const auto blockBytes = GetBlockBytes(m_format);
+	const auto rowPitch = GetRowPitch(m_format, width);
+
+	Block block;
+
+	for (unsigned int by = firstRow; by < lastRow; by++) {
+
+		auto pOut = pDst + (size_t)by * rowPitch;
+
+		for (unsigned int bx = 0; bx < blocksAcross; bx++, pOut += blockBytes) {
+
+			LoadBlock(pSrc, width, height, bx, by, block);
+
+			switch (m_format)
+			{
+			case BcFormat::BC1:
+
+				EncodeColorBlock(block, pOut);
+				break;
+
+			//alpha block first, then the color block
+			case BcFormat::BC3:
+
+				EncodeValueBlock(block.c[A], pOut);
+				EncodeColorBlock(block, pOut + 8u);
+				break;
+
+			case BcFormat::BC4:
+
+				EncodeValueBlock(block.c[R], pOut);
+				break;
+
+			case BcFormat::BC5:
+
+				EncodeValueBlock(block.c[R], pOut);
+				EncodeValueBlock(block.c[G], pOut + 8u);
+				break;
+
+			case BcFormat::BC7:
+
+				EncodeBc7Block(block, pOut);
+				break;
+			}
+		}
+	}
+}
+
+void BcEncoder::Decode(const uint8_t* pSrc, unsigned int width, unsigned int height, uint32_t* pDst) const noexcept
+{
+	const auto blocksAcross = CountBlocks(width);
+	const auto blocksDown = CountBlocks(height);
+	const auto blockBytes = GetBlockBytes(m_format);
+
+	for (unsigned int by = 0; by < blocksDown; by++) {
+
+		for (unsigned int bx = 0; bx < blocksAcross; bx++, pSrc += blockBytes) {
+
+			uint32_t texels[16];
+			uint8_t red[16], green[16];
+
+			switch (m_format)
+			{
+			case BcFormat::BC1:
+
+				DecodeColorBlock(pSrc, false, texels);
+				break;
+
+			case BcFormat::BC3:
+
+				DecodeValueBlock(pSrc, red);
+				DecodeColorBlock(pSrc + 8u, true, texels);
+
+				for (unsigned int i = 0; i < 16u; i++) {
+
+					texels[i] = (texels[i] & 0x00FFFFFFu) | ((uint32_t)red[i] << 24u);
+				}
+				break;
+
+			case BcFormat::BC4:
+
+				DecodeValueBlock(pSrc, red);
+
+				for (unsigned int i = 0; i < 16u; i++) {
+
+					texels[i] = 0xFF000000u | ((uint32_t)red[i] << 16u);
+				}
+				break;
+
+			case BcFormat::BC5:
+
+				DecodeValueBlock(pSrc, red);
+				DecodeValueBlock(pSrc + 8u, green);
+
+				for (unsigned int i = 0; i < 16u; i++) {
+
+					texels[i] = 0xFF000000u | ((uint32_t)red[i] << 16u) | ((uint32_t)green[i] << 8u);
+				}
+				break;
+
+			case BcFormat::BC7:
+
+				DecodeBc7Block(pSrc, texels);
+				break;
+			}
+
+			//partial edge blocks only write the texels inside the image
+			for (unsigned int y = 0; y < 4u && by * 4u + y < height; y++) {
+
+				for (unsigned int x = 0; x < 4u && bx * 4u + x < width; x++) {
+
+					pDst[(size_t)(by * 4u + y) * width + bx * 4u + x] = texels[y * 4u + x];
+				}
+			}
+		}
+	}
+}
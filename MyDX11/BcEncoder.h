@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+//block compressed layouts the encoder can write, values match nothing in dxgi on purpose
+//so this header builds without windows
+enum class BcFormat {
+
+	BC1,	//rgb 565 endpoints, 4 colors, opaque
+	BC3,	//BC1 color block plus a 8 value alpha block
+	BC4,	//red only, one 8 value block
+	BC5,	//red and green, two 8 value blocks
+	BC7,	//mode 6 only, rgba 7777 + p bit endpoints with 16 weights
+};
+
+/// <summary>
+/// CPU block compression of a B8G8R8A8 image (the Surface::Color layout) into 4x4 blocks
+/// endpoints come from the principal axis of each block then get refined by least squares,
+/// the index search runs over four texels at a time with SSE
+/// works on raw pixels only so it builds and runs without windows
+/// </summary>
+class BcEncoder {
+
+public:
+
+	//8 bytes per block for BC1 / BC4, 16 for the rest
+	static size_t GetBlockBytes(BcFormat format) noexcept;
+
+	//blocks along one axis, partial blocks at the edge count as whole ones
+	static unsigned int CountBlocks(unsigned int size) noexcept;
+
+	//bytes of one row of blocks / of a whole level
+	static size_t GetRowPitch(BcFormat format, unsigned int width) noexcept;
+	static size_t GetLevelBytes(BcFormat format, unsigned int width, unsigned int height) noexcept;
+
+	//peak signal to noise ratio in dB over the channels the format keeps,
+	//identical images give infinity
+	static double Psnr(BcFormat format, const uint32_t* pA, const uint32_t* pB, size_t count) noexcept;
+
+public:
+
+	explicit BcEncoder(BcFormat format) noexcept;
+
+	BcFormat GetFormat() const noexcept;
+
+	//encodes block rows [firstRow, lastRow) of a width x height image, texels past the
+	//edge repeat the last row / column, rows are independent so ranges can run in parallel
+	void Run(const uint32_t* pSrc, unsigned int width, unsigned int height, uint8_t* pDst, unsigned int firstRow, unsigned int lastRow) const noexcept;
+
+	//reverse of Run over the whole image, missing channels come back as 0 (alpha as 255)
+	//*only understands what Run writes (BC7 mode 6), meant for measuring the error
+	void Decode(const uint8_t* pSrc, unsigned int width, unsigned int height, uint32_t* pDst) const noexcept;
+
+private:
+
+	BcFormat m_format;
+};
@@ -25,4 +25,31 @@ namespace Bind {
 
     }
 
+    void Bindable::BindPixelView(Graphics& gfx, UINT slot, ID3D11ShaderResourceView* pView) noexcept
+    {
+        //slots past the cache are always bound
+        if (slot < gfx.pixelViews.size()) {
+
+            if (gfx.pixelViews[slot] == pView) {
+
+                return;
+            }
+
+            gfx.pixelViews[slot] = pView;
+        }
+
+        gfx.pContext->PSSetShaderResources(slot, 1u, &pView);
+    }
+
+    void Bindable::BindPixelSampler(Graphics& gfx, ID3D11SamplerState* pSampler) noexcept
+    {
+        if (gfx.pPixelSampler == pSampler) {
+
+            return;
+        }
+
+        gfx.pPixelSampler = pSampler;
+        gfx.pContext->PSSetSamplers(0u, 1u, &pSampler);
+    }
+
 }
\ No newline at end of file
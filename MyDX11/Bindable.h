@@ -18,6 +18,10 @@ namespace Bind {
 		static ID3D11Device* GetDevice(Graphics& gfx) noexcept;
 		static DxgiInfoManager& GetInfoManager(Graphics& gfx);
 
+		//skip the call when the same object is already bound there, meshes sharing a packed texture bind it once
+		static void BindPixelView(Graphics& gfx, UINT slot, ID3D11ShaderResourceView* pView) noexcept;
+		static void BindPixelSampler(Graphics& gfx, ID3D11SamplerState* pSampler) noexcept;
+
 	};
 
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ConstantBuffers.h"
+#include "DynamicConstantBuffers.h"
 #include "IndexBuffer.h"
 #include "InputLayout.h"
 #include "PixelShader.h"
@@ -1,3 +1,5 @@
+#include "ClusteredLights.hlsli"
+
 cbuffer LightCBuf
 {
     float3 lightPos;
@@ -13,7 +15,6 @@ cbuffer ObjectCBuf
 {
     float specularIntensity;
     float specularPower;
-    float padding[2];
 };
 
 
@@ -32,6 +33,10 @@ float4 main(float3 worldPos : Position, float3 n : Normal, float3 color : Color)
     const float3 r = w * 2.0f - vToL;
 	// calculate specular intensity based on angle between viewing vector and reflection vector, narrow with power function
     const float3 specular = att * (diffuseColor * diffuseIntensity) * specularIntensity * pow(max(0.0f, dot(normalize(-r), normalize(worldPos))), specularPower);
+	// the swarm's lights in this pixel's cluster
+    float3 clusterDiffuse;
+    float3 clusterSpecular;
+    ShadeClusteredLights(worldPos, n, specularPower, clusterDiffuse, clusterSpecular);
 	// final color
-    return float4(saturate((diffuse + ambient + specular) * color), 1.0f);
+    return float4(saturate((diffuse + clusterDiffuse + ambient + specular + clusterSpecular * specularIntensity) * color), 1.0f);
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "GraphicsThrowMacros.h"
 #include "Cube.h"
 #include "imgui/imgui.h"
+#include <cmath>
 
 
 
@@ -22,10 +23,30 @@ Box::Box(Graphics& gfx,
 		ddist,
 		odist,
 		rdist)
+{
+
+	//geometry is shared, only the material and transform are per box
+	pMesh = ResolveMesh(gfx);
+
+	//per instance material
+	materialConstants.color = material;
+
+	//model deformation transform(per instance,not stored as bind)
+	DirectX::XMStoreFloat3x3(&mt, DirectX::XMMatrixScaling(1.0f, 1.0f, bdist(rng)));
+
+}
+
+std::shared_ptr<InstancedMesh> Box::ResolveMesh(Graphics& gfx)
 {
 	using namespace Bind;
 
-	//Initialization for the buffers
+	//mesh lives as long as any box uses it
+	static std::weak_ptr<InstancedMesh> pShared;
+
+	if (auto pMesh = pShared.lock()) {
+
+		return pMesh;
+	}
 
 	//Create Vertex
 	struct Vertex {
@@ -37,19 +58,21 @@ Box::Box(Graphics& gfx,
 	auto model = Cube::MakeIndependent<Vertex>();
 	model.SetNormalsIndependentFlat();
 
+	std::vector<std::shared_ptr<Bindable>> binds;
+
 	//Bind Vertex Buffer
-	AddBind(std::make_shared<VertexBuffer>(gfx, model.vertices));
+	binds.push_back(std::make_shared<VertexBuffer>(gfx, model.vertices));
 
 	//Bind Vertex Shader
-	auto pvs = std::make_shared<VertexShader>(gfx, L"PhongVS.cso");
+	auto pvs = std::make_shared<VertexShader>(gfx, L"InstancedPhongVS.cso");
 	auto pvsbc = pvs->GetByteCode();
-	AddBind(std::move(pvs));
+	binds.push_back(std::move(pvs));
 
-	//Bind Pixel Shader
-	AddBind(std::make_shared<PixelShader>(gfx, L"PhongPS.cso"));
+	//Bind Pixel Shader (material comes from the instance)
+	binds.push_back(std::make_shared<PixelShader>(gfx, L"InstancedPhongPS.cso"));
 
 	//Bind Index Buffer
-	AddBind(std::make_shared<IndexBuffer>(gfx, model.indices));
+	binds.push_back(std::make_shared<IndexBuffer>(gfx, model.indices));
 
 	//Create Input Layout
 	const std::vector<D3D11_INPUT_ELEMENT_DESC> ied = {
@@ -59,86 +82,68 @@ Box::Box(Graphics& gfx,
 	};
 
 	//Bind Input Layout to the pipeline
-	AddBind(std::make_shared<InputLayout>(gfx, ied, pvsbc));
-
-	//Bind Topology
-	AddBind(std::make_shared<Topology>(gfx, D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST));
-
-
-
+	binds.push_back(InputLayout::Resolve(gfx, InstancedMesh::WithInstanceLayout(ied), pvsbc));
 
-	//Bind Transform Constant Buffer pipeline
-	AddBind(std::make_shared<TransformCbuf>(gfx, *this));
+	auto pMesh = std::make_shared<InstancedMesh>(gfx, std::move(binds));
+	pShared = pMesh;
+	return pMesh;
+}
 
-	//PS material constants
-	materialConstants.color = material;
-	AddBind(std::make_shared<MaterialCbuf>(gfx, materialConstants, 1u));
 
-	//model deformation transform(per instance,not stored as bind)
-	DirectX::XMStoreFloat3x3(&mt, DirectX::XMMatrixScaling(1.0f, 1.0f, bdist(rng)));
 
+float Box::GetBoundingRadius() const noexcept
+{
+	//half diagonal of the 1x1xz box
+	return 0.5f * std::sqrt(2.0f + mt.m[2][2] * mt.m[2][2]);
 }
 
+void Box::WriteInstance(InstanceData& instance, DirectX::FXMMATRIX world) const noexcept
+{
+	TestObject::WriteInstance(instance, DirectX::XMLoadFloat3x3(&mt) * world);
 
+	instance.materialColor = materialConstants.color;
+	instance.specularIntensity = materialConstants.specularIntensity;
+	instance.specularPower = materialConstants.specularPower;
+}
 
-DirectX::XMMATRIX Box::GetTransformXM() const noexcept
+bool Box::GetOccluderBox(DirectX::FXMMATRIX world, DirectX::XMFLOAT4X4& box) const noexcept
 {
-	return	DirectX::XMLoadFloat3x3(&mt) *
-		TestObject::GetTransformXM();
+	DirectX::XMStoreFloat4x4(&box, DirectX::XMLoadFloat3x3(&mt) * world);
+	return true;
 }
 
-bool Box::SpawnControlWindow(int id, Graphics& gfx) noexcept
+bool Box::SpawnControlWindow(int id, ObjectSimulation::Motion& motion, bool& isOpen) noexcept
 {
 
-	bool isDirty = false;
-	bool isOpen = true;
+	isOpen = true;
+	bool isMotionChanged = false;
 
 	//control window for ps material constants
 	if (ImGui::Begin(("Box" + std::to_string(id)).c_str(),&isOpen)) {
 
 		ImGui::Text("Material Properties");
 		//color
-		const auto cd = ImGui::ColorEdit3("Material Color", &materialConstants.color.x);
+		ImGui::ColorEdit3("Material Color", &materialConstants.color.x);
 
 		//lighting stuffs
-		const auto sid= ImGui::SliderFloat("Specular Intensity", &materialConstants.specularIntensity,0.05f,4.0f,"%.2f",2);
-		const auto spd=ImGui::SliderFloat("Specular Power", &materialConstants.specularPower, 1.0f, 200.0f, "%.2f", 2);
-
-		isDirty = cd || sid || spd;
+		ImGui::SliderFloat("Specular Intensity", &materialConstants.specularIntensity,0.05f,4.0f,"%.2f",2);
+		ImGui::SliderFloat("Specular Power", &materialConstants.specularPower, 1.0f, 200.0f, "%.2f", 2);
 
 		//Transform stuffs
 		ImGui::Text("Position");
 
-		ImGui::SliderFloat("R", &r, 0.0f, 80.0f, "%.1f");
-		ImGui::SliderAngle("Theta", &theta, -180.0f, 180.0f);
-		ImGui::SliderAngle("Phi", &phi, -180.0f, 180.0f);
+		isMotionChanged |= ImGui::SliderFloat("R", &motion.r, 0.0f, 80.0f, "%.1f");
+		isMotionChanged |= ImGui::SliderAngle("Theta", &motion.theta, -180.0f, 180.0f);
+		isMotionChanged |= ImGui::SliderAngle("Phi", &motion.phi, -180.0f, 180.0f);
 		
 		ImGui::Text("Orientation");
-		ImGui::SliderAngle("Roll", &roll, -180.0f, 180.0f);
-		ImGui::SliderAngle("Pitch", &pitch, -180.0f, 180.0f);
-		ImGui::SliderAngle("Yaw", &yaw, -180.0f, 180.0f);
+		isMotionChanged |= ImGui::SliderAngle("Roll", &motion.roll, -180.0f, 180.0f);
+		isMotionChanged |= ImGui::SliderAngle("Pitch", &motion.pitch, -180.0f, 180.0f);
+		isMotionChanged |= ImGui::SliderAngle("Yaw", &motion.yaw, -180.0f, 180.0f);
 
 	}
 
 	ImGui::End();
 
-	if (isDirty) {
-
-		SyncMaterial(gfx);
-
-	}
-
-	return isOpen;
-}
-
-void Box::SyncMaterial(Graphics& gfx) noexcept(!IS_DEBUG)
-{
-
-	//finding materialcbuff
-	auto pConstantPS = QueryBindable<MaterialCbuf>();
-
-	//checking pConstantPS is null pointer or not
-	assert(pConstantPS != nullptr);
-
-	pConstantPS->Update(gfx, materialConstants);
+	return isMotionChanged;
 }
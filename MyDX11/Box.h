@@ -1,9 +1,6 @@
 #pragma once
 
 #include "TestObjects.h"
-#include "ConstantBuffers.h"
-
-using namespace Bind;
 
 //Drawable Base templated on Box
 class Box :public TestObject {
@@ -19,33 +16,37 @@ public:
 		std::uniform_real_distribution<float>& bdist,
 		DirectX::XMFLOAT3 material);
 
-	//getter for getting the box's transform
-	DirectX::XMMATRIX GetTransformXM() const noexcept override;
+	//unit cube stretched along z
+	float GetBoundingRadius() const noexcept override;
+
+	//material and deformation go into the instance data every frame
+	void WriteInstance(InstanceData& instance, DirectX::FXMMATRIX world) const noexcept override;
 
-	//for imgui control windows
-	bool SpawnControlWindow(int id, Graphics& gfx) noexcept;
+	//the box itself, deformation included
+	bool GetOccluderBox(DirectX::FXMMATRIX world, DirectX::XMFLOAT4X4& box) const noexcept override;
+
+	//for imgui control windows (position/orientation live in the simulation)
+	//returns whether a motion slider moved, so the simulation is only written then
+	bool SpawnControlWindow(int id, ObjectSimulation::Motion& motion, bool& isOpen) noexcept;
 
 private:
 
-	//for syncing materials data
-	void SyncMaterial(Graphics& gfx) noexcept(!IS_DEBUG);
+	//every box shares one cube mesh
+	static std::shared_ptr<InstancedMesh> ResolveMesh(Graphics& gfx);
 
 private:
 
-	//PS material constant stuffs
+	//per instance material stuffs
 
-	struct PSMaterialConstant {
+	struct Material {
 
 		DirectX::XMFLOAT3 color;
 
 		//Lighting stuffs
 		float specularIntensity = 0.6f;
 		float specularPower = 30.0f;
-		float padding[3];
 	}materialConstants;
 
-	using MaterialCbuf = PixelConstantBuffer<PSMaterialConstant>;
-
 private:
 
 	//model transform
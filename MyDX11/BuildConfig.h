@@ -0,0 +1,11 @@
+#pragma once
+
+//IS_DEBUG comes from the project's configurations (true for Debug, false for Release)
+//builds without them, like the portable units' tests, take it from NDEBUG the way assert does
+#ifndef IS_DEBUG
+#ifdef NDEBUG
+#define IS_DEBUG false
+#else
+#define IS_DEBUG true
+#endif
+#endif
@@ -0,0 +1,51 @@
+#include "ClusteredLights.h"
+
+namespace {
+
+	//ClusterCBuf as declared in ClusteredLights.hlsli
+	MyDynamicConstant::CbufLayout MakeClusterLayout()
+	{
+		using MyDynamicConstant::CbufLayout;
+
+		CbufLayout layout;
+		layout.Append(CbufLayout::Float2, "projectionScale");
+		layout.Append(CbufLayout::Float, "sliceScale");
+		layout.Append(CbufLayout::Float, "sliceBias");
+		//*the layouts have no integers, counts this small are exact as floats
+		layout.Append(CbufLayout::Float3, "clusterCounts");
+
+		return layout;
+	}
+}
+
+ClusteredLights::ClusteredLights(Graphics& gfx)
+	:
+	m_lights(gfx, DXGI_FORMAT_R32G32B32A32_FLOAT, 2u * 256u, 5u),
+	m_ranges(gfx, DXGI_FORMAT_R32G32_UINT, 16u * 9u * 24u, 6u),
+	m_indices(gfx, DXGI_FORMAT_R16_UINT, 16u * 1024u, 7u),
+	m_constants(gfx, MakeClusterLayout(), 2u)
+{
+	//nothing is lit by clusters until the first Update, a zero count is all the shaders read then
+	m_ranges.Update(gfx, std::vector<LightClusters::Range>(16u * 9u * 24u, LightClusters::Range{ 0u,0u }));
+}
+
+void ClusteredLights::Update(Graphics& gfx, const Frame& frame)
+{
+	m_lights.Update(gfx, frame.lights);
+	m_ranges.Update(gfx, frame.ranges);
+	m_indices.Update(gfx, frame.indices);
+
+	auto& buffer = m_constants.GetBuffer();
+	buffer["projectionScale"] = frame.projectionScale;
+	buffer["sliceScale"] = frame.sliceScale;
+	buffer["sliceBias"] = frame.sliceBias;
+	buffer["clusterCounts"] = DirectX::XMFLOAT3{ (float)frame.tilesX,(float)frame.tilesY,(float)frame.slices };
+}
+
+void ClusteredLights::Bind(Graphics& gfx) noexcept
+{
+	m_lights.Bind(gfx);
+	m_ranges.Bind(gfx);
+	m_indices.Bind(gfx);
+	m_constants.Bind(gfx);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "graphics.h"
+#include "LightClusters.h"
+#include "ShaderBuffer.h"
+#include "DynamicConstantBuffers.h"
+#include <DirectXMath.h>
+#include <vector>
+#include <cstdint>
+
+/// <summary>
+/// Uploads the cluster grid LightClusters built to the buffers the phong pixel shaders loop over (ClusteredLights.hlsli)
+/// lights go to t5, the clusters' ranges to t6, the index list to t7 and the grid constants to b2
+/// </summary>
+class ClusteredLights {
+
+public:
+
+	//one frame of lights and clusters, copied into the frame packet by the simulation thread
+	struct Frame {
+
+		//two per light: view space position and range, then color times intensity
+		std::vector<DirectX::XMFLOAT4> lights;
+		std::vector<LightClusters::Range> ranges;
+		std::vector<uint16_t> indices;
+
+		DirectX::XMFLOAT2 projectionScale = { 1.0f,1.0f };
+		float sliceScale = 0.0f;
+		float sliceBias = 0.0f;
+		unsigned int tilesX = 1u;
+		unsigned int tilesY = 1u;
+		unsigned int slices = 1u;
+	};
+
+public:
+
+	ClusteredLights(Graphics& gfx);
+
+	void Update(Graphics& gfx, const Frame& frame);
+	void Bind(Graphics& gfx) noexcept;
+
+private:
+
+	Bind::ShaderBuffer<DirectX::XMFLOAT4> m_lights;
+	Bind::ShaderBuffer<LightClusters::Range> m_ranges;
+	Bind::ShaderBuffer<uint16_t> m_indices;
+	Bind::DynamicPixelConstantBuffer m_constants;
+};
@@ -0,0 +1,59 @@
+
+//grid of view space clusters the cpu fills with the lights reaching into each one every frame (LightClusters)
+cbuffer ClusterCBuf : register(b2)
+{
+    
+    float2 clusterProjectionScale;
+    float clusterSliceScale;
+    float clusterSliceBias;
+    float3 clusterCounts;
+};
+
+//two texels a light: view space position and range, then color times intensity
+Buffer<float4> clusterLights : register(t5);
+//offset and count of every cluster's lights in clusterIndices
+Buffer<uint2> clusterRanges : register(t6);
+Buffer<uint> clusterIndices : register(t7);
+
+//same as LightClusters::GetClusterIndex, points off the grid are clamped onto it
+uint GetClusterIndex(float3 viewPos)
+{
+    const float2 ndc = viewPos.xy * clusterProjectionScale / viewPos.z;
+    const float2 tile = clamp(floor((ndc * 0.5f + 0.5f) * clusterCounts.xy), 0.0f, clusterCounts.xy - 1.0f);
+    const float slice = clamp(floor(log2(viewPos.z) * clusterSliceScale + clusterSliceBias), 0.0f, clusterCounts.z - 1.0f);
+    
+    return (uint) ((slice * clusterCounts.y + tile.y) * clusterCounts.x + tile.x);
+}
+
+//diffuse and specular of the lights in the pixel's cluster only, the material is applied by the caller
+void ShadeClusteredLights(float3 viewPos, float3 n, float specularPower, out float3 diffuse, out float3 specular)
+{
+    diffuse = 0.0f;
+    specular = 0.0f;
+    
+    const uint2 range = clusterRanges.Load(GetClusterIndex(viewPos));
+    
+    for (uint i = 0; i < range.y; i++)
+    {
+        const uint light = clusterIndices.Load(range.x + i);
+        const float4 positionRange = clusterLights.Load(light * 2u);
+        const float3 color = clusterLights.Load(light * 2u + 1u).rgb;
+        
+        //fragment to light vector data
+        const float3 vToL = positionRange.xyz - viewPos;
+        const float distSq = max(dot(vToL, vToL), 0.0001f);
+        const float3 dirToL = vToL * rsqrt(distSq);
+        
+        //inverse square falloff windowed to zero at the range, past it the light isn't in the cluster lists
+        const float t = distSq / (positionRange.w * positionRange.w);
+        const float window = saturate(1.0f - t * t);
+        const float att = window * window / (distSq + 1.0f);
+        
+        diffuse += color * att * max(0.0f, dot(dirToL, n));
+        
+        //reflected light vector, same specular as the main light
+        const float3 r = n * dot(vToL, n) * 2.0f - vToL;
+        
+        specular += color * att * pow(max(0.0f, dot(normalize(-r), normalize(viewPos))), specularPower);
+    }
+}
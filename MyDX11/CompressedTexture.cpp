@@ -0,0 +1,356 @@
+#include "CompressedTexture.h"
+#include "MipChain.h"
+#include "JobSystem.h"
+#include "DdsFile.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+namespace {
+
+	//bump whenever the encoder output changes so stale cache files are ignored
+	constexpr uint32_t encoderVersion = 1u;
+	constexpr char cacheMagic[4] = { 'B','C','T','X' };
+
+	//blocks per job, small levels end up in a single job
+	constexpr size_t blocksPerJob = 4096u;
+
+	//FNV-1a, cheap next to the encoder and good enough to tell textures apart
+	class Hasher {
+
+	public:
+
+		void Add(const void* pData, size_t size) noexcept
+		{
+			const auto pBytes = static_cast<const uint8_t*>(pData);
+
+			for (size_t i = 0; i < size; i++) {
+
+				m_hash = (m_hash ^ pBytes[i]) * 0x100000001B3ull;
+			}
+		}
+
+		template<typename T>
+		void Add(const T& value) noexcept
+		{
+			Add(&value, sizeof(T));
+		}
+
+		uint64_t Get() const noexcept
+		{
+			return m_hash;
+		}
+
+	private:
+
+		uint64_t m_hash = 0xCBF29CE484222325ull;
+	};
+
+	bool IsOpaque(const Surface& surface) noexcept
+	{
+		const auto pTexels = surface.GetBufferPtr();
+		const size_t count = (size_t)surface.GetWidth() * surface.GetHeight();
+
+		return std::all_of(pTexels, pTexels + count, [](Surface::Color c) { return c.GetA() == 255u; });
+	}
+
+	DdsFormat ToDdsFormat(BcFormat format) noexcept
+	{
+		switch (format)
+		{
+		case BcFormat::BC1:
+
+			return DdsFormat::BC1Unorm;
+
+		case BcFormat::BC3:
+
+			return DdsFormat::BC3Unorm;
+
+		case BcFormat::BC4:
+
+			return DdsFormat::BC4Unorm;
+
+		case BcFormat::BC5:
+
+			return DdsFormat::BC5Unorm;
+
+		case BcFormat::BC7:
+
+			return DdsFormat::BC7Unorm;
+		}
+
+		return DdsFormat::Unknown;
+	}
+
+	const char* GetFormatName(BcFormat format) noexcept
+	{
+		switch (format)
+		{
+		case BcFormat::BC1:
+
+			return "BC1";
+
+		case BcFormat::BC3:
+
+			return "BC3";
+
+		case BcFormat::BC4:
+
+			return "BC4";
+
+		case BcFormat::BC5:
+
+			return "BC5";
+
+		case BcFormat::BC7:
+
+			return "BC7";
+		}
+
+		return "?";
+	}
+}
+
+bool CompressedTexture::CanCompress(const Surface& top) noexcept
+{
+	return top.GetWidth() % 4u == 0u && top.GetHeight() % 4u == 0u;
+}
+
+CompressedTexture::CompressedTexture(const MipChain& mips, Role role, bool highQuality, JobSystem* pJobs, std::string cacheDir)
+{
+	const auto& top = mips.GetLevel(0);
+
+	assert("Top level has to be whole blocks" && CanCompress(top));
+
+	switch (role)
+	{
+	case Role::Normal:
+
+		m_format = BcFormat::BC5;
+		break;
+
+	default:
+
+		m_format = highQuality ? BcFormat::BC7 : IsOpaque(top) ? BcFormat::BC1 : BcFormat::BC3;
+		break;
+	}
+
+	//key covers every source level, the format and the encoder that produced the blocks
+	Hasher hasher;
+	hasher.Add(encoderVersion);
+	hasher.Add(m_format);
+
+	for (size_t i = 0; i < mips.GetLevelCount(); i++) {
+
+		const auto& level = mips.GetLevel(i);
+
+		hasher.Add(level.GetWidth());
+		hasher.Add(level.GetHeight());
+		hasher.Add(level.GetBufferPtr(), (size_t)level.GetWidth() * level.GetHeight() * sizeof(Surface::Color));
+	}
+
+	const auto key = hasher.Get();
+
+	std::ostringstream name;
+	name << std::hex << std::setw(16) << std::setfill('0') << key << ".bctx";
+
+	const auto cachePath = (std::filesystem::path(cacheDir) / name.str()).string();
+
+	m_isFromCache = LoadCache(cachePath, key);
+
+	if (!m_isFromCache) {
+
+		const BcEncoder encoder(m_format);
+
+		m_levels.resize(mips.GetLevelCount());
+
+		for (size_t i = 0; i < m_levels.size(); i++) {
+
+			const auto& src = mips.GetLevel(i);
+			auto& dst = m_levels[i];
+
+			dst.width = src.GetWidth();
+			dst.height = src.GetHeight();
+			dst.blocks.resize(BcEncoder::GetLevelBytes(m_format, dst.width, dst.height));
+
+			//Color is a single dword in B8G8R8A8 order, the encoder works on the raw texels
+			const auto pSrc = reinterpret_cast<const uint32_t*>(src.GetBufferPtr());
+			const auto blockRows = BcEncoder::CountBlocks(dst.height);
+
+			if (pJobs != nullptr) {
+
+				const auto rowsPerJob = std::max<size_t>(1u, blocksPerJob / BcEncoder::CountBlocks(dst.width));
+
+				pJobs->ParallelFor(blockRows, rowsPerJob, [&](size_t first, size_t last) {
+
+					encoder.Run(pSrc, dst.width, dst.height, dst.blocks.data(), (unsigned int)first, (unsigned int)last);
+				});
+			}
+			else {
+
+				encoder.Run(pSrc, dst.width, dst.height, dst.blocks.data(), 0u, blockRows);
+			}
+
+			//decode again to measure what was lost
+			std::vector<uint32_t> decoded((size_t)dst.width * dst.height);
+			encoder.Decode(dst.blocks.data(), dst.width, dst.height, decoded.data());
+
+			dst.psnr = BcEncoder::Psnr(m_format, pSrc, decoded.data(), decoded.size());
+		}
+
+		std::error_code ec;
+		std::filesystem::create_directories(cacheDir, ec);
+
+		SaveCache(cachePath, key);
+	}
+
+	std::ostringstream oss;
+	oss << "[CompressedTexture] " << GetFormatName(m_format) << " " << top.GetWidth() << "x" << top.GetHeight()
+		<< " psnr " << std::fixed << std::setprecision(2) << m_levels.front().psnr << " dB"
+		<< (m_isFromCache ? " (cache)" : "") << std::endl;
+
+	OutputDebugStringA(oss.str().c_str());
+}
+
+BcFormat CompressedTexture::GetFormat() const noexcept
+{
+	return m_format;
+}
+
+size_t CompressedTexture::GetLevelCount() const noexcept
+{
+	return m_levels.size();
+}
+
+const CompressedTexture::Level& CompressedTexture::GetLevel(size_t level) const noexcept(!IS_DEBUG)
+{
+	assert("Mip level out of range" && level < m_levels.size());
+
+	return m_levels[level];
+}
+
+bool CompressedTexture::IsFromCache() const noexcept
+{
+	return m_isFromCache;
+}
+
+void CompressedTexture::SaveDds(const std::string& path) const
+{
+	DdsFile::Description desc;
+	desc.format = ToDdsFormat(m_format);
+	desc.width = m_levels.front().width;
+	desc.height = m_levels.front().height;
+	desc.mipLevels = (unsigned int)m_levels.size();
+
+	std::vector<DdsFile::Subresource> subresources;
+
+	for (const auto& level : m_levels) {
+
+		subresources.push_back({ level.blocks.data(), level.width, level.height,
+			BcEncoder::GetRowPitch(m_format, level.width), level.blocks.size() });
+	}
+
+	DdsFile::Write(path, desc, subresources);
+}
+
+//cache file: magic, version, format, key, level count, then per level width, height, psnr, byte count and the blocks
+bool CompressedTexture::LoadCache(const std::string& path, uint64_t key)
+{
+	std::ifstream file(path, std::ios::binary);
+
+	if (!file) {
+
+		return false;
+	}
+
+	char magic[4];
+	uint32_t version, format, levelCount;
+	uint64_t fileKey;
+
+	file.read(magic, sizeof(magic));
+	file.read(reinterpret_cast<char*>(&version), sizeof(version));
+	file.read(reinterpret_cast<char*>(&format), sizeof(format));
+	file.read(reinterpret_cast<char*>(&fileKey), sizeof(fileKey));
+	file.read(reinterpret_cast<char*>(&levelCount), sizeof(levelCount));
+
+	if (!file || !std::equal(magic, magic + 4, cacheMagic) || version != encoderVersion ||
+		format != (uint32_t)m_format || fileKey != key) {
+
+		return false;
+	}
+
+	std::vector<Level> levels(levelCount);
+
+	for (auto& level : levels) {
+
+		uint64_t size;
+
+		file.read(reinterpret_cast<char*>(&level.width), sizeof(level.width));
+		file.read(reinterpret_cast<char*>(&level.height), sizeof(level.height));
+		file.read(reinterpret_cast<char*>(&level.psnr), sizeof(level.psnr));
+		file.read(reinterpret_cast<char*>(&size), sizeof(size));
+
+		//a truncated or foreign file just means encoding again
+		if (!file || size != BcEncoder::GetLevelBytes(m_format, level.width, level.height)) {
+
+			return false;
+		}
+
+		level.blocks.resize((size_t)size);
+		file.read(reinterpret_cast<char*>(level.blocks.data()), (std::streamsize)size);
+	}
+
+	if (!file) {
+
+		return false;
+	}
+
+	m_levels = std::move(levels);
+	return true;
+}
+
+void CompressedTexture::SaveCache(const std::string& path, uint64_t key) const
+{
+	//written next to the target and renamed so a crash never leaves half a file behind
+	const auto tempPath = path + ".tmp";
+
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+
+		const uint32_t version = encoderVersion;
+		const uint32_t format = (uint32_t)m_format;
+		const uint32_t levelCount = (uint32_t)m_levels.size();
+
+		file.write(cacheMagic, sizeof(cacheMagic));
+		file.write(reinterpret_cast<const char*>(&version), sizeof(version));
+		file.write(reinterpret_cast<const char*>(&format), sizeof(format));
+		file.write(reinterpret_cast<const char*>(&key), sizeof(key));
+		file.write(reinterpret_cast<const char*>(&levelCount), sizeof(levelCount));
+
+		for (const auto& level : m_levels) {
+
+			const uint64_t size = level.blocks.size();
+
+			file.write(reinterpret_cast<const char*>(&level.width), sizeof(level.width));
+			file.write(reinterpret_cast<const char*>(&level.height), sizeof(level.height));
+			file.write(reinterpret_cast<const char*>(&level.psnr), sizeof(level.psnr));
+			file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+			file.write(reinterpret_cast<const char*>(level.blocks.data()), (std::streamsize)size);
+		}
+
+		//the cache is only a shortcut, failing to write it is not an error
+		if (!file) {
+
+			file.close();
+
+			std::error_code ec;
+			std::filesystem::remove(tempPath, ec);
+			return;
+		}
+	}
+
+	std::error_code ec;
+	std::filesystem::rename(tempPath, path, ec);
+}
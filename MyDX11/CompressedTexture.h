@@ -0,0 +1,68 @@
+#pragma once
+
+#include "BcEncoder.h"
+#include "Surface.h"
+#include <vector>
+#include <string>
+
+class MipChain;
+class JobSystem;
+
+/// <summary>
+/// Block compressed copy of a mip chain, the format follows what the texture is used for
+/// levels are encoded once on the job system and kept in a disk cache keyed by the source texels
+/// </summary>
+class CompressedTexture {
+
+public:
+
+	//what the texture feeds in the shader decides which channels have to survive
+	enum class Role {
+
+		Diffuse,	//BC1 when opaque, BC3 otherwise
+		Specular,	//same as diffuse, the phong shaders read the color from rgb and the power from alpha
+		Normal,		//BC5, x and y only, z is rebuilt in the shader
+	};
+
+	struct Level {
+
+		unsigned int width;
+		unsigned int height;
+		std::vector<uint8_t> blocks;
+
+		//quality of this level against the source
+		double psnr;
+	};
+
+public:
+
+	//d3d11 only takes block compressed textures whose top level is made of whole blocks
+	static bool CanCompress(const Surface& top) noexcept;
+
+public:
+
+	//highQuality switches the color roles to BC7
+	CompressedTexture(const MipChain& mips, Role role, bool highQuality = false, JobSystem* pJobs = nullptr, std::string cacheDir = "asset\\cache");
+
+	BcFormat GetFormat() const noexcept;
+
+	size_t GetLevelCount() const noexcept;
+	const Level& GetLevel(size_t level) const noexcept(!IS_DEBUG);
+
+	//true when the blocks came from the disk cache instead of the encoder
+	bool IsFromCache() const noexcept;
+
+	//every level as a DDS the texture can later be created from without encoding again
+	void SaveDds(const std::string& path) const;
+
+private:
+
+	bool LoadCache(const std::string& path, uint64_t key);
+	void SaveCache(const std::string& path, uint64_t key) const;
+
+private:
+
+	BcFormat m_format;
+	std::vector<Level> m_levels;
+	bool m_isFromCache = false;
+};
@@ -1,6 +1,7 @@
 #include "Cylinder.h"
 #include "Prism.h"
 #include "BindableBase.h"
+#include <unordered_map>
 
 Cylinder::Cylinder(Graphics& gfx, 
 	std::mt19937& rng, 
@@ -13,15 +14,32 @@ Cylinder::Cylinder(Graphics& gfx,
 	:TestObject(gfx,rng,adist,ddist,odist,rdist)
 {
 
+	pMesh = ResolveMesh(gfx, tdist(rng));
+
+}
+
+std::shared_ptr<InstancedMesh> Cylinder::ResolveMesh(Graphics& gfx, int tesselation)
+{
 	using namespace Bind;
+
+	//one mesh per tesselation level, shared by every cylinder using it
+	static std::unordered_map<int, std::weak_ptr<InstancedMesh>> meshes;
+
+	auto& pShared = meshes[tesselation];
+
+	if (auto pMesh = pShared.lock()) {
+
+		return pMesh;
+	}
+
+	std::vector<std::shared_ptr<Bindable>> binds;
 	
-	
-	auto pvs = std::make_shared<VertexShader>(gfx, L"PhongVS.cso");
+	auto pvs = std::make_shared<VertexShader>(gfx, L"InstancedPhongVS.cso");
 	auto pvsbc = pvs->GetByteCode();
 
-	AddBind(std::move(pvs));
+	binds.push_back(std::move(pvs));
 
-	AddBind(std::make_shared<PixelShader>(gfx, L"IndexedPhongPS.cso"));
+	binds.push_back(std::make_shared<PixelShader>(gfx, L"IndexedPhongPS.cso"));
 
 	
 	const std::vector<D3D11_INPUT_ELEMENT_DESC> ied = {
@@ -30,29 +48,25 @@ Cylinder::Cylinder(Graphics& gfx,
 
 	};
 
-	AddBind(std::make_shared<InputLayout>(gfx, ied, pvsbc));
-
-	AddBind(std::make_shared<Topology>(gfx, D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST));
-
-	struct PSMaterialConstant {
+	binds.push_back(InputLayout::Resolve(gfx, InstancedMesh::WithInstanceLayout(ied), pvsbc));
 
-		DirectX::XMFLOAT3A colors[6] = {
+	//material constant (ObjectCBuf in IndexedPhongPS)
+	MyDynamicConstant::CbufLayout matLayout;
+	matLayout.Append(MyDynamicConstant::CbufLayout::Float3, "materialColor", 6u);
+	matLayout.Append(MyDynamicConstant::CbufLayout::Float, "specularIntensity");
+	matLayout.Append(MyDynamicConstant::CbufLayout::Float, "specularPower");
 
-			{1.0f,0.0f,0.0f},
-			{0.0f,1.0f,0.0f},
-			{0.0f,0.0f,1.0f},
-			{1.0f,1.0f,0.0f},
-			{1.0f,0.0f,1.0f},
-			{0.0f,1.0f,1.0f},
+	MyDynamicConstant::CbufBuffer matConst(std::move(matLayout));
+	matConst["materialColor"][0] = DirectX::XMFLOAT3{ 1.0f,0.0f,0.0f };
+	matConst["materialColor"][1] = DirectX::XMFLOAT3{ 0.0f,1.0f,0.0f };
+	matConst["materialColor"][2] = DirectX::XMFLOAT3{ 0.0f,0.0f,1.0f };
+	matConst["materialColor"][3] = DirectX::XMFLOAT3{ 1.0f,1.0f,0.0f };
+	matConst["materialColor"][4] = DirectX::XMFLOAT3{ 1.0f,0.0f,1.0f };
+	matConst["materialColor"][5] = DirectX::XMFLOAT3{ 0.0f,1.0f,1.0f };
+	matConst["specularIntensity"] = 0.6f;
+	matConst["specularPower"] = 30.0f;
 
-		};
-
-		float specularIntensity = 0.6f;
-		float specularPower = 30.0f;
-
-	}matConst;
-
-	AddBind(std::make_shared<PixelConstantBuffer<PSMaterialConstant>>(gfx, matConst, 1u));
+	binds.push_back(std::make_shared<DynamicPixelConstantBuffer>(gfx, std::move(matConst), 1u));
 
 
 
@@ -62,12 +76,13 @@ Cylinder::Cylinder(Graphics& gfx,
 		DirectX::XMFLOAT3 n;
 	};
 
-	const auto model = Prism::MakeTesselatedIndependentCapNormals<Vertex>(tdist(rng));
+	const auto model = Prism::MakeTesselatedIndependentCapNormals<Vertex>(tesselation);
 
-	AddBind(std::make_shared<VertexBuffer>(gfx, model.vertices));
-				 
-	AddBind(std::make_shared<IndexBuffer>(gfx, model.indices));
+	binds.push_back(std::make_shared<VertexBuffer>(gfx, model.vertices));
 				 
-	AddBind(std::make_shared<TransformCbuf>(gfx, *this));
+	binds.push_back(std::make_shared<IndexBuffer>(gfx, model.indices));
 
+	auto pMesh = std::make_shared<InstancedMesh>(gfx, std::move(binds));
+	pShared = pMesh;
+	return pMesh;
 }
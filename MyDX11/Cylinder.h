@@ -14,5 +14,9 @@ public:
 		std::uniform_real_distribution<float>& bdist,
 		std::uniform_int_distribution<int>& tdist);
 
+private:
+
+	//geometry shared between cylinders with the same tesselation
+	static std::shared_ptr<InstancedMesh> ResolveMesh(Graphics& gfx, int tesselation);
 
 };
\ No newline at end of file
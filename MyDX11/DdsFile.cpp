@@ -0,0 +1,647 @@
+#include "DdsFile.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <cassert>
+
+#ifdef _WIN32
+#include "myWin.h"
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+	constexpr uint32_t MakeFourCC(char a, char b, char c, char d) noexcept
+	{
+		return (uint32_t)(uint8_t)a | ((uint32_t)(uint8_t)b << 8u) | ((uint32_t)(uint8_t)c << 16u) | ((uint32_t)(uint8_t)d << 24u);
+	}
+
+	constexpr uint32_t ddsMagic = MakeFourCC('D', 'D', 'S', ' ');
+
+	//header flags
+	constexpr uint32_t flagCaps = 0x1u;
+	constexpr uint32_t flagHeight = 0x2u;
+	constexpr uint32_t flagWidth = 0x4u;
+	constexpr uint32_t flagPitch = 0x8u;
+	constexpr uint32_t flagPixelFormat = 0x1000u;
+	constexpr uint32_t flagMipMapCount = 0x20000u;
+	constexpr uint32_t flagLinearSize = 0x80000u;
+	constexpr uint32_t flagDepth = 0x800000u;
+
+	//pixel format flags
+	constexpr uint32_t pixelAlpha = 0x1u;
+	constexpr uint32_t pixelFourCC = 0x4u;
+	constexpr uint32_t pixelRgb = 0x40u;
+	constexpr uint32_t pixelLuminance = 0x20000u;
+
+	constexpr uint32_t capsComplex = 0x8u;
+	constexpr uint32_t capsTexture = 0x1000u;
+	constexpr uint32_t capsMipMap = 0x400000u;
+	constexpr uint32_t caps2CubeMap = 0x200u;
+	constexpr uint32_t caps2AllFaces = 0xFC00u;
+	constexpr uint32_t caps2Volume = 0x200000u;
+
+	//DX10 header values
+	constexpr uint32_t dimensionTexture2D = 3u;
+	constexpr uint32_t miscTextureCube = 0x4u;
+
+	//largest 2D texture D3D11 can make, also keeps the pitch maths far from overflowing
+	constexpr uint32_t maxDimension = 16384u;
+
+	struct PixelFormat {
+
+		uint32_t size;
+		uint32_t flags;
+		uint32_t fourCC;
+		uint32_t rgbBitCount;
+		uint32_t rMask;
+		uint32_t gMask;
+		uint32_t bMask;
+		uint32_t aMask;
+	};
+
+	struct Header {
+
+		uint32_t size;
+		uint32_t flags;
+		uint32_t height;
+		uint32_t width;
+		uint32_t pitchOrLinearSize;
+		uint32_t depth;
+		uint32_t mipMapCount;
+		uint32_t reserved1[11];
+		PixelFormat pixelFormat;
+		uint32_t caps;
+		uint32_t caps2;
+		uint32_t caps3;
+		uint32_t caps4;
+		uint32_t reserved2;
+	};
+
+	struct HeaderDx10 {
+
+		uint32_t format;
+		uint32_t resourceDimension;
+		uint32_t miscFlag;
+		uint32_t arraySize;
+		uint32_t miscFlags2;
+	};
+
+	static_assert(sizeof(PixelFormat) == 32u, "DDS pixel format has to be 32 bytes");
+	static_assert(sizeof(Header) == 124u, "DDS header has to be 124 bytes");
+	static_assert(sizeof(HeaderDx10) == 20u, "DX10 header has to be 20 bytes");
+
+	unsigned int CountLevels(unsigned int width, unsigned int height) noexcept
+	{
+		unsigned int count = 1u;
+
+		for (unsigned int size = std::max(width, height); size > 1u; size >>= 1u) {
+
+			count++;
+		}
+
+		return count;
+	}
+
+	//files written before the DX10 header existed say what they hold with a four cc or bit masks
+	DdsFormat GetLegacyFormat(const PixelFormat& pf) noexcept
+	{
+		if (pf.flags & pixelFourCC) {
+
+			switch (pf.fourCC)
+			{
+			case MakeFourCC('D', 'X', 'T', '1'):
+
+				return DdsFormat::BC1Unorm;
+
+			case MakeFourCC('D', 'X', 'T', '2'):
+			case MakeFourCC('D', 'X', 'T', '3'):
+
+				return DdsFormat::BC2Unorm;
+
+			case MakeFourCC('D', 'X', 'T', '4'):
+			case MakeFourCC('D', 'X', 'T', '5'):
+
+				return DdsFormat::BC3Unorm;
+
+			case MakeFourCC('A', 'T', 'I', '1'):
+			case MakeFourCC('B', 'C', '4', 'U'):
+
+				return DdsFormat::BC4Unorm;
+
+			case MakeFourCC('B', 'C', '4', 'S'):
+
+				return DdsFormat::BC4Snorm;
+
+			case MakeFourCC('A', 'T', 'I', '2'):
+			case MakeFourCC('B', 'C', '5', 'U'):
+
+				return DdsFormat::BC5Unorm;
+
+			case MakeFourCC('B', 'C', '5', 'S'):
+
+				return DdsFormat::BC5Snorm;
+
+			//D3DFMT values stored as the four cc
+			case 113u:
+
+				return DdsFormat::R16G16B16A16Float;
+
+			case 116u:
+
+				return DdsFormat::R32G32B32A32Float;
+			}
+
+			return DdsFormat::Unknown;
+		}
+
+		if ((pf.flags & pixelRgb) && pf.rgbBitCount == 32u) {
+
+			const uint32_t aMask = (pf.flags & pixelAlpha) ? pf.aMask : 0u;
+
+			if (pf.rMask == 0x00FF0000u && pf.gMask == 0x0000FF00u && pf.bMask == 0x000000FFu) {
+
+				return aMask == 0xFF000000u ? DdsFormat::B8G8R8A8Unorm : DdsFormat::B8G8R8X8Unorm;
+			}
+
+			if (pf.rMask == 0x000000FFu && pf.gMask == 0x0000FF00u && pf.bMask == 0x00FF0000u && aMask == 0xFF000000u) {
+
+				return DdsFormat::R8G8B8A8Unorm;
+			}
+		}
+
+		if ((pf.flags & pixelLuminance) && pf.rgbBitCount == 8u && pf.rMask == 0xFFu) {
+
+			return DdsFormat::R8Unorm;
+		}
+
+		return DdsFormat::Unknown;
+	}
+
+	std::vector<DdsFile::Subresource> Layout(const DdsFile::Description& desc) noexcept
+	{
+		std::vector<DdsFile::Subresource> subresources;
+		subresources.reserve((size_t)desc.mipLevels * desc.arraySize);
+
+		for (unsigned int item = 0; item < desc.arraySize; item++) {
+
+			for (unsigned int mip = 0; mip < desc.mipLevels; mip++) {
+
+				DdsFile::Subresource sub = {};
+
+				sub.width = std::max(1u, desc.width >> mip);
+				sub.height = std::max(1u, desc.height >> mip);
+				sub.rowPitch = DdsFile::GetRowPitch(desc.format, sub.width);
+				sub.slicePitch = sub.rowPitch * DdsFile::GetRowCount(desc.format, sub.height);
+
+				subresources.push_back(sub);
+			}
+		}
+
+		return subresources;
+	}
+}
+
+bool DdsFile::IsBlockCompressed(DdsFormat format) noexcept
+{
+	switch (format)
+	{
+	case DdsFormat::BC1Unorm:
+	case DdsFormat::BC1UnormSrgb:
+	case DdsFormat::BC2Unorm:
+	case DdsFormat::BC2UnormSrgb:
+	case DdsFormat::BC3Unorm:
+	case DdsFormat::BC3UnormSrgb:
+	case DdsFormat::BC4Unorm:
+	case DdsFormat::BC4Snorm:
+	case DdsFormat::BC5Unorm:
+	case DdsFormat::BC5Snorm:
+	case DdsFormat::BC6HUf16:
+	case DdsFormat::BC6HSf16:
+	case DdsFormat::BC7Unorm:
+	case DdsFormat::BC7UnormSrgb:
+
+		return true;
+
+	default:
+
+		return false;
+	}
+}
+
+unsigned int DdsFile::GetBitsPerTexel(DdsFormat format) noexcept
+{
+	switch (format)
+	{
+	case DdsFormat::R32G32B32A32Float:
+
+		return 128u;
+
+	case DdsFormat::R16G16B16A16Float:
+
+		return 64u;
+
+	case DdsFormat::R8G8B8A8Unorm:
+	case DdsFormat::R8G8B8A8UnormSrgb:
+	case DdsFormat::B8G8R8A8Unorm:
+	case DdsFormat::B8G8R8X8Unorm:
+	case DdsFormat::B8G8R8A8UnormSrgb:
+
+		return 32u;
+
+	case DdsFormat::R8G8Unorm:
+
+		return 16u;
+
+	case DdsFormat::R8Unorm:
+	case DdsFormat::BC2Unorm:
+	case DdsFormat::BC2UnormSrgb:
+	case DdsFormat::BC3Unorm:
+	case DdsFormat::BC3UnormSrgb:
+	case DdsFormat::BC5Unorm:
+	case DdsFormat::BC5Snorm:
+	case DdsFormat::BC6HUf16:
+	case DdsFormat::BC6HSf16:
+	case DdsFormat::BC7Unorm:
+	case DdsFormat::BC7UnormSrgb:
+
+		return 8u;
+
+	case DdsFormat::BC1Unorm:
+	case DdsFormat::BC1UnormSrgb:
+	case DdsFormat::BC4Unorm:
+	case DdsFormat::BC4Snorm:
+
+		return 4u;
+
+	default:
+
+		return 0u;
+	}
+}
+
+size_t DdsFile::GetRowPitch(DdsFormat format, unsigned int width) noexcept
+{
+	if (IsBlockCompressed(format)) {
+
+		//16 texels per block
+		const size_t blockBytes = GetBitsPerTexel(format) * 2u;
+
+		return std::max<size_t>(1u, (width + 3u) / 4u) * blockBytes;
+	}
+
+	return ((size_t)width * GetBitsPerTexel(format) + 7u) / 8u;
+}
+
+unsigned int DdsFile::GetRowCount(DdsFormat format, unsigned int height) noexcept
+{
+	return IsBlockCompressed(format) ? std::max(1u, (height + 3u) / 4u) : height;
+}
+
+void DdsFile::Write(const std::string& path, const Description& desc, const std::vector<Subresource>& subresources)
+{
+	if (GetBitsPerTexel(desc.format) == 0u) {
+
+		throw Exception(__LINE__, __FILE__, "Cannot write DDS with format " + std::to_string((uint32_t)desc.format));
+	}
+
+	if (desc.width == 0u || desc.height == 0u || desc.arraySize == 0u || desc.mipLevels == 0u ||
+		desc.mipLevels > CountLevels(desc.width, desc.height) || (desc.isCubeMap && desc.arraySize % 6u != 0u)) {
+
+		throw Exception(__LINE__, __FILE__, "Invalid DDS description for [" + path + "]");
+	}
+
+	const auto layout = Layout(desc);
+
+	if (subresources.size() != layout.size()) {
+
+		throw Exception(__LINE__, __FILE__, "DDS [" + path + "] needs " + std::to_string(layout.size()) +
+			" subresources, got " + std::to_string(subresources.size()));
+	}
+
+	for (size_t i = 0; i < layout.size(); i++) {
+
+		const auto& sub = subresources[i];
+
+		if (sub.pData == nullptr || sub.width != layout[i].width || sub.height != layout[i].height || sub.rowPitch < layout[i].rowPitch) {
+
+			throw Exception(__LINE__, __FILE__, "Subresource " + std::to_string(i) + " of DDS [" + path + "] does not match the description");
+		}
+	}
+
+	const bool isCompressed = IsBlockCompressed(desc.format);
+
+	Header header = {};
+	header.size = sizeof(Header);
+	header.flags = flagCaps | flagHeight | flagWidth | flagPixelFormat | flagMipMapCount | (isCompressed ? flagLinearSize : flagPitch);
+	header.height = desc.height;
+	header.width = desc.width;
+	header.pitchOrLinearSize = (uint32_t)(isCompressed ? layout.front().slicePitch : layout.front().rowPitch);
+	header.mipMapCount = desc.mipLevels;
+	header.pixelFormat.size = sizeof(PixelFormat);
+	header.pixelFormat.flags = pixelFourCC;
+	header.pixelFormat.fourCC = MakeFourCC('D', 'X', '1', '0');
+	header.caps = capsTexture | (desc.mipLevels > 1u ? capsComplex | capsMipMap : 0u) | (desc.arraySize > 1u ? capsComplex : 0u);
+	header.caps2 = desc.isCubeMap ? caps2CubeMap | caps2AllFaces : 0u;
+
+	HeaderDx10 dx10 = {};
+	dx10.format = (uint32_t)desc.format;
+	dx10.resourceDimension = dimensionTexture2D;
+	dx10.miscFlag = desc.isCubeMap ? miscTextureCube : 0u;
+	dx10.arraySize = desc.isCubeMap ? desc.arraySize / 6u : desc.arraySize;
+
+	const auto tempPath = path + ".tmp";
+
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+
+		file.write(reinterpret_cast<const char*>(&ddsMagic), sizeof(ddsMagic));
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(&dx10), sizeof(dx10));
+
+		for (size_t i = 0; i < layout.size(); i++) {
+
+			const auto& sub = subresources[i];
+			const auto tightPitch = layout[i].rowPitch;
+
+			if (sub.rowPitch == tightPitch) {
+
+				file.write(reinterpret_cast<const char*>(sub.pData), (std::streamsize)layout[i].slicePitch);
+				continue;
+			}
+
+			const auto rows = GetRowCount(desc.format, sub.height);
+
+			for (unsigned int y = 0; y < rows; y++) {
+
+				file.write(reinterpret_cast<const char*>(sub.pData + y * sub.rowPitch), (std::streamsize)tightPitch);
+			}
+		}
+
+		if (!file) {
+
+			file.close();
+
+			std::error_code ec;
+			std::filesystem::remove(tempPath, ec);
+
+			throw Exception(__LINE__, __FILE__, "Failed to write [" + path + "]");
+		}
+	}
+
+	std::error_code ec;
+	std::filesystem::rename(tempPath, path, ec);
+
+	if (ec) {
+
+		std::filesystem::remove(tempPath, ec);
+
+		throw Exception(__LINE__, __FILE__, "Failed to replace [" + path + "]");
+	}
+}
+
+DdsFile::DdsFile(const std::string& path)
+{
+#ifdef _WIN32
+	const HANDLE hFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+	if (hFile == INVALID_HANDLE_VALUE) {
+
+		throw Exception(__LINE__, __FILE__, "Failed to open [" + path + "]");
+	}
+
+	LARGE_INTEGER fileSize = {};
+	GetFileSizeEx(hFile, &fileSize);
+
+	//the view keeps the mapping alive, neither handle is needed once it exists
+	const HANDLE hMapping = fileSize.QuadPart > 0 ? CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0u, 0u, nullptr) : nullptr;
+	CloseHandle(hFile);
+
+	if (hMapping != nullptr) {
+
+		m_pData = static_cast<const uint8_t*>(MapViewOfFile(hMapping, FILE_MAP_READ, 0u, 0u, 0u));
+		CloseHandle(hMapping);
+	}
+#else
+	const int fd = open(path.c_str(), O_RDONLY);
+
+	if (fd < 0) {
+
+		throw Exception(__LINE__, __FILE__, "Failed to open [" + path + "]");
+	}
+
+	struct stat info = {};
+	fstat(fd, &info);
+
+	const off_t fileSize = info.st_size;
+
+	if (fileSize > 0) {
+
+		void* pView = mmap(nullptr, (size_t)fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+		m_pData = pView == MAP_FAILED ? nullptr : static_cast<const uint8_t*>(pView);
+	}
+
+	close(fd);
+#endif
+
+	if (m_pData == nullptr) {
+
+		throw Exception(__LINE__, __FILE__, "Failed to map [" + path + "]");
+	}
+
+#ifdef _WIN32
+	m_size = (size_t)fileSize.QuadPart;
+#else
+	m_size = (size_t)fileSize;
+#endif
+
+	//the destructor does not run for a throwing constructor
+	try {
+
+		Parse(path);
+	}
+	catch (...) {
+
+#ifdef _WIN32
+		UnmapViewOfFile(m_pData);
+#else
+		munmap(const_cast<uint8_t*>(m_pData), m_size);
+#endif
+		throw;
+	}
+}
+
+DdsFile::~DdsFile()
+{
+#ifdef _WIN32
+	UnmapViewOfFile(m_pData);
+#else
+	munmap(const_cast<uint8_t*>(m_pData), m_size);
+#endif
+}
+
+const DdsFile::Description& DdsFile::GetDescription() const noexcept
+{
+	return m_desc;
+}
+
+const std::vector<DdsFile::Subresource>& DdsFile::GetSubresources() const noexcept
+{
+	return m_subresources;
+}
+
+const DdsFile::Subresource& DdsFile::GetSubresource(unsigned int mip, unsigned int item) const noexcept(!IS_DEBUG)
+{
+	assert("Subresource out of range" && mip < m_desc.mipLevels && item < m_desc.arraySize);
+
+	return m_subresources[(size_t)item * m_desc.mipLevels + mip];
+}
+
+void DdsFile::Parse(const std::string& path)
+{
+	const auto corrupt = [&path](const char* what) {
+
+		return Exception(__LINE__, __FILE__, "Corrupt DDS [" + path + "] (" + what + ")");
+	};
+
+	uint32_t magic = 0u;
+	Header header = {};
+
+	if (m_size < sizeof(magic) + sizeof(header)) {
+
+		throw corrupt("file too small");
+	}
+
+	//copied out, the mapping gives no alignment guarantee past the start
+	memcpy(&magic, m_pData, sizeof(magic));
+	memcpy(&header, m_pData + sizeof(magic), sizeof(header));
+
+	if (magic != ddsMagic || header.size != sizeof(Header) || header.pixelFormat.size != sizeof(PixelFormat)) {
+
+		throw corrupt("bad header");
+	}
+
+	if (((header.flags & flagDepth) && header.depth > 1u) || (header.caps2 & caps2Volume)) {
+
+		throw Exception(__LINE__, __FILE__, "Volume texture [" + path + "] is not supported");
+	}
+
+	size_t offset = sizeof(magic) + sizeof(header);
+
+	m_desc.width = header.width;
+	m_desc.height = header.height;
+	m_desc.mipLevels = std::max(1u, header.mipMapCount);
+
+	if ((header.pixelFormat.flags & pixelFourCC) && header.pixelFormat.fourCC == MakeFourCC('D', 'X', '1', '0')) {
+
+		HeaderDx10 dx10 = {};
+
+		if (m_size < offset + sizeof(dx10)) {
+
+			throw corrupt("file too small");
+		}
+
+		memcpy(&dx10, m_pData + offset, sizeof(dx10));
+		offset += sizeof(dx10);
+
+		if (dx10.resourceDimension != dimensionTexture2D) {
+
+			throw Exception(__LINE__, __FILE__, "DDS [" + path + "] is not a 2D texture");
+		}
+
+		m_desc.format = (DdsFormat)dx10.format;
+		m_desc.isCubeMap = (dx10.miscFlag & miscTextureCube) != 0u;
+		m_desc.arraySize = dx10.arraySize;
+
+		if (m_desc.arraySize == 0u || (m_desc.isCubeMap && m_desc.arraySize > UINT32_MAX / 6u)) {
+
+			throw corrupt("bad array size");
+		}
+
+		if (m_desc.isCubeMap) {
+
+			m_desc.arraySize *= 6u;
+		}
+	}
+	else {
+
+		m_desc.format = GetLegacyFormat(header.pixelFormat);
+
+		if (header.caps2 & caps2CubeMap) {
+
+			//faces that are left out would shift every subresource after them
+			if ((header.caps2 & caps2AllFaces) != caps2AllFaces) {
+
+				throw Exception(__LINE__, __FILE__, "Partial cube map [" + path + "] is not supported");
+			}
+
+			m_desc.isCubeMap = true;
+			m_desc.arraySize = 6u;
+		}
+	}
+
+	if (GetBitsPerTexel(m_desc.format) == 0u) {
+
+		throw Exception(__LINE__, __FILE__, "DDS [" + path + "] has unsupported format " + std::to_string((uint32_t)m_desc.format));
+	}
+
+	if (m_desc.width == 0u || m_desc.height == 0u || m_desc.width > maxDimension || m_desc.height > maxDimension ||
+		m_desc.mipLevels > CountLevels(m_desc.width, m_desc.height)) {
+
+		throw corrupt("bad size");
+	}
+
+	//every subresource takes at least a byte, checked before a bogus count gets allocated
+	if ((uint64_t)m_desc.arraySize * m_desc.mipLevels > m_size - offset) {
+
+		throw corrupt("truncated");
+	}
+
+	m_subresources = Layout(m_desc);
+
+	for (auto& sub : m_subresources) {
+
+		if (sub.slicePitch > m_size - offset) {
+
+			throw corrupt("truncated");
+		}
+
+		sub.pData = m_pData + offset;
+		offset += sub.slicePitch;
+	}
+}
+
+
+//dds exception stuff
+DdsFile::Exception::Exception(int line, const char* file, std::string note) noexcept
+	:
+	myException(line, file),
+	note(std::move(note))
+{}
+
+const char* DdsFile::Exception::what() const noexcept
+{
+	std::ostringstream oss;
+
+	oss << myException::what() << std::endl
+		<< "[Note] " << GetNote();
+
+	whatBuffer = oss.str();
+	return whatBuffer.c_str();
+}
+
+const char* DdsFile::Exception::GetType() const noexcept
+{
+	return "SupaHotFire DDS Exception";
+}
+
+const std::string& DdsFile::Exception::GetNote() const noexcept
+{
+	return note;
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "BuildConfig.h"
+#include "myException.h"
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+//the formats the container can carry, same numbers as DXGI_FORMAT so a value can be cast straight across
+//*spelled out here so this header builds without windows
+enum class DdsFormat : uint32_t {
+
+	Unknown = 0,
+	R32G32B32A32Float = 2,
+	R16G16B16A16Float = 10,
+	R8G8B8A8Unorm = 28,
+	R8G8B8A8UnormSrgb = 29,
+	R8G8Unorm = 49,
+	R8Unorm = 61,
+	BC1Unorm = 71,
+	BC1UnormSrgb = 72,
+	BC2Unorm = 74,
+	BC2UnormSrgb = 75,
+	BC3Unorm = 77,
+	BC3UnormSrgb = 78,
+	BC4Unorm = 80,
+	BC4Snorm = 81,
+	BC5Unorm = 83,
+	BC5Snorm = 84,
+	B8G8R8A8Unorm = 87,
+	B8G8R8X8Unorm = 88,
+	B8G8R8A8UnormSrgb = 91,
+	BC6HUf16 = 95,
+	BC6HSf16 = 96,
+	BC7Unorm = 98,
+	BC7UnormSrgb = 99,
+};
+
+/// <summary>
+/// DDS container, reads a memory mapped file in place and writes the DX10 header variant
+/// subresources point straight into the mapping so they can go to D3D11_SUBRESOURCE_DATA without a copy
+/// covers 2D textures with mip chains, arrays and cube maps, volume textures are refused
+/// works on raw bytes only so it builds and runs without windows
+/// </summary>
+class DdsFile {
+
+public:
+
+	class Exception :public myException {
+
+	public:
+
+		Exception(int line, const char* file, std::string note) noexcept;
+		const char* what() const noexcept override;
+		const char* GetType() const noexcept override;
+
+		const std::string& GetNote() const noexcept;
+
+	private:
+
+		std::string note;
+	};
+
+	struct Description {
+
+		DdsFormat format = DdsFormat::Unknown;
+		unsigned int width = 0u;
+		unsigned int height = 0u;
+		unsigned int mipLevels = 1u;
+
+		//2D slices, a cube map counts all six faces here
+		unsigned int arraySize = 1u;
+		bool isCubeMap = false;
+	};
+
+	struct Subresource {
+
+		const uint8_t* pData;
+		unsigned int width;
+		unsigned int height;
+
+		//bytes of one row of texels (of 4x4 blocks for BCn) / of the whole level
+		size_t rowPitch;
+		size_t slicePitch;
+	};
+
+public:
+
+	static bool IsBlockCompressed(DdsFormat format) noexcept;
+
+	//0 for anything not listed in DdsFormat
+	static unsigned int GetBitsPerTexel(DdsFormat format) noexcept;
+
+	//tightly packed pitches, the layout the file uses
+	static size_t GetRowPitch(DdsFormat format, unsigned int width) noexcept;
+	static unsigned int GetRowCount(DdsFormat format, unsigned int height) noexcept;
+
+	//subresources go array item by array item, every mip of one item before the next item
+	//(the same order as D3D11CalcSubresource), rows are written tightly packed whatever the source pitch
+	//*goes through a temporary file so a failed write never leaves half a texture behind
+	static void Write(const std::string& path, const Description& desc, const std::vector<Subresource>& subresources);
+
+public:
+
+	//maps the file read only and checks that every subresource lies inside it
+	explicit DdsFile(const std::string& path);
+	DdsFile(const DdsFile&) = delete;
+	DdsFile& operator=(const DdsFile&) = delete;
+	~DdsFile();
+
+	const Description& GetDescription() const noexcept;
+
+	//index is mip + item * mipLevels
+	const std::vector<Subresource>& GetSubresources() const noexcept;
+	const Subresource& GetSubresource(unsigned int mip, unsigned int item = 0u) const noexcept(!IS_DEBUG);
+
+private:
+
+	void Parse(const std::string& path);
+
+private:
+
+	const uint8_t* m_pData = nullptr;
+	size_t m_size = 0u;
+
+	Description m_desc;
+	std::vector<Subresource> m_subresources;
+};
@@ -1,12 +1,16 @@
 #include "Drawable.h"
 #include "GraphicsThrowMacros.h"
 #include "IndexBuffer.h"
+#include "TransformCbuf.h"
+#include "Profiler.h"
 #include <cassert>
 
 using namespace Bind;
 
 void Drawable::Draw(Graphics& gfx) const noexcept(!IS_DEBUG)
 {
+	PROFILE_ZONE("Drawable::Draw");
+
 	//Bind all the instance binds
 	for (auto& b : binds) {
 
@@ -19,6 +23,30 @@ void Drawable::Draw(Graphics& gfx) const noexcept(!IS_DEBUG)
 
 }
 
+void Drawable::DrawInstanced(Graphics& gfx, UINT instanceCount, UINT startInstance) const noexcept(!IS_DEBUG)
+{
+	PROFILE_ZONE("Drawable::DrawInstanced");
+
+	//Bind all the shared binds (instance buffer is bound by the caller)
+	for (auto& b : binds) {
+
+		b->Bind(gfx);
+	}
+
+
+	//Draw command for the whole group
+	gfx.DrawIndexedInstanced(pIndexBuffer->GetCount(), instanceCount, startInstance);
+
+}
+
+void Drawable::StageTransform() const
+{
+	if (pTransformCbuf != nullptr) {
+
+		pTransformCbuf->Stage();
+	}
+}
+
 void Drawable::AddBind(std::shared_ptr<Bindable> bind) noexcept(!IS_DEBUG)
 {
 
@@ -29,6 +57,10 @@ void Drawable::AddBind(std::shared_ptr<Bindable> bind) noexcept(!IS_DEBUG)
 		
 		pIndexBuffer = &static_cast<IndexBuffer&>(*bind);
 	}
+	else if (typeid(*bind) == typeid(TransformCbuf)) {
+
+		pTransformCbuf = &static_cast<TransformCbuf&>(*bind);
+	}
 
 	binds.push_back(std::move(bind));
 
@@ -8,6 +8,7 @@ namespace Bind {
 
 	class Bindable;
 	class IndexBuffer;
+	class TransformCbuf;
 }
 
 
@@ -23,6 +24,10 @@ public:
 	virtual DirectX::XMMATRIX GetTransformXM() const noexcept = 0;
 
 	void Draw(Graphics& gfx) const noexcept(!IS_DEBUG);
+	void DrawInstanced(Graphics& gfx, UINT instanceCount, UINT startInstance) const noexcept(!IS_DEBUG);
+
+	//queues the current transform for the frame's batched transform upload (see TransformCbuf::Flush)
+	void StageTransform() const;
 	virtual void Update(float dt) noexcept {}
 
 	//destructor
@@ -54,6 +59,7 @@ private:
 
 	//special pointer to the transformation constant buffer
 	const class Bind::IndexBuffer* pIndexBuffer = nullptr;
+	const class Bind::TransformCbuf* pTransformCbuf = nullptr;
 	std::vector<std::shared_ptr<Bind::Bindable>> binds;
 	
 };
\ No newline at end of file
@@ -0,0 +1,667 @@
+#include "DynamicBvh.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <numeric>
+#include <array>
+#include <cmath>
+#include <cfloat>
+
+namespace {
+
+	//subtrees below this depth are refit as one job each (up to 64 of them)
+	constexpr unsigned int subtreeDepth = 6u;
+	//objects per job when encoding their centers
+	constexpr size_t minParallelEncode = 8192u;
+
+	//bits of each axis in a morton code, sorted radixBits at a time
+	constexpr unsigned int codeBits = 10u;
+	constexpr uint32_t codeMax = (1u << codeBits) - 1u;
+	constexpr unsigned int radixBits = 10u;
+	constexpr uint32_t radixSize = 1u << radixBits;
+
+	//past the deepest a tree gets, one level per code bit and then halving objects that share a code
+	constexpr size_t maxStack = 64u;
+
+	struct Plane {
+
+		float x;
+		float y;
+		float z;
+		float w;
+	};
+
+	//puts two zero bits in front of each of the low 10 bits, so three axes interleave
+	uint32_t SpreadBits(uint32_t v) noexcept
+	{
+		v = (v | (v << 16)) & 0x030000ffu;
+		v = (v | (v << 8)) & 0x0300f00fu;
+		v = (v | (v << 4)) & 0x030c30c3u;
+		v = (v | (v << 2)) & 0x09249249u;
+
+		return v;
+	}
+
+	float GetArea(const float* min, const float* max) noexcept
+	{
+		const float dx = max[0] - min[0];
+		const float dy = max[1] - min[1];
+		const float dz = max[2] - min[2];
+
+		return 2.0f * (dx * dy + dy * dz + dz * dx);
+	}
+}
+
+
+void DynamicBvh::Resize(size_t count)
+{
+	if (count != m_spheres.size()) {
+
+		m_spheres.resize(count, Sphere{ 0.0f,0.0f,0.0f,0.0f });
+		m_isDirty = true;
+	}
+}
+
+size_t DynamicBvh::GetCount() const noexcept
+{
+	return m_spheres.size();
+}
+
+void DynamicBvh::SetSphere(size_t index, const DirectX::XMFLOAT3& center, float radius) noexcept
+{
+	m_spheres[index] = { center.x,center.y,center.z,radius };
+}
+
+void DynamicBvh::Update(JobSystem* pJobs)
+{
+	if (m_isDirty) {
+
+		Rebuild(pJobs);
+		return;
+	}
+
+	Refit(pJobs);
+
+	//the refitted boxes grew into each other, a new split fits the objects where they are now
+	if (m_stats.cost > m_stats.builtCost * m_rebuildRatio) {
+
+		Rebuild(pJobs);
+	}
+}
+
+void DynamicBvh::Rebuild(JobSystem* pJobs)
+{
+	const uint32_t count = (uint32_t)m_spheres.size();
+
+	SortItems(pJobs);
+
+	m_items.resize(count);
+
+	for (uint32_t i = 0u; i < count; i++) {
+
+		m_items[i] = m_buildItems[i].index;
+	}
+
+	m_nodes.clear();
+	m_subtrees.clear();
+	m_topNodes.clear();
+
+	if (count > 0u) {
+
+		Build(0u, count);
+		AddSubtrees(0u, 0u);
+	}
+
+	m_isDirty = false;
+	Refit(pJobs);
+
+	m_stats.nodes = m_nodes.size();
+	m_stats.builtCost = m_stats.cost;
+	m_stats.nRebuilds++;
+}
+
+void DynamicBvh::SetRebuildRatio(float ratio) noexcept
+{
+	m_rebuildRatio = std::max(ratio, 1.0f);
+}
+
+float DynamicBvh::GetRebuildRatio() const noexcept
+{
+	return m_rebuildRatio;
+}
+
+void DynamicBvh::SortItems(JobSystem* pJobs)
+{
+	const size_t count = m_spheres.size();
+
+	m_buildItems.resize(count);
+	m_sortScratch.resize(count);
+
+	if (count == 0u) {
+
+		return;
+	}
+
+	float lo[3] = { m_spheres[0].x,m_spheres[0].y,m_spheres[0].z };
+	float hi[3] = { lo[0],lo[1],lo[2] };
+
+	for (const Sphere& s : m_spheres) {
+
+		lo[0] = std::min(lo[0], s.x);
+		lo[1] = std::min(lo[1], s.y);
+		lo[2] = std::min(lo[2], s.z);
+		hi[0] = std::max(hi[0], s.x);
+		hi[1] = std::max(hi[1], s.y);
+		hi[2] = std::max(hi[2], s.z);
+	}
+
+	//each axis of the bounds in codeBits steps, flat axes all land on 0
+	float scale[3];
+
+	for (int axis = 0; axis < 3; axis++) {
+
+		const float extent = hi[axis] - lo[axis];
+
+		scale[axis] = extent > 0.0f ? (float)codeMax / extent : 0.0f;
+	}
+
+	const auto encode = [&](size_t first, size_t last) {
+
+		for (size_t i = first; i < last; i++) {
+
+			const Sphere& s = m_spheres[i];
+			const uint32_t x = std::min((uint32_t)((s.x - lo[0]) * scale[0]), codeMax);
+			const uint32_t y = std::min((uint32_t)((s.y - lo[1]) * scale[1]), codeMax);
+			const uint32_t z = std::min((uint32_t)((s.z - lo[2]) * scale[2]), codeMax);
+
+			m_buildItems[i] = { (SpreadBits(x) << 2) | (SpreadBits(y) << 1) | SpreadBits(z),(uint32_t)i };
+		}
+	};
+
+	if (pJobs != nullptr) {
+
+		pJobs->ParallelFor(count, minParallelEncode, encode);
+	}
+	else {
+
+		encode(0u, count);
+	}
+
+	//least significant digit first, each pass is stable so the earlier digits stay in order
+	for (unsigned int shift = 0u; shift < codeBits * 3u; shift += radixBits) {
+
+		std::array<uint32_t, radixSize> offsets = {};
+
+		for (const BuildItem& item : m_buildItems) {
+
+			offsets[(item.code >> shift) & (radixSize - 1u)]++;
+		}
+
+		uint32_t sum = 0u;
+
+		for (uint32_t& offset : offsets) {
+
+			const uint32_t bucket = offset;
+			offset = sum;
+			sum += bucket;
+		}
+
+		for (const BuildItem& item : m_buildItems) {
+
+			m_sortScratch[offsets[(item.code >> shift) & (radixSize - 1u)]++] = item;
+		}
+
+		m_buildItems.swap(m_sortScratch);
+	}
+}
+
+void DynamicBvh::Build(uint32_t firstItem, uint32_t itemCount)
+{
+	const uint32_t node = (uint32_t)m_nodes.size();
+	m_nodes.push_back({ {},firstItem,{},itemCount,0u });
+
+	if (itemCount <= leafSize) {
+
+		return;
+	}
+
+	//split where the highest bit the range's codes differ in flips, that's a plane halving the cell they share
+	//ranges of one code (objects closer than a cell) are just halved
+	const auto first = m_buildItems.begin() + firstItem;
+	const auto last = first + itemCount;
+	const uint32_t differing = first->code ^ (last - 1)->code;
+	uint32_t split = itemCount / 2u;
+
+	if (differing != 0u) {
+
+		uint32_t bit = 1u << 31;
+
+		while ((differing & bit) == 0u) {
+
+			bit >>= 1;
+		}
+
+		split = (uint32_t)(std::partition_point(first, last, [bit](const BuildItem& item) { return (item.code & bit) == 0u; }) - first);
+	}
+
+	Build(firstItem, split);
+	m_nodes[node].right = (uint32_t)m_nodes.size();
+	Build(firstItem + split, itemCount - split);
+}
+
+void DynamicBvh::AddSubtrees(uint32_t node, unsigned int depth)
+{
+	const Node& n = m_nodes[node];
+
+	if (depth == subtreeDepth || n.right == 0u) {
+
+		//the last node of a subtree depth first is its rightmost leaf
+		uint32_t last = node;
+
+		while (m_nodes[last].right != 0u) {
+
+			last = m_nodes[last].right;
+		}
+
+		m_subtrees.push_back({ node,last + 1u - node });
+		return;
+	}
+
+	m_topNodes.push_back(node);
+	AddSubtrees(node + 1u, depth + 1u);
+	AddSubtrees(n.right, depth + 1u);
+}
+
+double DynamicBvh::Refit(uint32_t first, uint32_t last) noexcept
+{
+	double area = 0.0;
+
+	for (uint32_t i = last; i-- > first;) {
+
+		Node& n = m_nodes[i];
+
+		if (n.right == 0u) {
+
+			float lo[3] = { FLT_MAX,FLT_MAX,FLT_MAX };
+			float hi[3] = { -FLT_MAX,-FLT_MAX,-FLT_MAX };
+
+			for (uint32_t k = n.firstItem; k < n.firstItem + n.itemCount; k++) {
+
+				const Sphere& s = m_spheres[m_items[k]];
+
+				lo[0] = std::min(lo[0], s.x - s.r);
+				lo[1] = std::min(lo[1], s.y - s.r);
+				lo[2] = std::min(lo[2], s.z - s.r);
+				hi[0] = std::max(hi[0], s.x + s.r);
+				hi[1] = std::max(hi[1], s.y + s.r);
+				hi[2] = std::max(hi[2], s.z + s.r);
+			}
+
+			std::copy(lo, lo + 3, n.min);
+			std::copy(hi, hi + 3, n.max);
+
+			area += (double)GetArea(n.min, n.max) * n.itemCount;
+		}
+		else {
+
+			const Node& l = m_nodes[i + 1u];
+			const Node& r = m_nodes[n.right];
+
+			for (int axis = 0; axis < 3; axis++) {
+
+				n.min[axis] = std::min(l.min[axis], r.min[axis]);
+				n.max[axis] = std::max(l.max[axis], r.max[axis]);
+			}
+
+			area += GetArea(n.min, n.max);
+		}
+	}
+
+	return area;
+}
+
+void DynamicBvh::Refit(JobSystem* pJobs)
+{
+	if (m_nodes.empty()) {
+
+		m_stats.cost = 0.0f;
+		return;
+	}
+
+	m_subtreeAreas.assign(m_subtrees.size(), 0.0);
+
+	const auto refitSubtrees = [this](size_t first, size_t last) {
+
+		for (size_t k = first; k < last; k++) {
+
+			m_subtreeAreas[k] = Refit(m_subtrees[k].root, m_subtrees[k].root + m_subtrees[k].nodeCount);
+		}
+	};
+
+	if (pJobs != nullptr) {
+
+		pJobs->ParallelFor(m_subtrees.size(), 1u, refitSubtrees);
+	}
+	else {
+
+		refitSubtrees(0u, m_subtrees.size());
+	}
+
+	//parents come before their children depth first, so backwards visits children first
+	double area = std::accumulate(m_subtreeAreas.begin(), m_subtreeAreas.end(), 0.0);
+
+	for (auto it = m_topNodes.rbegin(); it != m_topNodes.rend(); ++it) {
+
+		area += Refit(*it, *it + 1u);
+	}
+
+	const float rootArea = GetArea(m_nodes[0].min, m_nodes[0].max);
+	m_stats.cost = rootArea > 0.0f ? (float)(area / rootArea) : 0.0f;
+}
+
+void DynamicBvh::QueryFrustum(const DirectX::XMFLOAT4X4& viewProj, std::vector<uint32_t>& indices) const
+{
+	indices.clear();
+
+	if (m_nodes.empty()) {
+
+		return;
+	}
+
+	//clip planes straight from the view projection columns, normalized so distances to them are in world units
+	const auto& m = viewProj.m;
+	Plane planes[6] = {
+		{ m[0][3] + m[0][0],m[1][3] + m[1][0],m[2][3] + m[2][0],m[3][3] + m[3][0] },	//left
+		{ m[0][3] - m[0][0],m[1][3] - m[1][0],m[2][3] - m[2][0],m[3][3] - m[3][0] },	//right
+		{ m[0][3] + m[0][1],m[1][3] + m[1][1],m[2][3] + m[2][1],m[3][3] + m[3][1] },	//bottom
+		{ m[0][3] - m[0][1],m[1][3] - m[1][1],m[2][3] - m[2][1],m[3][3] - m[3][1] },	//top
+		{ m[0][2],m[1][2],m[2][2],m[3][2] },											//near
+		{ m[0][3] - m[0][2],m[1][3] - m[1][2],m[2][3] - m[2][2],m[3][3] - m[3][2] },	//far
+	};
+
+	for (auto& p : planes) {
+
+		const float length = std::sqrt(p.x * p.x + p.y * p.y + p.z * p.z);
+		const float scale = length > 0.0f ? 1.0f / length : 0.0f;
+
+		p = { p.x * scale,p.y * scale,p.z * scale,p.w * scale };
+	}
+
+	//a node wholly inside a plane clears its bit, its subtree skips that plane
+	constexpr uint32_t allPlanes = 0x3fu;
+
+	struct Entry {
+
+		uint32_t node;
+		uint32_t planes;
+	};
+
+	Entry stack[maxStack];
+	size_t top = 0u;
+	stack[top++] = { 0u,allPlanes };
+
+	while (top > 0u) {
+
+		const auto [node, active] = stack[--top];
+		const Node& n = m_nodes[node];
+
+		uint32_t remaining = active;
+		bool isOutside = false;
+
+		for (int i = 0; i < 6 && !isOutside; i++) {
+
+			if ((active & (1u << i)) == 0u) {
+
+				continue;
+			}
+
+			const Plane& p = planes[i];
+
+			//corner furthest along the normal and the one furthest against it
+			const float far = p.x * (p.x > 0.0f ? n.max[0] : n.min[0]) + p.y * (p.y > 0.0f ? n.max[1] : n.min[1]) + p.z * (p.z > 0.0f ? n.max[2] : n.min[2]) + p.w;
+			const float near = p.x * (p.x > 0.0f ? n.min[0] : n.max[0]) + p.y * (p.y > 0.0f ? n.min[1] : n.max[1]) + p.z * (p.z > 0.0f ? n.min[2] : n.max[2]) + p.w;
+
+			if (far < 0.0f) {
+
+				isOutside = true;
+			}
+			else if (near >= 0.0f) {
+
+				remaining &= ~(1u << i);
+			}
+		}
+
+		if (isOutside) {
+
+			continue;
+		}
+
+		//wholly inside, every object under it goes in without a test
+		if (remaining == 0u) {
+
+			indices.insert(indices.end(), m_items.begin() + n.firstItem, m_items.begin() + n.firstItem + n.itemCount);
+			continue;
+		}
+
+		if (n.right != 0u) {
+
+			stack[top++] = { n.right,remaining };
+			stack[top++] = { node + 1u,remaining };
+			continue;
+		}
+
+		for (uint32_t k = n.firstItem; k < n.firstItem + n.itemCount; k++) {
+
+			const Sphere& s = m_spheres[m_items[k]];
+			bool isInside = true;
+
+			for (int i = 0; i < 6 && isInside; i++) {
+
+				const Plane& p = planes[i];
+
+				isInside = (remaining & (1u << i)) == 0u || p.x * s.x + p.y * s.y + p.z * s.z + p.w >= -s.r;
+			}
+
+			if (isInside) {
+
+				indices.push_back(m_items[k]);
+			}
+		}
+	}
+}
+
+void DynamicBvh::QuerySphere(const DirectX::XMFLOAT3& center, float radius, std::vector<uint32_t>& indices) const
+{
+	indices.clear();
+
+	if (m_nodes.empty()) {
+
+		return;
+	}
+
+	const float c[3] = { center.x,center.y,center.z };
+	const float radiusSq = radius * radius;
+
+	uint32_t stack[maxStack];
+	size_t top = 0u;
+	stack[top++] = 0u;
+
+	while (top > 0u) {
+
+		const uint32_t node = stack[--top];
+		const Node& n = m_nodes[node];
+
+		//squared distances to the nearest and the furthest point of the box
+		float nearSq = 0.0f;
+		float farSq = 0.0f;
+
+		for (int axis = 0; axis < 3; axis++) {
+
+			const float below = n.min[axis] - c[axis];
+			const float above = c[axis] - n.max[axis];
+			const float nearest = std::max({ below,above,0.0f });
+			const float furthest = std::max(std::abs(below), std::abs(above));
+
+			nearSq += nearest * nearest;
+			farSq += furthest * furthest;
+		}
+
+		if (nearSq > radiusSq) {
+
+			continue;
+		}
+
+		//the sphere holds the whole box, so every object under it overlaps
+		if (farSq <= radiusSq) {
+
+			indices.insert(indices.end(), m_items.begin() + n.firstItem, m_items.begin() + n.firstItem + n.itemCount);
+			continue;
+		}
+
+		if (n.right != 0u) {
+
+			stack[top++] = n.right;
+			stack[top++] = node + 1u;
+			continue;
+		}
+
+		for (uint32_t k = n.firstItem; k < n.firstItem + n.itemCount; k++) {
+
+			const Sphere& s = m_spheres[m_items[k]];
+			const float dx = s.x - c[0];
+			const float dy = s.y - c[1];
+			const float dz = s.z - c[2];
+			const float reach = s.r + radius;
+
+			if (dx * dx + dy * dy + dz * dz <= reach * reach) {
+
+				indices.push_back(m_items[k]);
+			}
+		}
+	}
+}
+
+std::optional<DynamicBvh::Hit> DynamicBvh::Raycast(const DirectX::XMFLOAT3& origin, const DirectX::XMFLOAT3& direction, float maxDistance) const noexcept
+{
+	const float length = std::sqrt(direction.x * direction.x + direction.y * direction.y + direction.z * direction.z);
+
+	if (m_nodes.empty() || !(length > 0.0f)) {
+
+		return {};
+	}
+
+	const float o[3] = { origin.x,origin.y,origin.z };
+	const float d[3] = { direction.x / length,direction.y / length,direction.z / length };
+	//infinite along axes the ray doesn't move on, the slabs of those are all or nothing
+	const float inv[3] = { 1.0f / d[0],1.0f / d[1],1.0f / d[2] };
+
+	//distance the ray enters the box at, past maxDistance when it misses
+	const auto enter = [&](const Node& n) {
+
+		float tNear = 0.0f;
+		float tFar = maxDistance;
+
+		for (int axis = 0; axis < 3; axis++) {
+
+			float t0 = (n.min[axis] - o[axis]) * inv[axis];
+			float t1 = (n.max[axis] - o[axis]) * inv[axis];
+
+			if (t0 > t1) {
+
+				std::swap(t0, t1);
+			}
+
+			//NaN (origin on a slab of an axis it doesn't move on) leaves the bounds alone
+			tNear = t0 > tNear ? t0 : tNear;
+			tFar = t1 < tFar ? t1 : tFar;
+		}
+
+		return tNear <= tFar ? tNear : FLT_MAX;
+	};
+
+	std::optional<Hit> hit;
+	float best = maxDistance;
+
+	uint32_t stack[maxStack];
+	size_t top = 0u;
+
+	if (enter(m_nodes[0]) <= best) {
+
+		stack[top++] = 0u;
+	}
+
+	while (top > 0u) {
+
+		const uint32_t node = stack[--top];
+		const Node& n = m_nodes[node];
+
+		//a nearer hit turned up since it was pushed
+		if (enter(n) > best) {
+
+			continue;
+		}
+
+		if (n.right != 0u) {
+
+			const float tLeft = enter(m_nodes[node + 1u]);
+			const float tRight = enter(m_nodes[n.right]);
+
+			//nearer child on top so it's walked first
+			const bool isLeftNearer = tLeft <= tRight;
+			const uint32_t nearChild = isLeftNearer ? node + 1u : n.right;
+			const uint32_t farChild = isLeftNearer ? n.right : node + 1u;
+
+			if (std::max(tLeft, tRight) <= best) {
+
+				stack[top++] = farChild;
+			}
+
+			if (std::min(tLeft, tRight) <= best) {
+
+				stack[top++] = nearChild;
+			}
+
+			continue;
+		}
+
+		for (uint32_t k = n.firstItem; k < n.firstItem + n.itemCount; k++) {
+
+			const Sphere& s = m_spheres[m_items[k]];
+			const float oc[3] = { o[0] - s.x,o[1] - s.y,o[2] - s.z };
+			const float b = oc[0] * d[0] + oc[1] * d[1] + oc[2] * d[2];
+			const float c = oc[0] * oc[0] + oc[1] * oc[1] + oc[2] * oc[2] - s.r * s.r;
+
+			//starting inside counts as a hit right away
+			float t = 0.0f;
+
+			if (c > 0.0f) {
+
+				const float discriminant = b * b - c;
+
+				if (discriminant < 0.0f) {
+
+					continue;
+				}
+
+				t = -b - std::sqrt(discriminant);
+
+				if (t < 0.0f) {
+
+					continue;
+				}
+			}
+
+			if (t <= best) {
+
+				best = t;
+				hit = Hit{ m_items[k],t };
+			}
+		}
+	}
+
+	return hit;
+}
+
+const DynamicBvh::Stats& DynamicBvh::GetStats() const noexcept
+{
+	return m_stats;
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <optional>
+
+class JobSystem;
+
+/// <summary>
+/// Bounding volume hierarchy over objects' bounding spheres, for objects that all move every frame
+/// the owner writes every sphere once a frame and Update refits the boxes bottom up instead of rebuilding,
+/// the tree is only rebuilt when the count changes or the refitted boxes overlap so much that it got too costly to walk
+/// builds sort the centers along a morton curve and halve the sorted range down to the leaves, which is quick enough to redo in a frame
+/// nodes are laid out depth first so every subtree is one contiguous range, refits split subtrees across jobs
+/// answers frustum, sphere and nearest ray hit queries, works without windows
+/// </summary>
+class DynamicBvh {
+
+public:
+
+	//most objects in a leaf
+	static constexpr uint32_t leafSize = 4u;
+
+	struct Hit {
+
+		uint32_t index;
+		float distance;
+	};
+
+	struct Stats {
+
+		size_t nodes = 0u;
+		//surface area heuristic cost (sum of node areas over the root's) now and right after the last build
+		float cost = 0.0f;
+		float builtCost = 0.0f;
+		unsigned int nRebuilds = 0u;
+	};
+
+public:
+
+	DynamicBvh() = default;
+	DynamicBvh(const DynamicBvh&) = delete;
+	DynamicBvh& operator=(const DynamicBvh&) = delete;
+
+	//objects are 0..count-1, a new count rebuilds on the next Update
+	void Resize(size_t count);
+	size_t GetCount() const noexcept;
+
+	//different objects can be set from different threads at once
+	void SetSphere(size_t index, const DirectX::XMFLOAT3& center, float radius) noexcept;
+
+	//refits to the spheres set since the last one, rebuilds when the count changed or the cost grew past the rebuild ratio
+	//sorting keys and refitting subtrees are split across pJobs when given
+	void Update(JobSystem* pJobs = nullptr);
+	void Rebuild(JobSystem* pJobs = nullptr);
+
+	//cost over the cost right after the build that triggers a rebuild
+	void SetRebuildRatio(float ratio) noexcept;
+	float GetRebuildRatio() const noexcept;
+
+	//indices of the objects whose spheres are inside or touch the frustum of a view projection (row vectors, D3D depth 0..w)
+	void QueryFrustum(const DirectX::XMFLOAT4X4& viewProj, std::vector<uint32_t>& indices) const;
+	void QuerySphere(const DirectX::XMFLOAT3& center, float radius, std::vector<uint32_t>& indices) const;
+	//nearest sphere the ray enters (or starts in) within maxDistance, direction doesn't have to be normalized
+	std::optional<Hit> Raycast(const DirectX::XMFLOAT3& origin, const DirectX::XMFLOAT3& direction, float maxDistance = 3.4e38f) const noexcept;
+
+	const Stats& GetStats() const noexcept;
+
+private:
+
+	struct Sphere {
+
+		float x;
+		float y;
+		float z;
+		float r;
+	};
+
+	//the left child is always the next node
+	struct Node {
+
+		float min[3];
+		//items of the whole subtree are [firstItem, firstItem + itemCount) in m_items
+		uint32_t firstItem;
+		float max[3];
+		uint32_t itemCount;
+		//0 for leaves, the root is never anyone's child
+		uint32_t right;
+	};
+
+	//an object's place along the morton curve through the centers' bounds
+	struct BuildItem {
+
+		uint32_t code;
+		uint32_t index;
+	};
+
+	//a subtree refit as one job
+	struct Subtree {
+
+		uint32_t root;
+		uint32_t nodeCount;
+	};
+
+	void SortItems(JobSystem* pJobs);
+	//appends the subtree over the sorted items [firstItem, firstItem + itemCount)
+	void Build(uint32_t firstItem, uint32_t itemCount);
+	//bottom up over [first, last) in reverse, children always come after their parent, returns the sum of the areas
+	double Refit(uint32_t first, uint32_t last) noexcept;
+	void Refit(JobSystem* pJobs);
+	void AddSubtrees(uint32_t node, unsigned int depth);
+
+private:
+
+	std::vector<Sphere> m_spheres;
+	bool m_isDirty = true;
+	float m_rebuildRatio = 1.6f;
+
+	std::vector<Node> m_nodes;
+	std::vector<uint32_t> m_items;
+	std::vector<BuildItem> m_buildItems;
+	std::vector<BuildItem> m_sortScratch;
+
+	//subtrees at the split depth and the nodes above them, depth first
+	std::vector<Subtree> m_subtrees;
+	std::vector<uint32_t> m_topNodes;
+	std::vector<double> m_subtreeAreas;
+
+	Stats m_stats;
+};
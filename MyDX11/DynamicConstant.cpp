@@ -0,0 +1,109 @@
+#include "DynamicConstant.h"
+#include <cstring>
+#include <algorithm>
+
+namespace MyDynamicConstant {
+
+	CbufLayout& CbufLayout::Append(ElementType type, std::string name, size_t arrayCount) noexcept(!IS_DEBUG)
+	{
+		assert("Array count must be at least 1" && arrayCount != 0u);
+
+		const auto size = Element::SizeOf(type);
+		auto offset = GetPackedSize();
+
+		//matrices and arrays begin a new register, anything else only if it would straddle one
+		const bool isNewRegister =
+			type == Matrix ||
+			arrayCount > 1u ||
+			offset / 16u != (offset + size - 1u) / 16u;
+
+		//(whatever follows an array can still share the register of its last slot)
+		if (isNewRegister) {
+
+			offset = (offset + 15u) & ~size_t(15u);
+		}
+
+		m_elements.emplace_back(type, std::move(name), arrayCount, offset);
+		return *this;
+	}
+
+	const CbufLayout::Element& CbufLayout::Resolve(const std::string& name) const noexcept(!IS_DEBUG)
+	{
+		for (auto& e : m_elements) {
+
+			if (e.GetName() == name) {
+
+				return e;
+			}
+		}
+
+		assert("Could not resolve cbuffer element name" && false);
+
+		return m_elements.front();
+	}
+
+	std::vector<ShaderReflection::Problem> CbufLayout::Check(const ShaderReflection::Cbuffer& cbuffer) const
+	{
+		std::vector<ShaderReflection::CbufferField> fields;
+		fields.reserve(m_elements.size());
+
+		for (const auto& e : m_elements) {
+
+			fields.push_back({ e.GetName(),e.GetOffset(),e.GetOffsetAfter() - e.GetOffset() });
+		}
+
+		auto problems = ShaderReflection::CheckCbuffer(cbuffer, fields);
+
+		if (Size() != cbuffer.size) {
+
+			problems.push_back({ true,"Cbuffer " + cbuffer.name + " is " + std::to_string(cbuffer.size) + " bytes in the hlsl but " + std::to_string(Size()) + " in the layout" });
+		}
+
+		return problems;
+	}
+
+	ElementRef ElementRef::operator[](size_t i) const noexcept(!IS_DEBUG)
+	{
+		assert("Indexing a cbuffer element that isn't an array" && m_element.GetArrayCount() > 1u);
+		assert("Cbuffer array index out of range" && i < m_element.GetArrayCount());
+
+		return { m_buffer,m_element,m_element.GetOffset() + i * m_element.GetArrayStride() };
+	}
+
+	void ElementRef::Write(const void* pData, size_t size) noexcept(!IS_DEBUG)
+	{
+		auto pDst = m_buffer.m_bytes.data() + m_offset;
+
+		//same value, nothing to upload
+		if (std::memcmp(pDst, pData, size) == 0) {
+
+			return;
+		}
+
+		std::memcpy(pDst, pData, size);
+
+		m_buffer.m_dirtyBegin = std::min(m_buffer.m_dirtyBegin, m_offset);
+		m_buffer.m_dirtyEnd = std::max(m_buffer.m_dirtyEnd, m_offset + size);
+	}
+
+	const char* ElementRef::Data() const noexcept
+	{
+		return m_buffer.m_bytes.data() + m_offset;
+	}
+
+	CbufBuffer::CbufBuffer(CbufLayout layout) noexcept(!IS_DEBUG)
+		:
+		m_layout(std::move(layout)),
+		m_bytes(m_layout.Size(), 0),
+		m_dirtyBegin(0u),
+		m_dirtyEnd(m_bytes.size())
+	{}
+
+	ElementRef CbufBuffer::operator[](const std::string& name) noexcept(!IS_DEBUG)
+	{
+		const auto& element = m_layout.Resolve(name);
+
+		return { *this,element,element.GetOffset() };
+	}
+
+}
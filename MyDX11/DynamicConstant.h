@@ -0,0 +1,330 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <type_traits>
+#include <cassert>
+#include "graphics.h"
+#include "ShaderReflection.h"
+
+namespace MyDynamicConstant {
+
+	/// <summary>
+	/// Runtime description of an hlsl cbuffer, offsets follow the hlsl packing rules
+	/// (nothing straddles a 16 byte register, matrices and array elements start a new one)
+	/// so the c++ side needs no hand written padding
+	/// </summary>
+	class CbufLayout
+	{
+
+	public:
+
+		enum ElementType
+		{
+			Float,
+			Float2,
+			Float3,
+			Float4,
+			Matrix,
+			Bool,
+			Count,
+		};
+
+		template<ElementType> struct Map;
+		template<> struct Map<Float>{
+
+			using SysType = float;
+			static constexpr const char* hlslName = "float";
+		};
+
+		template<> struct Map<Float2>{
+
+			using SysType = DirectX::XMFLOAT2;
+			static constexpr const char* hlslName = "float2";
+		};
+
+		template<> struct Map<Float3>{
+
+			using SysType = DirectX::XMFLOAT3;
+			static constexpr const char* hlslName = "float3";
+		};
+
+		template<> struct Map<Float4>{
+
+			using SysType = DirectX::XMFLOAT4;
+			static constexpr const char* hlslName = "float4";
+		};
+
+		template<> struct Map<Matrix>{
+
+			using SysType = DirectX::XMFLOAT4X4;
+			static constexpr const char* hlslName = "matrix";
+		};
+
+		//hlsl bool is 4 bytes
+		template<> struct Map<Bool>{
+
+			using SysType = BOOL;
+			static constexpr const char* hlslName = "bool";
+		};
+
+		class Element{
+
+		public:
+
+			Element(ElementType type, std::string name, size_t arrayCount, size_t offset)
+				:
+				m_type(type),
+				m_name(std::move(name)),
+				m_arrayCount(arrayCount),
+				m_offset(offset)
+			{}
+
+			size_t GetOffset() const noexcept{
+
+				return m_offset;
+			}
+
+			//arrays keep every element in its own register, the last one can share its tail
+			size_t GetOffsetAfter() const noexcept(!IS_DEBUG){
+
+				return m_offset + (m_arrayCount - 1u) * GetArrayStride() + SizeOf(m_type);
+			}
+
+			size_t GetArrayStride() const noexcept(!IS_DEBUG){
+
+				return (SizeOf(m_type) + 15u) & ~size_t(15u);
+			}
+
+			size_t GetArrayCount() const noexcept{
+
+				return m_arrayCount;
+			}
+
+			ElementType GetType() const noexcept{
+
+				return m_type;
+			}
+
+			const std::string& GetName() const noexcept{
+
+				return m_name;
+			}
+
+			static constexpr size_t SizeOf(ElementType type) noexcept(!IS_DEBUG)
+			{
+
+				switch (type)
+				{
+				case Float:
+
+					return sizeof(Map<Float>::SysType);
+
+				case Float2:
+
+					return sizeof(Map<Float2>::SysType);
+
+				case Float3:
+
+					return sizeof(Map<Float3>::SysType);
+
+				case Float4:
+
+					return sizeof(Map<Float4>::SysType);
+
+				case Matrix:
+
+					return sizeof(Map<Matrix>::SysType);
+
+				case Bool:
+
+					return sizeof(Map<Bool>::SysType);
+				}
+
+				assert("Invalid element type" && false);
+				return 0u;
+			}
+
+			//does the c++ type match the element type
+			template<typename T>
+			static constexpr bool IsSysType(ElementType type) noexcept
+			{
+
+				switch (type)
+				{
+				case Float:
+
+					return std::is_same<T, Map<Float>::SysType>::value;
+
+				case Float2:
+
+					return std::is_same<T, Map<Float2>::SysType>::value;
+
+				case Float3:
+
+					return std::is_same<T, Map<Float3>::SysType>::value;
+
+				case Float4:
+
+					return std::is_same<T, Map<Float4>::SysType>::value;
+
+				case Matrix:
+
+					return std::is_same<T, Map<Matrix>::SysType>::value;
+
+				case Bool:
+
+					return std::is_same<T, Map<Bool>::SysType>::value;
+				}
+
+				return false;
+			}
+
+		private:
+
+			ElementType m_type;
+			std::string m_name;
+			size_t m_arrayCount;
+			size_t m_offset;
+		};
+
+	public:
+
+		//arrayCount > 1 declares an hlsl array (type name[arrayCount])
+		CbufLayout& Append(ElementType type, std::string name, size_t arrayCount = 1u) noexcept(!IS_DEBUG);
+
+		const Element& Resolve(const std::string& name) const noexcept(!IS_DEBUG);
+
+		const Element& ResolveByIndex(size_t i) const noexcept(!IS_DEBUG){
+
+			return m_elements[i];
+		}
+
+		//offsets and sizes against the cbuffer of the same name in a compiled shader
+		std::vector<ShaderReflection::Problem> Check(const ShaderReflection::Cbuffer& cbuffer) const;
+
+		size_t GetElementCount() const noexcept{
+
+			return m_elements.size();
+		}
+
+		//bytes up to the end of the last element
+		size_t GetPackedSize() const noexcept(!IS_DEBUG){
+
+			return m_elements.empty() ? 0u : m_elements.back().GetOffsetAfter();
+		}
+
+		//constant buffer sizes are whole registers
+		size_t Size() const noexcept(!IS_DEBUG){
+
+			return (GetPackedSize() + 15u) & ~size_t(15u);
+		}
+
+	private:
+
+		std::vector<Element> m_elements;
+	};
+
+	class CbufBuffer;
+
+	//one element (or array slot) of a CbufBuffer, writes only mark dirty when the bytes change
+	class ElementRef
+	{
+
+		friend class CbufBuffer;
+
+	public:
+
+		//array slot, the element has to be an array
+		ElementRef operator[](size_t i) const noexcept(!IS_DEBUG);
+
+		template<typename T>
+		ElementRef& operator=(const T& val) noexcept(!IS_DEBUG)
+		{
+			assert("Parameter type doesn't match the cbuffer element" && CbufLayout::Element::IsSysType<T>(m_element.GetType()));
+
+			Write(&val, sizeof(T));
+			return *this;
+		}
+
+		template<typename T>
+		const T& Get() const noexcept(!IS_DEBUG)
+		{
+			assert("Parameter type doesn't match the cbuffer element" && CbufLayout::Element::IsSysType<T>(m_element.GetType()));
+
+			return *reinterpret_cast<const T*>(Data());
+		}
+
+	private:
+
+		ElementRef(CbufBuffer& buffer, const CbufLayout::Element& element, size_t offset) noexcept
+			:
+			m_buffer(buffer),
+			m_element(element),
+			m_offset(offset)
+		{}
+
+		void Write(const void* pData, size_t size) noexcept(!IS_DEBUG);
+		const char* Data() const noexcept;
+
+	private:
+
+		CbufBuffer& m_buffer;
+		const CbufLayout::Element& m_element;
+		size_t m_offset;
+	};
+
+	//cpu copy of a cbuffer plus the byte range changed since the last upload
+	class CbufBuffer
+	{
+
+		friend class ElementRef;
+
+	public:
+
+		//starts zeroed and fully dirty
+		CbufBuffer(CbufLayout layout) noexcept(!IS_DEBUG);
+
+		ElementRef operator[](const std::string& name) noexcept(!IS_DEBUG);
+
+		const char* GetData() const noexcept{
+
+			return m_bytes.data();
+		}
+
+		size_t SizeBytes() const noexcept{
+
+			return m_bytes.size();
+		}
+
+		const CbufLayout& GetLayout() const noexcept{
+
+			return m_layout;
+		}
+
+		bool IsDirty() const noexcept{
+
+			return m_dirtyBegin < m_dirtyEnd;
+		}
+
+		//[first, second) byte range written since the last ClearDirty
+		std::pair<size_t, size_t> GetDirtyRange() const noexcept{
+
+			return { m_dirtyBegin,m_dirtyEnd };
+		}
+
+		void ClearDirty() noexcept{
+
+			m_dirtyBegin = m_bytes.size();
+			m_dirtyEnd = 0u;
+		}
+
+	private:
+
+		CbufLayout m_layout;
+		std::vector<char> m_bytes;
+		size_t m_dirtyBegin;
+		size_t m_dirtyEnd;
+	};
+
+}
@@ -0,0 +1,87 @@
+#include "DynamicConstantBuffers.h"
+#include "GraphicsThrowMacros.h"
+
+namespace Bind {
+
+	DynamicConstantBuffer::DynamicConstantBuffer(Graphics& gfx, MyDynamicConstant::CbufBuffer buffer, UINT slot)
+		:
+		slot(slot),
+		m_buffer(std::move(buffer))
+	{
+
+		INFOMAN(gfx);
+
+		D3D11_BUFFER_DESC cbd;
+		cbd.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+		cbd.Usage = D3D11_USAGE_DYNAMIC;
+		cbd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+		cbd.MiscFlags = 0u;
+		cbd.ByteWidth = (UINT)m_buffer.SizeBytes();
+		cbd.StructureByteStride = 0u;
+
+		D3D11_SUBRESOURCE_DATA csd = {};
+		csd.pSysMem = m_buffer.GetData();
+
+		GFX_THROW_INFO(GetDevice(gfx)->CreateBuffer(&cbd, &csd, &pConstantBuffer));
+
+		//the gpu copy starts in sync
+		m_buffer.ClearDirty();
+	}
+
+	MyDynamicConstant::CbufBuffer& DynamicConstantBuffer::GetBuffer() noexcept
+	{
+		return m_buffer;
+	}
+
+	const MyDynamicConstant::CbufBuffer& DynamicConstantBuffer::GetBuffer() const noexcept
+	{
+		return m_buffer;
+	}
+
+	void DynamicConstantBuffer::Update(Graphics& gfx)
+	{
+		//nothing written (or only the same values), skip the map entirely
+		if (!m_buffer.IsDirty()) {
+
+			return;
+		}
+
+		INFOMAN(gfx);
+
+		//discard hands back fresh memory, so the whole buffer is copied, not just the dirty range
+		D3D11_MAPPED_SUBRESOURCE msr;
+		GFX_THROW_INFO(GetContext(gfx)->Map(
+			pConstantBuffer.Get(), 0u,
+			D3D11_MAP_WRITE_DISCARD, 0u,
+			&msr
+		));
+
+		memcpy(msr.pData, m_buffer.GetData(), m_buffer.SizeBytes());
+		GetContext(gfx)->Unmap(pConstantBuffer.Get(), 0u);
+
+		m_buffer.ClearDirty();
+	}
+
+	DynamicVertexConstantBuffer::DynamicVertexConstantBuffer(Graphics& gfx, MyDynamicConstant::CbufBuffer buffer, UINT slot)
+		:
+		DynamicConstantBuffer(gfx, std::move(buffer), slot)
+	{}
+
+	void DynamicVertexConstantBuffer::Bind(Graphics& gfx) noexcept
+	{
+		Update(gfx);
+		GetContext(gfx)->VSSetConstantBuffers(slot, 1u, pConstantBuffer.GetAddressOf());
+	}
+
+	DynamicPixelConstantBuffer::DynamicPixelConstantBuffer(Graphics& gfx, MyDynamicConstant::CbufBuffer buffer, UINT slot)
+		:
+		DynamicConstantBuffer(gfx, std::move(buffer), slot)
+	{}
+
+	void DynamicPixelConstantBuffer::Bind(Graphics& gfx) noexcept
+	{
+		Update(gfx);
+		GetContext(gfx)->PSSetConstantBuffers(slot, 1u, pConstantBuffer.GetAddressOf());
+	}
+
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Bindable.h"
+#include "DynamicConstant.h"
+
+namespace Bind {
+
+	//Base DynamicConstantBuffer
+	//*layout is described at runtime, the cpu copy is only uploaded when it changed
+	class DynamicConstantBuffer :public Bindable {
+
+	public:
+
+		//edits go to the cpu copy and are uploaded by the next Update/Bind
+		MyDynamicConstant::CbufBuffer& GetBuffer() noexcept;
+		const MyDynamicConstant::CbufBuffer& GetBuffer() const noexcept;
+
+		//uploads the cpu copy if anything in it changed, otherwise does nothing
+		void Update(Graphics& gfx);
+
+	protected:
+
+		//constructor creating the buffer with the current contents
+		DynamicConstantBuffer(Graphics& gfx, MyDynamicConstant::CbufBuffer buffer, UINT slot);
+
+	protected:
+
+		//ComPtr for ConstantBuffer
+		Microsoft::WRL::ComPtr<ID3D11Buffer> pConstantBuffer;
+
+		UINT slot;
+
+	private:
+
+		MyDynamicConstant::CbufBuffer m_buffer;
+	};
+
+	//DynamicVertexConstantBuffer
+	class DynamicVertexConstantBuffer :public DynamicConstantBuffer {
+
+	public:
+
+		DynamicVertexConstantBuffer(Graphics& gfx, MyDynamicConstant::CbufBuffer buffer, UINT slot = 0u);
+
+		//upload if dirty then bind to the vertex shader
+		void Bind(Graphics& gfx) noexcept override;
+	};
+
+	//DynamicPixelConstantBuffer
+	class DynamicPixelConstantBuffer :public DynamicConstantBuffer {
+
+	public:
+
+		DynamicPixelConstantBuffer(Graphics& gfx, MyDynamicConstant::CbufBuffer buffer, UINT slot = 0u);
+
+		//upload if dirty then bind to the pixel shader
+		void Bind(Graphics& gfx) noexcept override;
+	};
+
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <optional>
+#include <cstddef>
+#include <cstdint>
+
+/// <summary>
+/// Fixed capacity queue for one producer thread and one consumer thread, no locks and no allocation once constructed
+/// the window's message pump pushes input events and the frame loop reads them, the two can be on different threads
+/// a full ring drops the new event and counts it, the producer never touches the read end
+/// </summary>
+template<typename T>
+class EventRing {
+
+public:
+
+	//capacity is rounded up to a power of two so positions wrap with a mask
+	explicit EventRing(size_t capacity)
+		:
+		m_events(RoundUp(capacity)),
+		m_mask(m_events.size() - 1u)
+	{}
+
+	EventRing(const EventRing&) = delete;
+	EventRing& operator=(const EventRing&) = delete;
+
+	//producer side, false when the ring is full and the event was dropped
+	bool Push(const T& event) noexcept {
+
+		const size_t tail = m_write.tail.load(std::memory_order_relaxed);
+
+		//the consumer's position is only reloaded when the cached one says full
+		if (tail - m_write.cachedHead == m_events.size()) {
+
+			m_write.cachedHead = m_read.head.load(std::memory_order_acquire);
+
+			if (tail - m_write.cachedHead == m_events.size()) {
+
+				m_overflows.fetch_add(1u, std::memory_order_relaxed);
+				return false;
+			}
+		}
+
+		m_events[tail & m_mask] = event;
+		m_write.tail.store(tail + 1u, std::memory_order_release);
+
+		return true;
+	}
+
+	//consumer side, oldest event first
+	std::optional<T> Pop() noexcept {
+
+		const size_t head = m_read.head.load(std::memory_order_relaxed);
+
+		if (head == m_read.cachedTail) {
+
+			m_read.cachedTail = m_write.tail.load(std::memory_order_acquire);
+
+			if (head == m_read.cachedTail) {
+
+				return std::nullopt;
+			}
+		}
+
+		const T event = m_events[head & m_mask];
+		m_read.head.store(head + 1u, std::memory_order_release);
+
+		return event;
+	}
+
+	//consumer side, drops everything pushed so far
+	void Clear() noexcept {
+
+		m_read.cachedTail = m_write.tail.load(std::memory_order_acquire);
+		m_read.head.store(m_read.cachedTail, std::memory_order_release);
+	}
+
+	//exact from the consumer, a snapshot from anywhere else
+	bool IsEmpty() const noexcept {
+
+		return GetSize() == 0u;
+	}
+
+	size_t GetSize() const noexcept {
+
+		const size_t head = m_read.head.load(std::memory_order_acquire);
+
+		return m_write.tail.load(std::memory_order_acquire) - head;
+	}
+
+	size_t GetCapacity() const noexcept {
+
+		return m_events.size();
+	}
+
+	//events dropped because the ring was full, since construction
+	uint64_t GetOverflowCount() const noexcept {
+
+		return m_overflows.load(std::memory_order_relaxed);
+	}
+
+private:
+
+	static size_t RoundUp(size_t capacity) noexcept {
+
+		size_t size = 1u;
+
+		while (size < capacity) {
+
+			size <<= 1u;
+		}
+
+		return size;
+	}
+
+private:
+
+	//each end on its own cache line with the copy of the other end it last saw, positions only ever grow
+	struct alignas(64) WriteEnd {
+
+		std::atomic<size_t> tail = 0u;
+		size_t cachedHead = 0u;
+	};
+
+	struct alignas(64) ReadEnd {
+
+		std::atomic<size_t> head = 0u;
+		size_t cachedTail = 0u;
+	};
+
+	std::vector<T> m_events;
+	size_t m_mask;
+	std::atomic<uint64_t> m_overflows = 0u;
+
+	WriteEnd m_write;
+	ReadEnd m_read;
+};
@@ -0,0 +1,99 @@
+#include "FixedTimestep.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+FixedTimestep::FixedTimestep(double step, unsigned int maxStepsPerFrame, double maxFrameTime) noexcept
+	:
+	m_step(step),
+	m_maxStepsPerFrame(maxStepsPerFrame),
+	m_maxFrameTime(maxFrameTime),
+	m_lastMaxSteps(maxStepsPerFrame)
+{
+	assert("Simulation step has to be positive" && step > 0.0);
+	assert("At least one step per frame" && maxStepsPerFrame > 0u);
+}
+
+unsigned int FixedTimestep::Advance(double seconds, double speed) noexcept
+{
+	seconds = std::max(seconds, 0.0);
+	speed = std::max(speed, 0.0);
+
+	//the clamp and the cap are about slow frames, so they're applied in real time
+	//and fast forward runs more steps per frame rather than hitting the cap on every one
+	if (seconds > m_maxFrameTime) {
+
+		m_dropped += (seconds - m_maxFrameTime) * speed;
+		seconds = m_maxFrameTime;
+	}
+
+	m_accumulator += seconds * speed;
+
+	const auto maxSteps = (unsigned int)std::ceil(m_maxStepsPerFrame * std::max(speed, 1.0));
+	auto steps = (unsigned int)std::floor(m_accumulator / m_step);
+
+	//spiral of death guard, if the steps can't keep up the simulation slows down rather than the frames
+	if (steps > maxSteps) {
+
+		m_dropped += (steps - maxSteps) * m_step;
+		m_accumulator -= (steps - maxSteps) * m_step;
+		steps = maxSteps;
+	}
+
+	//rounding can leave the remainder a hair outside [0,step)
+	m_accumulator = std::clamp(m_accumulator - steps * m_step, 0.0, m_step);
+
+	m_lastSteps = steps;
+	m_lastMaxSteps = maxSteps;
+	m_totalSteps += steps;
+
+	return steps;
+}
+
+float FixedTimestep::GetAlpha() const noexcept
+{
+	return (float)std::min(m_accumulator / m_step, 1.0);
+}
+
+float FixedTimestep::GetStep() const noexcept
+{
+	return (float)m_step;
+}
+
+void FixedTimestep::SetStep(double step) noexcept
+{
+	assert("Simulation step has to be positive" && step > 0.0);
+
+	m_accumulator *= step / m_step;
+	m_step = step;
+}
+
+double FixedTimestep::GetMaxFrameTime() const noexcept
+{
+	return m_maxFrameTime;
+}
+
+unsigned int FixedTimestep::GetMaxStepsPerFrame() const noexcept
+{
+	return m_maxStepsPerFrame;
+}
+
+unsigned int FixedTimestep::GetLastMaxStepCount() const noexcept
+{
+	return m_lastMaxSteps;
+}
+
+unsigned int FixedTimestep::GetLastStepCount() const noexcept
+{
+	return m_lastSteps;
+}
+
+unsigned long long FixedTimestep::GetTotalStepCount() const noexcept
+{
+	return m_totalSteps;
+}
+
+double FixedTimestep::GetDroppedTime() const noexcept
+{
+	return m_dropped;
+}
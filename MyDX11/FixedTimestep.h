@@ -0,0 +1,52 @@
+#pragma once
+
+/// <summary>
+/// Accumulator that turns variable frame times into a whole number of fixed simulation steps
+/// the simulation then advances the same way at any frame rate and the leftover time becomes the
+/// interpolation factor between the last two simulated states for rendering
+/// long frames are clamped and the steps per frame capped, so a hitch can't snowball into ever longer catch-up frames
+/// a speed factor plays the simulation faster or slower than real time by running more or fewer steps of the same length
+/// </summary>
+class FixedTimestep {
+
+public:
+
+	//120 Hz, at most 8 steps (two 30 fps frames of catch-up) and a quarter second per frame
+	//*both limits are in real time, at 4x speed a frame may run 4 times the steps before the cap kicks in
+	FixedTimestep(double step = 1.0 / 120.0, unsigned int maxStepsPerFrame = 8u, double maxFrameTime = 0.25) noexcept;
+
+	//adds one frame of real seconds played at speed times real time and returns the steps to run for it, never more than the cap
+	//*time past the cap is dropped instead of carried into the next frame
+	unsigned int Advance(double seconds, double speed = 1.0) noexcept;
+
+	//time left over after the last step as a fraction of a step, [0,1)
+	float GetAlpha() const noexcept;
+
+	float GetStep() const noexcept;
+	//keeps the fraction of a step already accumulated
+	void SetStep(double step) noexcept;
+
+	//frame times above this are treated as this long
+	double GetMaxFrameTime() const noexcept;
+	//at real time, faster frames get proportionally more
+	unsigned int GetMaxStepsPerFrame() const noexcept;
+
+	unsigned int GetLastStepCount() const noexcept;
+	//the cap the last frame ran under
+	unsigned int GetLastMaxStepCount() const noexcept;
+	unsigned long long GetTotalStepCount() const noexcept;
+	//simulated seconds thrown away by the clamp and the cap so far
+	double GetDroppedTime() const noexcept;
+
+private:
+
+	double m_step;
+	unsigned int m_maxStepsPerFrame;
+	double m_maxFrameTime;
+
+	double m_accumulator = 0.0;
+	unsigned int m_lastSteps = 0u;
+	unsigned int m_lastMaxSteps;
+	unsigned long long m_totalSteps = 0u;
+	double m_dropped = 0.0;
+};
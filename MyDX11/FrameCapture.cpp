@@ -0,0 +1,267 @@
+#include "FrameCapture.h"
+#include "GraphicsThrowMacros.h"
+#include "Surface.h"
+#include "PixelKernels.h"
+#include "Profiler.h"
+#include <filesystem>
+#include <stdexcept>
+
+FrameCapture::FrameCapture(Graphics& gfx, unsigned int ringSize)
+	:
+	m_width(gfx.GetWidth()),
+	m_height(gfx.GetHeight()),
+	m_pContext(gfx.pContext)
+{
+	INFOMAN(gfx);
+
+	gfx.pTarget->GetResource(&m_pBackBuffer);
+
+	//same size and format as the swap chain, readable by the CPU
+	D3D11_TEXTURE2D_DESC desc = {};
+	desc.Width = m_width;
+	desc.Height = m_height;
+	desc.MipLevels = 1u;
+	desc.ArraySize = 1u;
+	desc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+	desc.SampleDesc.Count = 1u;
+	desc.SampleDesc.Quality = 0u;
+	desc.Usage = D3D11_USAGE_STAGING;
+	desc.BindFlags = 0u;
+	desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+	desc.MiscFlags = 0u;
+
+	for (unsigned int i = 0; i < ringSize; i++) {
+
+		auto pSlot = std::make_unique<Slot>();
+
+		GFX_THROW_INFO(gfx.pDevice->CreateTexture2D(&desc, nullptr, &pSlot->pStaging));
+
+		m_slots.push_back(std::move(pSlot));
+	}
+
+	m_thread = std::thread(&FrameCapture::WorkerLoop, this);
+}
+
+FrameCapture::~FrameCapture()
+{
+	//copies the GPU still owes are waited for here, the frame loop is gone by now
+	for (size_t i = 0; i < m_slots.size(); i++) {
+
+		auto& slot = *m_slots[(m_next + i) % m_slots.size()];
+
+		if (slot.state != State::Copied) {
+
+			continue;
+		}
+
+		if (FAILED(m_pContext->Map(slot.pStaging.Get(), 0u, D3D11_MAP_READ, 0u, &slot.mapped))) {
+
+			slot.state = State::Free;
+			m_failed++;
+
+			continue;
+		}
+
+		slot.isConverted = false;
+		slot.state = State::Mapped;
+
+		std::lock_guard<std::mutex> lock(m_queueMtx);
+		m_queue.push_back(&slot);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_queueMtx);
+		m_isQuitting = true;
+	}
+
+	m_wake.notify_all();
+	m_thread.join();
+
+	for (const auto& pSlot : m_slots) {
+
+		if (pSlot->state == State::Mapped) {
+
+			m_pContext->Unmap(pSlot->pStaging.Get(), 0u);
+		}
+	}
+}
+
+void FrameCapture::Update(Graphics& gfx, const std::string& path)
+{
+	INFOMAN(gfx);
+
+	const size_t count = m_slots.size();
+
+	//slots the worker has copied out of go back to the ring
+	for (const auto& pSlot : m_slots) {
+
+		if (pSlot->state == State::Mapped && pSlot->isConverted.load(std::memory_order_acquire)) {
+
+			m_pContext->Unmap(pSlot->pStaging.Get(), 0u);
+			pSlot->state = State::Free;
+		}
+	}
+
+	//oldest copy first, while one is still in flight so is every later one
+	for (size_t i = 0; i < count; i++) {
+
+		auto& slot = *m_slots[(m_next + i) % count];
+
+		if (slot.state != State::Copied) {
+
+			continue;
+		}
+
+#ifndef NDEBUG
+		infoManager.Set();
+#endif
+
+		hr = m_pContext->Map(slot.pStaging.Get(), 0u, D3D11_MAP_READ, D3D11_MAP_FLAG_DO_NOT_WAIT, &slot.mapped);
+
+		if (hr == DXGI_ERROR_WAS_STILL_DRAWING) {
+
+			break;
+		}
+
+		if (FAILED(hr)) {
+
+			throw GFX_EXCEPT(hr);
+		}
+
+		slot.isConverted.store(false, std::memory_order_relaxed);
+		slot.state = State::Mapped;
+
+		{
+			std::lock_guard<std::mutex> lock(m_queueMtx);
+			m_queue.push_back(&slot);
+		}
+
+		m_wake.notify_one();
+	}
+
+	if (path.empty()) {
+
+		return;
+	}
+
+	auto& slot = *m_slots[m_next];
+
+	//the ring is full of frames the worker has not got to yet
+	if (slot.state != State::Free) {
+
+		m_dropped++;
+		return;
+	}
+
+	GFX_THROW_INFO_ONLY(m_pContext->CopyResource(slot.pStaging.Get(), m_pBackBuffer.Get()));
+
+	slot.path = path;
+	slot.state = State::Copied;
+	m_next = (m_next + 1u) % count;
+	m_captured++;
+}
+
+FrameCapture::Stats FrameCapture::GetStats() const
+{
+	Stats stats;
+	stats.captured = m_captured;
+	stats.written = m_written;
+	stats.dropped = m_dropped;
+	stats.failed = m_failed;
+
+	std::lock_guard<std::mutex> lock(m_statsMtx);
+	stats.lastFile = m_lastFile;
+	stats.lastError = m_lastError;
+
+	return stats;
+}
+
+void FrameCapture::WorkerLoop() noexcept
+{
+	PROFILE_THREAD("Capture");
+
+	while (true) {
+
+		Slot* pSlot = nullptr;
+
+		{
+			std::unique_lock<std::mutex> lock(m_queueMtx);
+			m_wake.wait(lock, [this] { return !m_queue.empty() || m_isQuitting; });
+
+			//whatever was queued before quitting is still written
+			if (m_queue.empty()) {
+
+				return;
+			}
+
+			pSlot = m_queue.front();
+			m_queue.pop_front();
+		}
+
+		Write(*pSlot);
+	}
+}
+
+void FrameCapture::Write(Slot& slot) noexcept
+{
+	PROFILE_ZONE("FrameCapture::Write");
+
+	const std::string path = slot.path;
+	std::string error;
+	bool isReleased = false;
+
+	try {
+
+		Surface surface(m_width, m_height);
+
+		//rows of the mapping are padded to RowPitch
+		const PixelKernels::ConstImage src(static_cast<const uint32_t*>(slot.mapped.pData), slot.mapped.RowPitch / sizeof(uint32_t), m_width, m_height);
+		PixelKernels::Blit(src, PixelKernels::Image(reinterpret_cast<uint32_t*>(surface.GetBufferPtr()), m_width, m_width, m_height));
+
+		//the render thread unmaps and reuses the slot from here on, it must not be touched again
+		slot.isConverted.store(true, std::memory_order_release);
+		isReleased = true;
+
+		std::error_code ec;
+		std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+
+		//the back buffer's alpha is whatever the blend states left there
+		surface.Save(path, false);
+	}
+	catch (const Surface::Exception& e) {
+
+		error = e.GetNote();
+	}
+	catch (const std::exception& e) {
+
+		error = e.what();
+	}
+
+	//a failure before the copy still has to give the slot back
+	if (!isReleased) {
+
+		slot.isConverted.store(true, std::memory_order_release);
+	}
+
+	std::lock_guard<std::mutex> lock(m_statsMtx);
+
+	if (error.empty()) {
+
+		m_written++;
+		m_lastFile = path;
+	}
+	else {
+
+		m_failed++;
+		m_lastError = error;
+	}
+}
+
+DxgiInfoManager& FrameCapture::GetInfoManager(Graphics& gfx)
+{
+#ifndef NDEBUG
+	return gfx.infoManager;
+#else
+	throw std::logic_error("Bruh why you do this! (tried to access gfx.infoManager in Release config)");
+#endif
+}
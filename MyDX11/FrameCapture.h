@@ -0,0 +1,108 @@
+#pragma once
+
+#include "graphics.h"
+#include <vector>
+#include <deque>
+#include <memory>
+#include <string>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+/// <summary>
+/// Screenshots and frame sequences without stalling the frame
+/// the back buffer is copied into one of a ring of staging textures and mapped a few frames later, once the GPU is done with it
+/// a worker thread copies the mapped texels into a Surface, hands the slot back and then encodes and writes the file
+/// when every slot is still busy the frame is dropped, the render thread never waits on the GPU or the disk
+/// </summary>
+class FrameCapture {
+
+public:
+
+	struct Stats {
+
+		size_t captured = 0u;
+		size_t written = 0u;
+		size_t dropped = 0u;
+		size_t failed = 0u;
+
+		std::string lastFile;
+		std::string lastError;
+	};
+
+public:
+
+	//more slots ride out longer encodes, each one is a full back buffer
+	FrameCapture(Graphics& gfx, unsigned int ringSize = 4u);
+	FrameCapture(const FrameCapture&) = delete;
+	FrameCapture& operator=(const FrameCapture&) = delete;
+	//writes everything already copied, with the render thread stopped
+	~FrameCapture();
+
+	//render thread, after the scene and before the imgui pass so imgui stays out of the shot
+	//*an empty path captures nothing this frame, the extension picks the format (.png or .qoi)
+	void Update(Graphics& gfx, const std::string& path);
+
+	//any thread
+	Stats GetStats() const;
+
+private:
+
+	enum class State {
+
+		Free,
+		//copy queued on the GPU
+		Copied,
+		//mapped and waiting for (or in) the worker
+		Mapped,
+	};
+
+	struct Slot {
+
+		Microsoft::WRL::ComPtr<ID3D11Texture2D> pStaging;
+		State state = State::Free;
+		std::string path;
+		D3D11_MAPPED_SUBRESOURCE mapped = {};
+
+		//set by the worker once the texels are out of the mapping
+		std::atomic<bool> isConverted = false;
+	};
+
+private:
+
+	void WorkerLoop() noexcept;
+	void Write(Slot& slot) noexcept;
+
+	//for INFOMAN, the same access Bindable has
+	static DxgiInfoManager& GetInfoManager(Graphics& gfx);
+
+private:
+
+	UINT m_width;
+	UINT m_height;
+
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext> m_pContext;
+	Microsoft::WRL::ComPtr<ID3D11Resource> m_pBackBuffer;
+
+	//copied in ring order, so walking on from m_next visits the slots oldest first
+	std::vector<std::unique_ptr<Slot>> m_slots;
+	size_t m_next = 0u;
+
+	//mapped slots in the order they were copied
+	std::mutex m_queueMtx;
+	std::condition_variable m_wake;
+	std::deque<Slot*> m_queue;
+	bool m_isQuitting = false;
+
+	std::atomic<size_t> m_captured = 0u;
+	std::atomic<size_t> m_written = 0u;
+	std::atomic<size_t> m_dropped = 0u;
+	std::atomic<size_t> m_failed = 0u;
+
+	mutable std::mutex m_statsMtx;
+	std::string m_lastFile;
+	std::string m_lastError;
+
+	std::thread m_thread;
+};
@@ -0,0 +1,46 @@
+#include "FramePacket.h"
+
+ImguiDrawSnapshot::~ImguiDrawSnapshot()
+{
+	Release();
+}
+
+void ImguiDrawSnapshot::Capture(const ImDrawData* pDrawData)
+{
+	Release();
+
+	if (pDrawData == nullptr || !pDrawData->Valid) {
+
+		return;
+	}
+
+	//clone vertex/index/command buffers of every list
+	m_lists.reserve(pDrawData->CmdListsCount);
+
+	for (int i = 0; i < pDrawData->CmdListsCount; i++) {
+
+		m_lists.push_back(pDrawData->CmdLists[i]->CloneOutput());
+	}
+
+	m_drawData = *pDrawData;
+	m_drawData.CmdLists = m_lists.data();
+	m_drawData.CmdListsCount = (int)m_lists.size();
+	m_isValid = true;
+}
+
+ImDrawData* ImguiDrawSnapshot::Get() noexcept
+{
+	return m_isValid ? &m_drawData : nullptr;
+}
+
+void ImguiDrawSnapshot::Release() noexcept
+{
+	for (auto pList : m_lists) {
+
+		IM_DELETE(pList);
+	}
+
+	m_lists.clear();
+	m_drawData.Clear();
+	m_isValid = false;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "PointLight.h"
+#include "ClusteredLights.h"
+#include "InstanceBatcher.h"
+#include "imgui/imgui.h"
+#include <DirectXMath.h>
+#include <vector>
+#include <memory>
+#include <string>
+#include <cstdint>
+
+class InstancedMesh;
+
+//deep copy of one frame of imgui draw lists
+//*the originals belong to the imgui context and are rebuilt by the next NewFrame
+class ImguiDrawSnapshot {
+
+public:
+
+	ImguiDrawSnapshot() = default;
+	ImguiDrawSnapshot(const ImguiDrawSnapshot&) = delete;
+	ImguiDrawSnapshot& operator=(const ImguiDrawSnapshot&) = delete;
+	~ImguiDrawSnapshot();
+
+	//nullptr clears the snapshot (imgui disabled)
+	void Capture(const ImDrawData* pDrawData);
+
+	//nullptr when nothing was captured
+	ImDrawData* Get() noexcept;
+
+private:
+
+	void Release() noexcept;
+
+private:
+
+	ImDrawData m_drawData;
+	std::vector<ImDrawList*> m_lists;
+	bool m_isValid = false;
+};
+
+/// <summary>
+/// Everything the render thread needs to draw one frame
+/// filled by the simulation thread, read only while the render thread owns it
+/// </summary>
+struct FramePacket {
+
+	//one instanced draw, the packet keeps the mesh alive while it's in flight
+	struct DrawCall {
+
+		std::shared_ptr<const InstancedMesh> pMesh;
+		unsigned int start;
+		unsigned int count;
+	};
+
+	unsigned long long frameIndex = 0u;
+
+	DirectX::XMFLOAT4X4 camera;
+	DirectX::XMFLOAT4X4 projection;
+	PointLight::PointLightCBuf light;
+	//the swarm's lights and the cluster lists the lit shaders loop over
+	ClusteredLights::Frame clusters;
+
+	//packed instance data and the draws that reference it
+	std::vector<InstanceData> instances;
+	std::vector<DrawCall> draws;
+
+	//nano model node transforms (indexed by node id)
+	std::vector<DirectX::XMFLOAT4X4> modelPose;
+
+	//file the frame is captured to, empty when it is not
+	std::string capturePath;
+
+	//internal resolution, picked by the render thread's scaler when dynamic
+	bool isDynamicResolution = true;
+	float resolutionScale = 1.0f;
+	uint64_t targetFrameNs = 16'666'667u;
+
+	ImguiDrawSnapshot imgui;
+};
@@ -0,0 +1,106 @@
+#include "FramePipeline.h"
+#include "Profiler.h"
+
+FramePipeline::FramePipeline(RenderFunc render)
+	:
+	m_render(std::move(render)),
+	m_thread(&FramePipeline::RenderLoop, this)
+{}
+
+FramePipeline::~FramePipeline()
+{
+	//wake the render thread with a dummy frame so it sees the quit flag
+	m_isQuitting = true;
+	m_submitted.fetch_add(1u, std::memory_order_release);
+	m_submitted.notify_all();
+
+	m_thread.join();
+}
+
+FramePacket& FramePipeline::BeginPacket()
+{
+	RethrowRenderError();
+
+	const auto frame = m_submitted.load(std::memory_order_relaxed);
+
+	//slot is free once the packet two frames back is drawn
+	if (frame >= 2u) {
+
+		WaitForCompleted(frame - 1u);
+	}
+
+	RethrowRenderError();
+
+	auto& packet = m_packets[frame % 2u];
+	packet.frameIndex = frame;
+
+	return packet;
+}
+
+void FramePipeline::Submit() noexcept
+{
+	//release publishes everything written to the packet
+	m_submitted.fetch_add(1u, std::memory_order_release);
+	m_submitted.notify_one();
+}
+
+void FramePipeline::WaitIdle()
+{
+	WaitForCompleted(m_submitted.load(std::memory_order_relaxed));
+	RethrowRenderError();
+}
+
+void FramePipeline::WaitForCompleted(unsigned long long frame) const noexcept
+{
+	auto completed = m_completed.load(std::memory_order_acquire);
+
+	while (completed < frame) {
+
+		m_completed.wait(completed, std::memory_order_acquire);
+		completed = m_completed.load(std::memory_order_acquire);
+	}
+}
+
+void FramePipeline::RethrowRenderError()
+{
+	if (m_hasRenderError.load(std::memory_order_acquire)) {
+
+		std::rethrow_exception(m_renderError);
+	}
+}
+
+void FramePipeline::RenderLoop() noexcept
+{
+	PROFILE_THREAD("Render");
+
+	unsigned long long frame = 0u;
+
+	while (true) {
+
+		//sleep until the next packet is handed over
+		m_submitted.wait(frame, std::memory_order_acquire);
+
+		if (m_isQuitting) {
+
+			return;
+		}
+
+		//after a failure packets are only retired, the error surfaces on the simulation thread
+		if (!m_hasRenderError.load(std::memory_order_relaxed)) {
+
+			try {
+
+				m_render(m_packets[frame % 2u]);
+			}
+			catch (...) {
+
+				m_renderError = std::current_exception();
+				m_hasRenderError.store(true, std::memory_order_release);
+			}
+		}
+
+		frame++;
+		m_completed.store(frame, std::memory_order_release);
+		m_completed.notify_all();
+	}
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "FramePacket.h"
+#include <array>
+#include <atomic>
+#include <thread>
+#include <functional>
+#include <exception>
+
+/// <summary>
+/// Two stage frame pipeline, the calling thread fills packet N+1 while a dedicated
+/// render thread draws packet N
+/// the two packets are handed over with a pair of atomic frame counters (no locks)
+/// so the simulation can run at most one frame ahead of the render thread
+/// </summary>
+class FramePipeline {
+
+public:
+
+	using RenderFunc = std::function<void(FramePacket& packet)>;
+
+public:
+
+	//render is called on the render thread for every submitted packet
+	FramePipeline(RenderFunc render);
+	FramePipeline(const FramePipeline&) = delete;
+	FramePipeline& operator=(const FramePipeline&) = delete;
+	~FramePipeline();
+
+	//waits until the render thread is done with the packet from two frames ago
+	//*rethrows anything the render thread threw
+	FramePacket& BeginPacket();
+
+	//hands the packet returned by BeginPacket to the render thread
+	void Submit() noexcept;
+
+	//waits until every submitted packet is drawn (before touching state the render thread uses)
+	void WaitIdle();
+
+private:
+
+	void RenderLoop() noexcept;
+	void WaitForCompleted(unsigned long long frame) const noexcept;
+	void RethrowRenderError();
+
+private:
+
+	RenderFunc m_render;
+	std::array<FramePacket, 2> m_packets;
+
+	//packets handed over / packets finished, packet n lives in slot n % 2
+	std::atomic<unsigned long long> m_submitted = 0u;
+	std::atomic<unsigned long long> m_completed = 0u;
+	std::atomic<bool> m_isQuitting = false;
+
+	//set by the render thread before it stops, read after m_completed stops moving
+	std::exception_ptr m_renderError;
+	std::atomic<bool> m_hasRenderError = false;
+
+	std::thread m_thread;
+};
@@ -0,0 +1,456 @@
+#include "FrameStats.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+namespace {
+
+	constexpr unsigned int linearBits = 7u;
+	constexpr unsigned int subBits = linearBits - 1u;
+	constexpr uint64_t linearCount = 1u << linearBits;
+	constexpr uint64_t subCount = 1u << subBits;
+
+	//128 linear buckets, then 64 for each power of two from 2^7 to 2^63
+	constexpr size_t bucketCount = linearCount + (64u - linearBits) * subCount;
+
+	//recent hitches kept for the panel and the export
+	constexpr size_t maxHitches = 256u;
+
+	unsigned int GetHighestBit(uint64_t value) noexcept
+	{
+		unsigned int bit = 0u;
+
+		while (value >>= 1u) {
+
+			bit++;
+		}
+
+		return bit;
+	}
+
+	void WriteSummary(std::ostream& os, const FrameStats::Summary& summary)
+	{
+		os << "{\"count\":" << summary.count
+			<< ",\"mean_ns\":" << summary.meanNs
+			<< ",\"stddev_ns\":" << summary.stdDevNs
+			<< ",\"min_ns\":" << summary.minNs
+			<< ",\"p50_ns\":" << summary.p50Ns
+			<< ",\"p95_ns\":" << summary.p95Ns
+			<< ",\"p99_ns\":" << summary.p99Ns
+			<< ",\"max_ns\":" << summary.maxNs
+			<< ",\"hitches\":" << summary.hitches << "}";
+	}
+}
+
+
+FrameStats::Histogram::Histogram()
+	:
+	m_counts(bucketCount, 0u)
+{}
+
+void FrameStats::Histogram::Add(uint64_t value) noexcept
+{
+	m_counts[GetBucket(value)]++;
+	m_count++;
+}
+
+void FrameStats::Histogram::Remove(uint64_t value) noexcept
+{
+	auto& count = m_counts[GetBucket(value)];
+
+	if (count > 0u) {
+
+		count--;
+		m_count--;
+	}
+}
+
+void FrameStats::Histogram::Clear() noexcept
+{
+	std::fill(m_counts.begin(), m_counts.end(), 0u);
+	m_count = 0u;
+}
+
+uint64_t FrameStats::Histogram::GetCount() const noexcept
+{
+	return m_count;
+}
+
+uint64_t FrameStats::Histogram::GetPercentile(double percentile) const noexcept
+{
+	if (m_count == 0u) {
+
+		return 0u;
+	}
+
+	//nearest rank, the smallest value with at least that share of the frames at or below it
+	const double share = std::clamp(percentile, 0.0, 100.0) / 100.0;
+	const uint64_t rank = std::max((uint64_t)std::ceil(share * (double)m_count), (uint64_t)1u);
+
+	uint64_t seen = 0u;
+
+	for (size_t i = 0; i < m_counts.size(); i++) {
+
+		seen += m_counts[i];
+
+		if (seen >= rank) {
+
+			return GetBucketTop(i);
+		}
+	}
+
+	return GetBucketTop(m_counts.size() - 1u);
+}
+
+size_t FrameStats::Histogram::GetBucket(uint64_t value) noexcept
+{
+	if (value < linearCount) {
+
+		return (size_t)value;
+	}
+
+	//the top 7 bits of the value, the leading one is implied
+	const unsigned int shift = GetHighestBit(value) - subBits;
+	const uint64_t sub = (value >> shift) - subCount;
+
+	return (size_t)(linearCount + (shift - 1u) * subCount + sub);
+}
+
+uint64_t FrameStats::Histogram::GetBucketTop(size_t bucket) noexcept
+{
+	if (bucket < linearCount) {
+
+		return bucket;
+	}
+
+	const unsigned int shift = (unsigned int)((bucket - linearCount) / subCount) + 1u;
+	const uint64_t sub = (bucket - linearCount) % subCount + subCount;
+
+	return ((sub + 1u) << shift) - 1u;
+}
+
+
+FrameStats::FrameStats(myTimer::Clock clock, size_t windowSize)
+	:
+	m_timer(std::move(clock)),
+	m_frames(std::max(windowSize, (size_t)1u))
+{
+	m_hitches.reserve(maxHitches);
+}
+
+uint64_t FrameStats::MarkFrame()
+{
+	const uint64_t durationNs = m_timer.MarkNs();
+
+	if (!m_isTiming) {
+
+		m_isTiming = true;
+		return 0u;
+	}
+
+	AddFrame(durationNs);
+	return durationNs;
+}
+
+void FrameStats::AddFrame(uint64_t durationNs)
+{
+	//measured against the frames before this one, a long frame shouldn't raise its own bar
+	//*nothing counts for the first few frames, a median of two says nothing
+	const uint64_t medianNs = m_window.GetPercentile(50.0);
+	const bool isHitch = m_window.GetCount() >= 16u &&
+		durationNs >= m_thresholds.minDurationNs &&
+		(double)durationNs > m_thresholds.medianFactor * (double)medianNs;
+
+	m_elapsedNs += durationNs;
+
+	Frame frame = { m_frameCount,m_elapsedNs,durationNs,isHitch };
+
+	auto& slot = m_frames[m_nextFrame];
+
+	if (m_nFrames == m_frames.size()) {
+
+		m_window.Remove(slot.durationNs);
+
+		if (slot.isHitch) {
+
+			m_windowHitches--;
+		}
+	}
+	else {
+
+		m_nFrames++;
+	}
+
+	slot = frame;
+	m_nextFrame = (m_nextFrame + 1u) % m_frames.size();
+	m_window.Add(durationNs);
+
+	m_session.Add(durationNs);
+	m_frameCount++;
+	m_sessionMinNs = std::min(m_sessionMinNs, durationNs);
+	m_sessionMaxNs = std::max(m_sessionMaxNs, durationNs);
+
+	const double delta = (double)durationNs - m_sessionMeanNs;
+	m_sessionMeanNs += delta / (double)m_frameCount;
+	m_sessionM2 += delta * ((double)durationNs - m_sessionMeanNs);
+
+	if (isHitch) {
+
+		m_windowHitches++;
+		m_sessionHitches++;
+
+		if (m_hitches.size() == maxHitches) {
+
+			m_hitches.erase(m_hitches.begin());
+		}
+
+		m_hitches.push_back({ frame.index,frame.endNs,durationNs,medianNs });
+	}
+}
+
+void FrameStats::Reset()
+{
+	m_isTiming = false;
+
+	m_nextFrame = 0u;
+	m_nFrames = 0u;
+	m_window.Clear();
+	m_windowHitches = 0u;
+
+	m_session.Clear();
+	m_frameCount = 0u;
+	m_elapsedNs = 0u;
+	m_sessionMinNs = UINT64_MAX;
+	m_sessionMaxNs = 0u;
+	m_sessionMeanNs = 0.0;
+	m_sessionM2 = 0.0;
+	m_sessionHitches = 0u;
+
+	m_hitches.clear();
+}
+
+void FrameStats::SetHitchThresholds(const HitchThresholds& thresholds) noexcept
+{
+	m_thresholds = thresholds;
+}
+
+const FrameStats::HitchThresholds& FrameStats::GetHitchThresholds() const noexcept
+{
+	return m_thresholds;
+}
+
+FrameStats::Summary FrameStats::GetWindowSummary() const
+{
+	Summary summary;
+
+	if (m_nFrames == 0u) {
+
+		return summary;
+	}
+
+	summary.count = m_nFrames;
+	summary.minNs = UINT64_MAX;
+
+	//the window is small enough to go over again, so its mean and min/max are exact
+	double sum = 0.0;
+
+	for (size_t i = 0; i < m_nFrames; i++) {
+
+		const uint64_t durationNs = m_frames[i].durationNs;
+
+		sum += (double)durationNs;
+		summary.minNs = std::min(summary.minNs, durationNs);
+		summary.maxNs = std::max(summary.maxNs, durationNs);
+	}
+
+	summary.meanNs = sum / (double)m_nFrames;
+
+	double squares = 0.0;
+
+	for (size_t i = 0; i < m_nFrames; i++) {
+
+		const double delta = (double)m_frames[i].durationNs - summary.meanNs;
+		squares += delta * delta;
+	}
+
+	summary.stdDevNs = std::sqrt(squares / (double)m_nFrames);
+	summary.p50Ns = std::min(m_window.GetPercentile(50.0), summary.maxNs);
+	summary.p95Ns = std::min(m_window.GetPercentile(95.0), summary.maxNs);
+	summary.p99Ns = std::min(m_window.GetPercentile(99.0), summary.maxNs);
+	summary.hitches = m_windowHitches;
+
+	return summary;
+}
+
+FrameStats::Summary FrameStats::GetSessionSummary() const
+{
+	Summary summary;
+
+	if (m_frameCount == 0u) {
+
+		return summary;
+	}
+
+	summary.count = m_frameCount;
+	summary.meanNs = m_sessionMeanNs;
+	summary.stdDevNs = std::sqrt(m_sessionM2 / (double)m_frameCount);
+	summary.minNs = m_sessionMinNs;
+	summary.maxNs = m_sessionMaxNs;
+	summary.p50Ns = std::min(m_session.GetPercentile(50.0), m_sessionMaxNs);
+	summary.p95Ns = std::min(m_session.GetPercentile(95.0), m_sessionMaxNs);
+	summary.p99Ns = std::min(m_session.GetPercentile(99.0), m_sessionMaxNs);
+	summary.hitches = m_sessionHitches;
+
+	return summary;
+}
+
+uint64_t FrameStats::GetWindowPercentile(double percentile) const noexcept
+{
+	return m_window.GetPercentile(percentile);
+}
+
+uint64_t FrameStats::GetSessionPercentile(double percentile) const noexcept
+{
+	return std::min(m_session.GetPercentile(percentile), m_sessionMaxNs);
+}
+
+std::vector<FrameStats::Frame> FrameStats::GetWindowFrames() const
+{
+	std::vector<Frame> frames;
+	frames.reserve(m_nFrames);
+
+	const size_t first = m_nFrames == m_frames.size() ? m_nextFrame : 0u;
+
+	for (size_t i = 0; i < m_nFrames; i++) {
+
+		frames.push_back(m_frames[(first + i) % m_frames.size()]);
+	}
+
+	return frames;
+}
+
+const std::vector<FrameStats::Hitch>& FrameStats::GetRecentHitches() const noexcept
+{
+	return m_hitches;
+}
+
+size_t FrameStats::GetWindowSize() const noexcept
+{
+	return m_frames.size();
+}
+
+uint64_t FrameStats::GetFrameCount() const noexcept
+{
+	return m_frameCount;
+}
+
+std::string FrameStats::MakeCsv() const
+{
+	std::ostringstream oss;
+	oss << "frame,end_ns,duration_ns,hitch\n";
+
+	for (const auto& frame : GetWindowFrames()) {
+
+		oss << frame.index << ',' << frame.endNs << ',' << frame.durationNs << ',' << (frame.isHitch ? 1 : 0) << '\n';
+	}
+
+	return oss.str();
+}
+
+std::string FrameStats::MakeJson() const
+{
+	std::ostringstream oss;
+	oss << std::fixed << std::setprecision(1);
+
+	oss << "{\n\"thresholds\":{\"median_factor\":" << m_thresholds.medianFactor
+		<< ",\"min_duration_ns\":" << m_thresholds.minDurationNs << "},\n";
+
+	oss << "\"window\":";
+	WriteSummary(oss, GetWindowSummary());
+	oss << ",\n\"session\":";
+	WriteSummary(oss, GetSessionSummary());
+
+	oss << ",\n\"hitches\":[";
+
+	for (size_t i = 0; i < m_hitches.size(); i++) {
+
+		const auto& hitch = m_hitches[i];
+
+		oss << (i == 0u ? "\n" : ",\n")
+			<< "{\"frame\":" << hitch.index
+			<< ",\"end_ns\":" << hitch.endNs
+			<< ",\"duration_ns\":" << hitch.durationNs
+			<< ",\"median_ns\":" << hitch.medianNs << "}";
+	}
+
+	oss << "],\n\"frames_ns\":[";
+
+	const auto frames = GetWindowFrames();
+
+	for (size_t i = 0; i < frames.size(); i++) {
+
+		oss << (i == 0u ? "" : ",") << frames[i].durationNs;
+	}
+
+	oss << "]\n}\n";
+
+	return oss.str();
+}
+
+void FrameStats::SaveCsv(const std::string& path) const
+{
+	Save(path, MakeCsv());
+}
+
+void FrameStats::SaveJson(const std::string& path) const
+{
+	Save(path, MakeJson());
+}
+
+void FrameStats::Save(const std::string& path, const std::string& text) const
+{
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+	if (!file) {
+
+		throw Exception(__LINE__, __FILE__, "Failed to create [" + path + "]");
+	}
+
+	file.write(text.data(), (std::streamsize)text.size());
+
+	if (!file) {
+
+		throw Exception(__LINE__, __FILE__, "Failed to write [" + path + "]");
+	}
+}
+
+
+//frame stats exception stuff
+FrameStats::Exception::Exception(int line, const char* file, std::string note) noexcept
+	:
+	myException(line, file),
+	note(std::move(note))
+{}
+
+const char* FrameStats::Exception::what() const noexcept
+{
+	std::ostringstream oss;
+
+	oss << myException::what() << std::endl
+		<< "[Note] " << GetNote();
+
+	whatBuffer = oss.str();
+	return whatBuffer.c_str();
+}
+
+const char* FrameStats::Exception::GetType() const noexcept
+{
+	return "SupaHotFire FrameStats Exception";
+}
+
+const std::string& FrameStats::Exception::GetNote() const noexcept
+{
+	return note;
+}
@@ -0,0 +1,175 @@
+#pragma once
+
+#include "myException.h"
+#include "myTimer.h"
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Frame time statistics, for seeing stutter rather than just the average fps
+/// frames are timed in whole nanoseconds and kept twice, a rolling window of the last frames and a histogram over the whole session
+/// both histograms are log linear (like HdrHistogram) so percentiles are off by under 1% however long a frame took
+/// a frame is a hitch when it is both some factor over the window's median and over an absolute floor
+/// the clock comes in through myTimer so a fake one can step it by hand, works without windows, the imgui view lives in FrameStatsWindow.cpp
+/// </summary>
+class FrameStats {
+
+public:
+
+	class Exception :public myException {
+
+	public:
+
+		Exception(int line, const char* file, std::string note) noexcept;
+		const char* what() const noexcept override;
+		const char* GetType() const noexcept override;
+
+		const std::string& GetNote() const noexcept;
+
+	private:
+
+		std::string note;
+	};
+
+	struct Frame {
+
+		//counted from 0 since the last reset
+		uint64_t index;
+		//when the frame ended, nanoseconds since the first frame started
+		uint64_t endNs;
+		uint64_t durationNs;
+		bool isHitch;
+	};
+
+	struct Hitch {
+
+		uint64_t index;
+		uint64_t endNs;
+		uint64_t durationNs;
+		//the window's median when it happened, what it was measured against
+		uint64_t medianNs;
+	};
+
+	struct HitchThresholds {
+
+		//times the median of the window
+		double medianFactor = 2.0;
+		//frames shorter than this never count, so a fast scene doesn't report every 2 ms blip
+		uint64_t minDurationNs = 8'000'000u;
+	};
+
+	//percentiles are the top of their histogram bucket (never below the true value), everything in nanoseconds
+	struct Summary {
+
+		uint64_t count = 0u;
+		double meanNs = 0.0;
+		double stdDevNs = 0.0;
+		uint64_t minNs = 0u;
+		uint64_t p50Ns = 0u;
+		uint64_t p95Ns = 0u;
+		uint64_t p99Ns = 0u;
+		uint64_t maxNs = 0u;
+		uint64_t hitches = 0u;
+	};
+
+public:
+
+	FrameStats(myTimer::Clock clock = myTimer::SteadyClock, size_t windowSize = 1024u);
+
+	//call once per frame at the same spot, returns the frame's length
+	//*the first call after construction or Reset only starts the clock and returns 0, so loading isn't counted as a frame
+	uint64_t MarkFrame();
+	//for durations measured elsewhere
+	void AddFrame(uint64_t durationNs);
+
+	//drops every frame and hitch, the thresholds are kept
+	void Reset();
+
+	void SetHitchThresholds(const HitchThresholds& thresholds) noexcept;
+	const HitchThresholds& GetHitchThresholds() const noexcept;
+
+	Summary GetWindowSummary() const;
+	Summary GetSessionSummary() const;
+
+	//percentile in [0,100] of the window or of the whole session, 0 with no frames
+	uint64_t GetWindowPercentile(double percentile) const noexcept;
+	uint64_t GetSessionPercentile(double percentile) const noexcept;
+
+	//oldest first
+	std::vector<Frame> GetWindowFrames() const;
+	//the latest ones only, Summary::hitches has the count
+	const std::vector<Hitch>& GetRecentHitches() const noexcept;
+
+	size_t GetWindowSize() const noexcept;
+	uint64_t GetFrameCount() const noexcept;
+
+	//csv has one row per window frame, json the summaries, thresholds, recent hitches and window frames
+	std::string MakeCsv() const;
+	std::string MakeJson() const;
+	void SaveCsv(const std::string& path) const;
+	void SaveJson(const std::string& path) const;
+
+	//graph of the window, the percentiles and the recent hitches, inside the current imgui window
+	void ShowStats();
+
+public:
+
+	//log linear buckets, the first 128 hold one nanosecond each
+	//*above that every power of two is cut into 64, so a bucket is at most 1/64 of its values wide
+	class Histogram {
+
+	public:
+
+		Histogram();
+
+		void Add(uint64_t value) noexcept;
+		void Remove(uint64_t value) noexcept;
+		void Clear() noexcept;
+
+		uint64_t GetCount() const noexcept;
+		uint64_t GetPercentile(double percentile) const noexcept;
+
+		static size_t GetBucket(uint64_t value) noexcept;
+		//the largest value that lands in the bucket
+		static uint64_t GetBucketTop(size_t bucket) noexcept;
+
+	private:
+
+		std::vector<uint64_t> m_counts;
+		uint64_t m_count = 0u;
+	};
+
+private:
+
+	void Save(const std::string& path, const std::string& text) const;
+
+private:
+
+	myTimer m_timer;
+	bool m_isTiming = false;
+
+	HitchThresholds m_thresholds;
+
+	//ring of the last frames, m_frames[m_nextFrame] is the oldest once full
+	std::vector<Frame> m_frames;
+	size_t m_nextFrame = 0u;
+	size_t m_nFrames = 0u;
+	Histogram m_window;
+	uint64_t m_windowHitches = 0u;
+
+	Histogram m_session;
+	uint64_t m_frameCount = 0u;
+	uint64_t m_elapsedNs = 0u;
+	uint64_t m_sessionMinNs = UINT64_MAX;
+	uint64_t m_sessionMaxNs = 0u;
+	//running mean and squared deviations (Welford), a plain sum of squares loses everything on long sessions
+	double m_sessionMeanNs = 0.0;
+	double m_sessionM2 = 0.0;
+	uint64_t m_sessionHitches = 0u;
+
+	std::vector<Hitch> m_hitches;
+	//the imgui graph, kept so it isn't reallocated every frame
+	std::vector<float> m_plot;
+};
@@ -0,0 +1,111 @@
+#include "FrameStats.h"
+#include "imgui/imgui.h"
+#include <algorithm>
+#include <cstdio>
+
+//imgui half of FrameStats, the window graph, percentiles and recent hitches
+
+namespace {
+
+	//newest first under the table
+	constexpr size_t nShownHitches = 8u;
+
+	float ToMs(uint64_t ns) noexcept
+	{
+		return (float)((double)ns * 1.0e-6);
+	}
+
+	void SummaryRow(const char* label, const FrameStats::Summary& summary)
+	{
+		ImGui::TextUnformatted(label);
+		ImGui::NextColumn();
+		ImGui::Text("%.2f", ToMs((uint64_t)summary.meanNs));
+		ImGui::NextColumn();
+		ImGui::Text("%.2f", ToMs(summary.p50Ns));
+		ImGui::NextColumn();
+		ImGui::Text("%.2f", ToMs(summary.p95Ns));
+		ImGui::NextColumn();
+		ImGui::Text("%.2f", ToMs(summary.p99Ns));
+		ImGui::NextColumn();
+		ImGui::Text("%.2f", ToMs(summary.maxNs));
+		ImGui::NextColumn();
+		ImGui::Text("%llu", (unsigned long long)summary.hitches);
+		ImGui::NextColumn();
+	}
+}
+
+void FrameStats::ShowStats()
+{
+	const auto window = GetWindowSummary();
+	const auto session = GetSessionSummary();
+
+	if (window.count == 0u) {
+
+		ImGui::Text("No frame recorded yet");
+		return;
+	}
+
+	m_plot.clear();
+
+	for (const auto& frame : GetWindowFrames()) {
+
+		m_plot.push_back(ToMs(frame.durationNs));
+	}
+
+	//scaled to the slow end of the window, so a single huge hitch doesn't flatten everything else
+	const float scaleMax = std::max(ToMs(window.p99Ns) * 1.5f, ToMs(m_thresholds.minDurationNs));
+
+	char overlay[64];
+	snprintf(overlay, sizeof(overlay), "%.2f ms (%.0f fps)", ToMs((uint64_t)window.meanNs), 1.0e9 / std::max(window.meanNs, 1.0));
+
+	ImGui::PlotLines("##frames", m_plot.data(), (int)m_plot.size(), 0, overlay, 0.0f, scaleMax, ImVec2(ImGui::GetContentRegionAvailWidth(), 80.0f));
+
+	ImGui::Columns(7, "frame stats");
+	for (const char* header : { "ms","mean","p50","p95","p99","max","hitches" }) {
+
+		ImGui::TextUnformatted(header);
+		ImGui::NextColumn();
+	}
+	ImGui::Separator();
+
+	SummaryRow("window", window);
+	SummaryRow("session", session);
+	ImGui::Columns(1);
+
+	ImGui::Text("std dev %.2f ms over the window, %llu frames this session", ToMs((uint64_t)window.stdDevNs), (unsigned long long)session.count);
+
+	//the thresholds only apply to frames from now on
+	float factor = (float)m_thresholds.medianFactor;
+	float minMs = ToMs(m_thresholds.minDurationNs);
+
+	if (ImGui::SliderFloat("Hitch x Median", &factor, 1.1f, 5.0f, "%.1f")) {
+
+		m_thresholds.medianFactor = factor;
+	}
+
+	if (ImGui::SliderFloat("Hitch Min (ms)", &minMs, 0.0f, 100.0f, "%.1f")) {
+
+		m_thresholds.minDurationNs = (uint64_t)((double)minMs * 1.0e6);
+	}
+
+	if (ImGui::Button("Reset")) {
+
+		Reset();
+		return;
+	}
+
+	if (!m_hitches.empty()) {
+
+		ImGui::Separator();
+
+		const size_t first = m_hitches.size() > nShownHitches ? m_hitches.size() - nShownHitches : 0u;
+
+		for (size_t i = m_hitches.size(); i-- > first;) {
+
+			const auto& hitch = m_hitches[i];
+
+			ImGui::Text("frame %llu: %.2f ms (median %.2f ms) at %.1f s",
+				(unsigned long long)hitch.index, ToMs(hitch.durationNs), ToMs(hitch.medianNs), (double)hitch.endNs * 1.0e-9);
+		}
+	}
+}
@@ -0,0 +1,85 @@
+#include "ImageDecoder.h"
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <cstring>
+
+void ImageDecoder::Decode(const uint8_t* pData, size_t size, const Allocator& allocate)
+{
+	if (IsPng(pData, size)) {
+
+		DecodePng(pData, size, allocate);
+	}
+	else if (IsJpeg(pData, size)) {
+
+		DecodeJpeg(pData, size, allocate);
+	}
+	else {
+
+		throw Exception(__LINE__, __FILE__, "Unknown image format (only PNG and JPEG are supported)");
+	}
+}
+
+void ImageDecoder::DecodeFile(const std::string& path, const Allocator& allocate)
+{
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+
+	if (!file) {
+
+		throw Exception(__LINE__, __FILE__, "Failed to open [" + path + "]");
+	}
+
+	std::vector<uint8_t> bytes((size_t)file.tellg());
+
+	file.seekg(0);
+	file.read(reinterpret_cast<char*>(bytes.data()), (std::streamsize)bytes.size());
+
+	if (!file) {
+
+		throw Exception(__LINE__, __FILE__, "Failed to read [" + path + "]");
+	}
+
+	Decode(bytes.data(), bytes.size(), allocate);
+}
+
+bool ImageDecoder::IsPng(const uint8_t* pData, size_t size) noexcept
+{
+	static constexpr uint8_t signature[8] = { 0x89,'P','N','G','\r','\n',0x1A,'\n' };
+
+	return size >= 8u && memcmp(pData, signature, 8u) == 0;
+}
+
+bool ImageDecoder::IsJpeg(const uint8_t* pData, size_t size) noexcept
+{
+	//start of image marker
+	return size >= 2u && pData[0] == 0xFFu && pData[1] == 0xD8u;
+}
+
+
+//image decoder exception stuff
+ImageDecoder::Exception::Exception(int line, const char* file, std::string note) noexcept
+	:
+	myException(line, file),
+	note(std::move(note))
+{}
+
+const char* ImageDecoder::Exception::what() const noexcept
+{
+	std::ostringstream oss;
+
+	oss << myException::what() << std::endl
+		<< "[Note] " << GetNote();
+
+	whatBuffer = oss.str();
+	return whatBuffer.c_str();
+}
+
+const char* ImageDecoder::Exception::GetType() const noexcept
+{
+	return "SupaHotFire Image Decoder Exception";
+}
+
+const std::string& ImageDecoder::Exception::GetNote() const noexcept
+{
+	return note;
+}
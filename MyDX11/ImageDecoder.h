@@ -0,0 +1,52 @@
+#pragma once
+
+#include "myException.h"
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <string>
+
+/// <summary>
+/// PNG and baseline JPEG decoding straight into B8G8R8A8 (the Surface::Color layout)
+/// the caller hands out the destination once the size is known, so no finished image is copied around
+/// holds no shared state, any number of files can be decoded at once on different threads
+/// works on raw bytes only so it builds and runs without windows
+/// </summary>
+class ImageDecoder {
+
+public:
+
+	class Exception :public myException {
+
+	public:
+
+		Exception(int line, const char* file, std::string note) noexcept;
+		const char* what() const noexcept override;
+		const char* GetType() const noexcept override;
+
+		const std::string& GetNote() const noexcept;
+
+	private:
+
+		std::string note;
+	};
+
+	//called once with the image size, returns width * height texels to decode into
+	using Allocator = std::function<uint32_t*(unsigned int width, unsigned int height)>;
+
+public:
+
+	//the format comes from the signature, not the file name
+	static void Decode(const uint8_t* pData, size_t size, const Allocator& allocate);
+
+	//reads the whole file then decodes it
+	static void DecodeFile(const std::string& path, const Allocator& allocate);
+
+	static bool IsPng(const uint8_t* pData, size_t size) noexcept;
+	static bool IsJpeg(const uint8_t* pData, size_t size) noexcept;
+
+private:
+
+	static void DecodePng(const uint8_t* pData, size_t size, const Allocator& allocate);
+	static void DecodeJpeg(const uint8_t* pData, size_t size, const Allocator& allocate);
+};
@@ -0,0 +1,917 @@
+#include "ImageDecoder.h"
+#include <emmintrin.h>
+#include <algorithm>
+#include <vector>
+#include <cstring>
+#include <cmath>
+#include <array>
+
+//JPEG half of ImageDecoder: baseline huffman scans, an SSE float IDCT and SSE color conversion to B8G8R8A8
+
+namespace {
+
+	//natural index of the k-th zigzag coefficient, padded so a corrupt run can't index past the block
+	constexpr uint8_t zigzag[64 + 16] = {
+		0,1,8,16,9,2,3,10,17,24,32,25,18,11,4,5,
+		12,19,26,33,40,48,41,34,27,20,13,6,7,14,21,28,
+		35,42,49,56,57,50,43,36,29,22,15,23,30,37,44,51,
+		58,59,52,45,38,31,39,46,53,60,61,54,47,55,62,63,
+		63,63,63,63,63,63,63,63,63,63,63,63,63,63,63,63
+	};
+
+	//entropy coded bytes, most significant bit first, 0xFF00 unstuffed, zeros once a marker shows up
+	class EntropyReader {
+
+	public:
+
+		EntropyReader(const uint8_t* pData, size_t size, size_t pos) noexcept
+			:
+			m_pData(pData),
+			m_size(size),
+			m_pos(pos)
+		{}
+
+		void Refill() noexcept
+		{
+			while (m_count <= 56u) {
+
+				unsigned int byte = 0u;
+
+				if (!m_isAtMarker && m_pos < m_size) {
+
+					byte = m_pData[m_pos];
+
+					if (byte != 0xFFu) {
+
+						m_pos++;
+					}
+					else if (m_pos + 1u < m_size && m_pData[m_pos + 1u] == 0x00u) {
+
+						m_pos += 2u;
+					}
+					else {
+
+						m_isAtMarker = true;
+						byte = 0u;
+					}
+				}
+
+				m_bits |= (uint64_t)byte << (56u - m_count);
+				m_count += 8u;
+			}
+		}
+
+		unsigned int Peek(unsigned int count) const noexcept
+		{
+			return (unsigned int)(m_bits >> (64u - count));
+		}
+
+		void Consume(unsigned int count) noexcept
+		{
+			m_bits <<= count;
+			m_count -= count;
+		}
+
+		unsigned int GetCount() const noexcept
+		{
+			return m_count;
+		}
+
+		//signed coefficient of the given size, refilled by the caller
+		int Receive(unsigned int size) noexcept
+		{
+			if (size == 0u) {
+
+				return 0;
+			}
+
+			int value = (int)Peek(size);
+			Consume(size);
+
+			if (value < (1 << (size - 1u))) {
+
+				value += (-1 << size) + 1;
+			}
+
+			return value;
+		}
+
+		//drops the padding bits and steps over the next RSTn marker
+		void Restart() noexcept
+		{
+			m_bits = 0u;
+			m_count = 0u;
+			m_isAtMarker = false;
+
+			while (m_pos + 1u < m_size) {
+
+				if (m_pData[m_pos] == 0xFFu && m_pData[m_pos + 1u] >= 0xD0u && m_pData[m_pos + 1u] <= 0xD7u) {
+
+					m_pos += 2u;
+					return;
+				}
+
+				m_pos++;
+			}
+		}
+
+		//first byte after the scan, where the next marker starts
+		size_t GetEnd() const noexcept
+		{
+			size_t pos = m_pos;
+
+			while (pos + 1u < m_size && !(m_pData[pos] == 0xFFu && m_pData[pos + 1u] != 0x00u && (m_pData[pos + 1u] < 0xD0u || m_pData[pos + 1u] > 0xD7u))) {
+
+				pos++;
+			}
+
+			return pos;
+		}
+
+	private:
+
+		const uint8_t* m_pData;
+		size_t m_size;
+		size_t m_pos;
+
+		uint64_t m_bits = 0u;
+		unsigned int m_count = 0u;
+		bool m_isAtMarker = false;
+	};
+
+	struct HuffmanTable {
+
+		static constexpr unsigned int fastBits = 9u;
+
+		//(length << 8) | symbol for codes up to fastBits long, zero otherwise
+		uint16_t fast[1u << fastBits];
+
+		//largest code of every length (-1 for none) and where its symbols start
+		int maxCode[17];
+		int valueOffset[17];
+		uint8_t values[256];
+
+		bool isDefined = false;
+
+		//counts of codes per length 1..16, then the symbols in code order
+		void Build(const uint8_t* pCounts, const uint8_t* pValues, unsigned int valueCount)
+		{
+			std::fill(std::begin(fast), std::end(fast), (uint16_t)0u);
+			std::copy(pValues, pValues + valueCount, values);
+
+			int code = 0;
+			int k = 0;
+
+			for (unsigned int len = 1u; len <= 16u; len++) {
+
+				valueOffset[len] = k - code;
+
+				for (unsigned int i = 0; i < pCounts[len - 1u]; i++, k++, code++) {
+
+					if (len <= fastBits) {
+
+						const unsigned int first = (unsigned int)code << (fastBits - len);
+
+						for (unsigned int j = 0; j < (1u << (fastBits - len)); j++) {
+
+							fast[first + j] = (uint16_t)((len << 8u) | values[k]);
+						}
+					}
+				}
+
+				maxCode[len] = pCounts[len - 1u] != 0u ? code - 1 : -1;
+
+				if (code > (1 << len)) {
+
+					throw ImageDecoder::Exception(__LINE__, __FILE__, "Corrupt JPEG (bad huffman table)");
+				}
+
+				code <<= 1;
+			}
+
+			isDefined = true;
+		}
+
+		unsigned int Decode(EntropyReader& reader) const
+		{
+			if (reader.GetCount() < 16u) {
+
+				reader.Refill();
+			}
+
+			if (const auto entry = fast[reader.Peek(fastBits)]) {
+
+				reader.Consume(entry >> 8u);
+				return entry & 0xFFu;
+			}
+
+			const int peeked = (int)reader.Peek(16u);
+
+			for (unsigned int len = fastBits + 1u; len <= 16u; len++) {
+
+				const int code = peeked >> (16u - len);
+
+				if (code <= maxCode[len]) {
+
+					reader.Consume(len);
+					return values[valueOffset[len] + code];
+				}
+			}
+
+			throw ImageDecoder::Exception(__LINE__, __FILE__, "Corrupt JPEG (invalid huffman code)");
+		}
+	};
+
+	struct Component {
+
+		unsigned int id;
+		unsigned int h;
+		unsigned int v;
+		unsigned int quantTable;
+
+		//set per scan
+		unsigned int dcTable = 0u;
+		unsigned int acTable = 0u;
+		int dcPredictor = 0;
+
+		//decoded samples, whole mcus so edge blocks need no clipping
+		unsigned int planeWidth = 0u;
+		unsigned int planeHeight = 0u;
+		std::vector<uint8_t> plane;
+	};
+
+	struct Frame {
+
+		unsigned int width = 0u;
+		unsigned int height = 0u;
+		unsigned int hMax = 1u;
+		unsigned int vMax = 1u;
+		unsigned int mcusAcross = 0u;
+		unsigned int mcusDown = 0u;
+		std::vector<Component> components;
+
+		//dequantization with the IDCT scale folded in, natural order
+		alignas(16) float quant[4][64];
+		HuffmanTable dcTables[4];
+		HuffmanTable acTables[4];
+
+		unsigned int restartInterval = 0u;
+
+		//Adobe APP14 transform 0 means the three channels are already RGB
+		bool isRgb = false;
+	};
+
+	/// IDCT (AA&N float, the same factorisation as libjpeg's jidctflt)
+
+	//8 coefficients along one axis, each lane is an independent column
+	inline void Idct1D(__m128 v[8]) noexcept
+	{
+		const __m128 sqrt2 = _mm_set1_ps(1.414213562f);
+
+		//even part
+		__m128 tmp10 = _mm_add_ps(v[0], v[4]);
+		__m128 tmp11 = _mm_sub_ps(v[0], v[4]);
+		__m128 tmp13 = _mm_add_ps(v[2], v[6]);
+		__m128 tmp12 = _mm_sub_ps(_mm_mul_ps(_mm_sub_ps(v[2], v[6]), sqrt2), tmp13);
+
+		const __m128 tmp0 = _mm_add_ps(tmp10, tmp13);
+		const __m128 tmp3 = _mm_sub_ps(tmp10, tmp13);
+		const __m128 tmp1 = _mm_add_ps(tmp11, tmp12);
+		const __m128 tmp2 = _mm_sub_ps(tmp11, tmp12);
+
+		//odd part
+		const __m128 z13 = _mm_add_ps(v[5], v[3]);
+		const __m128 z10 = _mm_sub_ps(v[5], v[3]);
+		const __m128 z11 = _mm_add_ps(v[1], v[7]);
+		const __m128 z12 = _mm_sub_ps(v[1], v[7]);
+
+		const __m128 tmp7 = _mm_add_ps(z11, z13);
+		tmp11 = _mm_mul_ps(_mm_sub_ps(z11, z13), sqrt2);
+
+		const __m128 z5 = _mm_mul_ps(_mm_add_ps(z10, z12), _mm_set1_ps(1.847759065f));
+		tmp10 = _mm_sub_ps(_mm_mul_ps(z12, _mm_set1_ps(1.082392200f)), z5);
+		tmp12 = _mm_add_ps(_mm_mul_ps(z10, _mm_set1_ps(-2.613125930f)), z5);
+
+		const __m128 tmp6 = _mm_sub_ps(tmp12, tmp7);
+		const __m128 tmp5 = _mm_sub_ps(tmp11, tmp6);
+		const __m128 tmp4 = _mm_add_ps(tmp10, tmp5);
+
+		v[0] = _mm_add_ps(tmp0, tmp7);
+		v[7] = _mm_sub_ps(tmp0, tmp7);
+		v[1] = _mm_add_ps(tmp1, tmp6);
+		v[6] = _mm_sub_ps(tmp1, tmp6);
+		v[2] = _mm_add_ps(tmp2, tmp5);
+		v[5] = _mm_sub_ps(tmp2, tmp5);
+		v[4] = _mm_add_ps(tmp3, tmp4);
+		v[3] = _mm_sub_ps(tmp3, tmp4);
+	}
+
+	//lo holds columns 0-3 of each row, hi columns 4-7
+	inline void Transpose8x8(__m128 lo[8], __m128 hi[8]) noexcept
+	{
+		_MM_TRANSPOSE4_PS(lo[0], lo[1], lo[2], lo[3]);
+		_MM_TRANSPOSE4_PS(hi[0], hi[1], hi[2], hi[3]);
+		_MM_TRANSPOSE4_PS(lo[4], lo[5], lo[6], lo[7]);
+		_MM_TRANSPOSE4_PS(hi[4], hi[5], hi[6], hi[7]);
+
+		//the off diagonal quadrants trade places
+		for (unsigned int i = 0; i < 4u; i++) {
+
+			std::swap(hi[i], lo[i + 4u]);
+		}
+	}
+
+	//dequantized coefficients to 8x8 samples
+	void IdctBlock(const float* pCoefficients, uint8_t* pOut, size_t stride) noexcept
+	{
+		__m128 lo[8], hi[8];
+
+		for (unsigned int r = 0; r < 8u; r++) {
+
+			lo[r] = _mm_load_ps(pCoefficients + r * 8u);
+			hi[r] = _mm_load_ps(pCoefficients + r * 8u + 4u);
+		}
+
+		//columns, then rows through a transpose, then back
+		Idct1D(lo);
+		Idct1D(hi);
+		Transpose8x8(lo, hi);
+		Idct1D(lo);
+		Idct1D(hi);
+		Transpose8x8(lo, hi);
+
+		const __m128 offset = _mm_set1_ps(128.0f);
+
+		for (unsigned int r = 0; r < 8u; r++) {
+
+			const __m128i a = _mm_cvtps_epi32(_mm_add_ps(lo[r], offset));
+			const __m128i b = _mm_cvtps_epi32(_mm_add_ps(hi[r], offset));
+			const __m128i words = _mm_packs_epi32(a, b);
+
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(pOut + r * stride), _mm_packus_epi16(words, words));
+		}
+	}
+
+	/// scan decoding
+
+	void DecodeBlock(EntropyReader& reader, const Frame& frame, Component& component, float* pBlock)
+	{
+		std::fill(pBlock, pBlock + 64, 0.0f);
+
+		const auto& dcTable = frame.dcTables[component.dcTable];
+		const auto& acTable = frame.acTables[component.acTable];
+		const float* pQuant = frame.quant[component.quantTable];
+
+		const auto dcSize = dcTable.Decode(reader);
+
+		if (dcSize > 11u) {
+
+			throw ImageDecoder::Exception(__LINE__, __FILE__, "Corrupt JPEG (bad DC coefficient)");
+		}
+
+		reader.Refill();
+		component.dcPredictor += reader.Receive(dcSize);
+		pBlock[0] = component.dcPredictor * pQuant[0];
+
+		for (unsigned int k = 1u; k < 64u;) {
+
+			const auto symbol = acTable.Decode(reader);
+			const auto size = symbol & 15u;
+			const auto run = symbol >> 4u;
+
+			if (size == 0u) {
+
+				//end of block, or a run of 16 zeros
+				if (run != 15u) {
+
+					break;
+				}
+
+				k += 16u;
+				continue;
+			}
+
+			k += run;
+
+			if (k > 63u) {
+
+				throw ImageDecoder::Exception(__LINE__, __FILE__, "Corrupt JPEG (coefficient past the end of the block)");
+			}
+
+			if (reader.GetCount() < size) {
+
+				reader.Refill();
+			}
+
+			const auto index = zigzag[k++];
+			pBlock[index] = reader.Receive(size) * pQuant[index];
+		}
+	}
+
+	void DecodeScan(EntropyReader& reader, Frame& frame, const std::vector<Component*>& scan)
+	{
+		alignas(16) float block[64];
+
+		for (auto pComponent : scan) {
+
+			pComponent->dcPredictor = 0;
+		}
+
+		unsigned int untilRestart = frame.restartInterval;
+
+		auto CheckRestart = [&]() {
+
+			if (frame.restartInterval == 0u) {
+
+				return;
+			}
+
+			if (untilRestart == 0u) {
+
+				reader.Restart();
+				untilRestart = frame.restartInterval;
+
+				for (auto pComponent : scan) {
+
+					pComponent->dcPredictor = 0;
+				}
+			}
+
+			untilRestart--;
+		};
+
+		if (scan.size() == 1u) {
+
+			//non interleaved, an mcu is one block and only blocks covering the image are coded
+			auto& c = *scan.front();
+
+			const unsigned int blocksAcross = ((frame.width * c.h + frame.hMax - 1u) / frame.hMax + 7u) / 8u;
+			const unsigned int blocksDown = ((frame.height * c.v + frame.vMax - 1u) / frame.vMax + 7u) / 8u;
+
+			for (unsigned int by = 0; by < blocksDown; by++) {
+
+				for (unsigned int bx = 0; bx < blocksAcross; bx++) {
+
+					CheckRestart();
+					DecodeBlock(reader, frame, c, block);
+					IdctBlock(block, c.plane.data() + (size_t)by * 8u * c.planeWidth + bx * 8u, c.planeWidth);
+				}
+			}
+
+			return;
+		}
+
+		for (unsigned int my = 0; my < frame.mcusDown; my++) {
+
+			for (unsigned int mx = 0; mx < frame.mcusAcross; mx++) {
+
+				CheckRestart();
+
+				for (auto pComponent : scan) {
+
+					auto& c = *pComponent;
+
+					for (unsigned int v = 0; v < c.v; v++) {
+
+						for (unsigned int h = 0; h < c.h; h++) {
+
+							const size_t y = ((size_t)my * c.v + v) * 8u;
+							const size_t x = ((size_t)mx * c.h + h) * 8u;
+
+							DecodeBlock(reader, frame, c, block);
+							IdctBlock(block, c.plane.data() + y * c.planeWidth + x, c.planeWidth);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	/// color conversion
+
+	//4 samples of a row into float lanes
+	inline __m128 LoadSamples(const uint8_t* p) noexcept
+	{
+		int32_t v;
+		memcpy(&v, p, 4u);
+
+		const __m128i zero = _mm_setzero_si128();
+		return _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(v), zero), zero));
+	}
+
+	//channel values in 0..255 to four B8G8R8A8 texels
+	inline __m128i PackTexels(__m128 r, __m128 g, __m128 b) noexcept
+	{
+		const __m128 lo = _mm_setzero_ps();
+		const __m128 hi = _mm_set1_ps(255.0f);
+
+		const __m128i ri = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(r, lo), hi));
+		const __m128i gi = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(g, lo), hi));
+		const __m128i bi = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(b, lo), hi));
+
+		return _mm_or_si128(_mm_or_si128(_mm_set1_epi32((int)0xFF000000u), _mm_slli_epi32(ri, 16)), _mm_or_si128(_mm_slli_epi32(gi, 8), bi));
+	}
+
+	//rows of each component at full width (padded to 4), chroma is replicated from the nearest sample
+	const uint8_t* UpsampleRow(const Frame& frame, const Component& c, unsigned int y, std::vector<uint8_t>& row) noexcept
+	{
+		const uint8_t* pSrc = c.plane.data() + (size_t)(y * c.v / frame.vMax) * c.planeWidth;
+
+		if (c.h == frame.hMax) {
+
+			return pSrc;
+		}
+
+		for (unsigned int x = 0; x < row.size(); x++) {
+
+			row[x] = pSrc[std::min(x * c.h / frame.hMax, c.planeWidth - 1u)];
+		}
+
+		return row.data();
+	}
+
+	void ConvertToTexels(const Frame& frame, uint32_t* pDst)
+	{
+		const unsigned int width = frame.width;
+		const unsigned int paddedWidth = (width + 3u) & ~3u;
+
+		std::vector<uint8_t> rows[3];
+
+		for (auto& r : rows) {
+
+			r.resize(paddedWidth);
+		}
+
+		for (unsigned int y = 0; y < frame.height; y++) {
+
+			uint32_t* pOut = pDst + (size_t)y * width;
+
+			if (frame.components.size() == 1u) {
+
+				const uint8_t* pGray = UpsampleRow(frame, frame.components[0], y, rows[0]);
+
+				for (unsigned int x = 0; x < width; x++) {
+
+					pOut[x] = 0xFF000000u | (pGray[x] * 0x010101u);
+				}
+
+				continue;
+			}
+
+			const uint8_t* p0 = UpsampleRow(frame, frame.components[0], y, rows[0]);
+			const uint8_t* p1 = UpsampleRow(frame, frame.components[1], y, rows[1]);
+			const uint8_t* p2 = UpsampleRow(frame, frame.components[2], y, rows[2]);
+
+			//both the planes and the upsampled rows are at least paddedWidth wide, only the store needs a tail
+			alignas(16) uint32_t texels[4];
+
+			for (unsigned int x = 0; x < width; x += 4u) {
+
+				const __m128 a = LoadSamples(p0 + x);
+				const __m128 b = LoadSamples(p1 + x);
+				const __m128 c = LoadSamples(p2 + x);
+
+				__m128i packed;
+
+				if (frame.isRgb) {
+
+					packed = PackTexels(a, b, c);
+				}
+				else {
+
+					//JFIF YCbCr, full range
+					const __m128 cb = _mm_sub_ps(b, _mm_set1_ps(128.0f));
+					const __m128 cr = _mm_sub_ps(c, _mm_set1_ps(128.0f));
+
+					const __m128 r = _mm_add_ps(a, _mm_mul_ps(cr, _mm_set1_ps(1.402f)));
+					const __m128 g = _mm_sub_ps(a, _mm_add_ps(_mm_mul_ps(cb, _mm_set1_ps(0.344136f)), _mm_mul_ps(cr, _mm_set1_ps(0.714136f))));
+					const __m128 bl = _mm_add_ps(a, _mm_mul_ps(cb, _mm_set1_ps(1.772f)));
+
+					packed = PackTexels(r, g, bl);
+				}
+
+				if (x + 4u <= width) {
+
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(pOut + x), packed);
+				}
+				else {
+
+					_mm_store_si128(reinterpret_cast<__m128i*>(texels), packed);
+					std::copy(texels, texels + (width - x), pOut + x);
+				}
+			}
+		}
+	}
+
+	inline unsigned int ReadWord(const uint8_t* p) noexcept
+	{
+		return (p[0] << 8u) | p[1];
+	}
+
+	/// header segments
+
+	void ReadQuantTables(Frame& frame, const uint8_t* p, size_t length)
+	{
+		//AA&N scale of each frequency, with the final 1/8 of the 2D transform
+		static const auto scales = []() {
+
+			std::array<float, 8> s;
+			s[0] = 1.0f;
+
+			for (unsigned int k = 1u; k < 8u; k++) {
+
+				s[k] = (float)(std::cos(k * 3.14159265358979323846 / 16.0) * std::sqrt(2.0));
+			}
+
+			return s;
+		}();
+
+		size_t pos = 0u;
+
+		while (pos < length) {
+
+			const unsigned int precision = p[pos] >> 4u;
+			const unsigned int id = p[pos] & 15u;
+			pos++;
+
+			const size_t tableBytes = precision != 0u ? 128u : 64u;
+
+			if (id > 3u || pos + tableBytes > length) {
+
+				throw ImageDecoder::Exception(__LINE__, __FILE__, "Corrupt JPEG (bad DQT segment)");
+			}
+
+			for (unsigned int k = 0; k < 64u; k++) {
+
+				const unsigned int value = precision != 0u ? ReadWord(p + pos + k * 2u) : p[pos + k];
+				const unsigned int i = zigzag[k];
+
+				frame.quant[id][i] = value * scales[i / 8u] * scales[i % 8u] / 8.0f;
+			}
+
+			pos += tableBytes;
+		}
+	}
+
+	void ReadHuffmanTables(Frame& frame, const uint8_t* p, size_t length)
+	{
+		size_t pos = 0u;
+
+		while (pos < length) {
+
+			if (pos + 17u > length) {
+
+				throw ImageDecoder::Exception(__LINE__, __FILE__, "Corrupt JPEG (bad DHT segment)");
+			}
+
+			const unsigned int tableClass = p[pos] >> 4u;
+			const unsigned int id = p[pos] & 15u;
+			const uint8_t* pCounts = p + pos + 1u;
+
+			unsigned int total = 0u;
+
+			for (unsigned int i = 0; i < 16u; i++) {
+
+				total += pCounts[i];
+			}
+
+			pos += 17u;
+
+			if (tableClass > 1u || id > 3u || total > 256u || pos + total > length) {
+
+				throw ImageDecoder::Exception(__LINE__, __FILE__, "Corrupt JPEG (bad DHT segment)");
+			}
+
+			auto& table = tableClass == 0u ? frame.dcTables[id] : frame.acTables[id];
+			table.Build(pCounts, p + pos, total);
+
+			pos += total;
+		}
+	}
+
+	void ReadFrameHeader(Frame& frame, const uint8_t* p, size_t length)
+	{
+		if (length < 6u || p[0] != 8u) {
+
+			throw ImageDecoder::Exception(__LINE__, __FILE__, "Only 8 bit JPEG is supported");
+		}
+
+		frame.height = ReadWord(p + 1u);
+		frame.width = ReadWord(p + 3u);
+
+		const unsigned int count = p[5];
+
+		if (frame.width == 0u || frame.height == 0u) {
+
+			throw ImageDecoder::Exception(__LINE__, __FILE__, "Corrupt JPEG (empty image)");
+		}
+
+		if ((count != 1u && count != 3u) || length < 6u + count * 3u) {
+
+			throw ImageDecoder::Exception(__LINE__, __FILE__, "Only gray and 3 channel JPEG is supported");
+		}
+
+		frame.components.resize(count);
+
+		for (unsigned int i = 0; i < count; i++) {
+
+			auto& c = frame.components[i];
+			const uint8_t* pc = p + 6u + i * 3u;
+
+			c.id = pc[0];
+			c.h = pc[1] >> 4u;
+			c.v = pc[1] & 15u;
+			c.quantTable = pc[2];
+
+			if (c.h == 0u || c.h > 4u || c.v == 0u || c.v > 4u || c.quantTable > 3u) {
+
+				throw ImageDecoder::Exception(__LINE__, __FILE__, "Corrupt JPEG (bad component)");
+			}
+
+			frame.hMax = std::max(frame.hMax, c.h);
+			frame.vMax = std::max(frame.vMax, c.v);
+		}
+
+		frame.mcusAcross = (frame.width + frame.hMax * 8u - 1u) / (frame.hMax * 8u);
+		frame.mcusDown = (frame.height + frame.vMax * 8u - 1u) / (frame.vMax * 8u);
+
+		for (auto& c : frame.components) {
+
+			c.planeWidth = frame.mcusAcross * c.h * 8u;
+			c.planeHeight = frame.mcusDown * c.v * 8u;
+			c.plane.assign((size_t)c.planeWidth * c.planeHeight, 0u);
+		}
+	}
+
+	std::vector<Component*> ReadScanHeader(Frame& frame, const uint8_t* p, size_t length)
+	{
+		const unsigned int count = length > 0u ? p[0] : 0u;
+
+		if (frame.components.empty() || count == 0u || count > frame.components.size() || length < 4u + count * 2u) {
+
+			throw ImageDecoder::Exception(__LINE__, __FILE__, "Corrupt JPEG (bad SOS segment)");
+		}
+
+		std::vector<Component*> scan;
+
+		for (unsigned int i = 0; i < count; i++) {
+
+			const uint8_t* ps = p + 1u + i * 2u;
+
+			const auto it = std::find_if(frame.components.begin(), frame.components.end(), [id = ps[0]](const Component& c) { return c.id == id; });
+
+			if (it == frame.components.end()) {
+
+				throw ImageDecoder::Exception(__LINE__, __FILE__, "Corrupt JPEG (scan names an unknown component)");
+			}
+
+			it->dcTable = ps[1] >> 4u;
+			it->acTable = ps[1] & 15u;
+
+			if (it->dcTable > 3u || it->acTable > 3u || !frame.dcTables[it->dcTable].isDefined || !frame.acTables[it->acTable].isDefined) {
+
+				throw ImageDecoder::Exception(__LINE__, __FILE__, "Corrupt JPEG (scan uses a missing huffman table)");
+			}
+
+			scan.push_back(&*it);
+		}
+
+		return scan;
+	}
+}
+
+void ImageDecoder::DecodeJpeg(const uint8_t* pData, size_t size, const Allocator& allocate)
+{
+	Frame frame;
+	bool hasScan = false;
+
+	size_t pos = 2u;
+
+	for (;;) {
+
+		//markers may be preceded by any number of 0xFF fill bytes
+		while (pos < size && pData[pos] != 0xFFu) {
+
+			pos++;
+		}
+
+		while (pos < size && pData[pos] == 0xFFu) {
+
+			pos++;
+		}
+
+		if (pos >= size) {
+
+			break;
+		}
+
+		const unsigned int marker = pData[pos++];
+
+		//markers without a length
+		if (marker == 0xD9u) {
+
+			break;
+		}
+
+		if (marker == 0x01u || (marker >= 0xD0u && marker <= 0xD8u)) {
+
+			continue;
+		}
+
+		if (pos + 2u > size) {
+
+			throw Exception(__LINE__, __FILE__, "Corrupt JPEG (truncated segment)");
+		}
+
+		const size_t length = ReadWord(pData + pos);
+
+		if (length < 2u || pos + length > size) {
+
+			throw Exception(__LINE__, __FILE__, "Corrupt JPEG (truncated segment)");
+		}
+
+		const uint8_t* pSegment = pData + pos + 2u;
+		const size_t segmentLength = length - 2u;
+
+		switch (marker)
+		{
+		//baseline and extended huffman
+		case 0xC0u:
+		case 0xC1u:
+
+			ReadFrameHeader(frame, pSegment, segmentLength);
+			break;
+
+		case 0xC2u:
+		case 0xC6u:
+		case 0xCAu:
+		case 0xCEu:
+
+			throw Exception(__LINE__, __FILE__, "Progressive JPEG is not supported");
+
+		case 0xC3u:
+		case 0xC5u:
+		case 0xC7u:
+		case 0xC9u:
+		case 0xCBu:
+		case 0xCDu:
+		case 0xCFu:
+
+			throw Exception(__LINE__, __FILE__, "Lossless and arithmetic coded JPEG is not supported");
+
+		case 0xC4u:
+
+			ReadHuffmanTables(frame, pSegment, segmentLength);
+			break;
+
+		case 0xDBu:
+
+			ReadQuantTables(frame, pSegment, segmentLength);
+			break;
+
+		case 0xDDu:
+
+			if (segmentLength < 2u) {
+
+				throw Exception(__LINE__, __FILE__, "Corrupt JPEG (bad DRI segment)");
+			}
+
+			frame.restartInterval = ReadWord(pSegment);
+			break;
+
+		//Adobe APP14, transform 0 on a 3 channel image means RGB
+		case 0xEEu:
+
+			if (segmentLength >= 12u && memcmp(pSegment, "Adobe", 5u) == 0) {
+
+				frame.isRgb = pSegment[11] == 0u;
+			}
+			break;
+
+		case 0xDAu:
+		{
+			const auto scan = ReadScanHeader(frame, pSegment, segmentLength);
+
+			EntropyReader reader(pData, size, pos + length);
+			DecodeScan(reader, frame, scan);
+
+			hasScan = true;
+			pos = reader.GetEnd();
+			continue;
+		}
+
+		default:
+
+			break;
+		}
+
+		pos += length;
+	}
+
+	if (!hasScan) {
+
+		throw Exception(__LINE__, __FILE__, "Corrupt JPEG (no image data)");
+	}
+
+	ConvertToTexels(frame, allocate(frame.width, frame.height));
+}
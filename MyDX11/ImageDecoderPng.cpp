@@ -0,0 +1,991 @@
+#include "ImageDecoder.h"
+#include <emmintrin.h>
+#include <algorithm>
+#include <vector>
+#include <cstring>
+
+//PNG half of ImageDecoder: zlib inflate, scanline filters and the conversion to B8G8R8A8
+
+namespace {
+
+	//D3D11 cannot make a texture bigger than this anyway, also stops a corrupt IHDR asking for gigabytes
+	constexpr uint32_t maxDimension = 16384u;
+
+	/// inflate
+
+	//deflate packs bits lowest first, the buffer is refilled a byte at a time and padded with zeros past the end
+	class BitStream {
+
+	public:
+
+		BitStream(const uint8_t* pData, size_t size) noexcept
+			:
+			m_pData(pData),
+			m_size(size)
+		{}
+
+		void Refill() noexcept
+		{
+			while (m_count <= 56u) {
+
+				const uint64_t byte = m_pos < m_size ? m_pData[m_pos] : 0u;
+
+				m_bits |= byte << m_count;
+				m_count += 8u;
+				m_pos++;
+			}
+		}
+
+		//callers refill first, at most 57 bits are guaranteed
+		unsigned int Peek(unsigned int count) const noexcept
+		{
+			return (unsigned int)(m_bits & ((1ull << count) - 1u));
+		}
+
+		void Consume(unsigned int count) noexcept
+		{
+			m_bits >>= count;
+			m_count -= count;
+		}
+
+		unsigned int Get(unsigned int count) noexcept
+		{
+			if (m_count < count) {
+
+				Refill();
+			}
+
+			const auto value = Peek(count);
+			Consume(count);
+
+			return value;
+		}
+
+		//drops the rest of the current byte and hands back the read position for raw copies
+		size_t AlignToByte() noexcept
+		{
+			Consume(m_count & 7u);
+
+			//bytes sitting in the buffer go back to the stream
+			const size_t position = m_pos - m_count / 8u;
+
+			m_bits = 0u;
+			m_count = 0u;
+			m_pos = position;
+
+			return position;
+		}
+
+		void Skip(size_t bytes) noexcept
+		{
+			m_pos += bytes;
+		}
+
+		//true once more bytes were used than the stream holds
+		bool IsOverrun() const noexcept
+		{
+			return m_pos - m_count / 8u > m_size;
+		}
+
+		const uint8_t* GetData() const noexcept
+		{
+			return m_pData;
+		}
+
+		size_t GetSize() const noexcept
+		{
+			return m_size;
+		}
+
+	private:
+
+		const uint8_t* m_pData;
+		size_t m_size;
+		size_t m_pos = 0u;
+
+		uint64_t m_bits = 0u;
+		unsigned int m_count = 0u;
+	};
+
+	//canonical huffman code, short codes resolve with one table lookup
+	class Huffman {
+
+	public:
+
+		static constexpr unsigned int fastBits = 10u;
+		static constexpr unsigned int maxBits = 15u;
+
+	public:
+
+		void Build(const uint8_t* pLengths, unsigned int count)
+		{
+			unsigned int lengthCount[maxBits + 1u] = {};
+
+			for (unsigned int i = 0; i < count; i++) {
+
+				lengthCount[pLengths[i]]++;
+			}
+
+			lengthCount[0] = 0u;
+
+			//first code and first symbol slot of every length
+			unsigned int code = 0u, slot = 0u;
+
+			for (unsigned int len = 1u; len <= maxBits; len++) {
+
+				code = (code + lengthCount[len - 1u]) << 1u;
+
+				if (lengthCount[len] > (1u << len)) {
+
+					throw ImageDecoder::Exception(__LINE__, __FILE__, "Corrupt PNG (bad huffman code lengths)");
+				}
+
+				m_firstCode[len] = code;
+				m_firstSlot[len] = slot;
+				m_count[len] = lengthCount[len];
+				slot += lengthCount[len];
+			}
+
+			std::fill(std::begin(m_fast), std::end(m_fast), (uint16_t)0u);
+
+			unsigned int nextCode[maxBits + 1u];
+			unsigned int nextSlot[maxBits + 1u];
+			std::copy(std::begin(m_firstCode), std::end(m_firstCode), nextCode);
+			std::copy(std::begin(m_firstSlot), std::end(m_firstSlot), nextSlot);
+
+			for (unsigned int symbol = 0; symbol < count; symbol++) {
+
+				const unsigned int len = pLengths[symbol];
+
+				if (len == 0u) {
+
+					continue;
+				}
+
+				const unsigned int symbolCode = nextCode[len]++;
+				m_symbols[nextSlot[len]++] = (uint16_t)symbol;
+
+				if (len <= fastBits) {
+
+					//the stream holds codes most significant bit first, lookups use them reversed
+					const unsigned int reversed = Reverse(symbolCode, len);
+
+					for (unsigned int i = reversed; i < (1u << fastBits); i += 1u << len) {
+
+						m_fast[i] = (uint16_t)((len << 9u) | symbol);
+					}
+				}
+			}
+		}
+
+		unsigned int Decode(BitStream& bits) const
+		{
+			if (const auto entry = m_fast[bits.Peek(fastBits)]) {
+
+				bits.Consume(entry >> 9u);
+				return entry & 0x1FFu;
+			}
+
+			//longer codes, walked one bit at a time
+			const unsigned int peeked = bits.Peek(maxBits);
+			unsigned int code = 0u;
+
+			for (unsigned int len = 1u; len <= maxBits; len++) {
+
+				code = (code << 1u) | ((peeked >> (len - 1u)) & 1u);
+
+				if (code - m_firstCode[len] < m_count[len]) {
+
+					bits.Consume(len);
+					return m_symbols[m_firstSlot[len] + code - m_firstCode[len]];
+				}
+			}
+
+			throw ImageDecoder::Exception(__LINE__, __FILE__, "Corrupt PNG (invalid huffman code)");
+		}
+
+	private:
+
+		static unsigned int Reverse(unsigned int code, unsigned int len) noexcept
+		{
+			unsigned int reversed = 0u;
+
+			for (unsigned int i = 0; i < len; i++) {
+
+				reversed = (reversed << 1u) | ((code >> i) & 1u);
+			}
+
+			return reversed;
+		}
+
+	private:
+
+		//(length << 9) | symbol, zero when the code is longer than fastBits
+		uint16_t m_fast[1u << fastBits];
+
+		unsigned int m_firstCode[maxBits + 1u];
+		unsigned int m_firstSlot[maxBits + 1u];
+		unsigned int m_count[maxBits + 1u];
+		uint16_t m_symbols[288];
+	};
+
+	constexpr uint16_t lengthBase[29] = { 3,4,5,6,7,8,9,10,11,13,15,17,19,23,27,31,35,43,51,59,67,83,99,115,131,163,195,227,258 };
+	constexpr uint8_t lengthExtra[29] = { 0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2,3,3,3,3,4,4,4,4,5,5,5,5,0 };
+	constexpr uint16_t distBase[30] = { 1,2,3,4,5,7,9,13,17,25,33,49,65,97,129,193,257,385,513,769,1025,1537,2049,3073,4097,6145,8193,12289,16385,24577 };
+	constexpr uint8_t distExtra[30] = { 0,0,0,0,1,1,2,2,3,3,4,4,5,5,6,6,7,7,8,8,9,9,10,10,11,11,12,12,13,13 };
+
+	//order the code length code lengths are stored in
+	constexpr uint8_t codeLengthOrder[19] = { 16,17,18,0,8,7,9,6,10,5,11,4,12,3,13,2,14,1,15 };
+
+	//back reference, the source is always behind the destination
+	inline void CopyMatch(uint8_t* pDst, size_t out, size_t dstSize, size_t length, size_t distance) noexcept
+	{
+		uint8_t* pOut = pDst + out;
+		const uint8_t* pIn = pOut - distance;
+
+		if (distance >= 16u && out + ((length + 15u) & ~size_t(15u)) <= dstSize) {
+
+			//whole 16 byte chunks, never reading anything not yet written,
+			//the overshoot lands on bytes the next symbols overwrite anyway
+			for (size_t i = 0; i < length; i += 16u) {
+
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(pOut + i), _mm_loadu_si128(reinterpret_cast<const __m128i*>(pIn + i)));
+			}
+		}
+		else if (distance == 1u) {
+
+			memset(pOut, *pIn, length);
+		}
+		else {
+
+			for (size_t i = 0; i < length; i++) {
+
+				pOut[i] = pIn[i];
+			}
+		}
+	}
+
+	void InflateBlock(BitStream& bits, const Huffman& literals, const Huffman& distances, uint8_t* pDst, size_t& out, size_t dstSize)
+	{
+		for (;;) {
+
+			//longest symbol pair is 15 + 5 + 15 + 13 bits, one refill covers it
+			bits.Refill();
+
+			const auto symbol = literals.Decode(bits);
+
+			if (symbol < 256u) {
+
+				if (out >= dstSize) {
+
+					throw ImageDecoder::Exception(__LINE__, __FILE__, "Corrupt PNG (too much image data)");
+				}
+
+				pDst[out++] = (uint8_t)symbol;
+				continue;
+			}
+
+			if (symbol == 256u) {
+
+				return;
+			}
+
+			if (symbol > 285u) {
+
+				throw ImageDecoder::Exception(__LINE__, __FILE__, "Corrupt PNG (invalid length symbol)");
+			}
+
+			const auto lengthSymbol = symbol - 257u;
+			const size_t length = lengthBase[lengthSymbol] + bits.Get(lengthExtra[lengthSymbol]);
+
+			const auto distSymbol = distances.Decode(bits);
+
+			if (distSymbol >= 30u) {
+
+				throw ImageDecoder::Exception(__LINE__, __FILE__, "Corrupt PNG (invalid distance symbol)");
+			}
+
+			const size_t distance = distBase[distSymbol] + bits.Get(distExtra[distSymbol]);
+
+			if (distance > out || out + length > dstSize) {
+
+				throw ImageDecoder::Exception(__LINE__, __FILE__, "Corrupt PNG (back reference out of range)");
+			}
+
+			CopyMatch(pDst, out, dstSize, length, distance);
+			out += length;
+		}
+	}
+
+	void ReadDynamicTables(BitStream& bits, Huffman& literals, Huffman& distances)
+	{
+		bits.Refill();
+
+		const unsigned int literalCount = bits.Get(5u) + 257u;
+		const unsigned int distCount = bits.Get(5u) + 1u;
+		const unsigned int codeLengthCount = bits.Get(4u) + 4u;
+
+		uint8_t codeLengthLengths[19] = {};
+
+		for (unsigned int i = 0; i < codeLengthCount; i++) {
+
+			codeLengthLengths[codeLengthOrder[i]] = (uint8_t)bits.Get(3u);
+		}
+
+		Huffman codeLengths;
+		codeLengths.Build(codeLengthLengths, 19u);
+
+		//literal and distance lengths are one run, repeats may cross between them
+		uint8_t lengths[286 + 30] = {};
+		unsigned int n = 0u;
+
+		while (n < literalCount + distCount) {
+
+			bits.Refill();
+
+			const auto symbol = codeLengths.Decode(bits);
+			unsigned int repeat = 1u;
+			uint8_t value = 0u;
+
+			if (symbol < 16u) {
+
+				value = (uint8_t)symbol;
+			}
+			else if (symbol == 16u) {
+
+				if (n == 0u) {
+
+					throw ImageDecoder::Exception(__LINE__, __FILE__, "Corrupt PNG (repeat without a previous length)");
+				}
+
+				value = lengths[n - 1u];
+				repeat = 3u + bits.Get(2u);
+			}
+			else if (symbol == 17u) {
+
+				repeat = 3u + bits.Get(3u);
+			}
+			else {
+
+				repeat = 11u + bits.Get(7u);
+			}
+
+			if (n + repeat > literalCount + distCount) {
+
+				throw ImageDecoder::Exception(__LINE__, __FILE__, "Corrupt PNG (code lengths overflow)");
+			}
+
+			std::fill(lengths + n, lengths + n + repeat, value);
+			n += repeat;
+		}
+
+		literals.Build(lengths, literalCount);
+		distances.Build(lengths + literalCount, distCount);
+	}
+
+	//zlib stream into exactly dstSize bytes
+	void Inflate(const uint8_t* pSrc, size_t size, uint8_t* pDst, size_t dstSize)
+	{
+		if (size < 2u || (pSrc[0] & 0x0Fu) != 8u || ((pSrc[0] << 8u) | pSrc[1]) % 31u != 0u || (pSrc[1] & 0x20u) != 0u) {
+
+			throw ImageDecoder::Exception(__LINE__, __FILE__, "Corrupt PNG (bad zlib header)");
+		}
+
+		BitStream bits(pSrc + 2u, size - 2u);
+
+		Huffman literals, distances;
+		size_t out = 0u;
+		bool isLast = false;
+
+		while (!isLast) {
+
+			isLast = bits.Get(1u) != 0u;
+
+			switch (bits.Get(2u))
+			{
+			case 0u:
+			{
+				//stored, LEN and NLEN then raw bytes
+				const auto position = bits.AlignToByte();
+
+				if (position + 4u > bits.GetSize()) {
+
+					throw ImageDecoder::Exception(__LINE__, __FILE__, "Corrupt PNG (truncated stored block)");
+				}
+
+				const auto pHeader = bits.GetData() + position;
+				const size_t length = pHeader[0] | (pHeader[1] << 8u);
+
+				if ((length ^ 0xFFFFu) != (size_t)(pHeader[2] | (pHeader[3] << 8u)) ||
+					position + 4u + length > bits.GetSize() || out + length > dstSize) {
+
+					throw ImageDecoder::Exception(__LINE__, __FILE__, "Corrupt PNG (bad stored block)");
+				}
+
+				memcpy(pDst + out, pHeader + 4u, length);
+				out += length;
+				bits.Skip(4u + length);
+				break;
+			}
+			case 1u:
+			{
+				//fixed tables from the deflate spec
+				uint8_t lengths[288 + 30];
+
+				std::fill(lengths, lengths + 144, (uint8_t)8u);
+				std::fill(lengths + 144, lengths + 256, (uint8_t)9u);
+				std::fill(lengths + 256, lengths + 280, (uint8_t)7u);
+				std::fill(lengths + 280, lengths + 288, (uint8_t)8u);
+				std::fill(lengths + 288, lengths + 318, (uint8_t)5u);
+
+				literals.Build(lengths, 288u);
+				distances.Build(lengths + 288, 30u);
+
+				InflateBlock(bits, literals, distances, pDst, out, dstSize);
+				break;
+			}
+			case 2u:
+
+				ReadDynamicTables(bits, literals, distances);
+				InflateBlock(bits, literals, distances, pDst, out, dstSize);
+				break;
+
+			default:
+
+				throw ImageDecoder::Exception(__LINE__, __FILE__, "Corrupt PNG (invalid block type)");
+			}
+
+			if (bits.IsOverrun()) {
+
+				throw ImageDecoder::Exception(__LINE__, __FILE__, "Corrupt PNG (truncated image data)");
+			}
+		}
+
+		if (out != dstSize) {
+
+			throw ImageDecoder::Exception(__LINE__, __FILE__, "Corrupt PNG (not enough image data)");
+		}
+	}
+
+	/// scanline filters
+
+	//one pixel of 3 or 4 bytes into the low dword
+	template<unsigned int bpp>
+	inline __m128i LoadPixel(const uint8_t* p) noexcept
+	{
+		uint32_t v = 0u;
+		memcpy(&v, p, bpp);
+
+		return _mm_cvtsi32_si128((int)v);
+	}
+
+	template<unsigned int bpp>
+	inline void StorePixel(uint8_t* p, __m128i v) noexcept
+	{
+		const uint32_t value = (uint32_t)_mm_cvtsi128_si32(v);
+		memcpy(p, &value, bpp);
+	}
+
+	//Sub, Avg and Paeth depend on the pixel to the left, so the lanes are the channels of one pixel
+	template<unsigned int bpp>
+	void UnfilterPixels(uint8_t filter, uint8_t* pRow, const uint8_t* pPrev, size_t rowBytes) noexcept
+	{
+		const __m128i zero = _mm_setzero_si128();
+
+		//left (a) and upper left (c) in 16 bit lanes
+		__m128i a = zero;
+		__m128i c = zero;
+
+		for (size_t i = 0; i < rowBytes; i += bpp) {
+
+			const __m128i x = LoadPixel<bpp>(pRow + i);
+			__m128i predictor;
+
+			switch (filter)
+			{
+			case 1u:
+
+				predictor = a;
+				break;
+
+			case 3u:
+
+				predictor = _mm_srli_epi16(_mm_add_epi16(a, _mm_unpacklo_epi8(LoadPixel<bpp>(pPrev + i), zero)), 1);
+				break;
+
+			default:
+			{
+				const __m128i b = _mm_unpacklo_epi8(LoadPixel<bpp>(pPrev + i), zero);
+
+				const __m128i bc = _mm_sub_epi16(b, c);
+				const __m128i ac = _mm_sub_epi16(a, c);
+
+				const __m128i pa = _mm_max_epi16(bc, _mm_sub_epi16(zero, bc));
+				const __m128i pb = _mm_max_epi16(ac, _mm_sub_epi16(zero, ac));
+				const __m128i abc = _mm_add_epi16(bc, ac);
+				const __m128i pc = _mm_max_epi16(abc, _mm_sub_epi16(zero, abc));
+
+				//a if pa is the smallest, else b if pb beats pc, else c
+				const __m128i smallest = _mm_min_epi16(_mm_min_epi16(pa, pb), pc);
+				const __m128i useA = _mm_cmpeq_epi16(pa, smallest);
+				const __m128i useB = _mm_cmpeq_epi16(pb, smallest);
+
+				predictor = _mm_or_si128(_mm_and_si128(useB, b), _mm_andnot_si128(useB, c));
+				predictor = _mm_or_si128(_mm_and_si128(useA, a), _mm_andnot_si128(useA, predictor));
+
+				c = b;
+				break;
+			}
+			}
+
+			const __m128i result = _mm_add_epi8(x, _mm_packus_epi16(predictor, predictor));
+
+			StorePixel<bpp>(pRow + i, result);
+			a = _mm_unpacklo_epi8(result, zero);
+		}
+	}
+
+	//any pixel size, used for the 1, 2, 6 and 8 byte formats
+	void UnfilterScalar(uint8_t filter, uint8_t* pRow, const uint8_t* pPrev, size_t rowBytes, unsigned int bpp) noexcept
+	{
+		for (size_t i = 0; i < rowBytes; i++) {
+
+			const int a = i >= bpp ? pRow[i - bpp] : 0;
+			const int b = pPrev[i];
+			const int c = i >= bpp ? pPrev[i - bpp] : 0;
+
+			int predictor;
+
+			switch (filter)
+			{
+			case 1u:
+
+				predictor = a;
+				break;
+
+			case 3u:
+
+				predictor = (a + b) >> 1;
+				break;
+
+			default:
+			{
+				const int pa = std::abs(b - c);
+				const int pb = std::abs(a - c);
+				const int pc = std::abs(a + b - 2 * c);
+
+				predictor = pa <= pb && pa <= pc ? a : pb <= pc ? b : c;
+				break;
+			}
+			}
+
+			pRow[i] = (uint8_t)(pRow[i] + predictor);
+		}
+	}
+
+	//pPrev is the already unfiltered row above (zeros for the first one)
+	void Unfilter(uint8_t filter, uint8_t* pRow, const uint8_t* pPrev, size_t rowBytes, unsigned int bpp)
+	{
+		switch (filter)
+		{
+		case 0u:
+
+			return;
+
+		//Up has no dependency along the row, 16 bytes at a time
+		case 2u:
+		{
+			size_t i = 0u;
+
+			for (; i + 16u <= rowBytes; i += 16u) {
+
+				const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow + i));
+				const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pPrev + i));
+
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(pRow + i), _mm_add_epi8(x, b));
+			}
+
+			for (; i < rowBytes; i++) {
+
+				pRow[i] = (uint8_t)(pRow[i] + pPrev[i]);
+			}
+
+			return;
+		}
+		case 1u:
+		case 3u:
+		case 4u:
+
+			if (bpp == 4u) {
+
+				UnfilterPixels<4u>(filter, pRow, pPrev, rowBytes);
+			}
+			else if (bpp == 3u) {
+
+				UnfilterPixels<3u>(filter, pRow, pPrev, rowBytes);
+			}
+			else {
+
+				UnfilterScalar(filter, pRow, pPrev, rowBytes, bpp);
+			}
+
+			return;
+
+		default:
+
+			throw ImageDecoder::Exception(__LINE__, __FILE__, "Corrupt PNG (unknown filter type)");
+		}
+	}
+
+	/// conversion to B8G8R8A8
+
+	enum ColorType : uint8_t {
+
+		Gray = 0u,
+		Rgb = 2u,
+		Palette = 3u,
+		GrayAlpha = 4u,
+		Rgba = 6u,
+	};
+
+	struct PngInfo {
+
+		unsigned int width = 0u;
+		unsigned int height = 0u;
+		unsigned int depth = 0u;
+		uint8_t colorType = 0u;
+
+		//B8G8R8A8 entries, alpha from tRNS
+		uint32_t palette[256];
+
+		//tRNS color key for gray / rgb, already reduced to 8 bits
+		bool hasKey = false;
+		unsigned int keyR = 0u, keyG = 0u, keyB = 0u;
+	};
+
+	inline uint32_t MakeTexel(unsigned int r, unsigned int g, unsigned int b, unsigned int a) noexcept
+	{
+		return (a << 24u) | (r << 16u) | (g << 8u) | b;
+	}
+
+	//byte-swaps R and B of four RGBA pixels at once
+	void ConvertRgba8(const uint8_t* pSrc, uint32_t* pDst, unsigned int width) noexcept
+	{
+		const __m128i keep = _mm_set1_epi32((int)0xFF00FF00u);
+		const __m128i low = _mm_set1_epi32(0xFF);
+
+		unsigned int x = 0u;
+
+		for (; x + 4u <= width; x += 4u) {
+
+			const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + x * 4u));
+			const __m128i r = _mm_and_si128(v, low);
+			const __m128i b = _mm_and_si128(_mm_srli_epi32(v, 16), low);
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + x), _mm_or_si128(_mm_and_si128(v, keep), _mm_or_si128(b, _mm_slli_epi32(r, 16))));
+		}
+
+		for (; x < width; x++) {
+
+			const auto p = pSrc + x * 4u;
+			pDst[x] = MakeTexel(p[0], p[1], p[2], p[3]);
+		}
+	}
+
+	void ConvertRow(const PngInfo& info, const uint8_t* pSrc, uint32_t* pDst)
+	{
+		const unsigned int width = info.width;
+
+		//16 bit samples keep their high byte
+		const unsigned int sample = info.depth == 16u ? 2u : 1u;
+
+		switch (info.colorType)
+		{
+		case Rgba:
+
+			if (sample == 1u) {
+
+				ConvertRgba8(pSrc, pDst, width);
+				return;
+			}
+
+			for (unsigned int x = 0; x < width; x++, pSrc += 8u) {
+
+				pDst[x] = MakeTexel(pSrc[0], pSrc[2], pSrc[4], pSrc[6]);
+			}
+			return;
+
+		case Rgb:
+
+			for (unsigned int x = 0; x < width; x++, pSrc += 3u * sample) {
+
+				const unsigned int r = pSrc[0], g = pSrc[sample], b = pSrc[2u * sample];
+				const bool isKey = info.hasKey && r == info.keyR && g == info.keyG && b == info.keyB;
+
+				pDst[x] = MakeTexel(r, g, b, isKey ? 0u : 255u);
+			}
+			return;
+
+		case GrayAlpha:
+
+			for (unsigned int x = 0; x < width; x++, pSrc += 2u * sample) {
+
+				pDst[x] = MakeTexel(pSrc[0], pSrc[0], pSrc[0], pSrc[sample]);
+			}
+			return;
+
+		case Gray:
+
+			if (info.depth >= 8u) {
+
+				for (unsigned int x = 0; x < width; x++, pSrc += sample) {
+
+					const unsigned int v = pSrc[0];
+					pDst[x] = MakeTexel(v, v, v, info.hasKey && v == info.keyR ? 0u : 255u);
+				}
+				return;
+			}
+
+			//1, 2 and 4 bit gray, packed from the high bit down, stretched to 8 bits
+			{
+				const unsigned int mask = (1u << info.depth) - 1u;
+				const unsigned int scale = 255u / mask;
+
+				for (unsigned int x = 0; x < width; x++) {
+
+					const unsigned int bit = x * info.depth;
+					const unsigned int raw = (pSrc[bit >> 3u] >> (8u - info.depth - (bit & 7u))) & mask;
+					const unsigned int v = raw * scale;
+
+					pDst[x] = MakeTexel(v, v, v, info.hasKey && v == info.keyR ? 0u : 255u);
+				}
+			}
+			return;
+
+		case Palette:
+		{
+			const unsigned int mask = (1u << info.depth) - 1u;
+
+			for (unsigned int x = 0; x < width; x++) {
+
+				const unsigned int bit = x * info.depth;
+				const unsigned int index = (pSrc[bit >> 3u] >> (8u - info.depth - (bit & 7u))) & mask;
+
+				pDst[x] = info.palette[index];
+			}
+			return;
+		}
+		}
+	}
+
+	inline uint32_t ReadBigEndian(const uint8_t* p) noexcept
+	{
+		return ((uint32_t)p[0] << 24u) | ((uint32_t)p[1] << 16u) | ((uint32_t)p[2] << 8u) | p[3];
+	}
+}
+
+void ImageDecoder::DecodePng(const uint8_t* pData, size_t size, const Allocator& allocate)
+{
+	PngInfo info;
+	bool hasHeader = false;
+	unsigned int paletteSize = 0u;
+
+	//IDAT chunks are one zlib stream split up, a single chunk is inflated in place
+	const uint8_t* pCompressed = nullptr;
+	size_t compressedSize = 0u;
+	std::vector<uint8_t> joined;
+
+	std::fill(std::begin(info.palette), std::end(info.palette), 0xFF000000u);
+
+	//signature, then length / type / data / crc chunks
+	size_t pos = 8u;
+
+	for (;;) {
+
+		if (pos + 12u > size) {
+
+			throw Exception(__LINE__, __FILE__, "Corrupt PNG (missing IEND chunk)");
+		}
+
+		const uint32_t length = ReadBigEndian(pData + pos);
+		const auto pType = pData + pos + 4u;
+		const auto pChunk = pData + pos + 8u;
+
+		if (length > size - pos - 12u) {
+
+			throw Exception(__LINE__, __FILE__, "Corrupt PNG (chunk past the end of the file)");
+		}
+
+		if (memcmp(pType, "IHDR", 4u) == 0) {
+
+			if (length < 13u) {
+
+				throw Exception(__LINE__, __FILE__, "Corrupt PNG (short IHDR)");
+			}
+
+			info.width = ReadBigEndian(pChunk);
+			info.height = ReadBigEndian(pChunk + 4u);
+			info.depth = pChunk[8];
+			info.colorType = pChunk[9];
+
+			if (pChunk[10] != 0u || pChunk[11] != 0u) {
+
+				throw Exception(__LINE__, __FILE__, "Corrupt PNG (unknown compression or filter method)");
+			}
+
+			if (pChunk[12] != 0u) {
+
+				throw Exception(__LINE__, __FILE__, "Interlaced PNG is not supported");
+			}
+
+			hasHeader = true;
+		}
+		else if (memcmp(pType, "PLTE", 4u) == 0) {
+
+			paletteSize = std::min(256u, length / 3u);
+
+			for (unsigned int i = 0; i < paletteSize; i++) {
+
+				info.palette[i] = MakeTexel(pChunk[i * 3u], pChunk[i * 3u + 1u], pChunk[i * 3u + 2u], 255u);
+			}
+		}
+		else if (memcmp(pType, "tRNS", 4u) == 0) {
+
+			if (info.colorType == Palette) {
+
+				for (unsigned int i = 0; i < std::min(256u, length); i++) {
+
+					info.palette[i] = (info.palette[i] & 0x00FFFFFFu) | ((uint32_t)pChunk[i] << 24u);
+				}
+			}
+			else if (info.colorType == Gray && length >= 2u) {
+
+				//samples are 16 bit big endian whatever the depth
+				const unsigned int key = ((pChunk[0] << 8u) | pChunk[1]);
+
+				info.keyR = info.depth == 16u ? key >> 8u : info.depth == 8u ? key : key * (255u / ((1u << info.depth) - 1u));
+				info.hasKey = info.depth != 16u;
+			}
+			else if (info.colorType == Rgb && length >= 6u) {
+
+				const unsigned int shift = info.depth == 16u ? 8u : 0u;
+
+				info.keyR = ((pChunk[0] << 8u) | pChunk[1]) >> shift;
+				info.keyG = ((pChunk[2] << 8u) | pChunk[3]) >> shift;
+				info.keyB = ((pChunk[4] << 8u) | pChunk[5]) >> shift;
+
+				//a 16 bit key no longer identifies a color once reduced to 8 bits
+				info.hasKey = info.depth == 8u;
+			}
+		}
+		else if (memcmp(pType, "IDAT", 4u) == 0) {
+
+			if (pCompressed == nullptr && joined.empty()) {
+
+				pCompressed = pChunk;
+				compressedSize = length;
+			}
+			else {
+
+				if (joined.empty()) {
+
+					joined.assign(pCompressed, pCompressed + compressedSize);
+				}
+
+				joined.insert(joined.end(), pChunk, pChunk + length);
+				pCompressed = joined.data();
+				compressedSize = joined.size();
+			}
+		}
+		else if (memcmp(pType, "IEND", 4u) == 0) {
+
+			break;
+		}
+
+		pos += 12u + length;
+	}
+
+	if (!hasHeader || pCompressed == nullptr || info.width == 0u || info.height == 0u) {
+
+		throw Exception(__LINE__, __FILE__, "Corrupt PNG (missing IHDR or IDAT)");
+	}
+
+	if (info.width > maxDimension || info.height > maxDimension) {
+
+		throw Exception(__LINE__, __FILE__, "PNG is larger than " + std::to_string(maxDimension) + " texels across");
+	}
+
+	unsigned int channels = 0u;
+
+	switch (info.colorType)
+	{
+	case Gray:
+
+		channels = 1u;
+		break;
+
+	case Rgb:
+
+		channels = 3u;
+		break;
+
+	case Palette:
+
+		channels = 1u;
+		break;
+
+	case GrayAlpha:
+
+		channels = 2u;
+		break;
+
+	case Rgba:
+
+		channels = 4u;
+		break;
+
+	default:
+
+		throw Exception(__LINE__, __FILE__, "Corrupt PNG (unknown color type)");
+	}
+
+	//packed depths only exist for gray and palette, 16 bit never for palette
+	const bool isPacked = info.depth == 1u || info.depth == 2u || info.depth == 4u;
+	const bool isValidDepth = info.colorType == Palette ? isPacked || info.depth == 8u :
+		info.colorType == Gray ? isPacked || info.depth == 8u || info.depth == 16u :
+		info.depth == 8u || info.depth == 16u;
+
+	if (!isValidDepth) {
+
+		throw Exception(__LINE__, __FILE__, "Corrupt PNG (invalid bit depth)");
+	}
+
+	if (info.colorType == Palette && paletteSize == 0u) {
+
+		throw Exception(__LINE__, __FILE__, "Corrupt PNG (palette image without PLTE)");
+	}
+
+	const size_t bitsPerPixel = (size_t)channels * info.depth;
+	const size_t rowBytes = (info.width * bitsPerPixel + 7u) / 8u;
+	const unsigned int filterBpp = (unsigned int)std::max<size_t>(1u, bitsPerPixel / 8u);
+
+	//filter byte plus the row, for every row
+	std::vector<uint8_t> raw(info.height * (rowBytes + 1u));
+	Inflate(pCompressed, compressedSize, raw.data(), raw.size());
+
+	uint32_t* pDst = allocate(info.width, info.height);
+
+	//first row filters against zeros
+	const std::vector<uint8_t> zeros(rowBytes, 0u);
+	const uint8_t* pPrev = zeros.data();
+
+	for (unsigned int y = 0; y < info.height; y++) {
+
+		uint8_t* pRow = raw.data() + y * (rowBytes + 1u);
+
+		Unfilter(pRow[0], pRow + 1u, pPrev, rowBytes, filterBpp);
+		ConvertRow(info, pRow + 1u, pDst + (size_t)y * info.width);
+
+		pPrev = pRow + 1u;
+	}
+}
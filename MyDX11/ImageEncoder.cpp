@@ -0,0 +1,112 @@
+#include "ImageEncoder.h"
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cctype>
+
+bool ImageEncoder::CanEncode(const std::string& path)
+{
+	const auto extension = GetLowerExtension(path);
+
+	return extension == "png" || extension == "qoi";
+}
+
+ImageEncoder::Format ImageEncoder::GetFormat(const std::string& path)
+{
+	const auto extension = GetLowerExtension(path);
+
+	if (extension == "png") {
+
+		return Format::Png;
+	}
+
+	if (extension == "qoi") {
+
+		return Format::Qoi;
+	}
+
+	throw Exception(__LINE__, __FILE__, "Unknown image extension [" + path + "] (only .png and .qoi are supported)");
+}
+
+const char* ImageEncoder::GetExtension(Format format) noexcept
+{
+	return format == Format::Png ? ".png" : ".qoi";
+}
+
+void ImageEncoder::Encode(Format format, const PixelKernels::ConstImage& image, bool hasAlpha, std::vector<uint8_t>& bytes)
+{
+	bytes.clear();
+
+	if (format == Format::Png) {
+
+		EncodePng(image, hasAlpha, bytes);
+	}
+	else {
+
+		EncodeQoi(image, hasAlpha, bytes);
+	}
+}
+
+void ImageEncoder::EncodeFile(const std::string& path, const PixelKernels::ConstImage& image, bool hasAlpha)
+{
+	std::vector<uint8_t> bytes;
+
+	Encode(GetFormat(path), image, hasAlpha, bytes);
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+	if (!file) {
+
+		throw Exception(__LINE__, __FILE__, "Failed to create [" + path + "]");
+	}
+
+	file.write(reinterpret_cast<const char*>(bytes.data()), (std::streamsize)bytes.size());
+
+	if (!file) {
+
+		throw Exception(__LINE__, __FILE__, "Failed to write [" + path + "]");
+	}
+}
+
+std::string ImageEncoder::GetLowerExtension(const std::string& path)
+{
+	const auto dot = path.find_last_of('.');
+
+	std::string extension = dot == std::string::npos ? std::string() : path.substr(dot + 1u);
+
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) {
+
+		return (char)std::tolower(c);
+	});
+
+	return extension;
+}
+
+
+//image encoder exception stuff
+ImageEncoder::Exception::Exception(int line, const char* file, std::string note) noexcept
+	:
+	myException(line, file),
+	note(std::move(note))
+{}
+
+const char* ImageEncoder::Exception::what() const noexcept
+{
+	std::ostringstream oss;
+
+	oss << myException::what() << std::endl
+		<< "[Note] " << GetNote();
+
+	whatBuffer = oss.str();
+	return whatBuffer.c_str();
+}
+
+const char* ImageEncoder::Exception::GetType() const noexcept
+{
+	return "SupaHotFire Image Encoder Exception";
+}
+
+const std::string& ImageEncoder::Exception::GetNote() const noexcept
+{
+	return note;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "myException.h"
+#include "PixelKernels.h"
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// PNG and QOI encoding from B8G8R8A8 (the Surface::Color layout)
+/// tuned for speed over size, meant for screenshots and frame sequences written while the engine runs
+/// PNG is one greedy LZ77 pass with a dynamic huffman block per 64K symbols, QOI is the whole format in one pass
+/// holds no shared state, any number of images can be encoded at once on different threads
+/// works on raw bytes only so it builds and runs without windows
+/// </summary>
+class ImageEncoder {
+
+public:
+
+	class Exception :public myException {
+
+	public:
+
+		Exception(int line, const char* file, std::string note) noexcept;
+		const char* what() const noexcept override;
+		const char* GetType() const noexcept override;
+
+		const std::string& GetNote() const noexcept;
+
+	private:
+
+		std::string note;
+	};
+
+	enum class Format {
+
+		//about a third the size of raw, a few times slower than QOI
+		Png,
+		//a bit bigger than PNG, several times faster, made for sequences
+		Qoi,
+	};
+
+public:
+
+	//from the extension, .png or .qoi (any case)
+	static bool CanEncode(const std::string& path);
+	static Format GetFormat(const std::string& path);
+	static const char* GetExtension(Format format) noexcept;
+
+	//replaces the contents of bytes, so one buffer can be reused frame after frame
+	//*without alpha the image is stored as RGB and the alpha channel is ignored
+	static void Encode(Format format, const PixelKernels::ConstImage& image, bool hasAlpha, std::vector<uint8_t>& bytes);
+
+	//format from the extension, the folder has to exist
+	static void EncodeFile(const std::string& path, const PixelKernels::ConstImage& image, bool hasAlpha);
+
+private:
+
+	static std::string GetLowerExtension(const std::string& path);
+
+	static void EncodePng(const PixelKernels::ConstImage& image, bool hasAlpha, std::vector<uint8_t>& bytes);
+	static void EncodeQoi(const PixelKernels::ConstImage& image, bool hasAlpha, std::vector<uint8_t>& bytes);
+};
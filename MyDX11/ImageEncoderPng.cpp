@@ -0,0 +1,869 @@
+#include "ImageEncoder.h"
+#include <emmintrin.h>
+#include <algorithm>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+
+//PNG half of ImageEncoder: scanline filters, a fast deflate and the chunk framing
+
+namespace {
+
+	/// deflate
+
+	constexpr unsigned int minMatch = 4u;
+	constexpr unsigned int maxMatch = 258u;
+	constexpr unsigned int windowSize = 32768u;
+
+	//one slot per hash, the newest position wins, no chains
+	constexpr unsigned int hashBits = 15u;
+
+	//symbols per huffman block, enough to pay for the table header
+	constexpr size_t blockSymbols = 64u * 1024u;
+
+	constexpr unsigned int literalCodes = 286u;
+	constexpr unsigned int distanceCodes = 30u;
+	constexpr unsigned int lengthCodes = 19u;
+	constexpr unsigned int endOfBlock = 256u;
+
+	//base value and extra bits of every length and distance code
+	constexpr uint16_t lengthBase[29] = { 3,4,5,6,7,8,9,10,11,13,15,17,19,23,27,31,35,43,51,59,67,83,99,115,131,163,195,227,258 };
+	constexpr uint8_t lengthExtra[29] = { 0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2,3,3,3,3,4,4,4,4,5,5,5,5,0 };
+	constexpr uint16_t distanceBase[30] = { 1,2,3,4,5,7,9,13,17,25,33,49,65,97,129,193,257,385,513,769,1025,1537,2049,3073,4097,6145,8193,12289,16385,24577 };
+	constexpr uint8_t distanceExtra[30] = { 0,0,0,0,1,1,2,2,3,3,4,4,5,5,6,6,7,7,8,8,9,9,10,10,11,11,12,12,13,13 };
+
+	//order the code length code lengths are stored in
+	constexpr uint8_t lengthOrder[lengthCodes] = { 16,17,18,0,8,7,9,6,10,5,11,4,12,3,13,2,14,1,15 };
+
+	//length to code and distance to code, the upper distances go through their top bits
+	struct CodeTables {
+
+		CodeTables() noexcept
+		{
+			for (unsigned int code = 0; code < 29u; code++) {
+
+				const unsigned int count = code == 28u ? 1u : 1u << lengthExtra[code];
+
+				for (unsigned int i = 0; i < count; i++) {
+
+					lengths[lengthBase[code] + i] = (uint8_t)code;
+				}
+			}
+
+			for (unsigned int code = 0; code < distanceCodes; code++) {
+
+				const unsigned int count = 1u << distanceExtra[code];
+
+				for (unsigned int i = 0; i < count; i++) {
+
+					const unsigned int distance = distanceBase[code] + i - 1u;
+
+					if (distance < 256u) {
+
+						nearDistances[distance] = (uint8_t)code;
+					}
+					else {
+
+						farDistances[distance >> 7u] = (uint8_t)code;
+					}
+				}
+			}
+		}
+
+		unsigned int GetDistanceCode(unsigned int distance) const noexcept
+		{
+			return distance <= 256u ? nearDistances[distance - 1u] : farDistances[(distance - 1u) >> 7u];
+		}
+
+		uint8_t lengths[maxMatch + 1u] = {};
+		uint8_t nearDistances[256] = {};
+		uint8_t farDistances[256] = {};
+	};
+
+	const CodeTables& GetCodeTables()
+	{
+		static const CodeTables tables;
+		return tables;
+	}
+
+	//deflate packs bits lowest first
+	//*appends to bytes, which is kept larger than what was written until Flush trims it
+	class BitWriter {
+
+	public:
+
+		explicit BitWriter(std::vector<uint8_t>& bytes) noexcept
+			:
+			m_bytes(bytes),
+			m_pos(bytes.size())
+		{}
+
+		//at most 32 bits at a time
+		void Put(uint32_t value, unsigned int count)
+		{
+			m_bits |= (uint64_t)value << m_count;
+			m_count += count;
+
+			if (m_count >= 32u) {
+
+				if (m_pos + 4u > m_bytes.size()) {
+
+					m_bytes.resize(m_bytes.size() * 2u + 64u);
+				}
+
+				uint8_t* p = m_bytes.data() + m_pos;
+
+				p[0] = (uint8_t)m_bits;
+				p[1] = (uint8_t)(m_bits >> 8u);
+				p[2] = (uint8_t)(m_bits >> 16u);
+				p[3] = (uint8_t)(m_bits >> 24u);
+
+				m_pos += 4u;
+				m_bits >>= 32u;
+				m_count -= 32u;
+			}
+		}
+
+		//pads the last byte with zeros
+		void Flush()
+		{
+			m_bytes.resize(m_pos);
+
+			while (m_count > 0u) {
+
+				m_bytes.push_back((uint8_t)m_bits);
+				m_bits >>= 8u;
+				m_count = m_count > 8u ? m_count - 8u : 0u;
+			}
+
+			m_bits = 0u;
+			m_pos = m_bytes.size();
+		}
+
+	private:
+
+		std::vector<uint8_t>& m_bytes;
+		size_t m_pos;
+		uint64_t m_bits = 0u;
+		unsigned int m_count = 0u;
+	};
+
+	//canonical huffman code for a set of frequencies, no length above maxBits
+	class HuffmanCode {
+
+	public:
+
+		void Build(const uint32_t* pFrequencies, unsigned int count, unsigned int maxBits)
+		{
+			m_lengths.assign(count, 0u);
+			m_codes.assign(count, 0u);
+
+			std::vector<unsigned int> symbols;
+
+			for (unsigned int i = 0; i < count; i++) {
+
+				if (pFrequencies[i] > 0u) {
+
+					symbols.push_back(i);
+				}
+			}
+
+			//a code needs two symbols to exist, the spare one is never written
+			if (symbols.size() < 2u) {
+
+				m_lengths[0] = 1u;
+				m_lengths[symbols.empty() || symbols[0] == 0u ? 1u : symbols[0]] = 1u;
+				AssignCodes(maxBits);
+
+				return;
+			}
+
+			std::stable_sort(symbols.begin(), symbols.end(), [pFrequencies](unsigned int a, unsigned int b) {
+
+				return pFrequencies[a] < pFrequencies[b];
+			});
+
+			//two queue huffman over the sorted leaves, nodes come out in ascending weight so the second queue stays sorted
+			const size_t leaves = symbols.size();
+			std::vector<uint64_t> weights(leaves * 2u - 1u);
+			std::vector<size_t> parents(leaves * 2u - 1u);
+
+			for (size_t i = 0; i < leaves; i++) {
+
+				weights[i] = pFrequencies[symbols[i]];
+			}
+
+			size_t nextLeaf = 0u, nextNode = leaves;
+
+			const auto takeSmallest = [&](size_t node) {
+
+				if (nextLeaf < leaves && (nextNode >= node || weights[nextLeaf] <= weights[nextNode])) {
+
+					return nextLeaf++;
+				}
+
+				return nextNode++;
+			};
+
+			for (size_t node = leaves; node < weights.size(); node++) {
+
+				const size_t a = takeSmallest(node);
+				const size_t b = takeSmallest(node);
+
+				weights[node] = weights[a] + weights[b];
+				parents[a] = node;
+				parents[b] = node;
+			}
+
+			//depths top down, the root is the last node
+			std::vector<unsigned int> depths(weights.size(), 0u);
+			unsigned int lengthCount[32] = {};
+
+			for (size_t node = weights.size() - 1u; node-- > 0u;) {
+
+				depths[node] = depths[parents[node]] + 1u;
+			}
+
+			for (size_t i = 0; i < leaves; i++) {
+
+				lengthCount[std::min(depths[i], 31u)]++;
+			}
+
+			//too deep codes are pulled up to maxBits, then shorter codes are pushed down until the kraft sum fits again
+			for (unsigned int len = maxBits + 1u; len < 32u; len++) {
+
+				lengthCount[maxBits] += lengthCount[len];
+				lengthCount[len] = 0u;
+			}
+
+			uint64_t kraft = 0u;
+
+			for (unsigned int len = 1u; len <= maxBits; len++) {
+
+				kraft += (uint64_t)lengthCount[len] << (maxBits - len);
+			}
+
+			while (kraft > (1ull << maxBits)) {
+
+				lengthCount[maxBits]--;
+
+				for (unsigned int len = maxBits - 1u; len > 0u; len--) {
+
+					if (lengthCount[len] > 0u) {
+
+						lengthCount[len]--;
+						lengthCount[len + 1u] += 2u;
+						break;
+					}
+				}
+
+				kraft--;
+			}
+
+			//rarest symbols get the longest codes
+			size_t leaf = 0u;
+
+			for (unsigned int len = maxBits; len > 0u; len--) {
+
+				for (unsigned int i = 0; i < lengthCount[len]; i++) {
+
+					m_lengths[symbols[leaf++]] = (uint8_t)len;
+				}
+			}
+
+			AssignCodes(maxBits);
+		}
+
+		const std::vector<uint8_t>& GetLengths() const noexcept
+		{
+			return m_lengths;
+		}
+
+		void Put(BitWriter& bits, unsigned int symbol) const
+		{
+			bits.Put(m_codes[symbol], m_lengths[symbol]);
+		}
+
+	private:
+
+		//codes are stored bit reversed, the writer sends the lowest bit first
+		void AssignCodes(unsigned int maxBits)
+		{
+			std::vector<unsigned int> lengthCount(maxBits + 1u, 0u);
+			std::vector<unsigned int> nextCode(maxBits + 2u, 0u);
+
+			for (const auto len : m_lengths) {
+
+				lengthCount[len]++;
+			}
+
+			lengthCount[0] = 0u;
+
+			for (unsigned int len = 1u; len <= maxBits; len++) {
+
+				nextCode[len + 1u] = (nextCode[len] + lengthCount[len]) << 1u;
+			}
+
+			for (size_t i = 0; i < m_lengths.size(); i++) {
+
+				const unsigned int len = m_lengths[i];
+
+				if (len == 0u) {
+
+					continue;
+				}
+
+				unsigned int code = nextCode[len]++;
+				unsigned int reversed = 0u;
+
+				for (unsigned int b = 0; b < len; b++) {
+
+					reversed = (reversed << 1u) | (code & 1u);
+					code >>= 1u;
+				}
+
+				m_codes[i] = (uint16_t)reversed;
+			}
+		}
+
+	private:
+
+		std::vector<uint8_t> m_lengths;
+		std::vector<uint16_t> m_codes;
+	};
+
+	//literal (distance zero) or back reference
+	struct Symbol {
+
+		uint16_t value;
+		uint16_t distance;
+	};
+
+	//code lengths of both tables run length coded with the 16 / 17 / 18 codes, extra bits in the top byte
+	void RunLengthCode(const std::vector<uint8_t>& lengths, std::vector<uint16_t>& out, uint32_t* pFrequencies)
+	{
+		size_t i = 0u;
+
+		while (i < lengths.size()) {
+
+			const uint8_t len = lengths[i];
+			size_t run = 1u;
+
+			while (i + run < lengths.size() && lengths[i + run] == len) {
+
+				run++;
+			}
+
+			i += run;
+
+			if (len == 0u) {
+
+				while (run >= 11u) {
+
+					const auto count = std::min<size_t>(run, 138u);
+
+					out.push_back((uint16_t)(18u | (count - 11u) << 8u));
+					pFrequencies[18]++;
+					run -= count;
+				}
+
+				if (run >= 3u) {
+
+					out.push_back((uint16_t)(17u | (run - 3u) << 8u));
+					pFrequencies[17]++;
+					run = 0u;
+				}
+			}
+			else {
+
+				out.push_back(len);
+				pFrequencies[len]++;
+				run--;
+
+				while (run >= 3u) {
+
+					const auto count = std::min<size_t>(run, 6u);
+
+					out.push_back((uint16_t)(16u | (count - 3u) << 8u));
+					pFrequencies[16]++;
+					run -= count;
+				}
+			}
+
+			for (; run > 0u; run--) {
+
+				out.push_back(len);
+				pFrequencies[len]++;
+			}
+		}
+	}
+
+	void WriteBlock(BitWriter& bits, const std::vector<Symbol>& symbols, const uint32_t* pLiteralFrequencies, const uint32_t* pDistanceFrequencies, bool isLast)
+	{
+		const auto& tables = GetCodeTables();
+
+		HuffmanCode literals, distances;
+		literals.Build(pLiteralFrequencies, literalCodes, 15u);
+		distances.Build(pDistanceFrequencies, distanceCodes, 15u);
+
+		//trailing zero lengths are not stored, the counts have a floor
+		unsigned int literalCount = literalCodes;
+		unsigned int distanceCount = distanceCodes;
+
+		while (literalCount > 257u && literals.GetLengths()[literalCount - 1u] == 0u) {
+
+			literalCount--;
+		}
+
+		while (distanceCount > 1u && distances.GetLengths()[distanceCount - 1u] == 0u) {
+
+			distanceCount--;
+		}
+
+		//both tables are one sequence for the run length coding
+		std::vector<uint8_t> lengths(literals.GetLengths().begin(), literals.GetLengths().begin() + literalCount);
+		lengths.insert(lengths.end(), distances.GetLengths().begin(), distances.GetLengths().begin() + distanceCount);
+
+		std::vector<uint16_t> runs;
+		uint32_t lengthFrequencies[lengthCodes] = {};
+		RunLengthCode(lengths, runs, lengthFrequencies);
+
+		HuffmanCode lengthCode;
+		lengthCode.Build(lengthFrequencies, lengthCodes, 7u);
+
+		unsigned int lengthCount = lengthCodes;
+
+		while (lengthCount > 4u && lengthCode.GetLengths()[lengthOrder[lengthCount - 1u]] == 0u) {
+
+			lengthCount--;
+		}
+
+		bits.Put(isLast ? 1u : 0u, 1u);
+		bits.Put(2u, 2u);
+		bits.Put(literalCount - 257u, 5u);
+		bits.Put(distanceCount - 1u, 5u);
+		bits.Put(lengthCount - 4u, 4u);
+
+		for (unsigned int i = 0; i < lengthCount; i++) {
+
+			bits.Put(lengthCode.GetLengths()[lengthOrder[i]], 3u);
+		}
+
+		for (const auto run : runs) {
+
+			const unsigned int code = run & 0xFFu;
+
+			lengthCode.Put(bits, code);
+
+			if (code == 16u) {
+
+				bits.Put(run >> 8u, 2u);
+			}
+			else if (code == 17u) {
+
+				bits.Put(run >> 8u, 3u);
+			}
+			else if (code == 18u) {
+
+				bits.Put(run >> 8u, 7u);
+			}
+		}
+
+		for (const auto& symbol : symbols) {
+
+			if (symbol.distance == 0u) {
+
+				literals.Put(bits, symbol.value);
+				continue;
+			}
+
+			const unsigned int lengthSymbol = tables.lengths[symbol.value];
+			const unsigned int distanceSymbol = tables.GetDistanceCode(symbol.distance);
+
+			literals.Put(bits, 257u + lengthSymbol);
+			bits.Put(symbol.value - lengthBase[lengthSymbol], lengthExtra[lengthSymbol]);
+
+			distances.Put(bits, distanceSymbol);
+			bits.Put(symbol.distance - distanceBase[distanceSymbol], distanceExtra[distanceSymbol]);
+		}
+
+		literals.Put(bits, endOfBlock);
+	}
+
+	inline uint32_t Read32(const uint8_t* p) noexcept
+	{
+		uint32_t value;
+		memcpy(&value, p, 4u);
+		return value;
+	}
+
+	inline unsigned int Hash(uint32_t value) noexcept
+	{
+		return (value * 2654435761u) >> (32u - hashBits);
+	}
+
+	//greedy LZ77, the first match found is taken whole and its inside is not indexed
+	void Deflate(const uint8_t* pData, size_t size, BitWriter& bits)
+	{
+		const auto& tables = GetCodeTables();
+
+		//positions are stored plus one, zero is empty
+		std::vector<uint32_t> heads(1u << hashBits, 0u);
+
+		std::vector<Symbol> symbols;
+		symbols.reserve(blockSymbols);
+
+		uint32_t literalFrequencies[literalCodes] = {};
+		uint32_t distanceFrequencies[distanceCodes] = {};
+
+		const auto flush = [&](bool isLast) {
+
+			literalFrequencies[endOfBlock] = 1u;
+			WriteBlock(bits, symbols, literalFrequencies, distanceFrequencies, isLast);
+
+			symbols.clear();
+			std::fill(std::begin(literalFrequencies), std::end(literalFrequencies), 0u);
+			std::fill(std::begin(distanceFrequencies), std::end(distanceFrequencies), 0u);
+		};
+
+		size_t pos = 0u;
+
+		while (pos < size) {
+
+			if (symbols.size() >= blockSymbols) {
+
+				flush(false);
+			}
+
+			if (pos + minMatch <= size) {
+
+				const uint32_t bytes = Read32(pData + pos);
+				uint32_t& head = heads[Hash(bytes)];
+				const size_t candidate = head;
+
+				head = (uint32_t)pos + 1u;
+
+				if (candidate > 0u && pos + 1u - candidate <= windowSize && Read32(pData + candidate - 1u) == bytes) {
+
+					const uint8_t* pMatch = pData + candidate - 1u;
+					const size_t limit = std::min<size_t>(maxMatch, size - pos);
+					size_t length = minMatch;
+
+					while (length < limit && pMatch[length] == pData[pos + length]) {
+
+						length++;
+					}
+
+					const auto distance = (uint16_t)(pos + 1u - candidate);
+
+					symbols.push_back({ (uint16_t)length,distance });
+					literalFrequencies[257u + tables.lengths[length]]++;
+					distanceFrequencies[tables.GetDistanceCode(distance)]++;
+
+					pos += length;
+					continue;
+				}
+			}
+
+			symbols.push_back({ pData[pos],0u });
+			literalFrequencies[pData[pos]]++;
+			pos++;
+		}
+
+		flush(true);
+	}
+
+	/// zlib and png framing
+
+	uint32_t Adler32(const uint8_t* pData, size_t size) noexcept
+	{
+		uint32_t a = 1u, b = 0u;
+
+		//the largest run that cannot overflow b before the modulo
+		constexpr size_t chunk = 5552u;
+
+		while (size > 0u) {
+
+			const size_t count = std::min(size, chunk);
+
+			for (size_t i = 0; i < count; i++) {
+
+				a += pData[i];
+				b += a;
+			}
+
+			a %= 65521u;
+			b %= 65521u;
+			pData += count;
+			size -= count;
+		}
+
+		return (b << 16u) | a;
+	}
+
+	//slice by four, one table per byte of the word
+	struct CrcTables {
+
+		CrcTables() noexcept
+		{
+			for (uint32_t i = 0; i < 256u; i++) {
+
+				uint32_t c = i;
+
+				for (unsigned int k = 0; k < 8u; k++) {
+
+					c = (c & 1u) ? 0xEDB88320u ^ (c >> 1u) : c >> 1u;
+				}
+
+				table[0][i] = c;
+			}
+
+			for (uint32_t i = 0; i < 256u; i++) {
+
+				for (unsigned int t = 1u; t < 4u; t++) {
+
+					table[t][i] = (table[t - 1u][i] >> 8u) ^ table[0][table[t - 1u][i] & 0xFFu];
+				}
+			}
+		}
+
+		uint32_t table[4][256];
+	};
+
+	uint32_t Crc32(const uint8_t* pData, size_t size) noexcept
+	{
+		static const CrcTables tables;
+		const auto& t = tables.table;
+
+		uint32_t crc = 0xFFFFFFFFu;
+
+		for (; size >= 4u; size -= 4u, pData += 4u) {
+
+			crc ^= (uint32_t)pData[0] | (uint32_t)pData[1] << 8u | (uint32_t)pData[2] << 16u | (uint32_t)pData[3] << 24u;
+			crc = t[3][crc & 0xFFu] ^ t[2][(crc >> 8u) & 0xFFu] ^ t[1][(crc >> 16u) & 0xFFu] ^ t[0][crc >> 24u];
+		}
+
+		for (; size > 0u; size--, pData++) {
+
+			crc = t[0][(crc ^ *pData) & 0xFFu] ^ (crc >> 8u);
+		}
+
+		return crc ^ 0xFFFFFFFFu;
+	}
+
+	inline void PutBigEndian(std::vector<uint8_t>& bytes, uint32_t value)
+	{
+		const uint8_t word[4] = { (uint8_t)(value >> 24u),(uint8_t)(value >> 16u),(uint8_t)(value >> 8u),(uint8_t)value };
+
+		bytes.insert(bytes.end(), word, word + 4u);
+	}
+
+	//length, type, data, crc of type and data
+	void BeginChunk(std::vector<uint8_t>& bytes, const char* type)
+	{
+		PutBigEndian(bytes, 0u);
+		bytes.insert(bytes.end(), type, type + 4u);
+	}
+
+	void EndChunk(std::vector<uint8_t>& bytes, size_t start)
+	{
+		const size_t length = bytes.size() - start - 8u;
+
+		bytes[start] = (uint8_t)(length >> 24u);
+		bytes[start + 1u] = (uint8_t)(length >> 16u);
+		bytes[start + 2u] = (uint8_t)(length >> 8u);
+		bytes[start + 3u] = (uint8_t)length;
+
+		PutBigEndian(bytes, Crc32(bytes.data() + start + 4u, length + 4u));
+	}
+
+	/// scanline filters
+
+	inline uint8_t Paeth(int a, int b, int c) noexcept
+	{
+		const int pa = std::abs(b - c);
+		const int pb = std::abs(a - c);
+		const int pc = std::abs(a + b - c - c);
+
+		return (uint8_t)(pa <= pb && pa <= pc ? a : pb <= pc ? b : c);
+	}
+
+	//Paeth predictor of eight bytes in 16 bit lanes, the same selection the decoder makes
+	inline __m128i PaethPredictor(__m128i a, __m128i b, __m128i c) noexcept
+	{
+		const __m128i zero = _mm_setzero_si128();
+
+		const __m128i bc = _mm_sub_epi16(b, c);
+		const __m128i ac = _mm_sub_epi16(a, c);
+
+		const __m128i pa = _mm_max_epi16(bc, _mm_sub_epi16(zero, bc));
+		const __m128i pb = _mm_max_epi16(ac, _mm_sub_epi16(zero, ac));
+		const __m128i abc = _mm_add_epi16(bc, ac);
+		const __m128i pc = _mm_max_epi16(abc, _mm_sub_epi16(zero, abc));
+
+		const __m128i smallest = _mm_min_epi16(_mm_min_epi16(pa, pb), pc);
+		const __m128i useA = _mm_cmpeq_epi16(pa, smallest);
+		const __m128i useB = _mm_cmpeq_epi16(pb, smallest);
+
+		const __m128i predictor = _mm_or_si128(_mm_and_si128(useB, b), _mm_andnot_si128(useB, c));
+
+		return _mm_or_si128(_mm_and_si128(useA, a), _mm_andnot_si128(useA, predictor));
+	}
+
+	//sum of the residuals read as signed bytes, small either way is cheap
+	inline __m128i AddCost(__m128i cost, __m128i residual) noexcept
+	{
+		const __m128i magnitude = _mm_min_epu8(residual, _mm_sub_epi8(_mm_setzero_si128(), residual));
+
+		return _mm_add_epi64(cost, _mm_sad_epu8(magnitude, _mm_setzero_si128()));
+	}
+
+	//Up for flat and vertical detail, Paeth for the rest, whichever leaves the smaller residuals
+	//*the other three filters rarely win on rendered frames and would double the time spent here
+	//*pOut gets the filter byte then the row, pPaeth is scratch of rowBytes
+	void FilterRow(const uint8_t* pRow, const uint8_t* pPrev, size_t rowBytes, unsigned int bpp, uint8_t* pOut, uint8_t* pPaeth)
+	{
+		if (pPrev == nullptr) {
+
+			//first row, Sub
+			pOut[0] = 1u;
+
+			for (size_t i = 0; i < rowBytes; i++) {
+
+				pOut[1u + i] = (uint8_t)(pRow[i] - (i >= bpp ? pRow[i - bpp] : 0u));
+			}
+
+			return;
+		}
+
+		uint8_t* pUp = pOut + 1u;
+		unsigned int upCost = 0u, paethCost = 0u;
+
+		const auto scalar = [&](size_t i) {
+
+			const uint8_t up = (uint8_t)(pRow[i] - pPrev[i]);
+			const uint8_t pa = i >= bpp ? (uint8_t)(pRow[i] - Paeth(pRow[i - bpp], pPrev[i], pPrev[i - bpp])) : up;
+
+			pUp[i] = up;
+			pPaeth[i] = pa;
+
+			upCost += (unsigned int)std::abs((int8_t)up);
+			paethCost += (unsigned int)std::abs((int8_t)pa);
+		};
+
+		//the first pixel has nothing on its left
+		size_t i = 0u;
+
+		for (; i < bpp && i < rowBytes; i++) {
+
+			scalar(i);
+		}
+
+		const __m128i zero = _mm_setzero_si128();
+		__m128i upSum = zero, paethSum = zero;
+
+		for (; i + 16u <= rowBytes; i += 16u) {
+
+			const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow + i));
+			const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow + i - bpp));
+			const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pPrev + i));
+			const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pPrev + i - bpp));
+
+			const __m128i low = PaethPredictor(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero), _mm_unpacklo_epi8(c, zero));
+			const __m128i high = PaethPredictor(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero), _mm_unpackhi_epi8(c, zero));
+
+			const __m128i up = _mm_sub_epi8(x, b);
+			const __m128i pa = _mm_sub_epi8(x, _mm_packus_epi16(low, high));
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pUp + i), up);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pPaeth + i), pa);
+
+			upSum = AddCost(upSum, up);
+			paethSum = AddCost(paethSum, pa);
+		}
+
+		for (; i < rowBytes; i++) {
+
+			scalar(i);
+		}
+
+		upCost += (unsigned int)(_mm_cvtsi128_si32(upSum) + _mm_cvtsi128_si32(_mm_unpackhi_epi64(upSum, upSum)));
+		paethCost += (unsigned int)(_mm_cvtsi128_si32(paethSum) + _mm_cvtsi128_si32(_mm_unpackhi_epi64(paethSum, paethSum)));
+
+		if (paethCost < upCost) {
+
+			pOut[0] = 4u;
+			memcpy(pUp, pPaeth, rowBytes);
+		}
+		else {
+
+			pOut[0] = 2u;
+		}
+	}
+}
+
+void ImageEncoder::EncodePng(const PixelKernels::ConstImage& image, bool hasAlpha, std::vector<uint8_t>& bytes)
+{
+	const unsigned int bpp = hasAlpha ? 4u : 3u;
+	const size_t rowBytes = (size_t)image.width * bpp;
+
+	//PNG wants RGBA, the swizzle kernel turns one row at a time around
+	std::vector<uint32_t> rgba(image.width);
+	std::vector<uint8_t> rows[2] = { std::vector<uint8_t>(rowBytes),std::vector<uint8_t>(rowBytes) };
+	std::vector<uint8_t> paeth(rowBytes);
+
+	std::vector<uint8_t> filtered((rowBytes + 1u) * image.height);
+
+	for (unsigned int y = 0; y < image.height; y++) {
+
+		auto& row = rows[y & 1u];
+
+		PixelKernels::SwizzleRB(image.Crop(0u, y, image.width, 1u), PixelKernels::Image(rgba.data(), image.width, image.width, 1u));
+
+		if (hasAlpha) {
+
+			memcpy(row.data(), rgba.data(), rowBytes);
+		}
+		else {
+
+			for (unsigned int x = 0; x < image.width; x++) {
+
+				memcpy(row.data() + x * 3u, &rgba[x], 3u);
+			}
+		}
+
+		FilterRow(row.data(), y > 0u ? rows[(y - 1u) & 1u].data() : nullptr, rowBytes, bpp, filtered.data() + y * (rowBytes + 1u), paeth.data());
+	}
+
+	static constexpr uint8_t signature[8] = { 0x89,'P','N','G','\r','\n',0x1A,'\n' };
+
+	bytes.reserve(filtered.size() / 2u);
+	bytes.insert(bytes.end(), signature, signature + 8u);
+
+	size_t start = bytes.size();
+	BeginChunk(bytes, "IHDR");
+	PutBigEndian(bytes, image.width);
+	PutBigEndian(bytes, image.height);
+	//8 bit, RGB or RGBA, deflate, adaptive filters, not interlaced
+	const uint8_t header[5] = { 8u,(uint8_t)(hasAlpha ? 6u : 2u),0u,0u,0u };
+	bytes.insert(bytes.end(), header, header + 5u);
+	EndChunk(bytes, start);
+
+	//the whole zlib stream in one IDAT
+	start = bytes.size();
+	BeginChunk(bytes, "IDAT");
+	//32K window, fastest level
+	bytes.push_back(0x78u);
+	bytes.push_back(0x01u);
+
+	BitWriter bits(bytes);
+	Deflate(filtered.data(), filtered.size(), bits);
+	bits.Flush();
+
+	PutBigEndian(bytes, Adler32(filtered.data(), filtered.size()));
+	EndChunk(bytes, start);
+
+	start = bytes.size();
+	BeginChunk(bytes, "IEND");
+	EndChunk(bytes, start);
+}
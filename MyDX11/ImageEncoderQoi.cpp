@@ -0,0 +1,155 @@
+#include "ImageEncoder.h"
+
+//QOI half of ImageEncoder, the whole format is one pass over the pixels
+
+namespace {
+
+	constexpr uint8_t opIndex = 0x00u;
+	constexpr uint8_t opDiff = 0x40u;
+	constexpr uint8_t opLuma = 0x80u;
+	constexpr uint8_t opRun = 0xC0u;
+	constexpr uint8_t opRgb = 0xFEu;
+	constexpr uint8_t opRgba = 0xFFu;
+
+	//runs are stored minus one and 63, 64 would collide with the rgb and rgba tags
+	constexpr unsigned int maxRun = 62u;
+
+	constexpr uint8_t endMarker[8] = { 0,0,0,0,0,0,0,1 };
+
+	//B8G8R8A8 dword
+	inline unsigned int HashColor(uint32_t c) noexcept
+	{
+		const unsigned int b = c & 0xFFu;
+		const unsigned int g = (c >> 8u) & 0xFFu;
+		const unsigned int r = (c >> 16u) & 0xFFu;
+		const unsigned int a = c >> 24u;
+
+		return (r * 3u + g * 5u + b * 7u + a * 11u) & 63u;
+	}
+
+	inline void PutBigEndian(uint8_t* p, uint32_t value) noexcept
+	{
+		p[0] = (uint8_t)(value >> 24u);
+		p[1] = (uint8_t)(value >> 16u);
+		p[2] = (uint8_t)(value >> 8u);
+		p[3] = (uint8_t)value;
+	}
+}
+
+void ImageEncoder::EncodeQoi(const PixelKernels::ConstImage& image, bool hasAlpha, std::vector<uint8_t>& bytes)
+{
+	//the worst case is every pixel as an rgba op
+	bytes.resize(14u + (size_t)image.width * image.height * 5u + sizeof(endMarker));
+
+	uint8_t* pOut = bytes.data();
+
+	pOut[0] = 'q';
+	pOut[1] = 'o';
+	pOut[2] = 'i';
+	pOut[3] = 'f';
+	PutBigEndian(pOut + 4u, image.width);
+	PutBigEndian(pOut + 8u, image.height);
+	pOut[12] = hasAlpha ? 4u : 3u;
+	//sRGB color with linear alpha
+	pOut[13] = 0u;
+	pOut += 14u;
+
+	uint32_t index[64] = {};
+	uint32_t previous = 0xFF000000u;
+	unsigned int run = 0u;
+
+	//without alpha every pixel is read as opaque, so the alpha ops never come up
+	const uint32_t alphaMask = hasAlpha ? 0u : 0xFF000000u;
+
+	for (unsigned int y = 0; y < image.height; y++) {
+
+		const uint32_t* pRow = image.pTexels + y * image.pitch;
+
+		for (unsigned int x = 0; x < image.width; x++) {
+
+			const uint32_t pixel = pRow[x] | alphaMask;
+
+			if (pixel == previous) {
+
+				if (++run == maxRun) {
+
+					*pOut++ = opRun | (uint8_t)(run - 1u);
+					run = 0u;
+				}
+
+				continue;
+			}
+
+			if (run > 0u) {
+
+				*pOut++ = opRun | (uint8_t)(run - 1u);
+				run = 0u;
+			}
+
+			const unsigned int hash = HashColor(pixel);
+
+			if (index[hash] == pixel) {
+
+				*pOut++ = opIndex | (uint8_t)hash;
+			}
+			else {
+
+				index[hash] = pixel;
+
+				const uint8_t r = (uint8_t)(pixel >> 16u);
+				const uint8_t g = (uint8_t)(pixel >> 8u);
+				const uint8_t b = (uint8_t)pixel;
+
+				if ((pixel >> 24u) == (previous >> 24u)) {
+
+					//channel differences wrap around, as the format says
+					const int8_t dr = (int8_t)(r - (uint8_t)(previous >> 16u));
+					const int8_t dg = (int8_t)(g - (uint8_t)(previous >> 8u));
+					const int8_t db = (int8_t)(b - (uint8_t)previous);
+
+					const int8_t drDg = (int8_t)(dr - dg);
+					const int8_t dbDg = (int8_t)(db - dg);
+
+					if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+
+						*pOut++ = opDiff | (uint8_t)((dr + 2) << 4u | (dg + 2) << 2u | (db + 2));
+					}
+					else if (dg >= -32 && dg <= 31 && drDg >= -8 && drDg <= 7 && dbDg >= -8 && dbDg <= 7) {
+
+						*pOut++ = opLuma | (uint8_t)(dg + 32);
+						*pOut++ = (uint8_t)((drDg + 8) << 4u | (dbDg + 8));
+					}
+					else {
+
+						*pOut++ = opRgb;
+						*pOut++ = r;
+						*pOut++ = g;
+						*pOut++ = b;
+					}
+				}
+				else {
+
+					*pOut++ = opRgba;
+					*pOut++ = r;
+					*pOut++ = g;
+					*pOut++ = b;
+					*pOut++ = (uint8_t)(pixel >> 24u);
+				}
+			}
+
+			previous = pixel;
+		}
+	}
+
+	if (run > 0u) {
+
+		*pOut++ = opRun | (uint8_t)(run - 1u);
+	}
+
+	for (const auto byte : endMarker) {
+
+		*pOut++ = byte;
+	}
+
+	bytes.resize((size_t)(pOut - bytes.data()));
+}
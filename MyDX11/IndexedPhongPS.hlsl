@@ -1,3 +1,5 @@
+#include "ClusteredLights.hlsli"
+
 //constant  buffert for chaning the light position every frame
 cbuffer LightCBuf
 {
@@ -15,7 +17,6 @@ cbuffer ObjectCBuf
 {
     
     float3 materialColor[6];
-    float padding;
     float specularIntensity;
     float specularPower;
 };
@@ -50,7 +51,12 @@ float4 main(float3 worldPos : Position, float3 n : Normal,uint tid:SV_PrimitiveI
     dot(normalize(-r), normalize(worldPos))),
     specularPower);
     
+    //the swarm's lights in this pixel's cluster
+    float3 clusterDiffuse;
+    float3 clusterSpecular;
+    ShadeClusteredLights(worldPos, n, specularPower, clusterDiffuse, clusterSpecular);
+    
     //final color calculation 
-    return float4(saturate((diffuse + ambient + specular) * materialColor[(tid / 2)%6]), 1.0f);
+    return float4(saturate((diffuse + clusterDiffuse + ambient + specular + clusterSpecular * specularIntensity) * materialColor[(tid / 2)%6]), 1.0f);
     
 }
\ No newline at end of file
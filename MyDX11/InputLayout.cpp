@@ -1,5 +1,53 @@
 #include "InputLayout.h"
 #include "GraphicsThrowMacros.h"
+#include <unordered_map>
+#include <sstream>
+
+namespace {
+
+	std::vector<ShaderReflection::InputElement> ToInputElements(const std::vector<D3D11_INPUT_ELEMENT_DESC>& layout)
+	{
+		std::vector<ShaderReflection::InputElement> elements;
+		elements.reserve(layout.size());
+
+		for (const auto& desc : layout) {
+
+			ShaderReflection::InputElement element;
+			element.semanticName = desc.SemanticName;
+			element.semanticIndex = desc.SemanticIndex;
+			element.format = (VertexFormat)desc.Format;
+			element.inputSlot = desc.InputSlot;
+			element.alignedByteOffset = desc.AlignedByteOffset;
+			element.isPerInstance = desc.InputSlotClass == D3D11_INPUT_PER_INSTANCE_DATA;
+			element.instanceStepRate = desc.InstanceDataStepRate;
+
+			elements.push_back(std::move(element));
+		}
+
+		return elements;
+	}
+
+	//the names still point into elements, so it has to outlive the result
+	std::vector<D3D11_INPUT_ELEMENT_DESC> ToD3DLayout(const std::vector<ShaderReflection::InputElement>& elements)
+	{
+		std::vector<D3D11_INPUT_ELEMENT_DESC> layout;
+		layout.reserve(elements.size());
+
+		for (const auto& element : elements) {
+
+			layout.push_back({
+				element.semanticName.c_str(),
+				element.semanticIndex,
+				(DXGI_FORMAT)element.format,
+				element.inputSlot,
+				element.alignedByteOffset,
+				element.isPerInstance ? D3D11_INPUT_PER_INSTANCE_DATA : D3D11_INPUT_PER_VERTEX_DATA,
+				element.instanceStepRate });
+		}
+
+		return layout;
+	}
+}
 
 namespace Bind {
 
@@ -8,6 +56,20 @@ namespace Bind {
 
 		INFOMAN(gfx);
 
+		//check against the shader's input signature first, D3D only says "invalid arg" for a missing semantic
+		const ShaderReflection reflection(pVertexShaderByteCode->GetBufferPointer(), pVertexShaderByteCode->GetBufferSize());
+		const auto problems = reflection.CheckInputLayout(ToInputElements(layout));
+
+		if (ShaderReflection::HasError(problems)) {
+
+			throw ShaderReflection::Exception(__LINE__, __FILE__, "Input layout doesn't fit the vertex shader\n" + ShaderReflection::Describe(problems));
+		}
+
+		if (!problems.empty()) {
+
+			OutputDebugStringA(("[InputLayout]\n" + ShaderReflection::Describe(problems)).c_str());
+		}
+
 		//create InputLayout
 		GFX_THROW_INFO(GetDevice(gfx)->CreateInputLayout(
 			layout.data(),
@@ -19,10 +81,46 @@ namespace Bind {
 
 	}
 
+	std::shared_ptr<InputLayout> InputLayout::Resolve(Graphics& gfx, const std::vector<D3D11_INPUT_ELEMENT_DESC>& layout, ID3DBlob* pVertexShaderByteCode)
+	{
+		//shaders with the same input signature take the same layouts, so the key is the signature hash plus every element
+		const ShaderReflection reflection(pVertexShaderByteCode->GetBufferPointer(), pVertexShaderByteCode->GetBufferSize());
+
+		std::ostringstream key;
+		key << std::hex << reflection.GetInputSignatureHash();
+
+		for (const auto& desc : layout) {
+
+			key << '|' << desc.SemanticName << desc.SemanticIndex << ',' << desc.Format << ',' << desc.InputSlot << ','
+				<< desc.AlignedByteOffset << ',' << desc.InputSlotClass << ',' << desc.InstanceDataStepRate;
+		}
+
+		static std::unordered_map<std::string, std::weak_ptr<InputLayout>> layouts;
+
+		auto& pShared = layouts[key.str()];
+
+		if (auto pLayout = pShared.lock()) {
+
+			return pLayout;
+		}
+
+		auto pLayout = std::make_shared<InputLayout>(gfx, layout, pVertexShaderByteCode);
+		pShared = pLayout;
+		return pLayout;
+	}
+
+	std::shared_ptr<InputLayout> InputLayout::Resolve(Graphics& gfx, ID3DBlob* pVertexShaderByteCode)
+	{
+		const ShaderReflection reflection(pVertexShaderByteCode->GetBufferPointer(), pVertexShaderByteCode->GetBufferSize());
+		const auto elements = reflection.MakeInputLayout();
+
+		return Resolve(gfx, ToD3DLayout(elements), pVertexShaderByteCode);
+	}
+
 	void InputLayout::Bind(Graphics& gfx) noexcept
 	{
 		//Bind input layout
 		GetContext(gfx)->IASetInputLayout(pInputLayout.Get());
 	}
 
-}
\ No newline at end of file
+}
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "Bindable.h"
+#include "ShaderReflection.h"
+#include <memory>
 
 namespace Bind {
 
@@ -9,10 +11,19 @@ namespace Bind {
 	public:
 
 		//Constructor
+		//*throws when the layout is missing something the shader reads, before D3D gets to refuse it
 		InputLayout(Graphics& gfx,
 			const std::vector<D3D11_INPUT_ELEMENT_DESC>& layout,
 			ID3DBlob* pVertexShaderByteCode);
 
+		//one InputLayout per layout and input signature, shared by every shader with that signature
+		static std::shared_ptr<InputLayout> Resolve(Graphics& gfx,
+			const std::vector<D3D11_INPUT_ELEMENT_DESC>& layout,
+			ID3DBlob* pVertexShaderByteCode);
+
+		//the layout generated from the shader's inputs, see ShaderReflection::MakeInputLayout
+		static std::shared_ptr<InputLayout> Resolve(Graphics& gfx, ID3DBlob* pVertexShaderByteCode);
+
 		void Bind(Graphics& gfx) noexcept override;
 
 	protected:
@@ -21,4 +32,4 @@ namespace Bind {
 
 	};
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,78 @@
+#include "InstanceBatcher.h"
+#include <cassert>
+
+void InstanceBatcher::Begin() noexcept
+{
+	m_groupLookup.clear();
+	m_groups.clear();
+	m_instances.clear();
+	m_instanceGroups.clear();
+	m_lastKey = nullptr;
+	m_lastGroup = 0u;
+}
+
+InstanceData& InstanceBatcher::Add(Key key)
+{
+	assert("Instance key must not be null" && key != nullptr);
+
+	if (key != m_lastKey) {
+
+		//first instance of this geometry opens a new group
+		const auto [it, inserted] = m_groupLookup.try_emplace(key, (unsigned int)m_groups.size());
+
+		if (inserted) {
+
+			m_groups.push_back({ key,0u,0u });
+		}
+
+		m_lastKey = key;
+		m_lastGroup = it->second;
+	}
+
+	m_groups[m_lastGroup].count++;
+	m_instanceGroups.push_back(m_lastGroup);
+
+	return m_instances.emplace_back();
+}
+
+void InstanceBatcher::Pack()
+{
+	//group start offsets in first seen order
+	unsigned int offset = 0u;
+	for (auto& g : m_groups) {
+
+		g.start = offset;
+		offset += g.count;
+	}
+
+	//counting sort, instances keep their relative order inside a group
+	m_packed.resize(m_instances.size());
+
+	std::vector<unsigned int> cursor;
+	cursor.reserve(m_groups.size());
+
+	for (const auto& g : m_groups) {
+
+		cursor.push_back(g.start);
+	}
+
+	for (size_t i = 0; i < m_instances.size(); i++) {
+
+		m_packed[cursor[m_instanceGroups[i]]++] = m_instances[i];
+	}
+}
+
+size_t InstanceBatcher::GetInstanceCount() const noexcept
+{
+	return m_instances.size();
+}
+
+const std::vector<InstanceData>& InstanceBatcher::GetPacked() const noexcept
+{
+	return m_packed;
+}
+
+const std::vector<InstanceBatcher::Group>& InstanceBatcher::GetGroups() const noexcept
+{
+	return m_groups;
+}
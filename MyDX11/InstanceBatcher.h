@@ -0,0 +1,64 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <vector>
+#include <unordered_map>
+
+//per instance vertex data (layout matches the Instance struct in the Instanced*VS shaders)
+struct InstanceData {
+
+	DirectX::XMFLOAT4X4 transform;		//model to world, not transposed (read as rows)
+	DirectX::XMFLOAT3 materialColor = { 1.0f,1.0f,1.0f };
+	float specularIntensity = 0.6f;
+	float specularPower = 30.0f;
+	float padding[3];
+};
+
+/// <summary>
+/// Groups instances by the geometry they use and packs them into one contiguous
+/// array (one draw call per group), no graphics device needed
+/// </summary>
+class InstanceBatcher {
+
+public:
+
+	//geometry identity, instances with the same key are drawn together
+	using Key = const void*;
+
+	struct Group {
+
+		Key key;
+		unsigned int start;
+		unsigned int count;
+	};
+
+public:
+
+	//clear last frame's instances but keep allocations
+	void Begin() noexcept;
+
+	//returns the slot the instance data should be written to
+	InstanceData& Add(Key key);
+
+	//sort the instances by group into the packed array
+	void Pack();
+
+	size_t GetInstanceCount() const noexcept;
+	const std::vector<InstanceData>& GetPacked() const noexcept;
+	const std::vector<Group>& GetGroups() const noexcept;
+
+private:
+
+	std::unordered_map<Key, unsigned int> m_groupLookup;
+	std::vector<Group> m_groups;
+
+	//unsorted instances and the group each one belongs to
+	std::vector<InstanceData> m_instances;
+	std::vector<unsigned int> m_instanceGroups;
+
+	std::vector<InstanceData> m_packed;
+
+	//cache of the last looked up group, consecutive adds usually share geometry
+	Key m_lastKey = nullptr;
+	unsigned int m_lastGroup = 0u;
+};
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "Bindable.h"
+#include "GraphicsThrowMacros.h"
+
+namespace Bind {
+
+	//dynamic per instance vertex buffer
+	//*template on the instance struct like ConstantBuffer
+	template<typename T>
+	class InstanceBuffer :public Bindable {
+
+	public:
+
+		InstanceBuffer(Graphics& gfx, UINT capacity, UINT slot = 1u)
+			:
+			slot(slot)
+		{
+			Resize(gfx, capacity);
+		}
+
+		//write this frame's instances, grows the buffer when needed
+		void Update(Graphics& gfx, const std::vector<T>& instances) {
+
+			INFOMAN(gfx);
+
+			if (instances.empty()) {
+
+				return;
+			}
+
+			if (instances.size() > capacity) {
+
+				//grow geometrically so a slowly rising count doesn't recreate every frame
+				Resize(gfx, std::max((UINT)instances.size(), capacity * 2u));
+			}
+
+			D3D11_MAPPED_SUBRESOURCE msr;
+			GFX_THROW_INFO(GetContext(gfx)->Map(
+				pInstanceBuffer.Get(), 0u,
+				D3D11_MAP_WRITE_DISCARD, 0u,
+				&msr
+			));
+
+			memcpy(msr.pData, instances.data(), sizeof(T) * instances.size());
+			GetContext(gfx)->Unmap(pInstanceBuffer.Get(), 0u);
+		}
+
+		//bind to the instance input slot
+		void Bind(Graphics& gfx) noexcept override {
+
+			const UINT stride = sizeof(T);
+			const UINT offset = 0u;
+			GetContext(gfx)->IASetVertexBuffers(slot, 1u, pInstanceBuffer.GetAddressOf(), &stride, &offset);
+		}
+
+		UINT GetCapacity() const noexcept {
+
+			return capacity;
+		}
+
+	private:
+
+		void Resize(Graphics& gfx, UINT newCapacity) {
+
+			INFOMAN(gfx);
+
+			capacity = std::max(newCapacity, 1u);
+
+			D3D11_BUFFER_DESC bd = {};
+			bd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+			bd.Usage = D3D11_USAGE_DYNAMIC;
+			bd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+			bd.MiscFlags = 0u;
+			bd.ByteWidth = UINT(sizeof(T) * capacity);
+			bd.StructureByteStride = sizeof(T);
+
+			pInstanceBuffer.Reset();
+			GFX_THROW_INFO(GetDevice(gfx)->CreateBuffer(&bd, nullptr, &pInstanceBuffer));
+		}
+
+	protected:
+
+		UINT slot;
+		UINT capacity = 0u;
+		Microsoft::WRL::ComPtr<ID3D11Buffer> pInstanceBuffer;
+	};
+
+}
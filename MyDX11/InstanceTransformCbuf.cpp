@@ -0,0 +1,32 @@
+#include "InstanceTransformCbuf.h"
+
+
+namespace Bind {
+
+	InstanceTransformCbuf::InstanceTransformCbuf(Graphics& gfx, UINT slot)
+	{
+
+		//Check the constant buffer has been allocated yet or not
+		if (!pVcbuf) {
+
+			pVcbuf = std::make_unique<VertexConstantBuffer<Transforms>>(gfx, slot);
+		}
+
+	}
+
+	void InstanceTransformCbuf::Bind(Graphics& gfx) noexcept
+	{
+
+		const Transforms transforms = {
+			DirectX::XMMatrixTranspose(gfx.GetCamera()),
+			DirectX::XMMatrixTranspose(gfx.GetCamera() * gfx.GetProjection())
+		};
+
+		pVcbuf->Update(gfx, transforms);
+		pVcbuf->Bind(gfx);
+	}
+
+	//Declaration for static variable
+	std::unique_ptr<VertexConstantBuffer<InstanceTransformCbuf::Transforms>> InstanceTransformCbuf::pVcbuf;
+
+}
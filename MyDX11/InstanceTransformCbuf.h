@@ -0,0 +1,32 @@
+#pragma once
+
+#include "ConstantBuffers.h"
+#include <DirectXMath.h>
+
+namespace Bind {
+
+	//per frame camera constants for the instanced vertex shaders
+	//(the model transform comes from the instance buffer)
+	class InstanceTransformCbuf :public Bindable {
+
+	private:
+
+		struct Transforms {
+
+			DirectX::XMMATRIX view;
+			DirectX::XMMATRIX viewProj;
+		};
+
+	public:
+
+		InstanceTransformCbuf(Graphics& gfx, UINT slot = 0u);
+		void Bind(Graphics& gfx) noexcept override;
+
+	private:
+
+		//dynamic allocated static VertexConstantBuffer shared by every instanced mesh
+		static std::unique_ptr<VertexConstantBuffer<Transforms>> pVcbuf;
+
+	};
+
+}
@@ -0,0 +1,41 @@
+#include "InstancedMesh.h"
+#include "InstanceTransformCbuf.h"
+#include "InstanceBatcher.h"
+
+using namespace Bind;
+
+InstancedMesh::InstancedMesh(Graphics& gfx, std::vector<std::shared_ptr<Bindable>> bindPtrs)
+{
+
+	//test object geometry is all trianglelist
+	AddBind(std::make_shared<Topology>(gfx, D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST));
+
+	for (auto& pb : bindPtrs) {
+
+		AddBind(std::move(pb));
+	}
+
+	AddBind(std::make_shared<InstanceTransformCbuf>(gfx));
+}
+
+DirectX::XMMATRIX InstancedMesh::GetTransformXM() const noexcept
+{
+	return DirectX::XMMatrixIdentity();
+}
+
+std::vector<D3D11_INPUT_ELEMENT_DESC> InstancedMesh::WithInstanceLayout(std::vector<D3D11_INPUT_ELEMENT_DESC> layout)
+{
+	//matches InstanceData, stepped once per instance from slot 1
+	const D3D11_INPUT_ELEMENT_DESC instanceElements[] = {
+
+		{"InstanceTransform",0,DXGI_FORMAT_R32G32B32A32_FLOAT,1,offsetof(InstanceData,transform) + 0u,D3D11_INPUT_PER_INSTANCE_DATA,1},
+		{"InstanceTransform",1,DXGI_FORMAT_R32G32B32A32_FLOAT,1,offsetof(InstanceData,transform) + 16u,D3D11_INPUT_PER_INSTANCE_DATA,1},
+		{"InstanceTransform",2,DXGI_FORMAT_R32G32B32A32_FLOAT,1,offsetof(InstanceData,transform) + 32u,D3D11_INPUT_PER_INSTANCE_DATA,1},
+		{"InstanceTransform",3,DXGI_FORMAT_R32G32B32A32_FLOAT,1,offsetof(InstanceData,transform) + 48u,D3D11_INPUT_PER_INSTANCE_DATA,1},
+		{"InstanceMaterial",0,DXGI_FORMAT_R32G32B32A32_FLOAT,1,offsetof(InstanceData,materialColor),D3D11_INPUT_PER_INSTANCE_DATA,1},
+		{"InstanceSpecular",0,DXGI_FORMAT_R32_FLOAT,1,offsetof(InstanceData,specularPower),D3D11_INPUT_PER_INSTANCE_DATA,1},
+	};
+
+	layout.insert(layout.end(), std::begin(instanceElements), std::end(instanceElements));
+	return layout;
+}
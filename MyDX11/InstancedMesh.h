@@ -0,0 +1,24 @@
+#pragma once
+
+#include "Drawable.h"
+#include "BindableBase.h"
+#include <memory>
+
+/// <summary>
+/// Geometry drawn once per group of instances, the per instance transforms
+/// and materials come from the instance buffer bound to slot 1
+/// </summary>
+class InstancedMesh :public Drawable, public std::enable_shared_from_this<InstancedMesh> {
+
+public:
+
+	//constructor
+	InstancedMesh(Graphics& gfx, std::vector<std::shared_ptr<Bind::Bindable>> bindPtrs);
+
+	//instances are positioned by the instance buffer
+	DirectX::XMMATRIX GetTransformXM() const noexcept override;
+
+	//append the per instance elements (InstanceData) to a vertex layout
+	static std::vector<D3D11_INPUT_ELEMENT_DESC> WithInstanceLayout(std::vector<D3D11_INPUT_ELEMENT_DESC> layout);
+
+};
@@ -0,0 +1,57 @@
+#include "ClusteredLights.hlsli"
+
+//constant  buffert for chaning the light position every frame
+cbuffer LightCBuf
+{
+    
+    float3 lightPos;
+    float3 ambient;
+    float3 diffuseColor;
+    float diffuseIntensity;
+    float attConst;
+    float attLin;
+    float attQuad;
+};
+
+//taking position, normal and the per instance material of the pixel
+float4 main(float3 worldPos : Position, float3 n : Normal, float3 materialColor : MaterialColor, float2 specularParams : Specular) : SV_Target
+{
+    const float specularIntensity = specularParams.x;
+    const float specularPower = specularParams.y;
+    
+    //fragment to light vector data
+    const float3 vToL = lightPos - worldPos;    //vector to light
+    const float distToL = length(vToL);         //
+    const float3 dirToL = vToL / distToL;       //direction to light
+    
+    //diffuse attenuation
+    const float att = 1.0f / (attConst + attLin * distToL + attQuad * (distToL * distToL));
+    
+    //diffuse intensity base on dot product
+    const float3 diffuse = diffuseColor * diffuseIntensity * att * max(0.0f, dot(dirToL, n));
+    
+    //reflected light vector
+    const float3 w = n * dot(vToL, n);
+    
+    const float3 r = w * 2.0f - vToL;
+    
+    //calculate specular intensity based on angle 
+    //between viewing vector
+    //and refelction vector,
+    //narrow with power function
+    const float3 specular = att *
+    (diffuseColor * diffuseIntensity) *
+    specularIntensity *
+    pow(max(0.0f, 
+    dot(normalize(-r), normalize(worldPos))), 
+    specularPower);
+    
+    //the swarm's lights in this pixel's cluster
+    float3 clusterDiffuse;
+    float3 clusterSpecular;
+    ShadeClusteredLights(worldPos, n, specularPower, clusterDiffuse, clusterSpecular);
+    
+    //final color calculation 
+    return float4(saturate((diffuse + clusterDiffuse + ambient + specular + clusterSpecular * specularIntensity) * materialColor), 1.0f);
+    
+}
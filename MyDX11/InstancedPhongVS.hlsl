@@ -0,0 +1,48 @@
+//per frame camera constant buffer (shared by all instances)
+cbuffer CBuf
+{
+    matrix view;            //world to view transform
+    matrix viewProj;        //concatenated view projection
+};
+
+//per instance data streamed from the instance buffer
+struct Instance
+{
+    float4 row0 : InstanceTransform0;
+    float4 row1 : InstanceTransform1;
+    float4 row2 : InstanceTransform2;
+    float4 row3 : InstanceTransform3;
+    float4 material : InstanceMaterial;     //rgb color + specular intensity
+    float specularPower : InstanceSpecular;
+};
+
+struct VSOut
+{
+    float3 worldPos : Position;
+    float3 normal : Normal;
+    float3 materialColor : MaterialColor;
+    float2 specular : Specular;
+    float4 pos : SV_Position;
+};
+
+VSOut main(float3 pos : Position, float3 n : Normal, Instance inst)
+{
+    VSOut vso;
+    
+    const matrix model = matrix(inst.row0, inst.row1, inst.row2, inst.row3);
+    const float4 world = mul(float4(pos, 1.0f), model);
+    
+    //calculate the view space position of the pixel
+    vso.worldPos = (float3) mul(world, view);
+    
+    //
+    vso.normal = mul(mul(n, (float3x3) model), (float3x3) view);
+    
+    //
+    vso.pos = mul(world, viewProj);
+    
+    vso.materialColor = inst.material.rgb;
+    vso.specular = float2(inst.material.a, inst.specularPower);
+    
+    return vso;
+}
@@ -0,0 +1,33 @@
+cbuffer CBuf
+{
+    matrix view;
+    matrix viewProj;
+};
+
+struct Instance
+{
+    float4 row0 : InstanceTransform0;
+    float4 row1 : InstanceTransform1;
+    float4 row2 : InstanceTransform2;
+    float4 row3 : InstanceTransform3;
+};
+
+struct VSOut
+{
+    float3 worldPos : Position;
+    float3 normal : Normal;
+    float2 tc : Texcoord;
+    float4 pos : SV_Position;
+};
+
+VSOut main(float3 pos : Position, float3 n : Normal, float2 tc : Texcoord, Instance inst)
+{
+    VSOut vso;
+    const matrix model = matrix(inst.row0, inst.row1, inst.row2, inst.row3);
+    const float4 world = mul(float4(pos, 1.0f), model);
+    vso.worldPos = (float3) mul(world, view);
+    vso.normal = mul(mul(n, (float3x3) model), (float3x3) view);
+    vso.pos = mul(world, viewProj);
+    vso.tc = tc;
+    return vso;
+}
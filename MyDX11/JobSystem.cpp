@@ -0,0 +1,318 @@
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cassert>
+
+namespace {
+
+	//which system and deque the current thread belongs to (workers only)
+	thread_local const JobSystem* tl_pOwner = nullptr;
+	thread_local size_t tl_queue = 0u;
+}
+
+/// <summary>
+/// Counter
+/// </summary>
+
+JobSystem::Counter::~Counter()
+{
+	assert("Counter destroyed while jobs are still pending" && pending == 0);
+}
+
+bool JobSystem::Counter::IsDone() const noexcept
+{
+	return pending.load(std::memory_order_acquire) == 0;
+}
+
+
+/// <summary>
+/// JobSystem
+/// </summary>
+
+JobSystem::JobSystem(unsigned int nWorkers)
+{
+	if (nWorkers == 0u) {
+
+		nWorkers = std::max(1u, std::thread::hardware_concurrency()) - 1u;
+	}
+
+	//deque 0 belongs to the external threads
+	for (unsigned int i = 0; i <= nWorkers; i++) {
+
+		m_queues.push_back(std::make_unique<Queue>());
+	}
+
+	m_workers.reserve(nWorkers);
+
+	for (unsigned int i = 1; i <= nWorkers; i++) {
+
+		m_workers.emplace_back(&JobSystem::WorkerLoop, this, (size_t)i);
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMtx);
+		m_isQuitting = true;
+	}
+
+	m_wake.notify_all();
+
+	for (auto& t : m_workers) {
+
+		t.join();
+	}
+}
+
+void JobSystem::Run(Job job, Counter& counter)
+{
+	counter.pending.fetch_add(1, std::memory_order_relaxed);
+
+	Push({ std::move(job),&counter });
+	WakeWorkers(1u);
+}
+
+void JobSystem::RunAfter(Counter& dependency, Job job, Counter& counter)
+{
+	//counted now so waiting on counter also covers the deferred job
+	counter.pending.fetch_add(1, std::memory_order_relaxed);
+
+	{
+		std::lock_guard<std::mutex> lock(dependency.mtx);
+
+		if (!dependency.IsDone()) {
+
+			dependency.continuations.push_back({ std::move(job),&counter });
+			return;
+		}
+	}
+
+	Push({ std::move(job),&counter });
+	WakeWorkers(1u);
+}
+
+void JobSystem::Wait(Counter& counter)
+{
+	while (!counter.IsDone()) {
+
+		//help instead of blocking, yield only when nothing is queued anywhere
+		if (!TryRunOne()) {
+
+			std::this_thread::yield();
+		}
+	}
+
+	std::exception_ptr error;
+	{
+		std::lock_guard<std::mutex> lock(counter.mtx);
+		std::swap(error, counter.error);
+	}
+
+	if (error) {
+
+		std::rethrow_exception(error);
+	}
+}
+
+void JobSystem::ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t first, size_t last)>& func)
+{
+	if (count == 0u) {
+
+		return;
+	}
+
+	grainSize = std::max<size_t>(grainSize, 1u);
+
+	//nothing to split, skip the queues entirely
+	if (count <= grainSize || m_workers.empty()) {
+
+		func(0u, count);
+		return;
+	}
+
+	Counter counter;
+	size_t nJobs = 0u;
+
+	for (size_t first = 0; first < count; first += grainSize) {
+
+		const auto last = std::min(first + grainSize, count);
+
+		counter.pending.fetch_add(1, std::memory_order_relaxed);
+		Push({ [&func,first,last]() { func(first,last); },&counter });
+		nJobs++;
+	}
+
+	WakeWorkers(nJobs);
+	Wait(counter);
+}
+
+unsigned int JobSystem::GetThreadCount() const noexcept
+{
+	return (unsigned int)m_workers.size() + 1u;
+}
+
+size_t JobSystem::GetQueueIndex() const noexcept
+{
+	return tl_pOwner == this ? tl_queue : 0u;
+}
+
+void JobSystem::Push(Task task)
+{
+	auto& queue = *m_queues[GetQueueIndex()];
+
+	{
+		std::lock_guard<std::mutex> lock(queue.mtx);
+		queue.tasks.push_back(std::move(task));
+	}
+
+	m_queued.fetch_add(1, std::memory_order_release);
+}
+
+void JobSystem::WakeWorkers(size_t count) noexcept
+{
+	//taking the lock orders the push before a worker's sleep check (no lost wakeups)
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMtx);
+	}
+
+	if (count == 1u) {
+
+		m_wake.notify_one();
+	}
+	else {
+
+		m_wake.notify_all();
+	}
+}
+
+bool JobSystem::TryPop(size_t queueIndex, Task& task)
+{
+	auto& queue = *m_queues[queueIndex];
+	std::lock_guard<std::mutex> lock(queue.mtx);
+
+	if (queue.tasks.empty()) {
+
+		return false;
+	}
+
+	//newest first, it is most likely still in this core's cache
+	task = std::move(queue.tasks.back());
+	queue.tasks.pop_back();
+	m_queued.fetch_sub(1, std::memory_order_relaxed);
+
+	return true;
+}
+
+bool JobSystem::TrySteal(size_t thief, Task& task)
+{
+	const size_t nQueues = m_queues.size();
+
+	for (size_t i = 1; i < nQueues; i++) {
+
+		auto& queue = *m_queues[(thief + i) % nQueues];
+		std::lock_guard<std::mutex> lock(queue.mtx);
+
+		if (queue.tasks.empty()) {
+
+			continue;
+		}
+
+		//oldest job, usually the biggest untouched piece of work
+		task = std::move(queue.tasks.front());
+		queue.tasks.pop_front();
+		m_queued.fetch_sub(1, std::memory_order_relaxed);
+
+		return true;
+	}
+
+	return false;
+}
+
+bool JobSystem::TryRunOne()
+{
+	const size_t self = GetQueueIndex();
+	Task task;
+
+	if (!TryPop(self, task) && !TrySteal(self, task)) {
+
+		return false;
+	}
+
+	Execute(task);
+	return true;
+}
+
+void JobSystem::Execute(Task& task) noexcept
+{
+	try {
+
+		task.job();
+	}
+	catch (...) {
+
+		std::lock_guard<std::mutex> lock(task.pCounter->mtx);
+
+		if (!task.pCounter->error) {
+
+			task.pCounter->error = std::current_exception();
+		}
+	}
+
+	Finish(*task.pCounter);
+}
+
+void JobSystem::Finish(Counter& counter)
+{
+	std::vector<Counter::Continuation> continuations;
+
+	//decrement under the lock, Wait locks it too before returning
+	//*so the counter can't be destroyed while this is still touching it
+	{
+		std::lock_guard<std::mutex> lock(counter.mtx);
+
+		if (counter.pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+
+			//last job done, release whatever was chained onto this counter
+			std::swap(continuations, counter.continuations);
+		}
+	}
+
+	for (auto& c : continuations) {
+
+		Push({ std::move(c.job),c.pCounter });
+	}
+
+	if (!continuations.empty()) {
+
+		WakeWorkers(continuations.size());
+	}
+}
+
+void JobSystem::WorkerLoop(size_t queue)
+{
+	tl_pOwner = this;
+	tl_queue = queue;
+
+	PROFILE_THREAD("Job " + std::to_string(queue));
+
+	while (true) {
+
+		if (TryRunOne()) {
+
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_sleepMtx);
+
+		m_wake.wait(lock, [this]() {
+
+			return m_isQuitting || m_queued.load(std::memory_order_acquire) > 0;
+		});
+
+		if (m_isQuitting) {
+
+			return;
+		}
+	}
+}
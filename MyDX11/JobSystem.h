@@ -0,0 +1,115 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <exception>
+
+/// <summary>
+/// Fixed pool of worker threads pulling jobs from per thread deques
+/// owners pop their newest job, idle threads steal the oldest job from someone else
+/// threads that wait on a counter run queued jobs instead of blocking
+/// </summary>
+class JobSystem {
+
+public:
+
+	using Job = std::function<void()>;
+
+	//number of unfinished jobs tied to it, jobs can be chained onto a counter reaching zero
+	class Counter {
+
+		friend class JobSystem;
+
+	public:
+
+		Counter() = default;
+		Counter(const Counter&) = delete;
+		Counter& operator=(const Counter&) = delete;
+		~Counter();
+
+		bool IsDone() const noexcept;
+
+	private:
+
+		struct Continuation {
+
+			Job job;
+			Counter* pCounter;
+		};
+
+	private:
+
+		std::atomic<int> pending = 0;
+
+		//guards continuations and error
+		std::mutex mtx;
+		std::vector<Continuation> continuations;
+
+		//first exception thrown by one of the jobs, rethrown by Wait
+		std::exception_ptr error;
+	};
+
+public:
+
+	//nWorkers == 0 uses one worker per hardware thread besides the calling one
+	explicit JobSystem(unsigned int nWorkers = 0u);
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+	~JobSystem();
+
+	void Run(Job job, Counter& counter);
+
+	//job is queued once dependency reaches zero (immediately if it already has)
+	void RunAfter(Counter& dependency, Job job, Counter& counter);
+
+	//runs queued jobs on the calling thread until the counter reaches zero
+	void Wait(Counter& counter);
+
+	//splits [0,count) into ranges of grainSize and waits for all of them
+	void ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t first, size_t last)>& func);
+
+	//workers plus the thread that waits
+	unsigned int GetThreadCount() const noexcept;
+
+private:
+
+	struct Task {
+
+		Job job;
+		Counter* pCounter;
+	};
+
+	//deque 0 is shared by every thread that isn't a worker
+	struct Queue {
+
+		std::mutex mtx;
+		std::deque<Task> tasks;
+	};
+
+	void Push(Task task);
+	void WakeWorkers(size_t count) noexcept;
+	bool TryPop(size_t queue, Task& task);
+	bool TrySteal(size_t thief, Task& task);
+	bool TryRunOne();
+	void Execute(Task& task) noexcept;
+	void Finish(Counter& counter);
+	void WorkerLoop(size_t queue);
+	size_t GetQueueIndex() const noexcept;
+
+private:
+
+	std::vector<std::unique_ptr<Queue>> m_queues;
+	std::vector<std::thread> m_workers;
+
+	//sleeping workers wake when jobs are queued
+	std::atomic<int> m_queued = 0;
+	std::atomic<bool> m_isQuitting = false;
+	std::mutex m_sleepMtx;
+	std::condition_variable m_wake;
+};
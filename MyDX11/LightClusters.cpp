@@ -0,0 +1,481 @@
+#include "LightClusters.h"
+#include <emmintrin.h>
+#include <immintrin.h>
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <sstream>
+
+#ifdef _MSC_VER
+//msvc compiles intrinsics of any level anywhere, gcc and clang need the target per function
+#define AVX2_KERNEL
+#else
+#define AVX2_KERNEL __attribute__((target("avx2")))
+#endif
+
+namespace {
+
+	//planes are tested in registers of 8, the most any kernel takes at once
+	constexpr unsigned int planeBlock = 8u;
+	//relative depth slices are widened by when testing lights against them
+	constexpr float sliceMargin = 1.0e-4f;
+
+	//bit i of above is set when part of the box [uMin,uMax] x [zMin,zMax] is on the positive side of plane i, of below when part is on the negative side
+	using PlaneKernel = void(*)(const float* pA, const float* pB, unsigned int count, float uMin, float uMax, float zMin, float zMax, uint64_t& above, uint64_t& below);
+
+	void PlanesScalar(const float* pA, const float* pB, unsigned int count, float uMin, float uMax, float zMin, float zMax, uint64_t& above, uint64_t& below)
+	{
+		above = 0u;
+		below = 0u;
+
+		for (unsigned int i = 0; i < count; i++) {
+
+			//furthest corners along the normal and against it
+			const float far = std::max(pA[i] * uMin, pA[i] * uMax) + std::max(pB[i] * zMin, pB[i] * zMax);
+			const float near = std::min(pA[i] * uMin, pA[i] * uMax) + std::min(pB[i] * zMin, pB[i] * zMax);
+
+			above |= (uint64_t)(far >= 0.0f) << i;
+			below |= (uint64_t)(near <= 0.0f) << i;
+		}
+	}
+
+	void PlanesSse2(const float* pA, const float* pB, unsigned int count, float uMin, float uMax, float zMin, float zMax, uint64_t& above, uint64_t& below)
+	{
+		const __m128 vUMin = _mm_set1_ps(uMin);
+		const __m128 vUMax = _mm_set1_ps(uMax);
+		const __m128 vZMin = _mm_set1_ps(zMin);
+		const __m128 vZMax = _mm_set1_ps(zMax);
+		const __m128 zero = _mm_setzero_ps();
+
+		above = 0u;
+		below = 0u;
+
+		for (unsigned int i = 0; i < count; i += 4u) {
+
+			const __m128 a = _mm_loadu_ps(pA + i);
+			const __m128 b = _mm_loadu_ps(pB + i);
+			const __m128 au0 = _mm_mul_ps(a, vUMin);
+			const __m128 au1 = _mm_mul_ps(a, vUMax);
+			const __m128 bz0 = _mm_mul_ps(b, vZMin);
+			const __m128 bz1 = _mm_mul_ps(b, vZMax);
+
+			const __m128 far = _mm_add_ps(_mm_max_ps(au0, au1), _mm_max_ps(bz0, bz1));
+			const __m128 near = _mm_add_ps(_mm_min_ps(au0, au1), _mm_min_ps(bz0, bz1));
+
+			above |= (uint64_t)_mm_movemask_ps(_mm_cmpge_ps(far, zero)) << i;
+			below |= (uint64_t)_mm_movemask_ps(_mm_cmple_ps(near, zero)) << i;
+		}
+	}
+
+	AVX2_KERNEL void PlanesAvx2(const float* pA, const float* pB, unsigned int count, float uMin, float uMax, float zMin, float zMax, uint64_t& above, uint64_t& below)
+	{
+		const __m256 vUMin = _mm256_set1_ps(uMin);
+		const __m256 vUMax = _mm256_set1_ps(uMax);
+		const __m256 vZMin = _mm256_set1_ps(zMin);
+		const __m256 vZMax = _mm256_set1_ps(zMax);
+		const __m256 zero = _mm256_setzero_ps();
+
+		above = 0u;
+		below = 0u;
+
+		for (unsigned int i = 0; i < count; i += 8u) {
+
+			const __m256 a = _mm256_loadu_ps(pA + i);
+			const __m256 b = _mm256_loadu_ps(pB + i);
+			const __m256 au0 = _mm256_mul_ps(a, vUMin);
+			const __m256 au1 = _mm256_mul_ps(a, vUMax);
+			const __m256 bz0 = _mm256_mul_ps(b, vZMin);
+			const __m256 bz1 = _mm256_mul_ps(b, vZMax);
+
+			const __m256 far = _mm256_add_ps(_mm256_max_ps(au0, au1), _mm256_max_ps(bz0, bz1));
+			const __m256 near = _mm256_add_ps(_mm256_min_ps(au0, au1), _mm256_min_ps(bz0, bz1));
+
+			above |= (uint64_t)_mm256_movemask_ps(_mm256_cmp_ps(far, zero, _CMP_GE_OQ)) << i;
+			below |= (uint64_t)_mm256_movemask_ps(_mm256_cmp_ps(near, zero, _CMP_LE_OQ)) << i;
+		}
+	}
+
+	constexpr PlaneKernel planeKernels[] = { PlanesScalar,PlanesSse2,PlanesAvx2 };
+}
+
+
+LightClusters::LightClusters(unsigned int tilesX, unsigned int tilesY, unsigned int slices)
+	:
+	m_isa(PixelKernels::GetIsa())
+{
+	Resize(tilesX, tilesY, slices);
+}
+
+void LightClusters::Resize(unsigned int tilesX, unsigned int tilesY, unsigned int slices)
+{
+	if (tilesX == 0u || tilesY == 0u || slices == 0u || tilesX > maxTiles || tilesY > maxTiles) {
+
+		std::ostringstream oss;
+		oss << "Cluster grid of " << tilesX << "x" << tilesY << "x" << slices << " is empty or has more than " << maxTiles << " tiles along a side";
+
+		throw Exception(__LINE__, __FILE__, oss.str());
+	}
+
+	m_tilesX = tilesX;
+	m_tilesY = tilesY;
+	m_slices = slices;
+
+	//every slice starts out with empty clusters, Pack always has lists to join
+	m_sliceLists.assign(slices, {});
+
+	for (auto& slice : m_sliceLists) {
+
+		slice.ranges.assign((size_t)tilesX * tilesY, Range{ 0u,0u });
+	}
+
+	m_ranges.assign(GetClusterCount(), Range{ 0u,0u });
+	m_indices.clear();
+	m_stats = {};
+
+	SetUpGrid();
+}
+
+unsigned int LightClusters::GetTilesX() const noexcept
+{
+	return m_tilesX;
+}
+
+unsigned int LightClusters::GetTilesY() const noexcept
+{
+	return m_tilesY;
+}
+
+unsigned int LightClusters::GetSliceCount() const noexcept
+{
+	return m_slices;
+}
+
+size_t LightClusters::GetClusterCount() const noexcept
+{
+	return (size_t)m_tilesX * m_tilesY * m_slices;
+}
+
+void LightClusters::SetProjection(const DirectX::XMFLOAT4X4& projection)
+{
+	//z' = z * _33 + _43 and w' = z, so depth 0 is at -_43/_33 and depth 1 at _43/(1-_33)
+	const bool isPerspective = projection._34 == 1.0f && projection._44 == 0.0f && projection._33 > 1.0f && projection._43 < 0.0f;
+
+	if (!isPerspective || projection._11 <= 0.0f || projection._22 <= 0.0f) {
+
+		throw Exception(__LINE__, __FILE__, "Clusters need a left handed perspective projection with D3D depth");
+	}
+
+	m_near = -projection._43 / projection._33;
+	m_far = projection._43 / (1.0f - projection._33);
+	m_projectionScale = { projection._11,projection._22 };
+
+	SetUpGrid();
+}
+
+DirectX::XMFLOAT2 LightClusters::GetProjectionScale() const noexcept
+{
+	return m_projectionScale;
+}
+
+float LightClusters::GetSliceScale() const noexcept
+{
+	return m_sliceScale;
+}
+
+float LightClusters::GetSliceBias() const noexcept
+{
+	return m_sliceBias;
+}
+
+size_t LightClusters::GetClusterIndex(const DirectX::XMFLOAT3& point) const noexcept
+{
+	const float z = std::max(point.z, m_near);
+
+	const auto getTile = [z](float u, float scale, unsigned int tiles) {
+
+		const float tile = std::floor((u * scale / z * 0.5f + 0.5f) * tiles);
+
+		return (size_t)std::clamp(tile, 0.0f, (float)(tiles - 1u));
+	};
+
+	const size_t column = getTile(point.x, m_projectionScale.x, m_tilesX);
+	const size_t row = getTile(point.y, m_projectionScale.y, m_tilesY);
+
+	return ((size_t)GetSlice(z) * m_tilesY + row) * m_tilesX + column;
+}
+
+void LightClusters::Begin(const std::vector<Light>& lights)
+{
+	if (lights.size() > maxLights) {
+
+		throw Exception(__LINE__, __FILE__, std::to_string(lights.size()) + " lights, cluster indices only reach " + std::to_string(maxLights));
+	}
+
+	m_footprints.resize(lights.size());
+
+	for (auto& slice : m_sliceLists) {
+
+		slice.lights.clear();
+	}
+
+	m_stats = {};
+	m_stats.lights = lights.size();
+
+	for (size_t i = 0; i < lights.size(); i++) {
+
+		const Light& light = lights[i];
+		Footprint& footprint = m_footprints[i];
+
+		footprint = { light,0u,0u };
+
+		const float zMin = std::max(light.center.z - light.radius, m_near);
+		const float zMax = std::min(light.center.z + light.radius, m_far);
+
+		if (zMin > zMax) {
+
+			continue;
+		}
+
+		//tiles of the whole light, each slice narrows them down to the part of the light inside it
+		footprint.columns = GetTileMask(m_columns, m_tilesX, light.center.x - light.radius, light.center.x + light.radius, zMin, zMax);
+		footprint.rows = GetTileMask(m_rows, m_tilesY, light.center.y - light.radius, light.center.y + light.radius, zMin, zMax);
+
+		if (footprint.columns == 0u || footprint.rows == 0u) {
+
+			continue;
+		}
+
+		const unsigned int lastSlice = GetSlice(zMax);
+
+		for (unsigned int s = GetSlice(zMin); s <= lastSlice; s++) {
+
+			m_sliceLists[s].lights.push_back((uint16_t)i);
+		}
+
+		m_stats.visibleLights++;
+	}
+}
+
+void LightClusters::Assign(size_t firstSlice, size_t lastSlice)
+{
+	const size_t tiles = (size_t)m_tilesX * m_tilesY;
+
+	for (size_t s = firstSlice; s < lastSlice; s++) {
+
+		Slice& slice = m_sliceLists[s];
+		slice.ranges.assign(tiles, Range{ 0u,0u });
+		slice.masks.resize(slice.lights.size());
+
+		//a hair past the slice's ends, the shaders' log2 can round a pixel on the edge either way
+		const float sliceNear = m_sliceDepths[s] * (1.0f - sliceMargin);
+		const float sliceFar = m_sliceDepths[s + 1u] * (1.0f + sliceMargin);
+
+		//counted first so every cluster's list can go straight into its place
+		for (size_t k = 0; k < slice.lights.size(); k++) {
+
+			const Footprint& footprint = m_footprints[slice.lights[k]];
+			const Light& light = footprint.light;
+
+			//box around the part of the light in the slice, it's widest at the depth nearest the center
+			const float zMin = std::min(std::max(light.center.z - light.radius, sliceNear), sliceFar);
+			const float zMax = std::max(std::min(light.center.z + light.radius, sliceFar), zMin);
+			const float dz = light.center.z < zMin ? zMin - light.center.z : std::max(light.center.z - zMax, 0.0f);
+			const float radius = std::sqrt(std::max(light.radius * light.radius - dz * dz, 0.0f));
+
+			const uint32_t columns = footprint.columns & GetTileMask(m_columns, m_tilesX, light.center.x - radius, light.center.x + radius, zMin, zMax);
+			const uint32_t rows = footprint.rows & GetTileMask(m_rows, m_tilesY, light.center.y - radius, light.center.y + radius, zMin, zMax);
+
+			slice.masks[k] = { rows != 0u ? columns : 0u,rows };
+
+			for (uint32_t r = rows; r != 0u && columns != 0u; r &= r - 1u) {
+
+				Range* pRow = slice.ranges.data() + (size_t)std::countr_zero(r) * m_tilesX;
+
+				for (uint32_t c = columns; c != 0u; c &= c - 1u) {
+
+					pRow[std::countr_zero(c)].count++;
+				}
+			}
+		}
+
+		uint32_t offset = 0u;
+
+		for (Range& range : slice.ranges) {
+
+			range.offset = offset;
+			offset += range.count;
+			range.count = 0u;
+		}
+
+		slice.indices.resize(offset);
+
+		for (size_t k = 0; k < slice.lights.size(); k++) {
+
+			const auto [columns, rows] = slice.masks[k];
+
+			for (uint32_t r = rows; r != 0u && columns != 0u; r &= r - 1u) {
+
+				Range* pRow = slice.ranges.data() + (size_t)std::countr_zero(r) * m_tilesX;
+
+				for (uint32_t c = columns; c != 0u; c &= c - 1u) {
+
+					Range& range = pRow[std::countr_zero(c)];
+					slice.indices[range.offset + range.count++] = slice.lights[k];
+				}
+			}
+		}
+	}
+}
+
+void LightClusters::Assign()
+{
+	Assign(0u, m_slices);
+}
+
+void LightClusters::Pack()
+{
+	const size_t tiles = (size_t)m_tilesX * m_tilesY;
+
+	size_t total = 0u;
+
+	for (const auto& slice : m_sliceLists) {
+
+		total += slice.indices.size();
+	}
+
+	m_ranges.resize(GetClusterCount());
+	m_indices.resize(total);
+
+	uint32_t base = 0u;
+	uint32_t maxCount = 0u;
+
+	for (size_t s = 0; s < m_slices; s++) {
+
+		const Slice& slice = m_sliceLists[s];
+
+		for (size_t k = 0; k < tiles; k++) {
+
+			const Range& range = slice.ranges[k];
+
+			m_ranges[s * tiles + k] = { base + range.offset,range.count };
+			maxCount = std::max(maxCount, range.count);
+		}
+
+		std::copy(slice.indices.begin(), slice.indices.end(), m_indices.begin() + base);
+		base += (uint32_t)slice.indices.size();
+	}
+
+	m_stats.indices = total;
+	m_stats.maxClusterLights = maxCount;
+}
+
+const std::vector<LightClusters::Range>& LightClusters::GetRanges() const noexcept
+{
+	return m_ranges;
+}
+
+const std::vector<uint16_t>& LightClusters::GetIndices() const noexcept
+{
+	return m_indices;
+}
+
+const LightClusters::Stats& LightClusters::GetStats() const noexcept
+{
+	return m_stats;
+}
+
+void LightClusters::SetIsa(PixelKernels::Isa isa) noexcept
+{
+	m_isa = std::min(isa, PixelKernels::GetSupportedIsa());
+}
+
+PixelKernels::Isa LightClusters::GetIsa() const noexcept
+{
+	return m_isa;
+}
+
+void LightClusters::SetUpGrid()
+{
+	SetBoundaries(m_columns, m_tilesX, m_projectionScale.x);
+	SetBoundaries(m_rows, m_tilesY, m_projectionScale.y);
+
+	//slice k starts at near * (far/near)^(k/slices)
+	m_sliceScale = (float)m_slices / std::log2(m_far / m_near);
+	m_sliceBias = -std::log2(m_near) * m_sliceScale;
+
+	m_sliceDepths.resize(m_slices + 1u);
+
+	for (unsigned int k = 0; k <= m_slices; k++) {
+
+		m_sliceDepths[k] = m_near * std::pow(m_far / m_near, (float)k / (float)m_slices);
+	}
+}
+
+void LightClusters::SetBoundaries(Boundaries& boundaries, unsigned int tiles, float scale)
+{
+	//boundary i is where u * scale / z is -1 + 2i/tiles, points between i and i+1 are on the positive side of i and the negative side of i+1
+	boundaries.count = tiles + 1u;
+
+	const size_t padded = (boundaries.count + planeBlock - 1u) / planeBlock * planeBlock;
+
+	boundaries.a.assign(padded, 0.0f);
+	boundaries.b.assign(padded, 0.0f);
+
+	for (unsigned int i = 0; i < boundaries.count; i++) {
+
+		const float ndc = -1.0f + 2.0f * (float)i / (float)tiles;
+		const float length = std::sqrt(scale * scale + ndc * ndc);
+
+		boundaries.a[i] = scale / length;
+		boundaries.b[i] = -ndc / length;
+	}
+}
+
+uint32_t LightClusters::GetTileMask(const Boundaries& boundaries, unsigned int tiles, float uMin, float uMax, float zMin, float zMax) const noexcept
+{
+	uint64_t above;
+	uint64_t below;
+
+	planeKernels[(int)m_isa](boundaries.a.data(), boundaries.b.data(), (unsigned int)boundaries.a.size(), uMin, uMax, zMin, zMax, above, below);
+
+	//tile i needs part of the box on the positive side of boundary i and part on the negative side of boundary i+1
+	//*the two sides are checked apart, which is a little loose in the corners but never too tight
+	const uint64_t tileBits = (1ull << tiles) - 1u;
+
+	return (uint32_t)(above & (below >> 1) & tileBits);
+}
+
+unsigned int LightClusters::GetSlice(float z) const noexcept
+{
+	const float slice = std::floor(std::log2(z) * m_sliceScale + m_sliceBias);
+
+	return (unsigned int)std::clamp(slice, 0.0f, (float)(m_slices - 1u));
+}
+
+
+LightClusters::Exception::Exception(int line, const char* file, std::string note) noexcept
+	:
+	myException(line, file),
+	note(std::move(note))
+{}
+
+const char* LightClusters::Exception::what() const noexcept
+{
+	std::ostringstream oss;
+
+	oss << myException::what() << std::endl
+		<< "[Note] " << GetNote();
+
+	whatBuffer = oss.str();
+	return whatBuffer.c_str();
+}
+
+const char* LightClusters::Exception::GetType() const noexcept
+{
+	return "SupaHotFire LightClusters Exception";
+}
+
+const std::string& LightClusters::Exception::GetNote() const noexcept
+{
+	return note;
+}
@@ -0,0 +1,176 @@
+#pragma once
+
+#include "myException.h"
+#include "PixelKernels.h"
+#include <DirectXMath.h>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Cluster grid for forward shading with many point lights, built on the CPU every frame
+/// the view frustum is split into screen tiles and depth slices (exponentially deeper with distance), each cluster gets the list of lights reaching into it
+/// a light's slices come from its depth range, its columns and rows in each slice from testing the box around its part in the slice
+/// against every tile boundary plane at once with SIMD
+/// lights are binned by slice first so slices can be filled in parallel, then the lists are packed into one range per cluster and one index list
+/// works on plain numbers only so it builds and runs without windows
+/// </summary>
+class LightClusters {
+
+public:
+
+	class Exception :public myException {
+
+	public:
+
+		Exception(int line, const char* file, std::string note) noexcept;
+		const char* what() const noexcept override;
+		const char* GetType() const noexcept override;
+
+		const std::string& GetNote() const noexcept;
+
+	private:
+
+		std::string note;
+	};
+
+	//columns and rows a light covers are bit masks
+	static constexpr unsigned int maxTiles = 32u;
+	//indices are 16 bits
+	static constexpr size_t maxLights = 65536u;
+
+	//a light in view space, it lights nothing past the radius
+	struct Light {
+
+		DirectX::XMFLOAT3 center;
+		float radius;
+	};
+
+	//a cluster's lights are [offset, offset + count) of the index list
+	struct Range {
+
+		uint32_t offset;
+		uint32_t count;
+	};
+
+	struct Stats {
+
+		size_t lights = 0u;
+		//lights reaching into at least one cluster
+		size_t visibleLights = 0u;
+		size_t indices = 0u;
+		uint32_t maxClusterLights = 0u;
+	};
+
+public:
+
+	LightClusters(unsigned int tilesX = 16u, unsigned int tilesY = 9u, unsigned int slices = 24u);
+	LightClusters(const LightClusters&) = delete;
+	LightClusters& operator=(const LightClusters&) = delete;
+
+	void Resize(unsigned int tilesX, unsigned int tilesY, unsigned int slices);
+	unsigned int GetTilesX() const noexcept;
+	unsigned int GetTilesY() const noexcept;
+	unsigned int GetSliceCount() const noexcept;
+	size_t GetClusterCount() const noexcept;
+
+	//the grid splits the frustum of a perspective projection (row vectors, left handed, D3D depth 0..w)
+	void SetProjection(const DirectX::XMFLOAT4X4& projection);
+
+	//what the shaders find a view space point's cluster with:
+	//column = (x * scale.x / z * 0.5 + 0.5) * tilesX, rows the same with y counted from the bottom, slice = log2(z) * sliceScale + sliceBias
+	DirectX::XMFLOAT2 GetProjectionScale() const noexcept;
+	float GetSliceScale() const noexcept;
+	float GetSliceBias() const noexcept;
+	//the same on the CPU, points off the grid are clamped onto it
+	size_t GetClusterIndex(const DirectX::XMFLOAT3& point) const noexcept;
+
+	//works out the tiles and slices of every light and bins them by slice, lights are in view space
+	void Begin(const std::vector<Light>& lights);
+	//fills the lists of the clusters in slices [firstSlice,lastSlice), ranges are independent so they can run in parallel
+	void Assign(size_t firstSlice, size_t lastSlice);
+	void Assign();
+	//joins the slices' lists into the ranges and the index list
+	void Pack();
+
+	//one per cluster, cluster (column, row, slice) is at (slice * tilesY + row) * tilesX + column
+	const std::vector<Range>& GetRanges() const noexcept;
+	const std::vector<uint16_t>& GetIndices() const noexcept;
+
+	const Stats& GetStats() const noexcept;
+
+	//level of the tile plane kernel, the one PixelKernels picked to start with
+	void SetIsa(PixelKernels::Isa isa) noexcept;
+	PixelKernels::Isa GetIsa() const noexcept;
+
+private:
+
+	//columns and rows the whole light covers as bit masks
+	struct Footprint {
+
+		Light light;
+		uint32_t columns;
+		uint32_t rows;
+	};
+
+	struct Masks {
+
+		uint32_t columns;
+		uint32_t rows;
+	};
+
+	//boundary planes through the eye between the tiles of one axis, normal is (a, 0, b) or (0, a, b)
+	//*padded with planes through everything so the kernels run whole registers
+	struct Boundaries {
+
+		std::vector<float> a;
+		std::vector<float> b;
+		unsigned int count = 0u;
+	};
+
+	struct Slice {
+
+		std::vector<uint16_t> lights;
+		//the lights' tiles in this slice
+		std::vector<Masks> masks;
+		//offsets are into this slice's indices until Pack
+		std::vector<Range> ranges;
+		std::vector<uint16_t> indices;
+	};
+
+	//tile planes and slice constants for the current sizes and projection
+	void SetUpGrid();
+	void SetBoundaries(Boundaries& boundaries, unsigned int tiles, float scale);
+	//bits of the tiles a view space box overlaps, u is x for columns and y for rows
+	uint32_t GetTileMask(const Boundaries& boundaries, unsigned int tiles, float uMin, float uMax, float zMin, float zMax) const noexcept;
+	unsigned int GetSlice(float z) const noexcept;
+
+private:
+
+	unsigned int m_tilesX = 0u;
+	unsigned int m_tilesY = 0u;
+	unsigned int m_slices = 0u;
+
+	PixelKernels::Isa m_isa;
+
+	//the app's projection until one is set
+	float m_near = 0.5f;
+	float m_far = 40.0f;
+	DirectX::XMFLOAT2 m_projectionScale = { 1.0f,16.0f / 9.0f };
+	float m_sliceScale = 0.0f;
+	float m_sliceBias = 0.0f;
+	//where each slice starts, and the far plane
+	std::vector<float> m_sliceDepths;
+
+	Boundaries m_columns;
+	Boundaries m_rows;
+
+	std::vector<Footprint> m_footprints;
+	std::vector<Slice> m_sliceLists;
+
+	std::vector<Range> m_ranges;
+	std::vector<uint16_t> m_indices;
+
+	Stats m_stats;
+};
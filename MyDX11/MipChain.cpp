@@ -0,0 +1,75 @@
+#include "MipChain.h"
+#include "MipFilter.h"
+#include "JobSystem.h"
+#include "DdsFile.h"
+#include <algorithm>
+
+//destination texels per job, small levels end up in a single job
+constexpr size_t texelsPerJob = 64u * 1024u;
+
+MipChain::MipChain(Surface top, bool isSrgb, JobSystem* pJobs)
+{
+	m_levels.reserve(MipFilter::CountLevels(top.GetWidth(), top.GetHeight()));
+	m_levels.push_back(std::move(top));
+
+	while (m_levels.back().GetWidth() > 1u || m_levels.back().GetHeight() > 1u) {
+
+		const auto& src = m_levels.back();
+		const MipFilter filter(src.GetWidth(), src.GetHeight(), isSrgb);
+
+		Surface dst(filter.GetDstWidth(), filter.GetDstHeight());
+
+		//Color is a single dword in B8G8R8A8 order, the filter works on the raw texels
+		const auto pSrc = reinterpret_cast<const uint32_t*>(src.GetBufferPtr());
+		const auto pDst = reinterpret_cast<uint32_t*>(dst.GetBufferPtr());
+
+		if (pJobs != nullptr) {
+
+			const auto rowsPerJob = std::max<size_t>(1u, texelsPerJob / filter.GetDstWidth());
+
+			pJobs->ParallelFor(filter.GetDstHeight(), rowsPerJob, [&](size_t first, size_t last) {
+
+				filter.Run(pSrc, pDst, (unsigned int)first, (unsigned int)last);
+			});
+		}
+		else {
+
+			filter.Run(pSrc, pDst, 0u, filter.GetDstHeight());
+		}
+
+		m_levels.push_back(std::move(dst));
+	}
+}
+
+size_t MipChain::GetLevelCount() const noexcept
+{
+	return m_levels.size();
+}
+
+const Surface& MipChain::GetLevel(size_t level) const noexcept(!IS_DEBUG)
+{
+	assert("Mip level out of range" && level < m_levels.size());
+
+	return m_levels[level];
+}
+
+void MipChain::SaveDds(const std::string& path) const
+{
+	DdsFile::Description desc;
+	desc.format = DdsFormat::B8G8R8A8Unorm;
+	desc.width = m_levels.front().GetWidth();
+	desc.height = m_levels.front().GetHeight();
+	desc.mipLevels = (unsigned int)m_levels.size();
+
+	std::vector<DdsFile::Subresource> subresources;
+
+	for (const auto& level : m_levels) {
+
+		const size_t rowPitch = level.GetWidth() * sizeof(Surface::Color);
+
+		subresources.push_back({ reinterpret_cast<const uint8_t*>(level.GetBufferPtr()), level.GetWidth(), level.GetHeight(),
+			rowPitch, rowPitch * level.GetHeight() });
+	}
+
+	DdsFile::Write(path, desc, subresources);
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Surface.h"
+#include <vector>
+#include <string>
+
+class JobSystem;
+
+/// <summary>
+/// Full mip chain of a surface down to 1x1, built with MipFilter at load time
+/// each level is filtered from the one above, its rows split across the job system
+/// </summary>
+class MipChain {
+
+public:
+
+	//level 0 is the surface itself
+	//*color maps are averaged in linear light, data maps (specular, normals) should pass isSrgb = false
+	MipChain(Surface top, bool isSrgb = true, JobSystem* pJobs = nullptr);
+
+	size_t GetLevelCount() const noexcept;
+	const Surface& GetLevel(size_t level) const noexcept(!IS_DEBUG);
+
+	//every level as an uncompressed B8G8R8A8 DDS
+	void SaveDds(const std::string& path) const;
+
+private:
+
+	std::vector<Surface> m_levels;
+};
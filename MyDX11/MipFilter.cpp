@@ -0,0 +1,179 @@
+#include "MipFilter.h"
+#include <emmintrin.h>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace {
+
+	//conversion tables shared by every filter
+	struct ColorTables {
+
+		//linear values are looked up at this resolution when encoding back to sRGB
+		static constexpr unsigned int encodeSize = 16384u;
+
+		float srgbToLinear[256];
+		float unormToFloat[256];
+		unsigned char linearToSrgb[encodeSize];
+
+		ColorTables()
+		{
+			for (unsigned int i = 0; i < 256u; i++) {
+
+				const double c = i / 255.0;
+
+				srgbToLinear[i] = (float)(c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4));
+				unormToFloat[i] = (float)c;
+			}
+
+			for (unsigned int i = 0; i < encodeSize; i++) {
+
+				const double l = (double)i / (encodeSize - 1u);
+				const double c = l <= 0.0031308 ? l * 12.92 : 1.055 * std::pow(l, 1.0 / 2.4) - 0.055;
+
+				linearToSrgb[i] = (unsigned char)std::min(255.0, std::floor(c * 255.0 + 0.5));
+			}
+		}
+	};
+
+	const ColorTables& GetTables()
+	{
+		static const ColorTables tables;
+		return tables;
+	}
+
+	//B8G8R8A8 texel into b,g,r,a lanes
+	inline __m128 Decode(uint32_t texel, const float* pColorTable, const float* pAlphaTable) noexcept
+	{
+		return _mm_setr_ps(
+			pColorTable[texel & 0xFFu],
+			pColorTable[(texel >> 8u) & 0xFFu],
+			pColorTable[(texel >> 16u) & 0xFFu],
+			pAlphaTable[texel >> 24u]
+		);
+	}
+}
+
+unsigned int MipFilter::NextSize(unsigned int size) noexcept
+{
+	return std::max(1u, size / 2u);
+}
+
+unsigned int MipFilter::CountLevels(unsigned int width, unsigned int height) noexcept
+{
+	unsigned int levels = 1u;
+
+	while (width > 1u || height > 1u) {
+
+		width = NextSize(width);
+		height = NextSize(height);
+		levels++;
+	}
+
+	return levels;
+}
+
+MipFilter::MipFilter(unsigned int srcWidth, unsigned int srcHeight, bool isSrgb)
+	:
+	m_srcWidth(srcWidth),
+	m_srcHeight(srcHeight),
+	m_isSrgb(isSrgb),
+	m_columns(MakeTaps(srcWidth, NextSize(srcWidth))),
+	m_rows(MakeTaps(srcHeight, NextSize(srcHeight)))
+{
+	//build the tables before any parallel Run
+	GetTables();
+}
+
+unsigned int MipFilter::GetDstWidth() const noexcept
+{
+	return (unsigned int)m_columns.size();
+}
+
+unsigned int MipFilter::GetDstHeight() const noexcept
+{
+	return (unsigned int)m_rows.size();
+}
+
+void MipFilter::Run(const uint32_t* pSrc, uint32_t* pDst, unsigned int firstRow, unsigned int lastRow) const noexcept
+{
+	const auto& tables = GetTables();
+	const float* pColorTable = m_isSrgb ? tables.srgbToLinear : tables.unormToFloat;
+
+	//sRGB color lanes go through the encode table, linear lanes straight to 8 bit
+	const float colorScale = m_isSrgb ? (float)(ColorTables::encodeSize - 1u) : 255.0f;
+	const __m128 scale = _mm_setr_ps(colorScale, colorScale, colorScale, 255.0f);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+
+	const auto dstWidth = GetDstWidth();
+
+	for (unsigned int y = firstRow; y < lastRow; y++) {
+
+		const auto& rowTaps = m_rows[y];
+		auto pOut = pDst + (size_t)y * dstWidth;
+
+		for (unsigned int x = 0; x < dstWidth; x++) {
+
+			const auto& columnTaps = m_columns[x];
+			__m128 sum = zero;
+
+			//weighted sum of the covered source texels, all four channels at once
+			for (unsigned int r = 0; r < rowTaps.count; r++) {
+
+				const auto pRow = pSrc + (size_t)(rowTaps.first + r) * m_srcWidth + columnTaps.first;
+
+				for (unsigned int c = 0; c < columnTaps.count; c++) {
+
+					const __m128 weight = _mm_set1_ps(rowTaps.weights[r] * columnTaps.weights[c]);
+					sum = _mm_add_ps(sum, _mm_mul_ps(weight, Decode(pRow[c], pColorTable, tables.unormToFloat)));
+				}
+			}
+
+			//clamp, scale and round to table indices / 8 bit values
+			sum = _mm_min_ps(_mm_max_ps(sum, zero), one);
+
+			alignas(16) int32_t q[4];
+			_mm_store_si128(reinterpret_cast<__m128i*>(q), _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(sum, scale), half)));
+
+			if (m_isSrgb) {
+
+				q[0] = tables.linearToSrgb[q[0]];
+				q[1] = tables.linearToSrgb[q[1]];
+				q[2] = tables.linearToSrgb[q[2]];
+			}
+
+			pOut[x] = ((uint32_t)q[3] << 24u) | ((uint32_t)q[2] << 16u) | ((uint32_t)q[1] << 8u) | (uint32_t)q[0];
+		}
+	}
+}
+
+std::vector<MipFilter::Taps> MipFilter::MakeTaps(unsigned int srcSize, unsigned int dstSize)
+{
+	assert("Mip source must not be empty" && srcSize != 0u);
+
+	std::vector<Taps> taps(dstSize);
+
+	//scaled by dstSize, destination texel i covers [i * src, (i + 1) * src) and source texel s
+	//covers [s * dst, (s + 1) * dst), integers keep the footprints exact
+	for (unsigned int i = 0; i < dstSize; i++) {
+
+		const auto lo = (unsigned long long)i * srcSize;
+		const auto hi = lo + srcSize;
+
+		auto& t = taps[i];
+		t.first = (unsigned int)(lo / dstSize);
+		t.count = 0u;
+
+		for (auto s = (unsigned long long)t.first; s * dstSize < hi; s++) {
+
+			const auto overlap = std::min(hi, (s + 1u) * dstSize) - std::max(lo, s * dstSize);
+
+			assert("Mip footprint wider than 3 texels" && t.count < 3u);
+			t.weights[t.count++] = (float)((double)overlap / srcSize);
+		}
+	}
+
+	return taps;
+}
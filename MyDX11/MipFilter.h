@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/// <summary>
+/// Box filter for one mip reduction of a B8G8R8A8 image (the Surface::Color layout)
+/// odd sizes are area weighted so every source texel counts exactly once,
+/// color is averaged in linear light when the image is sRGB, alpha always linearly
+/// works on raw pixels only so it builds and runs without windows
+/// </summary>
+class MipFilter {
+
+public:
+
+	//size of the next level (D3D rounding, never below 1)
+	static unsigned int NextSize(unsigned int size) noexcept;
+
+	//levels down to 1x1 including the top one
+	static unsigned int CountLevels(unsigned int width, unsigned int height) noexcept;
+
+public:
+
+	MipFilter(unsigned int srcWidth, unsigned int srcHeight, bool isSrgb);
+
+	unsigned int GetDstWidth() const noexcept;
+	unsigned int GetDstHeight() const noexcept;
+
+	//filters destination rows [firstRow, lastRow), rows are independent so ranges can run in parallel
+	void Run(const uint32_t* pSrc, uint32_t* pDst, unsigned int firstRow, unsigned int lastRow) const noexcept;
+
+private:
+
+	//source texels covering one destination texel along one axis (at most 3 for a 2:1 reduction)
+	struct Taps {
+
+		unsigned int first;
+		unsigned int count;
+		float weights[3];
+	};
+
+	static std::vector<Taps> MakeTaps(unsigned int srcSize, unsigned int dstSize);
+
+private:
+
+	unsigned int m_srcWidth;
+	unsigned int m_srcHeight;
+	bool m_isSrgb;
+
+	std::vector<Taps> m_columns;
+	std::vector<Taps> m_rows;
+};
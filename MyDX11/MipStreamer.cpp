@@ -0,0 +1,264 @@
+#include "MipStreamer.h"
+#include <algorithm>
+#include <cmath>
+#include <cassert>
+
+//keeps the estimate finite with the camera inside a bounding sphere
+constexpr float minDistance = 0.01f;
+
+unsigned int MipStreamer::ComputeRequiredMip(float texelsPerUnit, float pixelsPerUnit, float distance, float radius, unsigned int mipCount) noexcept
+{
+	const float nearest = std::max(distance - radius, minDistance);
+
+	//texels that land on one pixel at the nearest point, every mip halves it
+	const float texelsPerPixel = texelsPerUnit * nearest / pixelsPerUnit;
+
+	if (!(texelsPerPixel > 1.0f)) {
+
+		return 0u;
+	}
+
+	const auto mip = (unsigned int)std::floor(std::log2(texelsPerPixel));
+
+	return std::min(mip, mipCount - 1u);
+}
+
+MipStreamer::MipStreamer() noexcept
+	:
+	MipStreamer(Config{})
+{}
+
+MipStreamer::MipStreamer(Config config) noexcept
+	:
+	m_config(config)
+{}
+
+MipStreamer::Id MipStreamer::Register(std::vector<size_t> mipBytes, unsigned int lowestMip)
+{
+	assert("Lowest resident mip out of range" && lowestMip < mipBytes.size());
+
+	Entry entry;
+	entry.bytes = std::move(mipBytes);
+	entry.lowestMip = lowestMip;
+	entry.residentMip = lowestMip;
+	entry.requestedMip = lowestMip;
+
+	//running sum from the smallest level up
+	for (size_t i = entry.bytes.size() - 1u; i-- > 0u;) {
+
+		entry.bytes[i] += entry.bytes[i + 1u];
+	}
+
+	m_committed += entry.bytes[lowestMip];
+	m_entries.push_back(std::move(entry));
+
+	return m_entries.size() - 1u;
+}
+
+void MipStreamer::SetBudget(size_t budget) noexcept
+{
+	m_config.budget = budget;
+}
+
+size_t MipStreamer::GetBudget() const noexcept
+{
+	return m_config.budget;
+}
+
+void MipStreamer::Request(Id id, unsigned int mip) noexcept(!IS_DEBUG)
+{
+	assert("Unknown streamed texture" && id < m_entries.size());
+
+	auto& entry = m_entries[id];
+
+	entry.frameRequest = std::min({ entry.frameRequest, mip, entry.lowestMip });
+}
+
+const std::vector<MipStreamer::Transition>& MipStreamer::Update()
+{
+	m_transitions.clear();
+	m_frame++;
+
+	for (auto& entry : m_entries) {
+
+		if (entry.frameRequest != none) {
+
+			entry.requestedMip = entry.frameRequest;
+			entry.lastUsedFrame = m_frame;
+			entry.frameRequest = none;
+		}
+	}
+
+	//the budget can shrink at any time, whatever was not drawn this frame goes first
+	if (m_committed > m_config.budget) {
+
+		Evict(m_committed - m_config.budget, none, m_frame);
+	}
+
+	//what is drawn alone is over it, those give up detail too, down to their floors
+	if (m_committed > m_config.budget) {
+
+		Evict(m_committed - m_config.budget, none, m_frame + 1u);
+	}
+
+	//only textures drawn this frame load, the ones missing the most mips first
+	std::vector<Id> candidates;
+
+	for (Id id = 0; id < m_entries.size(); id++) {
+
+		const auto& entry = m_entries[id];
+
+		if (entry.lastUsedFrame == m_frame && entry.pendingMip == none && entry.requestedMip < entry.residentMip) {
+
+			candidates.push_back(id);
+		}
+	}
+
+	std::stable_sort(candidates.begin(), candidates.end(), [this](Id a, Id b) {
+
+		return m_entries[a].residentMip - m_entries[a].requestedMip > m_entries[b].residentMip - m_entries[b].requestedMip;
+	});
+
+	for (const auto id : candidates) {
+
+		if (m_loadsInFlight >= m_config.maxLoadsInFlight) {
+
+			break;
+		}
+
+		auto& entry = m_entries[id];
+
+		const auto cost = [&entry](unsigned int mip) {
+
+			return entry.bytes[mip] - entry.bytes[entry.residentMip];
+		};
+
+		unsigned int target = entry.requestedMip;
+
+		if (m_committed + cost(target) > m_config.budget) {
+
+			Evict(m_committed + cost(target) - m_config.budget, id, m_frame);
+		}
+
+		//settle for less detail when even evicting leaves no room
+		while (target < entry.residentMip && m_committed + cost(target) > m_config.budget) {
+
+			target++;
+		}
+
+		if (target == entry.residentMip) {
+
+			continue;
+		}
+
+		m_committed += cost(target);
+		m_loadsInFlight++;
+
+		entry.pendingMip = target;
+		m_transitions.push_back({ id,target });
+	}
+
+	return m_transitions;
+}
+
+void MipStreamer::Complete(Id id, unsigned int mip) noexcept(!IS_DEBUG)
+{
+	assert("Unknown streamed texture" && id < m_entries.size());
+
+	auto& entry = m_entries[id];
+
+	assert("Texture has no transition in flight" && entry.pendingMip != none);
+
+	if (entry.pendingMip < entry.residentMip) {
+
+		m_loadsInFlight--;
+	}
+
+	//a failed transition leaves a different amount resident than was committed
+	m_committed = m_committed - entry.bytes[entry.pendingMip] + entry.bytes[mip];
+
+	entry.residentMip = mip;
+	entry.pendingMip = none;
+}
+
+size_t MipStreamer::GetCommittedBytes() const noexcept
+{
+	return m_committed;
+}
+
+size_t MipStreamer::GetTextureCount() const noexcept
+{
+	return m_entries.size();
+}
+
+MipStreamer::Status MipStreamer::GetStatus(Id id) const noexcept(!IS_DEBUG)
+{
+	assert("Unknown streamed texture" && id < m_entries.size());
+
+	const auto& entry = m_entries[id];
+
+	Status status;
+	status.mipCount = (unsigned int)entry.bytes.size();
+	status.lowestMip = entry.lowestMip;
+	status.residentMip = entry.residentMip;
+	status.requestedMip = entry.requestedMip;
+	status.pendingMip = entry.pendingMip;
+	status.residentBytes = entry.bytes[entry.residentMip];
+	status.lastUsedFrame = entry.lastUsedFrame;
+
+	return status;
+}
+
+void MipStreamer::Evict(size_t needed, Id keep, uint64_t olderThan)
+{
+	//least recently drawn first
+	std::vector<Id> victims;
+
+	for (Id id = 0; id < m_entries.size(); id++) {
+
+		if (id != keep && m_entries[id].pendingMip == none) {
+
+			victims.push_back(id);
+		}
+	}
+
+	std::stable_sort(victims.begin(), victims.end(), [this](Id a, Id b) {
+
+		return m_entries[a].lastUsedFrame < m_entries[b].lastUsedFrame;
+	});
+
+	size_t freed = 0u;
+
+	for (const auto id : victims) {
+
+		if (freed >= needed) {
+
+			break;
+		}
+
+		auto& entry = m_entries[id];
+
+		//textures still in use only give up the detail nobody asked for
+		const unsigned int keepMip = entry.lastUsedFrame >= olderThan ? entry.requestedMip : entry.lowestMip;
+
+		unsigned int mip = entry.residentMip;
+
+		while (mip < keepMip && freed + entry.bytes[entry.residentMip] - entry.bytes[mip] < needed) {
+
+			mip++;
+		}
+
+		if (mip == entry.residentMip) {
+
+			continue;
+		}
+
+		const size_t released = entry.bytes[entry.residentMip] - entry.bytes[mip];
+
+		m_committed -= released;
+		freed += released;
+
+		entry.pendingMip = mip;
+		m_transitions.push_back({ id,mip });
+	}
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "BuildConfig.h"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <climits>
+
+/// <summary>
+/// Decides which mips of streamed textures should be resident under a memory budget
+/// draws report the most detailed mip they need, Update turns that into transitions for the caller to carry out
+/// when a load does not fit, the least recently used textures give up their top mips first
+/// only does the book keeping (no d3d, no threads) so the policy can be run headless against a made up camera path
+/// </summary>
+class MipStreamer {
+
+public:
+
+	using Id = size_t;
+
+	static constexpr unsigned int none = UINT_MAX;
+
+	struct Config {
+
+		//bytes all streamed textures may hold at once
+		size_t budget = 64u * 1024u * 1024u;
+
+		//loads started but not finished, evictions do not count
+		unsigned int maxLoadsInFlight = 4u;
+	};
+
+	//a texture should end up with mip as its most detailed level
+	struct Transition {
+
+		Id id;
+		unsigned int mip;
+	};
+
+	struct Status {
+
+		unsigned int mipCount;
+		//floor that is never evicted
+		unsigned int lowestMip;
+		unsigned int residentMip;
+		//most detailed mip asked for the last time the texture was drawn
+		unsigned int requestedMip;
+		//none when nothing is on the way
+		unsigned int pendingMip;
+		size_t residentBytes;
+		uint64_t lastUsedFrame;
+	};
+
+public:
+
+	//mip a draw needs so one texel is no smaller than one pixel
+	//texelsPerUnit is texture size times the mesh's uv density (uv span per world unit),
+	//pixelsPerUnit is how many pixels one world unit covers at distance one (screen height * proj._22 / 2)
+	//*the nearest point of the bounding sphere is used so the closest part of the mesh never looks blurry
+	static unsigned int ComputeRequiredMip(float texelsPerUnit, float pixelsPerUnit, float distance, float radius, unsigned int mipCount) noexcept;
+
+public:
+
+	MipStreamer() noexcept;
+	explicit MipStreamer(Config config) noexcept;
+
+	//mipBytes holds the size of each level (all array items), most detailed first
+	//the texture starts with lowestMip and everything below it resident
+	Id Register(std::vector<size_t> mipBytes, unsigned int lowestMip);
+
+	void SetBudget(size_t budget) noexcept;
+	size_t GetBudget() const noexcept;
+
+	//draws of the current frame, the most detailed request wins
+	void Request(Id id, unsigned int mip) noexcept(!IS_DEBUG);
+
+	//ends the frame, returns the evictions and loads to start, each texture has at most one in flight
+	const std::vector<Transition>& Update();
+
+	//the transition for id finished, mip is what is actually resident now (the old mip if it failed)
+	void Complete(Id id, unsigned int mip) noexcept(!IS_DEBUG);
+
+	//bytes resident once every transition in flight is done, never above the budget unless the floors alone are
+	size_t GetCommittedBytes() const noexcept;
+
+	size_t GetTextureCount() const noexcept;
+	Status GetStatus(Id id) const noexcept(!IS_DEBUG);
+
+private:
+
+	struct Entry {
+
+		//bytes[i] is every level from i down, so any residency costs one lookup
+		std::vector<size_t> bytes;
+		unsigned int lowestMip;
+		unsigned int residentMip;
+		unsigned int requestedMip;
+		unsigned int pendingMip = none;
+		unsigned int frameRequest = none;
+		uint64_t lastUsedFrame = 0u;
+	};
+
+	//drops top mips of least recently used textures until needed bytes fit, skipping keep
+	void Evict(size_t needed, Id keep, uint64_t olderThan);
+
+private:
+
+	Config m_config;
+	std::vector<Entry> m_entries;
+
+	uint64_t m_frame = 0u;
+	size_t m_committed = 0u;
+	unsigned int m_loadsInFlight = 0u;
+
+	std::vector<Transition> m_transitions;
+};
@@ -1,8 +1,59 @@
 #include "Model.h"
 #include "imgui/imgui.h"
-#include "Surface.h"
+#include "MipChain.h"
+#include "CompressedTexture.h"
+#include "DdsFile.h"
+#include "StreamedTexture.h"
+#include "TextureStreamer.h"
+#include "MipStreamer.h"
+#include "TexturePacker.h"
+#include "Profiler.h"
 #include <unordered_map>
 #include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <filesystem>
+#include <iterator>
+#include <cfloat>
+#include <cmath>
+
+//where the model's texture file names are relative to
+static const std::string textureDir = "asset\\model\\nano_textured\\";
+
+//finished textures (mips and blocks) are baked here as DDS so later runs only read them
+static const std::string bakeDir = "asset\\cache";
+
+//larger sources are filtered down on import, keeping their aspect
+constexpr unsigned int maxTextureSize = 2048u;
+
+//occluders are the cells of a grid this many along a mesh's longest side that are wholly inside it
+constexpr unsigned int occluderCells = 24u;
+
+static std::string GetBakedPath(const std::string& path) {
+
+	//the hash keeps files with the same name in different folders apart, and bakes made under another size cap out
+	std::ostringstream name;
+	name << std::filesystem::path(path).stem().string() << "_"
+		<< std::hex << std::setw(16) << std::setfill('0') << std::hash<std::string>{}(path + "|" + std::to_string(maxTextureSize)) << ".dds";
+
+	return (std::filesystem::path(bakeDir) / name.str()).string();
+}
+
+//a bake older than its source is stale, delete the cache folder to force a rebuild
+static bool IsBaked(const std::string& path) {
+
+	std::error_code ec;
+	const auto bakedTime = std::filesystem::last_write_time(GetBakedPath(path), ec);
+
+	if (ec) {
+
+		return false;
+	}
+
+	const auto sourceTime = std::filesystem::last_write_time(path, ec);
+
+	return !ec && bakedTime >= sourceTime;
+}
 
 /// <summary>
 /// Model Error Handeling
@@ -53,6 +104,12 @@ Mesh::Mesh(Graphics& gfx, std::vector<std::shared_ptr<Bindable>> bindPtrs) {
 
 	for (auto& pb : bindPtrs) {
 
+		if (auto pStreamed = std::dynamic_pointer_cast<Bind::StreamedTexture>(pb)) {
+
+			m_streamedPtrs.push_back(std::move(pStreamed));
+			m_uvScales.push_back(1.0f);
+		}
+
 		AddBind(std::move(pb));
 	}
 
@@ -64,9 +121,85 @@ void Mesh::Draw(Graphics& gfx, DirectX::FXMMATRIX accumulatedTransform) const no
 	//storing transform into m_transform
 	DirectX::XMStoreFloat4x4(&m_transform, accumulatedTransform);
 
+	RequestMips(gfx, accumulatedTransform);
 	Drawable::Draw(gfx);
 }
 
+void Mesh::SetStreamingBounds(const DirectX::XMFLOAT3& center, float radius, float uvDensity) noexcept
+{
+	m_center = center;
+	m_radius = radius;
+	m_uvDensity = uvDensity;
+}
+
+void Mesh::SetUvScale(const Bindable& texture, float uvScale) noexcept
+{
+	for (size_t i = 0; i < m_streamedPtrs.size(); i++) {
+
+		if (m_streamedPtrs[i].get() == &texture) {
+
+			m_uvScales[i] = uvScale;
+		}
+	}
+}
+
+void Mesh::SetOccluder(OcclusionCuller::OccluderMesh occluder) noexcept
+{
+	m_occluder = std::move(occluder);
+}
+
+void Mesh::AddOccluder(OcclusionCuller& culler, DirectX::FXMMATRIX accumulatedTransform) const
+{
+	if (m_occluder.IsEmpty()) {
+
+		return;
+	}
+
+	DirectX::XMFLOAT4X4 world;
+	DirectX::XMStoreFloat4x4(&world, accumulatedTransform);
+
+	culler.AddOccluder(m_occluder, world);
+}
+
+void Mesh::RequestMips(Graphics& gfx, DirectX::FXMMATRIX accumulatedTransform) const noexcept
+{
+	if (m_streamedPtrs.empty()) {
+
+		return;
+	}
+
+	namespace dx = DirectX;
+
+	const auto modelView = accumulatedTransform * gfx.GetCamera();
+	const float distance = dx::XMVectorGetX(dx::XMVector3Length(dx::XMVector3Transform(dx::XMLoadFloat3(&m_center), modelView)));
+
+	//largest axis scale, the camera itself never scales
+	const float scale = std::max({
+		dx::XMVectorGetX(dx::XMVector3Length(modelView.r[0])),
+		dx::XMVectorGetX(dx::XMVector3Length(modelView.r[1])),
+		dx::XMVectorGetX(dx::XMVector3Length(modelView.r[2])) });
+
+	dx::XMFLOAT4X4 projection;
+	dx::XMStoreFloat4x4(&projection, gfx.GetProjection());
+
+	const float pixelsPerUnit = gfx.GetHeight() * projection._22 * 0.5f;
+
+	for (size_t i = 0; i < m_streamedPtrs.size(); i++) {
+
+		const auto& pTexture = m_streamedPtrs[i];
+		const float texelsPerUnit = pTexture->GetSize() * m_uvScales[i] * m_uvDensity / scale;
+
+		pTexture->Request(MipStreamer::ComputeRequiredMip(texelsPerUnit, pixelsPerUnit, distance, m_radius * scale, pTexture->GetMipCount()));
+	}
+}
+
+void Mesh::Stage(DirectX::FXMMATRIX accumulatedTransform) const
+{
+	DirectX::XMStoreFloat4x4(&m_transform, accumulatedTransform);
+
+	StageTransform();
+}
+
 //getting mesh's transform
 
 DirectX::XMMATRIX Mesh::GetTransformXM() const noexcept {
@@ -105,6 +238,71 @@ void Node::Draw(Graphics& gfx, DirectX::FXMMATRIX accumulatedTransform) const no
 	}
 }
 
+void Node::Draw(Graphics& gfx, DirectX::FXMMATRIX accumulatedTransform, const std::vector<DirectX::XMFLOAT4X4>& pose) const noexcept(!IS_DEBUG) {
+
+	//same as above but the applied transform comes from the pose
+	const auto built =
+		DirectX::XMLoadFloat4x4(&pose[m_nodeID]) *
+		DirectX::XMLoadFloat4x4(&baseTransform) *
+		accumulatedTransform;
+
+	for (const auto pm : meshPtrs) {
+
+		pm->Draw(gfx, built);
+	}
+
+	for (const auto& pc : childPtrs) {
+
+		pc->Draw(gfx, built, pose);
+	}
+}
+
+void Node::Stage(DirectX::FXMMATRIX accumulatedTransform, const std::vector<DirectX::XMFLOAT4X4>& pose) const
+{
+	const auto built =
+		DirectX::XMLoadFloat4x4(&pose[m_nodeID]) *
+		DirectX::XMLoadFloat4x4(&baseTransform) *
+		accumulatedTransform;
+
+	for (const auto pm : meshPtrs) {
+
+		pm->Stage(built);
+	}
+
+	for (const auto& pc : childPtrs) {
+
+		pc->Stage(built, pose);
+	}
+}
+
+void Node::AddOccluders(OcclusionCuller& culler, DirectX::FXMMATRIX accumulatedTransform) const
+{
+	const auto built =
+		DirectX::XMLoadFloat4x4(&appliedTransform) *
+		DirectX::XMLoadFloat4x4(&baseTransform) *
+		accumulatedTransform;
+
+	for (const auto pm : meshPtrs) {
+
+		pm->AddOccluder(culler, built);
+	}
+
+	for (const auto& pc : childPtrs) {
+
+		pc->AddOccluders(culler, built);
+	}
+}
+
+void Node::CapturePose(std::vector<DirectX::XMFLOAT4X4>& pose) const noexcept(!IS_DEBUG)
+{
+	pose[m_nodeID] = appliedTransform;
+
+	for (const auto& pc : childPtrs) {
+
+		pc->CapturePose(pose);
+	}
+}
+
 void Node::SetAppliedTransform(DirectX::FXMMATRIX transform) noexcept
 {
 
@@ -160,10 +358,366 @@ void Node::AddChild(std::unique_ptr<Node> pChild) noexcept(!IS_DEBUG) {
 	childPtrs.push_back(std::move(pChild));
 }
 
-Model::Model(Graphics& gfx, const std::string fileName)
+//packed groups of a model are baked next to its textures, named by what went into them
+static std::string GetPackedPath(const std::string& modelPath, const std::vector<std::string>& members, const TexturePacker::Group& group) {
+
+	std::string key = std::to_string(group.width) + "x" + std::to_string(group.height);
+
+	for (const auto& member : members) {
+
+		key += "|" + member;
+	}
+
+	std::ostringstream name;
+	name << std::filesystem::path(modelPath).stem().string() << (group.isAtlas ? "_atlas_" : "_array_")
+		<< std::hex << std::setw(16) << std::setfill('0') << std::hash<std::string>{}(key) << ".dds";
+
+	return (std::filesystem::path(bakeDir) / name.str()).string();
+}
+
+//streamed when there is a streamer and the file allows it, fully resident otherwise
+static std::shared_ptr<Bindable> LoadDds(Graphics& gfx, std::shared_ptr<const DdsFile> pFile, const std::string& name, TextureStreamer* pStreamer,
+	unsigned int slot, bool asArray = false) {
+
+	if (pStreamer != nullptr && Bind::StreamedTexture::CanStream(*pFile)) {
+
+		auto pTexture = std::make_shared<Bind::StreamedTexture>(gfx, std::move(pFile), slot, asArray);
+		pStreamer->Register(pTexture, name);
+
+		return pTexture;
+	}
+
+	return std::make_shared<Bind::Texture>(gfx, *pFile, slot, asArray);
+}
+
+static std::shared_ptr<Bindable> LoadBakedTexture(Graphics& gfx, const std::string& path, TextureStreamer* pStreamer, unsigned int slot) {
+
+	return LoadDds(gfx, std::make_shared<const DdsFile>(GetBakedPath(path)), std::filesystem::path(path).filename().string(), pStreamer, slot);
+}
+
+//block compressed when the size allows it, then baked to DDS
+//*returns the finished texture only when the bake could not be written, nullptr means the bake is there to load
+//*images decoded ahead of time are taken out of decoded, anything else is read here
+static std::shared_ptr<Bindable> BuildTexture(Graphics& gfx, const std::string& path, bool isSrgb, CompressedTexture::Role role,
+	JobSystem* pJobs, std::unordered_map<std::string, Surface>& decoded, unsigned int slot) {
+
+	auto node = decoded.extract(path);
+
+	Surface top = node.empty() ? Surface::FromFile(path) : std::move(node.mapped());
+
+	if (top.GetWidth() > maxTextureSize || top.GetHeight() > maxTextureSize) {
+
+		const float scale = (float)maxTextureSize / (float)std::max(top.GetWidth(), top.GetHeight());
+		const auto width = std::max(1u, (unsigned int)std::lround(top.GetWidth() * scale));
+		const auto height = std::max(1u, (unsigned int)std::lround(top.GetHeight() * scale));
+
+		top = top.Resample(width, height, PixelKernels::Filter::Lanczos3, isSrgb, pJobs);
+	}
+
+	MipChain mips(std::move(top), isSrgb, pJobs);
+
+	//the bake is only a shortcut, failing to write it is not an error
+	//*streaming and packing read from the baked file, so without one the texture stays on its own and fully resident
+	const auto bake = [&](const auto& texture) -> std::shared_ptr<Bindable> {
+
+		try {
+
+			std::error_code ec;
+			std::filesystem::create_directories(bakeDir, ec);
+
+			texture.SaveDds(GetBakedPath(path));
+
+			return nullptr;
+		}
+		catch (const DdsFile::Exception&) {
+		}
+
+		return std::make_shared<Bind::Texture>(gfx, texture, slot);
+	};
+
+	if (!CompressedTexture::CanCompress(mips.GetLevel(0))) {
+
+		return bake(mips);
+	}
+
+	return bake(CompressedTexture(mips, role, false, pJobs));
+}
+
+static std::shared_ptr<Bindable> LoadTexture(Graphics& gfx, const std::string& path, bool isSrgb, CompressedTexture::Role role,
+	JobSystem* pJobs, TextureStreamer* pStreamer, std::unordered_map<std::string, Surface>& decoded, unsigned int slot) {
+
+	//baked by an earlier run, nothing to decode, filter or encode
+	if (IsBaked(path)) {
+
+		try {
+
+			return LoadBakedTexture(gfx, path, pStreamer, slot);
+		}
+		catch (const DdsFile::Exception&) {
+
+			//an unreadable bake is simply built again
+		}
+	}
+
+	if (auto pTexture = BuildTexture(gfx, path, isSrgb, role, pJobs, decoded, slot)) {
+
+		return pTexture;
+	}
+
+	return LoadBakedTexture(gfx, path, pStreamer, slot);
+}
+
+/// <summary>
+/// Every texture one model uses, baked first so the bakes can be packed
+/// textures of the same role go through TexturePacker, a group is one bind shared by all its meshes
+/// and each mesh finds its slice and rectangle in the material constant
+/// anything that could not be baked or packed is loaded on its own like before
+/// </summary>
+class ModelTextures {
+
+public:
+
+	struct Binding {
+
+		std::shared_ptr<Bindable> pTexture;
+
+		//pTexture is a group, slice and uv say where the texture is in it
+		bool isPacked = false;
+		unsigned int slice = 0u;
+		TexturePacker::UvTransform uv;
+	};
+
+public:
+
+	ModelTextures(Graphics& gfx, const aiScene& scene, const std::string& modelPath, JobSystem* pJobs, TextureStreamer* pStreamer);
+
+	const Binding& Get(const std::string& path) const;
+
+	//the texture on its own, for meshes whose other texture did not make it into a group
+	std::shared_ptr<Bindable> GetSingle(Graphics& gfx, const std::string& path);
+
+	//all meshes share one, so consecutive draws skip rebinding it
+	const std::shared_ptr<Bindable>& GetSampler() const noexcept;
+
+private:
+
+	struct Source {
+
+		bool isSrgb;
+		CompressedTexture::Role role;
+		unsigned int slot;
+	};
+
+private:
+
+	JobSystem* m_pJobs;
+	TextureStreamer* m_pStreamer;
+
+	std::unordered_map<std::string, Source> m_sources;
+	std::unordered_map<std::string, Surface> m_decoded;
+	std::unordered_map<std::string, Binding> m_bindings;
+	std::unordered_map<std::string, std::shared_ptr<Bindable>> m_singles;
+	std::shared_ptr<Bindable> m_pSampler;
+};
+
+ModelTextures::ModelTextures(Graphics& gfx, const aiScene& scene, const std::string& modelPath, JobSystem* pJobs, TextureStreamer* pStreamer)
+	:
+	m_pJobs(pJobs),
+	m_pStreamer(pStreamer),
+	m_pSampler(std::make_shared<Bind::Sampler>(gfx))
+{
+	//diffuse maps go to slot 0 with the sRGB curve,
+	//specular intensities are data, averaged without it
+	//*color and power both live in the specular map, so it keeps all four channels instead of going BC4
+	std::vector<std::string> paths;
+
+	for (size_t i = 0; i < scene.mNumMeshes; i++) {
+
+		const auto& material = *scene.mMaterials[scene.mMeshes[i]->mMaterialIndex];
+
+		for (const auto type : { aiTextureType_DIFFUSE,aiTextureType_SPECULAR }) {
+
+			aiString texFileName;
+
+			if (material.GetTexture(type, 0, &texFileName) == aiReturn_SUCCESS) {
+
+				const auto path = textureDir + texFileName.C_Str();
+
+				const Source source = type == aiTextureType_DIFFUSE ?
+					Source{ true,CompressedTexture::Role::Diffuse,0u } :
+					Source{ false,CompressedTexture::Role::Specular,1u };
+
+				if (m_sources.emplace(path, source).second) {
+
+					paths.push_back(path);
+				}
+			}
+		}
+	}
+
+	//decode every texture that is not baked yet up front, one job per file
+	if (pJobs != nullptr) {
+
+		std::vector<std::string> unbaked;
+
+		std::copy_if(paths.begin(), paths.end(), std::back_inserter(unbaked), [](const std::string& path) {
+
+			return !IsBaked(path);
+		});
+
+		auto surfaces = Surface::FromFiles(unbaked, *pJobs);
+
+		for (size_t i = 0; i < unbaked.size(); i++) {
+
+			m_decoded.emplace(unbaked[i], std::move(surfaces[i]));
+		}
+	}
+
+	//bake everything, the bakes are what gets packed
+	std::vector<std::string> bakedSources;
+	std::vector<std::shared_ptr<const DdsFile>> filePtrs;
+	std::vector<TexturePacker::Item> items;
+
+	for (const auto& path : paths) {
+
+		const auto& source = m_sources.at(path);
+
+		if (!IsBaked(path)) {
+
+			if (auto pTexture = BuildTexture(gfx, path, source.isSrgb, source.role, pJobs, m_decoded, source.slot)) {
+
+				m_singles.emplace(path, pTexture);
+				m_bindings[path].pTexture = std::move(pTexture);
+				continue;
+			}
+		}
+
+		try {
+
+			auto pFile = std::make_shared<const DdsFile>(GetBakedPath(path));
+			const auto& desc = pFile->GetDescription();
+
+			if (desc.arraySize == 1u && !desc.isCubeMap) {
+
+				items.push_back({ desc.width,desc.height,desc.mipLevels,desc.format,(uint32_t)source.role });
+				bakedSources.push_back(path);
+				filePtrs.push_back(std::move(pFile));
+				continue;
+			}
+		}
+		catch (const DdsFile::Exception&) {
+		}
+
+		m_bindings[path].pTexture = GetSingle(gfx, path);
+	}
+
+	TexturePacker packer;
+	packer.Pack(items);
+
+	const auto& groups = packer.GetGroups();
+
+	for (size_t g = 0; g < groups.size(); g++) {
+
+		const auto& group = groups[g];
+
+		std::vector<std::string> members;
+		std::vector<const DdsFile*> files;
+
+		for (const auto i : group.items) {
+
+			members.push_back(bakedSources[i]);
+			files.push_back(filePtrs[i].get());
+		}
+
+		const auto packedPath = GetPackedPath(modelPath, members, group);
+
+		//stale when any member was baked again after it
+		std::error_code ec;
+		const auto packedTime = std::filesystem::last_write_time(packedPath, ec);
+
+		bool isFresh = !ec;
+
+		for (const auto& member : members) {
+
+			const auto bakedTime = std::filesystem::last_write_time(GetBakedPath(member), ec);
+
+			isFresh = isFresh && !ec && bakedTime <= packedTime;
+		}
+
+		//a group that fails to bake or load leaves its members on their own
+		std::shared_ptr<Bindable> pGroup;
+
+		try {
+
+			if (!isFresh) {
+
+				packer.Bake(g, files, packedPath);
+			}
+
+			pGroup = LoadDds(gfx, std::make_shared<const DdsFile>(packedPath), std::filesystem::path(packedPath).filename().string(),
+				pStreamer, m_sources.at(members.front()).slot, true);
+		}
+		catch (const DdsFile::Exception&) {
+
+			continue;
+		}
+
+		for (const auto i : group.items) {
+
+			const auto& placement = packer.GetPlacement(i);
+
+			auto& binding = m_bindings[bakedSources[i]];
+			binding.pTexture = pGroup;
+			binding.isPacked = true;
+			binding.slice = placement.slice;
+			binding.uv = placement.uv;
+		}
+	}
+
+	//baked but left out of every group, the file is already open
+	for (size_t i = 0; i < bakedSources.size(); i++) {
+
+		const auto& path = bakedSources[i];
+
+		if (m_bindings.count(path) == 0u) {
+
+			auto pTexture = LoadDds(gfx, filePtrs[i], std::filesystem::path(path).filename().string(), pStreamer, m_sources.at(path).slot);
+
+			m_singles.emplace(path, pTexture);
+			m_bindings[path].pTexture = std::move(pTexture);
+		}
+	}
+}
+
+const ModelTextures::Binding& ModelTextures::Get(const std::string& path) const
+{
+	return m_bindings.at(path);
+}
+
+std::shared_ptr<Bindable> ModelTextures::GetSingle(Graphics& gfx, const std::string& path)
+{
+	auto& pTexture = m_singles[path];
+
+	if (!pTexture) {
+
+		const auto& source = m_sources.at(path);
+
+		pTexture = LoadTexture(gfx, path, source.isSrgb, source.role, m_pJobs, m_pStreamer, m_decoded, source.slot);
+	}
+
+	return pTexture;
+}
+
+const std::shared_ptr<Bindable>& ModelTextures::GetSampler() const noexcept
+{
+	return m_pSampler;
+}
+
+Model::Model(Graphics& gfx, const std::string fileName, JobSystem* pJobs, TextureStreamer* pStreamer)
 	:
 	m_pWindow(std::make_unique<ModelWindow>())
 {
+	PROFILE_ZONE("Model::Model");
 
 	//creating importer
 	Assimp::Importer imp;
@@ -184,16 +738,20 @@ Model::Model(Graphics& gfx, const std::string fileName)
 	}
 	
 
+	//bake, pack and load every texture before the meshes pick theirs
+	ModelTextures textures(gfx, *pScene, fileName, pJobs, pStreamer);
+
 	//load all meshes from pScene
 	for (size_t i = 0; i < pScene->mNumMeshes; i++) {
 
 		//adding binded mesh into mesh pointer
-		m_meshPtrs.push_back(ParseMesh(gfx, *pScene->mMeshes[i],pScene->mMaterials));
+		m_meshPtrs.push_back(ParseMesh(gfx, *pScene->mMeshes[i],pScene->mMaterials,textures));
 	}
 
 	//updating root node
 	int nextId = 0;
 	m_pRoot = ParseNode(nextId,*pScene->mRootNode);
+	m_nodeCount = nextId;
 }
 
 void Model::Draw(Graphics& gfx) const noexcept(!IS_DEBUG)
@@ -205,6 +763,33 @@ void Model::Draw(Graphics& gfx) const noexcept(!IS_DEBUG)
 	m_pRoot->Draw(gfx, DirectX::XMMatrixIdentity());
 }
 
+void Model::CapturePose(std::vector<DirectX::XMFLOAT4X4>& pose) const
+{
+	//window transform is applied here instead of in Draw
+	if (auto node = m_pWindow->GetSelectedNode())
+	{
+		node->SetAppliedTransform(m_pWindow->GetTransform());
+	}
+
+	pose.resize(m_nodeCount);
+	m_pRoot->CapturePose(pose);
+}
+
+void Model::Draw(Graphics& gfx, const std::vector<DirectX::XMFLOAT4X4>& pose) const noexcept(!IS_DEBUG)
+{
+	m_pRoot->Draw(gfx, DirectX::XMMatrixIdentity(), pose);
+}
+
+void Model::Stage(const std::vector<DirectX::XMFLOAT4X4>& pose) const
+{
+	m_pRoot->Stage(DirectX::XMMatrixIdentity(), pose);
+}
+
+void Model::AddOccluders(OcclusionCuller& culler) const
+{
+	m_pRoot->AddOccluders(culler, DirectX::XMMatrixIdentity());
+}
+
 void Model::ShowWindow(const char* windowName) noexcept
 {
 
@@ -216,8 +801,9 @@ Model::~Model() noexcept
 }
 
 //binding every mesh
-std::unique_ptr<Mesh> Model::ParseMesh(Graphics& gfx, const aiMesh& mesh, const aiMaterial* const* pMaterials) {
+std::unique_ptr<Mesh> Model::ParseMesh(Graphics& gfx, const aiMesh& mesh, const aiMaterial* const* pMaterials, ModelTextures& textures) {
 
+	PROFILE_ZONE("Model::ParseMesh");
 
 	using MyDynamicVertex::VertexLayout;
 
@@ -255,25 +841,29 @@ std::unique_ptr<Mesh> Model::ParseMesh(Graphics& gfx, const aiMesh& mesh, const
 	std::vector<std::shared_ptr<Bindable>> bindablePtrs;
 
 	bool hasSpecularMap = false;
+	bool isPacked = false;
 	float shininess = 35.0f;
 
+	const ModelTextures::Binding* pDiffuse = nullptr;
+	const ModelTextures::Binding* pSpecular = nullptr;
+
 	//binding texture
 	if (mesh.mMaterialIndex >= 0) {
 
 		
 		auto& material = *pMaterials[mesh.mMaterialIndex];
 
-		using namespace std::string_literals;
-
-		const auto base = "asset\\model\\nano_textured\\"s;
-
 		aiString texFileName;
 		material.GetTexture(aiTextureType_DIFFUSE, 0, &texFileName);
-		bindablePtrs.push_back(std::make_shared<Bind::Texture>(gfx, Surface::FromFile(base + texFileName.C_Str())));
+		const auto diffusePath = textureDir + texFileName.C_Str();
+		pDiffuse = &textures.Get(diffusePath);
+
+		std::string specularPath;
 		
 		if (material.GetTexture(aiTextureType_SPECULAR, 0, &texFileName) == aiReturn_SUCCESS) {
 			
-			bindablePtrs.push_back(std::make_shared<Bind::Texture>(gfx, Surface::FromFile(base + texFileName.C_Str()), 1));
+			specularPath = textureDir + texFileName.C_Str();
+			pSpecular = &textures.Get(specularPath);
 			
 			hasSpecularMap = true;
 		}
@@ -282,7 +872,29 @@ std::unique_ptr<Mesh> Model::ParseMesh(Graphics& gfx, const aiMesh& mesh, const
 			material.Get(AI_MATKEY_SHININESS, shininess);
 		}
 
-		bindablePtrs.push_back(std::make_shared<Bind::Sampler>(gfx));
+		//the packed shaders read both maps from groups, so one unpacked map sends the whole mesh down the old path
+		isPacked = pDiffuse->isPacked && (pSpecular == nullptr || pSpecular->isPacked);
+
+		if (isPacked) {
+
+			bindablePtrs.push_back(pDiffuse->pTexture);
+
+			if (hasSpecularMap) {
+
+				bindablePtrs.push_back(pSpecular->pTexture);
+			}
+		}
+		else {
+
+			bindablePtrs.push_back(textures.GetSingle(gfx, diffusePath));
+
+			if (hasSpecularMap) {
+
+				bindablePtrs.push_back(textures.GetSingle(gfx, specularPath));
+			}
+		}
+
+		bindablePtrs.push_back(textures.GetSampler());
 	}
 
 
@@ -298,10 +910,35 @@ std::unique_ptr<Mesh> Model::ParseMesh(Graphics& gfx, const aiMesh& mesh, const
 	bindablePtrs.push_back(std::move(pvs));
 
 	//binding input layout
-	bindablePtrs.push_back(std::make_shared<InputLayout>(gfx, vbuf.GetLayout().GetD3DLayout(), pvsbc));
+	bindablePtrs.push_back(InputLayout::Resolve(gfx, vbuf.GetLayout().GetD3DLayout(), pvsbc));
 
 	//binding pixel shader
-	if (hasSpecularMap) {
+	if (isPacked) {
+
+		bindablePtrs.push_back(std::make_shared<Bind::PixelShader>(gfx, hasSpecularMap ? L"ModelPhongPSSpecMapPacked.cso" : L"ModelPhongPSPacked.cso"));
+
+		//where this mesh's textures are in the groups, the specular entries copy the diffuse ones without a map
+		const auto& specular = hasSpecularMap ? *pSpecular : *pDiffuse;
+
+		MyDynamicConstant::CbufLayout matLayout;
+		matLayout.Append(MyDynamicConstant::CbufLayout::Float4, "diffuseUv");
+		matLayout.Append(MyDynamicConstant::CbufLayout::Float4, "specularUv");
+		matLayout.Append(MyDynamicConstant::CbufLayout::Float, "diffuseSlice");
+		matLayout.Append(MyDynamicConstant::CbufLayout::Float, "specularSlice");
+		matLayout.Append(MyDynamicConstant::CbufLayout::Float, "specularIntensity");
+		matLayout.Append(MyDynamicConstant::CbufLayout::Float, "specularPower");
+
+		MyDynamicConstant::CbufBuffer pmc(std::move(matLayout));
+		pmc["diffuseUv"] = DirectX::XMFLOAT4{ pDiffuse->uv.scaleU,pDiffuse->uv.scaleV,pDiffuse->uv.offsetU,pDiffuse->uv.offsetV };
+		pmc["specularUv"] = DirectX::XMFLOAT4{ specular.uv.scaleU,specular.uv.scaleV,specular.uv.offsetU,specular.uv.offsetV };
+		pmc["diffuseSlice"] = (float)pDiffuse->slice;
+		pmc["specularSlice"] = (float)specular.slice;
+		pmc["specularIntensity"] = 0.8f;
+		pmc["specularPower"] = shininess;
+
+		bindablePtrs.push_back(std::make_shared<DynamicPixelConstantBuffer>(gfx, std::move(pmc), 1u));
+	}
+	else if (hasSpecularMap) {
 
 		bindablePtrs.push_back(std::make_shared<Bind::PixelShader>(gfx, L"ModelPhongPSSpecMap.cso"));
 
@@ -311,23 +948,88 @@ std::unique_ptr<Mesh> Model::ParseMesh(Graphics& gfx, const aiMesh& mesh, const
 		bindablePtrs.push_back(std::make_shared<Bind::PixelShader>(gfx, L"ModelPhongPS.cso"));
 
 		//creating material constant for pixel shader
-		struct PSMaterialConstant
-		{
+		MyDynamicConstant::CbufLayout matLayout;
+		matLayout.Append(MyDynamicConstant::CbufLayout::Float, "specularIntensity");
+		matLayout.Append(MyDynamicConstant::CbufLayout::Float, "specularPower");
 
-			float specularIntensity = 0.8f;
-			float specularPower;
-			float padding[2];
-		} pmc;
-
-		pmc.specularPower = shininess;
+		MyDynamicConstant::CbufBuffer pmc(std::move(matLayout));
+		pmc["specularIntensity"] = 0.8f;
+		pmc["specularPower"] = shininess;
 
 		//binding material constant
-		bindablePtrs.push_back(std::make_shared<PixelConstantBuffer<PSMaterialConstant>>(gfx, pmc, 1u));
+		bindablePtrs.push_back(std::make_shared<DynamicPixelConstantBuffer>(gfx, std::move(pmc), 1u));
 	}
 
 	
+	//bounding sphere around the box of the vertices, and how much uv one unit of surface covers on average
+	DirectX::XMFLOAT3 lo = { FLT_MAX,FLT_MAX,FLT_MAX };
+	DirectX::XMFLOAT3 hi = { -FLT_MAX,-FLT_MAX,-FLT_MAX };
+
+	for (unsigned int i = 0; i < mesh.mNumVertices; i++) {
+
+		const auto& v = mesh.mVertices[i];
+
+		lo = { std::min(lo.x,v.x),std::min(lo.y,v.y),std::min(lo.z,v.z) };
+		hi = { std::max(hi.x,v.x),std::max(hi.y,v.y),std::max(hi.z,v.z) };
+	}
+
+	const DirectX::XMFLOAT3 center = { (lo.x + hi.x) * 0.5f,(lo.y + hi.y) * 0.5f,(lo.z + hi.z) * 0.5f };
+	float radius = 0.0f;
+	double surfaceArea = 0.0;
+	double uvArea = 0.0;
+
+	for (unsigned int i = 0; i < mesh.mNumVertices; i++) {
+
+		const auto d = mesh.mVertices[i] - aiVector3D(center.x, center.y, center.z);
+
+		radius = std::max(radius, d.Length());
+	}
+
+	if (mesh.HasTextureCoords(0)) {
+
+		for (size_t i = 0; i + 2u < indices.size(); i += 3u) {
+
+			const auto& p0 = mesh.mVertices[indices[i]];
+			const auto& t0 = mesh.mTextureCoords[0][indices[i]];
+			const auto e1 = mesh.mVertices[indices[i + 1u]] - p0;
+			const auto e2 = mesh.mVertices[indices[i + 2u]] - p0;
+			const auto u1 = mesh.mTextureCoords[0][indices[i + 1u]] - t0;
+			const auto u2 = mesh.mTextureCoords[0][indices[i + 2u]] - t0;
+
+			surfaceArea += 0.5 * (e1 ^ e2).Length();
+			uvArea += 0.5 * std::abs(u1.x * u2.y - u1.y * u2.x);
+		}
+	}
+
 	//return a unique_ptr to mesh
-	return std::make_unique<Mesh>(gfx, std::move(bindablePtrs));
+	auto pMesh = std::make_unique<Mesh>(gfx, std::move(bindablePtrs));
+
+	pMesh->SetStreamingBounds(center, radius, surfaceArea > 0.0 ? (float)std::sqrt(uvArea / surfaceArea) : 0.0f);
+
+	//a coarse copy of the mesh hides what's behind it from the occlusion culler
+	{
+		std::vector<DirectX::XMFLOAT3> positions(mesh.mNumVertices);
+		std::transform(mesh.mVertices, mesh.mVertices + mesh.mNumVertices, positions.begin(), [](const aiVector3D& v) {
+
+			return DirectX::XMFLOAT3{ v.x,v.y,v.z };
+		});
+
+		pMesh->SetOccluder(OcclusionCuller::OccluderMesh::Simplify(positions, std::vector<uint32_t>(indices.begin(), indices.end()), occluderCells));
+	}
+
+	//an atlas item only covers part of the page the mip estimate is sized by
+	if (isPacked) {
+
+		for (const auto pBinding : { pDiffuse,pSpecular }) {
+
+			if (pBinding != nullptr) {
+
+				pMesh->SetUvScale(*pBinding->pTexture, std::max(pBinding->uv.scaleU, pBinding->uv.scaleV));
+			}
+		}
+	}
+
+	return pMesh;
 }
 
 
@@ -3,7 +3,10 @@
 #include "Drawable.h"
 #include "BindableBase.h"
 #include "Vertex.h"
+#include "Surface.h"
+#include "OcclusionCuller.h"
 #include <optional>
+#include <unordered_map>
 
 //assimp loading stuffs
 #include <assimp/Importer.hpp>
@@ -13,6 +16,11 @@
 
 using namespace Bind;
 
+namespace Bind {
+
+	class StreamedTexture;
+}
+
 class ModelException :public myException {
 
 public:
@@ -45,13 +53,38 @@ public:
 
 	//draw function
 	void Draw(Graphics& gfx, DirectX::FXMMATRIX accumulatedTransform) const noexcept(!IS_DEBUG);
+	//queue the transform for the frame's batched upload
+	void Stage(DirectX::FXMMATRIX accumulatedTransform) const;
 
 	//getting mesh's transform
 	DirectX::XMMATRIX GetTransformXM() const noexcept override;
 
+	//bounding sphere and uv span per unit in mesh space, what streamed textures size their mip requests by
+	void SetStreamingBounds(const DirectX::XMFLOAT3& center, float radius, float uvDensity) noexcept;
+	//fraction of a streamed texture the mesh's uvs map to, below one for an atlas item
+	void SetUvScale(const Bindable& texture, float uvScale) noexcept;
+
+	//simplified stand in drawn into the occlusion buffer, built on import
+	void SetOccluder(OcclusionCuller::OccluderMesh occluder) noexcept;
+	void AddOccluder(OcclusionCuller& culler, DirectX::FXMMATRIX accumulatedTransform) const;
+
+private:
+
+	//asks every streamed texture for the mip this draw needs
+	void RequestMips(Graphics& gfx, DirectX::FXMMATRIX accumulatedTransform) const noexcept;
+
 private:
 
 	mutable DirectX::XMFLOAT4X4 m_transform;	//mesh's transform
+
+	//streaming stuffs
+	std::vector<std::shared_ptr<Bind::StreamedTexture>> m_streamedPtrs;
+	std::vector<float> m_uvScales;
+	DirectX::XMFLOAT3 m_center = {};
+	float m_radius = 0.0f;
+	float m_uvDensity = 0.0f;
+
+	OcclusionCuller::OccluderMesh m_occluder;
 };
 
 
@@ -68,6 +101,11 @@ public:
 	Node(int id, const std::string& name, std::vector<Mesh*> meshPtrs, const DirectX::XMMATRIX& m_transform) noexcept(!IS_DEBUG);
 
 	void Draw(Graphics& gfx, DirectX::FXMMATRIX accumulatedTransform) const noexcept(!IS_DEBUG);
+	//draw with applied transforms taken from a captured pose (indexed by node id)
+	void Draw(Graphics& gfx, DirectX::FXMMATRIX accumulatedTransform, const std::vector<DirectX::XMFLOAT4X4>& pose) const noexcept(!IS_DEBUG);
+	void CapturePose(std::vector<DirectX::XMFLOAT4X4>& pose) const noexcept(!IS_DEBUG);
+	void Stage(DirectX::FXMMATRIX accumulatedTransform, const std::vector<DirectX::XMFLOAT4X4>& pose) const;
+	void AddOccluders(OcclusionCuller& culler, DirectX::FXMMATRIX accumulatedTransform) const;
 
 	void SetAppliedTransform(DirectX::FXMMATRIX transform) noexcept;
 	
@@ -133,10 +171,19 @@ class Model
 public:
 
 	//constructor
-	Model(Graphics& gfx, const std::string fileName);
+	//texture mips are generated on pJobs when given
+	//textures are streamed by pStreamer when given, fully resident otherwise
+	Model(Graphics& gfx, const std::string fileName, class JobSystem* pJobs = nullptr, class TextureStreamer* pStreamer = nullptr);
 
 	//draw
 	void Draw(Graphics& gfx) const noexcept(!IS_DEBUG);
+	//copies every node's applied transform so the model can be drawn on another thread
+	void CapturePose(std::vector<DirectX::XMFLOAT4X4>& pose) const;
+	void Draw(Graphics& gfx, const std::vector<DirectX::XMFLOAT4X4>& pose) const noexcept(!IS_DEBUG);
+	//stage every mesh transform of the pose before TransformCbuf::Flush
+	void Stage(const std::vector<DirectX::XMFLOAT4X4>& pose) const;
+	//every mesh's occluder at the nodes' current transforms, on the thread that owns the nodes
+	void AddOccluders(OcclusionCuller& culler) const;
 
 	//showing imgui window
 	void ShowWindow(const char* windowName = nullptr) noexcept;
@@ -147,7 +194,7 @@ public:
 private:
 
 	//binding every mesh
-	static std::unique_ptr<Mesh> ParseMesh(Graphics& gfx, const aiMesh& mesh, const aiMaterial* const* pMaterials);
+	static std::unique_ptr<Mesh> ParseMesh(Graphics& gfx, const aiMesh& mesh, const aiMaterial* const* pMaterials, class ModelTextures& textures);
 
 
 	std::unique_ptr<Node> ParseNode(int& nextID,const aiNode& node) noexcept;
@@ -156,6 +203,7 @@ private:
 
 	std::unique_ptr<Node> m_pRoot;
 	std::vector<std::unique_ptr<Mesh>> m_meshPtrs;
+	int m_nodeCount = 0;
 
 	//model window
 	std::unique_ptr<class ModelWindow> m_pWindow;
@@ -1,3 +1,4 @@
+#include "ClusteredLights.hlsli"
 
 //constant  buffert for chaning the light position every frame
 cbuffer LightCBuf
@@ -53,7 +54,12 @@ float4 main(float3 worldPos : Position, float3 n : Normal, float2 tc : TEXCOORD)
     dot(normalize(-r), normalize(worldPos))),
     specularPower);
     
+    //the swarm's lights in this pixel's cluster
+    float3 clusterDiffuse;
+    float3 clusterSpecular;
+    ShadeClusteredLights(worldPos, n, specularPower, clusterDiffuse, clusterSpecular);
+    
     //final color calculation 
-    return float4(saturate((diffuse + ambient) * tex.Sample(splr, tc).rgb+specular*specularReflectionColor), 1.0f);
+    return float4(saturate((diffuse + clusterDiffuse + ambient) * tex.Sample(splr, tc).rgb + (specular + clusterSpecular) * specularReflectionColor), 1.0f);
     
 }
\ No newline at end of file
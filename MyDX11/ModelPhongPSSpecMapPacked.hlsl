@@ -0,0 +1,85 @@
+#include "ClusteredLights.hlsli"
+
+//constant  buffert for chaning the light position every frame
+cbuffer LightCBuf
+{
+    
+    float3 lightPos;
+    float3 ambient;
+    float3 diffuseColor;
+    float diffuseIntensity;
+    float attConst;
+    float attLin;
+    float attQuad;
+};
+
+//where the mesh's textures live in the packed ones
+//uv transforms are scale in xy and offset in zw, intensity and power come from the map here
+cbuffer ObjectCBuf
+{
+    
+    float4 diffuseUv;
+    float4 specularUv;
+    float diffuseSlice;
+    float specularSlice;
+    float specularIntensity;
+    float specularPower;
+};
+
+Texture2DArray tex;
+Texture2DArray spec;
+
+SamplerState splr;
+
+//slice of a packed texture with the mesh's uvs moved into its rectangle
+//*the gradients come from the unwrapped uvs, frac alone would pick the smallest mip along the wrap
+float4 SamplePacked(Texture2DArray t, float4 uvTransform, float slice, float2 tc)
+{
+    const float2 uv = frac(tc) * uvTransform.xy + uvTransform.zw;
+    
+    return t.SampleGrad(splr, float3(uv, slice), ddx(tc) * uvTransform.xy, ddy(tc) * uvTransform.xy);
+}
+
+//taking position and normal of the pixel
+float4 main(float3 worldPos : Position, float3 n : Normal, float2 tc : TEXCOORD) : SV_Target
+{
+    //fragment to light vector data
+    const float3 vToL = lightPos - worldPos; //vector to light
+    const float distToL = length(vToL); //
+    const float3 dirToL = vToL / distToL; //direction to light
+    
+    //diffuse attenuation
+    const float att = 1.0f / (attConst + attLin * distToL + attQuad * (distToL * distToL));
+    
+    //diffuse intensity base on dot product
+    const float3 diffuse = diffuseColor * diffuseIntensity * att * max(0.0f, dot(dirToL, n));
+    
+    //reflected light vector
+    const float3 w = n * dot(vToL, n);
+    const float3 r = w * 2.0f - vToL;
+    
+    //calculate specular intensity based on angle 
+    //between viewing vector
+    //and refelction vector,
+    //narrow with power function
+    
+    const float4 specularSample = SamplePacked(spec, specularUv, specularSlice, tc);
+    
+    const float3 specularReflectionColor = specularSample.rgb;
+    const float specularSamplePower = pow(2.0f, specularSample.a * 13.0f);
+    
+    const float3 specular = att *
+    (diffuseColor * diffuseIntensity) *
+    pow(max(0.0f,
+    dot(normalize(-r), normalize(worldPos))),
+    specularSamplePower);
+    
+    //the swarm's lights in this pixel's cluster
+    float3 clusterDiffuse;
+    float3 clusterSpecular;
+    ShadeClusteredLights(worldPos, n, specularSamplePower, clusterDiffuse, clusterSpecular);
+    
+    //final color calculation 
+    return float4(saturate((diffuse + clusterDiffuse + ambient) * SamplePacked(tex, diffuseUv, diffuseSlice, tc).rgb + (specular + clusterSpecular) * specularReflectionColor), 1.0f);
+    
+}
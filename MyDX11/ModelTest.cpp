@@ -18,9 +18,25 @@ ModelTest::ModelTest(Graphics& gfx, std::mt19937& rng,
 	std::uniform_real_distribution<float>& rdist, 
 	DirectX::XMFLOAT3 material, float scale)
 	:
-	TestObject(gfx,rng,adist,ddist,odist,rdist)
+	TestObject(gfx,rng,adist,ddist,odist,rdist),
+	material(material),
+	scale(scale)
 {
 
+	pMesh = ResolveMesh(gfx);
+}
+
+std::shared_ptr<InstancedMesh> ModelTest::ResolveMesh(Graphics& gfx)
+{
+
+	static std::weak_ptr<InstancedMesh> pShared;
+
+	if (auto pMesh = pShared.lock()) {
+
+		return pMesh;
+	}
+
+
 	
 	using MyDynamicVertex::VertexLayout;
 	MyDynamicVertex::VertexBuffer vbuf(
@@ -37,52 +53,57 @@ ModelTest::ModelTest(Graphics& gfx, std::mt19937& rng,
 		aiProcess_Triangulate |
 		aiProcess_JoinIdenticalVertices
 	);
-	const auto pMesh = pModel->mMeshes[0];
+	const auto pAiMesh = pModel->mMeshes[0];
 
 	
 
-	for (unsigned int i = 0; i < pMesh->mNumVertices; i++)
+	for (unsigned int i = 0; i < pAiMesh->mNumVertices; i++)
 	{
 		vbuf.EmplaceBack(
-			DirectX::XMFLOAT3{ pMesh->mVertices[i].x * scale,pMesh->mVertices[i].y * scale,pMesh->mVertices[i].z * scale },
-			*reinterpret_cast<DirectX::XMFLOAT3*>(&pMesh->mNormals[i])
+			DirectX::XMFLOAT3{ pAiMesh->mVertices[i].x,pAiMesh->mVertices[i].y,pAiMesh->mVertices[i].z },
+			*reinterpret_cast<DirectX::XMFLOAT3*>(&pAiMesh->mNormals[i])
 			);
 	}
 
 	std::vector<unsigned short> indices;
-	indices.reserve(pMesh->mNumFaces * 3);
-	for (unsigned int i = 0; i < pMesh->mNumFaces; i++)
+	indices.reserve(pAiMesh->mNumFaces * 3);
+	for (unsigned int i = 0; i < pAiMesh->mNumFaces; i++)
 	{
-		const auto& face = pMesh->mFaces[i];
+		const auto& face = pAiMesh->mFaces[i];
 		assert(face.mNumIndices == 3);
 		indices.push_back(face.mIndices[0]);
 		indices.push_back(face.mIndices[1]);
 		indices.push_back(face.mIndices[2]);
 	}
 
-	AddBind(std::make_shared<VertexBuffer>(gfx, vbuf));
+	std::vector<std::shared_ptr<Bindable>> binds;
 
-	AddBind(std::make_shared<IndexBuffer>(gfx, indices));
+	binds.push_back(std::make_shared<VertexBuffer>(gfx, vbuf));
 
-	auto pvs = std::make_shared<VertexShader>(gfx, L"PhongVS.cso");
+	binds.push_back(std::make_shared<IndexBuffer>(gfx, indices));
+
+	auto pvs = std::make_shared<VertexShader>(gfx, L"InstancedPhongVS.cso");
 	auto pvsbc = pvs->GetByteCode();
-	AddBind(std::move(pvs));
+	binds.push_back(std::move(pvs));
 
-	AddBind(std::make_shared<PixelShader>(gfx, L"PhongPS.cso"));
+	//material comes from the instance
+	binds.push_back(std::make_shared<PixelShader>(gfx, L"InstancedPhongPS.cso"));
 
-	AddBind(std::make_shared<InputLayout>(gfx, vbuf.GetLayout().GetD3DLayout(), pvsbc));
+	binds.push_back(InputLayout::Resolve(gfx, InstancedMesh::WithInstanceLayout(vbuf.GetLayout().GetD3DLayout()), pvsbc));
 
-	AddBind(std::make_shared<Topology>(gfx, D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST));
+	auto pMesh = std::make_shared<InstancedMesh>(gfx, std::move(binds));
+	pShared = pMesh;
+	return pMesh;
+}
 
-	struct PSMaterialConstant
-	{
-		DirectX::XMFLOAT3 color;
-		float specularIntensity = 0.6f;
-		float specularPower = 30.0f;
-		float padding[3];
-	} pmc;
-	pmc.color = material;
-	AddBind(std::make_shared<PixelConstantBuffer<PSMaterialConstant>>(gfx, pmc, 1u));
-
-	AddBind(std::make_shared<TransformCbuf>(gfx, *this));
+float ModelTest::GetBoundingRadius() const noexcept
+{
+	return 1.75f * scale;
+}
+
+void ModelTest::WriteInstance(InstanceData& instance, DirectX::FXMMATRIX world) const noexcept
+{
+	TestObject::WriteInstance(instance, DirectX::XMMatrixScaling(scale, scale, scale) * world);
+
+	instance.materialColor = material;
 }
@@ -16,6 +16,20 @@ public:
 		DirectX::XMFLOAT3 material,
 		float scale);
 
+	//suzanne fits in a sphere of about 1.75 before scaling
+	float GetBoundingRadius() const noexcept override;
+
+	//scale is applied per instance, the suzanne mesh itself is shared
+	void WriteInstance(InstanceData& instance, DirectX::FXMMATRIX world) const noexcept override;
+
+private:
+
+	static std::shared_ptr<InstancedMesh> ResolveMesh(Graphics& gfx);
+
+private:
+
+	DirectX::XMFLOAT3 material;
+	float scale;
 
 };
 
@@ -18,7 +18,6 @@ cbuffer ObjectCBuf
    
     float specularIntensity;
     float specularPower;
-    float padding[2];
 };
 
 Texture2D tex;
@@ -0,0 +1,457 @@
+#include "ObjectSimulation.h"
+#include <cassert>
+#include <cmath>
+#include <emmintrin.h>
+
+namespace {
+
+	constexpr float pi = 3.141592654f;
+	constexpr float twoPi = 6.283185307f;
+
+	constexpr size_t Padded(size_t count) noexcept
+	{
+		return (count + 3u) & ~size_t(3u);
+	}
+
+	//angle - 2PI * round(angle / 2PI), into [-PI,PI] without a branch
+	//*cvtps rounds to nearest even like XMVectorModAngles, the angles are nowhere near int range
+	__m128 ModAngles4(__m128 angle) noexcept
+	{
+		const __m128 turns = _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_mul_ps(angle, _mm_set1_ps(1.0f / twoPi))));
+
+		return _mm_sub_ps(angle, _mm_mul_ps(turns, _mm_set1_ps(twoPi)));
+	}
+
+	//XMVectorSinCos's polynomials, angles folded into [-PI/2,PI/2] first
+	void SinCos4(__m128 angle, __m128& s, __m128& c) noexcept
+	{
+		__m128 x = ModAngles4(angle);
+
+		//sin(PI - x) is sin(x) and cos(PI - x) is -cos(x), so the outer half reflects in
+		const __m128 signBit = _mm_and_ps(x, _mm_set1_ps(-0.0f));
+		const __m128 reflected = _mm_sub_ps(_mm_or_ps(_mm_set1_ps(pi), signBit), x);
+		const __m128 isInner = _mm_cmple_ps(_mm_andnot_ps(signBit, x), _mm_set1_ps(pi * 0.5f));
+
+		x = _mm_or_ps(_mm_and_ps(isInner, x), _mm_andnot_ps(isInner, reflected));
+
+		const __m128 cosSign = _mm_or_ps(_mm_and_ps(isInner, _mm_set1_ps(1.0f)), _mm_andnot_ps(isInner, _mm_set1_ps(-1.0f)));
+		const __m128 x2 = _mm_mul_ps(x, x);
+
+		__m128 sin = _mm_set1_ps(-2.3889859e-08f);
+		sin = _mm_add_ps(_mm_mul_ps(sin, x2), _mm_set1_ps(2.7525562e-06f));
+		sin = _mm_add_ps(_mm_mul_ps(sin, x2), _mm_set1_ps(-0.00019840874f));
+		sin = _mm_add_ps(_mm_mul_ps(sin, x2), _mm_set1_ps(0.0083333310f));
+		sin = _mm_add_ps(_mm_mul_ps(sin, x2), _mm_set1_ps(-0.16666667f));
+		sin = _mm_add_ps(_mm_mul_ps(sin, x2), _mm_set1_ps(1.0f));
+		s = _mm_mul_ps(sin, x);
+
+		__m128 cos = _mm_set1_ps(-2.6051615e-07f);
+		cos = _mm_add_ps(_mm_mul_ps(cos, x2), _mm_set1_ps(2.4760495e-05f));
+		cos = _mm_add_ps(_mm_mul_ps(cos, x2), _mm_set1_ps(-0.0013888378f));
+		cos = _mm_add_ps(_mm_mul_ps(cos, x2), _mm_set1_ps(0.041666638f));
+		cos = _mm_add_ps(_mm_mul_ps(cos, x2), _mm_set1_ps(-0.5f));
+		cos = _mm_add_ps(_mm_mul_ps(cos, x2), _mm_set1_ps(1.0f));
+		c = _mm_mul_ps(cos, cosSign);
+	}
+
+	__m128 MultiplyAdd(__m128 a, __m128 b, __m128 c) noexcept
+	{
+		return _mm_add_ps(_mm_mul_ps(a, b), c);
+	}
+
+	//3x3 part of XMMatrixRotationRollPitchYaw (Rz * Rx * Ry) for 4 objects at once
+	//*m receives the 9 elements row major, one lane per object
+	void RollPitchYaw4(__m128 sp, __m128 cp, __m128 sy, __m128 cy, __m128 sr, __m128 cr, __m128* m) noexcept
+	{
+		const __m128 spsy = _mm_mul_ps(sp, sy);
+		const __m128 spcy = _mm_mul_ps(sp, cy);
+
+		m[0] = MultiplyAdd(sr, spsy, _mm_mul_ps(cr, cy));
+		m[1] = _mm_mul_ps(sr, cp);
+		m[2] = _mm_sub_ps(_mm_mul_ps(sr, spcy), _mm_mul_ps(cr, sy));
+
+		m[3] = _mm_sub_ps(_mm_mul_ps(cr, spsy), _mm_mul_ps(sr, cy));
+		m[4] = _mm_mul_ps(cr, cp);
+		m[5] = MultiplyAdd(cr, spcy, _mm_mul_ps(sr, sy));
+
+		m[6] = _mm_mul_ps(cp, sy);
+		m[7] = _mm_sub_ps(_mm_setzero_ps(), sp);
+		m[8] = _mm_mul_ps(cp, cy);
+	}
+}
+
+/// <summary>
+/// Handles
+/// </summary>
+
+ObjectSimulation::Handle ObjectSimulation::Spawn(const Motion& motion, float boundingRadius)
+{
+	//grow every stream by a whole SIMD lane group at once
+	if (m_count == m_r.size()) {
+
+		const size_t size = Padded(m_count + 1u);
+
+		m_r.resize(size, 0.0f);
+		for (size_t i = 0; i < AngleCount; i++) {
+
+			m_angles[i].resize(size, 0.0f);
+			m_rates[i].resize(size, 0.0f);
+			m_previousAngles[i].resize(size, 0.0f);
+		}
+		m_radius.resize(size, 0.0f);
+		m_transforms.resize(size);
+		m_visible.resize(size, 1u);
+	}
+
+	uint32_t slot;
+
+	if (!m_freeSlots.empty()) {
+
+		slot = m_freeSlots.back();
+		m_freeSlots.pop_back();
+	}
+	else {
+
+		slot = (uint32_t)m_slots.size();
+		m_slots.push_back({ 0u,0u });
+	}
+
+	const size_t index = m_count++;
+
+	m_slots[slot].dense = (uint32_t)index;
+	m_denseToSlot.push_back(slot);
+	Write(index, motion);
+	m_radius[index] = boundingRadius;
+	m_visible[index] = 1u;
+
+	return { slot,m_slots[slot].generation };
+}
+
+size_t ObjectSimulation::Despawn(Handle handle) noexcept
+{
+	assert("Despawning a stale object handle" && IsValid(handle));
+
+	const size_t index = m_slots[handle.index].dense;
+	const size_t last = m_count - 1u;
+
+	//move the last object into the hole so the streams stay dense
+	if (index != last) {
+
+		m_r[index] = m_r[last];
+		for (size_t i = 0; i < AngleCount; i++) {
+
+			m_angles[i][index] = m_angles[i][last];
+			m_rates[i][index] = m_rates[i][last];
+			m_previousAngles[i][index] = m_previousAngles[i][last];
+		}
+		m_radius[index] = m_radius[last];
+		m_transforms[index] = m_transforms[last];
+		m_visible[index] = m_visible[last];
+
+		const uint32_t movedSlot = m_denseToSlot[last];
+		m_slots[movedSlot].dense = (uint32_t)index;
+		m_denseToSlot[index] = movedSlot;
+	}
+
+	m_denseToSlot.pop_back();
+	m_count--;
+
+	//bump the generation so old handles to this slot stop resolving
+	m_slots[handle.index].generation++;
+	m_freeSlots.push_back(handle.index);
+
+	return index;
+}
+
+void ObjectSimulation::Clear() noexcept
+{
+	for (const auto slot : m_denseToSlot) {
+
+		m_slots[slot].generation++;
+		m_freeSlots.push_back(slot);
+	}
+
+	m_denseToSlot.clear();
+	m_count = 0u;
+}
+
+bool ObjectSimulation::IsValid(Handle handle) const noexcept
+{
+	return handle.index < m_slots.size() &&
+		m_slots[handle.index].generation == handle.generation &&
+		m_slots[handle.index].dense < m_count &&
+		m_denseToSlot[m_slots[handle.index].dense] == handle.index;
+}
+
+size_t ObjectSimulation::GetIndex(Handle handle) const noexcept
+{
+	assert("Looking up a stale object handle" && IsValid(handle));
+	return m_slots[handle.index].dense;
+}
+
+ObjectSimulation::Handle ObjectSimulation::GetHandle(size_t index) const noexcept
+{
+	assert("Handle index out of range" && index < m_count);
+
+	const uint32_t slot = m_denseToSlot[index];
+	return { slot,m_slots[slot].generation };
+}
+
+size_t ObjectSimulation::GetCount() const noexcept
+{
+	return m_count;
+}
+
+size_t ObjectSimulation::GetGroupCount() const noexcept
+{
+	return GetPaddedCount() / groupWidth;
+}
+
+size_t ObjectSimulation::GetPaddedCount() const noexcept
+{
+	return Padded(m_count);
+}
+
+ObjectSimulation::Motion ObjectSimulation::GetMotion(Handle handle) const noexcept
+{
+	const size_t i = GetIndex(handle);
+
+	Motion motion;
+	motion.r = m_r[i];
+	motion.roll = m_angles[Roll][i];
+	motion.pitch = m_angles[Pitch][i];
+	motion.yaw = m_angles[Yaw][i];
+	motion.theta = m_angles[Theta][i];
+	motion.phi = m_angles[Phi][i];
+	motion.chi = m_angles[Chi][i];
+	motion.droll = m_rates[Roll][i];
+	motion.dpitch = m_rates[Pitch][i];
+	motion.dyaw = m_rates[Yaw][i];
+	motion.dtheta = m_rates[Theta][i];
+	motion.dphi = m_rates[Phi][i];
+	motion.dchi = m_rates[Chi][i];
+
+	return motion;
+}
+
+void ObjectSimulation::SetMotion(Handle handle, const Motion& motion) noexcept
+{
+	Write(GetIndex(handle), motion);
+}
+
+void ObjectSimulation::Write(size_t i, const Motion& motion) noexcept
+{
+	m_r[i] = motion.r;
+	m_angles[Roll][i] = motion.roll;
+	m_angles[Pitch][i] = motion.pitch;
+	m_angles[Yaw][i] = motion.yaw;
+	m_angles[Theta][i] = motion.theta;
+	m_angles[Phi][i] = motion.phi;
+	m_angles[Chi][i] = motion.chi;
+	m_rates[Roll][i] = motion.droll;
+	m_rates[Pitch][i] = motion.dpitch;
+	m_rates[Yaw][i] = motion.dyaw;
+	m_rates[Theta][i] = motion.dtheta;
+	m_rates[Phi][i] = motion.dphi;
+	m_rates[Chi][i] = motion.dchi;
+
+	//an edited object jumps, blending from where it was would show a sweep instead
+	for (size_t a = 0; a < AngleCount; a++) {
+
+		m_previousAngles[a][i] = m_angles[a][i];
+	}
+}
+
+/// <summary>
+/// Kernels
+/// </summary>
+
+void ObjectSimulation::Update(float dt) noexcept
+{
+	Update(dt, 0u, GetGroupCount());
+}
+
+void ObjectSimulation::Update(float dt, size_t firstGroup, size_t lastGroup) noexcept
+{
+	if (dt == 0.0f) {
+
+		return;
+	}
+
+	const size_t first = firstGroup * groupWidth;
+	const size_t last = lastGroup * groupWidth;
+	const __m128 vdt = _mm_set1_ps(dt);
+
+	//one stream at a time keeps each loop to two sequential reads and one write
+	for (size_t a = 0; a < AngleCount; a++) {
+
+		float* pAngle = m_angles[a].data();
+		float* pPrevious = m_previousAngles[a].data();
+		const float* pRate = m_rates[a].data();
+
+		for (size_t i = first; i < last; i += groupWidth) {
+
+			const __m128 previous = _mm_loadu_ps(pAngle + i);
+			_mm_storeu_ps(pPrevious + i, previous);
+
+			const __m128 angle = MultiplyAdd(_mm_loadu_ps(pRate + i), vdt, previous);
+			_mm_storeu_ps(pAngle + i, ModAngles4(angle));
+		}
+	}
+}
+
+void ObjectSimulation::EmitTransforms() noexcept
+{
+	EmitTransforms(0u, GetGroupCount());
+}
+
+void ObjectSimulation::EmitTransforms(size_t firstGroup, size_t lastGroup) noexcept
+{
+	EmitTransforms(1.0f, firstGroup, lastGroup);
+}
+
+void ObjectSimulation::EmitTransforms(float alpha, size_t firstGroup, size_t lastGroup) noexcept
+{
+	const size_t first = firstGroup * groupWidth;
+	const size_t last = lastGroup * groupWidth;
+	const bool isBlended = alpha < 1.0f;
+	const __m128 valpha = _mm_set1_ps(alpha);
+
+	for (size_t i = first; i < last; i += groupWidth) {
+
+		__m128 s[AngleCount];
+		__m128 c[AngleCount];
+
+		for (size_t a = 0; a < AngleCount; a++) {
+
+			__m128 angle = _mm_loadu_ps(m_angles[a].data() + i);
+
+			//the short way around, the step may have wrapped the angle past PI
+			if (isBlended) {
+
+				const __m128 previous = _mm_loadu_ps(m_previousAngles[a].data() + i);
+				angle = MultiplyAdd(ModAngles4(_mm_sub_ps(angle, previous)), valpha, previous);
+			}
+
+			SinCos4(angle, s[a], c[a]);
+		}
+
+		//local spin and orbit rotation
+		__m128 local[9];
+		__m128 orbit[9];
+		RollPitchYaw4(s[Pitch], c[Pitch], s[Yaw], c[Yaw], s[Roll], c[Roll], local);
+		RollPitchYaw4(s[Theta], c[Theta], s[Phi], c[Phi], s[Chi], c[Chi], orbit);
+
+		//rotation part is local * orbit, the translation (r,0,0) only picks up the orbit
+		__m128 m[9];
+		for (size_t row = 0; row < 3; row++) {
+
+			for (size_t col = 0; col < 3; col++) {
+
+				__m128 v = _mm_mul_ps(local[row * 3], orbit[col]);
+				v = MultiplyAdd(local[row * 3 + 1], orbit[3 + col], v);
+				m[row * 3 + col] = MultiplyAdd(local[row * 3 + 2], orbit[6 + col], v);
+			}
+		}
+
+		const __m128 r = _mm_loadu_ps(m_r.data() + i);
+
+		//lanes hold one element of 4 matrices, transpose back into 4 rows per matrix
+		__m128 rows[4][4] = {
+			{ m[0],m[1],m[2],_mm_setzero_ps() },
+			{ m[3],m[4],m[5],_mm_setzero_ps() },
+			{ m[6],m[7],m[8],_mm_setzero_ps() },
+			{ _mm_mul_ps(r, orbit[0]),_mm_mul_ps(r, orbit[1]),_mm_mul_ps(r, orbit[2]),_mm_set1_ps(1.0f) },
+		};
+
+		for (auto& row : rows) {
+
+			_MM_TRANSPOSE4_PS(row[0], row[1], row[2], row[3]);
+		}
+
+		for (size_t k = 0; k < groupWidth; k++) {
+
+			auto& transform = m_transforms[i + k];
+
+			for (size_t row = 0; row < 4; row++) {
+
+				_mm_storeu_ps(transform.m[row], rows[row][k]);
+			}
+		}
+	}
+}
+
+void ObjectSimulation::Cull(const DirectX::XMFLOAT4X4& viewProj, size_t firstGroup, size_t lastGroup) noexcept
+{
+	//clip planes straight from the view projection columns (D3D depth range 0..w)
+	const auto& v = viewProj.m;
+	float planes[6][4];
+
+	for (size_t k = 0; k < 4; k++) {
+
+		planes[0][k] = v[k][3] + v[k][0];	//left
+		planes[1][k] = v[k][3] - v[k][0];	//right
+		planes[2][k] = v[k][3] + v[k][1];	//bottom
+		planes[3][k] = v[k][3] - v[k][1];	//top
+		planes[4][k] = v[k][2];				//near
+		planes[5][k] = v[k][3] - v[k][2];	//far
+	}
+
+	for (auto& p : planes) {
+
+		const float scale = 1.0f / std::sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+
+		for (auto& e : p) {
+
+			e *= scale;
+		}
+	}
+
+	const size_t first = firstGroup * groupWidth;
+	const size_t last = lastGroup * groupWidth;
+
+	for (size_t i = first; i < last; i += groupWidth) {
+
+		//sphere centers are the translation rows, transposed to x/y/z lanes
+		__m128 x = _mm_loadu_ps(m_transforms[i].m[3]);
+		__m128 y = _mm_loadu_ps(m_transforms[i + 1].m[3]);
+		__m128 z = _mm_loadu_ps(m_transforms[i + 2].m[3]);
+		__m128 w = _mm_loadu_ps(m_transforms[i + 3].m[3]);
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+
+		const __m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(m_radius.data() + i));
+		int inside = 0xf;
+
+		for (const auto& p : planes) {
+
+			__m128 d = MultiplyAdd(_mm_set1_ps(p[0]), x, _mm_set1_ps(p[3]));
+			d = MultiplyAdd(_mm_set1_ps(p[1]), y, d);
+			d = MultiplyAdd(_mm_set1_ps(p[2]), z, d);
+
+			inside &= _mm_movemask_ps(_mm_cmpge_ps(d, negRadius));
+		}
+
+		for (size_t k = 0; k < groupWidth; k++) {
+
+			m_visible[i + k] = (uint8_t)((inside >> k) & 1);
+		}
+	}
+}
+
+const DirectX::XMFLOAT4X4& ObjectSimulation::GetTransform(size_t index) const noexcept
+{
+	assert("Transform index out of range" && index < m_count);
+	return m_transforms[index];
+}
+
+bool ObjectSimulation::IsVisible(size_t index) const noexcept
+{
+	assert("Visibility index out of range" && index < m_count);
+	return m_visible[index] != 0u;
+}
+
+float ObjectSimulation::GetBoundingRadius(size_t index) const noexcept
+{
+	assert("Bounding radius index out of range" && index < m_count);
+	return m_radius[index];
+}
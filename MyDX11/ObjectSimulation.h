@@ -0,0 +1,142 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <vector>
+#include <array>
+#include <cstdint>
+
+/// <summary>
+/// Orbiting test object motion stored as structure of arrays
+/// one stream per angle/rate so Update and EmitTransforms run 4 objects per SIMD op
+/// objects are referred to by generational handles, spawn/despawn are O(1)
+/// the kernels also take ranges of 4 object groups so they can be split across jobs
+/// </summary>
+class ObjectSimulation {
+
+public:
+
+	//objects processed per SIMD op, kernel ranges are counted in these groups
+	static constexpr size_t groupWidth = 4u;
+
+	//stable reference to one object, stale once the object is despawned
+	struct Handle {
+
+		uint32_t index = UINT32_MAX;
+		uint32_t generation = 0u;
+
+		bool operator==(const Handle& rhs) const noexcept
+		{
+			return index == rhs.index && generation == rhs.generation;
+		}
+
+		bool operator<(const Handle& rhs) const noexcept
+		{
+			return index < rhs.index || (index == rhs.index && generation < rhs.generation);
+		}
+	};
+
+	//same parameters the test objects used to animate with
+	struct Motion {
+
+		//positional
+		float r = 0.0f;
+
+		//*rotation about the object center
+		float roll = 0.0f;
+		float pitch = 0.0f;
+		float yaw = 0.0f;
+
+		//*position around the center of the world space
+		float theta = 0.0f;
+		float phi = 0.0f;
+		float chi = 0.0f;
+
+		//angular speed(delta/s)
+		float droll = 0.0f;
+		float dpitch = 0.0f;
+		float dyaw = 0.0f;
+		float dtheta = 0.0f;
+		float dphi = 0.0f;
+		float dchi = 0.0f;
+	};
+
+public:
+
+	//bounding radius is in world units around the object's origin (used by Cull)
+	Handle Spawn(const Motion& motion, float boundingRadius = 1.0f);
+
+	//swaps the last object into the freed slot and returns that slot's dense index
+	//*owners of arrays parallel to the dense order mirror the same swap and pop
+	size_t Despawn(Handle handle) noexcept;
+	void Clear() noexcept;
+
+	bool IsValid(Handle handle) const noexcept;
+
+	//position of the object in the dense streams (and in GetTransform)
+	size_t GetIndex(Handle handle) const noexcept;
+	//handle of the object at a dense index
+	Handle GetHandle(size_t index) const noexcept;
+	size_t GetCount() const noexcept;
+	size_t GetGroupCount() const noexcept;
+
+	Motion GetMotion(Handle handle) const noexcept;
+	void SetMotion(Handle handle, const Motion& motion) noexcept;
+
+	//integrate every angle by its rate and wrap into [-PI,PI)
+	//*the angles before the step are kept, EmitTransforms can blend between them and the new ones
+	void Update(float dt) noexcept;
+	void Update(float dt, size_t firstGroup, size_t lastGroup) noexcept;
+
+	//rebuild all world matrices, same result as
+	//RotationRollPitchYaw(pitch,yaw,roll) * Translation(r,0,0) * RotationRollPitchYaw(theta,phi,chi)
+	void EmitTransforms() noexcept;
+	void EmitTransforms(size_t firstGroup, size_t lastGroup) noexcept;
+	//the same for the state alpha of the way from the one before the last Update to the current one
+	void EmitTransforms(float alpha, size_t firstGroup, size_t lastGroup) noexcept;
+
+	//bounding sphere vs view frustum test on the emitted transforms
+	void Cull(const DirectX::XMFLOAT4X4& viewProj, size_t firstGroup, size_t lastGroup) noexcept;
+
+	const DirectX::XMFLOAT4X4& GetTransform(size_t index) const noexcept;
+	bool IsVisible(size_t index) const noexcept;
+	float GetBoundingRadius(size_t index) const noexcept;
+
+private:
+
+	enum Angle {
+
+		Roll,
+		Pitch,
+		Yaw,
+		Theta,
+		Phi,
+		Chi,
+		AngleCount,
+	};
+
+	struct Slot {
+
+		uint32_t dense;
+		uint32_t generation;
+	};
+
+	void Write(size_t index, const Motion& motion) noexcept;
+	size_t GetPaddedCount() const noexcept;
+
+private:
+
+	//streams are padded to a multiple of 4 so the kernels never need a scalar tail
+	size_t m_count = 0u;
+	std::vector<float> m_r;
+	std::array<std::vector<float>, AngleCount> m_angles;
+	std::array<std::vector<float>, AngleCount> m_rates;
+	std::array<std::vector<float>, AngleCount> m_previousAngles;
+	std::vector<float> m_radius;
+	std::vector<DirectX::XMFLOAT4X4> m_transforms;
+	std::vector<uint8_t> m_visible;
+
+	//handle slot -> dense index, dense index -> handle slot
+	std::vector<Slot> m_slots;
+	std::vector<uint32_t> m_denseToSlot;
+	std::vector<uint32_t> m_freeSlots;
+};
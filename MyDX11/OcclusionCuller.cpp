@@ -0,0 +1,1076 @@
+#include "OcclusionCuller.h"
+#include <emmintrin.h>
+#include <immintrin.h>
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <unordered_map>
+
+#ifdef _MSC_VER
+//msvc compiles intrinsics of any level anywhere, gcc and clang need the target per function
+#define AVX2_KERNEL
+#else
+#define AVX2_KERNEL __attribute__((target("avx2")))
+#endif
+
+namespace {
+
+	//edges flatter than this (in pixels) are bounded by the triangle's top and bottom instead
+	constexpr float minEdgeHeight = 1.0e-4f;
+	//rows outside the triangle get a span that covers nothing
+	constexpr float noSpan = 1.0e30f;
+
+	constexpr uint32_t fullRow = 0xffffffffu;
+
+	//pixels [first,last) of a row of 32
+	uint32_t RowMask(int first, int last) noexcept
+	{
+		return (uint32_t)(~0ull << first) & ~(uint32_t)(~0ull << last);
+	}
+
+	//coverage of 8 rows of a tile from the x spans of the rows, base is the tile's left edge plus half a pixel
+	//*a pixel is covered when its center is inside the span, the first and last covered ones come from
+	//*ceil(lo - base) and floor(hi - base) done as truncation on values clamped to be positive
+	using CoverageKernel = void(*)(const float* pLo, const float* pHi, float base, uint32_t* pMasks);
+
+	void CoverageScalar(const float* pLo, const float* pHi, float base, uint32_t* pMasks)
+	{
+		for (unsigned int r = 0; r < OcclusionCuller::tileHeight; r++) {
+
+			//max first so a NaN ends up clamped, same as the SIMD versions
+			const float a = std::min(std::max(pLo[r] - base, 0.0f), 32.0f);
+			const float b = std::min(std::max(pHi[r] - base, -1.0f), 31.0f);
+
+			pMasks[r] = RowMask(32 - (int)(32.0f - a), (int)(b + 1.0f));
+		}
+	}
+
+	void CoverageSse2(const float* pLo, const float* pHi, float base, uint32_t* pMasks)
+	{
+		const __m128 vBase = _mm_set1_ps(base);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 minusOne = _mm_set1_ps(-1.0f);
+		const __m128 thirtyOne = _mm_set1_ps(31.0f);
+		const __m128 thirtyTwo = _mm_set1_ps(32.0f);
+
+		alignas(16) int32_t first[OcclusionCuller::tileHeight];
+		alignas(16) int32_t last[OcclusionCuller::tileHeight];
+
+		for (unsigned int r = 0; r < OcclusionCuller::tileHeight; r += 4u) {
+
+			const __m128 a = _mm_min_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(pLo + r), vBase), zero), thirtyTwo);
+			const __m128 b = _mm_min_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(pHi + r), vBase), minusOne), thirtyOne);
+
+			_mm_store_si128((__m128i*)(first + r), _mm_sub_epi32(_mm_set1_epi32(32), _mm_cvttps_epi32(_mm_sub_ps(thirtyTwo, a))));
+			_mm_store_si128((__m128i*)(last + r), _mm_cvttps_epi32(_mm_add_ps(b, one)));
+		}
+
+		//no per lane shifts before AVX2
+		for (unsigned int r = 0; r < OcclusionCuller::tileHeight; r++) {
+
+			pMasks[r] = RowMask(first[r], last[r]);
+		}
+	}
+
+	AVX2_KERNEL void CoverageAvx2(const float* pLo, const float* pHi, float base, uint32_t* pMasks)
+	{
+		const __m256 vBase = _mm256_set1_ps(base);
+		const __m256 thirtyTwo = _mm256_set1_ps(32.0f);
+
+		const __m256 a = _mm256_min_ps(_mm256_max_ps(_mm256_sub_ps(_mm256_loadu_ps(pLo), vBase), _mm256_setzero_ps()), thirtyTwo);
+		const __m256 b = _mm256_min_ps(_mm256_max_ps(_mm256_sub_ps(_mm256_loadu_ps(pHi), vBase), _mm256_set1_ps(-1.0f)), _mm256_set1_ps(31.0f));
+
+		const __m256i first = _mm256_sub_epi32(_mm256_set1_epi32(32), _mm256_cvttps_epi32(_mm256_sub_ps(thirtyTwo, a)));
+		const __m256i last = _mm256_cvttps_epi32(_mm256_add_ps(b, _mm256_set1_ps(1.0f)));
+
+		//shifts of 32 give 0, which is what an empty or full row needs
+		const __m256i ones = _mm256_set1_epi32(-1);
+
+		_mm256_storeu_si256((__m256i*)pMasks, _mm256_andnot_si256(_mm256_sllv_epi32(ones, last), _mm256_sllv_epi32(ones, first)));
+	}
+
+	constexpr CoverageKernel coverageKernels[] = { CoverageScalar,CoverageSse2,CoverageAvx2 };
+
+	//row vectors, a * b
+	DirectX::XMFLOAT4X4 Multiply(const DirectX::XMFLOAT4X4& a, const DirectX::XMFLOAT4X4& b) noexcept
+	{
+		DirectX::XMFLOAT4X4 result;
+
+		for (int r = 0; r < 4; r++) {
+
+			for (int c = 0; c < 4; c++) {
+
+				result.m[r][c] = a.m[r][0] * b.m[0][c] + a.m[r][1] * b.m[1][c] + a.m[r][2] * b.m[2][c] + a.m[r][3] * b.m[3][c];
+			}
+		}
+
+		return result;
+	}
+
+	//meshes this small cost less to draw as they are than what the grid makes of them, and they're exact
+	constexpr size_t lowPolyTriangles = 64u;
+
+	using Vec3 = std::array<double, 3>;
+
+	Vec3 Sub(const Vec3& a, const Vec3& b) noexcept
+	{
+		return { a[0] - b[0],a[1] - b[1],a[2] - b[2] };
+	}
+
+	//separating axis test of a triangle against a box around the origin with those half sizes, after Akenine-Moller
+	//*the box's own axes are left out, it's only asked about boxes within the triangle's bounds
+	bool IsTriangleTouchingBox(const std::array<Vec3, 3>& v, const Vec3& half) noexcept
+	{
+		const auto isSeparating = [&](const Vec3& axis) {
+
+			const double p0 = v[0][0] * axis[0] + v[0][1] * axis[1] + v[0][2] * axis[2];
+			const double p1 = v[1][0] * axis[0] + v[1][1] * axis[1] + v[1][2] * axis[2];
+			const double p2 = v[2][0] * axis[0] + v[2][1] * axis[1] + v[2][2] * axis[2];
+			const double r = half[0] * std::abs(axis[0]) + half[1] * std::abs(axis[1]) + half[2] * std::abs(axis[2]);
+
+			return std::min({ p0,p1,p2 }) > r || std::max({ p0,p1,p2 }) < -r;
+		};
+
+		//every edge crossed with every box axis
+		for (size_t i = 0; i < 3u; i++) {
+
+			const Vec3 e = Sub(v[(i + 1u) % 3u], v[i]);
+
+			if (isSeparating({ 0.0,-e[2],e[1] }) || isSeparating({ e[2],0.0,-e[0] }) || isSeparating({ -e[1],e[0],0.0 })) {
+
+				return false;
+			}
+		}
+
+		//and the triangle's plane
+		const Vec3 e1 = Sub(v[1], v[0]);
+		const Vec3 e2 = Sub(v[2], v[0]);
+
+		return !isSeparating({ e1[1] * e2[2] - e1[2] * e2[1],e1[2] * e2[0] - e1[0] * e2[2],e1[0] * e2[1] - e1[1] * e2[0] });
+	}
+}
+
+
+bool OcclusionCuller::OccluderMesh::IsEmpty() const noexcept
+{
+	return indices.empty();
+}
+
+size_t OcclusionCuller::OccluderMesh::GetTriangleCount() const noexcept
+{
+	return indices.size() / 3u;
+}
+
+OcclusionCuller::OccluderMesh OcclusionCuller::OccluderMesh::MakeBox()
+{
+	constexpr float side = 1.0f / 2.0f;
+
+	//same corners and winding as Cube::Make
+	return {
+		{
+			{ -side,-side,-side },{ side,-side,-side },{ -side,side,-side },{ side,side,-side },
+			{ -side,-side,side },{ side,-side,side },{ -side,side,side },{ side,side,side },
+		},
+		{
+			0,2,1,  2,3,1,
+			1,3,5,  3,7,5,
+			2,6,3,  3,6,7,
+			4,5,7,  4,7,6,
+			0,4,2,  2,4,6,
+			0,1,4,  1,5,4,
+		}
+	};
+}
+
+OcclusionCuller::OccluderMesh OcclusionCuller::OccluderMesh::Simplify(const std::vector<DirectX::XMFLOAT3>& vertices, const std::vector<uint32_t>& indices, unsigned int cells)
+{
+	if (cells == 0u) {
+
+		throw Exception(__LINE__, __FILE__, "Occluder simplified onto a grid of 0 cells");
+	}
+
+	if (indices.size() % 3u != 0u) {
+
+		throw Exception(__LINE__, __FILE__, "Occluder index count " + std::to_string(indices.size()) + " is not a whole number of triangles");
+	}
+
+	for (const uint32_t index : indices) {
+
+		if (index >= vertices.size()) {
+
+			throw Exception(__LINE__, __FILE__, "Occluder index " + std::to_string(index) + " past the " + std::to_string(vertices.size()) + " vertices");
+		}
+	}
+
+	const size_t nTriangles = indices.size() / 3u;
+
+	if (nTriangles <= lowPolyTriangles) {
+
+		return { vertices,indices };
+	}
+
+	OccluderMesh result;
+
+	Vec3 lo = { vertices.front().x,vertices.front().y,vertices.front().z };
+	Vec3 hi = lo;
+
+	for (const auto& v : vertices) {
+
+		lo = { std::min(lo[0],(double)v.x),std::min(lo[1],(double)v.y),std::min(lo[2],(double)v.z) };
+		hi = { std::max(hi[0],(double)v.x),std::max(hi[1],(double)v.y),std::max(hi[2],(double)v.z) };
+	}
+
+	const double extent = std::max({ hi[0] - lo[0],hi[1] - lo[1],hi[2] - lo[2] });
+
+	if (!(extent > 0.0)) {
+
+		return result;
+	}
+
+	const double cellSize = extent / cells;
+
+	//the bounds' shorter sides get fewer cells
+	std::array<int, 3> n;
+
+	for (size_t a = 0; a < 3u; a++) {
+
+		n[a] = std::clamp((int)std::ceil((hi[a] - lo[a]) / cellSize), 1, (int)cells);
+	}
+
+	const auto cellIndex = [&n](const std::array<int, 3>& c) {
+
+		return ((size_t)c[2] * n[1] + c[1]) * n[0] + c[0];
+	};
+
+	//triangles in grid units, a cell's corners are at whole numbers
+	std::vector<std::array<Vec3, 3>> triangles(nTriangles);
+
+	for (size_t t = 0; t < nTriangles; t++) {
+
+		for (size_t k = 0; k < 3u; k++) {
+
+			const auto& v = vertices[indices[t * 3u + k]];
+
+			triangles[t][k] = { (v.x - lo[0]) / cellSize,(v.y - lo[1]) / cellSize,(v.z - lo[2]) / cellSize };
+		}
+	}
+
+	//cells the surface passes through, grown by a hair so a triangle touching a side counts too
+	constexpr double margin = 1.0e-3;
+	std::vector<uint8_t> isSurface((size_t)n[0] * n[1] * n[2], 0u);
+
+	for (const auto& triangle : triangles) {
+
+		std::array<int, 3> first;
+		std::array<int, 3> last;
+
+		for (size_t a = 0; a < 3u; a++) {
+
+			const auto [tMin, tMax] = std::minmax({ triangle[0][a],triangle[1][a],triangle[2][a] });
+
+			first[a] = std::clamp((int)std::floor(tMin - margin), 0, n[a] - 1);
+			last[a] = std::clamp((int)std::floor(tMax + margin), 0, n[a] - 1);
+		}
+
+		for (int z = first[2]; z <= last[2]; z++) {
+
+			for (int y = first[1]; y <= last[1]; y++) {
+
+				for (int x = first[0]; x <= last[0]; x++) {
+
+					const size_t cell = cellIndex({ x,y,z });
+
+					if (isSurface[cell] != 0u) {
+
+						continue;
+					}
+
+					const Vec3 center = { x + 0.5,y + 0.5,z + 0.5 };
+					const std::array<Vec3, 3> relative = { Sub(triangle[0],center),Sub(triangle[1],center),Sub(triangle[2],center) };
+
+					isSurface[cell] = IsTriangleTouchingBox(relative, { 0.5 + margin,0.5 + margin,0.5 + margin }) ? 1u : 0u;
+				}
+			}
+		}
+	}
+
+	//a cell is inside when a line through it along an axis crosses the surface an odd number of times before it,
+	//asked along all three axes so a hole or a stray triangle only ever takes cells away
+	//*the lines run a little off the cell centers, by different amounts across and down so they don't go exactly through the edges
+	//*or diagonals of grid aligned meshes, any point of a cell the surface doesn't pass through is as inside as its center
+	constexpr double offsetU = 0.5 + 0.618034e-3;
+	constexpr double offsetV = 0.5 + 0.414214e-3;
+	std::vector<uint8_t> nInside(isSurface.size(), 0u);
+
+	for (size_t a = 0; a < 3u; a++) {
+
+		const size_t u = (a + 1u) % 3u;
+		const size_t v = (a + 2u) % 3u;
+
+		std::vector<std::vector<double>> crossings((size_t)n[u] * n[v]);
+
+		for (const auto& triangle : triangles) {
+
+			const double area = (triangle[1][u] - triangle[0][u]) * (triangle[2][v] - triangle[0][v]) - (triangle[2][u] - triangle[0][u]) * (triangle[1][v] - triangle[0][v]);
+
+			//edge on to the lines, they run past it
+			if (area == 0.0) {
+
+				continue;
+			}
+
+			const auto [uMin, uMax] = std::minmax({ triangle[0][u],triangle[1][u],triangle[2][u] });
+			const auto [vMin, vMax] = std::minmax({ triangle[0][v],triangle[1][v],triangle[2][v] });
+
+			const int firstU = std::max((int)std::ceil(uMin - offsetU), 0);
+			const int lastU = std::min((int)std::floor(uMax - offsetU), n[u] - 1);
+			const int firstV = std::max((int)std::ceil(vMin - offsetV), 0);
+			const int lastV = std::min((int)std::floor(vMax - offsetV), n[v] - 1);
+
+			for (int lv = firstV; lv <= lastV; lv++) {
+
+				for (int lu = firstU; lu <= lastU; lu++) {
+
+					const double pu = lu + offsetU;
+					const double pv = lv + offsetV;
+
+					//barycentric weights of the line's point in the triangle's shadow on the plane across the axis
+					std::array<double, 3> w;
+
+					for (size_t k = 0; k < 3u; k++) {
+
+						const auto& p = triangle[(k + 1u) % 3u];
+						const auto& q = triangle[(k + 2u) % 3u];
+
+						w[k] = ((p[u] - pu) * (q[v] - pv) - (q[u] - pu) * (p[v] - pv)) / area;
+					}
+
+					if (w[0] >= 0.0 && w[1] >= 0.0 && w[2] >= 0.0) {
+
+						crossings[(size_t)lv * n[u] + lu].push_back(w[0] * triangle[0][a] + w[1] * triangle[1][a] + w[2] * triangle[2][a]);
+					}
+				}
+			}
+		}
+
+		for (int lv = 0; lv < n[v]; lv++) {
+
+			for (int lu = 0; lu < n[u]; lu++) {
+
+				auto& line = crossings[(size_t)lv * n[u] + lu];
+				std::sort(line.begin(), line.end());
+
+				size_t nBefore = 0u;
+				std::array<int, 3> c;
+				c[u] = lu;
+				c[v] = lv;
+
+				for (c[a] = 0; c[a] < n[a]; c[a]++) {
+
+					while (nBefore < line.size() && line[nBefore] < c[a] + 0.5) {
+
+						nBefore++;
+					}
+
+					nInside[cellIndex(c)] += (uint8_t)(nBefore % 2u);
+				}
+			}
+		}
+	}
+
+	//cells wholly inside the mesh
+	const auto isSolid = [&](const std::array<int, 3>& c) {
+
+		for (size_t a = 0; a < 3u; a++) {
+
+			if (c[a] < 0 || c[a] >= n[a]) {
+
+				return false;
+			}
+		}
+
+		const size_t cell = cellIndex(c);
+
+		return nInside[cell] == 3u && isSurface[cell] == 0u;
+	};
+
+	//corners shared between faces are one vertex
+	std::unordered_map<uint64_t, uint32_t> vertexOfCorner;
+
+	const auto cornerVertex = [&](const std::array<int, 3>& c) {
+
+		const uint64_t key = ((uint64_t)c[2] * (n[1] + 1u) + c[1]) * (n[0] + 1u) + c[0];
+		const auto [it, isNew] = vertexOfCorner.emplace(key, (uint32_t)result.vertices.size());
+
+		if (isNew) {
+
+			result.vertices.push_back({ (float)(lo[0] + c[0] * cellSize),(float)(lo[1] + c[1] * cellSize),(float)(lo[2] + c[2] * cellSize) });
+		}
+
+		return it->second;
+	};
+
+	//the outside faces of the solid cells, every slice's merged into as few rectangles as it greedily can
+	//*the rectangles of neighbouring slices meet in T junctions, any crack between them only loses coverage
+	for (size_t a = 0; a < 3u; a++) {
+
+		const size_t u = (a + 1u) % 3u;
+		const size_t v = (a + 2u) % 3u;
+
+		std::vector<uint8_t> mask((size_t)n[u] * n[v]);
+
+		for (const int side : { -1,1 }) {
+
+			for (int k = 0; k < n[a]; k++) {
+
+				for (int lv = 0; lv < n[v]; lv++) {
+
+					for (int lu = 0; lu < n[u]; lu++) {
+
+						std::array<int, 3> c;
+						c[a] = k;
+						c[u] = lu;
+						c[v] = lv;
+
+						std::array<int, 3> neighbour = c;
+						neighbour[a] += side;
+
+						mask[(size_t)lv * n[u] + lu] = isSolid(c) && !isSolid(neighbour) ? 1u : 0u;
+					}
+				}
+
+				for (int lv = 0; lv < n[v]; lv++) {
+
+					for (int lu = 0; lu < n[u]; lu++) {
+
+						if (mask[(size_t)lv * n[u] + lu] == 0u) {
+
+							continue;
+						}
+
+						int width = 1;
+
+						while (lu + width < n[u] && mask[(size_t)lv * n[u] + lu + width] != 0u) {
+
+							width++;
+						}
+
+						int height = 1;
+
+						while (lv + height < n[v] &&
+							std::all_of(mask.begin() + (size_t)(lv + height) * n[u] + lu, mask.begin() + (size_t)(lv + height) * n[u] + lu + width, [](uint8_t m) { return m != 0u; })) {
+
+							height++;
+						}
+
+						for (int dv = 0; dv < height; dv++) {
+
+							std::fill_n(mask.begin() + (size_t)(lv + dv) * n[u] + lu, width, (uint8_t)0u);
+						}
+
+						std::array<std::array<int, 3>, 4> corners;
+
+						for (size_t i = 0; i < 4u; i++) {
+
+							corners[i][a] = side > 0 ? k + 1 : k;
+							corners[i][u] = lu + (i == 1u || i == 2u ? width : 0);
+							corners[i][v] = lv + (i >= 2u ? height : 0);
+						}
+
+						const uint32_t i0 = cornerVertex(corners[0]);
+						const uint32_t i1 = cornerVertex(corners[1]);
+						const uint32_t i2 = cornerVertex(corners[2]);
+						const uint32_t i3 = cornerVertex(corners[3]);
+
+						//u cross v is along the axis, so going u then v is clockwise seen from the side the axis points to
+						if (side > 0) {
+
+							result.indices.insert(result.indices.end(), { i0,i1,i2,i0,i2,i3 });
+						}
+						else {
+
+							result.indices.insert(result.indices.end(), { i0,i2,i1,i0,i3,i2 });
+						}
+					}
+				}
+			}
+		}
+	}
+
+	//the mesh as it is is exact, when the grid gives nothing cheaper it wins
+	if (result.GetTriangleCount() >= nTriangles) {
+
+		return { vertices,indices };
+	}
+
+	return result;
+}
+
+
+OcclusionCuller::OcclusionCuller(unsigned int width, unsigned int height)
+	:
+	m_isa(PixelKernels::GetIsa())
+{
+	Resize(width, height);
+}
+
+void OcclusionCuller::Resize(unsigned int width, unsigned int height)
+{
+	if (width == 0u || height == 0u || width % tileWidth != 0u || height % tileHeight != 0u) {
+
+		std::ostringstream oss;
+		oss << "Occlusion buffer of " << width << "x" << height << " is not a whole number of " << tileWidth << "x" << tileHeight << " tiles";
+
+		throw Exception(__LINE__, __FILE__, oss.str());
+	}
+
+	m_width = width;
+	m_height = height;
+	m_tilesX = width / tileWidth;
+	m_tilesY = height / tileHeight;
+
+	m_tiles.assign((size_t)m_tilesX * m_tilesY, Tile{});
+	m_bins.assign(m_tilesY, {});
+	m_triangles.clear();
+	m_stats = {};
+}
+
+unsigned int OcclusionCuller::GetWidth() const noexcept
+{
+	return m_width;
+}
+
+unsigned int OcclusionCuller::GetHeight() const noexcept
+{
+	return m_height;
+}
+
+size_t OcclusionCuller::GetTileRowCount() const noexcept
+{
+	return m_tilesY;
+}
+
+void OcclusionCuller::Begin(const DirectX::XMFLOAT4X4& viewProj)
+{
+	m_viewProj = viewProj;
+
+	//nothing drawn, every tile is infinitely far with an empty layer
+	std::fill(m_tiles.begin(), m_tiles.end(), Tile{});
+	m_triangles.clear();
+
+	for (auto& bin : m_bins) {
+
+		bin.clear();
+	}
+
+	m_stats = {};
+}
+
+void OcclusionCuller::AddOccluder(const OccluderMesh& mesh, const DirectX::XMFLOAT4X4& world)
+{
+	if (mesh.indices.size() % 3u != 0u) {
+
+		throw Exception(__LINE__, __FILE__, "Occluder index count " + std::to_string(mesh.indices.size()) + " is not a whole number of triangles");
+	}
+
+	const auto m = Multiply(world, m_viewProj);
+	const __m128 row0 = _mm_loadu_ps(m.m[0]);
+	const __m128 row1 = _mm_loadu_ps(m.m[1]);
+	const __m128 row2 = _mm_loadu_ps(m.m[2]);
+	const __m128 row3 = _mm_loadu_ps(m.m[3]);
+
+	m_clipVertices.resize(mesh.vertices.size());
+
+	for (size_t i = 0; i < mesh.vertices.size(); i++) {
+
+		const auto& v = mesh.vertices[i];
+		const __m128 clip = _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(_mm_set1_ps(v.x), row0), _mm_mul_ps(_mm_set1_ps(v.y), row1)),
+			_mm_add_ps(_mm_mul_ps(_mm_set1_ps(v.z), row2), row3));
+
+		_mm_storeu_ps(m_clipVertices[i].data(), clip);
+	}
+
+	m_stats.occluders++;
+
+	for (size_t i = 0; i < mesh.indices.size(); i += 3u) {
+
+		const uint32_t i0 = mesh.indices[i];
+		const uint32_t i1 = mesh.indices[i + 1u];
+		const uint32_t i2 = mesh.indices[i + 2u];
+
+		if (std::max({ i0,i1,i2 }) >= m_clipVertices.size()) {
+
+			throw Exception(__LINE__, __FILE__, "Occluder index past the " + std::to_string(m_clipVertices.size()) + " vertices");
+		}
+
+		m_stats.triangles++;
+
+		const std::array<const ClipVertex*, 3> triangle = { &m_clipVertices[i0],&m_clipVertices[i1],&m_clipVertices[i2] };
+
+		//all three past the same side plane
+		bool isOutside = false;
+
+		for (int axis = 0; axis < 2 && !isOutside; axis++) {
+
+			isOutside =
+				std::all_of(triangle.begin(), triangle.end(), [axis](const ClipVertex* p) { return (*p)[axis] < -(*p)[3]; }) ||
+				std::all_of(triangle.begin(), triangle.end(), [axis](const ClipVertex* p) { return (*p)[axis] > (*p)[3]; });
+		}
+
+		if (isOutside) {
+
+			continue;
+		}
+
+		//clipped by the near plane (z >= 0), the far and side planes are left to the screen bounds
+		std::array<ClipVertex, 4> polygon;
+		size_t nPolygon = 0u;
+
+		for (size_t k = 0; k < 3u; k++) {
+
+			const ClipVertex& a = *triangle[k];
+			const ClipVertex& b = *triangle[(k + 1u) % 3u];
+
+			if (a[2] >= 0.0f) {
+
+				polygon[nPolygon++] = a;
+			}
+
+			if ((a[2] >= 0.0f) != (b[2] >= 0.0f)) {
+
+				const float t = a[2] / (a[2] - b[2]);
+				ClipVertex& p = polygon[nPolygon++];
+
+				for (size_t c = 0; c < 4u; c++) {
+
+					p[c] = a[c] + t * (b[c] - a[c]);
+				}
+
+				//exactly on the plane, not a hair in front of it
+				p[2] = 0.0f;
+			}
+		}
+
+		for (size_t k = 2; k < nPolygon; k++) {
+
+			AddTriangle(polygon[0], polygon[k - 1u], polygon[k]);
+		}
+	}
+}
+
+void OcclusionCuller::AddTriangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2)
+{
+	//pixels, y down, and 1/w
+	struct ScreenVertex {
+
+		float x;
+		float y;
+		float z;
+	};
+
+	std::array<ScreenVertex, 3> v;
+	const std::array<const ClipVertex*, 3> clip = { &v0,&v1,&v2 };
+
+	for (size_t i = 0; i < 3u; i++) {
+
+		const auto& c = *clip[i];
+
+		//w is at least the near distance once clipped, unless the projection isn't a perspective one
+		if (!(c[3] > 0.0f)) {
+
+			return;
+		}
+
+		const float invW = 1.0f / c[3];
+
+		v[i] = { (c[0] * invW * 0.5f + 0.5f) * m_width,(0.5f - c[1] * invW * 0.5f) * m_height,invW };
+	}
+
+	//clockwise on screen is positive, anything else faces away or is too thin to cover a pixel center reliably
+	const float dx1 = v[1].x - v[0].x;
+	const float dy1 = v[1].y - v[0].y;
+	const float dx2 = v[2].x - v[0].x;
+	const float dy2 = v[2].y - v[0].y;
+	const float area = dx1 * dy2 - dx2 * dy1;
+
+	if (!(area > 1.0e-6f)) {
+
+		return;
+	}
+
+	const float xMin = std::min({ v[0].x,v[1].x,v[2].x });
+	const float xMax = std::max({ v[0].x,v[1].x,v[2].x });
+	const float yMin = std::min({ v[0].y,v[1].y,v[2].y });
+	const float yMax = std::max({ v[0].y,v[1].y,v[2].y });
+
+	if (xMax < 0.0f || yMax < 0.0f || xMin >= (float)m_width || yMin >= (float)m_height) {
+
+		return;
+	}
+
+	Triangle triangle;
+	triangle.leftSlope = { 0.0f,0.0f };
+	triangle.leftOffset = { -noSpan,-noSpan };
+	triangle.rightSlope = { 0.0f,0.0f };
+	triangle.rightOffset = { noSpan,noSpan };
+	triangle.top = yMin;
+	triangle.bottom = yMax;
+
+	//inside is to the right of every edge going clockwise, an edge going down bounds the rows on the right
+	size_t nLeft = 0u;
+	size_t nRight = 0u;
+
+	for (size_t i = 0; i < 3u; i++) {
+
+		const auto& p = v[i];
+		const auto& q = v[(i + 1u) % 3u];
+		const float dy = q.y - p.y;
+
+		if (std::abs(dy) < minEdgeHeight) {
+
+			continue;
+		}
+
+		const float slope = (q.x - p.x) / dy;
+		const float offset = p.x - p.y * slope;
+
+		//a triangle has at most two edges on either side
+		if (dy > 0.0f && nRight < 2u) {
+
+			triangle.rightSlope[nRight] = slope;
+			triangle.rightOffset[nRight++] = offset;
+		}
+		else if (dy < 0.0f && nLeft < 2u) {
+
+			triangle.leftSlope[nLeft] = slope;
+			triangle.leftOffset[nLeft++] = offset;
+		}
+	}
+
+	const float dz1 = v[1].z - v[0].z;
+	const float dz2 = v[2].z - v[0].z;
+
+	triangle.zx = (dz1 * dy2 - dz2 * dy1) / area;
+	triangle.zy = (dx1 * dz2 - dx2 * dz1) / area;
+	triangle.z0 = v[0].z - triangle.zx * v[0].x - triangle.zy * v[0].y;
+	triangle.zMin = std::min({ v[0].z,v[1].z,v[2].z });
+	triangle.zMax = std::max({ v[0].z,v[1].z,v[2].z });
+
+	triangle.left = (int)std::max(xMin, 0.0f);
+	triangle.right = (int)std::min(xMax, (float)(m_width - 1u));
+
+	const size_t firstRow = (size_t)std::max(yMin, 0.0f) / tileHeight;
+	const size_t lastRow = (size_t)std::min(yMax, (float)(m_height - 1u)) / tileHeight;
+	const uint32_t index = (uint32_t)m_triangles.size();
+
+	m_triangles.push_back(triangle);
+
+	for (size_t row = firstRow; row <= lastRow; row++) {
+
+		m_bins[row].push_back(index);
+	}
+
+	m_stats.drawnTriangles++;
+}
+
+void OcclusionCuller::Rasterize(size_t firstRow, size_t lastRow) noexcept
+{
+	lastRow = std::min(lastRow, (size_t)m_tilesY);
+
+	for (size_t row = firstRow; row < lastRow; row++) {
+
+		for (const uint32_t index : m_bins[row]) {
+
+			DrawTriangle(m_triangles[index], row);
+		}
+	}
+}
+
+void OcclusionCuller::Rasterize() noexcept
+{
+	Rasterize(0u, m_tilesY);
+}
+
+void OcclusionCuller::DrawTriangle(const Triangle& triangle, size_t tileRow) noexcept
+{
+	//x span of every row in the tile row, through pixel centers
+	alignas(32) float lo[tileHeight];
+	alignas(32) float hi[tileHeight];
+
+	const float rowTop = (float)(tileRow * tileHeight);
+
+	for (unsigned int r = 0; r < tileHeight; r++) {
+
+		const float y = rowTop + (float)r + 0.5f;
+
+		if (y < triangle.top || y > triangle.bottom) {
+
+			lo[r] = noSpan;
+			hi[r] = -noSpan;
+			continue;
+		}
+
+		lo[r] = std::max(triangle.leftSlope[0] * y + triangle.leftOffset[0], triangle.leftSlope[1] * y + triangle.leftOffset[1]);
+		hi[r] = std::min(triangle.rightSlope[0] * y + triangle.rightOffset[0], triangle.rightSlope[1] * y + triangle.rightOffset[1]);
+	}
+
+	//rectangle of the tile row the triangle can cover, its farthest depth in a tile bounds the triangle's there
+	const float yTop = std::max(rowTop, std::floor(triangle.top));
+	const float yBottom = std::min(rowTop + (float)tileHeight, std::floor(triangle.bottom) + 1.0f);
+	const float zRow = triangle.z0 + triangle.zy * (triangle.zy > 0.0f ? yTop : yBottom);
+
+	const CoverageKernel coverage = coverageKernels[(int)m_isa];
+	const unsigned int firstTile = (unsigned int)triangle.left / tileWidth;
+	const unsigned int lastTile = (unsigned int)triangle.right / tileWidth;
+
+	alignas(32) uint32_t masks[tileHeight];
+
+	for (unsigned int tx = firstTile; tx <= lastTile; tx++) {
+
+		Tile& tile = m_tiles[tileRow * m_tilesX + tx];
+
+		//already nearer everywhere than the nearest part of the triangle
+		if (triangle.zMax <= tile.zMin0) {
+
+			continue;
+		}
+
+		const float tileLeft = (float)(tx * tileWidth);
+
+		coverage(lo, hi, tileLeft + 0.5f, masks);
+
+		uint32_t any = 0u;
+
+		for (const uint32_t mask : masks) {
+
+			any |= mask;
+		}
+
+		if (any == 0u) {
+
+			continue;
+		}
+
+		const float xLeft = std::max(tileLeft, (float)triangle.left);
+		const float xRight = std::min(tileLeft + (float)tileWidth, (float)triangle.right + 1.0f);
+		const float z = std::max(zRow + triangle.zx * (triangle.zx > 0.0f ? xLeft : xRight), triangle.zMin);
+
+		UpdateTile(tile, masks, z);
+	}
+}
+
+void OcclusionCuller::UpdateTile(Tile& tile, const uint32_t* pCoverage, float z) noexcept
+{
+	//farther than what covers the whole tile, it adds nothing
+	if (z <= tile.zMin0) {
+
+		return;
+	}
+
+	uint32_t any = 0u;
+
+	for (const uint32_t mask : tile.mask) {
+
+		any |= mask;
+	}
+
+	//a triangle further in front of the layer than the layer is in front of the full tile starts a new layer,
+	//dropping the old one only ever loses occlusion
+	if (any == 0u || z - tile.zMin1 > tile.zMin1 - tile.zMin0) {
+
+		tile.mask.fill(0u);
+		tile.zMin1 = z;
+	}
+	else {
+
+		tile.zMin1 = std::min(tile.zMin1, z);
+	}
+
+	uint32_t all = fullRow;
+
+	for (unsigned int r = 0; r < tileHeight; r++) {
+
+		tile.mask[r] |= pCoverage[r];
+		all &= tile.mask[r];
+	}
+
+	//the layer covers the tile, it becomes what the whole tile is at least as near as
+	if (all == fullRow) {
+
+		tile.zMin0 = tile.zMin1;
+		tile.mask.fill(0u);
+	}
+}
+
+bool OcclusionCuller::IsVisible(const DirectX::XMFLOAT3& min, const DirectX::XMFLOAT3& max) const noexcept
+{
+	const auto& m = m_viewProj;
+
+	//four corners per register, the min z ones then the max z ones
+	const __m128 xs = _mm_setr_ps(min.x, max.x, min.x, max.x);
+	const __m128 ys = _mm_setr_ps(min.y, min.y, max.y, max.y);
+	const __m128 halfWidth = _mm_set1_ps(0.5f * m_width);
+	const __m128 halfHeight = _mm_set1_ps(0.5f * m_height);
+
+	__m128 xMin4 = _mm_set1_ps(noSpan);
+	__m128 xMax4 = _mm_set1_ps(-noSpan);
+	__m128 yMin4 = _mm_set1_ps(noSpan);
+	__m128 yMax4 = _mm_set1_ps(-noSpan);
+	__m128 zNear4 = _mm_setzero_ps();
+
+	for (const float z : { min.z,max.z }) {
+
+		const auto column = [&](int c) {
+
+			return _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(xs, _mm_set1_ps(m.m[0][c])), _mm_mul_ps(ys, _mm_set1_ps(m.m[1][c]))),
+				_mm_set1_ps(z * m.m[2][c] + m.m[3][c]));
+		};
+
+		const __m128 cz = column(2);
+		const __m128 cw = column(3);
+
+		//in front of the near plane (or behind the camera)
+		if (_mm_movemask_ps(_mm_or_ps(_mm_cmplt_ps(cz, _mm_setzero_ps()), _mm_cmple_ps(cw, _mm_setzero_ps()))) != 0) {
+
+			return true;
+		}
+
+		const __m128 invW = _mm_div_ps(_mm_set1_ps(1.0f), cw);
+		const __m128 sx = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(column(0), invW), _mm_set1_ps(1.0f)), halfWidth);
+		const __m128 sy = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(column(1), invW)), halfHeight);
+
+		xMin4 = _mm_min_ps(xMin4, sx);
+		xMax4 = _mm_max_ps(xMax4, sx);
+		yMin4 = _mm_min_ps(yMin4, sy);
+		yMax4 = _mm_max_ps(yMax4, sy);
+		zNear4 = _mm_max_ps(zNear4, invW);
+	}
+
+	alignas(16) float lanes[5][4];
+	_mm_store_ps(lanes[0], xMin4);
+	_mm_store_ps(lanes[1], xMax4);
+	_mm_store_ps(lanes[2], yMin4);
+	_mm_store_ps(lanes[3], yMax4);
+	_mm_store_ps(lanes[4], zNear4);
+
+	const float xMin = std::min({ lanes[0][0],lanes[0][1],lanes[0][2],lanes[0][3] });
+	const float xMax = std::max({ lanes[1][0],lanes[1][1],lanes[1][2],lanes[1][3] });
+	const float yMin = std::min({ lanes[2][0],lanes[2][1],lanes[2][2],lanes[2][3] });
+	const float yMax = std::max({ lanes[3][0],lanes[3][1],lanes[3][2],lanes[3][3] });
+	const float zNear = std::max({ lanes[4][0],lanes[4][1],lanes[4][2],lanes[4][3] });
+
+	if (xMax < 0.0f || yMax < 0.0f || xMin >= (float)m_width || yMin >= (float)m_height) {
+
+		return false;
+	}
+
+	//every pixel the rectangle touches, not just the centers inside it, so small boxes still get a pixel
+	const int px0 = (int)std::max(xMin, 0.0f);
+	const int px1 = (int)std::min(xMax, (float)(m_width - 1u));
+	const int py0 = (int)std::max(yMin, 0.0f);
+	const int py1 = (int)std::min(yMax, (float)(m_height - 1u));
+
+	for (int ty = py0 / (int)tileHeight; ty <= py1 / (int)tileHeight; ty++) {
+
+		const int rowTop = ty * (int)tileHeight;
+		const int firstRow = std::max(py0, rowTop) - rowTop;
+		const int lastRow = std::min(py1, rowTop + (int)tileHeight - 1) - rowTop;
+
+		for (int tx = px0 / (int)tileWidth; tx <= px1 / (int)tileWidth; tx++) {
+
+			const Tile& tile = m_tiles[(size_t)ty * m_tilesX + tx];
+
+			if (zNear < tile.zMin0) {
+
+				continue;
+			}
+
+			if (zNear >= tile.zMin1) {
+
+				return true;
+			}
+
+			const int tileLeft = tx * (int)tileWidth;
+			const uint32_t rect = RowMask(std::max(px0, tileLeft) - tileLeft, std::min(px1, tileLeft + (int)tileWidth - 1) - tileLeft + 1);
+
+			for (int r = firstRow; r <= lastRow; r++) {
+
+				if ((rect & ~tile.mask[r]) != 0u) {
+
+					return true;
+				}
+			}
+		}
+	}
+
+	return false;
+}
+
+bool OcclusionCuller::IsVisible(const DirectX::XMFLOAT3& center, float radius) const noexcept
+{
+	return IsVisible(
+		DirectX::XMFLOAT3{ center.x - radius,center.y - radius,center.z - radius },
+		DirectX::XMFLOAT3{ center.x + radius,center.y + radius,center.z + radius });
+}
+
+const OcclusionCuller::Stats& OcclusionCuller::GetStats() const noexcept
+{
+	return m_stats;
+}
+
+void OcclusionCuller::SetIsa(PixelKernels::Isa isa) noexcept
+{
+	m_isa = std::min(isa, PixelKernels::GetSupportedIsa());
+}
+
+PixelKernels::Isa OcclusionCuller::GetIsa() const noexcept
+{
+	return m_isa;
+}
+
+void OcclusionCuller::ResolveDepth(std::vector<float>& depth) const
+{
+	depth.resize((size_t)m_width * m_height);
+
+	for (unsigned int y = 0; y < m_height; y++) {
+
+		for (unsigned int x = 0; x < m_width; x++) {
+
+			const Tile& tile = m_tiles[(size_t)(y / tileHeight) * m_tilesX + x / tileWidth];
+			const bool isInLayer = (tile.mask[y % tileHeight] >> (x % tileWidth) & 1u) != 0u;
+
+			depth[(size_t)y * m_width + x] = isInLayer ? std::max(tile.zMin0, tile.zMin1) : tile.zMin0;
+		}
+	}
+}
+
+
+OcclusionCuller::Exception::Exception(int line, const char* file, std::string note) noexcept
+	:
+	myException(line, file),
+	note(std::move(note))
+{}
+
+const char* OcclusionCuller::Exception::what() const noexcept
+{
+	std::ostringstream oss;
+
+	oss << myException::what() << std::endl
+		<< "[Note] " << GetNote();
+
+	whatBuffer = oss.str();
+	return whatBuffer.c_str();
+}
+
+const char* OcclusionCuller::Exception::GetType() const noexcept
+{
+	return "SupaHotFire OcclusionCuller Exception";
+}
+
+const std::string& OcclusionCuller::Exception::GetNote() const noexcept
+{
+	return note;
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+#include "myException.h"
+#include "PixelKernels.h"
+#include <DirectXMath.h>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <array>
+
+/// <summary>
+/// Software occlusion culling against a small depth buffer drawn on the CPU, in the style of masked occlusion culling
+/// simplified occluder meshes are drawn into tiles of 32x8 pixels, instead of a depth per pixel a tile keeps a coverage bit per pixel and two depths:
+/// one every pixel of the tile is at least as near as and one for the pixels whose bit is set, the layer is merged into the first once the mask is full
+/// bounds are tested against the tiles they cover before their objects are drawn, anything behind all of them is occluded
+/// depths are 1/w so they interpolate linearly on screen, larger is nearer, so only perspective projections work
+/// tile rows are independent so drawing them can be split across jobs, works on plain numbers only so it builds and runs without windows
+/// </summary>
+class OcclusionCuller {
+
+public:
+
+	class Exception :public myException {
+
+	public:
+
+		Exception(int line, const char* file, std::string note) noexcept;
+		const char* what() const noexcept override;
+		const char* GetType() const noexcept override;
+
+		const std::string& GetNote() const noexcept;
+
+	private:
+
+		std::string note;
+	};
+
+	static constexpr unsigned int tileWidth = 32u;
+	static constexpr unsigned int tileHeight = 8u;
+
+	//triangles drawn into the depth buffer, clockwise ones face the camera like with the default rasterizer state
+	struct OccluderMesh {
+
+		std::vector<DirectX::XMFLOAT3> vertices;
+		std::vector<uint32_t> indices;
+
+		bool IsEmpty() const noexcept;
+		size_t GetTriangleCount() const noexcept;
+
+		//cube with sides of 1 around the origin
+		static OccluderMesh MakeBox();
+		//the cells of a grid with that many along the longest side of the bounds that are wholly inside the mesh, as a surface
+		//of rectangles, so it hides nothing the source wouldn't from any point outside it
+		//*inside is decided along all three axes, an open mesh gives nothing, and neither do parts thinner than a cell
+		//*meshes of a few triangles, or fewer than the grid makes, are returned as they are
+		static OccluderMesh Simplify(const std::vector<DirectX::XMFLOAT3>& vertices, const std::vector<uint32_t>& indices, unsigned int cells);
+	};
+
+	struct Stats {
+
+		size_t occluders = 0u;
+		//triangles handed in and the ones left after clipping and back face culling
+		size_t triangles = 0u;
+		size_t drawnTriangles = 0u;
+	};
+
+public:
+
+	//sizes have to be multiples of the tile size
+	OcclusionCuller(unsigned int width = 384u, unsigned int height = 216u);
+	OcclusionCuller(const OcclusionCuller&) = delete;
+	OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+
+	void Resize(unsigned int width, unsigned int height);
+	unsigned int GetWidth() const noexcept;
+	unsigned int GetHeight() const noexcept;
+	size_t GetTileRowCount() const noexcept;
+
+	//empties the buffer, triangles added after are projected with viewProj (row vectors, like DirectXMath)
+	void Begin(const DirectX::XMFLOAT4X4& viewProj);
+	//clips and sets up the mesh's triangles, world takes its vertices into world space
+	void AddOccluder(const OccluderMesh& mesh, const DirectX::XMFLOAT4X4& world);
+	//draws the triangles added into tile rows [firstRow,lastRow), ranges are independent so they can run in parallel
+	void Rasterize(size_t firstRow, size_t lastRow) noexcept;
+	void Rasterize() noexcept;
+
+	//false when the whole world space box is behind the occluders or off screen, boxes crossing the near plane are always visible
+	//*any number of threads can test at once after the rasterizing is done
+	bool IsVisible(const DirectX::XMFLOAT3& min, const DirectX::XMFLOAT3& max) const noexcept;
+	//tests the box around the sphere
+	bool IsVisible(const DirectX::XMFLOAT3& center, float radius) const noexcept;
+
+	const Stats& GetStats() const noexcept;
+
+	//level of the coverage kernel, the one PixelKernels picked to start with
+	void SetIsa(PixelKernels::Isa isa) noexcept;
+	PixelKernels::Isa GetIsa() const noexcept;
+
+	//nearest occluder depth (1/w) bounding every pixel, 0 where nothing was drawn, rows top to bottom
+	void ResolveDepth(std::vector<float>& depth) const;
+
+private:
+
+	struct Tile {
+
+		std::array<uint32_t, tileHeight> mask;
+		//every pixel is at least this near
+		float zMin0;
+		//pixels in the mask are at least this near
+		float zMin1;
+	};
+
+	//a clipped triangle in pixels, ready to draw
+	struct Triangle {
+
+		//x bounds of a row at height y are slope * y + offset, slots without an edge never bound
+		std::array<float, 2> leftSlope;
+		std::array<float, 2> leftOffset;
+		std::array<float, 2> rightSlope;
+		std::array<float, 2> rightOffset;
+		float top;
+		float bottom;
+
+		//1/w over the screen is zx * x + zy * y + z0, and its range over the vertices
+		float zx;
+		float zy;
+		float z0;
+		float zMin;
+		float zMax;
+
+		//inclusive pixel bounds
+		int left;
+		int right;
+	};
+
+	//x,y,z,w after the projection
+	using ClipVertex = std::array<float, 4>;
+
+	void AddTriangle(const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2);
+	void DrawTriangle(const Triangle& triangle, size_t tileRow) noexcept;
+	static void UpdateTile(Tile& tile, const uint32_t* pCoverage, float z) noexcept;
+
+private:
+
+	unsigned int m_width = 0u;
+	unsigned int m_height = 0u;
+	unsigned int m_tilesX = 0u;
+	unsigned int m_tilesY = 0u;
+
+	PixelKernels::Isa m_isa;
+
+	DirectX::XMFLOAT4X4 m_viewProj = {};
+	std::vector<Tile> m_tiles;
+	std::vector<Triangle> m_triangles;
+	//triangles overlapping each tile row
+	std::vector<std::vector<uint32_t>> m_bins;
+
+	//scratch for AddOccluder
+	std::vector<ClipVertex> m_clipVertices;
+
+	Stats m_stats;
+};
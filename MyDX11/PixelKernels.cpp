@@ -0,0 +1,845 @@
+#include "PixelKernels.h"
+#include <emmintrin.h>
+#include <immintrin.h>
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+//msvc compiles intrinsics of any level anywhere, gcc and clang need the target per function
+#define AVX2_KERNEL
+#else
+#define AVX2_KERNEL __attribute__((target("avx2")))
+#endif
+
+namespace {
+
+	//conversion tables shared by every kernel
+	struct ColorTables {
+
+		//linear values are looked up at this resolution when encoding back to sRGB
+		static constexpr unsigned int encodeSize = 16384u;
+
+		//256 color entries then 256 alpha entries, so one gather can decode a whole texel
+		float srgbToLinear[512];
+		float unormToFloat[512];
+
+		//padded so a four byte gather at the last entry stays inside
+		unsigned char linearToSrgb[encodeSize + 4u];
+
+		ColorTables()
+		{
+			for (unsigned int i = 0; i < 256u; i++) {
+
+				const double c = i / 255.0;
+
+				srgbToLinear[i] = (float)(c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4));
+				srgbToLinear[i + 256u] = (float)c;
+				unormToFloat[i] = (float)c;
+				unormToFloat[i + 256u] = (float)c;
+			}
+
+			for (unsigned int i = 0; i < encodeSize; i++) {
+
+				const double l = (double)i / (encodeSize - 1u);
+				const double c = l <= 0.0031308 ? l * 12.92 : 1.055 * std::pow(l, 1.0 / 2.4) - 0.055;
+
+				linearToSrgb[i] = (unsigned char)std::min(255.0, std::floor(c * 255.0 + 0.5));
+			}
+
+			std::fill(std::begin(linearToSrgb) + encodeSize, std::end(linearToSrgb), (unsigned char)255u);
+		}
+	};
+
+	const ColorTables& GetTables()
+	{
+		static const ColorTables tables;
+		return tables;
+	}
+
+	using Taps = PixelKernels::Resampler::Taps;
+
+	//one row (or run of floats) at a time, the public functions walk the rows
+	struct Kernels {
+
+		void (*fill)(uint32_t* pDst, size_t count, uint32_t value);
+		void (*swizzle)(const uint32_t* pSrc, uint32_t* pDst, size_t count);
+		void (*toLinear)(const uint32_t* pSrc, float* pDst, size_t count, const float* pTable, bool premultiply);
+		void (*fromLinear)(const float* pSrc, uint32_t* pDst, size_t count, bool isSrgb, bool unpremultiply);
+		void (*horizontal)(const float* pSrc, float* pDst, unsigned int count, const Taps* pTaps, const float* pWeights);
+		void (*vertical)(const float* const* pRows, const float* pWeights, unsigned int taps, float* pDst, size_t count);
+	};
+
+	//scalar, the reference the others have to match
+
+	void FillScalar(uint32_t* pDst, size_t count, uint32_t value)
+	{
+		std::fill_n(pDst, count, value);
+	}
+
+	void SwizzleScalar(const uint32_t* pSrc, uint32_t* pDst, size_t count)
+	{
+		for (size_t i = 0; i < count; i++) {
+
+			const uint32_t t = pSrc[i];
+			pDst[i] = (t & 0xFF00FF00u) | ((t >> 16u) & 0xFFu) | ((t & 0xFFu) << 16u);
+		}
+	}
+
+	void ToLinearScalar(const uint32_t* pSrc, float* pDst, size_t count, const float* pTable, bool premultiply)
+	{
+		for (size_t i = 0; i < count; i++) {
+
+			const uint32_t t = pSrc[i];
+			const float a = pTable[256u + (t >> 24u)];
+			const float m = premultiply ? a : 1.0f;
+
+			pDst[i * 4u + 0u] = pTable[t & 0xFFu] * m;
+			pDst[i * 4u + 1u] = pTable[(t >> 8u) & 0xFFu] * m;
+			pDst[i * 4u + 2u] = pTable[(t >> 16u) & 0xFFu] * m;
+			pDst[i * 4u + 3u] = a;
+		}
+	}
+
+	void FromLinearScalar(const float* pSrc, uint32_t* pDst, size_t count, bool isSrgb, bool unpremultiply)
+	{
+		const auto& tables = GetTables();
+		const float colorScale = isSrgb ? ColorTables::encodeSize - 1.0f : 255.0f;
+
+		for (size_t i = 0; i < count; i++) {
+
+			const float a = std::min(std::max(pSrc[i * 4u + 3u], 0.0f), 1.0f);
+			const float m = !unpremultiply ? 1.0f : (pSrc[i * 4u + 3u] > 0.0f ? 1.0f / pSrc[i * 4u + 3u] : 0.0f);
+
+			uint32_t texel = (uint32_t)(a * 255.0f + 0.5f) << 24u;
+
+			for (unsigned int c = 0; c < 3u; c++) {
+
+				const auto v = (uint32_t)(std::min(std::max(pSrc[i * 4u + c] * m, 0.0f), 1.0f) * colorScale + 0.5f);
+
+				texel |= (isSrgb ? tables.linearToSrgb[v] : v) << (c * 8u);
+			}
+
+			pDst[i] = texel;
+		}
+	}
+
+	//horizontal weights come four times over, one per channel, so the vector versions load them straight
+	void HorizontalScalar(const float* pSrc, float* pDst, unsigned int count, const Taps* pTaps, const float* pWeights)
+	{
+		for (unsigned int x = 0; x < count; x++) {
+
+			const float* pIn = pSrc + (size_t)pTaps[x].first * 4u;
+			const float* pW = pWeights + pTaps[x].weights;
+			float sum[4] = {};
+
+			for (unsigned int k = 0; k < pTaps[x].count * 4u; k++) {
+
+				sum[k % 4u] += pIn[k] * pW[k];
+			}
+
+			std::copy(sum, sum + 4, pDst + (size_t)x * 4u);
+		}
+	}
+
+	void VerticalScalar(const float* const* pRows, const float* pWeights, unsigned int taps, float* pDst, size_t count)
+	{
+		for (size_t i = 0; i < count; i++) {
+
+			float sum = 0.0f;
+
+			for (unsigned int k = 0; k < taps; k++) {
+
+				sum += pRows[k][i] * pWeights[k];
+			}
+
+			pDst[i] = sum;
+		}
+	}
+
+	//SSE2, every x86-64 cpu has it
+
+	void FillSse2(uint32_t* pDst, size_t count, uint32_t value)
+	{
+		const __m128i v = _mm_set1_epi32((int)value);
+		size_t i = 0;
+
+		for (; i + 4u <= count; i += 4u) {
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i), v);
+		}
+
+		FillScalar(pDst + i, count - i, value);
+	}
+
+	void SwizzleSse2(const uint32_t* pSrc, uint32_t* pDst, size_t count)
+	{
+		//no byte shuffle before SSSE3, red and blue are masked out and shifted past each other
+		const __m128i keep = _mm_set1_epi32((int)0xFF00FF00u);
+		const __m128i swap = _mm_set1_epi32(0x00FF00FF);
+		size_t i = 0;
+
+		for (; i + 4u <= count; i += 4u) {
+
+			const __m128i t = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i));
+			const __m128i rb = _mm_and_si128(t, swap);
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i),
+				_mm_or_si128(_mm_and_si128(t, keep), _mm_or_si128(_mm_slli_epi32(rb, 16), _mm_srli_epi32(rb, 16))));
+		}
+
+		SwizzleScalar(pSrc + i, pDst + i, count - i);
+	}
+
+	void ToLinearSse2(const uint32_t* pSrc, float* pDst, size_t count, const float* pTable, bool premultiply)
+	{
+		//no gather either, lookups go in lane by lane
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 alphaLane = _mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, -1));
+
+		for (size_t i = 0; i < count; i++) {
+
+			const uint32_t t = pSrc[i];
+			__m128 v = _mm_setr_ps(pTable[t & 0xFFu], pTable[(t >> 8u) & 0xFFu], pTable[(t >> 16u) & 0xFFu], pTable[256u + (t >> 24u)]);
+
+			if (premultiply) {
+
+				const __m128 a = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3));
+				v = _mm_mul_ps(v, _mm_or_ps(_mm_andnot_ps(alphaLane, a), _mm_and_ps(alphaLane, one)));
+			}
+
+			_mm_storeu_ps(pDst + i * 4u, v);
+		}
+	}
+
+	//b,g,r,a floats to integer levels, color scaled for the sRGB table or straight to 255
+	inline __m128i QuantizeSse2(__m128 v, __m128 scale, bool unpremultiply) noexcept
+	{
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+
+		if (unpremultiply) {
+
+			const __m128 alphaLane = _mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, -1));
+			const __m128 a = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3));
+			const __m128 inverse = _mm_and_ps(_mm_div_ps(one, a), _mm_cmpgt_ps(a, zero));
+
+			v = _mm_mul_ps(v, _mm_or_ps(_mm_andnot_ps(alphaLane, inverse), _mm_and_ps(alphaLane, one)));
+		}
+
+		v = _mm_min_ps(_mm_max_ps(v, zero), one);
+
+		return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, scale), _mm_set1_ps(0.5f)));
+	}
+
+	void FromLinearSse2(const float* pSrc, uint32_t* pDst, size_t count, bool isSrgb, bool unpremultiply)
+	{
+		const auto& tables = GetTables();
+		const float colorScale = isSrgb ? ColorTables::encodeSize - 1.0f : 255.0f;
+		const __m128 scale = _mm_setr_ps(colorScale, colorScale, colorScale, 255.0f);
+		size_t i = 0;
+
+		for (; i + 4u <= count; i += 4u) {
+
+			__m128i q[4];
+
+			for (unsigned int k = 0; k < 4u; k++) {
+
+				q[k] = QuantizeSse2(_mm_loadu_ps(pSrc + (i + k) * 4u), scale, unpremultiply);
+			}
+
+			if (isSrgb) {
+
+				alignas(16) uint32_t levels[16];
+
+				for (unsigned int k = 0; k < 4u; k++) {
+
+					_mm_store_si128(reinterpret_cast<__m128i*>(levels + k * 4u), q[k]);
+				}
+
+				for (unsigned int k = 0; k < 4u; k++) {
+
+					pDst[i + k] = tables.linearToSrgb[levels[k * 4u]] | (tables.linearToSrgb[levels[k * 4u + 1u]] << 8u) |
+						(tables.linearToSrgb[levels[k * 4u + 2u]] << 16u) | (levels[k * 4u + 3u] << 24u);
+				}
+			}
+			else {
+
+				const __m128i packed = _mm_packus_epi16(_mm_packs_epi32(q[0], q[1]), _mm_packs_epi32(q[2], q[3]));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i), packed);
+			}
+		}
+
+		FromLinearScalar(pSrc + i * 4u, pDst + i, count - i, isSrgb, unpremultiply);
+	}
+
+	void HorizontalSse2(const float* pSrc, float* pDst, unsigned int count, const Taps* pTaps, const float* pWeights)
+	{
+		for (unsigned int x = 0; x < count; x++) {
+
+			const float* pIn = pSrc + (size_t)pTaps[x].first * 4u;
+			const float* pW = pWeights + pTaps[x].weights;
+			__m128 sum = _mm_setzero_ps();
+
+			for (unsigned int k = 0; k < pTaps[x].count; k++) {
+
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(pIn + k * 4u), _mm_loadu_ps(pW + k * 4u)));
+			}
+
+			_mm_storeu_ps(pDst + (size_t)x * 4u, sum);
+		}
+	}
+
+	void VerticalSse2(const float* const* pRows, const float* pWeights, unsigned int taps, float* pDst, size_t count)
+	{
+		size_t i = 0;
+
+		for (; i + 4u <= count; i += 4u) {
+
+			__m128 sum = _mm_setzero_ps();
+
+			for (unsigned int k = 0; k < taps; k++) {
+
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(pRows[k] + i), _mm_set1_ps(pWeights[k])));
+			}
+
+			_mm_storeu_ps(pDst + i, sum);
+		}
+
+		for (; i < count; i++) {
+
+			float sum = 0.0f;
+
+			for (unsigned int k = 0; k < taps; k++) {
+
+				sum += pRows[k][i] * pWeights[k];
+			}
+
+			pDst[i] = sum;
+		}
+	}
+
+	//AVX2, two texels per register for the per texel kernels
+
+	AVX2_KERNEL void FillAvx2(uint32_t* pDst, size_t count, uint32_t value)
+	{
+		const __m256i v = _mm256_set1_epi32((int)value);
+		size_t i = 0;
+
+		for (; i + 8u <= count; i += 8u) {
+
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(pDst + i), v);
+		}
+
+		FillScalar(pDst + i, count - i, value);
+	}
+
+	AVX2_KERNEL void SwizzleAvx2(const uint32_t* pSrc, uint32_t* pDst, size_t count)
+	{
+		const __m256i order = _mm256_setr_epi8(
+			2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+			2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+		size_t i = 0;
+
+		for (; i + 8u <= count; i += 8u) {
+
+			const __m256i t = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pSrc + i));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(pDst + i), _mm256_shuffle_epi8(t, order));
+		}
+
+		SwizzleScalar(pSrc + i, pDst + i, count - i);
+	}
+
+	AVX2_KERNEL void ToLinearAvx2(const uint32_t* pSrc, float* pDst, size_t count, const float* pTable, bool premultiply)
+	{
+		//the alpha byte of each texel indexes the second half of the table
+		const __m256i alphaOffset = _mm256_setr_epi32(0, 0, 0, 256, 0, 0, 0, 256);
+		const __m256 one = _mm256_set1_ps(1.0f);
+		size_t i = 0;
+
+		for (; i + 2u <= count; i += 2u) {
+
+			const __m256i index = _mm256_add_epi32(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pSrc + i))), alphaOffset);
+			__m256 v = _mm256_i32gather_ps(pTable, index, 4);
+
+			if (premultiply) {
+
+				v = _mm256_mul_ps(v, _mm256_blend_ps(_mm256_permute_ps(v, _MM_SHUFFLE(3, 3, 3, 3)), one, 0x88));
+			}
+
+			_mm256_storeu_ps(pDst + i * 4u, v);
+		}
+
+		ToLinearScalar(pSrc + i, pDst + i * 4u, count - i, pTable, premultiply);
+	}
+
+	AVX2_KERNEL inline __m256i QuantizeAvx2(__m256 v, __m256 scale, bool unpremultiply) noexcept
+	{
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 one = _mm256_set1_ps(1.0f);
+
+		if (unpremultiply) {
+
+			const __m256 a = _mm256_permute_ps(v, _MM_SHUFFLE(3, 3, 3, 3));
+			const __m256 inverse = _mm256_and_ps(_mm256_div_ps(one, a), _mm256_cmp_ps(a, zero, _CMP_GT_OQ));
+
+			v = _mm256_mul_ps(v, _mm256_blend_ps(inverse, one, 0x88));
+		}
+
+		v = _mm256_min_ps(_mm256_max_ps(v, zero), one);
+
+		return _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(v, scale), _mm256_set1_ps(0.5f)));
+	}
+
+	AVX2_KERNEL void FromLinearAvx2(const float* pSrc, uint32_t* pDst, size_t count, bool isSrgb, bool unpremultiply)
+	{
+		const auto& tables = GetTables();
+		const float colorScale = isSrgb ? ColorTables::encodeSize - 1.0f : 255.0f;
+		const __m256 scale = _mm256_setr_ps(colorScale, colorScale, colorScale, 255.0f, colorScale, colorScale, colorScale, 255.0f);
+		const __m256i byteMask = _mm256_set1_epi32(0xFF);
+
+		//packing works on 128 bit lanes, this puts texels 0 1 2 3 back in order afterwards
+		const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+		size_t i = 0;
+
+		for (; i + 4u <= count; i += 4u) {
+
+			__m256i q0 = QuantizeAvx2(_mm256_loadu_ps(pSrc + i * 4u), scale, unpremultiply);
+			__m256i q1 = QuantizeAvx2(_mm256_loadu_ps(pSrc + i * 4u + 8u), scale, unpremultiply);
+
+			if (isSrgb) {
+
+				//byte table read four bytes at a time, the padding covers the last entries
+				const auto pTable = reinterpret_cast<const int*>(tables.linearToSrgb);
+
+				q0 = _mm256_blend_epi32(_mm256_and_si256(_mm256_i32gather_epi32(pTable, q0, 1), byteMask), q0, 0x88);
+				q1 = _mm256_blend_epi32(_mm256_and_si256(_mm256_i32gather_epi32(pTable, q1, 1), byteMask), q1, 0x88);
+			}
+
+			const __m256i words = _mm256_packus_epi32(q0, q1);
+			const __m256i bytes = _mm256_permutevar8x32_epi32(_mm256_packus_epi16(words, words), order);
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i), _mm256_castsi256_si128(bytes));
+		}
+
+		FromLinearScalar(pSrc + i * 4u, pDst + i, count - i, isSrgb, unpremultiply);
+	}
+
+	AVX2_KERNEL void HorizontalAvx2(const float* pSrc, float* pDst, unsigned int count, const Taps* pTaps, const float* pWeights)
+	{
+		for (unsigned int x = 0; x < count; x++) {
+
+			const float* pIn = pSrc + (size_t)pTaps[x].first * 4u;
+			const float* pW = pWeights + pTaps[x].weights;
+			const unsigned int n = pTaps[x].count;
+
+			//neighbouring taps are neighbouring texels, two of them fill a register
+			__m256 sum = _mm256_setzero_ps();
+			unsigned int k = 0;
+
+			for (; k + 2u <= n; k += 2u) {
+
+				sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(pIn + k * 4u), _mm256_loadu_ps(pW + k * 4u)));
+			}
+
+			__m128 total = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+
+			if (k < n) {
+
+				total = _mm_add_ps(total, _mm_mul_ps(_mm_loadu_ps(pIn + k * 4u), _mm_loadu_ps(pW + k * 4u)));
+			}
+
+			_mm_storeu_ps(pDst + (size_t)x * 4u, total);
+		}
+	}
+
+	AVX2_KERNEL void VerticalAvx2(const float* const* pRows, const float* pWeights, unsigned int taps, float* pDst, size_t count)
+	{
+		size_t i = 0;
+
+		for (; i + 8u <= count; i += 8u) {
+
+			__m256 sum = _mm256_setzero_ps();
+
+			for (unsigned int k = 0; k < taps; k++) {
+
+				sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(pRows[k] + i), _mm256_set1_ps(pWeights[k])));
+			}
+
+			_mm256_storeu_ps(pDst + i, sum);
+		}
+
+		for (; i < count; i++) {
+
+			float sum = 0.0f;
+
+			for (unsigned int k = 0; k < taps; k++) {
+
+				sum += pRows[k][i] * pWeights[k];
+			}
+
+			pDst[i] = sum;
+		}
+	}
+
+	constexpr Kernels kernels[] = {
+		{ FillScalar,SwizzleScalar,ToLinearScalar,FromLinearScalar,HorizontalScalar,VerticalScalar },
+		{ FillSse2,SwizzleSse2,ToLinearSse2,FromLinearSse2,HorizontalSse2,VerticalSse2 },
+		{ FillAvx2,SwizzleAvx2,ToLinearAvx2,FromLinearAvx2,HorizontalAvx2,VerticalAvx2 },
+	};
+
+	PixelKernels::Isa DetectIsa() noexcept
+	{
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 0);
+		const int maxLeaf = info[0];
+
+		__cpuid(info, 1);
+
+		//the OS has to save the ymm registers too, not just the cpu support them
+		const bool hasAvx = (info[2] & (1 << 28)) != 0 && (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6u) == 6u;
+		bool hasAvx2 = false;
+
+		if (hasAvx && maxLeaf >= 7) {
+
+			__cpuidex(info, 7, 0);
+			hasAvx2 = (info[1] & (1 << 5)) != 0;
+		}
+
+		return hasAvx2 ? PixelKernels::Isa::Avx2 : PixelKernels::Isa::Sse2;
+#else
+		//checks the OS side as well
+		return __builtin_cpu_supports("avx2") ? PixelKernels::Isa::Avx2 : PixelKernels::Isa::Sse2;
+#endif
+	}
+
+	std::atomic<PixelKernels::Isa>& Selected()
+	{
+		static std::atomic<PixelKernels::Isa> isa{ PixelKernels::GetSupportedIsa() };
+		return isa;
+	}
+
+	const Kernels& Current()
+	{
+		return kernels[(int)Selected().load(std::memory_order_relaxed)];
+	}
+
+	float Sinc(float x) noexcept
+	{
+		constexpr float pi = 3.14159265358979f;
+
+		return x == 0.0f ? 1.0f : std::sin(pi * x) / (pi * x);
+	}
+
+	float Weigh(PixelKernels::Filter filter, float x) noexcept
+	{
+		x = std::abs(x);
+
+		if (filter == PixelKernels::Filter::Lanczos3) {
+
+			return x < 3.0f ? Sinc(x) * Sinc(x / 3.0f) : 0.0f;
+		}
+
+		constexpr float b = 1.0f / 3.0f;
+		constexpr float c = 1.0f / 3.0f;
+
+		if (x < 1.0f) {
+
+			return ((12.0f - 9.0f * b - 6.0f * c) * x * x * x + (-18.0f + 12.0f * b + 6.0f * c) * x * x + (6.0f - 2.0f * b)) / 6.0f;
+		}
+
+		if (x < 2.0f) {
+
+			return ((-b - 6.0f * c) * x * x * x + (6.0f * b + 30.0f * c) * x * x + (-12.0f * b - 48.0f * c) * x + (8.0f * b + 24.0f * c)) / 6.0f;
+		}
+
+		return 0.0f;
+	}
+}
+
+PixelKernels::Image::Image(uint32_t* pTexels, size_t pitch, unsigned int width, unsigned int height) noexcept
+	:
+	pTexels(pTexels),
+	pitch(pitch),
+	width(width),
+	height(height)
+{}
+
+PixelKernels::Image PixelKernels::Image::Crop(unsigned int x, unsigned int y, unsigned int w, unsigned int h) const noexcept
+{
+	x = std::min(x, width);
+	y = std::min(y, height);
+
+	return Image(pTexels + y * pitch + x, pitch, std::min(w, width - x), std::min(h, height - y));
+}
+
+PixelKernels::ConstImage::ConstImage(const uint32_t* pTexels, size_t pitch, unsigned int width, unsigned int height) noexcept
+	:
+	pTexels(pTexels),
+	pitch(pitch),
+	width(width),
+	height(height)
+{}
+
+PixelKernels::ConstImage::ConstImage(const Image& image) noexcept
+	:
+	ConstImage(image.pTexels, image.pitch, image.width, image.height)
+{}
+
+PixelKernels::ConstImage PixelKernels::ConstImage::Crop(unsigned int x, unsigned int y, unsigned int w, unsigned int h) const noexcept
+{
+	x = std::min(x, width);
+	y = std::min(y, height);
+
+	return ConstImage(pTexels + y * pitch + x, pitch, std::min(w, width - x), std::min(h, height - y));
+}
+
+PixelKernels::Isa PixelKernels::GetSupportedIsa() noexcept
+{
+	static const Isa supported = DetectIsa();
+	return supported;
+}
+
+PixelKernels::Isa PixelKernels::GetIsa() noexcept
+{
+	return Selected().load(std::memory_order_relaxed);
+}
+
+void PixelKernels::SetIsa(Isa isa) noexcept
+{
+	Selected().store(std::min(isa, GetSupportedIsa()), std::memory_order_relaxed);
+}
+
+const char* PixelKernels::GetIsaName(Isa isa) noexcept
+{
+	switch (isa)
+	{
+	case Isa::Scalar:
+		return "Scalar";
+	case Isa::Sse2:
+		return "SSE2";
+	case Isa::Avx2:
+		return "AVX2";
+	}
+
+	return "Unknown";
+}
+
+void PixelKernels::Fill(const Image& dst, uint32_t value) noexcept
+{
+	const auto fill = Current().fill;
+
+	for (unsigned int y = 0; y < dst.height; y++) {
+
+		fill(dst.pTexels + y * dst.pitch, dst.width, value);
+	}
+}
+
+void PixelKernels::Blit(const ConstImage& src, const Image& dst) noexcept
+{
+	//a row copy is already as wide as the memory bus allows, memcpy picks its own instructions
+	const unsigned int width = std::min(src.width, dst.width);
+	const unsigned int height = std::min(src.height, dst.height);
+
+	for (unsigned int y = 0; y < height; y++) {
+
+		std::memcpy(dst.pTexels + y * dst.pitch, src.pTexels + y * src.pitch, width * sizeof(uint32_t));
+	}
+}
+
+void PixelKernels::SwizzleRB(const ConstImage& src, const Image& dst) noexcept
+{
+	const auto swizzle = Current().swizzle;
+	const unsigned int width = std::min(src.width, dst.width);
+	const unsigned int height = std::min(src.height, dst.height);
+
+	for (unsigned int y = 0; y < height; y++) {
+
+		swizzle(src.pTexels + y * src.pitch, dst.pTexels + y * dst.pitch, width);
+	}
+}
+
+void PixelKernels::ToLinear(const ConstImage& src, float* pDst, size_t dstPitch, bool isSrgb) noexcept
+{
+	const auto toLinear = Current().toLinear;
+	const float* pTable = isSrgb ? GetTables().srgbToLinear : GetTables().unormToFloat;
+
+	for (unsigned int y = 0; y < src.height; y++) {
+
+		toLinear(src.pTexels + y * src.pitch, pDst + y * dstPitch, src.width, pTable, false);
+	}
+}
+
+void PixelKernels::FromLinear(const float* pSrc, size_t srcPitch, const Image& dst, bool isSrgb) noexcept
+{
+	const auto fromLinear = Current().fromLinear;
+
+	for (unsigned int y = 0; y < dst.height; y++) {
+
+		fromLinear(pSrc + y * srcPitch, dst.pTexels + y * dst.pitch, dst.width, isSrgb, false);
+	}
+}
+
+void PixelKernels::Premultiply(const Image& image, bool isSrgb)
+{
+	const auto& current = Current();
+	const float* pTable = isSrgb ? GetTables().srgbToLinear : GetTables().unormToFloat;
+
+	//one row of floats at a time
+	std::vector<float> row((size_t)image.width * 4u);
+
+	for (unsigned int y = 0; y < image.height; y++) {
+
+		uint32_t* pTexels = image.pTexels + y * image.pitch;
+
+		current.toLinear(pTexels, row.data(), image.width, pTable, true);
+		current.fromLinear(row.data(), pTexels, image.width, isSrgb, false);
+	}
+}
+
+PixelKernels::Resampler::Resampler(unsigned int srcWidth, unsigned int srcHeight, unsigned int dstWidth, unsigned int dstHeight, Filter filter, bool isSrgb)
+	:
+	m_srcWidth(srcWidth),
+	m_srcHeight(srcHeight),
+	m_dstWidth(dstWidth),
+	m_dstHeight(dstHeight),
+	m_isSrgb(isSrgb)
+{
+	assert("Resampling needs at least one texel each way" && srcWidth > 0u && srcHeight > 0u && dstWidth > 0u && dstHeight > 0u);
+
+	MakeTaps(srcWidth, dstWidth, filter, m_columns, m_weights);
+
+	//one copy per channel for the horizontal pass
+	m_columnWeights.reserve(m_weights.size() * 4u);
+
+	for (const auto w : m_weights) {
+
+		m_columnWeights.insert(m_columnWeights.end(), 4u, w);
+	}
+
+	for (auto& taps : m_columns) {
+
+		taps.weights *= 4u;
+	}
+
+	m_weights.clear();
+	MakeTaps(srcHeight, dstHeight, filter, m_rows, m_weights);
+}
+
+unsigned int PixelKernels::Resampler::GetDstWidth() const noexcept
+{
+	return m_dstWidth;
+}
+
+unsigned int PixelKernels::Resampler::GetDstHeight() const noexcept
+{
+	return m_dstHeight;
+}
+
+void PixelKernels::Resampler::Run(const ConstImage& src, const Image& dst, unsigned int firstRow, unsigned int lastRow) const
+{
+	assert("Resampler run on images of the wrong size" &&
+		src.width == m_srcWidth && src.height == m_srcHeight && dst.width == m_dstWidth && dst.height == m_dstHeight);
+
+	const auto& current = Current();
+	const float* pTable = m_isSrgb ? GetTables().srgbToLinear : GetTables().unormToFloat;
+
+	//horizontally filtered source rows, enough for the tallest vertical footprint
+	//*footprints only move down, so every source row is filtered once per range
+	unsigned int ringSize = 1u;
+
+	for (unsigned int y = firstRow; y < lastRow; y++) {
+
+		ringSize = std::max(ringSize, m_rows[y].count);
+	}
+
+	const size_t rowFloats = (size_t)m_dstWidth * 4u;
+
+	std::vector<float> ring(ringSize * rowFloats);
+	std::vector<unsigned int> ringRows(ringSize, UINT32_MAX);
+	std::vector<float> linear((size_t)m_srcWidth * 4u);
+	std::vector<float> filtered(rowFloats);
+	std::vector<const float*> rowPtrs(ringSize);
+
+	for (unsigned int y = firstRow; y < lastRow; y++) {
+
+		const auto& taps = m_rows[y];
+
+		for (unsigned int k = 0; k < taps.count; k++) {
+
+			const unsigned int row = taps.first + k;
+			const unsigned int slot = row % ringSize;
+			float* pRow = ring.data() + slot * rowFloats;
+
+			if (ringRows[slot] != row) {
+
+				current.toLinear(src.pTexels + row * src.pitch, linear.data(), m_srcWidth, pTable, true);
+				current.horizontal(linear.data(), pRow, m_dstWidth, m_columns.data(), m_columnWeights.data());
+				ringRows[slot] = row;
+			}
+
+			rowPtrs[k] = pRow;
+		}
+
+		current.vertical(rowPtrs.data(), m_weights.data() + taps.weights, taps.count, filtered.data(), rowFloats);
+		current.fromLinear(filtered.data(), dst.pTexels + y * dst.pitch, m_dstWidth, m_isSrgb, true);
+	}
+}
+
+void PixelKernels::Resampler::MakeTaps(unsigned int srcSize, unsigned int dstSize, Filter filter, std::vector<Taps>& taps, std::vector<float>& weights)
+{
+	//shrinking widens the filter so every source texel still counts
+	const float ratio = (float)srcSize / dstSize;
+	const float scale = std::max(1.0f, ratio);
+	const float support = (filter == Filter::Lanczos3 ? 3.0f : 2.0f) * scale;
+
+	taps.resize(dstSize);
+
+	for (unsigned int i = 0; i < dstSize; i++) {
+
+		const float center = (i + 0.5f) * ratio;
+
+		//taps past the edges are dropped and the rest renormalized
+		const int first = std::max(0, (int)std::floor(center - support));
+		const int last = std::min((int)srcSize, (int)std::ceil(center + support));
+
+		const size_t offset = weights.size();
+		float sum = 0.0f;
+
+		for (int j = first; j < last; j++) {
+
+			const float w = Weigh(filter, (j + 0.5f - center) / scale);
+
+			weights.push_back(w);
+			sum += w;
+		}
+
+		//zero weights at the ends only cost loads
+		unsigned int begin = 0u;
+		unsigned int end = (unsigned int)(last - first);
+
+		while (begin + 1u < end && weights[offset + begin] == 0.0f) {
+
+			begin++;
+		}
+
+		while (end - 1u > begin && weights[offset + end - 1u] == 0.0f) {
+
+			end--;
+		}
+
+		std::copy(weights.begin() + offset + begin, weights.begin() + offset + end, weights.begin() + offset);
+		weights.resize(offset + (end - begin));
+
+		for (size_t k = offset; k < weights.size(); k++) {
+
+			weights[k] = sum != 0.0f ? weights[k] / sum : 1.0f / (end - begin);
+		}
+
+		taps[i] = { (unsigned int)first + begin,end - begin,offset };
+	}
+}
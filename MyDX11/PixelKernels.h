@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/// <summary>
+/// Vectorised kernels over B8G8R8A8 images (the Surface::Color layout)
+/// every kernel has a scalar, an SSE2 and an AVX2 version, the best one the CPU and OS allow is picked on first use
+/// images are a pointer plus a row pitch in texels, so a sub rectangle is just an offset pointer
+/// linear images hold four floats per texel in the same b,g,r,a order
+/// works on raw pixels only so it builds and runs without windows
+/// </summary>
+class PixelKernels {
+
+public:
+
+	enum class Isa {
+
+		Scalar,
+		Sse2,
+		Avx2,
+	};
+
+	enum class Filter {
+
+		//sharpest, rings a little on hard edges
+		Lanczos3,
+		//B = C = 1/3, softer with hardly any ringing
+		Mitchell,
+	};
+
+	struct Image {
+
+		Image(uint32_t* pTexels, size_t pitch, unsigned int width, unsigned int height) noexcept;
+
+		//the part of the image inside the rectangle
+		Image Crop(unsigned int x, unsigned int y, unsigned int width, unsigned int height) const noexcept;
+
+		uint32_t* pTexels;
+		size_t pitch;
+		unsigned int width;
+		unsigned int height;
+	};
+
+	struct ConstImage {
+
+		ConstImage(const uint32_t* pTexels, size_t pitch, unsigned int width, unsigned int height) noexcept;
+		ConstImage(const Image& image) noexcept;
+
+		ConstImage Crop(unsigned int x, unsigned int y, unsigned int width, unsigned int height) const noexcept;
+
+		const uint32_t* pTexels;
+		size_t pitch;
+		unsigned int width;
+		unsigned int height;
+	};
+
+	/// <summary>
+	/// Separable resample to any size, horizontal pass into a small ring of rows then vertical
+	/// filtered in linear light with premultiplied alpha, so transparent texels never bleed their color
+	/// </summary>
+	class Resampler {
+
+	public:
+
+		//source texels feeding one destination texel along one axis, weights sum to one
+		struct Taps {
+
+			unsigned int first;
+			unsigned int count;
+			size_t weights;
+		};
+
+	public:
+
+		Resampler(unsigned int srcWidth, unsigned int srcHeight, unsigned int dstWidth, unsigned int dstHeight, Filter filter, bool isSrgb);
+
+		unsigned int GetDstWidth() const noexcept;
+		unsigned int GetDstHeight() const noexcept;
+
+		//resamples destination rows [firstRow, lastRow), ranges are independent so they can run in parallel
+		void Run(const ConstImage& src, const Image& dst, unsigned int firstRow, unsigned int lastRow) const;
+
+	private:
+
+		static void MakeTaps(unsigned int srcSize, unsigned int dstSize, Filter filter, std::vector<Taps>& taps, std::vector<float>& weights);
+
+	private:
+
+		unsigned int m_srcWidth;
+		unsigned int m_srcHeight;
+		unsigned int m_dstWidth;
+		unsigned int m_dstHeight;
+		bool m_isSrgb;
+
+		std::vector<Taps> m_columns;
+		std::vector<Taps> m_rows;
+		std::vector<float> m_columnWeights;
+		std::vector<float> m_weights;
+	};
+
+public:
+
+	//best level this machine runs
+	static Isa GetSupportedIsa() noexcept;
+
+	//level the kernels run at now
+	static Isa GetIsa() noexcept;
+	//pins a level to compare or benchmark against, clamped to the supported one
+	static void SetIsa(Isa isa) noexcept;
+	static const char* GetIsaName(Isa isa) noexcept;
+
+	static void Fill(const Image& dst, uint32_t value) noexcept;
+
+	//copies the overlap of the two rectangles, they must not overlap in memory
+	static void Blit(const ConstImage& src, const Image& dst) noexcept;
+
+	//swaps the first and third byte of every texel, BGRA <-> RGBA either way, src and dst may be the same image
+	static void SwizzleRB(const ConstImage& src, const Image& dst) noexcept;
+
+	//color through the sRGB curve when isSrgb, alpha always linear
+	//*pitches of linear images count floats
+	static void ToLinear(const ConstImage& src, float* pDst, size_t dstPitch, bool isSrgb) noexcept;
+	static void FromLinear(const float* pSrc, size_t srcPitch, const Image& dst, bool isSrgb) noexcept;
+
+	//color times alpha, in linear light when isSrgb
+	static void Premultiply(const Image& image, bool isSrgb);
+};
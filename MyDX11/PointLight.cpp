@@ -1,10 +1,30 @@
 #include "PointLight.h"
 #include "imgui/imgui.h"
 
+namespace {
+
+	//LightCBuf as declared in the phong pixel shaders
+	MyDynamicConstant::CbufLayout MakeLightLayout()
+	{
+		using MyDynamicConstant::CbufLayout;
+
+		CbufLayout layout;
+		layout.Append(CbufLayout::Float3, "lightPos");
+		layout.Append(CbufLayout::Float3, "ambient");
+		layout.Append(CbufLayout::Float3, "diffuseColor");
+		layout.Append(CbufLayout::Float, "diffuseIntensity");
+		layout.Append(CbufLayout::Float, "attConst");
+		layout.Append(CbufLayout::Float, "attLin");
+		layout.Append(CbufLayout::Float, "attQuad");
+
+		return layout;
+	}
+}
+
 PointLight::PointLight(Graphics& gfx, float radius)
 	:
 	mesh(gfx,radius),
-	cbuf(gfx)
+	cbuf(gfx, MakeLightLayout())
 {
 	Reset();
 }
@@ -57,18 +77,47 @@ void PointLight::Reset() noexcept
 	};
 }
 
+PointLight::PointLightCBuf PointLight::GetData() const noexcept
+{
+	return cbData;
+}
+
 void PointLight::Draw(Graphics& gfx) const noexcept(!IS_DEBUG)
 {
-	mesh.SetPosition(cbData.pos);
-	mesh.Draw(gfx);
+	Draw(gfx, cbData);
 }
 
 void PointLight::Bind(Graphics& gfx, DirectX::FXMMATRIX view) const noexcept
 {
-	auto dataCopy = cbData;
-	const auto pos = DirectX::XMLoadFloat3(&cbData.pos);
-	DirectX::XMStoreFloat3(&dataCopy.pos, DirectX::XMVector3Transform(pos, view));
+	Bind(gfx, cbData, view);
+}
 
-	cbuf.Update(gfx, dataCopy);
-	cbuf.Bind(gfx);
+void PointLight::Draw(Graphics& gfx, const PointLightCBuf& data) const noexcept(!IS_DEBUG)
+{
+	mesh.SetPosition(data.pos);
+	mesh.Draw(gfx);
+}
+
+void PointLight::Stage(const PointLightCBuf& data) const
+{
+	mesh.SetPosition(data.pos);
+	mesh.StageTransform();
 }
+
+void PointLight::Bind(Graphics& gfx, const PointLightCBuf& data, DirectX::FXMMATRIX view) const noexcept
+{
+	DirectX::XMFLOAT3 viewPos;
+	DirectX::XMStoreFloat3(&viewPos, DirectX::XMVector3Transform(DirectX::XMLoadFloat3(&data.pos), view));
+
+	//unchanged values don't dirty the buffer, Bind skips the upload then
+	auto& buffer = cbuf.GetBuffer();
+	buffer["lightPos"] = viewPos;
+	buffer["ambient"] = data.ambient;
+	buffer["diffuseColor"] = data.diffuseColor;
+	buffer["diffuseIntensity"] = data.diffuseIntensity;
+	buffer["attConst"] = data.attConst;
+	buffer["attLin"] = data.attLin;
+	buffer["attQuad"] = data.attQuad;
+
+	cbuf.Bind(gfx);
+}
\ No newline at end of file
@@ -2,7 +2,7 @@
 
 #include "graphics.h"
 #include "SolidSphere.h"
-#include "ConstantBuffers.h"
+#include "DynamicConstantBuffers.h"
 
 class PointLight {
 
@@ -17,14 +17,14 @@ public:
 	void Draw(Graphics& gfx) const noexcept(!IS_DEBUG);
 	void Bind(Graphics& gfx, DirectX::FXMMATRIX view) const noexcept;
 
-private:
+public:
 
-	//constant buffer for point light
+	//point light parameters, packed into the LightCBuf layout on Bind
 	struct PointLightCBuf {
 
-		alignas(16) DirectX::XMFLOAT3 pos;
-		alignas(16) DirectX::XMFLOAT3 ambient;
-		alignas(16) DirectX::XMFLOAT3 diffuseColor;
+		DirectX::XMFLOAT3 pos;
+		DirectX::XMFLOAT3 ambient;
+		DirectX::XMFLOAT3 diffuseColor;
 
 		float diffuseIntensity;
 		float attConst;
@@ -32,6 +32,14 @@ private:
 		float attQuad;
 	};
 
+	//snapshot of the light for the render thread
+	PointLightCBuf GetData() const noexcept;
+	//draw/bind from a snapshot instead of the live (ui edited) data
+	void Draw(Graphics& gfx, const PointLightCBuf& data) const noexcept(!IS_DEBUG);
+	void Bind(Graphics& gfx, const PointLightCBuf& data, DirectX::FXMMATRIX view) const noexcept;
+	//stage the sphere's transform before TransformCbuf::Flush
+	void Stage(const PointLightCBuf& data) const;
+
 private:
 
 	//Constant Buffer data for lighting
@@ -39,5 +47,6 @@ private:
 	
 	//
 	mutable SolidSphere mesh;
-	mutable Bind::PixelConstantBuffer<PointLightCBuf> cbuf;
+	//only uploaded when the light or the camera moved
+	mutable Bind::DynamicPixelConstantBuffer cbuf;
 };
\ No newline at end of file
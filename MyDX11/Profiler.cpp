@@ -0,0 +1,431 @@
+#include "Profiler.h"
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <chrono>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace {
+
+	//zones per thread kept for the view and the export, 32 bytes each
+	constexpr size_t ringSize = 1u << 15u;
+
+	//frame starts kept, only the last two are needed for the view
+	constexpr size_t frameRingSize = 64u;
+
+	//one thread's zones, only that thread writes
+	//*a seqlock per ring: the writer bumps m_started before touching a slot and m_finished after,
+	//so a reader knows which slots may have changed under it by reading m_started after its copy
+	class ThreadRing {
+
+	public:
+
+		ThreadRing(unsigned int id)
+			:
+			m_id(id),
+			m_pSlots(std::make_unique<Slot[]>(ringSize))
+		{}
+
+		void Push(const char* name, uint64_t begin, uint64_t end, unsigned int depth) noexcept
+		{
+			const uint64_t i = m_finished.load(std::memory_order_relaxed);
+
+			m_started.store(i + 1u, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+
+			auto& slot = m_pSlots[i % ringSize];
+			slot.name.store(name, std::memory_order_relaxed);
+			slot.begin.store(begin, std::memory_order_relaxed);
+			slot.end.store(end, std::memory_order_relaxed);
+			slot.depth.store(depth, std::memory_order_relaxed);
+
+			m_finished.store(i + 1u, std::memory_order_release);
+		}
+
+		//appends the zones overlapping [begin,end) in the order they were pushed
+		void Copy(uint64_t begin, uint64_t end, std::vector<Profiler::Event>& events) const
+		{
+			const uint64_t finished = m_finished.load(std::memory_order_acquire);
+			const uint64_t first = finished > ringSize ? finished - ringSize : 0u;
+
+			const size_t base = events.size();
+			std::vector<uint64_t> indices;
+
+			//zones close in order, so walking back the ends only fall and the walk can stop at the first one before begin
+			for (uint64_t i = finished; i-- > first;) {
+
+				const auto& slot = m_pSlots[i % ringSize];
+				const Profiler::Event event = {
+					slot.name.load(std::memory_order_relaxed),
+					slot.begin.load(std::memory_order_relaxed),
+					slot.end.load(std::memory_order_relaxed),
+					slot.depth.load(std::memory_order_relaxed) };
+
+				if (event.end < begin) {
+
+					break;
+				}
+
+				if (event.begin < end) {
+
+					events.push_back(event);
+					indices.push_back(i);
+				}
+			}
+
+			//anything the writer started on since is suspect, its slot may hold half of a newer zone
+			std::atomic_thread_fence(std::memory_order_acquire);
+			const uint64_t started = m_started.load(std::memory_order_relaxed);
+			const uint64_t firstIntact = started > ringSize ? started - ringSize : 0u;
+
+			size_t kept = base;
+
+			for (size_t i = 0; i < indices.size(); i++) {
+
+				if (indices[i] >= firstIntact) {
+
+					events[kept++] = events[base + i];
+				}
+			}
+
+			events.resize(kept);
+			std::reverse(events.begin() + base, events.end());
+		}
+
+		unsigned int GetId() const noexcept
+		{
+			return m_id;
+		}
+
+	public:
+
+		//guarded by the registry mutex
+		std::string name;
+
+	private:
+
+		struct Slot {
+
+			std::atomic<const char*> name = nullptr;
+			std::atomic<uint64_t> begin = 0u;
+			std::atomic<uint64_t> end = 0u;
+			std::atomic<unsigned int> depth = 0u;
+		};
+
+	private:
+
+		unsigned int m_id;
+		std::unique_ptr<Slot[]> m_pSlots;
+		std::atomic<uint64_t> m_started = 0u;
+		std::atomic<uint64_t> m_finished = 0u;
+	};
+
+	struct Registry {
+
+		Registry()
+			:
+			startTicks(Profiler::Now()),
+			startTime(std::chrono::steady_clock::now())
+		{}
+
+		//rings outlive their threads, so zones of finished loads still show up in the export
+		std::mutex mtx;
+		std::vector<std::unique_ptr<ThreadRing>> rings;
+
+		std::atomic<uint64_t> frames[frameRingSize] = {};
+		std::atomic<uint64_t> frameCount = 0u;
+
+		//for the tick rate
+		uint64_t startTicks;
+		std::chrono::steady_clock::time_point startTime;
+	};
+
+	Registry& GetRegistry()
+	{
+		static Registry registry;
+		return registry;
+	}
+
+	//outside the registry so the zone destructor doesn't go through the static's guard
+	std::atomic<bool> g_isPaused = false;
+
+	thread_local ThreadRing* tl_pRing = nullptr;
+	thread_local unsigned int tl_depth = 0u;
+
+	ThreadRing& GetThreadRing()
+	{
+		if (tl_pRing == nullptr) {
+
+			auto& registry = GetRegistry();
+			std::lock_guard<std::mutex> lock(registry.mtx);
+
+			registry.rings.push_back(std::make_unique<ThreadRing>((unsigned int)registry.rings.size() + 1u));
+			tl_pRing = registry.rings.back().get();
+		}
+
+		return *tl_pRing;
+	}
+
+	void WriteJsonString(std::ostream& os, const char* text)
+	{
+		os << '"';
+
+		for (const char* p = text; *p != '\0'; p++) {
+
+			const auto c = (unsigned char)*p;
+
+			if (c == '"' || c == '\\') {
+
+				os << '\\' << (char)c;
+			}
+			else if (c < 0x20u) {
+
+				os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (unsigned int)c << std::dec << std::setfill(' ');
+			}
+			else {
+
+				os << (char)c;
+			}
+		}
+
+		os << '"';
+	}
+}
+
+
+Profiler::Zone::Zone(const char* name) noexcept
+	:
+	m_name(name),
+	m_begin(Now())
+{
+	tl_depth++;
+}
+
+Profiler::Zone::~Zone()
+{
+	const uint64_t end = Now();
+
+	tl_depth--;
+
+	if (!IsPaused()) {
+
+		GetThreadRing().Push(m_name, m_begin, end, tl_depth);
+	}
+}
+
+void Profiler::SetThreadName(const std::string& name)
+{
+	auto& ring = GetThreadRing();
+
+	std::lock_guard<std::mutex> lock(GetRegistry().mtx);
+	ring.name = name;
+}
+
+void Profiler::MarkFrame() noexcept
+{
+	auto& registry = GetRegistry();
+
+	if (IsPaused()) {
+
+		return;
+	}
+
+	const uint64_t count = registry.frameCount.load(std::memory_order_relaxed);
+
+	registry.frames[count % frameRingSize].store(Now(), std::memory_order_relaxed);
+	registry.frameCount.store(count + 1u, std::memory_order_release);
+}
+
+void Profiler::SetPaused(bool isPaused) noexcept
+{
+	g_isPaused.store(isPaused, std::memory_order_relaxed);
+}
+
+bool Profiler::IsPaused() noexcept
+{
+	return g_isPaused.load(std::memory_order_relaxed);
+}
+
+uint64_t Profiler::Now() noexcept
+{
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+double Profiler::GetTicksPerMs() noexcept
+{
+	const auto& registry = GetRegistry();
+
+	const uint64_t ticks = Now() - registry.startTicks;
+	const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - registry.startTime).count();
+
+	//right after startup the two clocks haven't drifted apart enough to say anything
+	return ms > 1.0 && ticks > 0u ? (double)ticks / ms : 1.0e6;
+}
+
+bool Profiler::GetLastFrame(uint64_t& begin, uint64_t& end) noexcept
+{
+	const auto& registry = GetRegistry();
+
+	const uint64_t count = registry.frameCount.load(std::memory_order_acquire);
+
+	if (count < 2u) {
+
+		return false;
+	}
+
+	begin = registry.frames[(count - 2u) % frameRingSize].load(std::memory_order_relaxed);
+	end = registry.frames[(count - 1u) % frameRingSize].load(std::memory_order_relaxed);
+	return true;
+}
+
+std::vector<Profiler::ThreadEvents> Profiler::Collect(uint64_t begin, uint64_t end)
+{
+	auto& registry = GetRegistry();
+
+	std::vector<ThreadEvents> threads;
+
+	std::lock_guard<std::mutex> lock(registry.mtx);
+
+	for (const auto& pRing : registry.rings) {
+
+		ThreadEvents thread;
+		thread.threadId = pRing->GetId();
+		thread.threadName = pRing->name.empty() ? "Thread " + std::to_string(thread.threadId) : pRing->name;
+
+		pRing->Copy(begin, end, thread.events);
+
+		if (!thread.events.empty()) {
+
+			threads.push_back(std::move(thread));
+		}
+	}
+
+	return threads;
+}
+
+std::string Profiler::MakeChromeTrace()
+{
+	const auto threads = Collect();
+	const double ticksPerUs = GetTicksPerMs() / 1000.0;
+
+	//timestamps from the oldest zone kept, the viewers don't care where zero is
+	uint64_t origin = UINT64_MAX;
+
+	for (const auto& thread : threads) {
+
+		for (const auto& event : thread.events) {
+
+			origin = std::min(origin, event.begin);
+		}
+	}
+
+	std::ostringstream oss;
+	oss << std::fixed << std::setprecision(3);
+	oss << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+	bool isFirst = true;
+
+	const auto separate = [&oss, &isFirst]() {
+
+		oss << (isFirst ? "\n" : ",\n");
+		isFirst = false;
+	};
+
+	for (const auto& thread : threads) {
+
+		separate();
+		oss << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread.threadId << ",\"args\":{\"name\":";
+		WriteJsonString(oss, thread.threadName.c_str());
+		oss << "}}";
+
+		for (const auto& event : thread.events) {
+
+			separate();
+			oss << "{\"name\":";
+			WriteJsonString(oss, event.name);
+			oss << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread.threadId
+				<< ",\"ts\":" << (double)(event.begin - origin) / ticksPerUs
+				<< ",\"dur\":" << (double)(event.end - event.begin) / ticksPerUs << "}";
+		}
+	}
+
+	//frame starts as global instant events, so frames line up across the threads
+	const auto& registry = GetRegistry();
+	const uint64_t frameCount = registry.frameCount.load(std::memory_order_acquire);
+
+	for (uint64_t i = frameCount > frameRingSize ? frameCount - frameRingSize : 0u; i < frameCount && origin != UINT64_MAX; i++) {
+
+		const uint64_t ticks = registry.frames[i % frameRingSize].load(std::memory_order_relaxed);
+
+		if (ticks >= origin) {
+
+			separate();
+			oss << "{\"name\":\"Frame\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":0,\"ts\":" << (double)(ticks - origin) / ticksPerUs << "}";
+		}
+	}
+
+	oss << "\n]}\n";
+
+	return oss.str();
+}
+
+void Profiler::SaveChromeTrace(const std::string& path)
+{
+	const auto trace = MakeChromeTrace();
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+	if (!file) {
+
+		throw Exception(__LINE__, __FILE__, "Failed to create [" + path + "]");
+	}
+
+	file.write(trace.data(), (std::streamsize)trace.size());
+
+	if (!file) {
+
+		throw Exception(__LINE__, __FILE__, "Failed to write [" + path + "]");
+	}
+}
+
+
+//profiler exception stuff
+Profiler::Exception::Exception(int line, const char* file, std::string note) noexcept
+	:
+	myException(line, file),
+	note(std::move(note))
+{}
+
+const char* Profiler::Exception::what() const noexcept
+{
+	std::ostringstream oss;
+
+	oss << myException::what() << std::endl
+		<< "[Note] " << GetNote();
+
+	whatBuffer = oss.str();
+	return whatBuffer.c_str();
+}
+
+const char* Profiler::Exception::GetType() const noexcept
+{
+	return "SupaHotFire Profiler Exception";
+}
+
+const std::string& Profiler::Exception::GetNote() const noexcept
+{
+	return note;
+}
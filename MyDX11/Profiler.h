@@ -0,0 +1,119 @@
+#pragma once
+
+#include "BuildConfig.h"
+#include "myException.h"
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+//zones are compiled in with the debug configuration, a project can define this itself to profile release builds
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED IS_DEBUG
+#endif
+
+#define PROFILE_CONCAT_(a,b) a##b
+#define PROFILE_CONCAT(a,b) PROFILE_CONCAT_(a,b)
+
+#if PROFILER_ENABLED
+//times the rest of the enclosing scope, name has to be a string literal (only the pointer is kept)
+#define PROFILE_ZONE(name) Profiler::Zone PROFILE_CONCAT(profileZone,__LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_ZONE(__FUNCTION__)
+#define PROFILE_FRAME() Profiler::MarkFrame()
+#define PROFILE_THREAD(name) Profiler::SetThreadName(name)
+#else
+#define PROFILE_ZONE(name)
+#define PROFILE_FUNCTION()
+#define PROFILE_FRAME()
+#define PROFILE_THREAD(name)
+#endif
+
+/// <summary>
+/// Scoped, nestable CPU zones for finding where frames and loads go
+/// a zone reads the TSC when it opens and closes and is written to a ring owned by the calling thread,
+/// so recording takes no lock and threads never contend, the oldest zones are overwritten once a ring is full
+/// readers (the flame view, the trace export) copy the rings while they are written and drop what got overwritten meanwhile
+/// works without windows, the imgui view lives in ProfilerWindow.cpp
+/// </summary>
+class Profiler {
+
+public:
+
+	class Exception :public myException {
+
+	public:
+
+		Exception(int line, const char* file, std::string note) noexcept;
+		const char* what() const noexcept override;
+		const char* GetType() const noexcept override;
+
+		const std::string& GetNote() const noexcept;
+
+	private:
+
+		std::string note;
+	};
+
+	class Zone {
+
+	public:
+
+		explicit Zone(const char* name) noexcept;
+		Zone(const Zone&) = delete;
+		Zone& operator=(const Zone&) = delete;
+		~Zone();
+
+	private:
+
+		const char* m_name;
+		uint64_t m_begin;
+	};
+
+	//one closed zone, times are ticks (see GetTicksPerMs)
+	struct Event {
+
+		const char* name;
+		uint64_t begin;
+		uint64_t end;
+		//0 for a zone opened with no other zone open on its thread
+		unsigned int depth;
+	};
+
+	struct ThreadEvents {
+
+		std::string threadName;
+		//1 for the first thread that recorded a zone, and so on
+		unsigned int threadId;
+		//in the order the zones closed, children before their parent
+		std::vector<Event> events;
+	};
+
+public:
+
+	//shown in the flame view and the trace, threads without a name get "Thread N"
+	static void SetThreadName(const std::string& name);
+
+	//start of a frame on the simulation thread, the flame view shows the span between the last two marks
+	static void MarkFrame() noexcept;
+
+	//while paused nothing is recorded, so the view and the next export keep the frames before the pause
+	static void SetPaused(bool isPaused) noexcept;
+	static bool IsPaused() noexcept;
+
+	static uint64_t Now() noexcept;
+	//measured against the steady clock since startup, so it settles within the first frames
+	static double GetTicksPerMs() noexcept;
+
+	//[begin,end) of the last whole frame, false until two frames were marked
+	static bool GetLastFrame(uint64_t& begin, uint64_t& end) noexcept;
+
+	//every zone on any thread that overlaps [begin,end), threads without one are left out
+	static std::vector<ThreadEvents> Collect(uint64_t begin = 0u, uint64_t end = UINT64_MAX);
+
+	//everything still in the rings as Chrome trace event JSON (chrome://tracing, ui.perfetto.dev)
+	static std::string MakeChromeTrace();
+	static void SaveChromeTrace(const std::string& path);
+
+	//flame graph of the last frame and the zones that took longest in it, inside the current imgui window
+	static void ShowFrame();
+};
@@ -0,0 +1,155 @@
+#include "Profiler.h"
+#include "imgui/imgui.h"
+#include <algorithm>
+#include <unordered_map>
+
+//imgui half of Profiler, the flame graph of the last frame
+
+namespace {
+
+	constexpr float rowHeight = 18.0f;
+
+	//the longest zones of the frame listed under the graph
+	constexpr size_t nTopZones = 12u;
+
+	//stable per zone name, hue from the pointer so the same zone keeps its color between frames
+	ImU32 GetZoneColor(const char* name) noexcept
+	{
+		const uint64_t hash = (uint64_t)(uintptr_t)name * 0x9E3779B97F4A7C15ull;
+		const float hue = (float)(hash >> 40u) / (float)(1u << 24u);
+
+		float r, g, b;
+		ImGui::ColorConvertHSVtoRGB(hue, 0.55f, 0.75f, r, g, b);
+
+		return ImGui::GetColorU32(ImVec4(r, g, b, 1.0f));
+	}
+}
+
+void Profiler::ShowFrame()
+{
+	uint64_t frameBegin;
+	uint64_t frameEnd;
+
+	if (!GetLastFrame(frameBegin, frameEnd) || frameEnd <= frameBegin) {
+
+		ImGui::Text("No frame recorded yet");
+		return;
+	}
+
+	const double ticksPerMs = GetTicksPerMs();
+	const double frameMs = (double)(frameEnd - frameBegin) / ticksPerMs;
+
+	ImGui::Text("Frame: %.3f ms", frameMs);
+
+	const auto threads = Collect(frameBegin, frameEnd);
+
+	auto* pDrawList = ImGui::GetWindowDrawList();
+	const float width = std::max(ImGui::GetContentRegionAvailWidth(), 64.0f);
+	const double pixelsPerTick = width / (double)(frameEnd - frameBegin);
+
+	//inclusive time per zone name, summed over every thread
+	struct Total {
+
+		const char* name;
+		double ms;
+		unsigned int count;
+	};
+
+	std::unordered_map<const char*, Total> totals;
+
+	for (const auto& thread : threads) {
+
+		unsigned int maxDepth = 0u;
+
+		for (const auto& event : thread.events) {
+
+			maxDepth = std::max(maxDepth, event.depth);
+		}
+
+		ImGui::TextUnformatted(thread.threadName.c_str());
+
+		const ImVec2 origin = ImGui::GetCursorScreenPos();
+		const float height = (maxDepth + 1u) * rowHeight;
+
+		pDrawList->AddRectFilled(origin, ImVec2(origin.x + width, origin.y + height), ImGui::GetColorU32(ImGuiCol_FrameBg));
+
+		for (const auto& event : thread.events) {
+
+			//zones reaching over the frame edges are cut at them
+			const uint64_t begin = std::max(event.begin, frameBegin);
+			const uint64_t end = std::min(event.end, frameEnd);
+
+			const float x0 = origin.x + (float)((begin - frameBegin) * pixelsPerTick);
+			const float x1 = std::max(origin.x + (float)((end - frameBegin) * pixelsPerTick), x0 + 1.0f);
+			const float y0 = origin.y + event.depth * rowHeight;
+			const float y1 = y0 + rowHeight - 1.0f;
+
+			pDrawList->AddRectFilled(ImVec2(x0, y0), ImVec2(x1, y1), GetZoneColor(event.name));
+
+			//names only where they fit
+			const float textWidth = ImGui::CalcTextSize(event.name).x;
+
+			if (x1 - x0 > textWidth + 4.0f) {
+
+				const ImVec4 clip(x0, y0, x1, y1);
+				pDrawList->AddText(ImGui::GetFont(), ImGui::GetFontSize(), ImVec2(x0 + 2.0f, y0 + 1.0f), IM_COL32_WHITE, event.name, nullptr, 0.0f, &clip);
+			}
+
+			const double ms = (double)(event.end - event.begin) / ticksPerMs;
+
+			if (ImGui::IsMouseHoveringRect(ImVec2(x0, y0), ImVec2(x1, y1))) {
+
+				ImGui::BeginTooltip();
+				ImGui::Text("%s", event.name);
+				ImGui::Text("%.3f ms (%.1f%% of the frame)", ms, ms / frameMs * 100.0);
+				ImGui::EndTooltip();
+			}
+
+			auto& total = totals.try_emplace(event.name, Total{ event.name,0.0,0u }).first->second;
+			total.ms += ms;
+			total.count++;
+		}
+
+		ImGui::Dummy(ImVec2(width, height));
+	}
+
+	std::vector<Total> top;
+	top.reserve(totals.size());
+
+	for (const auto& entry : totals) {
+
+		top.push_back(entry.second);
+	}
+
+	std::sort(top.begin(), top.end(), [](const Total& a, const Total& b) {
+
+		return a.ms > b.ms;
+	});
+
+	if (top.size() > nTopZones) {
+
+		top.resize(nTopZones);
+	}
+
+	ImGui::Separator();
+	ImGui::Columns(3, "zones");
+	ImGui::Text("Zone");
+	ImGui::NextColumn();
+	ImGui::Text("ms");
+	ImGui::NextColumn();
+	ImGui::Text("Calls");
+	ImGui::NextColumn();
+	ImGui::Separator();
+
+	for (const auto& total : top) {
+
+		ImGui::TextUnformatted(total.name);
+		ImGui::NextColumn();
+		ImGui::Text("%.3f", total.ms);
+		ImGui::NextColumn();
+		ImGui::Text("%u", total.count);
+		ImGui::NextColumn();
+	}
+
+	ImGui::Columns(1);
+}
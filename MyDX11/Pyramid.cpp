@@ -3,6 +3,7 @@
 #include "GraphicsThrowMacros.h"
 #include "Cone.h"
 #include <array>
+#include <unordered_map>
 
 Pyramid::Pyramid(Graphics& gfx, 
 	std::mt19937& rng, 
@@ -14,14 +15,30 @@ Pyramid::Pyramid(Graphics& gfx,
 	:TestObject(gfx,rng,adist,ddist,odist,rdist)
 {
 
+	pMesh = ResolveMesh(gfx, tdist(rng));
+}
+
+std::shared_ptr<InstancedMesh> Pyramid::ResolveMesh(Graphics& gfx, int tesselation)
+{
 	using namespace Bind;
 
+	//one mesh per tesselation level, shared by every pyramid using it
+	static std::unordered_map<int, std::weak_ptr<InstancedMesh>> meshes;
+
+	auto& pShared = meshes[tesselation];
+
+	if (auto pMesh = pShared.lock()) {
 
-	auto pvs = std::make_unique<VertexShader>(gfx, L"BlendedPhongVS.cso");
+		return pMesh;
+	}
+
+	std::vector<std::shared_ptr<Bindable>> binds;
+
+	auto pvs = std::make_shared<VertexShader>(gfx, L"InstancedBlendedPhongVS.cso");
 	auto pvsbc = pvs->GetByteCode();
-	AddBind(std::move(pvs));
+	binds.push_back(std::move(pvs));
 	
-	AddBind(std::make_shared<PixelShader>(gfx, L"BlendedPhongPS.cso"));
+	binds.push_back(std::make_shared<PixelShader>(gfx, L"BlendedPhongPS.cso"));
 
 	
 	const std::vector<D3D11_INPUT_ELEMENT_DESC> ied = {
@@ -31,18 +48,18 @@ Pyramid::Pyramid(Graphics& gfx,
 
 	};
 
-	AddBind(std::make_shared<InputLayout>(gfx, ied, pvsbc));
+	binds.push_back(InputLayout::Resolve(gfx, InstancedMesh::WithInstanceLayout(ied), pvsbc));
 
-	AddBind(std::make_shared<Topology>(gfx, D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST));
+	//material constant (ObjectCBuf in BlendedPhongPS)
+	MyDynamicConstant::CbufLayout matLayout;
+	matLayout.Append(MyDynamicConstant::CbufLayout::Float, "specularIntensity");
+	matLayout.Append(MyDynamicConstant::CbufLayout::Float, "specularPower");
 
-	struct PSMaterialConstant {
+	MyDynamicConstant::CbufBuffer matConst(std::move(matLayout));
+	matConst["specularIntensity"] = 0.6f;
+	matConst["specularPower"] = 30.0f;
 
-		float specularIntensity = 0.6f;
-		float specularPower = 30.0f;
-		float padding[2];
-	}colorConst;
-
-	AddBind(std::make_shared<PixelConstantBuffer<PSMaterialConstant>>(gfx, colorConst, 1u));
+	binds.push_back(std::make_shared<DynamicPixelConstantBuffer>(gfx, std::move(matConst), 1u));
 
 
 
@@ -54,7 +71,6 @@ Pyramid::Pyramid(Graphics& gfx,
 		char padding;
 	};
 
-	const auto tesselation = tdist(rng);
 	auto model = Cone::MakeTesselatedIndependentFaces<Vertex>(tesselation);
 
 	//set vertex colors for mesh
@@ -74,10 +90,11 @@ Pyramid::Pyramid(Graphics& gfx,
 	//add normals
 	model.SetNormalsIndependentFlat();
 
-	AddBind(std::make_shared<VertexBuffer>(gfx, model.vertices));
-
-	AddBind(std::make_shared<IndexBuffer>(gfx, model.indices));
+	binds.push_back(std::make_shared<VertexBuffer>(gfx, model.vertices));
 
+	binds.push_back(std::make_shared<IndexBuffer>(gfx, model.indices));
 
-	AddBind(std::make_shared<TransformCbuf>(gfx, *this));
+	auto pMesh = std::make_shared<InstancedMesh>(gfx, std::move(binds));
+	pShared = pMesh;
+	return pMesh;
 }
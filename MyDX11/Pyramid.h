@@ -13,6 +13,10 @@ public:
 		std::uniform_real_distribution<float>& rdist,
 		std::uniform_int_distribution<int>& tdist);
 
+private:
+
+	//geometry shared between pyramids with the same tesselation
+	static std::shared_ptr<InstancedMesh> ResolveMesh(Graphics& gfx, int tesselation);
 
 };
 
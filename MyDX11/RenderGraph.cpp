@@ -0,0 +1,743 @@
+#include "RenderGraph.h"
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+
+namespace {
+
+	constexpr size_t maxRenderTargets = 8u;
+
+	bool IsDepthFormat(TextureFormat format) noexcept
+	{
+		return format == TextureFormat::D32Float || format == TextureFormat::D24UnormS8Uint;
+	}
+
+	const char* GetFormatName(TextureFormat format) noexcept
+	{
+		switch (format) {
+
+		case TextureFormat::R16G16B16A16Float: return "R16G16B16A16_FLOAT";
+		case TextureFormat::R10G10B10A2Unorm: return "R10G10B10A2_UNORM";
+		case TextureFormat::R11G11B10Float: return "R11G11B10_FLOAT";
+		case TextureFormat::R8G8B8A8Unorm: return "R8G8B8A8_UNORM";
+		case TextureFormat::D32Float: return "D32_FLOAT";
+		case TextureFormat::R32Float: return "R32_FLOAT";
+		case TextureFormat::D24UnormS8Uint: return "D24_UNORM_S8_UINT";
+		case TextureFormat::B8G8R8A8Unorm: return "B8G8R8A8_UNORM";
+		default: return "UNKNOWN";
+		}
+	}
+}
+
+
+bool RenderGraph::TextureDesc::operator==(const TextureDesc& other) const noexcept
+{
+	return width == other.width && height == other.height && format == other.format;
+}
+
+bool RenderGraph::TextureDesc::operator!=(const TextureDesc& other) const noexcept
+{
+	return !(*this == other);
+}
+
+bool RenderGraph::Use::IsWrite() const noexcept
+{
+	return state == State::RenderTarget || state == State::DepthWrite;
+}
+
+
+RenderGraph::Pass::Pass(RenderGraph& graph, std::string name, Callback callback)
+	:
+	m_pGraph(&graph),
+	m_name(std::move(name)),
+	m_callback(std::move(callback))
+{}
+
+RenderGraph::Pass& RenderGraph::Pass::Read(const std::string& resource, State state, unsigned int slot)
+{
+	if (state != State::ShaderResource && state != State::DepthRead && state != State::CopySource) {
+
+		throw Exception(__LINE__, __FILE__, "Pass [" + m_name + "] reads [" + resource + "] as " + GetStateName(state));
+	}
+
+	Use use = {};
+	use.state = state;
+	use.slot = slot;
+
+	return Add(resource, use);
+}
+
+RenderGraph::Pass& RenderGraph::Pass::Write(const std::string& resource, State state, LoadOp load)
+{
+	if (state != State::RenderTarget && state != State::DepthWrite) {
+
+		throw Exception(__LINE__, __FILE__, "Pass [" + m_name + "] writes [" + resource + "] as " + GetStateName(state));
+	}
+
+	Use use = {};
+	use.state = state;
+	use.load = load;
+
+	return Add(resource, use);
+}
+
+RenderGraph::Pass& RenderGraph::Pass::Clear(const std::string& resource, const std::array<float, 4>& color)
+{
+	Use use = {};
+	use.state = State::RenderTarget;
+	use.load = LoadOp::Clear;
+	use.clearValue = color;
+
+	return Add(resource, use);
+}
+
+RenderGraph::Pass& RenderGraph::Pass::ClearDepth(const std::string& resource, float depth)
+{
+	Use use = {};
+	use.state = State::DepthWrite;
+	use.load = LoadOp::Clear;
+	use.clearValue[0] = depth;
+
+	return Add(resource, use);
+}
+
+RenderGraph::Pass& RenderGraph::Pass::KeepAlive() noexcept
+{
+	m_isKeptAlive = true;
+	return *this;
+}
+
+const std::string& RenderGraph::Pass::GetName() const noexcept
+{
+	return m_name;
+}
+
+const std::vector<RenderGraph::Use>& RenderGraph::Pass::GetUses() const noexcept
+{
+	return m_uses;
+}
+
+void RenderGraph::Pass::Execute(Graphics& gfx) const
+{
+	if (m_callback) {
+
+		m_callback(gfx);
+	}
+}
+
+RenderGraph::Pass& RenderGraph::Pass::Add(const std::string& resource, Use use)
+{
+	use.resource = m_pGraph->GetResourceIndex(resource);
+
+	const auto& desc = m_pGraph->m_resources[use.resource].desc;
+	const bool isDepthState = use.state == State::DepthWrite || use.state == State::DepthRead;
+
+	if (isDepthState != IsDepthFormat(desc.format) && use.state != State::ShaderResource && use.state != State::CopySource) {
+
+		throw Exception(__LINE__, __FILE__, "Pass [" + m_name + "] uses [" + resource + "] (" + GetFormatName(desc.format) + ") as " + GetStateName(use.state));
+	}
+
+	//d3d11 can't have one texture bound for reading and writing at once, and twice would be ambiguous anyway
+	for (const auto& other : m_uses) {
+
+		if (other.resource == use.resource) {
+
+			throw Exception(__LINE__, __FILE__, "Pass [" + m_name + "] uses [" + resource + "] more than once");
+		}
+	}
+
+	m_uses.push_back(use);
+	m_pGraph->m_isCompiled = false;
+
+	return *this;
+}
+
+
+void RenderGraph::CreateTexture(const std::string& name, const TextureDesc& desc)
+{
+	Resource resource;
+	resource.name = name;
+	resource.desc = desc;
+
+	AddResource(std::move(resource));
+}
+
+void RenderGraph::ImportTexture(const std::string& name, const TextureDesc& desc, void* pTexture)
+{
+	Resource resource;
+	resource.name = name;
+	resource.desc = desc;
+	resource.isImported = true;
+	resource.pImported = pTexture;
+
+	AddResource(std::move(resource));
+}
+
+void RenderGraph::MarkOutput(const std::string& name)
+{
+	m_resources[GetResourceIndex(name)].isOutput = true;
+	m_isCompiled = false;
+}
+
+RenderGraph::Pass& RenderGraph::AddPass(const std::string& name, Callback callback)
+{
+	m_passes.push_back(Pass(*this, name, std::move(callback)));
+	m_isCompiled = false;
+
+	return m_passes.back();
+}
+
+void RenderGraph::Compile()
+{
+	const size_t nPasses = m_passes.size();
+	const size_t nResources = m_resources.size();
+
+	//passes whose output this one uses
+	std::vector<std::vector<size_t>> needs(nPasses);
+	std::vector<size_t> lastWriter(nResources, npos);
+
+	for (size_t p = 0; p < nPasses; p++) {
+
+		const auto& pass = m_passes[p];
+
+		size_t nTargets = 0u;
+		size_t nDepth = 0u;
+		const TextureDesc* pTargetDesc = nullptr;
+
+		for (const auto& use : pass.m_uses) {
+
+			const auto& resource = m_resources[use.resource];
+
+			if (use.state == State::RenderTarget || use.state == State::DepthWrite || use.state == State::DepthRead) {
+
+				nTargets += use.state == State::RenderTarget ? 1u : 0u;
+				nDepth += use.state == State::RenderTarget ? 0u : 1u;
+
+				//everything bound to the OM together has to be the same size
+				if (pTargetDesc != nullptr && (pTargetDesc->width != resource.desc.width || pTargetDesc->height != resource.desc.height)) {
+
+					throw Exception(__LINE__, __FILE__, "Pass [" + pass.m_name + "] binds targets of different sizes ([" + resource.name + "])");
+				}
+
+				pTargetDesc = &resource.desc;
+			}
+
+			const size_t writer = lastWriter[use.resource];
+
+			if (!use.IsWrite() || use.load == LoadOp::Load) {
+
+				if (writer == npos && !resource.isImported) {
+
+					throw Exception(__LINE__, __FILE__, "Pass [" + pass.m_name + "] uses what is in [" + resource.name +
+						"] before any pass wrote it, the first write has to clear or discard it");
+				}
+
+				if (writer != npos) {
+
+					needs[p].push_back(writer);
+				}
+			}
+
+			if (use.IsWrite()) {
+
+				lastWriter[use.resource] = p;
+			}
+		}
+
+		if (nTargets > maxRenderTargets || nDepth > 1u) {
+
+			throw Exception(__LINE__, __FILE__, "Pass [" + pass.m_name + "] binds more targets than d3d11 has slots for");
+		}
+	}
+
+	//culling, everything a kept alive pass or the last write of an output depends on survives
+	std::vector<bool> isLive(nPasses, false);
+	std::vector<size_t> stack;
+
+	for (size_t p = 0; p < nPasses; p++) {
+
+		if (m_passes[p].m_isKeptAlive) {
+
+			stack.push_back(p);
+		}
+	}
+
+	for (size_t r = 0; r < nResources; r++) {
+
+		if (m_resources[r].isOutput) {
+
+			if (lastWriter[r] == npos) {
+
+				throw Exception(__LINE__, __FILE__, "Output [" + m_resources[r].name + "] is never written");
+			}
+
+			stack.push_back(lastWriter[r]);
+		}
+	}
+
+	while (!stack.empty()) {
+
+		const size_t p = stack.back();
+		stack.pop_back();
+
+		if (isLive[p]) {
+
+			continue;
+		}
+
+		isLive[p] = true;
+		stack.insert(stack.end(), needs[p].begin(), needs[p].end());
+	}
+
+	//passes that only have to run before a write (the last write and the reads since), among the live ones only
+	//*a culled write in between would otherwise hide the reads before it from the writes after it
+	std::vector<std::vector<size_t>> after(nPasses);
+	std::vector<size_t> lastLiveWriter(nResources, npos);
+	std::vector<std::vector<size_t>> readers(nResources);
+
+	for (size_t p = 0; p < nPasses; p++) {
+
+		if (!isLive[p]) {
+
+			continue;
+		}
+
+		for (const auto& use : m_passes[p].m_uses) {
+
+			if (use.IsWrite()) {
+
+				if (lastLiveWriter[use.resource] != npos) {
+
+					after[p].push_back(lastLiveWriter[use.resource]);
+				}
+
+				after[p].insert(after[p].end(), readers[use.resource].begin(), readers[use.resource].end());
+
+				lastLiveWriter[use.resource] = p;
+				readers[use.resource].clear();
+			}
+			else {
+
+				readers[use.resource].push_back(p);
+			}
+		}
+	}
+
+	//topological order of what's left (Kahn)
+	//*of the passes that are ready, one drawing to the same targets as the last goes first so the OM isn't rebound, then the earliest added
+	std::vector<std::vector<size_t>> successors(nPasses);
+	std::vector<size_t> nPending(nPasses, 0u);
+
+	for (size_t p = 0; p < nPasses; p++) {
+
+		if (!isLive[p]) {
+
+			continue;
+		}
+
+		for (const auto& edges : { &needs[p],&after[p] }) {
+
+			for (const size_t q : *edges) {
+
+				if (isLive[q]) {
+
+					successors[q].push_back(p);
+					nPending[p]++;
+				}
+			}
+		}
+	}
+
+	const auto getTargets = [this](size_t p) {
+
+		std::vector<size_t> targets;
+
+		for (const auto& use : m_passes[p].m_uses) {
+
+			if (use.state == State::RenderTarget || use.state == State::DepthWrite || use.state == State::DepthRead) {
+
+				targets.push_back(use.resource);
+			}
+		}
+
+		return targets;
+	};
+
+	std::vector<size_t> ready;
+	std::vector<size_t> order;
+
+	for (size_t p = 0; p < nPasses; p++) {
+
+		if (isLive[p] && nPending[p] == 0u) {
+
+			ready.push_back(p);
+		}
+	}
+
+	while (!ready.empty()) {
+
+		auto next = std::min_element(ready.begin(), ready.end());
+
+		if (!order.empty()) {
+
+			const auto lastTargets = getTargets(order.back());
+
+			if (!lastTargets.empty()) {
+
+				for (auto it = ready.begin(); it != ready.end(); ++it) {
+
+					if (getTargets(*it) == lastTargets && (*it < *next || getTargets(*next) != lastTargets)) {
+
+						next = it;
+					}
+				}
+			}
+		}
+
+		const size_t p = *next;
+		ready.erase(next);
+		order.push_back(p);
+
+		for (const size_t q : successors[p]) {
+
+			if (--nPending[q] == 0u) {
+
+				ready.push_back(q);
+			}
+		}
+	}
+
+	//steps and lifetimes
+	m_steps.clear();
+	m_allocations.clear();
+
+	for (auto& resource : m_resources) {
+
+		resource.firstStep = npos;
+		resource.lastStep = npos;
+		resource.allocation = npos;
+	}
+
+	for (size_t s = 0; s < order.size(); s++) {
+
+		Step step;
+		step.pass = order[s];
+
+		for (const auto& use : m_passes[step.pass].m_uses) {
+
+			auto& resource = m_resources[use.resource];
+
+			resource.firstStep = std::min(resource.firstStep, s);
+			resource.lastStep = resource.lastStep == npos ? s : std::max(resource.lastStep, s);
+
+			switch (use.state) {
+
+			case State::RenderTarget:
+				step.renderTargets.push_back(use.resource);
+				break;
+			case State::DepthWrite:
+			case State::DepthRead:
+				step.depthStencil = use.resource;
+				step.isDepthReadOnly = use.state == State::DepthRead;
+				break;
+			case State::ShaderResource:
+				step.shaderResources.push_back({ use.slot,use.resource });
+				break;
+			default:
+				break;
+			}
+
+			if (use.IsWrite() && use.load == LoadOp::Clear) {
+
+				step.clears.push_back(use);
+			}
+		}
+
+		m_steps.push_back(std::move(step));
+	}
+
+	//aliasing, transient textures in order of first use each take the first allocation of the same kind that's free by then
+	std::vector<size_t> transients;
+
+	for (size_t r = 0; r < nResources; r++) {
+
+		if (!m_resources[r].isImported && m_resources[r].firstStep != npos) {
+
+			transients.push_back(r);
+		}
+	}
+
+	std::stable_sort(transients.begin(), transients.end(), [this](size_t a, size_t b) {
+
+		return m_resources[a].firstStep < m_resources[b].firstStep;
+	});
+
+	for (const size_t r : transients) {
+
+		auto& resource = m_resources[r];
+
+		for (size_t a = 0; a < m_allocations.size() && resource.allocation == npos; a++) {
+
+			const auto& allocation = m_allocations[a];
+
+			if (allocation.desc == resource.desc && m_resources[allocation.resources.back()].lastStep < resource.firstStep) {
+
+				resource.allocation = a;
+			}
+		}
+
+		if (resource.allocation == npos) {
+
+			resource.allocation = m_allocations.size();
+
+			Allocation allocation;
+			allocation.desc = resource.desc;
+			m_allocations.push_back(std::move(allocation));
+		}
+
+		m_allocations[resource.allocation].resources.push_back(r);
+	}
+
+	//transitions, tracked per texture so the handover between aliased resources shows up too
+	const size_t nAllocations = m_allocations.size();
+	std::vector<State> states(nAllocations + nResources, State::None);
+	std::vector<size_t> owners(nAllocations + nResources, npos);
+
+	for (auto& step : m_steps) {
+
+		for (const auto& use : m_passes[step.pass].m_uses) {
+
+			const auto& resource = m_resources[use.resource];
+			const size_t key = resource.isImported ? nAllocations + use.resource : resource.allocation;
+
+			if (!resource.isImported) {
+
+				auto& allocation = m_allocations[resource.allocation];
+				allocation.isRenderTarget |= use.state == State::RenderTarget;
+				allocation.isDepthStencil |= use.state == State::DepthWrite || use.state == State::DepthRead;
+				allocation.isShaderResource |= use.state == State::ShaderResource;
+			}
+
+			if (states[key] != use.state || owners[key] != use.resource) {
+
+				step.transitions.push_back({ use.resource,states[key],use.state });
+				states[key] = use.state;
+				owners[key] = use.resource;
+			}
+		}
+	}
+
+	m_isCulled.assign(nPasses, true);
+
+	for (const size_t p : order) {
+
+		m_isCulled[p] = false;
+	}
+
+	m_isCompiled = true;
+}
+
+bool RenderGraph::IsCompiled() const noexcept
+{
+	return m_isCompiled;
+}
+
+const std::deque<RenderGraph::Pass>& RenderGraph::GetPasses() const noexcept
+{
+	return m_passes;
+}
+
+const std::vector<RenderGraph::Resource>& RenderGraph::GetResources() const noexcept
+{
+	return m_resources;
+}
+
+const std::vector<RenderGraph::Step>& RenderGraph::GetSteps() const noexcept
+{
+	return m_steps;
+}
+
+const std::vector<RenderGraph::Allocation>& RenderGraph::GetAllocations() const noexcept
+{
+	return m_allocations;
+}
+
+bool RenderGraph::IsCulled(size_t pass) const noexcept
+{
+	return pass < m_isCulled.size() && m_isCulled[pass];
+}
+
+size_t RenderGraph::FindResource(const std::string& name) const noexcept
+{
+	for (size_t i = 0; i < m_resources.size(); i++) {
+
+		if (m_resources[i].name == name) {
+
+			return i;
+		}
+	}
+
+	return npos;
+}
+
+size_t RenderGraph::GetTransientBytes() const noexcept
+{
+	size_t bytes = 0u;
+
+	for (const auto& resource : m_resources) {
+
+		if (!resource.isImported && resource.firstStep != npos) {
+
+			bytes += GetTextureBytes(resource.desc);
+		}
+	}
+
+	return bytes;
+}
+
+size_t RenderGraph::GetAllocatedBytes() const noexcept
+{
+	size_t bytes = 0u;
+
+	for (const auto& allocation : m_allocations) {
+
+		bytes += GetTextureBytes(allocation.desc);
+	}
+
+	return bytes;
+}
+
+size_t RenderGraph::GetTextureBytes(const TextureDesc& desc) noexcept
+{
+	const size_t bytesPerPixel = desc.format == TextureFormat::R16G16B16A16Float ? 8u :
+		desc.format == TextureFormat::Unknown ? 0u : 4u;
+
+	return (size_t)desc.width * desc.height * bytesPerPixel;
+}
+
+const char* RenderGraph::GetStateName(State state) noexcept
+{
+	switch (state) {
+
+	case State::None: return "None";
+	case State::RenderTarget: return "RenderTarget";
+	case State::DepthWrite: return "DepthWrite";
+	case State::DepthRead: return "DepthRead";
+	case State::ShaderResource: return "ShaderResource";
+	case State::CopySource: return "CopySource";
+	default: return "?";
+	}
+}
+
+std::string RenderGraph::Describe() const
+{
+	std::ostringstream oss;
+
+	if (!m_isCompiled) {
+
+		return "Not compiled\n";
+	}
+
+	for (size_t s = 0; s < m_steps.size(); s++) {
+
+		const auto& step = m_steps[s];
+
+		oss << s << ": " << m_passes[step.pass].m_name << "\n";
+
+		for (const auto& transition : step.transitions) {
+
+			oss << "    " << m_resources[transition.resource].name << " " << GetStateName(transition.before) << " -> " << GetStateName(transition.after) << "\n";
+		}
+
+		for (const auto& clear : step.clears) {
+
+			oss << "    clear " << m_resources[clear.resource].name << "\n";
+		}
+	}
+
+	for (size_t p = 0; p < m_passes.size(); p++) {
+
+		if (IsCulled(p)) {
+
+			oss << "culled: " << m_passes[p].m_name << "\n";
+		}
+	}
+
+	oss << std::fixed << std::setprecision(2);
+
+	for (size_t a = 0; a < m_allocations.size(); a++) {
+
+		const auto& allocation = m_allocations[a];
+
+		oss << "texture " << a << " (" << allocation.desc.width << "x" << allocation.desc.height << " " << GetFormatName(allocation.desc.format)
+			<< ", " << GetTextureBytes(allocation.desc) / (1024.0 * 1024.0) << " MB):";
+
+		for (const size_t r : allocation.resources) {
+
+			oss << " " << m_resources[r].name << " [" << m_resources[r].firstStep << "," << m_resources[r].lastStep << "]";
+		}
+
+		oss << "\n";
+	}
+
+	oss << "transient " << GetTransientBytes() / (1024.0 * 1024.0) << " MB in " << GetAllocatedBytes() / (1024.0 * 1024.0) << " MB\n";
+
+	return oss.str();
+}
+
+size_t RenderGraph::GetResourceIndex(const std::string& name) const
+{
+	const size_t index = FindResource(name);
+
+	if (index == npos) {
+
+		throw Exception(__LINE__, __FILE__, "No texture named [" + name + "] in the graph");
+	}
+
+	return index;
+}
+
+void RenderGraph::AddResource(Resource resource)
+{
+	if (FindResource(resource.name) != npos) {
+
+		throw Exception(__LINE__, __FILE__, "Texture [" + resource.name + "] is already in the graph");
+	}
+
+	if (resource.desc.format == TextureFormat::Unknown || resource.desc.width == 0u || resource.desc.height == 0u) {
+
+		throw Exception(__LINE__, __FILE__, "Texture [" + resource.name + "] has no size or format");
+	}
+
+	m_resources.push_back(std::move(resource));
+	m_isCompiled = false;
+}
+
+
+//render graph exception stuff
+RenderGraph::Exception::Exception(int line, const char* file, std::string note) noexcept
+	:
+	myException(line, file),
+	note(std::move(note))
+{}
+
+const char* RenderGraph::Exception::what() const noexcept
+{
+	std::ostringstream oss;
+
+	oss << myException::what() << std::endl
+		<< "[Note] " << GetNote();
+
+	whatBuffer = oss.str();
+	return whatBuffer.c_str();
+}
+
+const char* RenderGraph::Exception::GetType() const noexcept
+{
+	return "SupaHotFire RenderGraph Exception";
+}
+
+const std::string& RenderGraph::Exception::GetNote() const noexcept
+{
+	return note;
+}
@@ -0,0 +1,245 @@
+#pragma once
+
+#include "myException.h"
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <deque>
+#include <array>
+#include <functional>
+
+class Graphics;
+
+//the formats a graph texture can use, same numbers as DXGI_FORMAT so a value can be cast straight across
+enum class TextureFormat : uint32_t {
+
+	Unknown = 0,
+	R16G16B16A16Float = 10,
+	R10G10B10A2Unorm = 24,
+	R11G11B10Float = 26,
+	R8G8B8A8Unorm = 28,
+	D32Float = 40,
+	R32Float = 41,
+	D24UnormS8Uint = 45,
+	B8G8R8A8Unorm = 87,
+};
+
+/// <summary>
+/// A frame described as passes that read and write named textures, instead of targets bound by hand
+/// Compile works out the pass order from the reads and writes, drops passes nothing needs,
+/// gives transient textures with lifetimes that don't overlap the same texture and lists the state changes and binds for every pass
+/// rebuilt every frame, Graphics::Execute runs it and keeps the textures between frames
+/// works without windows
+/// </summary>
+class RenderGraph {
+
+public:
+
+	class Exception :public myException {
+
+	public:
+
+		Exception(int line, const char* file, std::string note) noexcept;
+		const char* what() const noexcept override;
+		const char* GetType() const noexcept override;
+
+		const std::string& GetNote() const noexcept;
+
+	private:
+
+		std::string note;
+	};
+
+	struct TextureDesc {
+
+		unsigned int width = 0u;
+		unsigned int height = 0u;
+		TextureFormat format = TextureFormat::Unknown;
+
+		bool operator==(const TextureDesc& other) const noexcept;
+		bool operator!=(const TextureDesc& other) const noexcept;
+	};
+
+	//how a pass uses a texture, also the state the texture is in afterwards
+	enum class State {
+
+		//before the first use in the frame
+		None,
+		RenderTarget,
+		DepthWrite,
+		DepthRead,
+		ShaderResource,
+		CopySource,
+	};
+
+	//what a write does with what was in the texture before
+	enum class LoadOp {
+
+		//keeps it, the pass depends on the one that wrote it last
+		Load,
+		Clear,
+		//the pass covers every pixel itself
+		Discard,
+	};
+
+	struct Use {
+
+		size_t resource;
+		State state;
+		LoadOp load = LoadOp::Load;
+		//color, or the depth in [0]
+		std::array<float, 4> clearValue = {};
+		//pixel shader register for ShaderResource reads
+		unsigned int slot = 0u;
+
+		bool IsWrite() const noexcept;
+	};
+
+	using Callback = std::function<void(Graphics& gfx)>;
+
+	class Pass {
+
+		friend class RenderGraph;
+
+	public:
+
+		//state has to be ShaderResource, DepthRead or CopySource
+		Pass& Read(const std::string& resource, State state = State::ShaderResource, unsigned int slot = 0u);
+		//state has to be RenderTarget or DepthWrite, render targets go to the OM slots in the order they are written
+		Pass& Write(const std::string& resource, State state = State::RenderTarget, LoadOp load = LoadOp::Load);
+		Pass& Clear(const std::string& resource, const std::array<float, 4>& color);
+		Pass& ClearDepth(const std::string& resource, float depth = 1.0f);
+		//never culled, for passes whose work leaves the frame (copies for readback and the like)
+		Pass& KeepAlive() noexcept;
+
+		const std::string& GetName() const noexcept;
+		const std::vector<Use>& GetUses() const noexcept;
+		//calls the callback, passes without one only set up their targets (clears)
+		void Execute(Graphics& gfx) const;
+
+	private:
+
+		Pass(RenderGraph& graph, std::string name, Callback callback);
+
+		Pass& Add(const std::string& resource, Use use);
+
+	private:
+
+		RenderGraph* m_pGraph;
+		std::string m_name;
+		Callback m_callback;
+		std::vector<Use> m_uses;
+		bool m_isKeptAlive = false;
+	};
+
+	struct Resource {
+
+		std::string name;
+		TextureDesc desc;
+		//owned outside the graph (the back buffer), never aliased
+		//*pImported is what Execute binds, for Graphics an ID3D11Texture2D
+		bool isImported = false;
+		void* pImported = nullptr;
+		//has to be written by the end of the frame, so its last writer is never culled
+		bool isOutput = false;
+
+		//filled by Compile, npos when no pass left uses it
+		size_t firstStep = npos;
+		size_t lastStep = npos;
+		//index into GetAllocations, npos for imported textures
+		size_t allocation = npos;
+	};
+
+	//one texture backing every transient resource aliased onto it
+	struct Allocation {
+
+		TextureDesc desc;
+		//every state any of its resources is used in, for the bind flags
+		bool isRenderTarget = false;
+		bool isDepthStencil = false;
+		bool isShaderResource = false;
+		//in the order they use it
+		std::vector<size_t> resources;
+	};
+
+	struct Transition {
+
+		size_t resource;
+		State before;
+		State after;
+	};
+
+	struct ShaderResource {
+
+		unsigned int slot;
+		size_t resource;
+	};
+
+	//one pass that survived culling, with everything to do before running it
+	struct Step {
+
+		size_t pass;
+		//state changes of the textures it uses, a resource taking over an aliased texture starts from the old owner's state
+		std::vector<Transition> transitions;
+		std::vector<Use> clears;
+		std::vector<size_t> renderTargets;
+		size_t depthStencil = npos;
+		bool isDepthReadOnly = false;
+		std::vector<ShaderResource> shaderResources;
+	};
+
+	static constexpr size_t npos = SIZE_MAX;
+
+public:
+
+	RenderGraph() = default;
+	RenderGraph(const RenderGraph&) = delete;
+	RenderGraph& operator=(const RenderGraph&) = delete;
+
+	//a texture only this frame uses, it may share memory with others whose lifetimes don't overlap
+	void CreateTexture(const std::string& name, const TextureDesc& desc);
+	void ImportTexture(const std::string& name, const TextureDesc& desc, void* pTexture);
+	void MarkOutput(const std::string& name);
+
+	//the order passes are added in is the order their reads and writes happen in,
+	//a read sees the last write added before it
+	Pass& AddPass(const std::string& name, Callback callback = {});
+
+	//throws on reads of textures nothing wrote and other misuse
+	void Compile();
+	bool IsCompiled() const noexcept;
+
+	const std::deque<Pass>& GetPasses() const noexcept;
+	const std::vector<Resource>& GetResources() const noexcept;
+	const std::vector<Step>& GetSteps() const noexcept;
+	const std::vector<Allocation>& GetAllocations() const noexcept;
+	bool IsCulled(size_t pass) const noexcept;
+
+	//npos when there's no such texture
+	size_t FindResource(const std::string& name) const noexcept;
+
+	//bytes the transient textures would take one each and what the allocations take
+	size_t GetTransientBytes() const noexcept;
+	size_t GetAllocatedBytes() const noexcept;
+	static size_t GetTextureBytes(const TextureDesc& desc) noexcept;
+	static const char* GetStateName(State state) noexcept;
+
+	//steps, transitions and allocations one per line, for the debug output
+	std::string Describe() const;
+
+private:
+
+	size_t GetResourceIndex(const std::string& name) const;
+	void AddResource(Resource resource);
+
+private:
+
+	std::deque<Pass> m_passes;
+	std::vector<Resource> m_resources;
+
+	std::vector<Step> m_steps;
+	std::vector<Allocation> m_allocations;
+	std::vector<bool> m_isCulled;
+	bool m_isCompiled = false;
+};
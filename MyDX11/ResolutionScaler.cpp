@@ -0,0 +1,202 @@
+#include "ResolutionScaler.h"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+ResolutionScaler::ResolutionScaler()
+	:
+	ResolutionScaler(Settings())
+{}
+
+ResolutionScaler::ResolutionScaler(const Settings& settings)
+{
+	SetSettings(settings);
+	Reset(m_settings.maxScale);
+}
+
+float ResolutionScaler::Update(uint64_t frameNs)
+{
+	//the first frame seeds the filter, anything before would drag it
+	m_filteredNs = m_filteredNs == 0.0 ? (double)frameNs :
+		m_filteredNs + m_settings.smoothing * ((double)frameNs - m_filteredNs);
+
+	//positive when there's time to spare, measured from the edge of the deadband
+	//so leaving it doesn't kick the proportional term by the whole band
+	const double target = (double)std::max(m_settings.targetNs, (uint64_t)1u);
+	double error = (target - m_filteredNs) / target;
+
+	error = error > 0.0 ? std::max(error - m_settings.deadband, 0.0) : std::min(error + m_settings.deadband, 0.0);
+
+	//the history keeps moving while the scale is held, otherwise the first update after
+	//compares against an error from before the change and swings the area straight back
+	if (m_cooldown > 0u) {
+
+		m_cooldown--;
+		m_lastLastError = m_lastError;
+		m_lastError = error;
+		return m_scale;
+	}
+
+	//incremental form, clamping the output is all the anti windup it needs
+	const double delta =
+		m_settings.kp * (error - m_lastError) +
+		m_settings.ki * error +
+		m_settings.kd * (error - 2.0 * m_lastError + m_lastLastError);
+
+	const double minArea = (double)m_settings.minScale * m_settings.minScale;
+	const double maxArea = (double)m_settings.maxScale * m_settings.maxScale;
+
+	m_area = std::clamp(m_area + delta, minArea, maxArea);
+	m_lastLastError = m_lastError;
+	m_lastError = error;
+
+	//hysteresis, the raw scale has to be three quarters of a step past the applied one
+	//*quantized and clamped first, and a controller pinned at a bound always moves, so the ends of the range are still reached
+	const float raw = GetRawScale();
+	const float next = Quantize(raw);
+	const bool isAtBound = m_area <= minArea || m_area >= maxArea;
+
+	//going up only when the frame time grown with the pixels still fits, if neither step around
+	//the target lands in the deadband it would otherwise flip between them for good
+	//*the area is held at the applied scale meanwhile, so the integral doesn't wind up against the refusal
+	if (next > m_scale && m_filteredNs * next * next > target * (1.0 + m_settings.deadband) * m_scale * m_scale) {
+
+		m_area = (double)m_scale * m_scale;
+	}
+	else if (next != m_scale && (std::abs(raw - m_scale) > m_settings.step * 0.75f || isAtBound)) {
+
+		m_scale = next;
+		m_cooldown = m_settings.cooldownFrames;
+		m_nChanges++;
+	}
+
+	return m_scale;
+}
+
+void ResolutionScaler::Reset(float scale)
+{
+	m_scale = Quantize(scale);
+	m_area = (double)m_scale * m_scale;
+	m_filteredNs = 0.0;
+	m_lastError = 0.0;
+	m_lastLastError = 0.0;
+	m_cooldown = 0u;
+}
+
+void ResolutionScaler::SetSettings(const Settings& settings)
+{
+	m_settings = settings;
+	m_settings.step = std::max(m_settings.step, 0.01f);
+	m_settings.minScale = std::clamp(m_settings.minScale, m_settings.step, 1.0f);
+	m_settings.maxScale = std::clamp(m_settings.maxScale, m_settings.minScale, 1.0f);
+
+	const double minArea = (double)m_settings.minScale * m_settings.minScale;
+	const double maxArea = (double)m_settings.maxScale * m_settings.maxScale;
+
+	m_area = std::clamp(m_area, minArea, maxArea);
+	m_scale = Quantize(m_scale);
+}
+
+const ResolutionScaler::Settings& ResolutionScaler::GetSettings() const noexcept
+{
+	return m_settings;
+}
+
+float ResolutionScaler::GetScale() const noexcept
+{
+	return m_scale;
+}
+
+float ResolutionScaler::GetRawScale() const noexcept
+{
+	return (float)std::sqrt(m_area);
+}
+
+double ResolutionScaler::GetFilteredNs() const noexcept
+{
+	return m_filteredNs;
+}
+
+unsigned int ResolutionScaler::GetChangeCount() const noexcept
+{
+	return m_nChanges;
+}
+
+unsigned int ResolutionScaler::ScaleSize(unsigned int size, float scale) noexcept
+{
+	return std::max((unsigned int)std::lround((double)size * scale), 1u);
+}
+
+std::vector<ResolutionScaler::Sample> ResolutionScaler::Replay(const std::vector<uint64_t>& framesNs, const Settings& settings)
+{
+	ResolutionScaler scaler(settings);
+
+	std::vector<Sample> samples;
+	samples.reserve(framesNs.size());
+
+	for (const uint64_t frameNs : framesNs) {
+
+		const float scale = scaler.Update(frameNs);
+		samples.push_back({ frameNs,scaler.GetFilteredNs(),scale });
+	}
+
+	return samples;
+}
+
+std::vector<uint64_t> ResolutionScaler::ParseTrace(const std::string& text)
+{
+	std::vector<uint64_t> framesNs;
+	std::istringstream iss(text);
+	std::string line;
+
+	//column of the frame time, the third in a FrameStats csv and the only one otherwise
+	size_t column = 0u;
+
+	while (std::getline(iss, line)) {
+
+		if (!line.empty() && line.back() == '\r') {
+
+			line.pop_back();
+		}
+
+		if (line.empty()) {
+
+			continue;
+		}
+
+		std::vector<std::string> fields;
+		std::istringstream row(line);
+
+		for (std::string field; std::getline(row, field, ',');) {
+
+			fields.push_back(field);
+		}
+
+		//any line with more than numbers is a header, one naming duration_ns picks the column
+		if (line.find_first_not_of("0123456789,.") != std::string::npos) {
+
+			const auto it = std::find(fields.begin(), fields.end(), "duration_ns");
+
+			if (it != fields.end()) {
+
+				column = (size_t)(it - fields.begin());
+			}
+
+			continue;
+		}
+
+		if (column < fields.size() && !fields[column].empty()) {
+
+			framesNs.push_back(std::stoull(fields[column]));
+		}
+	}
+
+	return framesNs;
+}
+
+float ResolutionScaler::Quantize(float scale) const noexcept
+{
+	const float stepped = std::round(scale / m_settings.step) * m_settings.step;
+
+	return std::clamp(stepped, m_settings.minScale, m_settings.maxScale);
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Picks the scale of the internal render resolution from measured frame times, to hold a target frame time
+/// an incremental PID works on the share of pixels drawn (scale squared, which is what the GPU time follows),
+/// errors inside the deadband count as none and the applied scale only moves in whole steps once the controller is three quarters of a step past it,
+/// up only when the frame time is expected to still fit at the larger size,
+/// after a change the controller holds for a few frames since the timings of the new size arrive late
+/// works on plain numbers only, so recorded traces can be replayed through it without windows
+/// </summary>
+class ResolutionScaler {
+
+public:
+
+	struct Settings {
+
+		uint64_t targetNs = 16'666'667u;
+		float minScale = 0.5f;
+		float maxScale = 1.0f;
+		//applied scales are multiples of this, so render targets aren't recreated every frame
+		float step = 0.05f;
+
+		double kp = 0.3;
+		double ki = 0.08;
+		double kd = 0.05;
+
+		//errors within this share of the target are left alone
+		double deadband = 0.05;
+		//weight of the newest frame in the filtered frame time
+		double smoothing = 0.25;
+		//frames held after the scale changes
+		unsigned int cooldownFrames = 6u;
+	};
+
+	//one replayed frame
+	struct Sample {
+
+		uint64_t frameNs;
+		double filteredNs;
+		float scale;
+	};
+
+public:
+
+	ResolutionScaler();
+	ResolutionScaler(const Settings& settings);
+
+	//one measured frame, returns the scale to draw the next one at
+	float Update(uint64_t frameNs);
+	//back to a fixed scale with the controller's history dropped
+	void Reset(float scale = 1.0f);
+
+	void SetSettings(const Settings& settings);
+	const Settings& GetSettings() const noexcept;
+
+	//what the next frame is drawn at, always a multiple of the step
+	float GetScale() const noexcept;
+	//what the controller would like, before the steps and the hysteresis
+	float GetRawScale() const noexcept;
+	double GetFilteredNs() const noexcept;
+	unsigned int GetChangeCount() const noexcept;
+
+	//size in pixels at a scale, never 0
+	static unsigned int ScaleSize(unsigned int size, float scale) noexcept;
+
+	//open loop, every recorded frame time goes through a fresh scaler
+	static std::vector<Sample> Replay(const std::vector<uint64_t>& framesNs, const Settings& settings);
+	//frame times in nanoseconds from a FrameStats csv (the duration_ns column) or from one number per line
+	static std::vector<uint64_t> ParseTrace(const std::string& text);
+
+private:
+
+	float Quantize(float scale) const noexcept;
+
+private:
+
+	Settings m_settings;
+
+	//share of the full resolution's pixels
+	double m_area = 1.0;
+	float m_scale = 1.0f;
+
+	double m_filteredNs = 0.0;
+	double m_lastError = 0.0;
+	double m_lastLastError = 0.0;
+	unsigned int m_cooldown = 0u;
+	unsigned int m_nChanges = 0u;
+};
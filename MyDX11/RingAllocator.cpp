@@ -0,0 +1,129 @@
+#include "RingAllocator.h"
+#include <cassert>
+
+RingAllocator::RingAllocator(size_t capacity, size_t alignment)
+	:
+	m_capacity(capacity),
+	m_alignment(alignment)
+{
+	assert("Ring alignment must be a power of two" && alignment != 0u && (alignment & (alignment - 1u)) == 0u);
+	assert("Ring capacity must be a multiple of the alignment" && capacity % alignment == 0u);
+}
+
+std::optional<size_t> RingAllocator::Allocate(size_t size) noexcept
+{
+	const auto alignedSize = (size + m_alignment - 1u) & ~(m_alignment - 1u);
+
+	if (alignedSize == 0u || alignedSize > m_capacity - m_usedBytes) {
+
+		return std::nullopt;
+	}
+
+	//empty ring, start over from the beginning so big blocks fit
+	if (m_usedBytes == 0u) {
+
+		m_head = 0u;
+		m_tail = 0u;
+	}
+
+	size_t offset;
+	size_t consumed;
+
+	if (m_head >= m_tail) {
+
+		//free space is [head, capacity) and [0, tail)
+		if (m_head + alignedSize <= m_capacity) {
+
+			offset = m_head;
+			consumed = alignedSize;
+		}
+		else if (alignedSize <= m_tail) {
+
+			//skip the tail end of the ring, it's returned with this frame
+			offset = 0u;
+			consumed = (m_capacity - m_head) + alignedSize;
+		}
+		else {
+
+			return std::nullopt;
+		}
+	}
+	else {
+
+		//free space is [head, tail)
+		if (m_head + alignedSize > m_tail) {
+
+			return std::nullopt;
+		}
+
+		offset = m_head;
+		consumed = alignedSize;
+	}
+
+	m_head = offset + alignedSize;
+
+	if (m_head == m_capacity) {
+
+		m_head = 0u;
+	}
+
+	m_usedBytes += consumed;
+	m_unfencedBytes += consumed;
+
+	return offset;
+}
+
+void RingAllocator::Fence(unsigned long long fenceValue)
+{
+	assert("Fence values must increase" && (m_fences.empty() || m_fences.back().value < fenceValue));
+
+	//nothing to give back for an empty frame
+	if (m_unfencedBytes == 0u) {
+
+		return;
+	}
+
+	m_fences.push_back({ fenceValue,m_head,m_unfencedBytes });
+	m_unfencedBytes = 0u;
+}
+
+void RingAllocator::Retire(unsigned long long completedValue) noexcept
+{
+	while (!m_fences.empty() && m_fences.front().value <= completedValue) {
+
+		m_tail = m_fences.front().head;
+		m_usedBytes -= m_fences.front().bytes;
+		m_fences.pop_front();
+	}
+}
+
+void RingAllocator::Reset() noexcept
+{
+	m_head = 0u;
+	m_tail = 0u;
+	m_usedBytes = 0u;
+	m_unfencedBytes = 0u;
+	m_fences.clear();
+}
+
+size_t RingAllocator::GetCapacity() const noexcept
+{
+	return m_capacity;
+}
+
+size_t RingAllocator::GetUsedBytes() const noexcept
+{
+	return m_usedBytes;
+}
+
+bool RingAllocator::HasPendingFences() const noexcept
+{
+	return !m_fences.empty();
+}
+
+unsigned long long RingAllocator::GetOldestFence() const noexcept
+{
+	assert("No pending fence" && !m_fences.empty());
+
+	return m_fences.front().value;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <optional>
+
+/// <summary>
+/// Linear sub allocator for a GPU ring buffer, hands out byte offsets only
+/// allocations are closed under a fence value and the space comes back once that
+/// fence is retired (the GPU is done with it), no graphics device needed
+/// </summary>
+class RingAllocator {
+
+public:
+
+	//alignment must be a power of two
+	RingAllocator(size_t capacity, size_t alignment);
+
+	//offset of a contiguous block, nullopt when the unretired frames don't leave room
+	//*a block never straddles the end of the ring, the skipped tail is freed with the frame
+	std::optional<size_t> Allocate(size_t size) noexcept;
+
+	//closes every allocation since the previous fence under fenceValue (must increase)
+	void Fence(unsigned long long fenceValue);
+
+	//frees every block fenced with a value <= completedValue
+	void Retire(unsigned long long completedValue) noexcept;
+
+	//drops everything, only valid once the GPU is idle
+	void Reset() noexcept;
+
+	size_t GetCapacity() const noexcept;
+	size_t GetUsedBytes() const noexcept;
+	bool HasPendingFences() const noexcept;
+	unsigned long long GetOldestFence() const noexcept;
+
+private:
+
+	//head position and bytes owned by one fenced frame
+	struct FenceMark {
+
+		unsigned long long value;
+		size_t head;
+		size_t bytes;
+	};
+
+private:
+
+	size_t m_capacity;
+	size_t m_alignment;
+
+	//[m_tail, m_head) is in use, wrapping around the end
+	size_t m_head = 0u;
+	size_t m_tail = 0u;
+	size_t m_usedBytes = 0u;
+
+	//bytes allocated since the last fence (including skipped tails)
+	size_t m_unfencedBytes = 0u;
+	std::deque<FenceMark> m_fences;
+};
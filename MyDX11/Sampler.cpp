@@ -3,15 +3,17 @@
 
 namespace Bind {
 
-	Sampler::Sampler(Graphics& gfx)
+	Sampler::Sampler(Graphics& gfx, D3D11_TEXTURE_ADDRESS_MODE address)
 	{
 		INFOMAN(gfx);
 
 		D3D11_SAMPLER_DESC samplerDesc = {};
 		samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
-		samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;
-		samplerDesc.AddressV = D3D11_TEXTURE_ADDRESS_WRAP;
-		samplerDesc.AddressW = D3D11_TEXTURE_ADDRESS_WRAP;
+		samplerDesc.AddressU = address;
+		samplerDesc.AddressV = address;
+		samplerDesc.AddressW = address;
+		samplerDesc.MinLOD = 0.0f;
+		samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;	//zero would lock sampling to the top mip
 
 
 		GFX_THROW_INFO(GetDevice(gfx)->CreateSamplerState(&samplerDesc, &pSampler));
@@ -21,7 +23,7 @@ namespace Bind {
 	void Sampler::Bind(Graphics& gfx) noexcept
 	{
 
-		GetContext(gfx)->PSSetSamplers(0, 1, pSampler.GetAddressOf());
+		BindPixelSampler(gfx, pSampler.Get());
 	}
 
 }
\ No newline at end of file
@@ -8,7 +8,8 @@ namespace Bind {
 
 	public:
 
-		Sampler(Graphics& gfx);
+		//wrap for tiling textures, clamp for ones covering the screen once
+		Sampler(Graphics& gfx, D3D11_TEXTURE_ADDRESS_MODE address = D3D11_TEXTURE_ADDRESS_WRAP);
 		void Bind(Graphics& gfx) noexcept override;
 
 	protected:
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "Bindable.h"
+#include "GraphicsThrowMacros.h"
+
+namespace Bind {
+
+	//dynamic typed buffer the pixel shader reads as Buffer<> through a view
+	//*shaders here are model 4.0 so there are no structured buffers, T has to match the format's size
+	template<typename T>
+	class ShaderBuffer :public Bindable {
+
+	public:
+
+		ShaderBuffer(Graphics& gfx, DXGI_FORMAT format, UINT capacity, UINT slot = 0u)
+			:
+			format(format),
+			slot(slot)
+		{
+			Resize(gfx, capacity);
+		}
+
+		//write this frame's elements, grows the buffer when needed
+		void Update(Graphics& gfx, const std::vector<T>& elements) {
+
+			INFOMAN(gfx);
+
+			if (elements.empty()) {
+
+				return;
+			}
+
+			if (elements.size() > capacity) {
+
+				//grow geometrically so a slowly rising count doesn't recreate every frame
+				Resize(gfx, std::max((UINT)elements.size(), capacity * 2u));
+			}
+
+			D3D11_MAPPED_SUBRESOURCE msr;
+			GFX_THROW_INFO(GetContext(gfx)->Map(
+				pBuffer.Get(), 0u,
+				D3D11_MAP_WRITE_DISCARD, 0u,
+				&msr
+			));
+
+			memcpy(msr.pData, elements.data(), sizeof(T) * elements.size());
+			GetContext(gfx)->Unmap(pBuffer.Get(), 0u);
+		}
+
+		void Bind(Graphics& gfx) noexcept override {
+
+			BindPixelView(gfx, slot, pBufferView.Get());
+		}
+
+		UINT GetCapacity() const noexcept {
+
+			return capacity;
+		}
+
+	private:
+
+		void Resize(Graphics& gfx, UINT newCapacity) {
+
+			INFOMAN(gfx);
+
+			capacity = std::max(newCapacity, 1u);
+
+			D3D11_BUFFER_DESC bd = {};
+			bd.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+			bd.Usage = D3D11_USAGE_DYNAMIC;
+			bd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+			bd.MiscFlags = 0u;
+			bd.ByteWidth = UINT(sizeof(T) * capacity);
+			bd.StructureByteStride = 0u;
+
+			pBufferView.Reset();
+			pBuffer.Reset();
+			GFX_THROW_INFO(GetDevice(gfx)->CreateBuffer(&bd, nullptr, &pBuffer));
+
+			D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+			srvDesc.Format = format;
+			srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+			srvDesc.Buffer.FirstElement = 0u;
+			srvDesc.Buffer.NumElements = capacity;
+			GFX_THROW_INFO(GetDevice(gfx)->CreateShaderResourceView(pBuffer.Get(), &srvDesc, &pBufferView));
+		}
+
+	protected:
+
+		DXGI_FORMAT format;
+		UINT slot;
+		UINT capacity = 0u;
+		Microsoft::WRL::ComPtr<ID3D11Buffer> pBuffer;
+		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> pBufferView;
+	};
+
+}
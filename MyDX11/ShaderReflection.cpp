@@ -0,0 +1,772 @@
+#include "ShaderReflection.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <cctype>
+#include <cstring>
+
+namespace {
+
+	constexpr uint32_t MakeFourCC(char a, char b, char c, char d) noexcept
+	{
+		return (uint32_t)(uint8_t)a | ((uint32_t)(uint8_t)b << 8u) | ((uint32_t)(uint8_t)c << 16u) | ((uint32_t)(uint8_t)d << 24u);
+	}
+
+	constexpr uint32_t dxbcMagic = MakeFourCC('D', 'X', 'B', 'C');
+
+	//signatures, the 1 and 5 variants carry a stream index and (1 only) a min precision as well
+	constexpr uint32_t chunkIsgn = MakeFourCC('I', 'S', 'G', 'N');
+	constexpr uint32_t chunkIsg1 = MakeFourCC('I', 'S', 'G', '1');
+	constexpr uint32_t chunkOsgn = MakeFourCC('O', 'S', 'G', 'N');
+	constexpr uint32_t chunkOsg1 = MakeFourCC('O', 'S', 'G', '1');
+	constexpr uint32_t chunkOsg5 = MakeFourCC('O', 'S', 'G', '5');
+	constexpr uint32_t chunkRdef = MakeFourCC('R', 'D', 'E', 'F');
+	constexpr uint32_t chunkShdr = MakeFourCC('S', 'H', 'D', 'R');
+	constexpr uint32_t chunkShex = MakeFourCC('S', 'H', 'E', 'X');
+
+	//magic, checksum, version, total size, chunk count
+	constexpr size_t dxbcHeaderSize = 32u;
+
+	//D3D_CBUFFER_TYPE, tbuffers and interface tables are left out
+	constexpr uint32_t cbufferTypeCbuffer = 0u;
+
+	//D3D_SHADER_VARIABLE_FLAGS
+	constexpr uint32_t variableUsed = 0x2u;
+
+	//D3D_SHADER_VARIABLE_CLASS
+	constexpr uint32_t classMatrixRows = 2u;
+	constexpr uint32_t classMatrixColumns = 3u;
+
+	//D3D_SHADER_VARIABLE_TYPE, anything else reads as float
+	constexpr uint32_t typeBool = 1u;
+	constexpr uint32_t typeInt = 2u;
+	constexpr uint32_t typeUint = 19u;
+
+	//bounds checked reads inside one chunk, offsets in a chunk are from its first byte
+	class ChunkReader {
+
+	public:
+
+		ChunkReader(const uint8_t* pData, size_t size, const char* pName) noexcept
+			:
+			m_pData(pData),
+			m_size(size),
+			m_pName(pName)
+		{}
+
+		uint32_t U32(size_t offset) const
+		{
+			Check(offset, 4u);
+
+			uint32_t value;
+			std::memcpy(&value, m_pData + offset, 4u);
+			return value;
+		}
+
+		uint16_t U16(size_t offset) const
+		{
+			Check(offset, 2u);
+
+			uint16_t value;
+			std::memcpy(&value, m_pData + offset, 2u);
+			return value;
+		}
+
+		uint8_t U8(size_t offset) const
+		{
+			Check(offset, 1u);
+
+			return m_pData[offset];
+		}
+
+		std::string String(size_t offset) const
+		{
+			Check(offset, 1u);
+
+			const auto pBegin = reinterpret_cast<const char*>(m_pData + offset);
+			const auto pEnd = static_cast<const char*>(std::memchr(pBegin, 0, m_size - offset));
+
+			if (pEnd == nullptr) {
+
+				throw ShaderReflection::Exception(__LINE__, __FILE__, std::string("Unterminated string in the ") + m_pName + " chunk");
+			}
+
+			return std::string(pBegin, pEnd);
+		}
+
+		//for tables, count * stride bytes from offset
+		void CheckTable(size_t offset, size_t count, size_t stride) const
+		{
+			if (count > m_size / stride) {
+
+				throw ShaderReflection::Exception(__LINE__, __FILE__, std::string("The ") + m_pName + " chunk is truncated");
+			}
+
+			Check(offset, count * stride);
+		}
+
+	private:
+
+		void Check(size_t offset, size_t size) const
+		{
+			if (offset > m_size || size > m_size - offset) {
+
+				throw ShaderReflection::Exception(__LINE__, __FILE__, std::string("The ") + m_pName + " chunk is truncated");
+			}
+		}
+
+	private:
+
+		const uint8_t* m_pData;
+		size_t m_size;
+		const char* m_pName;
+	};
+
+	struct FormatInfo {
+
+		VertexFormat format;
+		const char* name;
+		unsigned int size;
+		//what the input assembler hands the shader, unorm and snorm arrive as float
+		ShaderReflection::ComponentType componentType;
+	};
+
+	constexpr FormatInfo formatInfos[] = {
+
+		{ VertexFormat::R32G32B32A32Float,"R32G32B32A32_FLOAT",16u,ShaderReflection::ComponentType::Float },
+		{ VertexFormat::R32G32B32A32Uint,"R32G32B32A32_UINT",16u,ShaderReflection::ComponentType::Uint },
+		{ VertexFormat::R32G32B32A32Sint,"R32G32B32A32_SINT",16u,ShaderReflection::ComponentType::Sint },
+		{ VertexFormat::R32G32B32Float,"R32G32B32_FLOAT",12u,ShaderReflection::ComponentType::Float },
+		{ VertexFormat::R32G32B32Uint,"R32G32B32_UINT",12u,ShaderReflection::ComponentType::Uint },
+		{ VertexFormat::R32G32B32Sint,"R32G32B32_SINT",12u,ShaderReflection::ComponentType::Sint },
+		{ VertexFormat::R16G16B16A16Float,"R16G16B16A16_FLOAT",8u,ShaderReflection::ComponentType::Float },
+		{ VertexFormat::R16G16B16A16Unorm,"R16G16B16A16_UNORM",8u,ShaderReflection::ComponentType::Float },
+		{ VertexFormat::R16G16B16A16Uint,"R16G16B16A16_UINT",8u,ShaderReflection::ComponentType::Uint },
+		{ VertexFormat::R16G16B16A16Snorm,"R16G16B16A16_SNORM",8u,ShaderReflection::ComponentType::Float },
+		{ VertexFormat::R16G16B16A16Sint,"R16G16B16A16_SINT",8u,ShaderReflection::ComponentType::Sint },
+		{ VertexFormat::R32G32Float,"R32G32_FLOAT",8u,ShaderReflection::ComponentType::Float },
+		{ VertexFormat::R32G32Uint,"R32G32_UINT",8u,ShaderReflection::ComponentType::Uint },
+		{ VertexFormat::R32G32Sint,"R32G32_SINT",8u,ShaderReflection::ComponentType::Sint },
+		{ VertexFormat::R10G10B10A2Unorm,"R10G10B10A2_UNORM",4u,ShaderReflection::ComponentType::Float },
+		{ VertexFormat::R11G11B10Float,"R11G11B10_FLOAT",4u,ShaderReflection::ComponentType::Float },
+		{ VertexFormat::R8G8B8A8Unorm,"R8G8B8A8_UNORM",4u,ShaderReflection::ComponentType::Float },
+		{ VertexFormat::R8G8B8A8Uint,"R8G8B8A8_UINT",4u,ShaderReflection::ComponentType::Uint },
+		{ VertexFormat::R8G8B8A8Snorm,"R8G8B8A8_SNORM",4u,ShaderReflection::ComponentType::Float },
+		{ VertexFormat::R8G8B8A8Sint,"R8G8B8A8_SINT",4u,ShaderReflection::ComponentType::Sint },
+		{ VertexFormat::R16G16Float,"R16G16_FLOAT",4u,ShaderReflection::ComponentType::Float },
+		{ VertexFormat::R16G16Unorm,"R16G16_UNORM",4u,ShaderReflection::ComponentType::Float },
+		{ VertexFormat::R16G16Uint,"R16G16_UINT",4u,ShaderReflection::ComponentType::Uint },
+		{ VertexFormat::R16G16Snorm,"R16G16_SNORM",4u,ShaderReflection::ComponentType::Float },
+		{ VertexFormat::R16G16Sint,"R16G16_SINT",4u,ShaderReflection::ComponentType::Sint },
+		{ VertexFormat::R32Float,"R32_FLOAT",4u,ShaderReflection::ComponentType::Float },
+		{ VertexFormat::R32Uint,"R32_UINT",4u,ShaderReflection::ComponentType::Uint },
+		{ VertexFormat::R32Sint,"R32_SINT",4u,ShaderReflection::ComponentType::Sint },
+		{ VertexFormat::B8G8R8A8Unorm,"B8G8R8A8_UNORM",4u,ShaderReflection::ComponentType::Float },
+	};
+
+	const FormatInfo* FindFormat(VertexFormat format) noexcept
+	{
+		for (const auto& info : formatInfos) {
+
+			if (info.format == format) {
+
+				return &info;
+			}
+		}
+
+		return nullptr;
+	}
+
+	//32 bit formats of 1 to 4 components, the layout MakeInputLayout hands out
+	VertexFormat MakeFormat(ShaderReflection::ComponentType componentType, unsigned int componentCount) noexcept
+	{
+		static constexpr VertexFormat floats[] = { VertexFormat::R32Float,VertexFormat::R32G32Float,VertexFormat::R32G32B32Float,VertexFormat::R32G32B32A32Float };
+		static constexpr VertexFormat uints[] = { VertexFormat::R32Uint,VertexFormat::R32G32Uint,VertexFormat::R32G32B32Uint,VertexFormat::R32G32B32A32Uint };
+		static constexpr VertexFormat sints[] = { VertexFormat::R32Sint,VertexFormat::R32G32Sint,VertexFormat::R32G32B32Sint,VertexFormat::R32G32B32A32Sint };
+
+		const unsigned int i = std::clamp(componentCount, 1u, 4u) - 1u;
+
+		switch (componentType)
+		{
+		case ShaderReflection::ComponentType::Uint:
+
+			return uints[i];
+
+		case ShaderReflection::ComponentType::Sint:
+
+			return sints[i];
+
+		default:
+
+			return floats[i];
+		}
+	}
+
+	const char* GetComponentTypeName(ShaderReflection::ComponentType componentType) noexcept
+	{
+		switch (componentType)
+		{
+		case ShaderReflection::ComponentType::Uint:
+
+			return "uint";
+
+		case ShaderReflection::ComponentType::Sint:
+
+			return "int";
+
+		case ShaderReflection::ComponentType::Float:
+
+			return "float";
+
+		default:
+
+			return "unknown";
+		}
+	}
+
+	//semantics match without regard to case, as D3D does
+	bool IsSameSemantic(const std::string& a, const std::string& b) noexcept
+	{
+		return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](unsigned char x, unsigned char y) {
+
+			return std::toupper(x) == std::toupper(y);
+		});
+	}
+
+	std::string GetSemanticLabel(const std::string& name, unsigned int index)
+	{
+		return name + std::to_string(index);
+	}
+
+	//FNV-1a
+	void HashBytes(uint64_t& hash, const void* pData, size_t size) noexcept
+	{
+		const auto pBytes = static_cast<const uint8_t*>(pData);
+
+		for (size_t i = 0; i < size; i++) {
+
+			hash ^= pBytes[i];
+			hash *= 1099511628211ull;
+		}
+	}
+}
+
+
+ShaderReflection::ShaderReflection(const void* pData, size_t size)
+{
+	Parse(pData, size);
+}
+
+ShaderReflection::ShaderReflection(const std::string& path)
+{
+	std::ifstream file(path, std::ios::binary);
+
+	if (!file) {
+
+		throw Exception(__LINE__, __FILE__, "Failed to open [" + path + "]");
+	}
+
+	const std::vector<char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	Parse(bytes.data(), bytes.size());
+}
+
+void ShaderReflection::Parse(const void* pData, size_t size)
+{
+	const ChunkReader container(static_cast<const uint8_t*>(pData), size, "DXBC");
+
+	if (size < dxbcHeaderSize || container.U32(0u) != dxbcMagic) {
+
+		throw Exception(__LINE__, __FILE__, "Not a compiled shader (no DXBC header)");
+	}
+
+	const uint32_t chunkCount = container.U32(28u);
+	container.CheckTable(dxbcHeaderSize, chunkCount, 4u);
+
+	bool hasBytecode = false;
+
+	for (uint32_t i = 0; i < chunkCount; i++) {
+
+		const uint32_t chunkOffset = container.U32(dxbcHeaderSize + i * 4u);
+		const uint32_t fourCC = container.U32(chunkOffset);
+		const uint32_t chunkSize = container.U32(chunkOffset + 4u);
+
+		container.CheckTable(chunkOffset + 8u, chunkSize, 1u);
+
+		const uint8_t* pChunk = static_cast<const uint8_t*>(pData) + chunkOffset + 8u;
+
+		switch (fourCC)
+		{
+		case chunkIsgn:
+		case chunkIsg1:
+
+			ParseSignature(pChunk, chunkSize, fourCC, m_inputs);
+			break;
+
+		case chunkOsgn:
+		case chunkOsg1:
+		case chunkOsg5:
+
+			ParseSignature(pChunk, chunkSize, fourCC, m_outputs);
+			break;
+
+		case chunkRdef:
+
+			ParseResourceDefinitions(pChunk, chunkSize);
+			break;
+
+		case chunkShdr:
+		case chunkShex:
+		{
+			const uint32_t versionToken = ChunkReader(pChunk, chunkSize, "SHDR").U32(0u);
+
+			m_stage = (Stage)(versionToken >> 16u);
+			m_majorVersion = (versionToken >> 4u) & 0xFu;
+			m_minorVersion = versionToken & 0xFu;
+			hasBytecode = true;
+			break;
+		}
+		}
+	}
+
+	if (!hasBytecode) {
+
+		throw Exception(__LINE__, __FILE__, "The shader has no SHDR/SHEX chunk");
+	}
+}
+
+ShaderReflection::Stage ShaderReflection::GetStage() const noexcept
+{
+	return m_stage;
+}
+
+unsigned int ShaderReflection::GetMajorVersion() const noexcept
+{
+	return m_majorVersion;
+}
+
+unsigned int ShaderReflection::GetMinorVersion() const noexcept
+{
+	return m_minorVersion;
+}
+
+const std::vector<ShaderReflection::Parameter>& ShaderReflection::GetInputSignature() const noexcept
+{
+	return m_inputs;
+}
+
+const std::vector<ShaderReflection::Parameter>& ShaderReflection::GetOutputSignature() const noexcept
+{
+	return m_outputs;
+}
+
+const std::vector<ShaderReflection::Cbuffer>& ShaderReflection::GetCbuffers() const noexcept
+{
+	return m_cbuffers;
+}
+
+const std::vector<ShaderReflection::Binding>& ShaderReflection::GetBindings() const noexcept
+{
+	return m_bindings;
+}
+
+const ShaderReflection::Cbuffer* ShaderReflection::FindCbuffer(const std::string& name) const noexcept
+{
+	for (const auto& cbuffer : m_cbuffers) {
+
+		if (cbuffer.name == name) {
+
+			return &cbuffer;
+		}
+	}
+
+	return nullptr;
+}
+
+const ShaderReflection::Cbuffer* ShaderReflection::FindCbuffer(unsigned int slot) const noexcept
+{
+	for (const auto& cbuffer : m_cbuffers) {
+
+		if (cbuffer.slot == slot) {
+
+			return &cbuffer;
+		}
+	}
+
+	return nullptr;
+}
+
+uint64_t ShaderReflection::GetInputSignatureHash() const noexcept
+{
+	uint64_t hash = 14695981039346656037ull;
+
+	for (const auto& input : m_inputs) {
+
+		for (const unsigned char c : input.semanticName) {
+
+			const auto upper = (unsigned char)std::toupper(c);
+			HashBytes(hash, &upper, 1u);
+		}
+
+		const uint32_t fields[] = { 0u,input.semanticIndex,input.registerIndex,input.systemValue,(uint32_t)input.componentType,input.mask };
+		HashBytes(hash, fields, sizeof(fields));
+	}
+
+	return hash;
+}
+
+std::vector<ShaderReflection::InputElement> ShaderReflection::MakeInputLayout() const
+{
+	std::vector<InputElement> layout;
+	unsigned int offset = 0u;
+
+	for (const auto& input : m_inputs) {
+
+		//SV_VertexID and friends come from the input assembler, not a buffer
+		if (input.IsSystemValue()) {
+
+			continue;
+		}
+
+		InputElement element;
+		element.semanticName = input.semanticName;
+		element.semanticIndex = input.semanticIndex;
+		element.format = MakeFormat(input.componentType, input.GetComponentCount());
+		element.alignedByteOffset = offset;
+
+		offset += GetFormatSize(element.format);
+		layout.push_back(std::move(element));
+	}
+
+	return layout;
+}
+
+std::vector<ShaderReflection::Problem> ShaderReflection::CheckInputLayout(const std::vector<InputElement>& layout) const
+{
+	std::vector<Problem> problems;
+
+	for (size_t i = 0; i < layout.size(); i++) {
+
+		const auto& element = layout[i];
+		const auto label = GetSemanticLabel(element.semanticName, element.semanticIndex);
+
+		if (FindFormat(element.format) == nullptr) {
+
+			problems.push_back({ true,"Element " + label + " has a format (" + std::to_string((uint32_t)element.format) + ") the input assembler can't read" });
+		}
+
+		for (size_t j = 0; j < i; j++) {
+
+			if (layout[j].semanticIndex == element.semanticIndex && IsSameSemantic(layout[j].semanticName, element.semanticName)) {
+
+				problems.push_back({ true,"Element " + label + " appears more than once in the layout" });
+				break;
+			}
+		}
+	}
+
+	for (const auto& input : m_inputs) {
+
+		if (input.IsSystemValue()) {
+
+			continue;
+		}
+
+		const auto label = GetSemanticLabel(input.semanticName, input.semanticIndex);
+
+		const auto it = std::find_if(layout.begin(), layout.end(), [&input](const InputElement& element) {
+
+			return element.semanticIndex == input.semanticIndex && IsSameSemantic(element.semanticName, input.semanticName);
+		});
+
+		if (it == layout.end()) {
+
+			problems.push_back({ true,"The shader reads " + label + " but the layout has no such element" });
+			continue;
+		}
+
+		const auto pFormat = FindFormat(it->format);
+
+		if (pFormat != nullptr && pFormat->componentType != input.componentType) {
+
+			problems.push_back({ false,"Element " + label + " is " + pFormat->name + " but the shader reads it as " + GetComponentTypeName(input.componentType) });
+		}
+	}
+
+	return problems;
+}
+
+std::vector<ShaderReflection::Problem> ShaderReflection::CheckCbuffer(const Cbuffer& cbuffer, const std::vector<CbufferField>& fields)
+{
+	std::vector<Problem> problems;
+
+	for (const auto& field : fields) {
+
+		const auto pVariable = cbuffer.FindVariable(field.name);
+
+		if (pVariable == nullptr) {
+
+			problems.push_back({ true,"Cbuffer " + cbuffer.name + " has no variable " + field.name });
+			continue;
+		}
+
+		if (pVariable->offset != field.offset) {
+
+			problems.push_back({ true,cbuffer.name + "." + field.name + " is at byte " + std::to_string(pVariable->offset) + " in the hlsl but at " + std::to_string(field.offset) + " in the layout" });
+		}
+
+		if (pVariable->size != field.size) {
+
+			problems.push_back({ true,cbuffer.name + "." + field.name + " is " + pVariable->typeName + " (" + std::to_string(pVariable->size) + " bytes) in the hlsl but " + std::to_string(field.size) + " bytes in the layout" });
+		}
+	}
+
+	for (const auto& variable : cbuffer.variables) {
+
+		const auto it = std::find_if(fields.begin(), fields.end(), [&variable](const CbufferField& field) {
+
+			return field.name == variable.name;
+		});
+
+		if (it == fields.end()) {
+
+			problems.push_back({ false,cbuffer.name + "." + variable.name + " is never written by the layout" + (variable.isUsed ? "" : " (the shader doesn't read it either)") });
+		}
+	}
+
+	return problems;
+}
+
+unsigned int ShaderReflection::GetFormatSize(VertexFormat format) noexcept
+{
+	const auto pInfo = FindFormat(format);
+
+	return pInfo != nullptr ? pInfo->size : 0u;
+}
+
+const char* ShaderReflection::GetFormatName(VertexFormat format) noexcept
+{
+	const auto pInfo = FindFormat(format);
+
+	return pInfo != nullptr ? pInfo->name : "UNKNOWN";
+}
+
+std::string ShaderReflection::Describe(const std::vector<Problem>& problems)
+{
+	std::ostringstream oss;
+
+	for (const auto& problem : problems) {
+
+		oss << (problem.isError ? "[Error] " : "[Warning] ") << problem.message << std::endl;
+	}
+
+	return oss.str();
+}
+
+bool ShaderReflection::HasError(const std::vector<Problem>& problems) noexcept
+{
+	return std::any_of(problems.begin(), problems.end(), [](const Problem& problem) {
+
+		return problem.isError;
+	});
+}
+
+void ShaderReflection::ParseSignature(const uint8_t* pChunk, size_t size, uint32_t fourCC, std::vector<Parameter>& parameters)
+{
+	const ChunkReader chunk(pChunk, size, "signature");
+
+	//ISG1/OSG1 add a stream in front and a min precision at the back, OSG5 only the stream
+	const bool hasStream = fourCC == chunkIsg1 || fourCC == chunkOsg1 || fourCC == chunkOsg5;
+	const size_t stride = fourCC == chunkIsg1 || fourCC == chunkOsg1 ? 32u : hasStream ? 28u : 24u;
+	const size_t first = hasStream ? 4u : 0u;
+
+	const uint32_t count = chunk.U32(0u);
+	const uint32_t tableOffset = chunk.U32(4u);
+
+	chunk.CheckTable(tableOffset, count, stride);
+
+	parameters.clear();
+	parameters.reserve(count);
+
+	for (uint32_t i = 0; i < count; i++) {
+
+		const size_t entry = tableOffset + i * stride + first;
+
+		Parameter parameter;
+		parameter.semanticName = chunk.String(chunk.U32(entry));
+		parameter.semanticIndex = chunk.U32(entry + 4u);
+		parameter.systemValue = chunk.U32(entry + 8u);
+		parameter.componentType = (ComponentType)chunk.U32(entry + 12u);
+		parameter.registerIndex = chunk.U32(entry + 16u);
+		parameter.mask = chunk.U8(entry + 20u);
+		parameter.usedMask = chunk.U8(entry + 21u);
+
+		parameters.push_back(std::move(parameter));
+	}
+}
+
+void ShaderReflection::ParseResourceDefinitions(const uint8_t* pChunk, size_t size)
+{
+	const ChunkReader chunk(pChunk, size, "RDEF");
+
+	const uint32_t cbufferCount = chunk.U32(0u);
+	const uint32_t cbufferOffset = chunk.U32(4u);
+	const uint32_t bindingCount = chunk.U32(8u);
+	const uint32_t bindingOffset = chunk.U32(12u);
+	const unsigned int majorVersion = chunk.U8(17u);
+
+	//shader model 5 grew the variable and type records, the offsets stay from the start of the chunk
+	const bool isSm5 = majorVersion >= 5u;
+	const size_t bindingStride = 32u;
+	const size_t cbufferStride = 24u;
+	const size_t variableStride = isSm5 ? 40u : 24u;
+
+	chunk.CheckTable(bindingOffset, bindingCount, bindingStride);
+
+	m_bindings.clear();
+	m_bindings.reserve(bindingCount);
+
+	for (uint32_t i = 0; i < bindingCount; i++) {
+
+		const size_t entry = bindingOffset + i * bindingStride;
+
+		Binding binding;
+		binding.name = chunk.String(chunk.U32(entry));
+		binding.type = (BindingType)chunk.U32(entry + 4u);
+		binding.slot = chunk.U32(entry + 20u);
+		binding.count = chunk.U32(entry + 24u);
+
+		m_bindings.push_back(std::move(binding));
+	}
+
+	chunk.CheckTable(cbufferOffset, cbufferCount, cbufferStride);
+
+	m_cbuffers.clear();
+
+	for (uint32_t i = 0; i < cbufferCount; i++) {
+
+		const size_t entry = cbufferOffset + i * cbufferStride;
+
+		if (chunk.U32(entry + 20u) != cbufferTypeCbuffer) {
+
+			continue;
+		}
+
+		Cbuffer cbuffer;
+		cbuffer.name = chunk.String(chunk.U32(entry));
+		cbuffer.size = chunk.U32(entry + 12u);
+
+		//the register comes from the binding of the same name
+		for (const auto& binding : m_bindings) {
+
+			if (binding.type == BindingType::Cbuffer && binding.name == cbuffer.name) {
+
+				cbuffer.slot = binding.slot;
+				break;
+			}
+		}
+
+		const uint32_t variableCount = chunk.U32(entry + 4u);
+		const uint32_t variableOffset = chunk.U32(entry + 8u);
+
+		chunk.CheckTable(variableOffset, variableCount, variableStride);
+
+		cbuffer.variables.reserve(variableCount);
+
+		for (uint32_t v = 0; v < variableCount; v++) {
+
+			const size_t variableEntry = variableOffset + v * variableStride;
+
+			Variable variable;
+			variable.name = chunk.String(chunk.U32(variableEntry));
+			variable.offset = chunk.U32(variableEntry + 4u);
+			variable.size = chunk.U32(variableEntry + 8u);
+			variable.isUsed = (chunk.U32(variableEntry + 12u) & variableUsed) != 0u;
+
+			//class, type, rows, columns, elements, members, then (sm5) four more dwords and the name
+			const uint32_t typeOffset = chunk.U32(variableEntry + 16u);
+			const uint32_t typeClass = chunk.U16(typeOffset);
+
+			variable.rows = chunk.U16(typeOffset + 4u);
+			variable.columns = chunk.U16(typeOffset + 6u);
+			variable.elements = chunk.U16(typeOffset + 8u);
+
+			if (isSm5) {
+
+				variable.typeName = chunk.String(chunk.U32(typeOffset + 32u));
+			}
+			else {
+
+				//shader model 4 records carry no name, so it is spelled from the class and base type
+				const uint32_t baseType = chunk.U16(typeOffset + 2u);
+				const std::string baseName = baseType == typeBool ? "bool" : baseType == typeInt ? "int" : baseType == typeUint ? "uint" : "float";
+
+				variable.typeName = typeClass == classMatrixRows || typeClass == classMatrixColumns
+					? baseName + std::to_string(variable.rows) + "x" + std::to_string(variable.columns)
+					: variable.columns > 1u ? baseName + std::to_string(variable.columns) : baseName;
+			}
+
+			cbuffer.variables.push_back(std::move(variable));
+		}
+
+		m_cbuffers.push_back(std::move(cbuffer));
+	}
+}
+
+unsigned int ShaderReflection::Parameter::GetComponentCount() const noexcept
+{
+	//the mask is contiguous from x, so the count is the highest set bit
+	unsigned int count = 0u;
+
+	for (unsigned int bit = 0; bit < 4u; bit++) {
+
+		if (mask & (1u << bit)) {
+
+			count = bit + 1u;
+		}
+	}
+
+	return count;
+}
+
+const ShaderReflection::Variable* ShaderReflection::Cbuffer::FindVariable(const std::string& variableName) const noexcept
+{
+	for (const auto& variable : variables) {
+
+		if (variable.name == variableName) {
+
+			return &variable;
+		}
+	}
+
+	return nullptr;
+}
+
+
+//shader reflection exception stuff
+ShaderReflection::Exception::Exception(int line, const char* file, std::string note) noexcept
+	:
+	myException(line, file),
+	note(std::move(note))
+{}
+
+const char* ShaderReflection::Exception::what() const noexcept
+{
+	std::ostringstream oss;
+
+	oss << myException::what() << std::endl
+		<< "[Note] " << GetNote();
+
+	whatBuffer = oss.str();
+	return whatBuffer.c_str();
+}
+
+const char* ShaderReflection::Exception::GetType() const noexcept
+{
+	return "SupaHotFire Shader Reflection Exception";
+}
+
+const std::string& ShaderReflection::Exception::GetNote() const noexcept
+{
+	return note;
+}
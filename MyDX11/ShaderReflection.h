@@ -0,0 +1,238 @@
+#pragma once
+
+#include "myException.h"
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+//the formats a vertex element can use, same numbers as DXGI_FORMAT so a value can be cast straight across
+//*spelled out here so this header builds without windows
+enum class VertexFormat : uint32_t {
+
+	Unknown = 0,
+	R32G32B32A32Float = 2,
+	R32G32B32A32Uint = 3,
+	R32G32B32A32Sint = 4,
+	R32G32B32Float = 6,
+	R32G32B32Uint = 7,
+	R32G32B32Sint = 8,
+	R16G16B16A16Float = 10,
+	R16G16B16A16Unorm = 11,
+	R16G16B16A16Uint = 12,
+	R16G16B16A16Snorm = 13,
+	R16G16B16A16Sint = 14,
+	R32G32Float = 16,
+	R32G32Uint = 17,
+	R32G32Sint = 18,
+	R10G10B10A2Unorm = 24,
+	R11G11B10Float = 26,
+	R8G8B8A8Unorm = 28,
+	R8G8B8A8Uint = 30,
+	R8G8B8A8Snorm = 31,
+	R8G8B8A8Sint = 32,
+	R16G16Float = 34,
+	R16G16Unorm = 35,
+	R16G16Uint = 36,
+	R16G16Snorm = 37,
+	R16G16Sint = 38,
+	R32Float = 41,
+	R32Uint = 42,
+	R32Sint = 43,
+	B8G8R8A8Unorm = 87,
+};
+
+/// <summary>
+/// Reads a compiled shader (.cso, the DXBC container fxc writes) without going through d3dcompiler
+/// pulls out the input and output signatures, the shader stage and the RDEF cbuffer layouts and resource bindings
+/// so vertex layouts can be checked against (or generated from) a vertex shader and cbuffer layouts against the hlsl
+/// works on raw bytes only so it builds and runs without windows
+/// </summary>
+class ShaderReflection {
+
+public:
+
+	class Exception :public myException {
+
+	public:
+
+		Exception(int line, const char* file, std::string note) noexcept;
+		const char* what() const noexcept override;
+		const char* GetType() const noexcept override;
+
+		const std::string& GetNote() const noexcept;
+
+	private:
+
+		std::string note;
+	};
+
+	//program type from the bytecode version token
+	enum class Stage {
+
+		Pixel = 0,
+		Vertex = 1,
+		Geometry = 2,
+		Hull = 3,
+		Domain = 4,
+		Compute = 5,
+	};
+
+	//D3D_REGISTER_COMPONENT_TYPE
+	enum class ComponentType : uint32_t {
+
+		Unknown = 0,
+		Uint = 1,
+		Sint = 2,
+		Float = 3,
+	};
+
+	//one entry of ISGN/OSGN
+	struct Parameter {
+
+		std::string semanticName;
+		unsigned int semanticIndex = 0u;
+		unsigned int registerIndex = 0u;
+		//D3D_NAME, 0 for user semantics (SV_Position is 1, SV_VertexID 6, SV_InstanceID 8, SV_Target 64)
+		unsigned int systemValue = 0u;
+		ComponentType componentType = ComponentType::Unknown;
+		//components the register holds and, for inputs, the ones the shader actually reads
+		uint8_t mask = 0u;
+		uint8_t usedMask = 0u;
+
+		bool IsSystemValue() const noexcept {
+
+			return systemValue != 0u;
+		}
+
+		unsigned int GetComponentCount() const noexcept;
+	};
+
+	//D3D11_INPUT_ELEMENT_DESC with the name held by value
+	struct InputElement {
+
+		std::string semanticName;
+		unsigned int semanticIndex = 0u;
+		VertexFormat format = VertexFormat::Unknown;
+		unsigned int inputSlot = 0u;
+		unsigned int alignedByteOffset = 0u;
+		bool isPerInstance = false;
+		unsigned int instanceStepRate = 0u;
+	};
+
+	struct Variable {
+
+		std::string name;
+		//hlsl type name (float3, matrix, ...)
+		std::string typeName;
+		unsigned int offset = 0u;
+		//bytes up to the end of the last element, a float3[2] is 28
+		unsigned int size = 0u;
+		unsigned int rows = 0u;
+		unsigned int columns = 0u;
+		//0 when it isn't an array
+		unsigned int elements = 0u;
+		bool isUsed = false;
+	};
+
+	struct Cbuffer {
+
+		std::string name;
+		//register (b#), the slot the buffer is bound to
+		unsigned int slot = 0u;
+		//always whole 16 byte registers
+		unsigned int size = 0u;
+		std::vector<Variable> variables;
+
+		const Variable* FindVariable(const std::string& variableName) const noexcept;
+	};
+
+	//D3D_SHADER_INPUT_TYPE values for the ones the engine binds
+	enum class BindingType : uint32_t {
+
+		Cbuffer = 0,
+		Tbuffer = 1,
+		Texture = 2,
+		Sampler = 3,
+	};
+
+	struct Binding {
+
+		std::string name;
+		BindingType type = BindingType::Cbuffer;
+		unsigned int slot = 0u;
+		unsigned int count = 1u;
+	};
+
+	//a c++ side cbuffer member, to be checked against the hlsl one of the same name
+	struct CbufferField {
+
+		std::string name;
+		size_t offset;
+		size_t size;
+	};
+
+	//D3D only refuses an input layout for errors, warnings still create but read garbage or defaults
+	struct Problem {
+
+		bool isError;
+		std::string message;
+	};
+
+public:
+
+	//the bytes are parsed in the constructor and not kept
+	ShaderReflection(const void* pData, size_t size);
+	ShaderReflection(const std::string& path);
+
+	Stage GetStage() const noexcept;
+	//shader model, 5.0 is {5,0}
+	unsigned int GetMajorVersion() const noexcept;
+	unsigned int GetMinorVersion() const noexcept;
+
+	const std::vector<Parameter>& GetInputSignature() const noexcept;
+	const std::vector<Parameter>& GetOutputSignature() const noexcept;
+	const std::vector<Cbuffer>& GetCbuffers() const noexcept;
+	const std::vector<Binding>& GetBindings() const noexcept;
+
+	//nullptr when the shader has no such cbuffer
+	const Cbuffer* FindCbuffer(const std::string& name) const noexcept;
+	const Cbuffer* FindCbuffer(unsigned int slot) const noexcept;
+
+	//two shaders with the same hash accept the same input layouts
+	uint64_t GetInputSignatureHash() const noexcept;
+
+	//one tightly packed slot 0 element per user semantic in register order, system values are left out
+	std::vector<InputElement> MakeInputLayout() const;
+
+	//missing semantics and repeated elements are errors, component type mismatches are warnings
+	std::vector<Problem> CheckInputLayout(const std::vector<InputElement>& layout) const;
+
+	//every field has to exist in the hlsl with the same offset and size, hlsl variables the fields miss are warnings
+	static std::vector<Problem> CheckCbuffer(const Cbuffer& cbuffer, const std::vector<CbufferField>& fields);
+
+	//bytes per element, 0 for Unknown
+	static unsigned int GetFormatSize(VertexFormat format) noexcept;
+	static const char* GetFormatName(VertexFormat format) noexcept;
+
+	//messages one per line, for exceptions and the debug output
+	static std::string Describe(const std::vector<Problem>& problems);
+	static bool HasError(const std::vector<Problem>& problems) noexcept;
+
+private:
+
+	void Parse(const void* pData, size_t size);
+	void ParseSignature(const uint8_t* pChunk, size_t size, uint32_t fourCC, std::vector<Parameter>& parameters);
+	void ParseResourceDefinitions(const uint8_t* pChunk, size_t size);
+
+private:
+
+	Stage m_stage = Stage::Vertex;
+	unsigned int m_majorVersion = 0u;
+	unsigned int m_minorVersion = 0u;
+
+	std::vector<Parameter> m_inputs;
+	std::vector<Parameter> m_outputs;
+	std::vector<Cbuffer> m_cbuffers;
+	std::vector<Binding> m_bindings;
+};
@@ -2,7 +2,7 @@
 #include "BindableBase.h"
 #include "GraphicsThrowMacros.h"
 #include "Cube.h"
-#include "Surface.h"
+#include "MipChain.h"
 #include "Texture.h"
 #include "Sampler.h"
 
@@ -16,8 +16,26 @@ SkinnedBox::SkinnedBox(Graphics& gfx,
 	TestObject(gfx,rng,adist,ddist,odist,rdist)
 {
 
+	//texture is only loaded once for all skinned boxes
+	pMesh = ResolveMesh(gfx);
+}
+
+bool SkinnedBox::GetOccluderBox(DirectX::FXMMATRIX world, DirectX::XMFLOAT4X4& box) const noexcept
+{
+	DirectX::XMStoreFloat4x4(&box, world);
+	return true;
+}
+
+std::shared_ptr<InstancedMesh> SkinnedBox::ResolveMesh(Graphics& gfx)
+{
 	using namespace Bind;
 
+	static std::weak_ptr<InstancedMesh> pShared;
+
+	if (auto pMesh = pShared.lock()) {
+
+		return pMesh;
+	}
 
 	struct Vertex {
 
@@ -29,19 +47,21 @@ SkinnedBox::SkinnedBox(Graphics& gfx,
 	auto model = Cube::MakeIndependentTextured<Vertex>();
 	model.SetNormalsIndependentFlat();
 
-	AddBind(std::make_shared<VertexBuffer>(gfx, model.vertices));
+	std::vector<std::shared_ptr<Bindable>> binds;
+
+	binds.push_back(std::make_shared<VertexBuffer>(gfx, model.vertices));
 
-	AddBind(std::make_shared<Texture>(gfx, Surface::FromFile("asset\\texture\\stonk.jpg")));
+	binds.push_back(std::make_shared<Texture>(gfx, MipChain(Surface::FromFile("asset\\texture\\stonk.jpg"))));
 
-	AddBind(std::make_shared<Sampler>(gfx));
+	binds.push_back(std::make_shared<Sampler>(gfx));
 
-	auto pvs = std::make_shared<VertexShader>(gfx, L"TexturedPhongVS.cso");
+	auto pvs = std::make_shared<VertexShader>(gfx, L"InstancedTexturedPhongVS.cso");
 	auto pvsbc = pvs->GetByteCode();
-	AddBind(std::move(pvs));
+	binds.push_back(std::move(pvs));
 
-	AddBind(std::make_shared<PixelShader>(gfx, L"TexturedPhongPS.cso"));
+	binds.push_back(std::make_shared<PixelShader>(gfx, L"TexturedPhongPS.cso"));
 
-	AddBind(std::make_shared<IndexBuffer>(gfx, model.indices));
+	binds.push_back(std::make_shared<IndexBuffer>(gfx, model.indices));
 
 	const std::vector<D3D11_INPUT_ELEMENT_DESC> ied = {
 		{"Position",0,DXGI_FORMAT_R32G32B32_FLOAT,0,0,D3D11_INPUT_PER_VERTEX_DATA,0},
@@ -50,19 +70,20 @@ SkinnedBox::SkinnedBox(Graphics& gfx,
 	
 	};
 
-	AddBind(std::make_shared<InputLayout>(gfx, ied, pvsbc));
-
-	AddBind(std::make_shared<Topology>(gfx, D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST));
-
-	struct PSMaterialConstant {
+	binds.push_back(InputLayout::Resolve(gfx, InstancedMesh::WithInstanceLayout(ied), pvsbc));
 
-		float specularIntensity = 0.6f;
-		float specularPower = 30.0f;
-		float padding[2];
-	}colorConst;
+	//material constant (ObjectCBuf in TexturedPhongPS)
+	MyDynamicConstant::CbufLayout matLayout;
+	matLayout.Append(MyDynamicConstant::CbufLayout::Float, "specularIntensity");
+	matLayout.Append(MyDynamicConstant::CbufLayout::Float, "specularPower");
 
-	AddBind(std::make_shared<PixelConstantBuffer<PSMaterialConstant>>(gfx, colorConst, 1u));
+	MyDynamicConstant::CbufBuffer matConst(std::move(matLayout));
+	matConst["specularIntensity"] = 0.6f;
+	matConst["specularPower"] = 30.0f;
 
+	binds.push_back(std::make_shared<DynamicPixelConstantBuffer>(gfx, std::move(matConst), 1u));
 
-	AddBind(std::make_shared<TransformCbuf>(gfx, *this));
+	auto pMesh = std::make_shared<InstancedMesh>(gfx, std::move(binds));
+	pShared = pMesh;
+	return pMesh;
 }
@@ -13,5 +13,13 @@ public:
 		std::uniform_real_distribution<float>& odist,
 		std::uniform_real_distribution<float>& rdist);
 
+	//the unit cube as it is
+	bool GetOccluderBox(DirectX::FXMMATRIX world, DirectX::XMFLOAT4X4& box) const noexcept override;
+
+private:
+
+	//geometry shared between skinned boxes
+	static std::shared_ptr<InstancedMesh> ResolveMesh(Graphics& gfx);
+
 };
 
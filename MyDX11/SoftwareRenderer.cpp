@@ -0,0 +1,806 @@
+#include "SoftwareRenderer.h"
+#include "ImageDecoder.h"
+#include <emmintrin.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cassert>
+#include <sstream>
+
+namespace dx = DirectX;
+
+namespace {
+
+	//vertices/triangles handed to a worker per work item
+	constexpr size_t vertexBatchSize = 2048u;
+	constexpr size_t triangleBatchSize = 1024u;
+
+	float MillisecondsSince(std::chrono::steady_clock::time_point start) noexcept {
+
+		return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	//b,g,r,a bytes to rgba floats in [0,1]
+	__m128 UnpackColor(uint32_t c) noexcept {
+
+		const __m128i bytes = _mm_cvtsi32_si128((int)c);
+		const __m128i words = _mm_unpacklo_epi8(bytes, _mm_setzero_si128());
+		const __m128 bgra = _mm_cvtepi32_ps(_mm_unpacklo_epi16(words, _mm_setzero_si128()));
+
+		return _mm_mul_ps(_mm_shuffle_ps(bgra, bgra, _MM_SHUFFLE(3, 0, 1, 2)), _mm_set1_ps(1.0f / 255.0f));
+	}
+
+	uint32_t PackColor(const dx::XMFLOAT3& rgb) noexcept {
+
+		auto toByte = [](float c) {
+
+			return (uint32_t)(std::clamp(c, 0.0f, 1.0f) * 255.0f + 0.5f);
+		};
+
+		return 0xFF000000u | (toByte(rgb.x) << 16u) | (toByte(rgb.y) << 8u) | toByte(rgb.z);
+	}
+
+	__m128 Lerp(__m128 a, __m128 b, float t) noexcept {
+
+		return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), _mm_set1_ps(t)));
+	}
+
+	//row vector times matrix, the convention the engine's matrices are built for
+	__m128 Transform(__m128 v, const dx::XMFLOAT4X4& m) noexcept {
+
+		__m128 result = _mm_mul_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)), _mm_loadu_ps(m.m[0]));
+		result = _mm_add_ps(result, _mm_mul_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)), _mm_loadu_ps(m.m[1])));
+		result = _mm_add_ps(result, _mm_mul_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2)), _mm_loadu_ps(m.m[2])));
+
+		return _mm_add_ps(result, _mm_mul_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3)), _mm_loadu_ps(m.m[3])));
+	}
+
+	dx::XMFLOAT4X4 Multiply(const dx::XMFLOAT4X4& a, const dx::XMFLOAT4X4& b) noexcept {
+
+		dx::XMFLOAT4X4 result;
+
+		for (int row = 0; row < 4; row++) {
+
+			_mm_storeu_ps(result.m[row], Transform(_mm_loadu_ps(a.m[row]), b));
+		}
+
+		return result;
+	}
+
+	//the shading math is one pixel at a time, on plain float3s
+	dx::XMFLOAT3 Add(const dx::XMFLOAT3& a, const dx::XMFLOAT3& b) noexcept {
+
+		return { a.x + b.x,a.y + b.y,a.z + b.z };
+	}
+
+	dx::XMFLOAT3 Subtract(const dx::XMFLOAT3& a, const dx::XMFLOAT3& b) noexcept {
+
+		return { a.x - b.x,a.y - b.y,a.z - b.z };
+	}
+
+	dx::XMFLOAT3 Multiply(const dx::XMFLOAT3& a, const dx::XMFLOAT3& b) noexcept {
+
+		return { a.x * b.x,a.y * b.y,a.z * b.z };
+	}
+
+	dx::XMFLOAT3 Scale(const dx::XMFLOAT3& a, float s) noexcept {
+
+		return { a.x * s,a.y * s,a.z * s };
+	}
+
+	float Dot(const dx::XMFLOAT3& a, const dx::XMFLOAT3& b) noexcept {
+
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	dx::XMFLOAT3 Normalize(const dx::XMFLOAT3& a) noexcept {
+
+		const float length = std::sqrt(Dot(a, a));
+
+		return length > 0.0f ? Scale(a, 1.0f / length) : a;
+	}
+
+	dx::XMFLOAT3 Rgb(const dx::XMFLOAT4& rgba) noexcept {
+
+		return { rgba.x,rgba.y,rgba.z };
+	}
+
+	//top-left fill rule for clockwise triangles in y-down screen space
+	bool IsTopLeft(float ax, float ay, float bx, float by) noexcept {
+
+		const float dx = bx - ax;
+		const float dy = by - ay;
+		return dy < 0.0f || (dy == 0.0f && dx > 0.0f);
+	}
+
+}
+
+
+/// <summary>
+/// FrameBuffer
+/// </summary>
+
+SoftwareRenderer::FrameBuffer::FrameBuffer(unsigned int width, unsigned int height)
+	:
+	m_width(width),
+	m_height(height),
+	m_depthPitch((width + 3u) & ~3u),
+	m_color((size_t)width * height),
+	m_depth(m_depthPitch * height, 1.0f)
+{}
+
+void SoftwareRenderer::FrameBuffer::Clear(uint32_t color, float depth) noexcept
+{
+	std::fill(m_color.begin(), m_color.end(), color);
+	std::fill(m_depth.begin(), m_depth.end(), depth);
+}
+
+unsigned int SoftwareRenderer::FrameBuffer::GetWidth() const noexcept
+{
+	return m_width;
+}
+
+unsigned int SoftwareRenderer::FrameBuffer::GetHeight() const noexcept
+{
+	return m_height;
+}
+
+uint32_t* SoftwareRenderer::FrameBuffer::GetColorPtr() noexcept
+{
+	return m_color.data();
+}
+
+const uint32_t* SoftwareRenderer::FrameBuffer::GetColorPtr() const noexcept
+{
+	return m_color.data();
+}
+
+PixelKernels::ConstImage SoftwareRenderer::FrameBuffer::GetImage() const noexcept
+{
+	return { m_color.data(),m_width,m_width,m_height };
+}
+
+float* SoftwareRenderer::FrameBuffer::GetDepthPtr() noexcept
+{
+	return m_depth.data();
+}
+
+const float* SoftwareRenderer::FrameBuffer::GetDepthPtr() const noexcept
+{
+	return m_depth.data();
+}
+
+size_t SoftwareRenderer::FrameBuffer::GetDepthPitch() const noexcept
+{
+	return m_depthPitch;
+}
+
+
+/// <summary>
+/// Texture
+/// </summary>
+
+SoftwareRenderer::Texture::Texture(unsigned int width, unsigned int height, std::vector<uint32_t> texels) noexcept
+	:
+	m_width(width),
+	m_height(height),
+	m_texels(std::move(texels))
+{
+	assert("Texture needs width * height texels" && m_texels.size() == (size_t)width * height);
+}
+
+SoftwareRenderer::Texture SoftwareRenderer::Texture::FromFile(const std::string& path)
+{
+	unsigned int width = 0u;
+	unsigned int height = 0u;
+	std::vector<uint32_t> texels;
+
+	ImageDecoder::DecodeFile(path, [&](unsigned int w, unsigned int h) {
+
+		width = w;
+		height = h;
+		texels.resize((size_t)w * h);
+
+		return texels.data();
+	});
+
+	return Texture(width, height, std::move(texels));
+}
+
+dx::XMFLOAT4 SoftwareRenderer::Texture::Sample(float u, float v) const noexcept
+{
+	const int w = (int)m_width;
+	const int h = (int)m_height;
+
+	//texel centers are at half coordinates
+	const float fx = u * (float)m_width - 0.5f;
+	const float fy = v * (float)m_height - 0.5f;
+	const float flx = std::floor(fx);
+	const float fly = std::floor(fy);
+	const float ax = fx - flx;
+	const float ay = fy - fly;
+
+	//wrap addressing on both axes
+	auto wrap = [](int i, int n) {
+
+		i %= n;
+		return i < 0 ? i + n : i;
+	};
+
+	const int x0 = wrap((int)flx, w);
+	const int y0 = wrap((int)fly, h);
+	const int x1 = x0 + 1 == w ? 0 : x0 + 1;
+	const int y1 = y0 + 1 == h ? 0 : y0 + 1;
+
+	const auto pTexels = m_texels.data();
+	const auto top = Lerp(UnpackColor(pTexels[y0 * w + x0]), UnpackColor(pTexels[y0 * w + x1]), ax);
+	const auto bottom = Lerp(UnpackColor(pTexels[y1 * w + x0]), UnpackColor(pTexels[y1 * w + x1]), ax);
+
+	dx::XMFLOAT4 rgba;
+	_mm_storeu_ps(&rgba.x, Lerp(top, bottom, ay));
+
+	return rgba;
+}
+
+unsigned int SoftwareRenderer::Texture::GetWidth() const noexcept
+{
+	return m_width;
+}
+
+unsigned int SoftwareRenderer::Texture::GetHeight() const noexcept
+{
+	return m_height;
+}
+
+
+/// <summary>
+/// SoftwareRenderer
+/// </summary>
+
+SoftwareRenderer::SoftwareRenderer(JobSystem& jobs, unsigned int width, unsigned int height)
+	:
+	m_jobs(jobs),
+	m_width(width),
+	m_height(height),
+	m_tilesX(((int)width + tileSize - 1) / tileSize),
+	m_tilesY(((int)height + tileSize - 1) / tileSize)
+{}
+
+void SoftwareRenderer::AddMesh(Mesh mesh)
+{
+	assert("Mesh normals must match positions" && mesh.normals.size() == mesh.positions.size());
+	assert("Mesh index count must be a multiple of 3" && mesh.indices.size() % 3 == 0);
+
+	//untextured meshes still carry texcoords so the vertex stage stays uniform
+	mesh.texcoords.resize(mesh.positions.size(), { 0.0f,0.0f });
+
+	m_meshes.push_back(std::move(mesh));
+}
+
+void SoftwareRenderer::ClearMeshes() noexcept
+{
+	m_meshes.clear();
+	m_shadedVertices.clear();
+}
+
+void SoftwareRenderer::Render(FrameBuffer& target, const dx::XMFLOAT4X4& view, const dx::XMFLOAT4X4& projection,
+	const LightData& light, uint32_t clearColor)
+{
+	assert(target.GetWidth() == m_width);
+	assert(target.GetHeight() == m_height);
+
+	const auto frameStart = std::chrono::steady_clock::now();
+	m_stats = {};
+
+	//light position goes to view space like PointLight::Bind does
+	LightData viewLight = light;
+	float lightPos[4];
+	_mm_storeu_ps(lightPos, Transform(_mm_setr_ps(light.pos.x, light.pos.y, light.pos.z, 1.0f), view));
+	viewLight.pos = { lightPos[0],lightPos[1],lightPos[2] };
+
+	//split the work into batches so big and small meshes balance across workers
+	m_vertexBatches.clear();
+	m_triangleBatches.clear();
+	m_shadedVertices.resize(m_meshes.size());
+
+	for (size_t m = 0; m < m_meshes.size(); m++) {
+
+		const auto nVertices = m_meshes[m].positions.size();
+		const auto nTriangles = m_meshes[m].indices.size() / 3;
+
+		m_shadedVertices[m].resize(nVertices);
+		m_stats.trianglesIn += nTriangles;
+
+		for (size_t first = 0; first < nVertices; first += vertexBatchSize) {
+
+			m_vertexBatches.push_back({ m,first,std::min(first + vertexBatchSize,nVertices) });
+		}
+
+		for (size_t first = 0; first < nTriangles; first += triangleBatchSize) {
+
+			m_triangleBatches.push_back({ m,first,std::min(first + triangleBatchSize,nTriangles) });
+		}
+	}
+
+	//vertex stage (PhongVS/ModelPhongVS)
+	auto stageStart = std::chrono::steady_clock::now();
+
+	m_jobs.ParallelFor(m_vertexBatches.size(), 1u, [&](size_t firstBatch, size_t lastBatch) {
+
+		for (size_t b = firstBatch; b < lastBatch; b++) {
+
+			const auto& batch = m_vertexBatches[b];
+			const auto& mesh = m_meshes[batch.mesh];
+			auto& out = m_shadedVertices[batch.mesh];
+
+			const auto modelView = Multiply(mesh.transform, view);
+			const auto modelViewProj = Multiply(modelView, projection);
+
+			for (size_t i = batch.first; i < batch.last; i++) {
+
+				const auto& p = mesh.positions[i];
+				const auto& n = mesh.normals[i];
+				const auto pos = _mm_setr_ps(p.x, p.y, p.z, 1.0f);
+
+				float viewPos[4];
+				float normal[4];
+				_mm_storeu_ps(&out[i].clip.x, Transform(pos, modelViewProj));
+				_mm_storeu_ps(viewPos, Transform(pos, modelView));
+				_mm_storeu_ps(normal, Transform(_mm_setr_ps(n.x, n.y, n.z, 0.0f), modelView));
+
+				out[i].viewPos = { viewPos[0],viewPos[1],viewPos[2] };
+				out[i].normal = { normal[0],normal[1],normal[2] };
+				out[i].tc = mesh.texcoords[i];
+			}
+		}
+	});
+
+	m_stats.vertexMs = MillisecondsSince(stageStart);
+
+	//clipping, triangle setup and binning
+	stageStart = std::chrono::steady_clock::now();
+
+	m_triangles.resize(m_triangleBatches.size());
+	m_bins.resize(m_triangleBatches.size());
+
+	m_jobs.ParallelFor(m_triangleBatches.size(), 1u, [this](size_t first, size_t last) {
+
+		for (size_t b = first; b < last; b++) {
+
+			SetupTriangles(b);
+		}
+	});
+
+	BuildTileLists();
+
+	m_stats.binningMs = MillisecondsSince(stageStart);
+
+	//tile rasterisation, every tile owns its color and depth pixels
+	stageStart = std::chrono::steady_clock::now();
+
+	target.Clear(clearColor);
+
+	m_jobs.ParallelFor((size_t)m_tilesX * m_tilesY, 1u, [&](size_t first, size_t last) {
+
+		for (size_t tile = first; tile < last; tile++) {
+
+			RasteriseTile(tile, target, viewLight);
+		}
+	});
+
+	m_stats.rasterMs = MillisecondsSince(stageStart);
+	m_stats.totalMs = MillisecondsSince(frameStart);
+}
+
+unsigned int SoftwareRenderer::GetWidth() const noexcept
+{
+	return m_width;
+}
+
+unsigned int SoftwareRenderer::GetHeight() const noexcept
+{
+	return m_height;
+}
+
+unsigned int SoftwareRenderer::GetThreadCount() const noexcept
+{
+	return m_jobs.GetThreadCount();
+}
+
+const SoftwareRenderer::FrameStats& SoftwareRenderer::GetFrameStats() const noexcept
+{
+	return m_stats;
+}
+
+void SoftwareRenderer::SetupTriangles(size_t b)
+{
+	const auto& batch = m_triangleBatches[b];
+	const auto& mesh = m_meshes[batch.mesh];
+	const auto& verts = m_shadedVertices[batch.mesh];
+
+	m_triangles[b].clear();
+	m_bins[b].clear();
+
+	auto lerp = [](const ShadedVertex& a, const ShadedVertex& c, float t) {
+
+		auto mix = [t](float x, float y) { return x + (y - x) * t; };
+
+		ShadedVertex v;
+		_mm_storeu_ps(&v.clip.x, Lerp(_mm_loadu_ps(&a.clip.x), _mm_loadu_ps(&c.clip.x), t));
+		v.viewPos = { mix(a.viewPos.x,c.viewPos.x),mix(a.viewPos.y,c.viewPos.y),mix(a.viewPos.z,c.viewPos.z) };
+		v.normal = { mix(a.normal.x,c.normal.x),mix(a.normal.y,c.normal.y),mix(a.normal.z,c.normal.z) };
+		v.tc = { mix(a.tc.x,c.tc.x),mix(a.tc.y,c.tc.y) };
+		return v;
+	};
+
+	for (size_t t = batch.first; t < batch.last; t++) {
+
+		const ShadedVertex* in[3] = {
+			&verts[mesh.indices[t * 3 + 0]],
+			&verts[mesh.indices[t * 3 + 1]],
+			&verts[mesh.indices[t * 3 + 2]],
+		};
+
+		//trivial reject against the frustum side planes
+		bool outside = false;
+		for (int axis = 0; axis < 2 && !outside; axis++) {
+
+			auto coord = [axis](const ShadedVertex* v) { return axis == 0 ? v->clip.x : v->clip.y; };
+
+			outside =
+				(coord(in[0]) > in[0]->clip.w && coord(in[1]) > in[1]->clip.w && coord(in[2]) > in[2]->clip.w) ||
+				(coord(in[0]) < -in[0]->clip.w && coord(in[1]) < -in[1]->clip.w && coord(in[2]) < -in[2]->clip.w);
+		}
+
+		if (outside) {
+
+			continue;
+		}
+
+		//near plane (z >= 0 in d3d clip space)
+		const int nInside = (in[0]->clip.z >= 0.0f) + (in[1]->clip.z >= 0.0f) + (in[2]->clip.z >= 0.0f);
+
+		if (nInside == 0) {
+
+			continue;
+		}
+
+		if (nInside == 3) {
+
+			EmitTriangle(b, *in[0], *in[1], *in[2], mesh.material);
+			continue;
+		}
+
+		//clip the polygon against the near plane, keeps winding order
+		ShadedVertex poly[4];
+		int nPoly = 0;
+
+		for (int i = 0; i < 3; i++) {
+
+			const auto& a = *in[i];
+			const auto& c = *in[(i + 1) % 3];
+			const bool aIn = a.clip.z >= 0.0f;
+			const bool cIn = c.clip.z >= 0.0f;
+
+			if (aIn) {
+
+				poly[nPoly++] = a;
+			}
+
+			if (aIn != cIn) {
+
+				poly[nPoly++] = lerp(a, c, a.clip.z / (a.clip.z - c.clip.z));
+			}
+		}
+
+		for (int i = 1; i + 1 < nPoly; i++) {
+
+			EmitTriangle(b, poly[0], poly[i], poly[i + 1], mesh.material);
+		}
+	}
+}
+
+void SoftwareRenderer::EmitTriangle(size_t b, const ShadedVertex& v0, const ShadedVertex& v1, const ShadedVertex& v2, const Material& material)
+{
+	const ShadedVertex* v[3] = { &v0,&v1,&v2 };
+	Triangle tri;
+
+	for (int i = 0; i < 3; i++) {
+
+		const float invW = 1.0f / v[i]->clip.w;
+
+		//viewport transform
+		tri.x[i] = (v[i]->clip.x * invW + 1.0f) * 0.5f * (float)m_width;
+		tri.y[i] = (1.0f - v[i]->clip.y * invW) * 0.5f * (float)m_height;
+		tri.z[i] = v[i]->clip.z * invW;
+		tri.invW[i] = invW;
+
+		tri.viewPos[i] = Scale(v[i]->viewPos, invW);
+		tri.normal[i] = Scale(v[i]->normal, invW);
+		tri.tc[i] = { v[i]->tc.x * invW,v[i]->tc.y * invW };
+	}
+
+	//back face culling (d3d default: clockwise is front)
+	const float area = (tri.x[1] - tri.x[0]) * (tri.y[2] - tri.y[0]) - (tri.y[1] - tri.y[0]) * (tri.x[2] - tri.x[0]);
+
+	if (!(area > 0.0f)) {
+
+		return;
+	}
+
+	//pixel bounds of the sample points covered
+	tri.minX = std::max(0, (int)std::floor(std::min({ tri.x[0],tri.x[1],tri.x[2] }) - 0.5f));
+	tri.minY = std::max(0, (int)std::floor(std::min({ tri.y[0],tri.y[1],tri.y[2] }) - 0.5f));
+	tri.maxX = std::min((int)m_width - 1, (int)std::ceil(std::max({ tri.x[0],tri.x[1],tri.x[2] }) - 0.5f));
+	tri.maxY = std::min((int)m_height - 1, (int)std::ceil(std::max({ tri.y[0],tri.y[1],tri.y[2] }) - 0.5f));
+
+	if (tri.minX > tri.maxX || tri.minY > tri.maxY) {
+
+		return;
+	}
+
+	tri.pMaterial = &material;
+
+	auto& tris = m_triangles[b];
+	const auto index = (unsigned int)tris.size();
+	tris.push_back(tri);
+
+	for (int ty = tri.minY / tileSize; ty <= tri.maxY / tileSize; ty++) {
+
+		for (int tx = tri.minX / tileSize; tx <= tri.maxX / tileSize; tx++) {
+
+			m_bins[b].push_back({ (unsigned int)(ty * m_tilesX + tx),index });
+		}
+	}
+}
+
+void SoftwareRenderer::BuildTileLists()
+{
+	const size_t nTiles = (size_t)m_tilesX * m_tilesY;
+
+	//counting sort of the bin entries by tile, batch order is preserved
+	m_tileOffsets.assign(nTiles + 1u, 0u);
+
+	for (const auto& bins : m_bins) {
+
+		for (const auto& e : bins) {
+
+			m_tileOffsets[e.tile + 1u]++;
+		}
+	}
+
+	for (size_t i = 0; i < nTiles; i++) {
+
+		m_tileOffsets[i + 1u] += m_tileOffsets[i];
+	}
+
+	m_tileTriangles.resize(m_tileOffsets.back());
+	std::vector<unsigned int> cursor(m_tileOffsets.begin(), m_tileOffsets.end() - 1);
+
+	for (size_t b = 0; b < m_bins.size(); b++) {
+
+		for (const auto& e : m_bins[b]) {
+
+			m_tileTriangles[cursor[e.tile]++] = &m_triangles[b][e.triangle];
+		}
+
+		m_stats.trianglesBinned += m_triangles[b].size();
+	}
+}
+
+void SoftwareRenderer::RasteriseTile(size_t tile, FrameBuffer& target, const LightData& light) noexcept
+{
+	const int tileMinX = (int)(tile % m_tilesX) * tileSize;
+	const int tileMinY = (int)(tile / m_tilesX) * tileSize;
+	const int tileMaxX = std::min(tileMinX + tileSize, (int)m_width) - 1;
+	const int tileMaxY = std::min(tileMinY + tileSize, (int)m_height) - 1;
+
+	for (auto i = m_tileOffsets[tile]; i < m_tileOffsets[tile + 1]; i++) {
+
+		RasteriseTriangle(*m_tileTriangles[i], tileMinX, tileMinY, tileMaxX, tileMaxY, target, light);
+	}
+}
+
+void SoftwareRenderer::RasteriseTriangle(const Triangle& tri, int tileMinX, int tileMinY, int tileMaxX, int tileMaxY,
+	FrameBuffer& target, const LightData& light) noexcept
+{
+	const int minX = std::max(tri.minX, tileMinX) & ~3;
+	const int minY = std::max(tri.minY, tileMinY);
+	const int maxX = std::min(tri.maxX, tileMaxX);
+	const int maxY = std::min(tri.maxY, tileMaxY);
+
+	if (minX > maxX || minY > maxY) {
+
+		return;
+	}
+
+	//edge i is opposite vertex i, E(p) = A*px + B*py + C
+	float A[3], B[3], C[3];
+	bool topLeft[3];
+
+	for (int i = 0; i < 3; i++) {
+
+		const int a = (i + 1) % 3;
+		const int c = (i + 2) % 3;
+
+		A[i] = -(tri.y[c] - tri.y[a]);
+		B[i] = tri.x[c] - tri.x[a];
+		C[i] = -B[i] * tri.y[a] - A[i] * tri.x[a];
+		topLeft[i] = IsTopLeft(tri.x[a], tri.y[a], tri.x[c], tri.y[c]);
+	}
+
+	const float invArea = 1.0f / (A[0] * tri.x[0] + B[0] * tri.y[0] + C[0]);
+
+	//4 pixels per step
+	const __m128 laneOffset = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+	const __m128 laneIndex = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 end = _mm_set1_ps((float)maxX + 1.0f);
+
+	__m128 stepX[3];
+	for (int i = 0; i < 3; i++) {
+
+		stepX[i] = _mm_set1_ps(A[i] * 4.0f);
+	}
+
+	auto pColor = target.GetColorPtr();
+
+	for (int y = minY; y <= maxY; y++) {
+
+		const float py = (float)y + 0.5f;
+		const __m128 px = _mm_add_ps(_mm_set1_ps((float)minX), laneOffset);
+
+		__m128 e[3];
+		for (int i = 0; i < 3; i++) {
+
+			e[i] = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(A[i]), px), _mm_set1_ps(B[i] * py + C[i]));
+		}
+
+		float* pDepthRow = target.GetDepthPtr() + (size_t)y * target.GetDepthPitch();
+
+		for (int x = minX; x <= maxX; x += 4) {
+
+			//coverage with fill rule
+			__m128 mask = _mm_cmplt_ps(_mm_add_ps(_mm_set1_ps((float)x), laneIndex), end);
+
+			for (int i = 0; i < 3; i++) {
+
+				mask = _mm_and_ps(mask, topLeft[i] ? _mm_cmpge_ps(e[i], zero) : _mm_cmpgt_ps(e[i], zero));
+			}
+
+			if (_mm_movemask_ps(mask) != 0) {
+
+				//barycentrics and depth (z/w is linear in screen space)
+				const __m128 b0 = _mm_mul_ps(e[0], _mm_set1_ps(invArea));
+				const __m128 b1 = _mm_mul_ps(e[1], _mm_set1_ps(invArea));
+				const __m128 b2 = _mm_mul_ps(e[2], _mm_set1_ps(invArea));
+
+				const __m128 z = _mm_add_ps(_mm_mul_ps(b0, _mm_set1_ps(tri.z[0])),
+					_mm_add_ps(_mm_mul_ps(b1, _mm_set1_ps(tri.z[1])), _mm_mul_ps(b2, _mm_set1_ps(tri.z[2]))));
+
+				//D32 LESS depth test
+				const __m128 depth = _mm_loadu_ps(pDepthRow + x);
+				const __m128 pass = _mm_and_ps(mask, _mm_cmplt_ps(z, depth));
+				_mm_storeu_ps(pDepthRow + x, _mm_or_ps(_mm_and_ps(pass, z), _mm_andnot_ps(pass, depth)));
+
+				const int passed = _mm_movemask_ps(pass);
+
+				if (passed != 0) {
+
+					float w0[4], w1[4], w2[4];
+					_mm_storeu_ps(w0, b0);
+					_mm_storeu_ps(w1, b1);
+					_mm_storeu_ps(w2, b2);
+
+					for (int lane = 0; lane < 4; lane++) {
+
+						if (!(passed & (1 << lane))) {
+
+							continue;
+						}
+
+						//perspective correct attributes
+						const float w = 1.0f / (w0[lane] * tri.invW[0] + w1[lane] * tri.invW[1] + w2[lane] * tri.invW[2]);
+						const float c0 = w0[lane] * w;
+						const float c1 = w1[lane] * w;
+						const float c2 = w2[lane] * w;
+
+						auto interp3 = [c0, c1, c2](const dx::XMFLOAT3* a) {
+
+							return Add(Add(Scale(a[0], c0), Scale(a[1], c1)), Scale(a[2], c2));
+						};
+
+						const dx::XMFLOAT2 tc = {
+							tri.tc[0].x * c0 + tri.tc[1].x * c1 + tri.tc[2].x * c2,
+							tri.tc[0].y * c0 + tri.tc[1].y * c1 + tri.tc[2].y * c2
+						};
+
+						const auto color = ShadePixel(*tri.pMaterial, light, interp3(tri.viewPos), interp3(tri.normal), tc);
+						pColor[(size_t)y * m_width + x + lane] = PackColor(color);
+					}
+				}
+			}
+
+			for (int i = 0; i < 3; i++) {
+
+				e[i] = _mm_add_ps(e[i], stepX[i]);
+			}
+		}
+	}
+}
+
+dx::XMFLOAT3 SoftwareRenderer::ShadePixel(const Material& material, const LightData& light,
+	const dx::XMFLOAT3& viewPos, const dx::XMFLOAT3& n, const dx::XMFLOAT2& tc) noexcept
+{
+	//fragment to light vector data
+	const auto vToL = Subtract(light.pos, viewPos);
+	const float distToL = std::sqrt(Dot(vToL, vToL));
+	const auto dirToL = Scale(vToL, 1.0f / distToL);
+
+	//diffuse attenuation
+	const float att = 1.0f / (light.attConst + light.attLin * distToL + light.attQuad * (distToL * distToL));
+
+	const auto lightColor = Scale(light.diffuseColor, light.diffuseIntensity);
+	const auto diffuse = Scale(lightColor, att * std::max(0.0f, Dot(dirToL, n)));
+	const auto& ambient = light.ambient;
+
+	//reflected light vector
+	const auto w = Scale(n, Dot(vToL, n));
+	const auto r = Subtract(Scale(w, 2.0f), vToL);
+	const float specAngle = std::max(0.0f, Dot(Normalize(Scale(r, -1.0f)), Normalize(viewPos)));
+
+	switch (material.shading) {
+
+	case Shading::ModelPhong: {
+
+		const auto specular = Scale(lightColor, att * material.specularIntensity * std::pow(specAngle, material.specularPower));
+		const auto texel = Rgb(material.pDiffuse->Sample(tc.x, tc.y));
+		return Add(Multiply(Add(diffuse, ambient), texel), specular);
+	}
+
+	case Shading::ModelPhongSpecMap: {
+
+		const auto specSample = material.pSpecular->Sample(tc.x, tc.y);
+		const float specularPower = std::pow(2.0f, specSample.w * 13.0f);
+		const auto specular = Scale(lightColor, att * std::pow(specAngle, specularPower));
+		const auto texel = Rgb(material.pDiffuse->Sample(tc.x, tc.y));
+		return Add(Multiply(Add(diffuse, ambient), texel), Multiply(specular, Rgb(specSample)));
+	}
+
+	default: {
+
+		const auto specular = Scale(lightColor, att * material.specularIntensity * std::pow(specAngle, material.specularPower));
+		return Multiply(Add(Add(diffuse, ambient), specular), material.color);
+	}
+
+	}
+}
+
+
+//software renderer exception stuff
+SoftwareRenderer::Exception::Exception(int line, const char* file, std::string note) noexcept
+	:
+	myException(line, file),
+	note(std::move(note))
+{}
+
+const char* SoftwareRenderer::Exception::what() const noexcept
+{
+	std::ostringstream oss;
+
+	oss << myException::what() << std::endl
+		<< "[Note] " << GetNote();
+
+	whatBuffer = oss.str();
+	return whatBuffer.c_str();
+}
+
+const char* SoftwareRenderer::Exception::GetType() const noexcept
+{
+	return "SupaHotFire Software Renderer Exception";
+}
+
+const std::string& SoftwareRenderer::Exception::GetNote() const noexcept
+{
+	return note;
+}
@@ -0,0 +1,252 @@
+#pragma once
+
+#include "myException.h"
+#include "JobSystem.h"
+#include "PixelKernels.h"
+#include <DirectXMath.h>
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+/// <summary>
+/// CPU implementation of the pipeline the engine uses on the GPU
+/// (indexed triangle lists, Phong/ModelPhong shading, D32 depth, bilinear wrap sampling)
+/// renders into its own color and depth buffers so frames can be produced without a D3D device,
+/// only the model loading goes through assimp and windows, the rest builds and runs on Linux
+/// </summary>
+class SoftwareRenderer {
+
+public:
+
+	class Exception :public myException {
+
+	public:
+
+		Exception(int line, const char* file, std::string note) noexcept;
+		const char* what() const noexcept override;
+		const char* GetType() const noexcept override;
+
+		const std::string& GetNote() const noexcept;
+
+	private:
+
+		std::string note;
+	};
+
+public:
+
+	//same layout as PointLight's pixel constant buffer (LightCBuf in the Phong shaders)
+	struct LightData {
+
+		alignas(16) DirectX::XMFLOAT3 pos;
+		alignas(16) DirectX::XMFLOAT3 ambient;
+		alignas(16) DirectX::XMFLOAT3 diffuseColor;
+
+		float diffuseIntensity;
+		float attConst;
+		float attLin;
+		float attQuad;
+	};
+
+	//B8G8R8A8 color (the Surface::Color layout) and D32 depth the renderer draws into
+	class FrameBuffer {
+
+	public:
+
+		FrameBuffer(unsigned int width, unsigned int height);
+
+		void Clear(uint32_t color, float depth = 1.0f) noexcept;
+
+		unsigned int GetWidth() const noexcept;
+		unsigned int GetHeight() const noexcept;
+
+		uint32_t* GetColorPtr() noexcept;
+		const uint32_t* GetColorPtr() const noexcept;
+		PixelKernels::ConstImage GetImage() const noexcept;
+
+		//rows are padded to a multiple of 4 for the 4 wide depth test
+		float* GetDepthPtr() noexcept;
+		const float* GetDepthPtr() const noexcept;
+		size_t GetDepthPitch() const noexcept;
+
+		//the color into a surface of the same size, for showing or saving a frame through the engine
+		//*windows only, Surface is built on GDI+
+		void CopyTo(class Surface& surface) const noexcept;
+
+	private:
+
+		unsigned int m_width;
+		unsigned int m_height;
+		size_t m_depthPitch;
+
+		std::vector<uint32_t> m_color;
+		std::vector<float> m_depth;
+	};
+
+	//texture sampled the way Bind::Sampler sets it up (MIN_MAG_MIP_LINEAR + WRAP)
+	class Texture {
+
+	public:
+
+		//texels in the Surface::Color layout
+		Texture(unsigned int width, unsigned int height, std::vector<uint32_t> texels) noexcept;
+
+		//PNG or JPEG through ImageDecoder
+		static Texture FromFile(const std::string& path);
+
+		//returns rgba in [0,1]
+		DirectX::XMFLOAT4 Sample(float u, float v) const noexcept;
+
+		unsigned int GetWidth() const noexcept;
+		unsigned int GetHeight() const noexcept;
+
+	private:
+
+		unsigned int m_width;
+		unsigned int m_height;
+		std::vector<uint32_t> m_texels;
+	};
+
+	//pixel shader selection follows the shader each drawable binds
+	enum class Shading {
+
+		Phong,				//PhongPS (flat material color)
+		ModelPhong,			//ModelPhongPS (diffuse texture + material specular)
+		ModelPhongSpecMap,	//ModelPhongPSSpecMap (diffuse texture + specular map)
+	};
+
+	struct Material {
+
+		Shading shading = Shading::Phong;
+		DirectX::XMFLOAT3 color = { 1.0f,1.0f,1.0f };
+		float specularIntensity = 0.8f;
+		float specularPower = 30.0f;
+		std::shared_ptr<Texture> pDiffuse;
+		std::shared_ptr<Texture> pSpecular;
+	};
+
+	struct Mesh {
+
+		std::vector<DirectX::XMFLOAT3> positions;
+		std::vector<DirectX::XMFLOAT3> normals;
+		std::vector<DirectX::XMFLOAT2> texcoords;
+		std::vector<unsigned short> indices;
+		Material material;
+		DirectX::XMFLOAT4X4 transform;
+	};
+
+	//timings of the last Render call in milliseconds
+	struct FrameStats {
+
+		float vertexMs = 0.0f;
+		float binningMs = 0.0f;
+		float rasterMs = 0.0f;
+		float totalMs = 0.0f;
+		size_t trianglesIn = 0;
+		size_t trianglesBinned = 0;
+	};
+
+public:
+
+	//stages are split across the job system's threads
+	SoftwareRenderer(JobSystem& jobs, unsigned int width, unsigned int height);
+	SoftwareRenderer(const SoftwareRenderer&) = delete;
+	SoftwareRenderer& operator=(const SoftwareRenderer&) = delete;
+
+	void AddMesh(Mesh mesh);
+
+	//loads a model file through assimp the same way Model does and adds its meshes
+	//*windows only, assimp is only built for the engine
+	void LoadModel(const std::string& fileName, const DirectX::XMFLOAT4X4& transform);
+	void ClearMeshes() noexcept;
+
+	//matrices are row major for row vectors, as DirectXMath stores them
+	void Render(FrameBuffer& target, const DirectX::XMFLOAT4X4& view, const DirectX::XMFLOAT4X4& projection,
+		const LightData& light, uint32_t clearColor);
+
+	unsigned int GetWidth() const noexcept;
+	unsigned int GetHeight() const noexcept;
+	unsigned int GetThreadCount() const noexcept;
+	const FrameStats& GetFrameStats() const noexcept;
+
+private:
+
+	//vertex shader output (ModelPhongVS/PhongVS VSOut)
+	struct ShadedVertex {
+
+		DirectX::XMFLOAT4 clip;
+		DirectX::XMFLOAT3 viewPos;
+		DirectX::XMFLOAT3 normal;
+		DirectX::XMFLOAT2 tc;
+	};
+
+	//screen space triangle ready for rasterisation
+	struct Triangle {
+
+		float x[3];
+		float y[3];
+		float z[3];
+		float invW[3];
+
+		//attributes pre-divided by w for perspective correct interpolation
+		DirectX::XMFLOAT3 viewPos[3];
+		DirectX::XMFLOAT3 normal[3];
+		DirectX::XMFLOAT2 tc[3];
+
+		const Material* pMaterial;
+		int minX, minY, maxX, maxY;
+	};
+
+	//work item for the vertex and setup stages (a range of one mesh)
+	struct Batch {
+
+		size_t mesh;
+		size_t first;
+		size_t last;
+	};
+
+	//triangle reference emitted by the setup stage, sorted into tiles afterwards
+	struct BinEntry {
+
+		unsigned int tile;
+		unsigned int triangle;
+	};
+
+	void SetupTriangles(size_t batch);
+	void EmitTriangle(size_t batch, const ShadedVertex& v0, const ShadedVertex& v1, const ShadedVertex& v2, const Material& material);
+	void BuildTileLists();
+	void RasteriseTile(size_t tile, FrameBuffer& target, const LightData& light) noexcept;
+	void RasteriseTriangle(const Triangle& tri, int tileMinX, int tileMinY, int tileMaxX, int tileMaxY,
+		FrameBuffer& target, const LightData& light) noexcept;
+
+	static DirectX::XMFLOAT3 ShadePixel(const Material& material, const LightData& light,
+		const DirectX::XMFLOAT3& viewPos, const DirectX::XMFLOAT3& normal, const DirectX::XMFLOAT2& tc) noexcept;
+
+private:
+
+	static constexpr int tileSize = 64;
+
+	JobSystem& m_jobs;
+	unsigned int m_width;
+	unsigned int m_height;
+	int m_tilesX;
+	int m_tilesY;
+
+	std::vector<Mesh> m_meshes;
+	std::vector<std::vector<ShadedVertex>> m_shadedVertices;
+
+	//per batch triangle storage and bins (no locking while binning)
+	//tile lists are rebuilt in batch order so the output is deterministic
+	std::vector<Batch> m_vertexBatches;
+	std::vector<Batch> m_triangleBatches;
+	std::vector<std::vector<Triangle>> m_triangles;
+	std::vector<std::vector<BinEntry>> m_bins;
+	std::vector<unsigned int> m_tileOffsets;
+	std::vector<const Triangle*> m_tileTriangles;
+
+	std::unordered_map<std::string, std::shared_ptr<Texture>> m_textureCache;
+
+	FrameStats m_stats;
+};
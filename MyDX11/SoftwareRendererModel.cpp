@@ -0,0 +1,149 @@
+#include "SoftwareRenderer.h"
+#include "Surface.h"
+#include <cassert>
+#include <cstring>
+#include <functional>
+
+//assimp loading stuffs
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+//the parts of the software renderer that need the engine's windows side (assimp and Surface)
+//kept out of SoftwareRenderer.cpp so that one builds on Linux
+
+namespace dx = DirectX;
+
+void SoftwareRenderer::LoadModel(const std::string& fileName, const dx::XMFLOAT4X4& transform)
+{
+	Assimp::Importer imp;
+
+	const auto pScene = imp.ReadFile(fileName.c_str(),
+		aiProcess_Triangulate |
+		aiProcess_JoinIdenticalVertices |
+		aiProcess_ConvertToLeftHanded |
+		aiProcess_GenNormals
+	);
+
+	if (pScene == nullptr) {
+
+		throw Exception(__LINE__, __FILE__, imp.GetErrorString());
+	}
+
+	//textures are looked up next to the model file
+	const auto slash = fileName.find_last_of("/\\");
+	const auto base = slash == std::string::npos ? std::string{} : fileName.substr(0, slash + 1);
+
+	auto loadTexture = [this, &base](const aiString& name) {
+
+		const auto path = base + name.C_Str();
+		auto& pTex = m_textureCache[path];
+
+		if (!pTex) {
+
+			pTex = std::make_shared<Texture>(Texture::FromFile(path));
+		}
+
+		return pTex;
+	};
+
+	//parse meshes the same way Model::ParseMesh does
+	std::vector<Mesh> parsed;
+	parsed.reserve(pScene->mNumMeshes);
+
+	for (unsigned int m = 0; m < pScene->mNumMeshes; m++) {
+
+		const auto& mesh = *pScene->mMeshes[m];
+		Mesh out;
+
+		out.positions.reserve(mesh.mNumVertices);
+		out.normals.reserve(mesh.mNumVertices);
+		out.texcoords.reserve(mesh.mNumVertices);
+
+		for (unsigned int i = 0; i < mesh.mNumVertices; i++) {
+
+			out.positions.push_back(*reinterpret_cast<const dx::XMFLOAT3*>(&mesh.mVertices[i]));
+			out.normals.push_back(*reinterpret_cast<const dx::XMFLOAT3*>(&mesh.mNormals[i]));
+
+			if (mesh.mTextureCoords[0] != nullptr) {
+
+				out.texcoords.push_back({ mesh.mTextureCoords[0][i].x,mesh.mTextureCoords[0][i].y });
+			}
+		}
+
+		out.indices.reserve(mesh.mNumFaces * 3);
+		for (unsigned int i = 0; i < mesh.mNumFaces; i++) {
+
+			const auto& face = mesh.mFaces[i];
+			assert(face.mNumIndices == 3);
+			out.indices.push_back(face.mIndices[0]);
+			out.indices.push_back(face.mIndices[1]);
+			out.indices.push_back(face.mIndices[2]);
+		}
+
+		if (mesh.mMaterialIndex >= 0) {
+
+			auto& material = *pScene->mMaterials[mesh.mMaterialIndex];
+			aiString texFileName;
+
+			out.material.shading = Shading::ModelPhong;
+			out.material.specularIntensity = 0.8f;
+			out.material.specularPower = 35.0f;
+
+			if (material.GetTexture(aiTextureType_DIFFUSE, 0, &texFileName) == aiReturn_SUCCESS) {
+
+				out.material.pDiffuse = loadTexture(texFileName);
+			}
+
+			if (material.GetTexture(aiTextureType_SPECULAR, 0, &texFileName) == aiReturn_SUCCESS) {
+
+				out.material.pSpecular = loadTexture(texFileName);
+				out.material.shading = Shading::ModelPhongSpecMap;
+			}
+			else {
+
+				material.Get(AI_MATKEY_SHININESS, out.material.specularPower);
+			}
+
+			//textured shaders need a diffuse map, fall back to flat phong
+			if (!out.material.pDiffuse) {
+
+				out.material.shading = Shading::Phong;
+			}
+		}
+
+		parsed.push_back(std::move(out));
+	}
+
+	//walk the node tree accumulating transforms the same way Node::Draw does
+	std::function<void(const aiNode&, dx::FXMMATRIX)> parseNode =
+		[&](const aiNode& node, dx::FXMMATRIX accumulated) {
+
+		const auto built = dx::XMMatrixTranspose(dx::XMLoadFloat4x4(
+			reinterpret_cast<const dx::XMFLOAT4X4*>(&node.mTransformation)
+		)) * accumulated;
+
+		for (unsigned int i = 0; i < node.mNumMeshes; i++) {
+
+			Mesh instance = parsed.at(node.mMeshes[i]);
+			dx::XMStoreFloat4x4(&instance.transform, built);
+			AddMesh(std::move(instance));
+		}
+
+		for (unsigned int i = 0; i < node.mNumChildren; i++) {
+
+			parseNode(*node.mChildren[i], built);
+		}
+	};
+
+	parseNode(*pScene->mRootNode, dx::XMLoadFloat4x4(&transform));
+}
+
+void SoftwareRenderer::FrameBuffer::CopyTo(Surface& surface) const noexcept
+{
+	assert(surface.GetWidth() == m_width);
+	assert(surface.GetHeight() == m_height);
+
+	//Surface::Color is the same single B8G8R8A8 dword
+	std::memcpy(surface.GetBufferPtr(), m_color.data(), m_color.size() * sizeof(uint32_t));
+}
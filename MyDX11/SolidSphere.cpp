@@ -28,16 +28,17 @@ SolidSphere::SolidSphere(Graphics& gfx, float radius)
 	AddBind(std::make_shared<PixelShader>(gfx, L"SolidPS.cso"));
 
 	//Creatre constant Buffer
-	struct PSColorConstant {
-		DirectX::XMFLOAT3 color = { 1.0f,1.0f,1.0f };
-		float padding;
-	}colorConst;
+	MyDynamicConstant::CbufLayout colorLayout;
+	colorLayout.Append(MyDynamicConstant::CbufLayout::Float4, "color");
+
+	MyDynamicConstant::CbufBuffer colorConst(std::move(colorLayout));
+	colorConst["color"] = DirectX::XMFLOAT4{ 1.0f,1.0f,1.0f,1.0f };
 
 	//Bind static constant buffer
-	AddBind(std::make_shared<PixelConstantBuffer<PSColorConstant>>(gfx, colorConst));
+	AddBind(std::make_shared<DynamicPixelConstantBuffer>(gfx, std::move(colorConst)));
 
 	//Bind static input layout
-	AddBind(std::make_shared<InputLayout>(gfx, model.vertices.GetLayout().GetD3DLayout(), pvsbc));
+	AddBind(InputLayout::Resolve(gfx, model.vertices.GetLayout().GetD3DLayout(), pvsbc));
 
 	//Bind static topology
 	AddBind(std::make_shared<Topology>(gfx, D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST));
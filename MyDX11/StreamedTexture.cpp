@@ -0,0 +1,175 @@
+#include "StreamedTexture.h"
+#include "DdsFile.h"
+#include "MipStreamer.h"
+#include "GraphicsThrowMacros.h"
+#include <algorithm>
+#include <cassert>
+#include <utility>
+#include <vector>
+
+namespace Bind {
+
+	bool StreamedTexture::CanStream(const DdsFile& file) noexcept
+	{
+		const auto& desc = file.GetDescription();
+
+		if (desc.isCubeMap) {
+
+			return false;
+		}
+
+		if (!DdsFile::IsBlockCompressed(desc.format)) {
+
+			return true;
+		}
+
+		for (unsigned int mip = 0; mip <= FindLowestMip(file); mip++) {
+
+			if ((desc.width >> mip) % 4u != 0u || (desc.height >> mip) % 4u != 0u) {
+
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	unsigned int StreamedTexture::FindLowestMip(const DdsFile& file) noexcept
+	{
+		const auto& desc = file.GetDescription();
+
+		//first level that fits, the last one when the file stops short of it
+		unsigned int mip = 0u;
+
+		while (mip + 1u < desc.mipLevels && std::max(desc.width, desc.height) >> mip > residentSize) {
+
+			mip++;
+		}
+
+		return mip;
+	}
+
+	StreamedTexture::StreamedTexture(Graphics& gfx, std::shared_ptr<const DdsFile> pFile, unsigned int slot, bool asArray)
+		:
+		m_pFile(std::move(pFile)),
+		slot(slot),
+		m_asArray(asArray),
+		m_request(MipStreamer::none)
+	{
+		assert("File cannot be streamed" && CanStream(*m_pFile));
+
+		m_lowestMip = FindLowestMip(*m_pFile);
+		m_residentMip = m_lowestMip;
+		pTextureView = CreateView(gfx, m_lowestMip);
+	}
+
+	void StreamedTexture::Bind(Graphics& gfx) noexcept
+	{
+		BindPixelView(gfx, slot, pTextureView.Get());
+	}
+
+	void StreamedTexture::Request(unsigned int mip) noexcept
+	{
+		m_request = std::min(m_request, mip);
+	}
+
+	unsigned int StreamedTexture::TakeRequest() noexcept
+	{
+		return std::exchange(m_request, MipStreamer::none);
+	}
+
+	const DdsFile& StreamedTexture::GetFile() const noexcept
+	{
+		return *m_pFile;
+	}
+
+	unsigned int StreamedTexture::GetMipCount() const noexcept
+	{
+		return m_pFile->GetDescription().mipLevels;
+	}
+
+	unsigned int StreamedTexture::GetSize() const noexcept
+	{
+		const auto& desc = m_pFile->GetDescription();
+
+		return std::max(desc.width, desc.height);
+	}
+
+	unsigned int StreamedTexture::GetLowestMip() const noexcept
+	{
+		return m_lowestMip;
+	}
+
+	unsigned int StreamedTexture::GetResidentMip() const noexcept
+	{
+		return m_residentMip;
+	}
+
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> StreamedTexture::CreateView(Graphics& gfx, unsigned int mip) const
+	{
+		//no info manager here, it belongs to the render thread
+		HRESULT hr;
+
+		const auto& desc = m_pFile->GetDescription();
+
+		D3D11_TEXTURE2D_DESC textureDesc = {};
+
+		textureDesc.Width = std::max(1u, desc.width >> mip);
+		textureDesc.Height = std::max(1u, desc.height >> mip);
+		textureDesc.MipLevels = desc.mipLevels - mip;
+		textureDesc.ArraySize = desc.arraySize;
+		textureDesc.Format = (DXGI_FORMAT)desc.format;
+		textureDesc.SampleDesc.Count = 1;
+		textureDesc.SampleDesc.Quality = 0;
+		textureDesc.Usage = D3D11_USAGE_IMMUTABLE;
+		textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+		textureDesc.CPUAccessFlags = 0;
+		textureDesc.MiscFlags = 0;
+
+		//the levels from mip down of every array item, reading them is where the file is paged in
+		std::vector<D3D11_SUBRESOURCE_DATA> sd;
+		sd.reserve((size_t)textureDesc.MipLevels * desc.arraySize);
+
+		for (unsigned int item = 0; item < desc.arraySize; item++) {
+
+			for (unsigned int level = mip; level < desc.mipLevels; level++) {
+
+				const auto& sub = m_pFile->GetSubresource(level, item);
+
+				sd.push_back({ sub.pData,(UINT)sub.rowPitch,(UINT)sub.slicePitch });
+			}
+		}
+
+		Microsoft::WRL::ComPtr<ID3D11Texture2D> pTexture;
+		GFX_THROW_NOINFO(GetDevice(gfx)->CreateTexture2D(&textureDesc, sd.data(), &pTexture));
+
+		D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+		srvDesc.Format = textureDesc.Format;
+
+		if (desc.arraySize > 1u || m_asArray) {
+
+			srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+			srvDesc.Texture2DArray.MostDetailedMip = 0;
+			srvDesc.Texture2DArray.MipLevels = textureDesc.MipLevels;
+			srvDesc.Texture2DArray.FirstArraySlice = 0;
+			srvDesc.Texture2DArray.ArraySize = desc.arraySize;
+		}
+		else {
+
+			srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+			srvDesc.Texture2D.MostDetailedMip = 0;
+			srvDesc.Texture2D.MipLevels = textureDesc.MipLevels;
+		}
+
+		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> pView;
+		GFX_THROW_NOINFO(GetDevice(gfx)->CreateShaderResourceView(pTexture.Get(), &srvDesc, &pView));
+
+		return pView;
+	}
+
+	void StreamedTexture::SetView(Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> pView, unsigned int mip) noexcept
+	{
+		pTextureView = std::move(pView);
+		m_residentMip = mip;
+	}
+}
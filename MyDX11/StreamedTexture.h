@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Bindable.h"
+#include <memory>
+
+class DdsFile;
+
+namespace Bind {
+
+	/// <summary>
+	/// Texture whose top mips come and go, fed from a mapped DDS file
+	/// every residency change builds a new texture holding only the wanted mip and the ones below it,
+	/// the shader never sees the difference since uvs are normalized
+	/// draws ask for a mip with Request, TextureStreamer decides what is actually resident
+	/// </summary>
+	class StreamedTexture :public Bindable {
+
+	public:
+
+		//levels at most this big are resident from the start and never evicted
+		static constexpr unsigned int residentSize = 64u;
+
+	public:
+
+		//cube maps are not streamed, block compressed files need whole blocks on every level that can be the top
+		static bool CanStream(const DdsFile& file) noexcept;
+
+	public:
+
+		//asArray views a single texture as an array of one, what shaders reading packed textures declare
+		StreamedTexture(Graphics& gfx, std::shared_ptr<const DdsFile> pFile, unsigned int slot = 0, bool asArray = false);
+
+		void Bind(Graphics& gfx) noexcept override;
+
+		//most detailed mip a draw this frame needs, render thread only
+		void Request(unsigned int mip) noexcept;
+		//request since the last call, MipStreamer::none when the texture was not drawn
+		unsigned int TakeRequest() noexcept;
+
+		const DdsFile& GetFile() const noexcept;
+		unsigned int GetMipCount() const noexcept;
+		//largest side of the top level, what the mip estimate scales by
+		unsigned int GetSize() const noexcept;
+		unsigned int GetLowestMip() const noexcept;
+		unsigned int GetResidentMip() const noexcept;
+
+		//view of mip and everything below it read straight from the mapped file
+		//*only uses the device (free threaded), safe to call on a job thread
+		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> CreateView(Graphics& gfx, unsigned int mip) const;
+
+		//swaps a view from CreateView in, render thread only
+		void SetView(Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> pView, unsigned int mip) noexcept;
+
+	private:
+
+		static unsigned int FindLowestMip(const DdsFile& file) noexcept;
+
+	private:
+
+		std::shared_ptr<const DdsFile> m_pFile;
+		unsigned int slot;
+		bool m_asArray;
+		unsigned int m_lowestMip = 0u;
+		unsigned int m_residentMip = 0u;
+		unsigned int m_request;
+
+		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> pTextureView;
+	};
+}
@@ -8,9 +8,18 @@ namespace Gdiplus
 }
 #include <gdiplus.h>
 #include <sstream>
+#include <iomanip>
+#include "ImageDecoder.h"
+#include "ImageEncoder.h"
+#include "JobSystem.h"
+#include "myTimer.h"
+#include "Profiler.h"
 
 #pragma comment( lib,"gdiplus.lib" )
 
+//destination texels per resample job
+constexpr size_t texelsPerJob = 64u * 1024u;
+
 Surface::Surface(unsigned int width, unsigned int height) noexcept
 	:
 	pBuffer(std::make_unique<Color[]>(width* height)),
@@ -39,7 +48,8 @@ Surface::~Surface()
 
 void Surface::Clear(Color fillValue) noexcept
 {
-	memset(pBuffer.get(), fillValue.dword, width * height * sizeof(Color));
+	//memset only repeats the low byte
+	PixelKernels::Fill(GetImage(), fillValue.dword);
 }
 
 void Surface::PutPixel(unsigned int x, unsigned int y, Color c) noexcept(!IS_DEBUG)
@@ -87,43 +97,82 @@ const Surface::Color* Surface::GetBufferPtrConst() const noexcept
 
 Surface Surface::FromFile(const std::string& name)
 {
+	PROFILE_ZONE("Surface::FromFile");
+
 	unsigned int width = 0;
 	unsigned int height = 0;
 	std::unique_ptr<Color[]> pBuffer;
 
-	{
-		// convert filenam to wide string (for Gdiplus)
-		wchar_t wideName[512];
-		mbstowcs_s(nullptr, wideName, name.c_str(), _TRUNCATE);
+	myTimer timer;
 
-		Gdiplus::Bitmap bitmap(wideName);
-		if (bitmap.GetLastStatus() != Gdiplus::Status::Ok)
-		{
-			std::stringstream ss;
-			ss << "Loading image [" << name << "]: failed to load.";
-			throw Exception(__LINE__, __FILE__, ss.str());
-		}
+	try
+	{
+		//Color is a single dword in B8G8R8A8 order, the decoder writes straight into the buffer
+		ImageDecoder::DecodeFile(name, [&](unsigned int w, unsigned int h) {
 
-		width = bitmap.GetWidth();
-		height = bitmap.GetHeight();
-		pBuffer = std::make_unique<Color[]>(width * height);
+			width = w;
+			height = h;
+			pBuffer = std::make_unique<Color[]>((size_t)width * height);
 
-		for (unsigned int y = 0; y < height; y++)
-		{
-			for (unsigned int x = 0; x < width; x++)
-			{
-				Gdiplus::Color c;
-				bitmap.GetPixel(x, y, &c);
-				pBuffer[y * width + x] = c.GetValue();
-			}
-		}
+			return reinterpret_cast<uint32_t*>(pBuffer.get());
+		});
+	}
+	catch (const ImageDecoder::Exception& e)
+	{
+		std::stringstream ss;
+		ss << "Loading image [" << name << "]: " << e.GetNote();
+		throw Exception(__LINE__, __FILE__, ss.str());
 	}
 
+	std::ostringstream oss;
+	oss << "[Surface] " << name << " " << width << "x" << height << " decoded in "
+		<< std::fixed << std::setprecision(2) << timer.Peek() * 1000.0f << " ms" << std::endl;
+
+	OutputDebugStringA(oss.str().c_str());
+
 	return Surface(width, height, std::move(pBuffer));
 }
 
-void Surface::Save(const std::string& filename) const
+std::vector<Surface> Surface::FromFiles(const std::vector<std::string>& names, JobSystem& jobs)
 {
+	std::vector<Surface> surfaces;
+	surfaces.reserve(names.size());
+
+	for (size_t i = 0; i < names.size(); i++) {
+
+		surfaces.emplace_back(0u, 0u);
+	}
+
+	//one file per job, every job writes only its own slot
+	jobs.ParallelFor(names.size(), 1u, [&](size_t first, size_t last) {
+
+		for (size_t i = first; i < last; i++) {
+
+			surfaces[i] = FromFile(names[i]);
+		}
+	});
+
+	return surfaces;
+}
+
+void Surface::Save(const std::string& filename, bool hasAlpha) const
+{
+	if (ImageEncoder::CanEncode(filename)) {
+
+		try {
+
+			ImageEncoder::EncodeFile(filename, GetImage(), hasAlpha);
+		}
+		catch (const ImageEncoder::Exception& e) {
+
+			std::stringstream ss;
+			ss << "Saving surface to [" << filename << "]: " << e.GetNote();
+			throw Exception(__LINE__, __FILE__, ss.str());
+		}
+
+		return;
+	}
+
 	auto GetEncoderClsid = [&filename](const WCHAR* format, CLSID* pClsid) -> void
 	{
 		UINT  num = 0;          // number of image encoders
@@ -190,6 +239,49 @@ void Surface::Copy(const Surface& src) noexcept(!IS_DEBUG)
 	memcpy(pBuffer.get(), src.pBuffer.get(), width * height * sizeof(Color));
 }
 
+void Surface::Blit(const Surface& src, unsigned int srcX, unsigned int srcY, unsigned int width, unsigned int height,
+	unsigned int dstX, unsigned int dstY) noexcept
+{
+	//cropping clips each rectangle to its own surface, the copy takes the overlap of the two
+	PixelKernels::Blit(src.GetImage().Crop(srcX, srcY, width, height), GetImage().Crop(dstX, dstY, width, height));
+}
+
+void Surface::SwizzleRB() noexcept
+{
+	PixelKernels::SwizzleRB(GetImage(), GetImage());
+}
+
+void Surface::Premultiply(bool isSrgb)
+{
+	PixelKernels::Premultiply(GetImage(), isSrgb);
+}
+
+Surface Surface::Resample(unsigned int width, unsigned int height, PixelKernels::Filter filter, bool isSrgb, JobSystem* pJobs) const
+{
+	const PixelKernels::Resampler resampler(this->width, this->height, width, height, filter, isSrgb);
+
+	Surface dst(width, height);
+
+	const auto src = GetImage();
+	const auto image = dst.GetImage();
+
+	if (pJobs != nullptr) {
+
+		const auto rowsPerJob = std::max<size_t>(1u, texelsPerJob / width);
+
+		pJobs->ParallelFor(height, rowsPerJob, [&](size_t first, size_t last) {
+
+			resampler.Run(src, image, (unsigned int)first, (unsigned int)last);
+		});
+	}
+	else {
+
+		resampler.Run(src, image, 0u, height);
+	}
+
+	return dst;
+}
+
 Surface::Surface(unsigned int width, unsigned int height, std::unique_ptr<Color[]> pBufferParam) noexcept
 	:
 	width(width),
@@ -197,6 +289,16 @@ Surface::Surface(unsigned int width, unsigned int height, std::unique_ptr<Color[
 	pBuffer(std::move(pBufferParam))
 {}
 
+PixelKernels::Image Surface::GetImage() noexcept
+{
+	return PixelKernels::Image(reinterpret_cast<uint32_t*>(pBuffer.get()), width, width, height);
+}
+
+PixelKernels::ConstImage Surface::GetImage() const noexcept
+{
+	return PixelKernels::ConstImage(reinterpret_cast<const uint32_t*>(pBuffer.get()), width, width, height);
+}
+
 
 //surface exception stuff
 Surface::Exception::Exception(int line, const char* file, std::string note) noexcept
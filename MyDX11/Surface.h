@@ -2,9 +2,11 @@
 
 #include "myWin.h"
 #include "myException.h"
+#include "PixelKernels.h"
 #include <string>
 #include <assert.h>
 #include <memory>
+#include <vector>
 
 class Surface {
 
@@ -130,15 +132,39 @@ public:
 	const Color* GetBufferPtr() const noexcept;
 	const Color* GetBufferPtrConst() const noexcept;
 
+	//PNG or JPEG, decoded without GDI+
 	static Surface FromFile(const std::string& name);
 
-	void Save(const std::string& filename) const;
+	//decodes the files concurrently, one job per file, surfaces come back in the same order
+	static std::vector<Surface> FromFiles(const std::vector<std::string>& names, class JobSystem& jobs);
+
+	//.png and .qoi go through ImageEncoder, anything else is written as a BMP through GDI+
+	//*without alpha PNG and QOI store RGB, a BMP always keeps all four channels
+	void Save(const std::string& filename, bool hasAlpha = true) const;
 	void Copy(const Surface& src) noexcept(!IS_DEBUG);
 
+	//copies a width x height rectangle of src to (dstX,dstY), clipped to both surfaces
+	void Blit(const Surface& src, unsigned int srcX, unsigned int srcY, unsigned int width, unsigned int height,
+		unsigned int dstX, unsigned int dstY) noexcept;
+
+	//BGRA <-> RGBA in place, for APIs that want the other byte order
+	void SwizzleRB() noexcept;
+
+	//color times alpha, in linear light when isSrgb
+	void Premultiply(bool isSrgb);
+
+	//a new surface of any size, filtered in linear light when isSrgb
+	//*rows are split across the job system when one is given
+	Surface Resample(unsigned int width, unsigned int height, PixelKernels::Filter filter, bool isSrgb, class JobSystem* pJobs = nullptr) const;
+
 private:
 
 	Surface(unsigned int width, unsigned int height, std::unique_ptr<Color[]> pBufferParam) noexcept;
 
+	//Color is a single dword in B8G8R8A8 order, the kernels work on the raw texels
+	PixelKernels::Image GetImage() noexcept;
+	PixelKernels::ConstImage GetImage() const noexcept;
+
 private:
 
 	std::unique_ptr<Color[]> pBuffer;
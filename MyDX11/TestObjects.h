@@ -1,9 +1,12 @@
 #pragma once
 
-#include "Drawable.h"
-#include "myMath.h"
+#include "InstancedMesh.h"
+#include "InstanceBatcher.h"
+#include "ObjectSimulation.h"
+#include <random>
 
-class TestObject :public Drawable {
+//animated object drawn through its (shared) instanced mesh
+class TestObject {
 
 public:
 
@@ -13,64 +16,58 @@ public:
 		std::uniform_real_distribution<float>& ddist,
 		std::uniform_real_distribution<float>& odist,
 		std::uniform_real_distribution<float>& rdist)
-		:
-		r(rdist(rng)),
-		droll(ddist(rng)),
-		dpitch(ddist(rng)),
-		dyaw(ddist(rng)),
-		dphi(odist(rng)),
-		dtheta(odist(rng)),
-		dchi(odist(rng)),
-		chi(adist(rng)),
-		theta(adist(rng)),
-		phi(adist(rng))
-	{}
-
-	void Update(float dt) noexcept {
-
-		//get delta time(dt) to update the angles
-		roll = wrap_angle(roll + droll * dt);
-		pitch = wrap_angle(pitch + dpitch * dt);
-		yaw = wrap_angle(yaw + dyaw * dt);
+	{
+		motion.r = rdist(rng);
+		motion.droll = ddist(rng);
+		motion.dpitch = ddist(rng);
+		motion.dyaw = ddist(rng);
+		motion.dphi = odist(rng);
+		motion.dtheta = odist(rng);
+		motion.dchi = odist(rng);
+		motion.chi = adist(rng);
+		motion.theta = adist(rng);
+		motion.phi = adist(rng);
+	}
 
-		theta = wrap_angle(theta + dtheta * dt);
-		phi = wrap_angle(phi + dphi * dt);
-		chi = wrap_angle(chi + dchi * dt);
+	TestObject(const TestObject&) = delete;
+	virtual ~TestObject() = default;
 
+	//starting state handed to the ObjectSimulation, which animates the object from then on
+	const ObjectSimulation::Motion& GetSpawnMotion() const noexcept
+	{
+		return motion;
 	}
 
-	DirectX::XMMATRIX GetTransformXM() const noexcept
+	//radius of a sphere around the origin containing the mesh (prism/cone shapes are within 1 of the z axis, z in [-1,1])
+	virtual float GetBoundingRadius() const noexcept
 	{
-		return DirectX::XMMatrixRotationRollPitchYaw(pitch, yaw, roll) *
-			   DirectX::XMMatrixTranslation(r, 0.0f, 0.0f) *
-			   DirectX::XMMatrixRotationRollPitchYaw(theta, phi, chi);
+		return 1.415f;
 	}
 
-protected:
+	//geometry shared by every object that looks the same (used as the instance group key)
+	const InstancedMesh& GetMesh() const noexcept
+	{
+		return *pMesh;
+	}
 
-	//positional
-	float r;
+	//fill this object's slot in the instance buffer (world comes from the simulation)
+	virtual void WriteInstance(InstanceData& instance, DirectX::FXMMATRIX world) const noexcept
+	{
+		DirectX::XMStoreFloat4x4(&instance.transform, world);
+	}
 
-	//angles
-	float roll = 0.0f;
-	float pitch = 0.0f;
-	float yaw = 0.0f;
+	//cube with sides of 1 the occlusion culler draws in place of the object, false for shapes that don't fill one
+	virtual bool GetOccluderBox(DirectX::FXMMATRIX world, DirectX::XMFLOAT4X4& box) const noexcept
+	{
+		return false;
+	}
 
-	//*position
-	float theta;
-	float phi;
-	float chi;
+protected:
 
-	//angular speed(delta/s)
+	std::shared_ptr<InstancedMesh> pMesh;
 
-	//*rotation about the box center
-	float droll;
-	float dpitch;
-	float dyaw;
+private:
 
-	//*rotation about the about the center of the world space
-	float dtheta;
-	float dphi;
-	float dchi;
+	ObjectSimulation::Motion motion;
 
 };
\ No newline at end of file
@@ -1,20 +1,53 @@
 #include "Texture.h"
-#include "Surface.h"
+#include "MipChain.h"
+#include "CompressedTexture.h"
+#include "DdsFile.h"
 #include "GraphicsThrowMacros.h"
 
+namespace {
+
+	DXGI_FORMAT ToDxgiFormat(BcFormat format) noexcept
+	{
+		switch (format)
+		{
+		case BcFormat::BC1:
+
+			return DXGI_FORMAT_BC1_UNORM;
+
+		case BcFormat::BC3:
+
+			return DXGI_FORMAT_BC3_UNORM;
+
+		case BcFormat::BC4:
+
+			return DXGI_FORMAT_BC4_UNORM;
+
+		case BcFormat::BC5:
+
+			return DXGI_FORMAT_BC5_UNORM;
+
+		case BcFormat::BC7:
+
+			return DXGI_FORMAT_BC7_UNORM;
+		}
+
+		return DXGI_FORMAT_UNKNOWN;
+	}
+}
+
 namespace Bind {
 
-	Texture::Texture(Graphics& gfx, const Surface& s,unsigned int slot)
+	Texture::Texture(Graphics& gfx, const MipChain& mips,unsigned int slot)
 		:slot(slot)
 	{
-		INFOMAN(gfx);
-
 		//Create texture resources
 		D3D11_TEXTURE2D_DESC textureDesc = {};
 
-		textureDesc.Width = s.GetWidth();
-		textureDesc.Height = s.GetHeight();
-		textureDesc.MipLevels = 1;
+		const auto& top = mips.GetLevel(0);
+
+		textureDesc.Width = top.GetWidth();
+		textureDesc.Height = top.GetHeight();
+		textureDesc.MipLevels = (UINT)mips.GetLevelCount();
 		textureDesc.ArraySize = 1;
 		textureDesc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
 		textureDesc.SampleDesc.Count = 1;
@@ -24,34 +57,143 @@ namespace Bind {
 		textureDesc.CPUAccessFlags = 0;
 		textureDesc.MiscFlags = 0;
 
-		//
-		D3D11_SUBRESOURCE_DATA sd = {};
-		sd.pSysMem = s.GetBufferPtr();
-		sd.SysMemPitch = s.GetWidth() * sizeof(Surface::Color);
+		//one subresource per mip level
+		std::vector<D3D11_SUBRESOURCE_DATA> sd(mips.GetLevelCount());
+
+		for (size_t i = 0; i < sd.size(); i++) {
+
+			const auto& level = mips.GetLevel(i);
+
+			sd[i].pSysMem = level.GetBufferPtr();
+			sd[i].SysMemPitch = level.GetWidth() * sizeof(Surface::Color);
+		}
+
+		CreateView(gfx, textureDesc, sd.data());
+	}
+
+	Texture::Texture(Graphics& gfx, const CompressedTexture& compressed, unsigned int slot)
+		:slot(slot)
+	{
+		D3D11_TEXTURE2D_DESC textureDesc = {};
+
+		const auto& top = compressed.GetLevel(0);
+
+		textureDesc.Width = top.width;
+		textureDesc.Height = top.height;
+		textureDesc.MipLevels = (UINT)compressed.GetLevelCount();
+		textureDesc.ArraySize = 1;
+		textureDesc.Format = ToDxgiFormat(compressed.GetFormat());
+		textureDesc.SampleDesc.Count = 1;
+		textureDesc.SampleDesc.Quality = 0;
+		textureDesc.Usage = D3D11_USAGE_DEFAULT;
+		textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+		textureDesc.CPUAccessFlags = 0;
+		textureDesc.MiscFlags = 0;
+
+		//pitch is one row of 4x4 blocks, not one row of texels
+		std::vector<D3D11_SUBRESOURCE_DATA> sd(compressed.GetLevelCount());
+
+		for (size_t i = 0; i < sd.size(); i++) {
+
+			const auto& level = compressed.GetLevel(i);
+
+			sd[i].pSysMem = level.blocks.data();
+			sd[i].SysMemPitch = (UINT)BcEncoder::GetRowPitch(compressed.GetFormat(), level.width);
+		}
+
+		CreateView(gfx, textureDesc, sd.data());
+	}
+
+	Texture::Texture(Graphics& gfx, const DdsFile& dds, unsigned int slot, bool asArray)
+		:slot(slot)
+	{
+		const auto& desc = dds.GetDescription();
+
+		D3D11_TEXTURE2D_DESC textureDesc = {};
+
+		textureDesc.Width = desc.width;
+		textureDesc.Height = desc.height;
+		textureDesc.MipLevels = desc.mipLevels;
+		textureDesc.ArraySize = desc.arraySize;
+		//DdsFormat carries the DXGI_FORMAT numbers
+		textureDesc.Format = (DXGI_FORMAT)desc.format;
+		textureDesc.SampleDesc.Count = 1;
+		textureDesc.SampleDesc.Quality = 0;
+		textureDesc.Usage = D3D11_USAGE_DEFAULT;
+		textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+		textureDesc.CPUAccessFlags = 0;
+		textureDesc.MiscFlags = desc.isCubeMap ? D3D11_RESOURCE_MISC_TEXTURECUBE : 0;
+
+		//the file keeps the subresources in D3D11CalcSubresource order already
+		const auto& subresources = dds.GetSubresources();
+		std::vector<D3D11_SUBRESOURCE_DATA> sd(subresources.size());
+
+		for (size_t i = 0; i < sd.size(); i++) {
+
+			sd[i].pSysMem = subresources[i].pData;
+			sd[i].SysMemPitch = (UINT)subresources[i].rowPitch;
+			sd[i].SysMemSlicePitch = (UINT)subresources[i].slicePitch;
+		}
+
+		CreateView(gfx, textureDesc, sd.data(), asArray);
+	}
+
+	void Texture::CreateView(Graphics& gfx, const D3D11_TEXTURE2D_DESC& textureDesc, const D3D11_SUBRESOURCE_DATA* pInitialData, bool asArray)
+	{
+		INFOMAN(gfx);
 
 		Microsoft::WRL::ComPtr<ID3D11Texture2D> pTexture;
 		GFX_THROW_INFO(GetDevice(gfx)->CreateTexture2D(
-			&textureDesc, &sd, &pTexture
+			&textureDesc, pInitialData, &pTexture
 		));
 
 		// create the resource view on the texture
 		D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
 		srvDesc.Format = textureDesc.Format;
-		srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-		srvDesc.Texture2D.MostDetailedMip = 0;
-		srvDesc.Texture2D.MipLevels = 1;
+
+		//the view follows the shape of the texture
+		if (textureDesc.MiscFlags & D3D11_RESOURCE_MISC_TEXTURECUBE) {
+
+			if (textureDesc.ArraySize > 6u) {
+
+				srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURECUBEARRAY;
+				srvDesc.TextureCubeArray.MostDetailedMip = 0;
+				srvDesc.TextureCubeArray.MipLevels = textureDesc.MipLevels;
+				srvDesc.TextureCubeArray.First2DArrayFace = 0;
+				srvDesc.TextureCubeArray.NumCubes = textureDesc.ArraySize / 6u;
+			}
+			else {
+
+				srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURECUBE;
+				srvDesc.TextureCube.MostDetailedMip = 0;
+				srvDesc.TextureCube.MipLevels = textureDesc.MipLevels;
+			}
+		}
+		else if (textureDesc.ArraySize > 1u || asArray) {
+
+			srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+			srvDesc.Texture2DArray.MostDetailedMip = 0;
+			srvDesc.Texture2DArray.MipLevels = textureDesc.MipLevels;
+			srvDesc.Texture2DArray.FirstArraySlice = 0;
+			srvDesc.Texture2DArray.ArraySize = textureDesc.ArraySize;
+		}
+		else {
+
+			srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+			srvDesc.Texture2D.MostDetailedMip = 0;
+			srvDesc.Texture2D.MipLevels = textureDesc.MipLevels;
+		}
 
 
 		GFX_THROW_INFO(GetDevice(gfx)->CreateShaderResourceView(
 			pTexture.Get(), &srvDesc, &pTextureView
 		));
-
 	}
 
 	void Texture::Bind(Graphics& gfx) noexcept
 	{
 
-		GetContext(gfx)->PSSetShaderResources(slot, 1u, pTextureView.GetAddressOf());
+		BindPixelView(gfx, slot, pTextureView.Get());
 	}
 
 
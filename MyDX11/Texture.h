@@ -2,7 +2,9 @@
 
 #include "Bindable.h"
 
-class Surface;
+class MipChain;
+class CompressedTexture;
+class DdsFile;
 
 namespace Bind {
 
@@ -10,10 +12,22 @@ namespace Bind {
 
 	public:
 
-		Texture(Graphics& gfx, const class Surface& s,unsigned int slot=0);
+		//uploads every level of the chain
+		Texture(Graphics& gfx, const class MipChain& mips,unsigned int slot=0);
+
+		//uploads the blocks as they are, the format comes from the encoder
+		Texture(Graphics& gfx, const CompressedTexture& compressed,unsigned int slot=0);
+
+		//every subresource is read straight out of the mapped file, arrays and cube maps keep their shape
+		//asArray views a single texture as an array of one, what shaders reading packed textures declare
+		Texture(Graphics& gfx, const DdsFile& dds,unsigned int slot=0,bool asArray=false);
 
 		void Bind(Graphics& gfx) noexcept override;
 
+	private:
+
+		void CreateView(Graphics& gfx, const D3D11_TEXTURE2D_DESC& textureDesc, const D3D11_SUBRESOURCE_DATA* pInitialData, bool asArray = false);
+
 	private:
 
 		unsigned int slot;
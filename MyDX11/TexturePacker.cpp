@@ -0,0 +1,473 @@
+#include "TexturePacker.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cassert>
+
+//D3D11_REQ_TEXTURE2D_ARRAY_AXIS_DIMENSION
+constexpr size_t maxArraySize = 2048u;
+
+static unsigned int RoundUp(unsigned int value, unsigned int multiple) noexcept {
+
+	return (value + multiple - 1u) / multiple * multiple;
+}
+
+static unsigned int Log2(unsigned int value) noexcept {
+
+	unsigned int log = 0u;
+
+	while (value >>= 1u) {
+
+		log++;
+	}
+
+	return log;
+}
+
+void TexturePacker::RemapUv(const UvTransform& transform, float& u, float& v) noexcept
+{
+	u = (u - std::floor(u)) * transform.scaleU + transform.offsetU;
+	v = (v - std::floor(v)) * transform.scaleV + transform.offsetV;
+}
+
+TexturePacker::TexturePacker() noexcept
+	:
+	TexturePacker(Config{})
+{}
+
+TexturePacker::TexturePacker(Config config) noexcept
+	:
+	m_config(config)
+{
+	assert("Atlas gutter must be a power of two" && config.gutter > 0u && (config.gutter & (config.gutter - 1u)) == 0u);
+}
+
+void TexturePacker::Pack(const std::vector<Item>& items)
+{
+	m_items = items;
+	m_placements.assign(items.size(), Placement{});
+	m_groups.clear();
+
+	//first appearance order so the same model always packs the same way
+	const auto bucket = [this](std::vector<std::vector<size_t>>& buckets, size_t i, auto&& isSame) {
+
+		for (auto& members : buckets) {
+
+			if (isSame(m_items[members.front()], m_items[i])) {
+
+				members.push_back(i);
+				return;
+			}
+		}
+
+		buckets.push_back({ i });
+	};
+
+	//identical textures become slices of one array
+	std::vector<std::vector<size_t>> arrays;
+
+	for (size_t i = 0; i < m_items.size(); i++) {
+
+		bucket(arrays, i, [](const Item& a, const Item& b) {
+
+			return a.format == b.format && a.key == b.key && a.width == b.width && a.height == b.height && a.mipLevels == b.mipLevels;
+		});
+	}
+
+	std::vector<size_t> leftovers;
+
+	for (const auto& members : arrays) {
+
+		if (members.size() < 2u) {
+
+			leftovers.push_back(members.front());
+			continue;
+		}
+
+		for (size_t first = 0; first < members.size(); first += maxArraySize) {
+
+			const auto& item = m_items[members[first]];
+
+			Group group = { false,item.format,item.key,item.width,item.height,item.mipLevels,{} };
+
+			for (size_t i = first; i < std::min(members.size(), first + maxArraySize); i++) {
+
+				m_placements[members[i]].group = m_groups.size();
+				m_placements[members[i]].slice = (unsigned int)group.items.size();
+				group.items.push_back(members[i]);
+			}
+
+			m_groups.push_back(std::move(group));
+		}
+	}
+
+	//the rest of each format shares atlas pages
+	std::vector<std::vector<size_t>> atlases;
+	const unsigned int gutter = m_config.gutter;
+
+	for (const auto i : leftovers) {
+
+		const auto& item = m_items[i];
+
+		//the cell (item rounded up plus one gutter) has to fit with the page's far border
+		if (RoundUp(item.width, gutter) + 2u * gutter > m_config.maxAtlasSize ||
+			RoundUp(item.height, gutter) + 2u * gutter > m_config.maxAtlasSize) {
+
+			continue;
+		}
+
+		bucket(atlases, i, [](const Item& a, const Item& b) {
+
+			return a.format == b.format && a.key == b.key;
+		});
+	}
+
+	for (auto candidates : atlases) {
+
+		while (candidates.size() >= 2u) {
+
+			//smallest power of two square that could hold every cell, doubled until they fit or the page is full
+			size_t area = 0u;
+			unsigned int largest = 0u;
+
+			for (const auto i : candidates) {
+
+				const unsigned int cellWidth = RoundUp(m_items[i].width, gutter) + gutter;
+				const unsigned int cellHeight = RoundUp(m_items[i].height, gutter) + gutter;
+
+				area += (size_t)cellWidth * cellHeight;
+				largest = std::max({ largest,cellWidth,cellHeight });
+			}
+
+			const unsigned int needed = std::max((unsigned int)std::ceil(std::sqrt((double)area)), largest) + gutter;
+			unsigned int size = 1u;
+
+			while (size < needed && size < m_config.maxAtlasSize) {
+
+				size <<= 1u;
+			}
+
+			size = std::min(size, m_config.maxAtlasSize);
+
+			std::vector<size_t> rest;
+
+			while (true) {
+
+				rest = PackPage(m_groups.size(), candidates, size);
+
+				if (rest.empty() || size >= m_config.maxAtlasSize) {
+
+					break;
+				}
+
+				size = std::min(size << 1u, m_config.maxAtlasSize);
+			}
+
+			std::vector<size_t> placed;
+
+			for (const auto i : candidates) {
+
+				if (std::find(rest.begin(), rest.end(), i) == rest.end()) {
+
+					placed.push_back(i);
+				}
+			}
+
+			//a page holding one item saves nothing, that item stays on its own
+			if (placed.size() < 2u) {
+
+				for (const auto i : placed) {
+
+					m_placements[i] = Placement{};
+				}
+
+				candidates = std::move(rest);
+				continue;
+			}
+
+			const bool isCompressed = DdsFile::IsBlockCompressed(m_items[placed.front()].format);
+
+			//every level keeps the gutter two texels (two blocks for BCn) wide, so each neighbour gets its own half
+			const unsigned int unit = isCompressed ? 4u : 1u;
+			unsigned int mipLevels = gutter >= 2u * unit ? Log2(gutter) - Log2(unit) : 1u;
+
+			for (const auto i : placed) {
+
+				mipLevels = std::min(mipLevels, m_items[i].mipLevels);
+			}
+
+			const auto& first = m_items[placed.front()];
+
+			m_groups.push_back({ true,first.format,first.key,size,size,mipLevels,std::move(placed) });
+
+			candidates = std::move(rest);
+		}
+	}
+}
+
+const std::vector<TexturePacker::Group>& TexturePacker::GetGroups() const noexcept
+{
+	return m_groups;
+}
+
+const TexturePacker::Placement& TexturePacker::GetPlacement(size_t item) const noexcept(!IS_DEBUG)
+{
+	assert("Unknown packed item" && item < m_placements.size());
+
+	return m_placements[item];
+}
+
+std::vector<size_t> TexturePacker::PackPage(size_t group, std::vector<size_t> items, unsigned int size)
+{
+	const unsigned int gutter = m_config.gutter;
+
+	//cells start on the gutter grid, so every item offset stays a whole block on every atlas mip
+	const unsigned int usable = size - gutter;
+
+	//tallest first keeps the skyline flat
+	std::stable_sort(items.begin(), items.end(), [this](size_t a, size_t b) {
+
+		return m_items[a].height != m_items[b].height ? m_items[a].height > m_items[b].height : m_items[a].width > m_items[b].width;
+	});
+
+	struct Segment {
+
+		unsigned int x;
+		unsigned int y;
+		unsigned int width;
+	};
+
+	std::vector<Segment> skyline = { { 0u,0u,usable } };
+	std::vector<size_t> rest;
+
+	for (const auto i : items) {
+
+		m_placements[i] = Placement{};
+
+		const unsigned int cellWidth = RoundUp(m_items[i].width, gutter) + gutter;
+		const unsigned int cellHeight = RoundUp(m_items[i].height, gutter) + gutter;
+
+		//lowest top edge wins, then leftmost
+		size_t best = skyline.size();
+		unsigned int bestY = 0u;
+
+		for (size_t s = 0; s < skyline.size(); s++) {
+
+			if (skyline[s].x + cellWidth > usable) {
+
+				break;
+			}
+
+			unsigned int y = 0u;
+			unsigned int covered = 0u;
+
+			for (size_t t = s; covered < cellWidth; t++) {
+
+				y = std::max(y, skyline[t].y);
+				covered += skyline[t].width;
+			}
+
+			if (y + cellHeight <= usable && (best == skyline.size() || y < bestY)) {
+
+				best = s;
+				bestY = y;
+			}
+		}
+
+		if (best == skyline.size()) {
+
+			rest.push_back(i);
+			continue;
+		}
+
+		const unsigned int x = skyline[best].x;
+
+		auto& placement = m_placements[i];
+		placement.group = group;
+		placement.x = x + gutter;
+		placement.y = bestY + gutter;
+		placement.uv.scaleU = (float)m_items[i].width / size;
+		placement.uv.scaleV = (float)m_items[i].height / size;
+		placement.uv.offsetU = (float)placement.x / size;
+		placement.uv.offsetV = (float)placement.y / size;
+
+		//raise the skyline under the cell and cut away what it covers
+		skyline.insert(skyline.begin() + best, { x,bestY + cellHeight,cellWidth });
+
+		for (size_t s = best + 1u; s < skyline.size();) {
+
+			const unsigned int end = x + cellWidth;
+
+			if (skyline[s].x >= end) {
+
+				break;
+			}
+
+			const unsigned int cut = end - skyline[s].x;
+
+			if (cut >= skyline[s].width) {
+
+				skyline.erase(skyline.begin() + s);
+				continue;
+			}
+
+			skyline[s].x += cut;
+			skyline[s].width -= cut;
+			break;
+		}
+
+		for (size_t s = 0; s + 1u < skyline.size();) {
+
+			if (skyline[s].y == skyline[s + 1u].y) {
+
+				skyline[s].width += skyline[s + 1u].width;
+				skyline.erase(skyline.begin() + s + 1u);
+			}
+			else {
+
+				s++;
+			}
+		}
+	}
+
+	return rest;
+}
+
+void TexturePacker::Bake(size_t group, const std::vector<const DdsFile*>& files, const std::string& path) const
+{
+	assert("Unknown packed group" && group < m_groups.size());
+
+	const auto& packed = m_groups[group];
+
+	if (files.size() != packed.items.size()) {
+
+		throw DdsFile::Exception(__LINE__, __FILE__, "Packed texture [" + path + "] needs " + std::to_string(packed.items.size()) +
+			" files, got " + std::to_string(files.size()));
+	}
+
+	for (size_t i = 0; i < files.size(); i++) {
+
+		const auto& desc = files[i]->GetDescription();
+		const auto& item = m_items[packed.items[i]];
+
+		if (desc.format != item.format || desc.width != item.width || desc.height != item.height ||
+			desc.mipLevels < packed.mipLevels || desc.arraySize != 1u || desc.isCubeMap) {
+
+			throw DdsFile::Exception(__LINE__, __FILE__, "File " + std::to_string(i) + " of packed texture [" + path + "] does not match what was packed");
+		}
+	}
+
+	if (packed.isAtlas) {
+
+		ComposeAtlas(packed, files, path);
+		return;
+	}
+
+	//slices go straight from each member's mapping to the file
+	DdsFile::Description desc;
+	desc.format = packed.format;
+	desc.width = packed.width;
+	desc.height = packed.height;
+	desc.mipLevels = packed.mipLevels;
+	desc.arraySize = (unsigned int)files.size();
+
+	std::vector<DdsFile::Subresource> subresources;
+	subresources.reserve(files.size() * packed.mipLevels);
+
+	for (const auto pFile : files) {
+
+		for (unsigned int mip = 0; mip < packed.mipLevels; mip++) {
+
+			subresources.push_back(pFile->GetSubresource(mip));
+		}
+	}
+
+	DdsFile::Write(path, desc, subresources);
+}
+
+void TexturePacker::ComposeAtlas(const Group& group, const std::vector<const DdsFile*>& files, const std::string& path) const
+{
+	//copies go in whole texels, or whole 4x4 blocks for BCn
+	const bool isCompressed = DdsFile::IsBlockCompressed(group.format);
+	const unsigned int unit = isCompressed ? 4u : 1u;
+	const size_t unitBytes = isCompressed ? DdsFile::GetBitsPerTexel(group.format) * 2u : DdsFile::GetBitsPerTexel(group.format) / 8u;
+
+	std::vector<std::vector<uint8_t>> levels(group.mipLevels);
+	std::vector<DdsFile::Subresource> subresources;
+
+	for (unsigned int mip = 0; mip < group.mipLevels; mip++) {
+
+		const unsigned int size = std::max(1u, group.width >> mip);
+		const size_t rowPitch = DdsFile::GetRowPitch(group.format, size);
+		const unsigned int rows = DdsFile::GetRowCount(group.format, size);
+		const unsigned int columns = (unsigned int)(rowPitch / unitBytes);
+
+		auto& level = levels[mip];
+		level.assign(rowPitch * rows, 0u);
+
+		const auto at = [&](unsigned int column, unsigned int row) {
+
+			return level.data() + row * rowPitch + column * unitBytes;
+		};
+
+		//half the gutter each side, neighbours never write over each other
+		//*for BCn the edge block is repeated whole, close enough to the edge colour without decoding
+		const unsigned int spread = std::max(1u, (m_config.gutter >> mip) / unit / 2u);
+
+		for (size_t i = 0; i < files.size(); i++) {
+
+			const auto& src = files[i]->GetSubresource(mip);
+			const auto& placement = m_placements[group.items[i]];
+
+			const unsigned int left = (placement.x >> mip) / unit;
+			const unsigned int top = (placement.y >> mip) / unit;
+			const unsigned int width = std::min((unsigned int)(DdsFile::GetRowPitch(group.format, src.width) / unitBytes), columns - left);
+			const unsigned int height = std::min(DdsFile::GetRowCount(group.format, src.height), rows - top);
+
+			//a level rounds the item's size down while its uvs still span the unrounded size,
+			//so the far edges are repeated across the rest of the cell as well
+			const auto& item = m_items[group.items[i]];
+			const unsigned int spreadRight = (RoundUp(item.width, m_config.gutter) >> mip) / unit - width + spread;
+			const unsigned int spreadBottom = (RoundUp(item.height, m_config.gutter) >> mip) / unit - height + spread;
+
+			for (unsigned int row = 0; row < height; row++) {
+
+				std::memcpy(at(left, top + row), src.pData + row * src.rowPitch, width * unitBytes);
+
+				for (unsigned int s = 1; s <= spread && s <= left; s++) {
+
+					std::memcpy(at(left - s, top + row), at(left, top + row), unitBytes);
+				}
+
+				for (unsigned int s = 1; s <= spreadRight && left + width - 1u + s < columns; s++) {
+
+					std::memcpy(at(left + width - 1u + s, top + row), at(left + width - 1u, top + row), unitBytes);
+				}
+			}
+
+			//rows are repeated after the columns so the corners get filled too
+			const unsigned int first = left - std::min(left, spread);
+			const unsigned int count = std::min(columns, left + width + spreadRight) - first;
+
+			for (unsigned int s = 1; s <= spread && s <= top; s++) {
+
+				std::memcpy(at(first, top - s), at(first, top), count * unitBytes);
+			}
+
+			for (unsigned int s = 1; s <= spreadBottom && top + height - 1u + s < rows; s++) {
+
+				std::memcpy(at(first, top + height - 1u + s), at(first, top + height - 1u), count * unitBytes);
+			}
+		}
+
+		subresources.push_back({ level.data(),size,size,rowPitch,level.size() });
+	}
+
+	DdsFile::Description desc;
+	desc.format = group.format;
+	desc.width = group.width;
+	desc.height = group.height;
+	desc.mipLevels = group.mipLevels;
+
+	DdsFile::Write(path, desc, subresources);
+}
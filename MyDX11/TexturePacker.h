@@ -0,0 +1,112 @@
+#pragma once
+
+#include "BuildConfig.h"
+#include "DdsFile.h"
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+/// <summary>
+/// Groups textures so meshes sharing a group share one bind
+/// same size, format and mip count go into a texture array, leftovers of one format are bin packed into padded atlas pages
+/// every item gets the slice it lives in and the uv transform from its own uvs to the group's
+/// works on sizes and DDS bytes only so it builds and runs without windows
+/// </summary>
+class TexturePacker {
+
+public:
+
+	static constexpr size_t none = SIZE_MAX;
+
+	struct Config {
+
+		//largest atlas page, items that do not fit next to their gutters stay on their own
+		unsigned int maxAtlasSize = 4096u;
+
+		//texels between atlas items and around the page, a power of two
+		//*every atlas mip keeps it at least two texels (two blocks for BCn) wide, so it also caps the atlas mip count
+		unsigned int gutter = 32u;
+	};
+
+	struct Item {
+
+		unsigned int width;
+		unsigned int height;
+		unsigned int mipLevels;
+		DdsFormat format;
+
+		//only items with the same key share a group (which slot they are bound to for example)
+		uint32_t key = 0u;
+	};
+
+	//packed uv = frac(uv) * scale + offset
+	struct UvTransform {
+
+		float scaleU = 1.0f;
+		float scaleV = 1.0f;
+		float offsetU = 0.0f;
+		float offsetV = 0.0f;
+	};
+
+	struct Placement {
+
+		//none when the item was left on its own
+		size_t group = none;
+		unsigned int slice = 0u;
+
+		//top left texel of the item in an atlas page
+		unsigned int x = 0u;
+		unsigned int y = 0u;
+
+		UvTransform uv;
+	};
+
+	struct Group {
+
+		bool isAtlas;
+		DdsFormat format;
+		uint32_t key;
+		unsigned int width;
+		unsigned int height;
+		unsigned int mipLevels;
+
+		//item indices, slice order for an array
+		std::vector<size_t> items;
+	};
+
+public:
+
+	//item's own uv to the packed texture, frac keeps wrapping uvs inside the item's rectangle
+	static void RemapUv(const UvTransform& transform, float& u, float& v) noexcept;
+
+public:
+
+	TexturePacker() noexcept;
+	explicit TexturePacker(Config config) noexcept;
+
+	//replaces whatever an earlier call packed
+	void Pack(const std::vector<Item>& items);
+
+	const std::vector<Group>& GetGroups() const noexcept;
+	const Placement& GetPlacement(size_t item) const noexcept(!IS_DEBUG);
+
+	//writes one group as a DDS, files[i] holds the item group.items[i]
+	//an array takes every member's levels straight from its mapping, an atlas is composed level by level
+	//and each item's edge is repeated into half the gutter on every side so filtering never reaches a neighbour
+	void Bake(size_t group, const std::vector<const DdsFile*>& files, const std::string& path) const;
+
+private:
+
+	//skyline bin packing of one atlas page, returns the items that did not fit
+	std::vector<size_t> PackPage(size_t group, std::vector<size_t> items, unsigned int size);
+
+	void ComposeAtlas(const Group& group, const std::vector<const DdsFile*>& files, const std::string& path) const;
+
+private:
+
+	Config m_config;
+	std::vector<Item> m_items;
+	std::vector<Placement> m_placements;
+	std::vector<Group> m_groups;
+};
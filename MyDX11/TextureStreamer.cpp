@@ -0,0 +1,178 @@
+#include "TextureStreamer.h"
+#include "DdsFile.h"
+#include "imgui/imgui.h"
+#include <algorithm>
+
+TextureStreamer::TextureStreamer(JobSystem& jobs, size_t budget)
+	:
+	m_jobs(jobs),
+	m_budget(budget)
+{
+	MipStreamer::Config config;
+	config.budget = budget;
+
+	m_policy = MipStreamer(config);
+}
+
+TextureStreamer::~TextureStreamer()
+{
+	for (auto& pLoad : m_loadPtrs) {
+
+		m_jobs.Wait(pLoad->counter);
+	}
+}
+
+void TextureStreamer::Register(std::shared_ptr<Bind::StreamedTexture> pTexture, std::string name)
+{
+	const auto& file = pTexture->GetFile();
+	const auto& desc = file.GetDescription();
+
+	//a level costs all of its array items
+	std::vector<size_t> mipBytes(desc.mipLevels, 0u);
+
+	for (unsigned int item = 0; item < desc.arraySize; item++) {
+
+		for (unsigned int mip = 0; mip < desc.mipLevels; mip++) {
+
+			mipBytes[mip] += file.GetSubresource(mip, item).slicePitch;
+		}
+	}
+
+	m_policy.Register(std::move(mipBytes), pTexture->GetLowestMip());
+
+	m_texturePtrs.push_back(std::move(pTexture));
+	m_names.push_back(std::move(name));
+}
+
+void TextureStreamer::Update(Graphics& gfx)
+{
+	//finished views go in, a failed one leaves the texture as it was
+	for (auto i = m_loadPtrs.begin(); i != m_loadPtrs.end();) {
+
+		auto& load = **i;
+
+		if (!load.counter.IsDone()) {
+
+			i++;
+			continue;
+		}
+
+		auto& texture = *m_texturePtrs[load.id];
+
+		if (load.pView) {
+
+			texture.SetView(std::move(load.pView), load.mip);
+		}
+
+		m_policy.Complete(load.id, texture.GetResidentMip());
+		i = m_loadPtrs.erase(i);
+	}
+
+	for (size_t i = 0; i < m_texturePtrs.size(); i++) {
+
+		const auto mip = m_texturePtrs[i]->TakeRequest();
+
+		if (mip != MipStreamer::none) {
+
+			m_policy.Request(i, mip);
+		}
+	}
+
+	m_policy.SetBudget(m_budget.load());
+
+	for (const auto& transition : m_policy.Update()) {
+
+		auto pLoad = std::make_unique<Load>();
+		pLoad->id = transition.id;
+		pLoad->mip = transition.mip;
+
+		//the texture and the load outlive the job, the destructor waits for it
+		m_jobs.Run([&gfx, pTexture = m_texturePtrs[transition.id].get(), pLoad = pLoad.get()]() {
+
+			try {
+
+				pLoad->pView = pTexture->CreateView(gfx, pLoad->mip);
+			}
+			catch (const std::exception&) {
+
+				//out of memory or device lost, no view tells Update the load failed
+			}
+		}, pLoad->counter);
+
+		m_loadPtrs.push_back(std::move(pLoad));
+	}
+
+	std::lock_guard<std::mutex> lock(m_statusMtx);
+
+	m_status.resize(m_policy.GetTextureCount());
+
+	for (size_t i = 0; i < m_status.size(); i++) {
+
+		m_status[i] = m_policy.GetStatus(i);
+	}
+
+	m_committed = m_policy.GetCommittedBytes();
+}
+
+void TextureStreamer::SetBudget(size_t budget) noexcept
+{
+	m_budget = budget;
+}
+
+void TextureStreamer::ShowWindow(const char* windowName) noexcept
+{
+	windowName = windowName ? windowName : "Texture Streaming";
+
+	if (ImGui::Begin(windowName)) {
+
+		std::lock_guard<std::mutex> lock(m_statusMtx);
+
+		constexpr float mb = 1024.0f * 1024.0f;
+
+		int budgetMb = (int)(m_budget.load() / (size_t)mb);
+
+		if (ImGui::SliderInt("Budget (MB)", &budgetMb, 1, 512)) {
+
+			m_budget = (size_t)budgetMb * (size_t)mb;
+		}
+
+		ImGui::ProgressBar(std::min(1.0f, m_committed / (float)m_budget.load()), ImVec2(-1.0f, 0.0f));
+		ImGui::Text("%.2f / %.2f MB committed", m_committed / mb, m_budget.load() / mb);
+
+		ImGui::Columns(5, "mips");
+		ImGui::Text("Texture"); ImGui::NextColumn();
+		ImGui::Text("Resident"); ImGui::NextColumn();
+		ImGui::Text("Requested"); ImGui::NextColumn();
+		ImGui::Text("Pending"); ImGui::NextColumn();
+		ImGui::Text("MB"); ImGui::NextColumn();
+		ImGui::Separator();
+
+		for (size_t i = 0; i < m_status.size(); i++) {
+
+			const auto& status = m_status[i];
+
+			//red when the draw wants more detail than there is
+			const bool isStarved = status.requestedMip < status.residentMip;
+
+			ImGui::Text("%s", m_names[i].c_str()); ImGui::NextColumn();
+			ImGui::TextColored(isStarved ? ImVec4(1.0f, 0.4f, 0.4f, 1.0f) : ImVec4(0.4f, 1.0f, 0.4f, 1.0f), "%u / %u", status.residentMip, status.mipCount); ImGui::NextColumn();
+			ImGui::Text("%u", status.requestedMip); ImGui::NextColumn();
+
+			if (status.pendingMip != MipStreamer::none) {
+
+				ImGui::Text("%u", status.pendingMip);
+			}
+			else {
+
+				ImGui::Text("-");
+			}
+
+			ImGui::NextColumn();
+			ImGui::Text("%.2f", status.residentBytes / mb); ImGui::NextColumn();
+		}
+
+		ImGui::Columns(1);
+	}
+
+	ImGui::End();
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "MipStreamer.h"
+#include "StreamedTexture.h"
+#include "JobSystem.h"
+#include <memory>
+#include <vector>
+#include <string>
+#include <mutex>
+#include <atomic>
+
+/// <summary>
+/// Carries out MipStreamer's decisions for the streamed textures of the scene
+/// new views are built from the mapped files on the job system and swapped in on the render thread a frame or more later
+/// *an old view lives until its replacement is swapped in, so the real footprint can briefly go past the budget
+/// </summary>
+class TextureStreamer {
+
+public:
+
+	explicit TextureStreamer(JobSystem& jobs, size_t budget = 64u * 1024u * 1024u);
+	TextureStreamer(const TextureStreamer&) = delete;
+	TextureStreamer& operator=(const TextureStreamer&) = delete;
+	//waits for loads still in flight
+	~TextureStreamer();
+
+	//before the render thread draws the texture (or with the pipeline idle)
+	void Register(std::shared_ptr<Bind::StreamedTexture> pTexture, std::string name);
+
+	//render thread, start of the frame: swaps finished loads in, hands the last frame's requests
+	//to the policy and starts whatever it asks for
+	void Update(Graphics& gfx);
+
+	//any thread, applied on the next Update
+	void SetBudget(size_t budget) noexcept;
+
+	//resident, requested and pending mips of every texture as of the last Update
+	void ShowWindow(const char* windowName = nullptr) noexcept;
+
+private:
+
+	struct Load {
+
+		MipStreamer::Id id;
+		unsigned int mip;
+
+		//written by the job, read once the counter is done
+		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> pView;
+		JobSystem::Counter counter;
+	};
+
+private:
+
+	JobSystem& m_jobs;
+	MipStreamer m_policy;
+	std::atomic<size_t> m_budget;
+
+	std::vector<std::shared_ptr<Bind::StreamedTexture>> m_texturePtrs;
+	std::vector<std::string> m_names;
+	std::vector<std::unique_ptr<Load>> m_loadPtrs;
+
+	//copy for the debug window, built on the simulation thread
+	std::mutex m_statusMtx;
+	std::vector<MipStreamer::Status> m_status;
+	size_t m_committed = 0u;
+};
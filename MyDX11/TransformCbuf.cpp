@@ -1,18 +1,59 @@
 #include "TransformCbuf.h"
+#include "RingAllocator.h"
+#include "Profiler.h"
+#include <d3d11_1.h>
+#include <deque>
+#include <thread>
 
 
 namespace Bind {
 
+	namespace wrl = Microsoft::WRL;
+
+	struct TransformCbuf::Ring {
+
+		Ring(size_t capacity)
+			:
+			allocator(capacity, slotSize)
+		{}
+
+		wrl::ComPtr<ID3D11DeviceContext1> pContext1;
+		wrl::ComPtr<ID3D11Buffer> pBuffer;
+		RingAllocator allocator;
+
+		//first map after (re)creating the buffer has to discard
+		bool isFresh = true;
+
+		//event query per frame the GPU may still be reading from the ring
+		std::deque<std::pair<unsigned long long, wrl::ComPtr<ID3D11Query>>> fences;
+		std::vector<wrl::ComPtr<ID3D11Query>> freeQueries;
+		unsigned long long nextFence = 1u;
+
+		//model transforms waiting for the next flush
+		std::vector<DirectX::XMFLOAT4X4> staged;
+		unsigned long long stagedBatch = 1u;
+
+		//batch the last flush uploaded and where it starts in the ring
+		unsigned long long uploadedBatch = 0u;
+		size_t batchOffset = 0u;
+	};
+
 	//Transformation Constant Buffer
 	TransformCbuf::TransformCbuf(Graphics& gfx, const Drawable& parent, UINT slot)
 		:
-		parent(parent)
+		parent(parent),
+		m_slot(slot)
 	{
 
 		//Check the constant buffer has been allocated yet or not
-		if (!pVcbuf) {
+		if (!pRing && !pVcbuf) {
+
+			CreateRing(gfx, initialRingSlots * slotSize);
+		}
+
+		//no offset binding, every draw maps the one small buffer instead
+		if (!pRing && !pVcbuf) {
 
-			//Allocating the constant buffer
 			pVcbuf = std::make_unique<VertexConstantBuffer<Transforms>>(gfx, slot);
 		}
 
@@ -20,25 +61,284 @@ namespace Bind {
 
 	void TransformCbuf::Bind(Graphics& gfx) noexcept
 	{
+		PROFILE_ZONE("TransformCbuf::Bind");
+
+		const auto view = gfx.GetCamera();
+		const auto viewProj = view * gfx.GetProjection();
+
+		if (!pRing) {
+
+			Transforms transforms;
+			WriteTransforms(&transforms, parent.GetTransformXM(), view, viewProj);
+
+			//Update the constant buffer every draw
+			pVcbuf->Update(gfx, transforms);
+			pVcbuf->Bind(gfx);
+			return;
+		}
+
+		auto& ring = *pRing;
+		size_t offset;
+
+		if (m_batch != 0u && m_batch == ring.uploadedBatch) {
+
+			//uploaded by this frame's flush
+			offset = ring.batchOffset + m_stagedIndex * slotSize;
+		}
+		else {
+
+			//not staged, costs a map of its own
+			INFOMAN(gfx);
+
+			offset = AllocateSlots(gfx, 1u);
+
+			D3D11_MAPPED_SUBRESOURCE msr;
+			GFX_THROW_INFO(ring.pContext1->Map(
+				ring.pBuffer.Get(), 0u,
+				ring.isFresh ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE, 0u,
+				&msr
+			));
+			ring.isFresh = false;
+
+			WriteTransforms(static_cast<char*>(msr.pData) + offset, parent.GetTransformXM(), view, viewProj);
+			ring.pContext1->Unmap(ring.pBuffer.Get(), 0u);
+		}
+
+		//bind a window of the ring, offsets and sizes are counted in 16 byte constants
+		const UINT firstConstant = (UINT)(offset / 16u);
+		const UINT numConstants = (UINT)(slotSize / 16u);
+		ring.pContext1->VSSetConstantBuffers1(m_slot, 1u, ring.pBuffer.GetAddressOf(), &firstConstant, &numConstants);
+	}
+
+	void TransformCbuf::Stage() const
+	{
+		if (!pRing) {
+
+			return;
+		}
+
+		auto& ring = *pRing;
+
+		m_batch = ring.stagedBatch;
+		m_stagedIndex = ring.staged.size();
+
+		DirectX::XMStoreFloat4x4(&ring.staged.emplace_back(), parent.GetTransformXM());
+	}
+
+	void TransformCbuf::Flush(Graphics& gfx)
+	{
+		PROFILE_ZONE("TransformCbuf::Flush");
+
+		if (!pRing) {
+
+			return;
+		}
+
+		auto& ring = *pRing;
+
+		//everything issued so far belongs to the previous frame
+		IssueFence(gfx);
+		RetireFences(gfx, false);
+
+		const auto batch = ring.stagedBatch++;
+
+		if (ring.staged.empty()) {
+
+			return;
+		}
+
+		INFOMAN(gfx);
+
+		const auto offset = AllocateSlots(gfx, ring.staged.size());
+
+		D3D11_MAPPED_SUBRESOURCE msr;
+		GFX_THROW_INFO(ring.pContext1->Map(
+			ring.pBuffer.Get(), 0u,
+			ring.isFresh ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE, 0u,
+			&msr
+		));
+		ring.isFresh = false;
+
+		//one pass over the whole frame, written straight into the mapped ring
+		const auto view = gfx.GetCamera();
+		const auto viewProj = view * gfx.GetProjection();
+		auto pDst = static_cast<char*>(msr.pData) + offset;
+
+		for (const auto& model : ring.staged) {
+
+			WriteTransforms(pDst, DirectX::XMLoadFloat4x4(&model), view, viewProj);
+			pDst += slotSize;
+		}
+
+		ring.pContext1->Unmap(ring.pBuffer.Get(), 0u);
+
+		ring.uploadedBatch = batch;
+		ring.batchOffset = offset;
+		ring.staged.clear();
+	}
+
+	void TransformCbuf::CreateRing(Graphics& gfx, size_t capacity)
+	{
+		INFOMAN(gfx);
+
+		//needs the 11.1 runtime for offset binding and no overwrite maps on constant buffers
+		D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+
+		if (FAILED(GetDevice(gfx)->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options))) ||
+			!options.ConstantBufferOffsetting ||
+			!options.MapNoOverwriteOnDynamicConstantBuffer) {
+
+			return;
+		}
+
+		wrl::ComPtr<ID3D11DeviceContext1> pContext1;
+
+		if (FAILED(GetContext(gfx)->QueryInterface(__uuidof(ID3D11DeviceContext1), &pContext1))) {
+
+			return;
+		}
+
+		auto pNewRing = std::make_unique<Ring>(capacity);
+		pNewRing->pContext1 = std::move(pContext1);
+
+		D3D11_BUFFER_DESC cbd;
+		cbd.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+		cbd.Usage = D3D11_USAGE_DYNAMIC;
+		cbd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+		cbd.MiscFlags = 0u;
+		cbd.ByteWidth = (UINT)capacity;
+		cbd.StructureByteStride = 0u;
+
+		GFX_THROW_INFO(GetDevice(gfx)->CreateBuffer(&cbd, nullptr, &pNewRing->pBuffer));
+
+		pRing = std::move(pNewRing);
+	}
+
+	size_t TransformCbuf::AllocateSlots(Graphics& gfx, size_t count)
+	{
+		auto& ring = *pRing;
+		const auto size = count * slotSize;
+
+		//more than fits in the whole ring, wait for the GPU and start over with a bigger one
+		if (size > ring.allocator.GetCapacity()) {
 
-		const auto modelView = parent.GetTransformXM() * gfx.GetCamera();
-		const Transforms m_transform = {
-			DirectX::XMMatrixTranspose(modelView),
-			DirectX::XMMatrixTranspose(
-				modelView *
-				gfx.GetProjection()
-			)
-		};
+			IssueFence(gfx);
 
+			while (!ring.fences.empty()) {
+
+				RetireFences(gfx, true);
+			}
+
+			auto capacity = ring.allocator.GetCapacity();
+
+			while (capacity < size) {
+
+				capacity *= 2u;
+			}
+
+			INFOMAN(gfx);
+
+			D3D11_BUFFER_DESC cbd;
+			ring.pBuffer->GetDesc(&cbd);
+			cbd.ByteWidth = (UINT)capacity;
+
+			ring.pBuffer.Reset();
+			GFX_THROW_INFO(GetDevice(gfx)->CreateBuffer(&cbd, nullptr, &ring.pBuffer));
+
+			ring.allocator = RingAllocator(capacity, slotSize);
+			ring.isFresh = true;
+		}
+
+		//ring full of frames the GPU hasn't finished, wait for the oldest one
+		auto offset = ring.allocator.Allocate(size);
+
+		while (!offset) {
+
+			//only the current frame is in the ring, close it so it can be waited on
+			if (ring.fences.empty()) {
+
+				IssueFence(gfx);
+			}
+
+			RetireFences(gfx, true);
+			offset = ring.allocator.Allocate(size);
+		}
 
-		//Update the constant buffer every frame
-		pVcbuf->Update(gfx, m_transform);
+		return *offset;
+	}
+
+	void TransformCbuf::IssueFence(Graphics& gfx)
+	{
+		INFOMAN(gfx);
+
+		auto& ring = *pRing;
+		wrl::ComPtr<ID3D11Query> pQuery;
+
+		if (!ring.freeQueries.empty()) {
+
+			pQuery = std::move(ring.freeQueries.back());
+			ring.freeQueries.pop_back();
+		}
+		else {
+
+			D3D11_QUERY_DESC qd = {};
+			qd.Query = D3D11_QUERY_EVENT;
+
+			GFX_THROW_INFO(GetDevice(gfx)->CreateQuery(&qd, &pQuery));
+		}
+
+		//signals once the GPU got past every command issued before it
+		ring.pContext1->End(pQuery.Get());
+
+		ring.allocator.Fence(ring.nextFence);
+		ring.fences.emplace_back(ring.nextFence, std::move(pQuery));
+		ring.nextFence++;
+	}
+
+	void TransformCbuf::RetireFences(Graphics& gfx, bool isWaiting)
+	{
+		auto& ring = *pRing;
+
+		while (!ring.fences.empty()) {
+
+			auto& [value, pQuery] = ring.fences.front();
+
+			//only flush the command queue when actually blocking on it
+			const UINT flags = isWaiting ? 0u : D3D11_ASYNC_GETDATA_DONOTFLUSH;
+
+			while (ring.pContext1->GetData(pQuery.Get(), nullptr, 0u, flags) == S_FALSE) {
+
+				if (!isWaiting) {
+
+					return;
+				}
+
+				std::this_thread::yield();
+			}
+
+			ring.allocator.Retire(value);
+			ring.freeQueries.push_back(std::move(pQuery));
+			ring.fences.pop_front();
+
+			//waiting retires one frame at a time
+			if (isWaiting) {
+
+				return;
+			}
+		}
+	}
+
+	void TransformCbuf::WriteTransforms(void* pDst, DirectX::FXMMATRIX model, DirectX::CXMMATRIX view, DirectX::CXMMATRIX viewProj) noexcept
+	{
+		//mapped memory is 16 byte aligned, matrices go in transposed for hlsl
+		auto& transforms = *static_cast<Transforms*>(pDst);
 
-		//bind the constant buffer to the graphic objects every frame
-		pVcbuf->Bind(gfx);
+		transforms.modelView = DirectX::XMMatrixTranspose(model * view);
+		transforms.modelViewProj = DirectX::XMMatrixTranspose(model * viewProj);
 	}
 
 	//Declaration for static variable
+	std::unique_ptr<TransformCbuf::Ring> TransformCbuf::pRing;
 	std::unique_ptr<VertexConstantBuffer<TransformCbuf::Transforms>> TransformCbuf::pVcbuf;
 
-}
\ No newline at end of file
+}
@@ -12,8 +12,8 @@ namespace Bind {
 
 		struct Transforms {
 
+			DirectX::XMMATRIX modelView;
 			DirectX::XMMATRIX modelViewProj;
-			DirectX::XMMATRIX model;
 		};
 
 	public:
@@ -21,14 +21,44 @@ namespace Bind {
 		TransformCbuf(Graphics& gfx, const Drawable& parent, UINT slot = 0u);
 		void Bind(Graphics& gfx) noexcept override;
 
+		//queues the parent's current transform for the next Flush
+		//*one transform per drawable per flush, drawing it twice needs an unstaged draw
+		void Stage() const;
+
+		//computes every staged model view / mvp in one pass and uploads them with a single map
+		//*called once per frame after staging and before drawing
+		static void Flush(Graphics& gfx);
+
 	private:
 
-		//dynamic allocated static VertexConstantBuffer
+		//per frame ring buffer, only created when the runtime supports constant buffer offsets
+		struct Ring;
+
+		static void CreateRing(Graphics& gfx, size_t capacity);
+		static size_t AllocateSlots(Graphics& gfx, size_t count);
+		static void IssueFence(Graphics& gfx);
+		static void RetireFences(Graphics& gfx, bool isWaiting);
+		static void WriteTransforms(void* pDst, DirectX::FXMMATRIX model, DirectX::CXMMATRIX view, DirectX::CXMMATRIX viewProj) noexcept;
+
+	private:
+
+		//constant buffer offsets/sizes must be multiples of 16 constants (256 bytes)
+		static constexpr size_t slotSize = 256u;
+		static constexpr size_t initialRingSlots = 4096u;
+
+		static std::unique_ptr<Ring> pRing;
+
+		//dynamic allocated static VertexConstantBuffer (fallback without offset binding)
 		static std::unique_ptr<VertexConstantBuffer<Transforms>> pVcbuf;
 
 		//Grab the matrix from it's parent and update to vcbuf
 		const Drawable& parent;
+		UINT m_slot;
+
+		//where Stage put the transform, 0 = never staged
+		mutable unsigned long long m_batch = 0u;
+		mutable size_t m_stagedIndex = 0u;
 
 	};
 
-}
\ No newline at end of file
+}
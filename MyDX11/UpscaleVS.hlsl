@@ -0,0 +1,14 @@
+struct VSOut
+{
+	float2 tc : TexCoord;
+	float4 pos : SV_Position;
+};
+
+//one triangle covering the screen, no vertex buffer
+VSOut main(uint id : SV_VertexID)
+{
+	VSOut vso;
+	vso.tc = float2((id << 1) & 2, id & 2);
+	vso.pos = float4(vso.tc * float2(2.0f, -2.0f) + float2(-1.0f, 1.0f), 0.0f, 1.0f);
+	return vso;
+}
@@ -0,0 +1,20 @@
+#include "Upscaler.h"
+
+Upscaler::Upscaler(Graphics& gfx)
+	:
+	m_vertexShader(gfx, L"UpscaleVS.cso"),
+	m_pixelShader(gfx, L"UpscalePS.cso"),
+	//clamped so the edges don't pull in texels from the other side
+	m_sampler(gfx, D3D11_TEXTURE_ADDRESS_CLAMP),
+	m_topology(gfx, D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST)
+{}
+
+void Upscaler::Draw(Graphics& gfx) noexcept(!IS_DEBUG)
+{
+	m_vertexShader.Bind(gfx);
+	m_pixelShader.Bind(gfx);
+	m_sampler.Bind(gfx);
+	m_topology.Bind(gfx);
+
+	gfx.Draw(3u);
+}
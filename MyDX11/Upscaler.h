@@ -0,0 +1,27 @@
+#pragma once
+
+#include "graphics.h"
+#include "VertexShader.h"
+#include "PixelShader.h"
+#include "Sampler.h"
+#include "Topology.h"
+
+/// <summary>
+/// Stretches the texture bound to pixel shader slot 0 over the bound target, bilinear
+/// for the render graph's upscale pass, a full screen triangle with no vertex or index buffer
+/// </summary>
+class Upscaler {
+
+public:
+
+	Upscaler(Graphics& gfx);
+
+	void Draw(Graphics& gfx) noexcept(!IS_DEBUG);
+
+private:
+
+	Bind::VertexShader m_vertexShader;
+	Bind::PixelShader m_pixelShader;
+	Bind::Sampler m_sampler;
+	Bind::Topology m_topology;
+};
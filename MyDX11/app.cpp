@@ -6,10 +6,16 @@
 #include "ModelTest.h"
 #include <memory>
 #include <algorithm>
+#include <cmath>
 #include "myMath.h"
 #include "Surface.h"
 #include "GDIPlusManager.h"
 #include "imgui/imgui.h"
+#include "TransformCbuf.h"
+#include <filesystem>
+#include <sstream>
+#include <iomanip>
+#include <ctime>
 
 
 GDIPlusManager gdipm;
@@ -17,118 +23,340 @@ GDIPlusManager gdipm;
 #define windowLenth (1600)
 #define windowWidth (900)
 
+//4 objects per group, large enough that queueing a job is noise next to the work
+constexpr size_t simGroupsPerJob = 1024u;
+//occlusion tests are a little heavier than a group of the simulation
+constexpr size_t occlusionTestsPerJob = 2048u;
+
+static const std::string captureDir = "capture";
+
+//local time as yyyymmdd_hhmmss, capture names sort by when they were taken
+static std::string GetTimeStamp()
+{
+	const std::time_t now = std::time(nullptr);
+	std::tm local = {};
+	localtime_s(&local, &now);
+
+	char buffer[32];
+	std::strftime(buffer, sizeof(buffer), "%Y%m%d_%H%M%S", &local);
+
+	return buffer;
+}
+
+
+class App::Factory {
+
+public:
+
+	//constructor
+	Factory(Graphics& gfx)
+		:
+		gfx(gfx){}
+
+	std::unique_ptr<TestObject> operator()() {
+
+		switch (sdist(rng)) {
+
+		case 0:
+
+			return MakeBox();
+
+		case 1:
+
+			return std::make_unique<Cylinder>(
+				gfx,
+				rng,
+				adist,
+				ddist,
+				odist,
+				rdist,
+				bdist,
+				tdist);
+
+		case 2:
+			return std::make_unique<Pyramid>(
+				gfx,
+				rng,
+				adist,
+				ddist,
+				odist,
+				rdist,
+				tdist);
+
+		case 3:
+
+			return std::make_unique<SkinnedBox>(
+				gfx,
+				rng,
+				adist,
+				ddist,
+				odist,
+				rdist
+				);
+
+		default:
+			assert(false && "Impossible drawable option in factory");
+			return {};
+
+		}
+
+
+		
+
+	}
+
+	//orbit of a swarm light, quicker than the objects' and with nothing to spin
+	ObjectSimulation::Motion MakeLightMotion() {
+
+		ObjectSimulation::Motion motion;
+		motion.r = ldist(rng);
+		motion.theta = adist(rng);
+		motion.phi = adist(rng);
+		motion.chi = adist(rng);
+		motion.dtheta = lodist(rng);
+		motion.dphi = lodist(rng);
+		motion.dchi = lodist(rng);
+
+		return motion;
+	}
+
+	//saturated random color, the brightest channel is always 1
+	DirectX::XMFLOAT3 MakeLightColor() {
+
+		DirectX::XMFLOAT3 color = { cdist(rng),cdist(rng),cdist(rng) };
+		const float brightest = std::max({ color.x,color.y,color.z,0.001f });
+
+		return { color.x / brightest,color.y / brightest,color.z / brightest };
+	}
+
+	std::unique_ptr<Box> MakeBox() {
+
+		const DirectX::XMFLOAT3 mat = { cdist(rng),cdist(rng),cdist(rng) };
+
+		return std::make_unique<Box>(
+			gfx,
+			rng,
+			adist,
+			ddist,
+			odist,
+			rdist,
+			bdist,
+			mat);
+	}
+
+private:
+
+	Graphics& gfx;
+	std::mt19937 rng{ std::random_device{}() };
+	std::uniform_int_distribution<int> sdist{ 0,3 };
+	std::uniform_real_distribution<float> adist{ 0.0f,PI * 2.0f };
+	std::uniform_real_distribution<float> ddist{ 0.0f,PI * 0.5f };
+	std::uniform_real_distribution<float> odist{ 0.0f,PI * 0.08f };
+	std::uniform_real_distribution<float> rdist{ 6.0f,20.0f };
+	std::uniform_real_distribution<float> bdist{ 0.4f,3.0f };
+	std::uniform_real_distribution<float> cdist{ 0.0f,1.0f };
+	std::uniform_int_distribution<int> tdist{ 3,30 };
+	std::uniform_real_distribution<float> ldist{ 2.0f,22.0f };
+	std::uniform_real_distribution<float> lodist{ -PI * 0.2f,PI * 0.2f };
+
+};
+
 
 App::App()
 	:
 	m_wnd(windowLenth, windowWidth, "Banana Engine"),
-	m_light(m_wnd.Gfx())
+	m_light(m_wnd.Gfx()),
+	m_pFactory(std::make_unique<Factory>(m_wnd.Gfx()))
 {
+	PROFILE_THREAD("Main");
 	
 	
-	class Factory {
-
-	public:
-
-		//constructor
-		Factory(Graphics& gfx)
-			:
-			gfx(gfx){}
-
-		std::unique_ptr<Drawable> operator()() {
-
-			const DirectX::XMFLOAT3 mat = { cdist(rng),cdist(rng),cdist(rng) };
-
-
-			switch (sdist(rng)) {
-
-			case 0:
-
-				return std::make_unique<Box>(
-					gfx,
-					rng,
-					adist,
-					ddist,
-					odist,
-					rdist,
-					bdist,
-					mat);
-
-			case 1:
-
-				return std::make_unique<Cylinder>(
-					gfx,
-					rng,
-					adist,
-					ddist,
-					odist,
-					rdist,
-					bdist,
-					tdist);
-
-			case 2:
-				return std::make_unique<Pyramid>(
-					gfx,
-					rng,
-					adist,
-					ddist,
-					odist,
-					rdist,
-					tdist);
-
-			case 3:
-
-				return std::make_unique<SkinnedBox>(
-					gfx,
-					rng,
-					adist,
-					ddist,
-					odist,
-					rdist
-					);
-
-			default:
-				assert(false && "Impossible drawable option in factory");
-				return {};
+	//create boxes
+	SpawnTestObjects(m_nDrawables);
+	SpawnClusterLights((size_t)m_nClusterLights);
 
-			}
+	//projection is handed to the render thread with every frame
+	DirectX::XMStoreFloat4x4(&m_projection, DirectX::XMMatrixPerspectiveLH(1.0f, 9.0f / 16.0f, 0.5f, 40.0f));
+	m_clusters.SetProjection(m_projection);
 
+}
 
-			
+void App::SpawnTestObjects(size_t count)
+{
+	//boxes windows refer to the old objects
+	m_boxControlIDs.clear();
+	m_comboBox.reset();
+	m_boxes.clear();
+
+	m_sim.Clear();
+	m_drawables.clear();
+	m_drawables.reserve(count);
 
+	//create boxes
+	for (size_t i = 0; i < count; i++) {
+
+		SpawnTestObject((*m_pFactory)());
+	}
+
+}
+
+void App::SpawnClusterLights(size_t count)
+{
+	m_lightSim.Clear();
+	m_lightColors.clear();
+
+	for (size_t i = 0; i < count; i++) {
+
+		m_lightSim.Spawn(m_pFactory->MakeLightMotion(), 0.0f);
+		m_lightColors.push_back(m_pFactory->MakeLightColor());
+	}
+}
+
+ObjectSimulation::Handle App::SpawnTestObject(std::unique_ptr<TestObject> pObject)
+{
+	const auto handle = m_sim.Spawn(pObject->GetSpawnMotion(), pObject->GetBoundingRadius());
+
+	//keep box handles for editing instance parameters
+	if (dynamic_cast<Box*>(pObject.get())) {
+
+		m_boxes.push_back(handle);
+	}
+
+	m_drawables.push_back(std::move(pObject));
+
+	return handle;
+}
+
+void App::DespawnTestObject(ObjectSimulation::Handle handle) noexcept
+{
+	//mirror the simulation's swap and pop
+	const auto index = m_sim.Despawn(handle);
+
+	std::swap(m_drawables[index], m_drawables.back());
+	m_drawables.pop_back();
+}
+
+void App::CullOccluded(DirectX::FXMMATRIX viewProj)
+{
+	DirectX::XMFLOAT4X4 vp;
+	DirectX::XMStoreFloat4x4(&vp, viewProj);
+
+	m_occlusion.Begin(vp);
+
+	//the model stands in the middle of everything, it always goes in
+	m_nano.AddOccluders(m_occlusion);
+
+	//then the boxes covering the most of the screen, by size over distance from the camera
+	const auto view = m_camera.GetMatrix();
+	DirectX::XMFLOAT4X4 box;
+
+	m_occluderCandidates.clear();
+
+	for (const uint32_t i : m_visibleObjects) {
+
+		const auto world = DirectX::XMLoadFloat4x4(&m_sim.GetTransform(i));
+
+		if (m_drawables[i]->GetOccluderBox(world, box)) {
+
+			const float depth = DirectX::XMVectorGetZ(DirectX::XMVector3Transform(world.r[3], view));
+
+			m_occluderCandidates.push_back({ m_drawables[i]->GetBoundingRadius() / std::max(depth, 0.5f),i });
 		}
+	}
 
-	private:
+	const size_t nOccluders = std::min(m_occluderCandidates.size(), (size_t)m_maxOccluders);
 
-		Graphics& gfx;
-		std::mt19937 rng{ std::random_device{}() };
-		std::uniform_int_distribution<int> sdist{ 0,3 };
-		std::uniform_real_distribution<float> adist{ 0.0f,PI * 2.0f };
-		std::uniform_real_distribution<float> ddist{ 0.0f,PI * 0.5f };
-		std::uniform_real_distribution<float> odist{ 0.0f,PI * 0.08f };
-		std::uniform_real_distribution<float> rdist{ 6.0f,20.0f };
-		std::uniform_real_distribution<float> bdist{ 0.4f,3.0f };
-		std::uniform_real_distribution<float> cdist{ 0.0f,1.0f };
-		std::uniform_int_distribution<int> tdist{ 3,30 };
+	std::partial_sort(m_occluderCandidates.begin(), m_occluderCandidates.begin() + nOccluders, m_occluderCandidates.end(),
+		[](const auto& lhs, const auto& rhs) { return lhs.first > rhs.first; });
 
-	};
+	for (size_t k = 0; k < nOccluders; k++) {
 
-	//create boxes
-	m_drawables.reserve(m_nDrawables);
-	std::generate_n(std::back_inserter(m_drawables), m_nDrawables, Factory{ m_wnd.Gfx() });
+		const size_t i = m_occluderCandidates[k].second;
+
+		m_drawables[i]->GetOccluderBox(DirectX::XMLoadFloat4x4(&m_sim.GetTransform(i)), box);
+		m_occlusion.AddOccluder(m_boxOccluder, box);
+	}
+
+	//tile rows are drawn in parallel, then everything the frustum kept is tested against them
+	m_jobs.ParallelFor(m_occlusion.GetTileRowCount(), 1u, [this](size_t first, size_t last) {
+
+		m_occlusion.Rasterize(first, last);
+	});
+
+	m_jobs.ParallelFor(m_visibleObjects.size(), occlusionTestsPerJob, [this](size_t first, size_t last) {
+
+		for (size_t k = first; k < last; k++) {
 
-	//init box pointers for editing instance parameters
-	for (auto& pd : m_drawables) {
+			const uint32_t i = m_visibleObjects[k];
+			const auto& transform = m_sim.GetTransform(i);
 
-		if (auto pb = dynamic_cast<Box*>(pd.get())) {
+			m_isOccluded[i] = !m_occlusion.IsVisible(DirectX::XMFLOAT3{ transform._41,transform._42,transform._43 }, m_drawables[i]->GetBoundingRadius());
+		}
+	});
+
+	m_nOccluded = (size_t)std::count(m_isOccluded.begin(), m_isOccluded.end(), (uint8_t)1u);
+}
 
-			m_boxes.push_back(pb);
+void App::AssignClusterLights(DirectX::FXMMATRIX view, unsigned int nSteps, float step, float alpha)
+{
+	//the swarm steps with the objects
+	m_jobs.ParallelFor(m_lightSim.GetGroupCount(), simGroupsPerJob, [&](size_t first, size_t last) {
+
+		for (unsigned int i = 0; i < nSteps; i++) {
+
+			m_lightSim.Update(step, first, last);
 		}
 
+		m_lightSim.EmitTransforms(alpha, first, last);
+	});
+
+	//the grid is in view space like the shaders' positions
+	m_clusterLights.resize(m_lightSim.GetCount());
+
+	for (size_t i = 0; i < m_clusterLights.size(); i++) {
+
+		const auto& transform = m_lightSim.GetTransform(i);
+		const auto center = DirectX::XMVector3Transform(DirectX::XMVectorSet(transform._41, transform._42, transform._43, 1.0f), view);
+
+		DirectX::XMStoreFloat3(&m_clusterLights[i].center, center);
+		m_clusterLights[i].radius = m_clusterLightRange;
 	}
 
-	//set the projection matrix for the graphics
-	m_wnd.Gfx().SetProjection(DirectX::XMMatrixPerspectiveLH(1.0f, 9.0f / 16.0f, 0.5f, 40.0f));
+	//lights are binned by slice, then the slices fill their clusters' lists in parallel
+	m_clusters.Begin(m_clusterLights);
+
+	m_jobs.ParallelFor(m_clusters.GetSliceCount(), 1u, [this](size_t first, size_t last) {
 
+		m_clusters.Assign(first, last);
+	});
+
+	m_clusters.Pack();
+}
+
+void App::PickBox(int x, int y)
+{
+	namespace dx = DirectX;
+
+	//the cursor's ray runs from the near plane to the far plane, back through the inverse view projection
+	const auto inverse = dx::XMMatrixInverse(nullptr, m_camera.GetMatrix() * dx::XMLoadFloat4x4(&m_projection));
+	const float ndcX = 2.0f * x / m_wnd.Gfx().GetWidth() - 1.0f;
+	const float ndcY = 1.0f - 2.0f * y / m_wnd.Gfx().GetHeight();
+
+	const auto nearPoint = dx::XMVector3TransformCoord(dx::XMVectorSet(ndcX, ndcY, 0.0f, 1.0f), inverse);
+	const auto farPoint = dx::XMVector3TransformCoord(dx::XMVectorSet(ndcX, ndcY, 1.0f, 1.0f), inverse);
+
+	dx::XMFLOAT3 origin;
+	dx::XMFLOAT3 direction;
+	dx::XMStoreFloat3(&origin, nearPoint);
+	dx::XMStoreFloat3(&direction, dx::XMVectorSubtract(farPoint, nearPoint));
+
+	//the nearest bounding sphere under the cursor, only boxes have control windows
+	const auto hit = m_bvh.Raycast(origin, direction);
+
+	if (hit && hit->index < m_drawables.size() && dynamic_cast<Box*>(m_drawables[hit->index].get())) {
+
+		m_boxControlIDs.insert(m_sim.GetHandle(hit->index));
+	}
 }
 
 int App::Go() {
@@ -149,30 +377,16 @@ int App::Go() {
 
 void App::DoFrame() {
 
-	//add deltatime and * by speedFactor
-	auto dt = m_timer.Mark() * m_speedFactor;
-
-	//buffer clearing
-	m_wnd.Gfx().BeginFrame(0.07f, 0.0f, 0.12f);
-	m_wnd.Gfx().SetCamera(m_camera.GetMatrix());
-	m_light.Bind(m_wnd.Gfx(),m_camera.GetMatrix());
-
-	//render
-	for (auto& d:m_drawables) {
-
-		//update all the boxes
-		d->Update(m_wnd.kbd.KeyIsPressed(VK_SPACE) ? 0.0f : dt);
-
-		//draw all the boxes
-		d->Draw(m_wnd.Gfx());
-	}
-	
+	PROFILE_FRAME();
+	PROFILE_ZONE("App::DoFrame");
 
-	//nano boi model
-	m_nano.Draw(m_wnd.Gfx());
+	//add deltatime and * by speedFactor
+	//*clamped like the simulation's frames, a hitch shouldn't throw the camera across the scene
+	const uint64_t frameNs = m_frameStats.MarkFrame();
+	const double frameSeconds = frameNs * 1.0e-9;
+	const auto dt = (float)std::min(frameSeconds, m_timestep.GetMaxFrameTime()) * m_speedFactor;
 
-	//point light
-	m_light.Draw(m_wnd.Gfx());
+	m_wnd.Gfx().NewImguiFrame();
 
 	//raw input stuffs
 	while (const auto e = m_wnd.kbd.ReadKey()){
@@ -231,11 +445,20 @@ void App::DoFrame() {
 			}
 			
 
+			break;
+
+		case VK_F9:
+
+			m_isScreenshotRequested = true;
 			break;
 		}
 		
 	}
 
+	//imgui gets typed characters from the window procedure and nothing here reads them,
+	//emptied every frame so the queue doesn't sit full counting every keystroke as dropped
+	m_wnd.kbd.FlushChar();
+
 
 	if (!m_wnd.GetCursorEnabled()) {
 
@@ -277,6 +500,137 @@ void App::DoFrame() {
 
 	}
 
+
+	//step, transform and cull all the boxes across the job system
+	//*each job runs the passes back to back on its own range while it's still in cache
+	//*the simulation only sees whole fixed steps, the transforms are blended to the frame's point between the last two
+	//*the timestep gets the real frame time and the speed apart, so fast forward doesn't run into the slow frame cap
+	const unsigned int nSteps = m_wnd.kbd.KeyIsPressed(VK_SPACE) ? 0u : m_timestep.Advance(frameSeconds, m_speedFactor);
+	const float step = m_timestep.GetStep();
+	const float alpha = m_timestep.GetAlpha();
+	const auto viewProj = m_camera.GetMatrix() * DirectX::XMLoadFloat4x4(&m_projection);
+
+	DirectX::XMFLOAT4X4 vp;
+	DirectX::XMStoreFloat4x4(&vp, viewProj);
+
+	//the jobs hand the spatial index every bounding sphere as they emit the transforms
+	m_bvh.Resize(m_sim.GetCount());
+
+	{
+		PROFILE_ZONE("Simulation");
+
+		m_jobs.ParallelFor(m_sim.GetGroupCount(), simGroupsPerJob, [&](size_t first, size_t last) {
+
+			for (unsigned int i = 0; i < nSteps; i++) {
+
+				m_sim.Update(step, first, last);
+			}
+
+			m_sim.EmitTransforms(alpha, first, last);
+
+			const size_t lastObject = std::min(last * ObjectSimulation::groupWidth, m_sim.GetCount());
+
+			for (size_t i = first * ObjectSimulation::groupWidth; i < lastObject; i++) {
+
+				const auto& transform = m_sim.GetTransform(i);
+
+				m_bvh.SetSphere(i, { transform._41,transform._42,transform._43 }, m_sim.GetBoundingRadius(i));
+			}
+
+			if (!m_isSpatialIndex) {
+
+				m_sim.Cull(vp, first, last);
+			}
+		});
+	}
+
+	{
+		PROFILE_ZONE("Spatial Index");
+
+		//refit once for the whole batch of moves, then the frustum walks the tree instead of every object
+		const uint64_t indexBegin = myTimer::SteadyClock();
+
+		m_bvh.Update(&m_jobs);
+
+		if (m_isSpatialIndex) {
+
+			m_bvh.QueryFrustum(vp, m_visibleObjects);
+		}
+		else {
+
+			m_visibleObjects.clear();
+
+			for (size_t i = 0; i < m_drawables.size(); i++) {
+
+				if (m_sim.IsVisible(i)) {
+
+					m_visibleObjects.push_back((uint32_t)i);
+				}
+			}
+		}
+
+		m_spatialIndexNs = myTimer::SteadyClock() - indexBegin;
+	}
+
+	//clicks that imgui didn't take pick boxes in the scene
+	while (const auto e = m_wnd.mouse.Read()) {
+
+		if (e->GetType() == Mouse::Event::Type::LPress && m_wnd.GetCursorEnabled()) {
+
+			PickBox(e->GetPosX(), e->GetPosY());
+		}
+	}
+
+	{
+		PROFILE_ZONE("Occlusion");
+
+		const uint64_t occlusionBegin = myTimer::SteadyClock();
+		m_isOccluded.assign(m_drawables.size(), 0u);
+
+		if (m_isOcclusionCulling) {
+
+			CullOccluded(viewProj);
+		}
+
+		m_occlusionNs = myTimer::SteadyClock() - occlusionBegin;
+	}
+
+	{
+		PROFILE_ZONE("Light Clusters");
+
+		const uint64_t clusterBegin = myTimer::SteadyClock();
+
+		//a new count from last frame's window, applied before the lights are built so the colors always match them
+		if (m_isRespawnClusterLights) {
+
+			SpawnClusterLights((size_t)m_nClusterLights);
+			m_isRespawnClusterLights = false;
+		}
+
+		AssignClusterLights(m_camera.GetMatrix(), nSteps, step, alpha);
+
+		m_clusterNs = myTimer::SteadyClock() - clusterBegin;
+	}
+
+	//gather the visible ones' instance data (drawables are in the simulation's dense order)
+	m_batcher.Begin();
+
+	for (const uint32_t i : m_visibleObjects) {
+
+		if (!m_isOccluded[i]) {
+
+			m_drawables[i]->WriteInstance(m_batcher.Add(&m_drawables[i]->GetMesh()), DirectX::XMLoadFloat4x4(&m_sim.GetTransform(i)));
+		}
+	}
+
+	m_batcher.Pack();
+	m_batchMeshes.clear();
+
+	for (const auto& g : m_batcher.GetGroups()) {
+
+		m_batchMeshes.push_back(static_cast<const InstancedMesh*>(g.key)->shared_from_this());
+	}
+
 	/// <summary>
 	/// imgui stuff
 	/// </summary>
@@ -293,6 +647,13 @@ void App::DoFrame() {
 	m_light.SpawnControlWindow();	//point light
 	//ShowImguiDemoWindow();
 	m_nano.ShowWindow();		//nano boi
+	m_streamer.ShowWindow();	//resident / requested mips
+	SpawnCaptureWindow();		//screenshots / sequences
+	SpawnProfilerWindow();		//zones of the last frame
+	SpawnFrameStatsWindow();	//frame time percentiles / hitches
+	SpawnResolutionWindow();	//internal resolution
+	SpawnOcclusionWindow();		//CPU depth buffer culling
+	SpawnLightClustersWindow();	//swarm lights and their cluster lists
 	ShowRawInputWindow();
 
 
@@ -302,9 +663,180 @@ void App::DoFrame() {
 	
 	ImGui::End();
 
-	
+
+	//hand the frame over to the render thread
+	//*waits here if the render thread is still two frames behind
+	auto& packet = [this]() -> FramePacket& {
+
+		PROFILE_ZONE("Wait for render thread");
+		return m_pipeline.BeginPacket();
+	}();
+
+	DirectX::XMStoreFloat4x4(&packet.camera, m_camera.GetMatrix());
+	packet.projection = m_projection;
+	packet.light = m_light.GetData();
+
+	{
+		auto& clusters = packet.clusters;
+		clusters.lights.resize(m_clusterLights.size() * 2u);
+
+		for (size_t i = 0; i < m_clusterLights.size(); i++) {
+
+			const auto& light = m_clusterLights[i];
+			const auto& color = m_lightColors[i];
+
+			clusters.lights[i * 2u] = { light.center.x,light.center.y,light.center.z,light.radius };
+			clusters.lights[i * 2u + 1u] = { color.x * m_clusterLightIntensity,color.y * m_clusterLightIntensity,color.z * m_clusterLightIntensity,0.0f };
+		}
+
+		clusters.ranges = m_clusters.GetRanges();
+		clusters.indices = m_clusters.GetIndices();
+		clusters.projectionScale = m_clusters.GetProjectionScale();
+		clusters.sliceScale = m_clusters.GetSliceScale();
+		clusters.sliceBias = m_clusters.GetSliceBias();
+		clusters.tilesX = m_clusters.GetTilesX();
+		clusters.tilesY = m_clusters.GetTilesY();
+		clusters.slices = m_clusters.GetSliceCount();
+	}
+
+	packet.instances = m_batcher.GetPacked();
+	packet.draws.clear();
+
+	for (size_t i = 0; i < m_batchMeshes.size(); i++) {
+
+		const auto& g = m_batcher.GetGroups()[i];
+		packet.draws.push_back({ std::move(m_batchMeshes[i]),g.start,g.count });
+	}
+
+	m_batchMeshes.clear();
+
+	m_nano.CapturePose(packet.modelPose);
+	packet.capturePath = NextCapturePath();
+	packet.isDynamicResolution = m_isDynamicResolution;
+	packet.resolutionScale = m_resolutionScale;
+	packet.targetFrameNs = (uint64_t)(1.0e9 / m_targetFps);
+	packet.imgui.Capture(m_wnd.Gfx().RenderImguiFrame());
+
+	m_pipeline.Submit();
+}
+
+void App::RenderFrame(FramePacket& packet)
+{
+	PROFILE_ZONE("App::RenderFrame");
+
+	auto& gfx = m_wnd.Gfx();
+	const uint64_t renderBegin = myTimer::SteadyClock();
+
+	//mips the last frame's draws asked for start loading, finished ones are swapped in
+	m_streamer.Update(gfx);
+
+	gfx.BeginFrame();
+	gfx.SetProjection(DirectX::XMLoadFloat4x4(&packet.projection));
+	gfx.SetCamera(DirectX::XMLoadFloat4x4(&packet.camera));
+	m_light.Bind(gfx, packet.light, gfx.GetCamera());
+
+	//every per draw transform of the frame goes up in one map
+	m_nano.Stage(packet.modelPose);
+	m_light.Stage(packet.light);
+	Bind::TransformCbuf::Flush(gfx);
+
+	m_instanceBuffer.Update(gfx, packet.instances);
+	m_clusteredLights.Update(gfx, packet.clusters);
+
+	//internal resolution from the frames measured so far, at full size the scene goes straight to the back buffer
+	const float scale = packet.isDynamicResolution ? m_scaler.GetScale() : packet.resolutionScale;
+	const unsigned int width = ResolutionScaler::ScaleSize(gfx.GetWidth(), scale);
+	const unsigned int height = ResolutionScaler::ScaleSize(gfx.GetHeight(), scale);
+	const bool isScaled = width != gfx.GetWidth() || height != gfx.GetHeight();
+	const std::string sceneTarget = isScaled ? "Scene" : "BackBuffer";
+
+	//the frame's passes, rebuilt every frame (the textures behind them are kept by gfx)
+	RenderGraph graph;
+	gfx.ImportBackBuffer(graph);
+	graph.CreateTexture("Depth", { width,height,TextureFormat::D32Float });
+
+	if (isScaled) {
+
+		graph.CreateTexture("Scene", { width,height,TextureFormat::B8G8R8A8Unorm });
+	}
+
+	graph.AddPass("Scene", [this, &packet](Graphics& gfx) {
+
+		//every lit shader reads the swarm's cluster lists
+		m_clusteredLights.Bind(gfx);
+
+		//draw all the boxes (one call per shared mesh)
+		m_instanceBuffer.Bind(gfx);
+
+		for (const auto& d : packet.draws) {
+
+			d.pMesh->DrawInstanced(gfx, d.count, d.start);
+		}
+
+		//nano boi model
+		m_nano.Draw(gfx, packet.modelPose);
+
+		//point light
+		m_light.Draw(gfx, packet.light);
+	})
+		.Clear(sceneTarget, { 0.07f,0.0f,0.12f,1.0f })
+		.ClearDepth("Depth");
+
+	if (isScaled) {
+
+		graph.AddPass("Upscale", [this](Graphics& gfx) {
+
+			m_upscaler.Draw(gfx);
+		})
+			.Read("Scene")
+			.Write("BackBuffer", RenderGraph::State::RenderTarget, RenderGraph::LoadOp::Discard);
+	}
+
+	//the scene without imgui goes to the capture ring, read back frames later
+	graph.AddPass("Capture", [this, &packet](Graphics& gfx) {
+
+		m_capture.Update(gfx, packet.capturePath);
+	})
+		.Read("BackBuffer", RenderGraph::State::CopySource)
+		.KeepAlive();
+
+	graph.AddPass("Imgui", [&packet](Graphics& gfx) {
+
+		gfx.RenderImgui(packet.imgui.Get());
+	})
+		.Write("BackBuffer");
+
+	graph.Compile();
+	gfx.Execute(graph);
+
+	//the gpu time is what the resolution moves, the render thread's cpu time stands in until timings come back
+	const uint64_t cpuNs = myTimer::SteadyClock() - renderBegin;
+	const uint64_t gpuNs = gfx.GetGpuFrameTime();
+
+	if (packet.isDynamicResolution) {
+
+		if (m_scaler.GetSettings().targetNs != packet.targetFrameNs) {
+
+			auto settings = m_scaler.GetSettings();
+			settings.targetNs = packet.targetFrameNs;
+			m_scaler.SetSettings(settings);
+		}
+
+		m_scaler.Update(gpuNs != 0u ? gpuNs : cpuNs);
+	}
+	else {
+
+		//picks up from the fixed scale when switched back on
+		m_scaler.Reset(packet.resolutionScale);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_resolutionMutex);
+		m_resolutionStatus = { scale,width,height,gpuNs,cpuNs };
+	}
+
 	//present
-	m_wnd.Gfx().EndFrame();
+	gfx.EndFrame();
 }
 void App::ShowImguiHelpWindow() noexcept
 {
@@ -312,41 +844,108 @@ void App::ShowImguiHelpWindow() noexcept
 
 		ImGui::Text("F2: Enable/Disable Mouse Cursor");
 		ImGui::Text("F3: Enable/Disable Raw Input");
+		ImGui::Text("F9: Screenshot");
 	}
 	ImGui::End();
 
 
 }
-void App::SpawnSimulationWindow() noexcept
+void App::SpawnSimulationWindow()
 {
 
 	if (ImGui::Begin("Simulation Speed")) {
 
 		ImGui::SliderFloat("Speed Factor", &m_speedFactor, 0.0f, 6.0f, "%.4f", 3.2f);
 		ImGui::Text("%.3f ms/frame (%.1f fps)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+
+		//fixed step rate, the speed factor changes how many steps a frame runs rather than their length
+		int stepRate = (int)std::lround(1.0f / m_timestep.GetStep());
+
+		if (ImGui::SliderInt("Step Rate (Hz)", &stepRate, 30, 240)) {
+
+			m_timestep.SetStep(1.0 / stepRate);
+		}
+
+		ImGui::Text("%u steps this frame (max %u), %.2f s dropped", m_timestep.GetLastStepCount(), m_timestep.GetLastMaxStepCount(), m_timestep.GetDroppedTime());
 		ImGui::Text("StatusF%s", m_wnd.kbd.KeyIsPressed(VK_SPACE) ? "Pause" : "Running(hold spacebar to pause)");
 
+		//object count, the scene is rebuilt on respawn
+		//*up to the 100k+ the simulation, culling and batching are built for, ctrl+click to type an exact count
+		int nObjects = (int)m_nDrawables;
+
+		if (ImGui::SliderInt("Objects", &nObjects, 1, 200000)) {
+
+			m_nDrawables = (size_t)nObjects;
+		}
+
+		if (ImGui::Button("Respawn")) {
+
+			//resources are created here, keep the render thread out of the device meanwhile
+			m_pipeline.WaitIdle();
+			SpawnTestObjects(m_nDrawables);
+		}
+
+		ImGui::Text("%d/%d objects visible in %d draw calls", (int)m_batcher.GetInstanceCount(), (int)m_drawables.size(), (int)m_batcher.GetGroups().size());
+
+		//frustum query on the BVH or the bounding sphere test on every object
+		ImGui::Checkbox("Spatial Index Culling", &m_isSpatialIndex);
+
+		const auto& bvhStats = m_bvh.GetStats();
+		ImGui::Text("BVH: %d nodes, cost %.1f (%.1f built), %u rebuilds", (int)bvhStats.nodes, bvhStats.cost, bvhStats.builtCost, bvhStats.nRebuilds);
+		ImGui::Text("Spatial index update and query: %.3f ms", m_spatialIndexNs * 1.0e-6);
+		ImGui::Text("Job threads: %u", m_jobs.GetThreadCount());
+
 	}
 	ImGui::End();
 
 }
 
-void App::SpawnBoxWindowManagerWindow() noexcept
+void App::SpawnBoxWindowManagerWindow()
 {
 	//imgui windows to control box instance parameters
 	if (ImGui::Begin("Boxes")) {
 
-		const auto preview = m_comboBoxIndex ? std::to_string(*m_comboBoxIndex) : "Choose Box";
+		//selected box was despawned elsewhere
+		if (m_comboBox && !m_sim.IsValid(*m_comboBox)) {
+
+			m_comboBox.reset();
+		}
+
+		//only the boxes around the camera are listed, nearest first
+		ImGui::SliderFloat("Search Radius", &m_boxSearchRadius, 1.0f, 80.0f, "%.1f");
+
+		const auto eye = m_camera.GetPosition();
+		m_bvh.QuerySphere(eye, m_boxSearchRadius, m_nearbyObjects);
+		m_nearbyBoxes.clear();
+
+		for (const uint32_t i : m_nearbyObjects) {
+
+			//the index is a frame old after a respawn
+			if (i < m_drawables.size() && dynamic_cast<Box*>(m_drawables[i].get())) {
+
+				const auto& transform = m_sim.GetTransform(i);
+				const float dx = transform._41 - eye.x;
+				const float dy = transform._42 - eye.y;
+				const float dz = transform._43 - eye.z;
+
+				m_nearbyBoxes.push_back({ std::sqrt(dx * dx + dy * dy + dz * dz),m_sim.GetHandle(i) });
+			}
+		}
+
+		std::sort(m_nearbyBoxes.begin(), m_nearbyBoxes.end());
+
+		const auto preview = m_comboBox ? "Box " + std::to_string(m_comboBox->index) : "Choose Box";
 
 		if (ImGui::BeginCombo("Box Number", preview.c_str())) {
 
-			for (int i = 0; i < m_boxes.size(); i++) {
+			for (const auto& [distance, handle] : m_nearbyBoxes) {
 
-				const bool isSelected = *m_comboBoxIndex == i;
+				const bool isSelected = m_comboBox == handle;
+				const auto label = "Box " + std::to_string(handle.index) + " (" + std::to_string((int)std::lround(distance)) + ")";
 
-				if (ImGui::Selectable(std::to_string(i).c_str(), isSelected)) {
+				if (ImGui::Selectable(label.c_str(), isSelected)) {
 
-					m_comboBoxIndex = i;
+					m_comboBox = handle;
 				}
 
 				if (isSelected) {
@@ -359,13 +958,37 @@ void App::SpawnBoxWindowManagerWindow() noexcept
 			ImGui::EndCombo();
 		}
 
-		if (ImGui::Button("Spawn Control Window") && m_comboBoxIndex) {
+		if (ImGui::Button("Spawn Control Window") && m_comboBox) {
+
+			m_boxControlIDs.insert(*m_comboBox);
+
+			m_comboBox.reset();
+		}
+
+		//spawning and despawning never shifts other objects' handles
+		if (ImGui::Button("Spawn Box")) {
+
+			m_pipeline.WaitIdle();
+			SpawnTestObject(m_pFactory->MakeBox());
+		}
+
+		ImGui::SameLine();
 
-			m_boxControlIDs.insert(*m_comboBoxIndex);
+		if (ImGui::Button("Despawn Box") && m_comboBox) {
 
-			m_comboBoxIndex.reset();
+			m_pipeline.WaitIdle();
+
+			const auto it = std::find(m_boxes.begin(), m_boxes.end(), *m_comboBox);
+
+			std::swap(*it, m_boxes.back());
+			m_boxes.pop_back();
+
+			DespawnTestObject(*m_comboBox);
+			m_comboBox.reset();
 		}
 
+		ImGui::Text("Click a box with the cursor shown to open its window");
+
 
 	}
 
@@ -376,7 +999,26 @@ void App::SpawnBoxWindows() noexcept
 	//imgui box attribute control windows
 	for (auto i = m_boxControlIDs.begin(); i != m_boxControlIDs.end();) {
 
-		if (!m_boxes[*i]->SpawnControlWindow(*i, m_wnd.Gfx())) {
+		//window outlived its box
+		if (!m_sim.IsValid(*i)) {
+
+			i = m_boxControlIDs.erase(i);
+			continue;
+		}
+
+		//only box handles end up in the control id set
+		auto& box = static_cast<Box&>(*m_drawables[m_sim.GetIndex(*i)]);
+		auto motion = m_sim.GetMotion(*i);
+
+		bool isOpen = true;
+
+		//writing the motion restarts the object's interpolation, so only when a slider actually moved
+		if (box.SpawnControlWindow((int)i->index, motion, isOpen)) {
+
+			m_sim.SetMotion(*i, motion);
+		}
+
+		if (!isOpen) {
 
 			i = m_boxControlIDs.erase(i);
 		}
@@ -411,11 +1053,274 @@ void App::ShowRawInputWindow()
 		ImGui::Text("Tally: (%d,%d)", x, y);
 		ImGui::Text("Cursor: %s", m_wnd.GetCursorEnabled() ? "enabled" : "disabled");
 		ImGui::Text("On/Off: %s", m_wnd.mouse.GetRawEnabled() ? "enabled" : "disabled");
+		//events the buffers had no room for
+		ImGui::Text("Dropped: %llu mouse, %llu raw, %llu key, %llu char",
+			(unsigned long long)m_wnd.mouse.GetOverflowCount(), (unsigned long long)m_wnd.mouse.GetRawOverflowCount(),
+			(unsigned long long)m_wnd.kbd.GetKeyOverflowCount(), (unsigned long long)m_wnd.kbd.GetCharOverflowCount());
+	}
+	ImGui::End();
+
+}
+
+
+void App::SpawnCaptureWindow()
+{
+	static const char* formats[] = { "PNG","QOI" };
+
+	if (ImGui::Begin("Capture")) {
+
+		int screenshotFormat = (int)m_screenshotFormat;
+
+		if (ImGui::Combo("Screenshot Format", &screenshotFormat, formats, IM_ARRAYSIZE(formats))) {
+
+			m_screenshotFormat = (ImageEncoder::Format)screenshotFormat;
+		}
+
+		if (ImGui::Button("Screenshot (F9)")) {
+
+			m_isScreenshotRequested = true;
+		}
+
+		ImGui::Separator();
+
+		//QOI keeps up with the frame rate where PNG drops frames
+		int sequenceFormat = (int)m_sequenceFormat;
+
+		if (ImGui::Combo("Sequence Format", &sequenceFormat, formats, IM_ARRAYSIZE(formats))) {
+
+			m_sequenceFormat = (ImageEncoder::Format)sequenceFormat;
+		}
+
+		if (ImGui::Checkbox("Record Sequence", &m_isRecording) && m_isRecording) {
+
+			m_sequenceDir = (std::filesystem::path(captureDir) / ("sequence_" + GetTimeStamp())).string();
+			m_sequenceFrame = 0u;
+		}
+
+		if (m_isRecording) {
+
+			ImGui::Text("%u frames to %s", m_sequenceFrame, m_sequenceDir.c_str());
+		}
+
+		ImGui::Separator();
+
+		const auto stats = m_capture.GetStats();
+
+		ImGui::Text("%d captured, %d written, %d dropped, %d failed", (int)stats.captured, (int)stats.written, (int)stats.dropped, (int)stats.failed);
+
+		if (!stats.lastFile.empty()) {
+
+			ImGui::Text("Last: %s", stats.lastFile.c_str());
+		}
+
+		if (!stats.lastError.empty()) {
+
+			ImGui::TextColored({ 1.0f,0.4f,0.4f,1.0f }, "Error: %s", stats.lastError.c_str());
+		}
+	}
+	ImGui::End();
+}
+
+void App::SpawnProfilerWindow()
+{
+	if (ImGui::Begin("Profiler")) {
+
+#if PROFILER_ENABLED
+		bool isPaused = Profiler::IsPaused();
+
+		if (ImGui::Checkbox("Pause", &isPaused)) {
+
+			Profiler::SetPaused(isPaused);
+		}
+
+		ImGui::SameLine();
+
+		//every zone still in the rings, a few hundred frames worth
+		if (ImGui::Button("Save Trace")) {
+
+			const auto path = (std::filesystem::path(captureDir) / ("trace_" + GetTimeStamp() + ".json")).string();
+
+			try {
+
+				std::filesystem::create_directories(captureDir);
+				Profiler::SaveChromeTrace(path);
+				m_traceStatus = "Saved " + path;
+			}
+			catch (const std::exception& e) {
+
+				m_traceStatus = e.what();
+			}
+		}
+
+		if (!m_traceStatus.empty()) {
+
+			ImGui::TextUnformatted(m_traceStatus.c_str());
+		}
+
+		ImGui::Separator();
+
+		Profiler::ShowFrame();
+#else
+		ImGui::Text("Zones are compiled out of this build (see PROFILER_ENABLED in Profiler.h)");
+#endif
+	}
+	ImGui::End();
+}
+
+void App::SpawnFrameStatsWindow()
+{
+	if (ImGui::Begin("Frame Stats")) {
+
+		const auto save = [this](const char* extension, void (FrameStats::*pSave)(const std::string&) const) {
+
+			const auto path = (std::filesystem::path(captureDir) / ("frames_" + GetTimeStamp() + extension)).string();
+
+			try {
+
+				std::filesystem::create_directories(captureDir);
+				(m_frameStats.*pSave)(path);
+				m_frameStatsStatus = "Saved " + path;
+			}
+			catch (const std::exception& e) {
+
+				m_frameStatsStatus = e.what();
+			}
+		};
+
+		if (ImGui::Button("Save CSV")) {
+
+			save(".csv", &FrameStats::SaveCsv);
+		}
+
+		ImGui::SameLine();
+
+		if (ImGui::Button("Save JSON")) {
+
+			save(".json", &FrameStats::SaveJson);
+		}
+
+		if (!m_frameStatsStatus.empty()) {
+
+			ImGui::TextUnformatted(m_frameStatsStatus.c_str());
+		}
+
+		ImGui::Separator();
+
+		m_frameStats.ShowStats();
 	}
 	ImGui::End();
+}
+
+void App::SpawnOcclusionWindow()
+{
+	if (ImGui::Begin("Occlusion")) {
+
+		ImGui::Checkbox("Enabled", &m_isOcclusionCulling);
+		ImGui::SliderInt("Box occluders", &m_maxOccluders, 0, 512);
+
+		//levels above what the cpu runs are clamped down
+		int isa = (int)m_occlusion.GetIsa();
+
+		if (ImGui::Combo("Kernel", &isa, "Scalar\0SSE2\0AVX2\0")) {
+
+			m_occlusion.SetIsa((PixelKernels::Isa)isa);
+		}
+
+		if (m_isOcclusionCulling) {
+
+			const auto& stats = m_occlusion.GetStats();
+
+			ImGui::Text("%d occluders, %d of %d triangles drawn", (int)stats.occluders, (int)stats.drawnTriangles, (int)stats.triangles);
+			ImGui::Text("%d objects occluded", (int)m_nOccluded);
+			ImGui::Text("%.3f ms at %ux%u", m_occlusionNs * 1.0e-6, m_occlusion.GetWidth(), m_occlusion.GetHeight());
+		}
+	}
+	ImGui::End();
+}
+
+void App::SpawnLightClustersWindow()
+{
+	if (ImGui::Begin("Light Clusters")) {
+
+		//this frame's lights are already built at the old count, the swarm is respawned next frame
+		if (ImGui::SliderInt("Lights", &m_nClusterLights, 0, 4096)) {
+
+			m_isRespawnClusterLights = true;
+		}
+
+		ImGui::SliderFloat("Range", &m_clusterLightRange, 0.5f, 10.0f, "%.1f");
+		ImGui::SliderFloat("Intensity", &m_clusterLightIntensity, 0.0f, 20.0f, "%.1f");
 
+		//levels above what the cpu runs are clamped down
+		int isa = (int)m_clusters.GetIsa();
+
+		if (ImGui::Combo("Kernel", &isa, "Scalar\0SSE2\0AVX2\0")) {
+
+			m_clusters.SetIsa((PixelKernels::Isa)isa);
+		}
+
+		const auto& stats = m_clusters.GetStats();
+		const size_t nClusters = m_clusters.GetClusterCount();
+
+		ImGui::Text("%d of %d lights in the frustum", (int)stats.visibleLights, (int)stats.lights);
+		ImGui::Text("%d indices, %.1f per cluster, at most %u", (int)stats.indices, (double)stats.indices / nClusters, stats.maxClusterLights);
+		ImGui::Text("%.3f ms over %ux%ux%u clusters", m_clusterNs * 1.0e-6, m_clusters.GetTilesX(), m_clusters.GetTilesY(), m_clusters.GetSliceCount());
+	}
+	ImGui::End();
 }
 
+void App::SpawnResolutionWindow()
+{
+	if (ImGui::Begin("Resolution")) {
+
+		ImGui::Checkbox("Dynamic", &m_isDynamicResolution);
+
+		if (m_isDynamicResolution) {
+
+			ImGui::SliderFloat("Target FPS", &m_targetFps, 30.0f, 144.0f, "%.0f");
+		}
+		else {
+
+			ImGui::SliderFloat("Scale", &m_resolutionScale, 0.25f, 1.0f, "%.2f");
+		}
+
+		ResolutionStatus status;
+		{
+			std::lock_guard<std::mutex> lock(m_resolutionMutex);
+			status = m_resolutionStatus;
+		}
+
+		ImGui::Text("Drawing at %ux%u (%.0f%%)", status.width, status.height, status.scale * 100.0f);
+		ImGui::Text("GPU: %.2f ms  Render thread: %.2f ms", status.gpuNs * 1.0e-6, status.cpuNs * 1.0e-6);
+	}
+	ImGui::End();
+}
+
+std::string App::NextCapturePath()
+{
+	//every frame of a sequence is captured, a screenshot would only be the same frame again
+	if (m_isRecording) {
+
+		m_isScreenshotRequested = false;
+
+		std::ostringstream name;
+		name << "frame_" << std::setw(6) << std::setfill('0') << m_sequenceFrame++ << ImageEncoder::GetExtension(m_sequenceFormat);
+
+		return (std::filesystem::path(m_sequenceDir) / name.str()).string();
+	}
+
+	if (m_isScreenshotRequested) {
+
+		m_isScreenshotRequested = false;
+
+		std::ostringstream name;
+		name << "screenshot_" << GetTimeStamp() << "_" << m_nScreenshots++ << ImageEncoder::GetExtension(m_screenshotFormat);
+
+		return (std::filesystem::path(captureDir) / name.str()).string();
+	}
+
+	return {};
+}
 
 App::~App()
 {
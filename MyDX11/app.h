@@ -1,11 +1,28 @@
 #pragma once
 #include "Window.h"
-#include "myTimer.h"
+#include "FrameStats.h"
 #include "imguiManager.h"
 #include "camera.h"
 #include "PointLight.h"
 #include "Model.h"
+#include "InstanceBatcher.h"
+#include "InstanceBuffer.h"
+#include "ObjectSimulation.h"
+#include "JobSystem.h"
+#include "FramePipeline.h"
+#include "TextureStreamer.h"
+#include "FrameCapture.h"
+#include "ImageEncoder.h"
+#include "Profiler.h"
+#include "FixedTimestep.h"
+#include "ResolutionScaler.h"
+#include "Upscaler.h"
+#include "OcclusionCuller.h"
+#include "DynamicBvh.h"
+#include "LightClusters.h"
+#include "ClusteredLights.h"
 #include <set>
+#include <mutex>
 
 class App {
 
@@ -23,43 +40,170 @@ public:
 private:
 	void DoFrame();
 
+	//runs on the render thread, the only place the device context is used
+	void RenderFrame(FramePacket& packet);
+
+	//file this frame is captured to, empty for none
+	std::string NextCapturePath();
+
+	//(re)create the test objects
+	void SpawnTestObjects(size_t count);
+	//(re)create the swarm of clustered lights
+	void SpawnClusterLights(size_t count);
+
+	//objects and the simulation share one dense order, both are updated together
+	ObjectSimulation::Handle SpawnTestObject(std::unique_ptr<class TestObject> pObject);
+	void DespawnTestObject(ObjectSimulation::Handle handle) noexcept;
+
+	//marks the objects the frustum kept that are hidden behind the occluders
+	void CullOccluded(DirectX::FXMMATRIX viewProj);
+	//opens the control window of the box under a cursor position in client pixels
+	void PickBox(int x, int y);
+	//moves the swarm and fills the cluster grid with its lights
+	void AssignClusterLights(DirectX::FXMMATRIX view, unsigned int nSteps, float step, float alpha);
+
 	//imgui windows management
 	void ShowImguiHelpWindow() noexcept;
 
-	void SpawnSimulationWindow() noexcept;
-	void SpawnBoxWindowManagerWindow() noexcept;
+	void SpawnSimulationWindow();
+	void SpawnBoxWindowManagerWindow();
 	void SpawnBoxWindows() noexcept;
 	void ShowImguiDemoWindow();
 	void ShowRawInputWindow();
+	void SpawnCaptureWindow();
+	void SpawnProfilerWindow();
+	void SpawnFrameStatsWindow();
+	void SpawnResolutionWindow();
+	void SpawnOcclusionWindow();
+	void SpawnLightClustersWindow();
 
 private:
 	ImguiManager imgui;
 
+	//worker pool shared by the per frame systems
+	JobSystem m_jobs;
+
 	Window m_wnd;
-	myTimer m_timer;
+	//times the frames and keeps their percentiles and hitches
+	FrameStats m_frameStats;
 
 	//speed factor
 	float m_speedFactor = 1.0f;
 
+	//the simulation advances in fixed steps, rendering blends between the last two
+	FixedTimestep m_timestep;
+
 	//camera
 	Camera m_camera;
+	DirectX::XMFLOAT4X4 m_projection;
 
 	//point light
 	PointLight m_light;
 
 	//Drawable
-	std::vector<std::unique_ptr<class Drawable>> m_drawables;
-	std::vector<class Box*> m_boxes;
-	static constexpr size_t m_nDrawables = 45;
-
-	Model m_nano{ m_wnd.Gfx(),"asset\\model\\nano_textured\\nanosuit.obj" };
+	class Factory;
+	std::unique_ptr<Factory> m_pFactory;
+	ObjectSimulation m_sim;
+	std::vector<std::unique_ptr<class TestObject>> m_drawables;
+	std::vector<ObjectSimulation::Handle> m_boxes;
+	size_t m_nDrawables = 45;
+
+	//instancing, objects sharing a mesh are drawn in one call
+	InstanceBatcher m_batcher;
+	//the batches' meshes, taken as soon as they're packed so a window despawning objects can't free one before the packet holds it
+	std::vector<std::shared_ptr<const InstancedMesh>> m_batchMeshes;
+	Bind::InstanceBuffer<InstanceData> m_instanceBuffer{ m_wnd.Gfx(),(UINT)m_nDrawables };
+
+	//model textures start at their low mips and stream in with distance
+	TextureStreamer m_streamer{ m_jobs };
+	Model m_nano{ m_wnd.Gfx(),"asset\\model\\nano_textured\\nanosuit.obj",&m_jobs,&m_streamer };
+
+	//the model and the boxes nearest to filling the screen are drawn into a small CPU depth buffer,
+	//objects entirely behind them are left out of the batches
+	OcclusionCuller m_occlusion;
+	OcclusionCuller::OccluderMesh m_boxOccluder = OcclusionCuller::OccluderMesh::MakeBox();
+	bool m_isOcclusionCulling = true;
+	int m_maxOccluders = 64;
+	//parallel to m_drawables
+	std::vector<uint8_t> m_isOccluded;
+	//box occluders by how much of the screen they cover, and their dense index
+	std::vector<std::pair<float, size_t>> m_occluderCandidates;
+	size_t m_nOccluded = 0u;
+	uint64_t m_occlusionNs = 0u;
+
+	//objects' bounding spheres in a BVH refit every frame, the frustum, the boxes list and picking query it
+	//instead of going through every object
+	DynamicBvh m_bvh;
+	bool m_isSpatialIndex = true;
+	//dense indices of the objects in the frustum this frame
+	std::vector<uint32_t> m_visibleObjects;
+	//boxes near the camera for the boxes list, and their distance
+	std::vector<uint32_t> m_nearbyObjects;
+	std::vector<std::pair<float, ObjectSimulation::Handle>> m_nearbyBoxes;
+	float m_boxSearchRadius = 15.0f;
+	uint64_t m_spatialIndexNs = 0u;
+
+	//swarm of small point lights orbiting with the objects, simulated like them
+	//the frustum is split into clusters and every pixel only shades the lights the CPU found reaching its cluster
+	ObjectSimulation m_lightSim;
+	std::vector<DirectX::XMFLOAT3> m_lightColors;
+	int m_nClusterLights = 1024;
+	//set by the window, the swarm is respawned at the start of the next assignment
+	bool m_isRespawnClusterLights = false;
+	float m_clusterLightRange = 4.0f;
+	float m_clusterLightIntensity = 3.0f;
+	LightClusters m_clusters;
+	//view space spheres of this frame's lights
+	std::vector<LightClusters::Light> m_clusterLights;
+	uint64_t m_clusterNs = 0u;
 
 
 	//Combo Box control 
-	std::optional<int> m_comboBoxIndex;
-	std::set<int> m_boxControlIDs;
+	std::optional<ObjectSimulation::Handle> m_comboBox;
+	std::set<ObjectSimulation::Handle> m_boxControlIDs;
 
 	//raw input data
 	int x = 0, y = 0;
 
+	//screenshots and frame sequences, encoded and written off the frame loop
+	FrameCapture m_capture{ m_wnd.Gfx() };
+	ImageEncoder::Format m_screenshotFormat = ImageEncoder::Format::Png;
+	ImageEncoder::Format m_sequenceFormat = ImageEncoder::Format::Qoi;
+	bool m_isScreenshotRequested = false;
+	unsigned int m_nScreenshots = 0u;
+	bool m_isRecording = false;
+	std::string m_sequenceDir;
+	unsigned int m_sequenceFrame = 0u;
+
+	//result of the last trace save, shown in the profiler window
+	std::string m_traceStatus;
+
+	//result of the last frame stats save
+	std::string m_frameStatsStatus;
+
+	//dynamic resolution, set on the simulation thread and handed over in the packet
+	bool m_isDynamicResolution = true;
+	float m_resolutionScale = 1.0f;
+	float m_targetFps = 60.0f;
+
+	//render thread only, the scene is drawn smaller and stretched over the back buffer
+	ResolutionScaler m_scaler;
+	Upscaler m_upscaler{ m_wnd.Gfx() };
+	ClusteredLights m_clusteredLights{ m_wnd.Gfx() };
+
+	//what the render thread last drew at, for the window
+	struct ResolutionStatus {
+
+		float scale = 1.0f;
+		unsigned int width = 0u;
+		unsigned int height = 0u;
+		uint64_t gpuNs = 0u;
+		uint64_t cpuNs = 0u;
+	};
+
+	mutable std::mutex m_resolutionMutex;
+	ResolutionStatus m_resolutionStatus;
+
+	//declared last so the render thread stops before anything it draws is destroyed
+	FramePipeline m_pipeline{ [this](FramePacket& packet) { RenderFrame(packet); } };
 };
\ No newline at end of file
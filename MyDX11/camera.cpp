@@ -26,6 +26,11 @@ DirectX::XMMATRIX Camera::GetMatrix() const noexcept
 	
 }
 
+DirectX::XMFLOAT3 Camera::GetPosition() const noexcept
+{
+	return position;
+}
+
 void Camera::SpawnControlWindow() noexcept
 {
 	if (ImGui::Begin("Camera")) {
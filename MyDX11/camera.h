@@ -11,6 +11,7 @@ public:
 	Camera() noexcept;
 
 	DirectX::XMMATRIX GetMatrix() const noexcept;
+	DirectX::XMFLOAT3 GetPosition() const noexcept;
 	void SpawnControlWindow() noexcept;
 	void Reset() noexcept;
 
@@ -4,6 +4,8 @@
 #include <d3dcompiler.h>
 #include <DirectXMath.h>
 #include "GraphicsThrowMacros.h"
+#include "Profiler.h"
+#include <algorithm>
 #include "imgui/imgui_impl_dx11.h"
 #include "imgui/imgui_impl_win32.h"
 
@@ -16,7 +18,11 @@ namespace dx = DirectX;				//DirectX custom short form
 
 
 
-Graphics::Graphics(HWND hWnd,int width,int height) {
+Graphics::Graphics(HWND hWnd,int width,int height)
+	:
+	width((UINT)width),
+	height((UINT)height)
+{
 
 	//required structure configuration information
 	
@@ -82,15 +88,21 @@ Graphics::Graphics(HWND hWnd,int width,int height) {
 	));
 
 	//gain access to texture subresource in swap chain (back buffer)
-	wrl::ComPtr<ID3D11Resource> pBackBuffer = nullptr;
-	GFX_THROW_INFO(pSwap->GetBuffer(0, __uuidof(ID3D11Resource), &pBackBuffer));
+	GFX_THROW_INFO(pSwap->GetBuffer(0, __uuidof(ID3D11Texture2D), &pBackBuffer));
 	GFX_THROW_INFO(pDevice->CreateRenderTargetView(
 		pBackBuffer.Get(),
 		nullptr,
 		&pTarget
 	));
 
-	//create depth stencil  buffer
+	//the graph binds the back buffer through the same view
+	auto& backBuffer = importedTextures[pBackBuffer.Get()];
+	backBuffer.desc = { (UINT)width,(UINT)height,TextureFormat::B8G8R8A8Unorm };
+	backBuffer.bindFlags = D3D11_BIND_RENDER_TARGET;
+	backBuffer.pTexture = pBackBuffer;
+	backBuffer.pTargetView = pTarget;
+
+	//depth test state, the depth buffer itself is a render graph texture
 	D3D11_DEPTH_STENCIL_DESC dsDesc = {};
 	dsDesc.DepthEnable = TRUE;
 	dsDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
@@ -103,35 +115,6 @@ Graphics::Graphics(HWND hWnd,int width,int height) {
 	//bind depth state
 	pContext->OMSetDepthStencilState(pDSState.Get(), 1u);
 
-	//create depth stencil texture
-	wrl::ComPtr<ID3D11Texture2D> pDepthStencil;
-	D3D11_TEXTURE2D_DESC descDepth = {};
-	descDepth.Width = width;
-	descDepth.Height = height;
-	descDepth.MipLevels = 1u;
-	descDepth.ArraySize = 1u;
-	descDepth.Format = DXGI_FORMAT_D32_FLOAT;	//D32 is a special format for depth in 32bit
-	
-	//sample describtor for anti-analising processing
-	descDepth.SampleDesc.Count = 1u;		//
-	descDepth.SampleDesc.Quality = 0u;		//
-
-	descDepth.Usage = D3D11_USAGE_DEFAULT;
-	descDepth.BindFlags = D3D11_BIND_DEPTH_STENCIL;
-
-	GFX_THROW_INFO(pDevice->CreateTexture2D(&descDepth, nullptr, &pDepthStencil));
-
-	//create view of depth stencil texture
-	D3D11_DEPTH_STENCIL_VIEW_DESC descDSV = {};
-	descDSV.Format = DXGI_FORMAT_D32_FLOAT;
-	descDSV.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2D;
-	descDSV.Texture2D.MipSlice = 0u;
-
-	GFX_THROW_INFO(pDevice->CreateDepthStencilView(pDepthStencil.Get(), &descDSV, &pDSV));
-
-	//bind stencil view to OM
-	pContext->OMSetRenderTargets(1u, pTarget.GetAddressOf(), pDSV.Get());
-
 	//conffigure viewport
 	D3D11_VIEWPORT vp;
 	vp.Width = (float)width;
@@ -143,6 +126,18 @@ Graphics::Graphics(HWND hWnd,int width,int height) {
 
 	pContext->RSSetViewports(1u, &vp);
 
+	//gpu frame timing
+	for (auto& timing : gpuTimings) {
+
+		D3D11_QUERY_DESC queryDesc = {};
+		queryDesc.Query = D3D11_QUERY_TIMESTAMP_DISJOINT;
+		GFX_THROW_INFO(pDevice->CreateQuery(&queryDesc, &timing.pDisjoint));
+
+		queryDesc.Query = D3D11_QUERY_TIMESTAMP;
+		GFX_THROW_INFO(pDevice->CreateQuery(&queryDesc, &timing.pBegin));
+		GFX_THROW_INFO(pDevice->CreateQuery(&queryDesc, &timing.pEnd));
+	}
+
 	//Init imgui d3d impl
 	ImGui_ImplDX11_Init(pDevice.Get(), pContext.Get());
 
@@ -150,14 +145,7 @@ Graphics::Graphics(HWND hWnd,int width,int height) {
 
 void Graphics::EndFrame()
 {
-	//imgui frame end
-	if (imguiEnabled) {
-
-		ImGui::Render();
-		ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData());
-
-	}
-
+	PROFILE_ZONE("Graphics::EndFrame");
 
 	HRESULT hr;
 
@@ -186,21 +174,322 @@ void Graphics::EndFrame()
 
 }
 
-void Graphics::BeginFrame(float red, float green, float blue) noexcept
+void Graphics::BeginFrame() noexcept
 {
-	//imgui begin frame
-	if (imguiEnabled) {
-		ImGui_ImplDX11_NewFrame();
-		ImGui_ImplWin32_NewFrame();
-		ImGui::NewFrame();
+	pixelViews.fill(nullptr);
+	pPixelSampler = nullptr;
+}
+
+void Graphics::ImportBackBuffer(RenderGraph& graph, const std::string& name) const
+{
+	graph.ImportTexture(name, { width,height,TextureFormat::B8G8R8A8Unorm }, pBackBuffer.Get());
+	graph.MarkOutput(name);
+}
+
+void Graphics::Execute(const RenderGraph& graph)
+{
+	PROFILE_ZONE("Graphics::Execute");
+
+	using State = RenderGraph::State;
+
+	if (!graph.IsCompiled()) {
+
+		throw RenderGraph::Exception(__LINE__, __FILE__, "Graph executed before it was compiled");
+	}
+
+	nExecutes++;
+
+	//oldest timings first, a set still in flight stops the walk so the newest result wins
+	for (size_t i = 0; i < gpuTimings.size(); i++) {
+
+		auto& timing = gpuTimings[(nextGpuTiming + i) % gpuTimings.size()];
+
+		if (!timing.isPending) {
+
+			continue;
+		}
+
+		D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint;
+		UINT64 begin;
+		UINT64 end;
+
+		if (pContext->GetData(timing.pDisjoint.Get(), &disjoint, sizeof(disjoint), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK ||
+			pContext->GetData(timing.pBegin.Get(), &begin, sizeof(begin), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK ||
+			pContext->GetData(timing.pEnd.Get(), &end, sizeof(end), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK) {
+
+			break;
+		}
+
+		timing.isPending = false;
+
+		//disjoint means the clock changed meanwhile (power state), that frame's numbers mean nothing
+		if (!disjoint.Disjoint && disjoint.Frequency > 0u && end >= begin) {
+
+			gpuFrameTime = (uint64_t)((double)(end - begin) * 1.0e9 / (double)disjoint.Frequency);
+		}
+	}
+
+	//with every set still waiting this frame goes untimed
+	auto& gpuTiming = gpuTimings[nextGpuTiming];
+	const bool isTimed = !gpuTiming.isPending;
+
+	if (isTimed) {
+
+		pContext->Begin(gpuTiming.pDisjoint.Get());
+		pContext->End(gpuTiming.pBegin.Get());
+	}
+
+	//a pooled texture of the same kind for every allocation, each backs one allocation at most
+	const auto& allocations = graph.GetAllocations();
+	std::vector<size_t> pooled(allocations.size());
+	std::vector<bool> isTaken(graphTextures.size(), false);
+
+	for (size_t a = 0; a < allocations.size(); a++) {
+
+		const auto& allocation = allocations[a];
+
+		const UINT bindFlags =
+			(allocation.isRenderTarget ? D3D11_BIND_RENDER_TARGET : 0u) |
+			(allocation.isDepthStencil ? D3D11_BIND_DEPTH_STENCIL : 0u) |
+			(allocation.isShaderResource ? D3D11_BIND_SHADER_RESOURCE : 0u);
+
+		pooled[a] = graphTextures.size();
+
+		for (size_t i = 0; i < graphTextures.size(); i++) {
+
+			if (!isTaken[i] && graphTextures[i].desc == allocation.desc && (graphTextures[i].bindFlags & bindFlags) == bindFlags) {
+
+				pooled[a] = i;
+				break;
+			}
+		}
+
+		if (pooled[a] == graphTextures.size()) {
+
+			GraphTexture texture;
+			texture.desc = allocation.desc;
+			CreateGraphViews(texture, bindFlags);
+
+			graphTextures.push_back(std::move(texture));
+			isTaken.push_back(false);
+		}
+
+		isTaken[pooled[a]] = true;
+		graphTextures[pooled[a]].lastUsed = nExecutes;
+	}
+
+	const auto& resources = graph.GetResources();
+
+	const auto getTexture = [&](size_t r, State state) -> GraphTexture& {
+
+		const auto& resource = resources[r];
+
+		if (!resource.isImported) {
+
+			return graphTextures[pooled[resource.allocation]];
+		}
+
+		auto& texture = importedTextures[resource.pImported];
+
+		if (texture.pTexture == nullptr) {
+
+			texture.desc = resource.desc;
+			texture.pTexture = static_cast<ID3D11Texture2D*>(resource.pImported);
+		}
+
+		CreateGraphViews(texture,
+			state == State::RenderTarget ? D3D11_BIND_RENDER_TARGET :
+			state == State::DepthWrite || state == State::DepthRead ? D3D11_BIND_DEPTH_STENCIL :
+			state == State::ShaderResource ? D3D11_BIND_SHADER_RESOURCE : 0u);
+
+		return texture;
+	};
+
+	std::array<ID3D11ShaderResourceView*, D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT> nullViews = {};
+	UINT nBoundViews = 0u;
+
+	//d3d11 resolves read/write hazards by itself but the debug layer complains, so targets and views come off before any state change
+	const auto unbind = [&]() {
+
+		pContext->OMSetRenderTargets(0u, nullptr, nullptr);
+		pContext->PSSetShaderResources(0u, nBoundViews, nullViews.data());
+
+		for (UINT i = 0; i < nBoundViews && i < pixelViews.size(); i++) {
+
+			pixelViews[i] = nullptr;
+		}
+
+		nBoundViews = 0u;
+	};
+
+	for (const auto& step : graph.GetSteps()) {
+
+		if (!step.transitions.empty()) {
+
+			unbind();
+		}
+
+		for (const auto& clear : step.clears) {
+
+			auto& texture = getTexture(clear.resource, clear.state);
+
+			if (clear.state == State::RenderTarget) {
+
+				pContext->ClearRenderTargetView(texture.pTargetView.Get(), clear.clearValue.data());
+			}
+			else {
+
+				const UINT flags = D3D11_CLEAR_DEPTH | (texture.desc.format == TextureFormat::D24UnormS8Uint ? D3D11_CLEAR_STENCIL : 0u);
+				pContext->ClearDepthStencilView(texture.pDepthView.Get(), flags, clear.clearValue[0], 0u);
+			}
+		}
+
+		if (!step.renderTargets.empty() || step.depthStencil != RenderGraph::npos) {
+
+			std::array<ID3D11RenderTargetView*, D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT> targets = {};
+			ID3D11DepthStencilView* pDepthView = nullptr;
+			RenderGraph::TextureDesc desc;
+
+			for (size_t i = 0; i < step.renderTargets.size(); i++) {
+
+				auto& texture = getTexture(step.renderTargets[i], State::RenderTarget);
+				targets[i] = texture.pTargetView.Get();
+				desc = texture.desc;
+			}
+
+			if (step.depthStencil != RenderGraph::npos) {
+
+				auto& texture = getTexture(step.depthStencil, step.isDepthReadOnly ? State::DepthRead : State::DepthWrite);
+				pDepthView = step.isDepthReadOnly ? texture.pReadOnlyDepthView.Get() : texture.pDepthView.Get();
+				desc = texture.desc;
+			}
+
+			pContext->OMSetRenderTargets((UINT)step.renderTargets.size(), targets.data(), pDepthView);
+
+			D3D11_VIEWPORT vp = {};
+			vp.Width = (float)desc.width;
+			vp.Height = (float)desc.height;
+			vp.MaxDepth = 1.0f;
+			pContext->RSSetViewports(1u, &vp);
+		}
+
+		for (const auto& view : step.shaderResources) {
+
+			auto* pView = getTexture(view.resource, State::ShaderResource).pShaderView.Get();
+			pContext->PSSetShaderResources(view.slot, 1u, &pView);
+
+			if (view.slot < pixelViews.size()) {
+
+				pixelViews[view.slot] = pView;
+			}
+
+			nBoundViews = std::max(nBoundViews, view.slot + 1u);
+		}
+
+		graph.GetPasses()[step.pass].Execute(*this);
+	}
+
+	//nothing the graph bound is left for the next frame to trip over
+	unbind();
+
+	if (isTimed) {
+
+		pContext->End(gpuTiming.pEnd.Get());
+		pContext->End(gpuTiming.pDisjoint.Get());
+		gpuTiming.isPending = true;
+		nextGpuTiming = (nextGpuTiming + 1u) % gpuTimings.size();
 	}
 
-	const float color[] = { red,green,blue,1.0f };
-	pContext->ClearRenderTargetView(pTarget.Get(), color);
-	pContext->ClearDepthStencilView(pDSV.Get(), D3D11_CLEAR_DEPTH, 1.0f, 0u);
+	//pooled textures no graph asked for in a while (a resolution change, a pass turned off) are released
+	constexpr unsigned long long keepFrames = 120u;
 
+	graphTextures.erase(std::remove_if(graphTextures.begin(), graphTextures.end(), [this](const GraphTexture& texture) {
+
+		return nExecutes - texture.lastUsed > keepFrames;
+	}), graphTextures.end());
 }
 
+void Graphics::CreateGraphViews(GraphTexture& texture, UINT bindFlags)
+{
+	HRESULT hr;
+
+	const auto format = (DXGI_FORMAT)texture.desc.format;
+	const bool isDepth = texture.desc.format == TextureFormat::D32Float || texture.desc.format == TextureFormat::D24UnormS8Uint;
+	const bool hasStencil = texture.desc.format == TextureFormat::D24UnormS8Uint;
+
+	//depth read through a shader needs a typeless texture with a differently typed view for each use
+	const DXGI_FORMAT shaderFormat = !isDepth ? format : hasStencil ? DXGI_FORMAT_R24_UNORM_X8_TYPELESS : DXGI_FORMAT_R32_FLOAT;
+
+	if (texture.pTexture == nullptr) {
+
+		D3D11_TEXTURE2D_DESC desc = {};
+		desc.Width = texture.desc.width;
+		desc.Height = texture.desc.height;
+		desc.MipLevels = 1u;
+		desc.ArraySize = 1u;
+		desc.Format = !isDepth ? format : hasStencil ? DXGI_FORMAT_R24G8_TYPELESS : DXGI_FORMAT_R32_TYPELESS;
+		desc.SampleDesc.Count = 1u;
+		desc.SampleDesc.Quality = 0u;
+		desc.Usage = D3D11_USAGE_DEFAULT;
+		desc.BindFlags = bindFlags;
+
+		GFX_THROW_INFO(pDevice->CreateTexture2D(&desc, nullptr, &texture.pTexture));
+
+		texture.bindFlags = bindFlags;
+	}
+
+	if ((bindFlags & D3D11_BIND_RENDER_TARGET) && texture.pTargetView == nullptr) {
+
+		GFX_THROW_INFO(pDevice->CreateRenderTargetView(texture.pTexture.Get(), nullptr, &texture.pTargetView));
+	}
+
+	if ((bindFlags & D3D11_BIND_DEPTH_STENCIL) && texture.pDepthView == nullptr) {
+
+		D3D11_DEPTH_STENCIL_VIEW_DESC descDSV = {};
+		descDSV.Format = format;
+		descDSV.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2D;
+		descDSV.Texture2D.MipSlice = 0u;
+
+		GFX_THROW_INFO(pDevice->CreateDepthStencilView(texture.pTexture.Get(), &descDSV, &texture.pDepthView));
+
+		//for passes that test against depth while it's also read as a texture
+		descDSV.Flags = D3D11_DSV_READ_ONLY_DEPTH | (hasStencil ? D3D11_DSV_READ_ONLY_STENCIL : 0u);
+
+		GFX_THROW_INFO(pDevice->CreateDepthStencilView(texture.pTexture.Get(), &descDSV, &texture.pReadOnlyDepthView));
+	}
+
+	if ((bindFlags & D3D11_BIND_SHADER_RESOURCE) && texture.pShaderView == nullptr) {
+
+		D3D11_SHADER_RESOURCE_VIEW_DESC descSRV = {};
+		descSRV.Format = shaderFormat;
+		descSRV.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+		descSRV.Texture2D.MostDetailedMip = 0u;
+		descSRV.Texture2D.MipLevels = 1u;
+
+		GFX_THROW_INFO(pDevice->CreateShaderResourceView(texture.pTexture.Get(), &descSRV, &texture.pShaderView));
+	}
+}
+
+uint64_t Graphics::GetGpuFrameTime() const noexcept
+{
+	return gpuFrameTime;
+}
+
+void Graphics::RenderImgui(ImDrawData* pImguiData)
+{
+	if (pImguiData != nullptr) {
+
+		ImGui_ImplDX11_RenderDrawData(pImguiData);
+	}
+}
+
+
+void Graphics::Draw(UINT vertexCount) noexcept(!IS_DEBUG)
+{
+
+	GFX_THROW_INFO_ONLY(pContext->Draw(vertexCount, 0u));
+
+}
 
 void Graphics::DrawIndexed(UINT count) noexcept(!IS_DEBUG)
 {
@@ -209,6 +498,13 @@ void Graphics::DrawIndexed(UINT count) noexcept(!IS_DEBUG)
 
 }
 
+void Graphics::DrawIndexedInstanced(UINT count, UINT instanceCount, UINT startInstance) noexcept(!IS_DEBUG)
+{
+
+	GFX_THROW_INFO_ONLY(pContext->DrawIndexedInstanced(count, instanceCount, 0u, 0, startInstance));
+
+}
+
 void Graphics::SetProjection(DirectX::FXMMATRIX proj) noexcept
 {
 	projection = proj;
@@ -219,6 +515,16 @@ DirectX::XMMATRIX Graphics::GetProjection() const noexcept
 	return projection;
 }
 
+UINT Graphics::GetWidth() const noexcept
+{
+	return width;
+}
+
+UINT Graphics::GetHeight() const noexcept
+{
+	return height;
+}
+
 void Graphics::SetCamera(DirectX::FXMMATRIX cam) noexcept
 {
 	camera = cam;
@@ -245,6 +551,28 @@ bool Graphics::IsImguiEnabled() const noexcept
 	return imguiEnabled;
 }
 
+void Graphics::NewImguiFrame() noexcept
+{
+	//imgui begin frame
+	if (imguiEnabled) {
+		ImGui_ImplDX11_NewFrame();
+		ImGui_ImplWin32_NewFrame();
+		ImGui::NewFrame();
+	}
+}
+
+ImDrawData* Graphics::RenderImguiFrame() noexcept
+{
+	if (!imguiEnabled) {
+
+		return nullptr;
+	}
+
+	ImGui::Render();
+
+	return ImGui::GetDrawData();
+}
+
 
 //Graphics exception stuff
 
@@ -6,19 +6,26 @@
 #include <wrl.h>
 #include <vector>
 #include "dxgiInfoManager.h"
+#include "RenderGraph.h"
 #include <d3dcompiler.h>
 #include <DirectXMath.h>
 #include <memory>
 #include <random>
+#include <array>
+#include <string>
+#include <unordered_map>
 
 namespace Bind
 {
 	class Bindable;
 }
 
+struct ImDrawData;
+
 class Graphics {
 
 	friend class Bind::Bindable;
+	friend class FrameCapture;
 
 public:
 
@@ -84,12 +91,29 @@ public:
 	~Graphics() = default;
 
 	void EndFrame();
-	void BeginFrame(float red, float green, float blue) noexcept;
-
+	//forgets what was bound last frame, targets are cleared by the passes that write them
+	void BeginFrame() noexcept;
+
+	//the swap chain's buffer as an output of the graph
+	void ImportBackBuffer(RenderGraph& graph, const std::string& name = "BackBuffer") const;
+	//binds and clears what every step of a compiled graph needs and runs its passes
+	//*transient textures come from a pool kept between frames, ones no graph asked for in a while are released
+	void Execute(const RenderGraph& graph);
+	//imgui on top of the bound target, from the last pass drawing to the back buffer (nullptr skips it)
+	void RenderImgui(ImDrawData* pImguiData);
+	//GPU time of the latest Execute whose timestamps are back, a few frames old and 0 until the first one is
+	uint64_t GetGpuFrameTime() const noexcept;
+
+	void Draw(UINT vertexCount) noexcept(!IS_DEBUG);
 	void DrawIndexed(UINT count) noexcept(!IS_DEBUG);
+	void DrawIndexedInstanced(UINT count, UINT instanceCount, UINT startInstance) noexcept(!IS_DEBUG);
 	void SetProjection(DirectX::FXMMATRIX proj) noexcept;
 	DirectX::XMMATRIX GetProjection() const noexcept;
 
+	//back buffer size in pixels
+	UINT GetWidth() const noexcept;
+	UINT GetHeight() const noexcept;
+
 	//camera stuffs
 	void SetCamera(DirectX::FXMMATRIX view) noexcept;
 	DirectX::XMMATRIX GetCamera() const noexcept;
@@ -98,6 +122,10 @@ public:
 	void EnableImgui() noexcept;
 	void DisableImgui() noexcept;
 	bool IsImguiEnabled() const noexcept;
+	//imgui frame is built on the simulation thread, separately from the d3d frame
+	void NewImguiFrame() noexcept;
+	//finishes the imgui frame, nullptr when imgui is disabled
+	ImDrawData* RenderImguiFrame() noexcept;
 
 private:
 	bool imguiEnabled = true;
@@ -108,6 +136,48 @@ private:
 	DirectX::XMMATRIX projection;
 	DirectX::XMMATRIX camera;
 
+	UINT width;
+	UINT height;
+
+	//pixel shader views and sampler last bound through Bindable, repeats of the same object are skipped
+	//*only compared, never dereferenced, and forgotten every BeginFrame since other code binds behind their back
+	std::array<ID3D11ShaderResourceView*, 8> pixelViews = {};
+	ID3D11SamplerState* pPixelSampler = nullptr;
+
+	//a texture behind render graph resources with the views the graph binds it through
+	struct GraphTexture {
+
+		RenderGraph::TextureDesc desc;
+		UINT bindFlags = 0u;
+		//Execute that last handed it out, for releasing unused ones
+		unsigned long long lastUsed = 0u;
+		Microsoft::WRL::ComPtr<ID3D11Texture2D> pTexture;
+		Microsoft::WRL::ComPtr<ID3D11RenderTargetView> pTargetView;
+		Microsoft::WRL::ComPtr<ID3D11DepthStencilView> pDepthView;
+		Microsoft::WRL::ComPtr<ID3D11DepthStencilView> pReadOnlyDepthView;
+		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> pShaderView;
+	};
+
+	void CreateGraphViews(GraphTexture& texture, UINT bindFlags);
+
+	std::vector<GraphTexture> graphTextures;
+	//views of imported textures, by the texture
+	std::unordered_map<void*, GraphTexture> importedTextures;
+	unsigned long long nExecutes = 0u;
+
+	//timestamps around every Execute, read back frames later without waiting on the GPU
+	struct GpuTiming {
+
+		Microsoft::WRL::ComPtr<ID3D11Query> pDisjoint;
+		Microsoft::WRL::ComPtr<ID3D11Query> pBegin;
+		Microsoft::WRL::ComPtr<ID3D11Query> pEnd;
+		bool isPending = false;
+	};
+
+	std::array<GpuTiming, 4> gpuTimings;
+	size_t nextGpuTiming = 0u;
+	uint64_t gpuFrameTime = 0u;
+
 #ifndef  NDEBUG
 	DxgiInfoManager infoManager;
 #endif // ! NDEBUG
@@ -116,6 +186,6 @@ private:
 	Microsoft::WRL::ComPtr<ID3D11Device> pDevice;
 	Microsoft::WRL::ComPtr<IDXGISwapChain> pSwap;
 	Microsoft::WRL::ComPtr<ID3D11DeviceContext> pContext;
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> pBackBuffer;
 	Microsoft::WRL::ComPtr<ID3D11RenderTargetView> pTarget;
-	Microsoft::WRL::ComPtr<ID3D11DepthStencilView> pDSV;
 };
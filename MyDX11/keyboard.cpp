@@ -1,53 +1,45 @@
 #include "keyboard.h"
+#include "myTimer.h"
+
+Keyboard::Keyboard(size_t keyCapacity, size_t charCapacity)
+	:
+	keybuffer(keyCapacity),
+	charbuffer(charCapacity)
+{}
 
 bool Keyboard::KeyIsPressed(unsigned char keycode) const noexcept {
 
-	return keystates[keycode];
+	return (keystates[keycode / 64u].load(std::memory_order_relaxed) >> (keycode % 64u)) & 1u;
 }
 
 std::optional<Keyboard::Event> Keyboard::ReadKey() noexcept {
 
-	if (keybuffer.size() > 0u) {
-
-		Keyboard::Event e = keybuffer.front();
-		keybuffer.pop();
-		return e;
-	}
-	
-	return {};
+	return keybuffer.Pop();
 }
 
 bool Keyboard::KeyIsEmpty() const noexcept {
 
-	return keybuffer.empty();
+	return keybuffer.IsEmpty();
 }
 
 std::optional<char> Keyboard::ReadChar() noexcept {
 
-	if (charbuffer.size() > 0u) {
-
-		unsigned char charcode = charbuffer.front();
-		charbuffer.pop();
-
-		return charcode;
-	}
-	
-	return {};
+	return charbuffer.Pop();
 }
 
 bool Keyboard::CharIsEmpty() const noexcept {
 
-	return charbuffer.empty();
+	return charbuffer.IsEmpty();
 }
 
 void Keyboard::FlushKey() noexcept {
 
-	keybuffer = std::queue<Event>();
+	keybuffer.Clear();
 }
 
 void Keyboard::FlushChar() noexcept {
 
-	charbuffer = std::queue<char>();
+	charbuffer.Clear();
 }
 
 void Keyboard::Flush() noexcept
@@ -56,6 +48,16 @@ void Keyboard::Flush() noexcept
 	FlushChar();
 }
 
+uint64_t Keyboard::GetKeyOverflowCount() const noexcept
+{
+	return keybuffer.GetOverflowCount();
+}
+
+uint64_t Keyboard::GetCharOverflowCount() const noexcept
+{
+	return charbuffer.GetOverflowCount();
+}
+
 void Keyboard::EnableAutorepeat() noexcept {
 
 	autorepeatEnabled = true;
@@ -76,34 +78,25 @@ bool Keyboard::AutorepeatIsEnabled() const noexcept {
 //Window class use them
 void Keyboard::OnKeyPressed(unsigned char keycode) noexcept {
 
-	keystates[keycode] = true;
-	keybuffer.push(Keyboard::Event(Keyboard::Event::Type::Press, keycode));
-	TrimBuffer(keybuffer);
+	keystates[keycode / 64u].fetch_or(1ull << (keycode % 64u), std::memory_order_relaxed);
+	keybuffer.Push(Keyboard::Event(Keyboard::Event::Type::Press, keycode, myTimer::SteadyClock()));
 }
 
 void Keyboard::OnKeyReleased(unsigned char keycode) noexcept {
 
-	keystates[keycode] = false;
-	keybuffer.push(Keyboard::Event(Keyboard::Event::Type::Release, keycode));
-	TrimBuffer(keybuffer);
+	keystates[keycode / 64u].fetch_and(~(1ull << (keycode % 64u)), std::memory_order_relaxed);
+	keybuffer.Push(Keyboard::Event(Keyboard::Event::Type::Release, keycode, myTimer::SteadyClock()));
 }
 
 void Keyboard::OnChar(char character) noexcept {
 
-	charbuffer.push(character);
-	TrimBuffer(charbuffer);
+	charbuffer.Push(character);
 }
 
 void Keyboard::ClearState() noexcept {
 
-	keystates.reset();
-}
-
-template<typename T>
-void Keyboard::TrimBuffer(std::queue<T>& buffer) noexcept {
-
-	while (buffer.size() > bufferSize) {
+	for (auto& keys : keystates) {
 
-		buffer.pop();
+		keys.store(0u, std::memory_order_relaxed);
 	}
 }
\ No newline at end of file
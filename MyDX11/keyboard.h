@@ -1,8 +1,11 @@
 #pragma once
-#include <queue>
-#include <bitset>
+#include "EventRing.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <optional>
 
+//*events go through lock free rings and the key states are atomic, so the window's message pump can run on another thread than the reader
 class Keyboard {
 
 	friend class Window;
@@ -22,18 +25,22 @@ public:
 	private:
 		Type type;
 		unsigned char code;
+		//myTimer::SteadyClock nanoseconds of when the message was handled
+		uint64_t timestamp;
 
 	public:
 		Event()
 			:
 			type(Type::Invalid),
-			code(0u)
+			code(0u),
+			timestamp(0u)
 		{}
 
-		Event(Type type,unsigned char code) noexcept
+		Event(Type type,unsigned char code,uint64_t timestamp) noexcept
 			:
 			type(type),
-			code(code)
+			code(code),
+			timestamp(timestamp)
 		{}
 
 		bool IsPress() const noexcept{
@@ -50,10 +57,17 @@ public:
 		{
 			return code;
 		}
+
+		uint64_t GetTimestamp() const noexcept
+		{
+			return timestamp;
+		}
 	};
 
-	//default construction
-	Keyboard() = default;
+	//events that don't fit in a full buffer are dropped and counted
+	static constexpr size_t defaultCapacity = 256u;
+
+	Keyboard(size_t keyCapacity = defaultCapacity, size_t charCapacity = defaultCapacity);
 
 	Keyboard(const Keyboard&) = delete;
 	Keyboard& operator=(const Keyboard&) = delete;
@@ -70,6 +84,10 @@ public:
 	void FlushChar() noexcept;
 	void Flush() noexcept;
 
+	//events dropped because nobody read them before the buffer filled
+	uint64_t GetKeyOverflowCount() const noexcept;
+	uint64_t GetCharOverflowCount() const noexcept;
+
 	//autorepeat control
 	void EnableAutorepeat() noexcept;
 	void DisableAutorepeat() noexcept;
@@ -81,16 +99,14 @@ private:
 	void OnKeyReleased(unsigned char keycode) noexcept;
 	void OnChar(char character) noexcept;
 	void ClearState() noexcept;
-	template<typename T>
-	static void TrimBuffer(std::queue<T>& buffer) noexcept;
 
 private:
 
 	static constexpr unsigned int nKeys = 256u;
-	static constexpr unsigned int bufferSize = 16u;
-	bool autorepeatEnabled = false;
-	std::bitset<nKeys> keystates;
-	std::queue<Event> keybuffer;
-	std::queue<char> charbuffer;
+	std::atomic<bool> autorepeatEnabled = false;
+	//one bit a key
+	std::array<std::atomic<uint64_t>, nKeys / 64u> keystates = {};
+	EventRing<Event> keybuffer;
+	EventRing<char> charbuffer;
 
 };
\ No newline at end of file
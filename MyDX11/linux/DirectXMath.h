@@ -0,0 +1,83 @@
+#pragma once
+
+//stand in for the Windows SDK's DirectXMath on machines without it, used only by the CMake build of the portable units
+//*the portable units keep their data in the storage types and do the math themselves, so only those are here,
+//laid out like the real ones so the same structs can be handed to the engine
+#include <cstddef>
+#include <cstdint>
+
+namespace DirectX {
+
+	struct XMFLOAT2 {
+
+		float x;
+		float y;
+
+		XMFLOAT2() = default;
+		constexpr XMFLOAT2(float x, float y) noexcept :x(x), y(y) {}
+		explicit XMFLOAT2(const float* pArray) noexcept :x(pArray[0]), y(pArray[1]) {}
+	};
+
+	struct XMFLOAT3 {
+
+		float x;
+		float y;
+		float z;
+
+		XMFLOAT3() = default;
+		constexpr XMFLOAT3(float x, float y, float z) noexcept :x(x), y(y), z(z) {}
+		explicit XMFLOAT3(const float* pArray) noexcept :x(pArray[0]), y(pArray[1]), z(pArray[2]) {}
+	};
+
+	struct XMFLOAT4 {
+
+		float x;
+		float y;
+		float z;
+		float w;
+
+		XMFLOAT4() = default;
+		constexpr XMFLOAT4(float x, float y, float z, float w) noexcept :x(x), y(y), z(z), w(w) {}
+		explicit XMFLOAT4(const float* pArray) noexcept :x(pArray[0]), y(pArray[1]), z(pArray[2]), w(pArray[3]) {}
+	};
+
+	//row major, row vectors times the matrix like the engine's shaders
+	struct XMFLOAT4X4 {
+
+		union {
+
+			struct {
+
+				float _11, _12, _13, _14;
+				float _21, _22, _23, _24;
+				float _31, _32, _33, _34;
+				float _41, _42, _43, _44;
+			};
+			float m[4][4];
+		};
+
+		XMFLOAT4X4() = default;
+		constexpr XMFLOAT4X4(
+			float m00, float m01, float m02, float m03,
+			float m10, float m11, float m12, float m13,
+			float m20, float m21, float m22, float m23,
+			float m30, float m31, float m32, float m33) noexcept
+			:
+			_11(m00), _12(m01), _13(m02), _14(m03),
+			_21(m10), _22(m11), _23(m12), _24(m13),
+			_31(m20), _32(m21), _33(m22), _34(m23),
+			_41(m30), _42(m31), _43(m32), _44(m33)
+		{}
+
+		float operator()(size_t row, size_t column) const noexcept {
+
+			return m[row][column];
+		}
+
+		float& operator()(size_t row, size_t column) noexcept {
+
+			return m[row][column];
+		}
+	};
+
+}
@@ -1,5 +1,14 @@
 #include "mouse.h"
-#include <Windows.h>
+#include "myTimer.h"
+
+//WHEEL_DELTA, spelled out so the mouse builds without windows
+static constexpr int wheelDelta = 120;
+
+Mouse::Mouse(size_t capacity, size_t rawCapacity)
+	:
+	buffer(capacity),
+	rawDeltaBuffer(rawCapacity)
+{}
 
 std::pair<int, int> Mouse::GetPos() const noexcept{
 
@@ -8,15 +17,7 @@ std::pair<int, int> Mouse::GetPos() const noexcept{
 
 std::optional<Mouse::RawDelta> Mouse::ReadRawDelta() noexcept
 {
-	if (rawDeltaBuffer.empty()){
-
-		return std::nullopt;
-	}
-
-	const RawDelta d = rawDeltaBuffer.front();
-	rawDeltaBuffer.pop();
-
-	return d;
+	return rawDeltaBuffer.Pop();
 }
 
 
@@ -48,19 +49,22 @@ bool Mouse::RightIsPressed() const noexcept {
 
 std::optional<Mouse::Event> Mouse::Read() noexcept {
 
-	if (buffer.size() > 0u) {
-
-		Mouse::Event e = buffer.front();
-		buffer.pop();
-		return e;
-	}
-	
-	return {};
+	return buffer.Pop();
 }
 
 void Mouse::Flush() noexcept {
 
-	buffer = std::queue<Event>();
+	buffer.Clear();
+}
+
+uint64_t Mouse::GetOverflowCount() const noexcept
+{
+	return buffer.GetOverflowCount();
+}
+
+uint64_t Mouse::GetRawOverflowCount() const noexcept
+{
+	return rawDeltaBuffer.GetOverflowCount();
 }
 
 void Mouse::EnableRaw() noexcept
@@ -85,86 +89,59 @@ void Mouse::OnMouseMove(int newx, int newy) noexcept {
 	x = newx;
 	y = newy;
 
-	buffer.push(Mouse::Event(Mouse::Event::Type::Move, *this));
-	TrimBuffer();
+	buffer.Push(Mouse::Event(Mouse::Event::Type::Move, *this, myTimer::SteadyClock()));
 }
 
 void Mouse::OnMouseLeave() noexcept {
 
 	isInWindow = false;
-	buffer.push(Mouse::Event(Mouse::Event::Type::Leave, *this));
-	TrimBuffer();
+	buffer.Push(Mouse::Event(Mouse::Event::Type::Leave, *this, myTimer::SteadyClock()));
 }
 
 void Mouse::OnMouseEnter() noexcept {
 
 	isInWindow = true;
-	buffer.push(Mouse::Event(Mouse::Event::Type::Enter, *this));
-	TrimBuffer();
+	buffer.Push(Mouse::Event(Mouse::Event::Type::Enter, *this, myTimer::SteadyClock()));
 }
 
 void Mouse::OnRawDelta(int dx, int dy) noexcept
 {
 
-	rawDeltaBuffer.push({ dx,dy });
-	TrimBuffer();
+	rawDeltaBuffer.Push({ dx,dy,myTimer::SteadyClock() });
 }
 
 void Mouse::OnLeftPressed(int x, int y) noexcept {
 
 	leftIsPressed = true;
-	buffer.push(Mouse::Event(Mouse::Event::Type::LPress, *this));
-	TrimBuffer();
+	buffer.Push(Mouse::Event(Mouse::Event::Type::LPress, *this, myTimer::SteadyClock()));
 }
 
 void Mouse::OnLeftReleased(int x, int y) noexcept {
 
 	leftIsPressed = false;
-	buffer.push(Mouse::Event(Mouse::Event::Type::LRelease, *this));
-	TrimBuffer();
+	buffer.Push(Mouse::Event(Mouse::Event::Type::LRelease, *this, myTimer::SteadyClock()));
 }
 
 void Mouse::OnRightPressed(int x, int y) noexcept {
 
 	rightIsPressed = true;
-	buffer.push(Mouse::Event(Mouse::Event::Type::RPress, *this));
-	TrimBuffer();
+	buffer.Push(Mouse::Event(Mouse::Event::Type::RPress, *this, myTimer::SteadyClock()));
 }
 
 void Mouse::OnRightReleased(int x, int y) noexcept {
 
 	rightIsPressed = false;
-	buffer.push(Mouse::Event(Mouse::Event::Type::RRelease, *this));
-	TrimBuffer();
+	buffer.Push(Mouse::Event(Mouse::Event::Type::RRelease, *this, myTimer::SteadyClock()));
 }
 
 void Mouse::OnWheelUp(int x, int y) noexcept {
 
-	buffer.push(Mouse::Event(Mouse::Event::Type::WheelUp, *this));
-	TrimBuffer();
+	buffer.Push(Mouse::Event(Mouse::Event::Type::WheelUp, *this, myTimer::SteadyClock()));
 }
 
 void Mouse::OnWheelDown(int x, int y) noexcept {
 
-	buffer.push(Mouse::Event(Mouse::Event::Type::WheelDown, *this));
-	TrimBuffer();
-}
-
-void Mouse::TrimBuffer() noexcept {
-
-	while (buffer.size() > bufferSize) {
-
-		buffer.pop();
-	}
-}
-
-void Mouse::TrimRawInputBuffer() noexcept
-{
-
-	while (rawDeltaBuffer.size() > bufferSize){
-
-		rawDeltaBuffer.pop();
-	}
+	buffer.Push(Mouse::Event(Mouse::Event::Type::WheelDown, *this, myTimer::SteadyClock()));
 }
 
 void Mouse::OnWheelDelta(int x, int y, int delta) noexcept {
@@ -172,14 +149,14 @@ void Mouse::OnWheelDelta(int x, int y, int delta) noexcept {
 	wheelDeltaCarry += delta;
 	
 	//generate events for every 120
-	while (wheelDeltaCarry >= WHEEL_DELTA) {
+	while (wheelDeltaCarry >= wheelDelta) {
 
-		wheelDeltaCarry -= WHEEL_DELTA;
+		wheelDeltaCarry -= wheelDelta;
 		OnWheelUp(x, y);
 	}
-	while (wheelDeltaCarry <= -WHEEL_DELTA) {
+	while (wheelDeltaCarry <= -wheelDelta) {
 
-		wheelDeltaCarry += WHEEL_DELTA;
+		wheelDeltaCarry += wheelDelta;
 		OnWheelDown(x, y);
 	}
 }
\ No newline at end of file
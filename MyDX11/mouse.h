@@ -1,7 +1,11 @@
 #pragma once
-#include <queue>
+#include "EventRing.h"
+#include <atomic>
+#include <cstdint>
 #include <optional>
+#include <utility>
 
+//*events go through lock free rings and the button/position state is atomic, so the window's message pump can run on another thread than the reader
 class Mouse {
 
 	friend class Window;
@@ -11,6 +15,8 @@ public:
 	struct RawDelta {
 
 		int x, y;
+		//myTimer::SteadyClock nanoseconds of when the message was handled
+		uint64_t timestamp;
 	};
 
 	class Event {
@@ -26,7 +32,8 @@ public:
 			WheelDown,
 			Move,
 			Enter,
-			Leave
+			Leave,
+			Invalid
 		};
 
 	private:
@@ -35,17 +42,30 @@ public:
 		bool rightIsPressed;
 		int x;
 		int y;
+		//myTimer::SteadyClock nanoseconds of when the message was handled
+		uint64_t timestamp;
 
 	public:
 		
+		//empty slot of the event ring
+		Event() noexcept
+			:
+			type(Type::Invalid),
+			leftIsPressed(false),
+			rightIsPressed(false),
+			x(0),
+			y(0),
+			timestamp(0u)
+		{}
 
-		Event(Type type, const Mouse& parent) noexcept
+		Event(Type type, const Mouse& parent, uint64_t timestamp) noexcept
 			:
 			type(type),
-			leftIsPressed(parent.leftIsPressed),
-			rightIsPressed(parent.rightIsPressed),
-			x(parent.x),
-			y(parent.y)
+			leftIsPressed(parent.leftIsPressed.load(std::memory_order_relaxed)),
+			rightIsPressed(parent.rightIsPressed.load(std::memory_order_relaxed)),
+			x(parent.x.load(std::memory_order_relaxed)),
+			y(parent.y.load(std::memory_order_relaxed)),
+			timestamp(timestamp)
 		{}
 
 		
@@ -80,10 +100,20 @@ public:
 			return rightIsPressed;
 		}
 
+		uint64_t GetTimestamp() const noexcept {
+
+			return timestamp;
+		}
+
 	};
 
 public:
-	Mouse() = default;
+	//events that don't fit in a full buffer are dropped and counted
+	static constexpr size_t defaultCapacity = 512u;
+	//raw deltas come in at the mouse's polling rate, up to a thousand a second
+	static constexpr size_t defaultRawCapacity = 1024u;
+
+	Mouse(size_t capacity = defaultCapacity, size_t rawCapacity = defaultRawCapacity);
 	Mouse(const Mouse&) = delete;
 	Mouse& operator=(const Mouse&) = delete;
 
@@ -101,10 +131,14 @@ public:
 	std::optional<Mouse::Event> Read() noexcept;
 	bool IsEmpty() const noexcept {
 
-		return buffer.empty();
+		return buffer.IsEmpty();
 	}
 	void Flush() noexcept;
 
+	//events dropped because nobody read them before the buffer filled
+	uint64_t GetOverflowCount() const noexcept;
+	uint64_t GetRawOverflowCount() const noexcept;
+
 	void EnableRaw() noexcept;
 	void DisableRaw() noexcept;
 	bool GetRawEnabled() const noexcept;
@@ -123,20 +157,18 @@ private:
 
 	void OnWheelUp(int x, int y) noexcept;
 	void OnWheelDown(int x, int y) noexcept;
-	void TrimBuffer() noexcept;
-	void TrimRawInputBuffer() noexcept;
 	void OnWheelDelta(int x, int y, int delta) noexcept;
 
 private:
-	static constexpr unsigned int bufferSize = 16u;
-	int x;
-	int y;
-	bool leftIsPressed = false;
-	bool rightIsPressed = false;
-	bool isInWindow = false;
+	std::atomic<int> x = 0;
+	std::atomic<int> y = 0;
+	std::atomic<bool> leftIsPressed = false;
+	std::atomic<bool> rightIsPressed = false;
+	std::atomic<bool> isInWindow = false;
+	//only the message pump touches it
 	int wheelDeltaCarry = 0;
-	std::queue<Event> buffer;
+	EventRing<Event> buffer;
 
-	bool isRawEnabled = false;
-	std::queue<RawDelta> rawDeltaBuffer;
+	std::atomic<bool> isRawEnabled = false;
+	EventRing<RawDelta> rawDeltaBuffer;
 };
\ No newline at end of file
@@ -2,20 +2,37 @@
 
 using namespace std::chrono;
 
-myTimer::myTimer() {
+myTimer::myTimer(Clock clock)
+	:
+	clock(std::move(clock))
+{
 
-	last = steady_clock::now();
+	last = this->clock();
 }
 
 float myTimer::Mark() {
 
-	const auto old = last;
-	last = steady_clock::now();
-	const duration<float> frameTime = last - old;
-	return frameTime.count();
+	return (float)(MarkNs() * 1.0e-9);
 }
 
 float myTimer::Peek() const {
 
-	return duration<float>(steady_clock::now() - last).count();
-}
\ No newline at end of file
+	return (float)(PeekNs() * 1.0e-9);
+}
+
+uint64_t myTimer::MarkNs() {
+
+	const auto old = last;
+	last = clock();
+	return last - old;
+}
+
+uint64_t myTimer::PeekNs() const {
+
+	return clock() - last;
+}
+
+uint64_t myTimer::SteadyClock() noexcept {
+
+	return (uint64_t)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
@@ -1,14 +1,28 @@
 #pragma once
 #include <chrono>
+#include <cstdint>
+#include <functional>
 
 class myTimer{
 
 public:
-	myTimer();
+	//nanoseconds from any fixed point, tests hand in their own to step the timer by hand
+	using Clock = std::function<uint64_t()>;
+
+	myTimer(Clock clock = SteadyClock);
+
+	//seconds, for per frame deltas
 	float Mark();
 	float Peek() const;
 
+	//whole nanoseconds, nothing is lost however long the session runs
+	uint64_t MarkNs();
+	uint64_t PeekNs() const;
+
+	static uint64_t SteadyClock() noexcept;
+
 private:
-	std::chrono::steady_clock::time_point last;
+	Clock clock;
+	uint64_t last;
 
 };
@@ -0,0 +1,357 @@
+#include "TestCheck.h"
+#include "DdsFile.h"
+#include "BcEncoder.h"
+#include "MipFilter.h"
+#include "ImageDecoder.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+	std::string GetTempPath(const char* name) {
+
+		return (std::filesystem::temp_directory_path() / name).string();
+	}
+
+	std::vector<uint8_t> ReadFile(const std::string& path) {
+
+		std::ifstream file(path, std::ios::binary);
+
+		return { std::istreambuf_iterator<char>(file),std::istreambuf_iterator<char>() };
+	}
+
+	void WriteFile(const std::string& path, const std::vector<uint8_t>& bytes) {
+
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		file.write((const char*)bytes.data(), (std::streamsize)bytes.size());
+	}
+
+	//random texels for every subresource, rows padded by extra bytes past what the format needs
+	//so writing has to repack them tightly
+	struct Source {
+
+		DdsFile::Description desc;
+		std::vector<std::vector<uint8_t>> levels;
+		std::vector<DdsFile::Subresource> subresources;
+	};
+
+	Source MakeSource(const DdsFile::Description& desc, size_t rowPadding, std::mt19937& rng) {
+
+		Source source;
+		source.desc = desc;
+
+		for (unsigned int item = 0; item < desc.arraySize; item++) {
+
+			for (unsigned int mip = 0; mip < desc.mipLevels; mip++) {
+
+				const unsigned int width = std::max(1u, desc.width >> mip);
+				const unsigned int height = std::max(1u, desc.height >> mip);
+				const size_t rowPitch = DdsFile::GetRowPitch(desc.format, width) + rowPadding;
+				const unsigned int nRows = DdsFile::GetRowCount(desc.format, height);
+
+				source.levels.emplace_back(rowPitch * nRows);
+
+				for (auto& byte : source.levels.back()) {
+
+					byte = (uint8_t)rng();
+				}
+
+				source.subresources.push_back({ source.levels.back().data(),width,height,rowPitch,rowPitch * nRows });
+			}
+		}
+
+		return source;
+	}
+
+	//what was written comes back with the same description and the same rows
+	bool IsSameAsWritten(const Source& source, const DdsFile& file) {
+
+		const auto& desc = file.GetDescription();
+
+		if (desc.format != source.desc.format || desc.width != source.desc.width || desc.height != source.desc.height ||
+			desc.mipLevels != source.desc.mipLevels || desc.arraySize != source.desc.arraySize || desc.isCubeMap != source.desc.isCubeMap ||
+			file.GetSubresources().size() != source.subresources.size()) {
+
+			return false;
+		}
+
+		for (unsigned int item = 0; item < desc.arraySize; item++) {
+
+			for (unsigned int mip = 0; mip < desc.mipLevels; mip++) {
+
+				const auto& written = source.subresources[item * desc.mipLevels + mip];
+				const auto& read = file.GetSubresource(mip, item);
+				const size_t rowPitch = DdsFile::GetRowPitch(desc.format, written.width);
+				const unsigned int nRows = DdsFile::GetRowCount(desc.format, written.height);
+
+				if (read.width != written.width || read.height != written.height || read.rowPitch != rowPitch || read.slicePitch != rowPitch * nRows) {
+
+					return false;
+				}
+
+				for (unsigned int y = 0; y < nRows; y++) {
+
+					if (std::memcmp(written.pData + y * written.rowPitch, read.pData + y * read.rowPitch, rowPitch) != 0) {
+
+						return false;
+					}
+				}
+			}
+		}
+
+		return true;
+	}
+
+	DdsFile::Description MakeDescription(DdsFormat format, unsigned int width, unsigned int height, unsigned int mipLevels, unsigned int arraySize = 1u, bool isCubeMap = false) {
+
+		DdsFile::Description desc;
+		desc.format = format;
+		desc.width = width;
+		desc.height = height;
+		desc.mipLevels = mipLevels;
+		desc.arraySize = arraySize;
+		desc.isCubeMap = isCubeMap;
+
+		return desc;
+	}
+
+	void TestRoundTrip() {
+
+		const std::string path = GetTempPath("MyDX11DdsFileTests.dds");
+		std::mt19937 rng(7u);
+
+		struct Case {
+
+			DdsFile::Description desc;
+			size_t rowPadding;
+		};
+
+		const Case cases[] = {
+			//full chains, partial blocks at the small mips
+			{ MakeDescription(DdsFormat::BC1Unorm,256u,128u,9u),0u },
+			{ MakeDescription(DdsFormat::BC1UnormSrgb,13u,7u,4u),0u },
+			{ MakeDescription(DdsFormat::BC3Unorm,64u,64u,7u,4u),0u },
+			{ MakeDescription(DdsFormat::BC4Unorm,20u,12u,5u),0u },
+			{ MakeDescription(DdsFormat::BC5Unorm,32u,8u,3u),0u },
+			{ MakeDescription(DdsFormat::BC7UnormSrgb,16u,16u,5u,6u,true),0u },
+			//uncompressed with padded source rows
+			{ MakeDescription(DdsFormat::B8G8R8A8Unorm,37u,11u,6u,2u),12u },
+			{ MakeDescription(DdsFormat::R8G8B8A8UnormSrgb,1u,1u,1u),4u },
+			{ MakeDescription(DdsFormat::R8Unorm,5u,3u,3u),3u },
+			{ MakeDescription(DdsFormat::R8G8Unorm,9u,9u,4u),1u },
+			//two cube maps in one array
+			{ MakeDescription(DdsFormat::R16G16B16A16Float,8u,8u,4u,12u,true),0u },
+			{ MakeDescription(DdsFormat::R32G32B32A32Float,3u,5u,3u),0u },
+		};
+
+		for (const auto& c : cases) {
+
+			const auto source = MakeSource(c.desc, c.rowPadding, rng);
+			DdsFile::Write(path, source.desc, source.subresources);
+
+			const DdsFile file(path);
+			CHECK(IsSameAsWritten(source, file));
+		}
+
+		std::filesystem::remove(path);
+	}
+
+	//a BC7 chain made the way the texture baker makes it decodes back close to the source
+	void TestEncodedChain() {
+
+		const std::string path = GetTempPath("MyDX11DdsFileTests.dds");
+
+		std::vector<uint32_t> top;
+		unsigned int width = 0u;
+		unsigned int height = 0u;
+
+		ImageDecoder::DecodeFile("asset/texture/notstonks.png", [&](unsigned int w, unsigned int h) {
+
+			width = w;
+			height = h;
+			top.resize((size_t)w * h);
+
+			return top.data();
+		});
+
+		const BcEncoder encoder(BcFormat::BC7);
+		const auto desc = MakeDescription(DdsFormat::BC7UnormSrgb, width, height, MipFilter::CountLevels(width, height));
+
+		std::vector<std::vector<uint32_t>> texels = { top };
+		std::vector<std::vector<uint8_t>> blocks;
+		std::vector<DdsFile::Subresource> subresources;
+
+		for (unsigned int mip = 0; mip < desc.mipLevels; mip++) {
+
+			const unsigned int w = std::max(1u, width >> mip);
+			const unsigned int h = std::max(1u, height >> mip);
+
+			if (mip + 1u < desc.mipLevels) {
+
+				const MipFilter filter(w, h, true);
+				texels.emplace_back((size_t)filter.GetDstWidth() * filter.GetDstHeight());
+				filter.Run(texels[mip].data(), texels[mip + 1u].data(), 0u, filter.GetDstHeight());
+			}
+
+			blocks.emplace_back(BcEncoder::GetLevelBytes(BcFormat::BC7, w, h));
+			encoder.Run(texels[mip].data(), w, h, blocks.back().data(), 0u, BcEncoder::CountBlocks(h));
+		}
+
+		for (unsigned int mip = 0; mip < desc.mipLevels; mip++) {
+
+			const unsigned int w = std::max(1u, width >> mip);
+			const unsigned int h = std::max(1u, height >> mip);
+
+			subresources.push_back({ blocks[mip].data(),w,h,BcEncoder::GetRowPitch(BcFormat::BC7, w),blocks[mip].size() });
+		}
+
+		DdsFile::Write(path, desc, subresources);
+
+		{
+			const DdsFile file(path);
+			CHECK(file.GetDescription().mipLevels == desc.mipLevels);
+
+			for (unsigned int mip = 0; mip < desc.mipLevels; mip++) {
+
+				const auto& level = file.GetSubresource(mip);
+				std::vector<uint32_t> decoded((size_t)level.width * level.height);
+				encoder.Decode(level.pData, level.width, level.height, decoded.data());
+
+				CHECK(level.slicePitch == blocks[mip].size());
+				CHECK(std::memcmp(level.pData, blocks[mip].data(), blocks[mip].size()) == 0);
+
+				//*the busy small levels of this image land just under 30 dB
+				CHECK(BcEncoder::Psnr(BcFormat::BC7, texels[mip].data(), decoded.data(), decoded.size()) > 25.0);
+			}
+		}
+
+		std::filesystem::remove(path);
+	}
+
+	template<typename F>
+	bool ThrowsDdsException(F&& func) {
+
+		try {
+
+			func();
+		}
+		catch (const DdsFile::Exception&) {
+
+			return true;
+		}
+
+		return false;
+	}
+
+	//bad descriptions are refused before anything is written, an existing file stays as it was
+	void TestWriteErrors() {
+
+		const std::string path = GetTempPath("MyDX11DdsFileTests.dds");
+		std::mt19937 rng(3u);
+
+		const auto source = MakeSource(MakeDescription(DdsFormat::BC1Unorm, 16u, 16u, 5u), 0u, rng);
+		DdsFile::Write(path, source.desc, source.subresources);
+
+		//one subresource short
+		auto missing = source.subresources;
+		missing.pop_back();
+		CHECK(ThrowsDdsException([&]() { DdsFile::Write(path, source.desc, missing); }));
+
+		//a level the size of another one
+		auto mismatched = source.subresources;
+		mismatched[1].width = 16u;
+		CHECK(ThrowsDdsException([&]() { DdsFile::Write(path, source.desc, mismatched); }));
+
+		//more mips than the size allows, and a format the container doesn't know
+		CHECK(ThrowsDdsException([&]() { DdsFile::Write(path, MakeDescription(DdsFormat::BC1Unorm, 16u, 16u, 6u), source.subresources); }));
+		CHECK(ThrowsDdsException([&]() { DdsFile::Write(path, MakeDescription(DdsFormat::Unknown, 16u, 16u, 5u), source.subresources); }));
+
+		//a cube map needs six items per cube
+		CHECK(ThrowsDdsException([&]() { DdsFile::Write(path, MakeDescription(DdsFormat::BC1Unorm, 16u, 16u, 5u, 1u, true), source.subresources); }));
+
+		{
+			const DdsFile file(path);
+			CHECK(IsSameAsWritten(source, file));
+		}
+
+		std::filesystem::remove(path);
+		CHECK(ThrowsDdsException([&]() { DdsFile file(path); }));
+	}
+
+	//truncated files and damaged headers are refused with DdsFile::Exception, never read out of bounds
+	void TestCorruptFiles() {
+
+		const std::string path = GetTempPath("MyDX11DdsFileTests.dds");
+		const std::string corruptPath = GetTempPath("MyDX11DdsFileTestsCorrupt.dds");
+		std::mt19937 rng(11u);
+
+		const auto source = MakeSource(MakeDescription(DdsFormat::BC3Unorm, 32u, 16u, 4u, 6u, true), 0u, rng);
+		DdsFile::Write(path, source.desc, source.subresources);
+		const auto original = ReadFile(path);
+
+		//magic, the 124 byte header and the 20 byte DX10 extension
+		constexpr size_t headerSize = 4u + 124u + 20u;
+		size_t nRefused = 0u;
+
+		for (int i = 0; i < 400; i++) {
+
+			auto bytes = original;
+
+			if (i % 2 == 0) {
+
+				bytes.resize(rng() % bytes.size());
+			}
+			else {
+
+				for (int n = 0; n < 3; n++) {
+
+					bytes[rng() % headerSize] = (uint8_t)rng();
+				}
+			}
+
+			WriteFile(corruptPath, bytes);
+
+			try {
+
+				const DdsFile file(corruptPath);
+
+				//touching the last byte of every level faults if the checks let one run past the mapping
+				uint8_t sum = 0u;
+
+				for (const auto& subresource : file.GetSubresources()) {
+
+					sum += subresource.pData[0] + subresource.pData[subresource.slicePitch - 1u];
+				}
+
+				static volatile uint8_t sink;
+				sink = sink + sum;
+			}
+			catch (const DdsFile::Exception&) {
+
+				nRefused++;
+			}
+		}
+
+		//every truncation loses data
+		CHECK(nRefused >= 200u);
+
+		std::filesystem::remove(path);
+		std::filesystem::remove(corruptPath);
+	}
+}
+
+int main()
+{
+	Test::Run("round trip", TestRoundTrip);
+	Test::Run("encoded mip chain", TestEncodedChain);
+	Test::Run("write errors", TestWriteErrors);
+	Test::Run("corrupt files", TestCorruptFiles);
+
+	return Test::Finish();
+}
@@ -0,0 +1,194 @@
+#include "DynamicBvh.h"
+#include "JobSystem.h"
+#include "RenderScene.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+
+namespace {
+
+	namespace dx = DirectX;
+
+	using Clock = std::chrono::steady_clock;
+
+	double MsSince(Clock::time_point start) noexcept
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	//row vectors, a * b
+	dx::XMFLOAT4X4 Multiply(const dx::XMFLOAT4X4& a, const dx::XMFLOAT4X4& b) noexcept
+	{
+		dx::XMFLOAT4X4 result;
+
+		for (int r = 0; r < 4; r++) {
+
+			for (int c = 0; c < 4; c++) {
+
+				result.m[r][c] = a.m[r][0] * b.m[0][c] + a.m[r][1] * b.m[1][c] + a.m[r][2] * b.m[2][c] + a.m[r][3] * b.m[3][c];
+			}
+		}
+
+		return result;
+	}
+}
+
+//100k spheres drifting around a field 1000 wide, every one moved every frame: Update on one thread and on the job system,
+//then a frustum from the middle of the field, 100 sphere queries and 1000 rays, and the sphere queries again by brute force
+//usage: DynamicBvhBenchmark [frames]
+int main(int argc, char* argv[])
+{
+	const int nFrames = argc > 1 ? std::max(1, std::atoi(argv[1])) : 100;
+
+	constexpr size_t count = 100'000u;
+	constexpr int nSphereQueries = 100;
+	constexpr int nRays = 1000;
+
+	std::mt19937 rng(1u);
+	std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+	std::uniform_real_distribution<float> height(0.0f, 50.0f);
+	std::uniform_real_distribution<float> radius(0.5f, 3.0f);
+	std::uniform_real_distribution<float> speed(-1.0f, 1.0f);
+
+	struct Object {
+
+		dx::XMFLOAT3 center;
+		dx::XMFLOAT3 velocity;
+		float radius;
+	};
+
+	std::vector<Object> objects(count);
+
+	for (auto& object : objects) {
+
+		object = { { position(rng),height(rng),position(rng) },{ speed(rng),speed(rng) * 0.1f,speed(rng) },radius(rng) };
+	}
+
+	//the queries are the same every frame, so the brute force counts can be checked against them once
+	std::vector<dx::XMFLOAT3> sphereCenters;
+	std::vector<std::pair<dx::XMFLOAT3, dx::XMFLOAT3>> rays;
+
+	for (int i = 0; i < nSphereQueries; i++) {
+
+		sphereCenters.push_back({ position(rng),height(rng),position(rng) });
+	}
+
+	for (int i = 0; i < nRays; i++) {
+
+		rays.push_back({ { position(rng),height(rng),position(rng) },{ speed(rng),speed(rng) * 0.2f,speed(rng) } });
+	}
+
+	const auto viewProj = Multiply(RenderScene::LookAtLH({ 0.0f,30.0f,-100.0f }, { 0.0f,0.0f,100.0f }, { 0.0f,1.0f,0.0f }), RenderScene::PerspectiveLH(1.0f, 9.0f / 16.0f, 0.5f, 400.0f));
+
+	JobSystem jobs;
+
+	std::cout << std::fixed << std::setprecision(3) << count << " objects, " << nFrames << " frames, " << jobs.GetThreadCount() << " threads" << std::endl;
+
+	for (JobSystem* pJobs : { (JobSystem*)nullptr,&jobs }) {
+
+		DynamicBvh bvh;
+		bvh.Resize(count);
+
+		double updateMs = 0.0;
+		double maxUpdateMs = 0.0;
+		double frustumMs = 0.0;
+		double sphereMs = 0.0;
+		double rayMs = 0.0;
+		size_t nVisible = 0u;
+		size_t nNear = 0u;
+		size_t nHits = 0u;
+		std::vector<uint32_t> indices;
+
+		//the first frame is the build
+		const auto buildStart = Clock::now();
+
+		for (size_t i = 0; i < count; i++) {
+
+			bvh.SetSphere(i, objects[i].center, objects[i].radius);
+		}
+
+		bvh.Update(pJobs);
+
+		const double buildMs = MsSince(buildStart);
+
+		for (int frame = 0; frame < nFrames; frame++) {
+
+			//a 60th of a second of drifting
+			for (size_t i = 0; i < count; i++) {
+
+				auto& o = objects[i];
+				o.center = { o.center.x + o.velocity.x / 60.0f,o.center.y + o.velocity.y / 60.0f,o.center.z + o.velocity.z / 60.0f };
+
+				bvh.SetSphere(i, o.center, o.radius);
+			}
+
+			const auto updateStart = Clock::now();
+
+			bvh.Update(pJobs);
+
+			const double ms = MsSince(updateStart);
+			updateMs += ms;
+			maxUpdateMs = std::max(maxUpdateMs, ms);
+
+			const auto frustumStart = Clock::now();
+
+			bvh.QueryFrustum(viewProj, indices);
+			nVisible = indices.size();
+			frustumMs += MsSince(frustumStart);
+
+			const auto sphereStart = Clock::now();
+			nNear = 0u;
+
+			for (const auto& center : sphereCenters) {
+
+				bvh.QuerySphere(center, 20.0f, indices);
+				nNear += indices.size();
+			}
+
+			sphereMs += MsSince(sphereStart);
+
+			const auto rayStart = Clock::now();
+			nHits = 0u;
+
+			for (const auto& ray : rays) {
+
+				nHits += bvh.Raycast(ray.first, ray.second, 200.0f) ? 1u : 0u;
+			}
+
+			rayMs += MsSince(rayStart);
+		}
+
+		const auto& stats = bvh.GetStats();
+
+		std::cout << (pJobs == nullptr ? "one thread" : "job system") << ": build " << buildMs << " ms, update mean " << updateMs / nFrames
+			<< " ms, max " << maxUpdateMs << " ms, " << stats.nRebuilds << " builds, cost " << stats.cost << " (" << stats.builtCost << " built)" << std::endl
+			<< "  frustum " << frustumMs / nFrames << " ms (" << nVisible << " in), "
+			<< nSphereQueries << " spheres " << sphereMs / nFrames << " ms (" << nNear << " found), "
+			<< nRays << " rays " << rayMs / nFrames << " ms (" << nHits << " hits)" << std::endl;
+	}
+
+	//the same queries without the tree, on the objects where the last frame left them
+	const auto bruteStart = Clock::now();
+	size_t nBruteNear = 0u;
+
+	for (const auto& center : sphereCenters) {
+
+		for (const auto& o : objects) {
+
+			const float dx = o.center.x - center.x;
+			const float dy = o.center.y - center.y;
+			const float dz = o.center.z - center.z;
+			const float reach = o.radius + 20.0f;
+
+			nBruteNear += dx * dx + dy * dy + dz * dz <= reach * reach ? 1u : 0u;
+		}
+	}
+
+	std::cout << "brute force: " << nSphereQueries << " spheres " << MsSince(bruteStart) << " ms (" << nBruteNear << " found)" << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,475 @@
+#include "TestCheck.h"
+#include "DynamicBvh.h"
+#include "JobSystem.h"
+#include "RenderScene.h"
+#include <algorithm>
+#include <cmath>
+#include <optional>
+#include <random>
+#include <vector>
+
+namespace {
+
+	namespace dx = DirectX;
+
+	struct Sphere {
+
+		dx::XMFLOAT3 center;
+		float radius;
+	};
+
+	//row vectors, a * b
+	dx::XMFLOAT4X4 Multiply(const dx::XMFLOAT4X4& a, const dx::XMFLOAT4X4& b) noexcept {
+
+		dx::XMFLOAT4X4 result;
+
+		for (int r = 0; r < 4; r++) {
+
+			for (int c = 0; c < 4; c++) {
+
+				result.m[r][c] = a.m[r][0] * b.m[0][c] + a.m[r][1] * b.m[1][c] + a.m[r][2] * b.m[2][c] + a.m[r][3] * b.m[3][c];
+			}
+		}
+
+		return result;
+	}
+
+	//spheres of a few sizes in a box 200 wide, some clumped together so the tree isn't only evenly spread
+	std::vector<Sphere> MakeSpheres(size_t count, std::mt19937& rng) {
+
+		std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+		std::uniform_real_distribution<float> offset(-2.0f, 2.0f);
+		std::uniform_real_distribution<float> radius(0.1f, 3.0f);
+
+		std::vector<Sphere> spheres;
+		dx::XMFLOAT3 clump = { 0.0f,0.0f,0.0f };
+
+		for (size_t i = 0; i < count; i++) {
+
+			if (i % 16u == 0u) {
+
+				clump = { position(rng),position(rng),position(rng) };
+			}
+
+			if (i % 2u == 0u) {
+
+				spheres.push_back({ { clump.x + offset(rng),clump.y + offset(rng),clump.z + offset(rng) },radius(rng) });
+			}
+			else {
+
+				spheres.push_back({ { position(rng),position(rng),position(rng) },radius(rng) });
+			}
+		}
+
+		return spheres;
+	}
+
+	void SetAll(DynamicBvh& bvh, const std::vector<Sphere>& spheres) {
+
+		bvh.Resize(spheres.size());
+
+		for (size_t i = 0; i < spheres.size(); i++) {
+
+			bvh.SetSphere(i, spheres[i].center, spheres[i].radius);
+		}
+	}
+
+	std::vector<uint32_t> Sorted(std::vector<uint32_t> indices) {
+
+		std::sort(indices.begin(), indices.end());
+
+		return indices;
+	}
+
+
+	/// every object one at a time, what the tree has to agree with
+
+	//inside or touching all six planes with the radii grown by slack, the planes taken from the camera rather than the matrix columns
+	std::vector<uint32_t> BruteFrustum(const std::vector<Sphere>& spheres, const dx::XMFLOAT3& eye, const dx::XMFLOAT3& target, float width, float height, float nearZ, float farZ, float slack) {
+
+		//the camera's axes, left handed like LookAtLH
+		const auto normalize = [](dx::XMFLOAT3 v) {
+
+			const float length = std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+			return dx::XMFLOAT3{ v.x / length,v.y / length,v.z / length };
+		};
+		const auto cross = [](const dx::XMFLOAT3& a, const dx::XMFLOAT3& b) {
+
+			return dx::XMFLOAT3{ a.y * b.z - a.z * b.y,a.z * b.x - a.x * b.z,a.x * b.y - a.y * b.x };
+		};
+		const auto dot = [](const dx::XMFLOAT3& a, const dx::XMFLOAT3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; };
+
+		const auto forward = normalize({ target.x - eye.x,target.y - eye.y,target.z - eye.z });
+		const auto right = normalize(cross({ 0.0f,1.0f,0.0f }, forward));
+		const auto up = cross(forward, right);
+
+		//inward normals of the sides, through the edges of the near plane and the eye
+		const float halfW = width * 0.5f / nearZ;
+		const float halfH = height * 0.5f / nearZ;
+		const auto side = [&](float x, float y, const dx::XMFLOAT3& along, float sign) {
+
+			//the corner direction crossed with the edge direction, facing inside
+			const dx::XMFLOAT3 corner = { forward.x + right.x * x + up.x * y,forward.y + right.y * x + up.y * y,forward.z + right.z * x + up.z * y };
+			const auto n = normalize(cross(corner, along));
+
+			return dx::XMFLOAT3{ n.x * sign,n.y * sign,n.z * sign };
+		};
+
+		const dx::XMFLOAT3 normals[4] = {
+			side(-halfW,0.0f,up,-1.0f),
+			side(halfW,0.0f,up,1.0f),
+			side(0.0f,-halfH,right,1.0f),
+			side(0.0f,halfH,right,-1.0f),
+		};
+
+		std::vector<uint32_t> indices;
+
+		for (uint32_t i = 0; i < spheres.size(); i++) {
+
+			const auto& s = spheres[i];
+			const float r = s.radius + slack;
+			const dx::XMFLOAT3 fromEye = { s.center.x - eye.x,s.center.y - eye.y,s.center.z - eye.z };
+			const float depth = dot(fromEye, forward);
+
+			bool isInside = depth >= nearZ - r && depth <= farZ + r;
+
+			for (const auto& n : normals) {
+
+				isInside &= dot(fromEye, n) >= -r;
+			}
+
+			if (isInside) {
+
+				indices.push_back(i);
+			}
+		}
+
+		return indices;
+	}
+
+	std::vector<uint32_t> BruteSphere(const std::vector<Sphere>& spheres, const dx::XMFLOAT3& center, float radius) {
+
+		std::vector<uint32_t> indices;
+
+		for (uint32_t i = 0; i < spheres.size(); i++) {
+
+			const auto& s = spheres[i];
+			const float dx = s.center.x - center.x;
+			const float dy = s.center.y - center.y;
+			const float dz = s.center.z - center.z;
+
+			if (dx * dx + dy * dy + dz * dz <= (s.radius + radius) * (s.radius + radius)) {
+
+				indices.push_back(i);
+			}
+		}
+
+		return indices;
+	}
+
+	//in double, nearest sphere entered within maxDistance, 0 for the ones the ray starts in
+	std::optional<DynamicBvh::Hit> BruteRay(const std::vector<Sphere>& spheres, const dx::XMFLOAT3& origin, const dx::XMFLOAT3& direction, float maxDistance) {
+
+		const double length = std::sqrt((double)direction.x * direction.x + (double)direction.y * direction.y + (double)direction.z * direction.z);
+		const double d[3] = { direction.x / length,direction.y / length,direction.z / length };
+
+		std::optional<DynamicBvh::Hit> hit;
+
+		for (uint32_t i = 0; i < spheres.size(); i++) {
+
+			const auto& s = spheres[i];
+			const double oc[3] = { (double)origin.x - s.center.x,(double)origin.y - s.center.y,(double)origin.z - s.center.z };
+			const double b = oc[0] * d[0] + oc[1] * d[1] + oc[2] * d[2];
+			const double c = oc[0] * oc[0] + oc[1] * oc[1] + oc[2] * oc[2] - (double)s.radius * s.radius;
+			double t = 0.0;
+
+			if (c > 0.0) {
+
+				const double discriminant = b * b - c;
+
+				if (discriminant < 0.0 || -b - std::sqrt(discriminant) < 0.0) {
+
+					continue;
+				}
+
+				t = -b - std::sqrt(discriminant);
+			}
+
+			if (t <= maxDistance && (!hit || t < hit->distance)) {
+
+				hit = DynamicBvh::Hit{ i,(float)t };
+			}
+		}
+
+		return hit;
+	}
+
+	//the same hit, or one the float walk found a hair nearer or further than the double one
+	bool IsSameHit(const std::optional<DynamicBvh::Hit>& a, const std::optional<DynamicBvh::Hit>& b) {
+
+		if (!a || !b) {
+
+			return !a && !b;
+		}
+
+		return std::abs(a->distance - b->distance) <= 1e-3f * std::max(1.0f, b->distance);
+	}
+
+
+	//looking at the middle of the spheres from outside them and from among them, wide and narrow
+	void TestFrustum() {
+
+		std::mt19937 rng(1u);
+		const auto spheres = MakeSpheres(20000u, rng);
+
+		DynamicBvh bvh;
+		SetAll(bvh, spheres);
+		bvh.Update();
+
+		struct View {
+
+			dx::XMFLOAT3 eye;
+			dx::XMFLOAT3 target;
+			float width;
+			float nearZ;
+			float farZ;
+		};
+
+		const View views[] = {
+			{ { 0.0f,20.0f,-250.0f },{ 0.0f,0.0f,0.0f },1.0f,0.5f,400.0f },
+			{ { 10.0f,5.0f,-3.0f },{ 40.0f,-20.0f,60.0f },1.0f,0.5f,80.0f },
+			{ { -50.0f,80.0f,30.0f },{ 0.0f,0.0f,0.0f },0.2f,1.0f,1000.0f },
+			{ { 0.0f,0.0f,0.0f },{ 1.0f,0.0f,0.0f },4.0f,0.1f,30.0f },
+		};
+
+		std::vector<uint32_t> indices;
+		bool isSame = true;
+		size_t nFound = 0u;
+
+		for (const auto& view : views) {
+
+			const float height = view.width * 9.0f / 16.0f;
+			const auto viewProj = Multiply(RenderScene::LookAtLH(view.eye, view.target, { 0.0f,1.0f,0.0f }), RenderScene::PerspectiveLH(view.width, height, view.nearZ, view.farZ));
+
+			bvh.QueryFrustum(viewProj, indices);
+
+			//the two ways round to the planes round differently, only spheres a hair from touching one may go either way
+			const auto found = Sorted(indices);
+			const auto tight = BruteFrustum(spheres, view.eye, view.target, view.width, height, view.nearZ, view.farZ, -1e-3f);
+			const auto loose = BruteFrustum(spheres, view.eye, view.target, view.width, height, view.nearZ, view.farZ, 1e-3f);
+
+			isSame &= std::includes(found.begin(), found.end(), tight.begin(), tight.end()) && std::includes(loose.begin(), loose.end(), found.begin(), found.end());
+			isSame &= std::adjacent_find(found.begin(), found.end()) == found.end();
+			nFound += found.size();
+		}
+
+		CHECK(isSame);
+		//neither all nor none, so the walk had to cut somewhere
+		CHECK(nFound > 100u && nFound < spheres.size() * 2u);
+
+		//straight ahead is in, behind the eye and past the far plane are out
+		const auto viewProj = Multiply(RenderScene::LookAtLH({ 0.0f,0.0f,-10.0f }, { 0.0f,0.0f,0.0f }, { 0.0f,1.0f,0.0f }), RenderScene::PerspectiveLH(1.0f, 1.0f, 1.0f, 50.0f));
+		const std::vector<Sphere> three = { { { 0.0f,0.0f,0.0f },1.0f },{ { 0.0f,0.0f,-20.0f },1.0f },{ { 0.0f,0.0f,45.0f },1.0f } };
+
+		DynamicBvh small;
+		SetAll(small, three);
+		small.Update();
+		small.QueryFrustum(viewProj, indices);
+
+		CHECK(indices == std::vector<uint32_t>{ 0u });
+	}
+
+	void TestSphere() {
+
+		std::mt19937 rng(2u);
+		const auto spheres = MakeSpheres(20000u, rng);
+		std::uniform_real_distribution<float> position(-120.0f, 120.0f);
+		std::uniform_real_distribution<float> radius(0.0f, 40.0f);
+
+		DynamicBvh bvh;
+		SetAll(bvh, spheres);
+		bvh.Update();
+
+		std::vector<uint32_t> indices;
+		bool isSame = true;
+
+		for (int query = 0; query < 200; query++) {
+
+			const dx::XMFLOAT3 center = { position(rng),position(rng),position(rng) };
+			const float r = radius(rng);
+
+			bvh.QuerySphere(center, r, indices);
+			isSame &= Sorted(indices) == BruteSphere(spheres, center, r);
+		}
+
+		CHECK(isSame);
+
+		//one around everything finds everything once
+		bvh.QuerySphere({ 0.0f,0.0f,0.0f }, 1000.0f, indices);
+		CHECK(indices.size() == spheres.size());
+		CHECK(Sorted(indices) == BruteSphere(spheres, { 0.0f,0.0f,0.0f }, 1000.0f));
+	}
+
+	void TestRaycast() {
+
+		std::mt19937 rng(3u);
+		const auto spheres = MakeSpheres(20000u, rng);
+		std::uniform_real_distribution<float> position(-150.0f, 150.0f);
+		std::uniform_real_distribution<float> direction(-1.0f, 1.0f);
+
+		DynamicBvh bvh;
+		SetAll(bvh, spheres);
+		bvh.Update();
+
+		bool isSame = true;
+		size_t nHits = 0u;
+
+		for (int ray = 0; ray < 1000; ray++) {
+
+			const dx::XMFLOAT3 origin = { position(rng),position(rng),position(rng) };
+			//every few not normalized, or along an axis
+			dx::XMFLOAT3 d = { direction(rng),direction(rng),direction(rng) };
+
+			if (ray % 7 == 0) {
+
+				d = { 0.0f,0.0f,ray % 2 == 0 ? 3.0f : -3.0f };
+			}
+
+			const float maxDistance = ray % 3 == 0 ? 50.0f : 3.4e38f;
+			const auto hit = bvh.Raycast(origin, d, maxDistance);
+			const auto expected = BruteRay(spheres, origin, d, maxDistance);
+
+			isSame &= IsSameHit(hit, expected);
+			nHits += hit ? 1u : 0u;
+		}
+
+		CHECK(isSame);
+		CHECK(nHits > 100u && nHits < 1000u);
+
+		//starting inside one is a hit at 0, a zero direction never hits
+		const auto inside = bvh.Raycast(spheres[5].center, { 1.0f,0.0f,0.0f });
+		CHECK(inside && inside->distance == 0.0f);
+		CHECK(!bvh.Raycast({ 0.0f,0.0f,0.0f }, { 0.0f,0.0f,0.0f }));
+	}
+
+	//moving every object and refitting answers the same as a fresh tree, scattering them far enough rebuilds
+	void TestUpdate() {
+
+		std::mt19937 rng(4u);
+		auto spheres = MakeSpheres(50000u, rng);
+		std::uniform_real_distribution<float> step(-0.5f, 0.5f);
+		std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+
+		JobSystem jobs;
+
+		for (JobSystem* pJobs : { (JobSystem*)nullptr,&jobs }) {
+
+			DynamicBvh bvh;
+			SetAll(bvh, spheres);
+			bvh.Update(pJobs);
+
+			CHECK(bvh.GetStats().nRebuilds == 1u);
+			CHECK(bvh.GetStats().nodes > spheres.size() / DynamicBvh::leafSize);
+
+			std::vector<uint32_t> indices;
+			bool isSame = true;
+
+			//small steps only refit
+			for (int frame = 0; frame < 10; frame++) {
+
+				for (size_t i = 0; i < spheres.size(); i++) {
+
+					spheres[i].center = { spheres[i].center.x + step(rng),spheres[i].center.y + step(rng),spheres[i].center.z + step(rng) };
+					bvh.SetSphere(i, spheres[i].center, spheres[i].radius);
+				}
+
+				bvh.Update(pJobs);
+
+				const dx::XMFLOAT3 center = { position(rng),position(rng),position(rng) };
+
+				bvh.QuerySphere(center, 30.0f, indices);
+				isSame &= Sorted(indices) == BruteSphere(spheres, center, 30.0f);
+			}
+
+			CHECK(isSame);
+			CHECK(bvh.GetStats().nRebuilds == 1u);
+			CHECK(bvh.GetStats().cost >= bvh.GetStats().builtCost);
+
+			//everything somewhere else, the refit boxes span the world and it builds again
+			for (size_t i = 0; i < spheres.size(); i++) {
+
+				spheres[i].center = { position(rng),position(rng),position(rng) };
+				bvh.SetSphere(i, spheres[i].center, spheres[i].radius);
+			}
+
+			bvh.Update(pJobs);
+
+			CHECK(bvh.GetStats().nRebuilds == 2u);
+			CHECK(bvh.GetStats().cost == bvh.GetStats().builtCost);
+
+			bvh.QuerySphere({ 0.0f,0.0f,0.0f }, 50.0f, indices);
+			CHECK(Sorted(indices) == BruteSphere(spheres, { 0.0f,0.0f,0.0f }, 50.0f));
+
+			//a new count rebuilds with the objects added
+			const auto more = MakeSpheres(1000u, rng);
+			spheres.insert(spheres.end(), more.begin(), more.end());
+			SetAll(bvh, spheres);
+			bvh.Update(pJobs);
+
+			CHECK(bvh.GetStats().nRebuilds == 3u);
+			CHECK(bvh.GetCount() == spheres.size());
+
+			bvh.QuerySphere({ 0.0f,0.0f,0.0f }, 50.0f, indices);
+			CHECK(Sorted(indices) == BruteSphere(spheres, { 0.0f,0.0f,0.0f }, 50.0f));
+
+			spheres.resize(50000u);
+		}
+	}
+
+	//nothing, one, and a pile of objects on the same spot, which no morton bit splits
+	void TestEdgeCases() {
+
+		DynamicBvh bvh;
+		std::vector<uint32_t> indices = { 7u };
+
+		bvh.Update();
+		bvh.QuerySphere({ 0.0f,0.0f,0.0f }, 10.0f, indices);
+		CHECK(indices.empty());
+		CHECK(!bvh.Raycast({ 0.0f,0.0f,-5.0f }, { 0.0f,0.0f,1.0f }));
+
+		const std::vector<Sphere> one = { { { 1.0f,2.0f,3.0f },0.5f } };
+		SetAll(bvh, one);
+		bvh.Update();
+
+		bvh.QuerySphere({ 1.0f,2.0f,4.0f }, 0.6f, indices);
+		CHECK(indices == std::vector<uint32_t>{ 0u });
+
+		const auto hit = bvh.Raycast({ 1.0f,2.0f,0.0f }, { 0.0f,0.0f,2.0f });
+		CHECK(hit && hit->index == 0u && std::abs(hit->distance - 2.5f) < 1e-5f);
+		CHECK(!bvh.Raycast({ 1.0f,2.0f,0.0f }, { 0.0f,0.0f,1.0f }, 2.0f));
+
+		std::vector<Sphere> pile(1000u, { { 4.0f,4.0f,4.0f },1.0f });
+		pile.push_back({ { -4.0f,-4.0f,-4.0f },1.0f });
+
+		SetAll(bvh, pile);
+		bvh.Update();
+
+		bvh.QuerySphere({ 4.0f,4.0f,4.0f }, 0.1f, indices);
+		CHECK(indices.size() == 1000u);
+		CHECK(Sorted(indices) == BruteSphere(pile, { 4.0f,4.0f,4.0f }, 0.1f));
+
+		const auto pileHit = bvh.Raycast({ -10.0f,-10.0f,-10.0f }, { 1.0f,1.0f,1.0f });
+		CHECK(pileHit && pileHit->index == 1000u);
+	}
+}
+
+int main()
+{
+	Test::Run("frustum", TestFrustum);
+	Test::Run("sphere", TestSphere);
+	Test::Run("raycast", TestRaycast);
+	Test::Run("update", TestUpdate);
+	Test::Run("edge cases", TestEdgeCases);
+
+	return Test::Finish();
+}
@@ -0,0 +1,92 @@
+#include "EventRing.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+
+namespace {
+
+	struct Event {
+
+		uint32_t type;
+		int32_t x;
+		int32_t y;
+		uint32_t buttons;
+		uint64_t timestamp;
+	};
+
+	using Clock = std::chrono::steady_clock;
+}
+
+//events the size of a mouse event streamed from a producer thread to a consumer thread through rings of a few sizes,
+//then pushed and popped in turns on one thread, what a frame reading its own input pays
+//usage: EventRingBenchmark [millions of events]
+int main(int argc, char* argv[])
+{
+	const uint64_t nEvents = (uint64_t)(argc > 1 ? std::max(1, std::atoi(argv[1])) : 20) * 1'000'000u;
+
+	std::cout << std::fixed << std::setprecision(2)
+		<< nEvents / 1'000'000u << "M events of " << sizeof(Event) << " bytes, " << std::thread::hardware_concurrency() << " hardware threads" << std::endl;
+
+	for (const size_t capacity : { 64u,1024u,65536u }) {
+
+		EventRing<Event> ring(capacity);
+		uint64_t nFull = 0u;
+		uint64_t sum = 0u;
+
+		const auto start = Clock::now();
+
+		//the producer waits when the ring is full so every event is counted through
+		std::thread producer([&ring, &nFull, nEvents]() {
+
+			for (uint64_t i = 0; i < nEvents; i++) {
+
+				while (!ring.Push({ 1u,(int32_t)i,0,0u,i })) {
+
+					nFull++;
+					std::this_thread::yield();
+				}
+			}
+		});
+
+		for (uint64_t nReceived = 0u; nReceived < nEvents;) {
+
+			if (const auto event = ring.Pop()) {
+
+				sum += event->timestamp;
+				nReceived++;
+			}
+			else {
+
+				std::this_thread::yield();
+			}
+		}
+
+		producer.join();
+
+		const double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		std::cout << std::setw(6) << ring.GetCapacity() << " events, two threads " << nEvents / ms / 1000.0 << " M events/s, "
+			<< nFull << " pushes found it full" << (sum == nEvents * (nEvents - 1u) / 2u ? "" : ", lost events") << std::endl;
+	}
+
+	EventRing<Event> ring(64u);
+	uint64_t sum = 0u;
+
+	const auto start = Clock::now();
+
+	for (uint64_t i = 0; i < nEvents; i++) {
+
+		ring.Push({ 1u,(int32_t)i,0,0u,i });
+		sum += ring.Pop()->timestamp;
+	}
+
+	const double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+	std::cout << "    64 events, one thread " << ms * 1'000'000.0 / nEvents << " ns per push and pop"
+		<< (sum == nEvents * (nEvents - 1u) / 2u ? "" : ", lost events") << std::endl;
+
+	return 0;
+}
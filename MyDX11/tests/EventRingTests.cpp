@@ -0,0 +1,257 @@
+#include "TestCheck.h"
+#include "EventRing.h"
+#include <deque>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+
+	//fields that only agree with each other when the event was copied whole
+	struct Event {
+
+		uint64_t sequence = 0u;
+		uint64_t tripled = 0u;
+		uint64_t inverted = ~0ull;
+
+		explicit Event(uint64_t sequence = 0u)
+			:
+			sequence(sequence),
+			tripled(sequence * 3u),
+			inverted(~sequence)
+		{}
+
+		bool IsWhole() const noexcept {
+
+			return tripled == sequence * 3u && inverted == ~sequence;
+		}
+	};
+
+	void TestCapacity() {
+
+		CHECK(EventRing<int>(0u).GetCapacity() == 1u);
+		CHECK(EventRing<int>(1u).GetCapacity() == 1u);
+		CHECK(EventRing<int>(5u).GetCapacity() == 8u);
+		CHECK(EventRing<int>(8u).GetCapacity() == 8u);
+		CHECK(EventRing<int>(1000u).GetCapacity() == 1024u);
+
+		//a ring of one still holds an event
+		EventRing<int> one(1u);
+		CHECK(one.Push(7));
+		CHECK(!one.Push(8));
+		CHECK(one.Pop() == 7);
+		CHECK(!one.Pop());
+	}
+
+	//a full ring keeps what it has and drops what comes after
+	void TestOverflow() {
+
+		EventRing<int> ring(8u);
+		CHECK(ring.IsEmpty() && !ring.Pop());
+
+		for (int i = 0; i < 8; i++) {
+
+			CHECK(ring.Push(i));
+		}
+
+		CHECK(!ring.Push(99));
+		CHECK(!ring.Push(100));
+		CHECK(ring.GetOverflowCount() == 2u);
+		CHECK(ring.GetSize() == 8u);
+
+		//room again once the oldest are read, and the positions wrap past the end
+		for (int i = 0; i < 3; i++) {
+
+			CHECK(ring.Pop() == i);
+		}
+
+		for (int i = 8; i < 11; i++) {
+
+			CHECK(ring.Push(i));
+		}
+
+		for (int i = 3; i < 11; i++) {
+
+			CHECK(ring.Pop() == i);
+		}
+
+		CHECK(!ring.Pop());
+		CHECK(ring.GetOverflowCount() == 2u);
+	}
+
+	void TestClear() {
+
+		EventRing<int> ring(4u);
+		ring.Push(1);
+		ring.Push(2);
+		ring.Clear();
+
+		CHECK(ring.IsEmpty() && !ring.Pop());
+
+		//what comes after is kept, in order
+		CHECK(ring.Push(3));
+		CHECK(ring.Push(4));
+		CHECK(ring.Pop() == 3);
+		CHECK(ring.Pop() == 4);
+
+		//clearing an empty ring does nothing
+		ring.Clear();
+		CHECK(ring.IsEmpty());
+	}
+
+	//random pushes and pops across many wraps give what a plain queue capped at the capacity gives
+	void TestAgainstQueue() {
+
+		std::mt19937 rng(3u);
+
+		for (const size_t capacity : { 1u,2u,3u,16u,100u }) {
+
+			EventRing<uint32_t> ring(capacity);
+			std::deque<uint32_t> queue;
+			uint64_t nDropped = 0u;
+			uint32_t next = 0u;
+
+			for (int i = 0; i < 20000; i++) {
+
+				//phases that mostly fill and mostly drain
+				const bool isFilling = (i / 500) % 2 == 0;
+
+				if (rng() % 4u < (isFilling ? 3u : 1u)) {
+
+					const bool isFull = queue.size() == ring.GetCapacity();
+					CHECK(ring.Push(next) == !isFull);
+
+					if (isFull) {
+
+						nDropped++;
+					}
+					else {
+
+						queue.push_back(next);
+					}
+
+					next++;
+				}
+				else {
+
+					const auto event = ring.Pop();
+					CHECK(event.has_value() == !queue.empty());
+
+					if (event && !queue.empty()) {
+
+						CHECK(*event == queue.front());
+						queue.pop_front();
+					}
+				}
+
+				CHECK(ring.GetSize() == queue.size());
+			}
+
+			CHECK(ring.GetOverflowCount() == nDropped);
+			CHECK(nDropped > 0u);
+		}
+	}
+
+	//one producer thread retrying when full, every event arrives once, whole and in order
+	void TestTwoThreads() {
+
+		constexpr uint64_t nEvents = 1'000'000u;
+
+		for (const size_t capacity : { 1u,64u,4096u }) {
+
+			EventRing<Event> ring(capacity);
+			uint64_t nRetries = 0u;
+
+			std::thread producer([&ring, &nRetries]() {
+
+				for (uint64_t i = 0; i < nEvents; i++) {
+
+					while (!ring.Push(Event(i))) {
+
+						nRetries++;
+						std::this_thread::yield();
+					}
+				}
+			});
+
+			uint64_t expected = 0u;
+			bool isOrdered = true;
+
+			while (expected < nEvents) {
+
+				//a snapshot, never more than the ring holds
+				isOrdered &= ring.GetSize() <= ring.GetCapacity();
+
+				if (const auto event = ring.Pop()) {
+
+					isOrdered &= event->sequence == expected && event->IsWhole();
+					expected++;
+				}
+				else {
+
+					std::this_thread::yield();
+				}
+			}
+
+			producer.join();
+
+			CHECK(isOrdered);
+			CHECK(!ring.Pop());
+			CHECK(ring.GetOverflowCount() == nRetries);
+		}
+	}
+
+	//a producer that never waits, like the message pump, loses events only at the counted overflows
+	void TestTwoThreadsDropping() {
+
+		constexpr uint64_t nEvents = 1'000'000u;
+
+		EventRing<Event> ring(256u);
+
+		std::thread producer([&ring]() {
+
+			for (uint64_t i = 0; i < nEvents; i++) {
+
+				ring.Push(Event(i));
+			}
+		});
+
+		uint64_t nReceived = 0u;
+		uint64_t last = 0u;
+		bool isOrdered = true;
+
+		const auto receive = [&]() {
+
+			while (const auto event = ring.Pop()) {
+
+				isOrdered &= event->IsWhole() && (nReceived == 0u || event->sequence > last);
+				last = event->sequence;
+				nReceived++;
+			}
+		};
+
+		while (nReceived + ring.GetOverflowCount() < nEvents) {
+
+			receive();
+			std::this_thread::yield();
+		}
+
+		producer.join();
+		receive();
+
+		CHECK(isOrdered);
+		CHECK(nReceived + ring.GetOverflowCount() == nEvents);
+	}
+}
+
+int main()
+{
+	Test::Run("capacity", TestCapacity);
+	Test::Run("overflow", TestOverflow);
+	Test::Run("clear", TestClear);
+	Test::Run("against a queue", TestAgainstQueue);
+	Test::Run("two threads", TestTwoThreads);
+	Test::Run("two threads dropping", TestTwoThreadsDropping);
+
+	return Test::Finish();
+}
@@ -0,0 +1,195 @@
+#include "TestCheck.h"
+#include "FixedTimestep.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace {
+
+	//powers of two so the sums below are exact
+	constexpr double step = 1.0 / 128.0;
+
+	bool IsNear(double a, double b) noexcept {
+
+		return std::abs(a - b) < 1e-9;
+	}
+
+	void TestSteps() {
+
+		FixedTimestep timestep(step);
+
+		CHECK(timestep.GetAlpha() == 0.0f);
+
+		//three and a half steps, then the half that completes the fourth
+		CHECK(timestep.Advance(3.5 * step) == 3u);
+		CHECK(timestep.GetAlpha() == 0.5f);
+		CHECK(timestep.Advance(0.5 * step) == 1u);
+		CHECK(timestep.GetAlpha() == 0.0f);
+
+		//frames shorter than a step run none until enough has built up
+		CHECK(timestep.Advance(0.25 * step) == 0u);
+		CHECK(timestep.Advance(0.25 * step) == 0u);
+		CHECK(timestep.GetAlpha() == 0.5f);
+		CHECK(timestep.Advance(0.75 * step) == 1u);
+		CHECK(timestep.GetAlpha() == 0.25f);
+
+		CHECK(timestep.GetLastStepCount() == 1u);
+		CHECK(timestep.GetTotalStepCount() == 5u);
+		CHECK(timestep.GetDroppedTime() == 0.0);
+
+		//time doesn't run backwards
+		CHECK(timestep.Advance(-1.0) == 0u);
+		CHECK(timestep.GetAlpha() == 0.25f);
+
+		//a minute at 60 fps with a 120 Hz step is two steps a frame, nothing dropped
+		FixedTimestep steady(1.0 / 120.0);
+		bool isTwo = true;
+
+		for (int frame = 0; frame < 3600; frame++) {
+
+			const unsigned int steps = steady.Advance(1.0 / 60.0);
+			isTwo &= steps >= 1u && steps <= 3u;
+		}
+
+		CHECK(isTwo);
+		CHECK(steady.GetTotalStepCount() >= 7199u && steady.GetTotalStepCount() <= 7200u);
+		CHECK(steady.GetDroppedTime() == 0.0);
+	}
+
+	//past 8 steps the rest of the frame is dropped, the fraction of a step stays
+	void TestCap() {
+
+		FixedTimestep timestep(step, 8u, 0.25);
+
+		CHECK(timestep.Advance(25.5 * step) == 8u);
+		CHECK(timestep.GetAlpha() == 0.5f);
+		CHECK(timestep.GetDroppedTime() == 17.0 * step);
+
+		//the next frame doesn't try to make up for it
+		CHECK(timestep.Advance(1.0 * step) == 1u);
+		CHECK(timestep.GetAlpha() == 0.5f);
+		CHECK(timestep.GetDroppedTime() == 17.0 * step);
+
+		//exactly the cap is fine
+		CHECK(timestep.Advance(7.5 * step) == 8u);
+		CHECK(timestep.GetDroppedTime() == 17.0 * step);
+	}
+
+	//a frame over a quarter second counts as a quarter second
+	void TestClamp() {
+
+		FixedTimestep timestep(step, 1000u, 0.25);
+
+		CHECK(timestep.GetMaxFrameTime() == 0.25);
+		CHECK(timestep.Advance(1.0) == 32u);
+		CHECK(timestep.GetAlpha() == 0.0f);
+		CHECK(timestep.GetDroppedTime() == 0.75);
+
+		//clamped and then capped, both go into the dropped time
+		FixedTimestep capped(step, 8u, 0.25);
+
+		CHECK(capped.Advance(1.0) == 8u);
+		CHECK(capped.GetDroppedTime() == 0.75 + 24.0 * step);
+	}
+
+	//fast forward runs more steps of the same length, the cap only fires when the frame itself was slow
+	void TestSpeed() {
+
+		FixedTimestep timestep(1.0 / 120.0, 8u, 0.25);
+
+		//6x at 30 fps is 24 steps a frame, three times the real time cap
+		bool isAll = true;
+
+		for (int frame = 0; frame < 300; frame++) {
+
+			const unsigned int steps = timestep.Advance(1.0 / 30.0, 6.0);
+			isAll &= steps >= 23u && steps <= 25u;
+		}
+
+		CHECK(isAll);
+		CHECK(timestep.GetLastMaxStepCount() == 48u);
+		CHECK(timestep.GetMaxStepsPerFrame() == 8u);
+		CHECK(timestep.GetDroppedTime() == 0.0);
+		CHECK(timestep.GetTotalStepCount() >= 7199u && timestep.GetTotalStepCount() <= 7200u);
+
+		//a hitch at the same speed is still cut short, at 6 times the steps
+		FixedTimestep slow(step, 8u, 0.25);
+
+		CHECK(slow.Advance(0.25, 6.0) == 48u);
+		CHECK(IsNear(slow.GetDroppedTime(), 1.5 - 48.0 * step));
+
+		//slow motion runs fewer steps, the cap stays at real time
+		FixedTimestep half(step, 8u, 0.25);
+
+		CHECK(half.Advance(step, 0.5) == 0u);
+		CHECK(half.GetAlpha() == 0.5f);
+		CHECK(half.Advance(step, 0.5) == 1u);
+		CHECK(half.Advance(0.25, 0.5) == 8u);
+		CHECK(half.GetLastMaxStepCount() == 8u);
+		CHECK(half.GetDroppedTime() == 8.0 * step);
+
+		//stopped, nothing moves and the blend holds still
+		CHECK(half.Advance(0.1, 0.0) == 0u);
+		CHECK(half.GetAlpha() == 0.0f);
+		CHECK(half.GetDroppedTime() == 8.0 * step);
+	}
+
+	//every simulated second is either stepped, still waiting in alpha or dropped
+	void TestAccounting() {
+
+		std::mt19937 rng(1u);
+		std::uniform_real_distribution<double> frameTime(0.0, 0.4);
+		std::uniform_real_distribution<double> speed(0.0, 6.0);
+
+		FixedTimestep timestep(1.0 / 120.0, 8u, 0.25);
+
+		double simulated = 0.0;
+		bool isAlphaInRange = true;
+		bool isWithinCap = true;
+
+		for (int frame = 0; frame < 10000; frame++) {
+
+			const double seconds = frameTime(rng);
+			const double s = speed(rng);
+			const unsigned int steps = timestep.Advance(seconds, s);
+
+			simulated += seconds * s;
+
+			isAlphaInRange &= timestep.GetAlpha() >= 0.0f && timestep.GetAlpha() < 1.0f;
+			isWithinCap &= steps <= timestep.GetLastMaxStepCount() && timestep.GetLastMaxStepCount() <= (unsigned int)std::ceil(8.0 * std::max(s, 1.0));
+		}
+
+		CHECK(isAlphaInRange);
+		CHECK(isWithinCap);
+		CHECK(timestep.GetDroppedTime() > 0.0);
+
+		const double accounted = timestep.GetTotalStepCount() * (1.0 / 120.0) + timestep.GetAlpha() * (1.0 / 120.0) + timestep.GetDroppedTime();
+		CHECK(std::abs(accounted - simulated) < 1e-6 * simulated);
+	}
+
+	//a new step length keeps the fraction of a step already built up
+	void TestSetStep() {
+
+		FixedTimestep timestep(step);
+
+		timestep.Advance(2.5 * step);
+		timestep.SetStep(step * 0.5);
+
+		CHECK(timestep.GetStep() == (float)(step * 0.5));
+		CHECK(timestep.GetAlpha() == 0.5f);
+		CHECK(timestep.Advance(0.25 * step) == 1u);
+		CHECK(timestep.GetAlpha() == 0.0f);
+	}
+}
+
+int main()
+{
+	Test::Run("steps", TestSteps);
+	Test::Run("cap", TestCap);
+	Test::Run("clamp", TestClamp);
+	Test::Run("speed", TestSpeed);
+	Test::Run("accounting", TestAccounting);
+	Test::Run("set step", TestSetStep);
+
+	return Test::Finish();
+}
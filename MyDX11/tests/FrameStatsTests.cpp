@@ -0,0 +1,313 @@
+#include "TestCheck.h"
+#include "FrameStats.h"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+	constexpr uint64_t frame60Ns = 16'666'667u;
+
+	//a clock that only moves when the test says so
+	struct FakeClock {
+
+		uint64_t nowNs = 1'000'000'000u;
+
+		myTimer::Clock Get() {
+
+			return [this]() { return nowNs; };
+		}
+	};
+
+	//the largest of the smallest percentile / 100 * count values, what an exact percentile gives
+	uint64_t GetExactPercentile(std::vector<uint64_t> values, double percentile) {
+
+		std::sort(values.begin(), values.end());
+		const auto rank = (size_t)std::ceil(percentile / 100.0 * (double)values.size());
+
+		return values[std::max(rank, (size_t)1u) - 1u];
+	}
+
+	void TestTimerSteps() {
+
+		FakeClock clock;
+		myTimer timer(clock.Get());
+
+		clock.nowNs += 2'500'000u;
+		CHECK(timer.PeekNs() == 2'500'000u);
+		CHECK(timer.MarkNs() == 2'500'000u);
+		CHECK(timer.MarkNs() == 0u);
+
+		clock.nowNs += 250'000'000u;
+		CHECK(timer.Mark() == 0.25f);
+	}
+
+	//the first mark only starts timing, each one after gives exactly what the clock moved
+	void TestMarkFrame() {
+
+		FakeClock clock;
+		FrameStats stats(clock.Get(), 8u);
+
+		clock.nowNs += 5'000'000'000u;
+		CHECK(stats.MarkFrame() == 0u);
+		CHECK(stats.GetFrameCount() == 0u);
+
+		const uint64_t steps[] = { 16'000'000u,17'000'000u,1u,33'333'333u };
+		uint64_t endNs = 0u;
+
+		for (const auto step : steps) {
+
+			clock.nowNs += step;
+			CHECK(stats.MarkFrame() == step);
+			endNs += step;
+		}
+
+		const auto frames = stats.GetWindowFrames();
+		CHECK(frames.size() == 4u);
+		CHECK(frames.back().endNs == endNs);
+		CHECK(frames.back().index == 3u);
+		CHECK(frames[1].durationNs == 17'000'000u);
+
+		//time between Reset and the next mark isn't a frame either
+		stats.Reset();
+		clock.nowNs += 900'000'000u;
+		CHECK(stats.MarkFrame() == 0u);
+		clock.nowNs += frame60Ns;
+		CHECK(stats.MarkFrame() == frame60Ns);
+		CHECK(stats.GetFrameCount() == 1u);
+		CHECK(stats.GetWindowFrames().front().index == 0u);
+	}
+
+	//one long frame in a steady 60 fps run is a hitch, measured against the median before it
+	void TestHitch() {
+
+		FakeClock clock;
+		FrameStats stats(clock.Get(), 100u);
+		stats.MarkFrame();
+
+		for (int i = 0; i < 300; i++) {
+
+			clock.nowNs += i == 150 ? 50'000'000u : frame60Ns;
+			stats.MarkFrame();
+		}
+
+		const auto& hitches = stats.GetRecentHitches();
+		CHECK(hitches.size() == 1u);
+
+		if (!hitches.empty()) {
+
+			CHECK(hitches[0].index == 150u);
+			CHECK(hitches[0].durationNs == 50'000'000u);
+			CHECK(hitches[0].medianNs >= frame60Ns && hitches[0].medianNs <= frame60Ns + frame60Ns / 64u);
+		}
+
+		//the window has moved past it, the session hasn't
+		CHECK(stats.GetWindowSummary().hitches == 0u);
+		CHECK(stats.GetSessionSummary().hitches == 1u);
+		CHECK(stats.GetWindowSummary().count == 100u);
+		CHECK(stats.GetSessionSummary().count == 300u);
+	}
+
+	void TestHitchThresholds() {
+
+		FakeClock clock;
+		FrameStats stats(clock.Get(), 64u);
+
+		//a 1 ms scene jumping to 5 ms is five times the median but under the floor
+		for (int i = 0; i < 40; i++) {
+
+			stats.AddFrame(i == 30 ? 5'000'000u : 1'000'000u);
+		}
+
+		CHECK(stats.GetSessionSummary().hitches == 0u);
+
+		//with the floor lowered it counts
+		FrameStats::HitchThresholds thresholds;
+		thresholds.minDurationNs = 2'000'000u;
+		stats.SetHitchThresholds(thresholds);
+		stats.AddFrame(5'000'000u);
+		CHECK(stats.GetSessionSummary().hitches == 1u);
+
+		//and the factor decides how far over the median is too far
+		thresholds.medianFactor = 10.0;
+		stats.SetHitchThresholds(thresholds);
+		stats.AddFrame(5'000'000u);
+		CHECK(stats.GetSessionSummary().hitches == 1u);
+
+		//the first frames never count, there's no median to speak of yet
+		FrameStats early(clock.Get(), 64u);
+
+		for (int i = 0; i < 15; i++) {
+
+			early.AddFrame(i == 14 ? 100'000'000u : frame60Ns);
+		}
+
+		CHECK(early.GetSessionSummary().hitches == 0u);
+
+		//Reset keeps the thresholds
+		stats.Reset();
+		CHECK(stats.GetHitchThresholds().medianFactor == 10.0);
+		CHECK(stats.GetSessionSummary().count == 0u);
+		CHECK(stats.GetRecentHitches().empty());
+	}
+
+	//the mean, deviation and extremes are exact, percentiles at most a bucket over
+	void TestSummaries() {
+
+		FakeClock clock;
+		FrameStats stats(clock.Get(), 500u);
+		std::mt19937_64 rng(1u);
+		std::vector<uint64_t> all;
+
+		for (int i = 0; i < 2000; i++) {
+
+			//mostly 60 fps with a tail out to 100 ms
+			const uint64_t durationNs = rng() % 10u == 0u ? 20'000'000u + rng() % 80'000'000u : 15'000'000u + rng() % 3'000'000u;
+			stats.AddFrame(durationNs);
+			all.push_back(durationNs);
+		}
+
+		const std::vector<uint64_t> window(all.end() - 500, all.end());
+
+		double mean = 0.0;
+
+		for (const auto d : all) {
+
+			mean += (double)d / (double)all.size();
+		}
+
+		double squares = 0.0;
+
+		for (const auto d : all) {
+
+			squares += ((double)d - mean) * ((double)d - mean);
+		}
+
+		const auto session = stats.GetSessionSummary();
+		CHECK(session.count == all.size());
+		CHECK(std::abs(session.meanNs - mean) < 1.0);
+		CHECK(std::abs(session.stdDevNs - std::sqrt(squares / (double)all.size())) < 1.0);
+		CHECK(session.minNs == *std::min_element(all.begin(), all.end()));
+		CHECK(session.maxNs == *std::max_element(all.begin(), all.end()));
+
+		const auto windowSummary = stats.GetWindowSummary();
+		CHECK(windowSummary.count == window.size());
+		CHECK(windowSummary.maxNs == *std::max_element(window.begin(), window.end()));
+
+		for (const double percentile : { 50.0,95.0,99.0 }) {
+
+			const uint64_t sessionExact = GetExactPercentile(all, percentile);
+			const uint64_t sessionGot = stats.GetSessionPercentile(percentile);
+			CHECK(sessionGot >= sessionExact && sessionGot - sessionExact <= sessionExact / 64u);
+
+			const uint64_t windowExact = GetExactPercentile(window, percentile);
+			const uint64_t windowGot = stats.GetWindowPercentile(percentile);
+			CHECK(windowGot >= windowExact && windowGot - windowExact <= windowExact / 64u);
+		}
+
+		CHECK(session.p50Ns <= session.p95Ns && session.p95Ns <= session.p99Ns && session.p99Ns <= session.maxNs);
+	}
+
+	void TestHistogram() {
+
+		using Histogram = FrameStats::Histogram;
+
+		//every value lands in the bucket whose top is the first at or above it
+		for (const uint64_t value : { 0ull,1ull,127ull,128ull,129ull,255ull,256ull,16'666'667ull,~0ull }) {
+
+			const size_t bucket = Histogram::GetBucket(value);
+			CHECK(Histogram::GetBucketTop(bucket) >= value);
+			CHECK(bucket == 0u || Histogram::GetBucketTop(bucket - 1u) < value);
+		}
+
+		std::mt19937_64 rng(3u);
+		std::vector<uint64_t> values;
+		Histogram histogram;
+
+		for (int i = 0; i < 50000; i++) {
+
+			const uint64_t value = rng() >> (rng() % 64u);
+			values.push_back(value);
+			histogram.Add(value);
+		}
+
+		for (const double percentile : { 0.1,1.0,50.0,95.0,99.0,100.0 }) {
+
+			const uint64_t exact = GetExactPercentile(values, percentile);
+			const uint64_t got = histogram.GetPercentile(percentile);
+			CHECK(got >= exact && (double)(got - exact) <= (double)exact / 64.0 + 1.0);
+		}
+
+		//removing everything that was added leaves it empty
+		for (const auto value : values) {
+
+			histogram.Remove(value);
+		}
+
+		CHECK(histogram.GetCount() == 0u);
+		CHECK(histogram.GetPercentile(50.0) == 0u);
+	}
+
+	void TestExport() {
+
+		FakeClock clock;
+		FrameStats stats(clock.Get(), 32u);
+
+		for (int i = 0; i < 40; i++) {
+
+			stats.AddFrame(i == 35 ? 60'000'000u : frame60Ns);
+		}
+
+		//a header and one row per window frame, the hitch marked
+		const auto csv = stats.MakeCsv();
+		CHECK(std::count(csv.begin(), csv.end(), '\n') == 33);
+		CHECK(csv.rfind("frame,end_ns,duration_ns,hitch\n", 0u) == 0u);
+		CHECK(csv.find("35," + std::to_string(35u * frame60Ns + 60'000'000u) + ",60000000,1\n") != std::string::npos);
+
+		const auto json = stats.MakeJson();
+		CHECK(json.find("\"hitches\":[\n{\"frame\":35,") != std::string::npos);
+		CHECK(std::count(json.begin(), json.end(), '{') == std::count(json.begin(), json.end(), '}'));
+		CHECK(std::count(json.begin(), json.end(), '[') == std::count(json.begin(), json.end(), ']'));
+
+		const auto path = (std::filesystem::temp_directory_path() / "MyDX11FrameStatsTests.csv").string();
+		stats.SaveCsv(path);
+
+		{
+			std::ifstream file(path, std::ios::binary);
+			CHECK(std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()) == csv);
+		}
+
+		std::filesystem::remove(path);
+
+		bool hasThrown = false;
+
+		try {
+
+			stats.SaveJson("/nonexistent directory/stats.json");
+		}
+		catch (const FrameStats::Exception&) {
+
+			hasThrown = true;
+		}
+
+		CHECK(hasThrown);
+	}
+}
+
+int main()
+{
+	Test::Run("timer steps", TestTimerSteps);
+	Test::Run("mark frame", TestMarkFrame);
+	Test::Run("hitch", TestHitch);
+	Test::Run("hitch thresholds", TestHitchThresholds);
+	Test::Run("summaries", TestSummaries);
+	Test::Run("histogram", TestHistogram);
+	Test::Run("export", TestExport);
+
+	return Test::Finish();
+}
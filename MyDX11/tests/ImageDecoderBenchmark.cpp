@@ -0,0 +1,107 @@
+#include "ImageDecoder.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <iterator>
+#include <string>
+#include <vector>
+
+//decode time of every PNG and JPEG under asset/, one file at a time and then all of them at once on the job system
+//files are read into memory first so only decoding is timed
+//usage: ImageDecoderBenchmark [repeats]
+int main(int argc, char* argv[])
+{
+	const int nRepeats = argc > 1 ? std::max(1, std::atoi(argv[1])) : 10;
+
+	struct File {
+
+		std::string path;
+		std::vector<uint8_t> bytes;
+		std::vector<uint32_t> texels;
+		unsigned int width = 0u;
+		unsigned int height = 0u;
+	};
+
+	std::vector<File> files;
+
+	for (const auto& entry : std::filesystem::recursive_directory_iterator("asset")) {
+
+		const auto extension = entry.path().extension().string();
+
+		if (extension == ".png" || extension == ".jpg") {
+
+			std::ifstream stream(entry.path(), std::ios::binary);
+
+			File file;
+			file.path = entry.path().generic_string();
+			file.bytes.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+			files.push_back(std::move(file));
+		}
+	}
+
+	std::sort(files.begin(), files.end(), [](const File& a, const File& b) { return a.path < b.path; });
+
+	auto decode = [](File& file) {
+
+		ImageDecoder::Decode(file.bytes.data(), file.bytes.size(), [&file](unsigned int width, unsigned int height) {
+
+			file.width = width;
+			file.height = height;
+			file.texels.resize((size_t)width * height);
+
+			return file.texels.data();
+		});
+	};
+
+	std::cout << std::fixed << std::setprecision(2) << files.size() << " files, " << nRepeats << " repeats" << std::endl;
+
+	double serialMs = 0.0;
+	size_t nTexels = 0u;
+
+	for (auto& file : files) {
+
+		decode(file);
+
+		const auto start = std::chrono::steady_clock::now();
+
+		for (int i = 0; i < nRepeats; i++) {
+
+			decode(file);
+		}
+
+		const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / nRepeats;
+
+		serialMs += ms;
+		nTexels += (size_t)file.width * file.height;
+
+		std::cout << std::setw(8) << ms << " ms  " << std::setw(5) << file.width << "x" << std::setw(5) << std::left << file.height << std::right
+			<< " " << std::setw(8) << file.bytes.size() / 1024u << " KB  " << file.path << std::endl;
+	}
+
+	//one file per job, the way the texture loader hands them out
+	JobSystem jobs;
+	const auto start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < nRepeats; i++) {
+
+		jobs.ParallelFor(files.size(), 1u, [&](size_t first, size_t last) {
+
+			for (size_t f = first; f < last; f++) {
+
+				decode(files[f]);
+			}
+		});
+	}
+
+	const double parallelMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / nRepeats;
+
+	std::cout << serialMs << " ms for all files one at a time, " << nTexels / serialMs / 1000.0 << " Mtexel/s" << std::endl
+		<< parallelMs << " ms for all files on " << jobs.GetThreadCount() << " threads, " << nTexels / parallelMs / 1000.0 << " Mtexel/s" << std::endl;
+
+	return 0;
+}
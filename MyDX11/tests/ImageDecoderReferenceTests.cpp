@@ -0,0 +1,326 @@
+#include "TestCheck.h"
+#include "ImageDecoder.h"
+#include <png.h>
+#include <jpeglib.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+//the decoder against libpng and libjpeg on files those libraries write, and on the shipped assets
+//*only built when both libraries are found, ImageDecoderTests covers the decoder without them
+namespace {
+
+	struct Image {
+
+		unsigned int width = 0u;
+		unsigned int height = 0u;
+		std::vector<uint32_t> texels;
+	};
+
+	Image Decode(const std::vector<uint8_t>& bytes) {
+
+		Image image;
+
+		ImageDecoder::Decode(bytes.data(), bytes.size(), [&image](unsigned int width, unsigned int height) {
+
+			image.width = width;
+			image.height = height;
+			image.texels.resize((size_t)width * height);
+
+			return image.texels.data();
+		});
+
+		return image;
+	}
+
+	Image DecodeReferencePng(const std::vector<uint8_t>& bytes) {
+
+		png_image png = {};
+		png.version = PNG_IMAGE_VERSION;
+
+		Image image;
+
+		if (png_image_begin_read_from_memory(&png, bytes.data(), bytes.size()) == 0) {
+
+			return image;
+		}
+
+		png.format = PNG_FORMAT_BGRA;
+		image.width = png.width;
+		image.height = png.height;
+		image.texels.resize((size_t)png.width * png.height);
+
+		if (png_image_finish_read(&png, nullptr, image.texels.data(), 0, nullptr) == 0) {
+
+			image.texels.clear();
+		}
+
+		return image;
+	}
+
+	//float idct and plain upsampling, the closest libjpeg has to what the decoder does
+	Image DecodeReferenceJpeg(const std::vector<uint8_t>& bytes) {
+
+		jpeg_decompress_struct info;
+		jpeg_error_mgr error;
+		info.err = jpeg_std_error(&error);
+		jpeg_create_decompress(&info);
+		jpeg_mem_src(&info, bytes.data(), (unsigned long)bytes.size());
+		jpeg_read_header(&info, TRUE);
+
+		info.dct_method = JDCT_FLOAT;
+		info.do_fancy_upsampling = FALSE;
+		info.out_color_space = info.num_components == 1 ? JCS_GRAYSCALE : JCS_RGB;
+		jpeg_start_decompress(&info);
+
+		Image image;
+		image.width = info.output_width;
+		image.height = info.output_height;
+		image.texels.resize((size_t)image.width * image.height);
+
+		std::vector<uint8_t> row((size_t)image.width * info.output_components);
+
+		while (info.output_scanline < info.output_height) {
+
+			const unsigned int y = info.output_scanline;
+			uint8_t* pRow = row.data();
+			jpeg_read_scanlines(&info, &pRow, 1u);
+
+			for (unsigned int x = 0; x < image.width; x++) {
+
+				const uint8_t* p = &row[(size_t)x * info.output_components];
+				const uint32_t r = p[0];
+				const uint32_t g = info.output_components == 1 ? p[0] : p[1];
+				const uint32_t b = info.output_components == 1 ? p[0] : p[2];
+
+				image.texels[(size_t)y * image.width + x] = 0xFF000000u | (r << 16u) | (g << 8u) | b;
+			}
+		}
+
+		jpeg_finish_decompress(&info);
+		jpeg_destroy_decompress(&info);
+
+		return image;
+	}
+
+	//largest difference of any channel over the whole image
+	int GetMaxDifference(const Image& a, const Image& b) {
+
+		if (a.width != b.width || a.height != b.height || a.texels.size() != b.texels.size()) {
+
+			return 256;
+		}
+
+		int difference = 0;
+
+		for (size_t i = 0; i < a.texels.size(); i++) {
+
+			for (int shift = 0; shift < 32; shift += 8) {
+
+				difference = std::max(difference, std::abs((int)((a.texels[i] >> shift) & 0xFFu) - (int)((b.texels[i] >> shift) & 0xFFu)));
+			}
+		}
+
+		return difference;
+	}
+
+	void WritePngBytes(png_structp pPng, png_bytep pData, png_size_t size) {
+
+		auto& bytes = *static_cast<std::vector<uint8_t>*>(png_get_io_ptr(pPng));
+		bytes.insert(bytes.end(), pData, pData + size);
+	}
+
+	std::vector<uint8_t> WritePng(unsigned int width, unsigned int height, int colorType, int depth, int level, int filters, std::mt19937& rng) {
+
+		std::vector<uint8_t> bytes;
+
+		png_structp pPng = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+		png_infop pInfo = png_create_info_struct(pPng);
+		png_set_write_fn(pPng, &bytes, WritePngBytes, nullptr);
+		png_set_IHDR(pPng, pInfo, width, height, depth, colorType, PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+		png_set_compression_level(pPng, level);
+		png_set_filter(pPng, 0, filters);
+
+		if (colorType == PNG_COLOR_TYPE_PALETTE) {
+
+			png_color palette[256];
+
+			for (auto& entry : palette) {
+
+				entry = { (png_byte)rng(),(png_byte)rng(),(png_byte)rng() };
+			}
+
+			const png_byte alpha[] = { 0u,50u,100u };
+			png_set_PLTE(pPng, pInfo, palette, 1 << depth);
+			png_set_tRNS(pPng, pInfo, alpha, std::min(3, 1 << depth), nullptr);
+		}
+
+		png_write_info(pPng, pInfo);
+
+		//noise and gradients mixed, so deflate finds both literals and matches
+		const int nChannels = colorType == PNG_COLOR_TYPE_RGB ? 3 : colorType == PNG_COLOR_TYPE_GRAY_ALPHA ? 2 : colorType == PNG_COLOR_TYPE_RGBA ? 4 : 1;
+		std::vector<uint8_t> row(((size_t)width * nChannels * depth + 7u) / 8u);
+
+		for (unsigned int y = 0; y < height; y++) {
+
+			for (size_t i = 0; i < row.size(); i++) {
+
+				row[i] = i % 7u < 3u ? (uint8_t)rng() : (uint8_t)(y * 3u + i);
+			}
+
+			png_write_row(pPng, row.data());
+		}
+
+		png_write_end(pPng, pInfo);
+		png_destroy_write_struct(&pPng, &pInfo);
+
+		return bytes;
+	}
+
+	std::vector<uint8_t> WriteJpeg(unsigned int width, unsigned int height, int nComponents, int hSampling, int vSampling, unsigned int restartInterval, bool isOptimized, std::mt19937& rng) {
+
+		jpeg_compress_struct info;
+		jpeg_error_mgr error;
+		info.err = jpeg_std_error(&error);
+		jpeg_create_compress(&info);
+
+		unsigned char* pBuffer = nullptr;
+		unsigned long size = 0u;
+		jpeg_mem_dest(&info, &pBuffer, &size);
+
+		info.image_width = width;
+		info.image_height = height;
+		info.input_components = nComponents;
+		info.in_color_space = nComponents == 1 ? JCS_GRAYSCALE : JCS_RGB;
+		jpeg_set_defaults(&info);
+		jpeg_set_quality(&info, 85, TRUE);
+
+		if (nComponents == 3) {
+
+			info.comp_info[0].h_samp_factor = hSampling;
+			info.comp_info[0].v_samp_factor = vSampling;
+		}
+
+		info.restart_interval = restartInterval;
+		info.optimize_coding = isOptimized ? TRUE : FALSE;
+		jpeg_start_compress(&info, TRUE);
+
+		std::vector<uint8_t> row((size_t)width * nComponents);
+
+		while (info.next_scanline < height) {
+
+			for (size_t x = 0; x < row.size(); x++) {
+
+				row[x] = (uint8_t)(x * 2u + info.next_scanline * 3u + (rng() & 31u));
+			}
+
+			uint8_t* pRow = row.data();
+			jpeg_write_scanlines(&info, &pRow, 1u);
+		}
+
+		jpeg_finish_compress(&info);
+		std::vector<uint8_t> bytes(pBuffer, pBuffer + size);
+		std::free(pBuffer);
+		jpeg_destroy_compress(&info);
+
+		return bytes;
+	}
+
+	//zlib at every level the encoder uses (stored, fixed and dynamic huffman) with every filter
+	//*16 bit samples are left to ImageDecoderTests, libpng's simplified reader linearizes them instead of keeping the high byte
+	void TestLibpngFiles() {
+
+		struct Format {
+
+			int colorType;
+			int depth;
+		};
+
+		const Format formats[] = {
+			{ PNG_COLOR_TYPE_GRAY,1 },{ PNG_COLOR_TYPE_GRAY,2 },{ PNG_COLOR_TYPE_GRAY,4 },{ PNG_COLOR_TYPE_GRAY,8 },
+			{ PNG_COLOR_TYPE_RGB,8 },
+			{ PNG_COLOR_TYPE_PALETTE,1 },{ PNG_COLOR_TYPE_PALETTE,2 },{ PNG_COLOR_TYPE_PALETTE,4 },{ PNG_COLOR_TYPE_PALETTE,8 },
+			{ PNG_COLOR_TYPE_GRAY_ALPHA,8 },{ PNG_COLOR_TYPE_RGBA,8 },
+		};
+
+		std::mt19937 rng(5u);
+
+		for (const auto& format : formats) {
+
+			for (const int level : { 0,1,9 }) {
+
+				for (const int filters : { PNG_FILTER_NONE,PNG_FILTER_SUB,PNG_FILTER_UP,PNG_FILTER_AVG,PNG_FILTER_PAETH,PNG_ALL_FILTERS }) {
+
+					const auto bytes = WritePng(1u + rng() % 70u, 1u + rng() % 40u, format.colorType, format.depth, level, filters, rng);
+
+					CHECK(GetMaxDifference(Decode(bytes), DecodeReferencePng(bytes)) == 0);
+				}
+			}
+		}
+	}
+
+	//gray, and color with every chroma subsampling, with and without restart markers and optimized huffman tables
+	void TestLibjpegFiles() {
+
+		std::mt19937 rng(5u);
+		const std::pair<int, int> samplings[] = { { 1,1 },{ 2,1 },{ 1,2 },{ 2,2 } };
+
+		for (const int nComponents : { 1,3 }) {
+
+			for (const auto& sampling : samplings) {
+
+				if (nComponents == 1 && sampling.first * sampling.second != 1) {
+
+					continue;
+				}
+
+				for (const unsigned int restartInterval : { 0u,3u }) {
+
+					for (const bool isOptimized : { false,true }) {
+
+						const auto bytes = WriteJpeg(1u + rng() % 90u, 1u + rng() % 70u, nComponents, sampling.first, sampling.second, restartInterval, isOptimized, rng);
+
+						//float rounding may move a channel by one
+						CHECK(GetMaxDifference(Decode(bytes), DecodeReferenceJpeg(bytes)) <= 1);
+					}
+				}
+			}
+		}
+	}
+
+	void TestAssets() {
+
+		for (const auto& entry : std::filesystem::recursive_directory_iterator("asset")) {
+
+			const auto extension = entry.path().extension().string();
+
+			if (extension != ".png" && extension != ".jpg") {
+
+				continue;
+			}
+
+			std::ifstream file(entry.path(), std::ios::binary);
+			const std::vector<uint8_t> bytes = { std::istreambuf_iterator<char>(file),std::istreambuf_iterator<char>() };
+
+			const int difference = GetMaxDifference(Decode(bytes), extension == ".png" ? DecodeReferencePng(bytes) : DecodeReferenceJpeg(bytes));
+
+			CHECK(difference <= (extension == ".png" ? 0 : 2));
+		}
+	}
+}
+
+int main()
+{
+	Test::Run("libpng written files", TestLibpngFiles);
+	Test::Run("libjpeg written files", TestLibjpegFiles);
+	Test::Run("assets", TestAssets);
+
+	return Test::Finish();
+}
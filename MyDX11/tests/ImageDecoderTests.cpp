@@ -0,0 +1,554 @@
+#include "TestCheck.h"
+#include "ImageDecoder.h"
+#include "ImageEncoder.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+	struct Image {
+
+		unsigned int width = 0u;
+		unsigned int height = 0u;
+		std::vector<uint32_t> texels;
+	};
+
+	Image Decode(const std::vector<uint8_t>& bytes) {
+
+		Image image;
+
+		ImageDecoder::Decode(bytes.data(), bytes.size(), [&image](unsigned int width, unsigned int height) {
+
+			image.width = width;
+			image.height = height;
+			image.texels.resize((size_t)width * height);
+
+			return image.texels.data();
+		});
+
+		return image;
+	}
+
+	std::vector<uint8_t> ReadFile(const std::string& path) {
+
+		std::ifstream file(path, std::ios::binary);
+
+		return { std::istreambuf_iterator<char>(file),std::istreambuf_iterator<char>() };
+	}
+
+	uint32_t MakeTexel(unsigned int r, unsigned int g, unsigned int b, unsigned int a) noexcept {
+
+		return (a << 24u) | (r << 16u) | (g << 8u) | b;
+	}
+
+
+	/// writes PNGs the decoder has to handle with nothing but stored deflate blocks,
+	/// so every color type, bit depth and filter can be checked against the samples that went in
+
+	uint32_t Crc32(const uint8_t* pData, size_t size) noexcept {
+
+		static const auto table = []() {
+
+			std::array<uint32_t, 256> t = {};
+
+			for (uint32_t n = 0; n < 256u; n++) {
+
+				uint32_t c = n;
+
+				for (int k = 0; k < 8; k++) {
+
+					c = c & 1u ? 0xEDB88320u ^ (c >> 1u) : c >> 1u;
+				}
+
+				t[n] = c;
+			}
+
+			return t;
+		}();
+
+		uint32_t crc = 0xFFFFFFFFu;
+
+		for (size_t i = 0; i < size; i++) {
+
+			crc = table[(crc ^ pData[i]) & 0xFFu] ^ (crc >> 8u);
+		}
+
+		return crc ^ 0xFFFFFFFFu;
+	}
+
+	void PutBigEndian(std::vector<uint8_t>& out, uint32_t value) {
+
+		out.push_back((uint8_t)(value >> 24u));
+		out.push_back((uint8_t)(value >> 16u));
+		out.push_back((uint8_t)(value >> 8u));
+		out.push_back((uint8_t)value);
+	}
+
+	void PutChunk(std::vector<uint8_t>& out, const char* type, const std::vector<uint8_t>& data) {
+
+		PutBigEndian(out, (uint32_t)data.size());
+
+		const size_t start = out.size();
+		out.insert(out.end(), type, type + 4);
+		out.insert(out.end(), data.begin(), data.end());
+
+		PutBigEndian(out, Crc32(out.data() + start, out.size() - start));
+	}
+
+	uint8_t Paeth(int a, int b, int c) noexcept {
+
+		const int p = a + b - c;
+		const int pa = std::abs(p - a);
+		const int pb = std::abs(p - b);
+		const int pc = std::abs(p - c);
+
+		return (uint8_t)(pa <= pb && pa <= pc ? a : pb <= pc ? b : c);
+	}
+
+	struct PngDesc {
+
+		PngDesc(unsigned int width, unsigned int height, uint8_t colorType, uint8_t depth, bool isInterlaced = false)
+			:
+			width(width),
+			height(height),
+			colorType(colorType),
+			depth(depth),
+			isInterlaced(isInterlaced)
+		{}
+
+		unsigned int width;
+		unsigned int height;
+		uint8_t colorType;
+		uint8_t depth;
+		bool isInterlaced;
+		std::vector<uint8_t> palette;
+		std::vector<uint8_t> transparency;
+	};
+
+	//rows are unfiltered bytes as the PNG stores them, filter -1 picks a different one every row
+	std::vector<uint8_t> MakePng(const PngDesc& desc, const std::vector<std::vector<uint8_t>>& rows, int filter) {
+
+		static constexpr unsigned int channels[] = { 1u,0u,3u,1u,2u,0u,4u };
+		const size_t bpp = std::max(1u, channels[desc.colorType] * desc.depth / 8u);
+
+		//filtered scanlines, each behind its filter type byte
+		std::vector<uint8_t> raw;
+
+		for (size_t y = 0; y < rows.size(); y++) {
+
+			const auto& row = rows[y];
+			const uint8_t type = (uint8_t)(filter < 0 ? y % 5u : (size_t)filter);
+			raw.push_back(type);
+
+			for (size_t i = 0; i < row.size(); i++) {
+
+				const int a = i >= bpp ? row[i - bpp] : 0;
+				const int b = y > 0 ? rows[y - 1][i] : 0;
+				const int c = i >= bpp && y > 0 ? rows[y - 1][i - bpp] : 0;
+				const uint8_t predictor = type == 1u ? (uint8_t)a : type == 2u ? (uint8_t)b : type == 3u ? (uint8_t)((a + b) / 2) : type == 4u ? Paeth(a, b, c) : 0u;
+
+				raw.push_back((uint8_t)(row[i] - predictor));
+			}
+		}
+
+		//zlib stream of stored blocks
+		std::vector<uint8_t> zlib = { 0x78u,0x01u };
+		size_t offset = 0u;
+
+		do {
+
+			const size_t length = std::min<size_t>(raw.size() - offset, 65535u);
+			const bool isLast = offset + length == raw.size();
+
+			zlib.push_back(isLast ? 1u : 0u);
+			zlib.push_back((uint8_t)length);
+			zlib.push_back((uint8_t)(length >> 8u));
+			zlib.push_back((uint8_t)~length);
+			zlib.push_back((uint8_t)(~length >> 8u));
+			zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + length);
+
+			offset += length;
+		} while (offset < raw.size());
+
+		uint32_t s1 = 1u;
+		uint32_t s2 = 0u;
+
+		for (const uint8_t byte : raw) {
+
+			s1 = (s1 + byte) % 65521u;
+			s2 = (s2 + s1) % 65521u;
+		}
+
+		PutBigEndian(zlib, (s2 << 16u) | s1);
+
+		std::vector<uint8_t> png = { 0x89u,'P','N','G','\r','\n',0x1Au,'\n' };
+		std::vector<uint8_t> header;
+
+		PutBigEndian(header, desc.width);
+		PutBigEndian(header, desc.height);
+		header.insert(header.end(), { desc.depth,desc.colorType,0u,0u,(uint8_t)(desc.isInterlaced ? 1u : 0u) });
+		PutChunk(png, "IHDR", header);
+
+		if (!desc.palette.empty()) {
+
+			PutChunk(png, "PLTE", desc.palette);
+		}
+
+		if (!desc.transparency.empty()) {
+
+			PutChunk(png, "tRNS", desc.transparency);
+		}
+
+		//split in two so the decoder has to join IDAT chunks
+		const size_t half = zlib.size() / 2u;
+		PutChunk(png, "IDAT", std::vector<uint8_t>(zlib.begin(), zlib.begin() + half));
+		PutChunk(png, "IDAT", std::vector<uint8_t>(zlib.begin() + half, zlib.end()));
+		PutChunk(png, "IEND", {});
+
+		return png;
+	}
+
+	//packs samples of any depth from the high bit down, 16 bit ones big endian
+	std::vector<uint8_t> PackRow(const std::vector<unsigned int>& samples, unsigned int depth) {
+
+		std::vector<uint8_t> row;
+
+		if (depth == 16u) {
+
+			for (const auto s : samples) {
+
+				row.push_back((uint8_t)(s >> 8u));
+				row.push_back((uint8_t)s);
+			}
+
+			return row;
+		}
+
+		row.assign((samples.size() * depth + 7u) / 8u, 0u);
+
+		for (size_t i = 0; i < samples.size(); i++) {
+
+			const size_t bit = i * depth;
+			row[bit / 8u] |= (uint8_t)(samples[i] << (8u - depth - bit % 8u));
+		}
+
+		return row;
+	}
+
+	//every color type at every bit depth it allows, through every filter, against the samples written
+	void TestPngFormats() {
+
+		struct Format {
+
+			uint8_t colorType;
+			uint8_t depth;
+		};
+
+		const Format formats[] = {
+			{ 0u,1u },{ 0u,2u },{ 0u,4u },{ 0u,8u },{ 0u,16u },
+			{ 2u,8u },{ 2u,16u },
+			{ 3u,1u },{ 3u,2u },{ 3u,4u },{ 3u,8u },
+			{ 4u,8u },{ 4u,16u },
+			{ 6u,8u },{ 6u,16u },
+		};
+
+		static constexpr unsigned int channels[] = { 1u,0u,3u,1u,2u,0u,4u };
+		std::mt19937 rng(5u);
+
+		for (const auto& format : formats) {
+
+			for (int filter = -1; filter <= 4; filter++) {
+
+				PngDesc desc((unsigned int)(1u + rng() % 37u), (unsigned int)(1u + rng() % 20u), format.colorType, format.depth);
+				const unsigned int maxSample = (1u << format.depth) - 1u;
+
+				//palette entries with alpha for the first few from tRNS, the rest opaque
+				std::vector<uint32_t> palette;
+
+				if (format.colorType == 3u) {
+
+					for (unsigned int i = 0; i <= maxSample; i++) {
+
+						const uint8_t r = (uint8_t)rng(), g = (uint8_t)rng(), b = (uint8_t)rng();
+						desc.palette.insert(desc.palette.end(), { r,g,b });
+						palette.push_back(MakeTexel(r, g, b, 255u));
+					}
+
+					for (unsigned int i = 0; i < std::min(3u, maxSample + 1u); i++) {
+
+						const uint8_t a = (uint8_t)(i * 100u);
+						desc.transparency.push_back(a);
+						palette[i] = (palette[i] & 0x00FFFFFFu) | ((uint32_t)a << 24u);
+					}
+				}
+
+				std::vector<std::vector<uint8_t>> rows;
+				std::vector<uint32_t> expected;
+
+				auto to8 = [&format, maxSample](unsigned int s) {
+
+					return format.depth == 16u ? s >> 8u : format.depth < 8u ? s * (255u / maxSample) : s;
+				};
+
+				for (unsigned int y = 0; y < desc.height; y++) {
+
+					std::vector<unsigned int> samples;
+
+					for (unsigned int x = 0; x < desc.width; x++) {
+
+						unsigned int s[4];
+
+						for (unsigned int c = 0; c < channels[format.colorType]; c++) {
+
+							s[c] = rng() % (maxSample + 1u);
+							samples.push_back(s[c]);
+						}
+
+						switch (format.colorType) {
+
+						case 0u: expected.push_back(MakeTexel(to8(s[0]), to8(s[0]), to8(s[0]), 255u)); break;
+						case 2u: expected.push_back(MakeTexel(to8(s[0]), to8(s[1]), to8(s[2]), 255u)); break;
+						case 3u: expected.push_back(palette[s[0]]); break;
+						case 4u: expected.push_back(MakeTexel(to8(s[0]), to8(s[0]), to8(s[0]), to8(s[1]))); break;
+						default: expected.push_back(MakeTexel(to8(s[0]), to8(s[1]), to8(s[2]), to8(s[3]))); break;
+						}
+					}
+
+					rows.push_back(PackRow(samples, format.depth));
+				}
+
+				const auto image = Decode(MakePng(desc, rows, filter));
+
+				CHECK(image.width == desc.width);
+				CHECK(image.height == desc.height);
+				CHECK(image.texels == expected);
+			}
+		}
+	}
+
+	//tRNS color keys make one gray level or one rgb color transparent
+	void TestPngColorKey() {
+
+		PngDesc gray(3u, 1u, 0u, 8u);
+		gray.transparency = { 0u,20u };
+
+		CHECK(Decode(MakePng(gray, { { 10u,20u,30u } }, 0)).texels ==
+			(std::vector<uint32_t>{ MakeTexel(10u, 10u, 10u, 255u), MakeTexel(20u, 20u, 20u, 0u), MakeTexel(30u, 30u, 30u, 255u) }));
+
+		PngDesc rgb(2u, 1u, 2u, 8u);
+		rgb.transparency = { 0u,1u,0u,2u,0u,3u };
+
+		CHECK(Decode(MakePng(rgb, { { 1u,2u,3u,1u,2u,4u } }, 1)).texels ==
+			(std::vector<uint32_t>{ MakeTexel(1u, 2u, 3u, 0u), MakeTexel(1u, 2u, 4u, 255u) }));
+	}
+
+	//stored blocks longer than one deflate block can hold
+	void TestPngLargeStoredStream() {
+
+		PngDesc desc(300u, 100u, 6u, 8u);
+		std::vector<std::vector<uint8_t>> rows(desc.height, std::vector<uint8_t>(desc.width * 4u));
+		std::vector<uint32_t> expected;
+
+		for (unsigned int y = 0; y < desc.height; y++) {
+
+			for (unsigned int x = 0; x < desc.width; x++) {
+
+				const uint8_t r = (uint8_t)x, g = (uint8_t)y, b = (uint8_t)(x ^ y), a = (uint8_t)(x + y);
+				std::memcpy(&rows[y][x * 4u], std::array<uint8_t, 4>{ r,g,b,a }.data(), 4u);
+				expected.push_back(MakeTexel(r, g, b, a));
+			}
+		}
+
+		CHECK(Decode(MakePng(desc, rows, 4)).texels == expected);
+	}
+
+	void TestPngUnsupported() {
+
+		PngDesc interlaced(1u, 1u, 0u, 8u, true);
+		bool hasThrown = false;
+
+		try {
+
+			Decode(MakePng(interlaced, { { 0u } }, 0));
+		}
+		catch (const ImageDecoder::Exception&) {
+
+			hasThrown = true;
+		}
+
+		CHECK(hasThrown);
+	}
+
+	//what ImageEncoder writes (dynamic huffman blocks) comes back exactly
+	void TestEncoderRoundTrip() {
+
+		std::mt19937 rng(9u);
+
+		for (const bool hasAlpha : { false,true }) {
+
+			for (const unsigned int size : { 1u,7u,64u,333u }) {
+
+				std::vector<uint32_t> texels((size_t)size * (size / 2u + 1u));
+
+				//half noise and half smooth, so both literals and matches are exercised
+				for (size_t i = 0; i < texels.size(); i++) {
+
+					texels[i] = i % 3u == 0u ? (uint32_t)rng() : (uint32_t)(i * 0x010203u);
+				}
+
+				std::vector<uint8_t> bytes;
+				ImageEncoder::Encode(ImageEncoder::Format::Png, { texels.data(),size,size,size / 2u + 1u }, hasAlpha, bytes);
+
+				const auto image = Decode(bytes);
+
+				if (!hasAlpha) {
+
+					for (auto& t : texels) {
+
+						t |= 0xFF000000u;
+					}
+				}
+
+				CHECK(image.width == size);
+				CHECK(image.texels == texels);
+			}
+		}
+	}
+
+	void TestSignatures() {
+
+		const auto png = ReadFile("asset/texture/kappa50.png");
+		const auto jpeg = ReadFile("asset/texture/stonk.jpg");
+
+		CHECK(ImageDecoder::IsPng(png.data(), png.size()));
+		CHECK(!ImageDecoder::IsJpeg(png.data(), png.size()));
+		CHECK(ImageDecoder::IsJpeg(jpeg.data(), jpeg.size()));
+		CHECK(!ImageDecoder::IsPng(jpeg.data(), jpeg.size()));
+		CHECK(!ImageDecoder::IsPng(png.data(), 4u));
+	}
+
+	//every PNG and JPEG shipped under asset/ decodes at the size its header gives
+	void TestAssets() {
+
+		size_t nFiles = 0u;
+
+		for (const auto& entry : std::filesystem::recursive_directory_iterator("asset")) {
+
+			const auto extension = entry.path().extension().string();
+
+			if (extension != ".png" && extension != ".jpg") {
+
+				continue;
+			}
+
+			const auto bytes = ReadFile(entry.path().string());
+			const auto image = Decode(bytes);
+
+			if (extension == ".png") {
+
+				CHECK(image.width == ((uint32_t)bytes[16] << 24u | (uint32_t)bytes[17] << 16u | (uint32_t)bytes[18] << 8u | bytes[19]));
+				CHECK(image.height == ((uint32_t)bytes[20] << 24u | (uint32_t)bytes[21] << 16u | (uint32_t)bytes[22] << 8u | bytes[23]));
+			}
+			else {
+
+				//no alpha in a JPEG
+				CHECK(image.width > 0u && image.height > 0u);
+				CHECK(std::all_of(image.texels.begin(), image.texels.end(), [](uint32_t t) { return t >> 24u == 0xFFu; }));
+			}
+
+			nFiles++;
+		}
+
+		CHECK(nFiles >= 20u);
+	}
+
+	//decoding on the job system gives the same texels as one at a time
+	void TestConcurrentDecode() {
+
+		const std::vector<std::string> paths = {
+			"asset/texture/kappa50.png","asset/texture/cube.png","asset/texture/stonk.jpg",
+			"asset/texture/notstonks.png","asset/model/field004.jpg","asset/model/nano_textured/glass_dif.png",
+		};
+
+		std::vector<Image> serial;
+
+		for (const auto& path : paths) {
+
+			serial.push_back(Decode(ReadFile(path)));
+		}
+
+		JobSystem jobs(4u);
+		std::vector<Image> parallel(paths.size());
+
+		jobs.ParallelFor(paths.size(), 1u, [&](size_t first, size_t last) {
+
+			for (size_t i = first; i < last; i++) {
+
+				parallel[i] = Decode(ReadFile(paths[i]));
+			}
+		});
+
+		for (size_t i = 0; i < paths.size(); i++) {
+
+			CHECK(parallel[i].texels == serial[i].texels);
+		}
+	}
+
+	//cut short or damaged files only ever end in ImageDecoder::Exception
+	void TestCorruptInput() {
+
+		std::mt19937 rng(1u);
+
+		for (const char* path : { "asset/texture/kappa50.png","asset/texture/stonk.jpg" }) {
+
+			const auto original = ReadFile(path);
+
+			for (int i = 0; i < 150; i++) {
+
+				auto bytes = original;
+
+				if (i % 3 == 0) {
+
+					bytes.resize(rng() % bytes.size());
+				}
+				else {
+
+					for (unsigned int n = 1u + rng() % 8u; n > 0u; n--) {
+
+						bytes[rng() % bytes.size()] = (uint8_t)rng();
+					}
+				}
+
+				try {
+
+					Decode(bytes);
+				}
+				catch (const ImageDecoder::Exception&) {
+				}
+			}
+		}
+	}
+}
+
+int main()
+{
+	Test::Run("png color types, depths and filters", TestPngFormats);
+	Test::Run("png color key", TestPngColorKey);
+	Test::Run("png stored stream over 64K", TestPngLargeStoredStream);
+	Test::Run("png unsupported", TestPngUnsupported);
+	Test::Run("encoder round trip", TestEncoderRoundTrip);
+	Test::Run("signatures", TestSignatures);
+	Test::Run("assets", TestAssets);
+	Test::Run("concurrent decode", TestConcurrentDecode);
+	Test::Run("corrupt input", TestCorruptInput);
+
+	return Test::Finish();
+}
@@ -0,0 +1,118 @@
+#include "ImageEncoder.h"
+#include "ImageDecoder.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <iterator>
+#include <string>
+#include <vector>
+
+//PNG and QOI encode time of every nanosuit texture, one at a time and then all of them at once on the job system,
+//the way a screenshot or a frame sequence is written while the engine runs
+//textures are decoded up front so only encoding is timed
+//usage: ImageEncoderBenchmark [repeats]
+int main(int argc, char* argv[])
+{
+	const int nRepeats = argc > 1 ? std::max(1, std::atoi(argv[1])) : 5;
+
+	struct File {
+
+		std::string path;
+		std::vector<uint32_t> texels;
+		unsigned int width = 0u;
+		unsigned int height = 0u;
+		std::vector<uint8_t> bytes;
+	};
+
+	std::vector<File> files;
+
+	for (const auto& entry : std::filesystem::directory_iterator("asset/model/nano_textured")) {
+
+		if (entry.path().extension().string() == ".png") {
+
+			std::ifstream stream(entry.path(), std::ios::binary);
+			const std::vector<uint8_t> bytes{ std::istreambuf_iterator<char>(stream),std::istreambuf_iterator<char>() };
+
+			File file;
+			file.path = entry.path().generic_string();
+
+			ImageDecoder::Decode(bytes.data(), bytes.size(), [&file](unsigned int width, unsigned int height) {
+
+				file.width = width;
+				file.height = height;
+				file.texels.resize((size_t)width * height);
+
+				return file.texels.data();
+			});
+
+			files.push_back(std::move(file));
+		}
+	}
+
+	std::sort(files.begin(), files.end(), [](const File& a, const File& b) { return a.path < b.path; });
+
+	size_t nTexels = 0u;
+
+	for (const auto& file : files) {
+
+		nTexels += file.texels.size();
+	}
+
+	std::cout << std::fixed << std::setprecision(2) << files.size() << " textures, " << nTexels / 1'000'000.0 << " Mtexels, " << nRepeats << " repeats" << std::endl;
+
+	JobSystem jobs;
+
+	for (const auto format : { ImageEncoder::Format::Png,ImageEncoder::Format::Qoi }) {
+
+		const auto encode = [format](File& file) {
+
+			ImageEncoder::Encode(format, { file.texels.data(),file.width,file.width,file.height }, false, file.bytes);
+		};
+
+		const auto start = std::chrono::steady_clock::now();
+
+		for (int i = 0; i < nRepeats; i++) {
+
+			for (auto& file : files) {
+
+				encode(file);
+			}
+		}
+
+		const double serialMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / nRepeats;
+
+		size_t nBytes = 0u;
+
+		for (const auto& file : files) {
+
+			nBytes += file.bytes.size();
+		}
+
+		//one texture per job
+		const auto parallelStart = std::chrono::steady_clock::now();
+
+		for (int i = 0; i < nRepeats; i++) {
+
+			jobs.ParallelFor(files.size(), 1u, [&](size_t first, size_t last) {
+
+				for (size_t f = first; f < last; f++) {
+
+					encode(files[f]);
+				}
+			});
+		}
+
+		const double parallelMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - parallelStart).count() / nRepeats;
+
+		std::cout << ImageEncoder::GetExtension(format) << ": " << nBytes * 100.0 / (nTexels * 3u) << "% of raw RGB, "
+			<< serialMs << " ms one at a time (" << nTexels / serialMs / 1000.0 << " Mtexel/s), "
+			<< parallelMs << " ms on " << jobs.GetThreadCount() << " threads (" << nTexels / parallelMs / 1000.0 << " Mtexel/s)" << std::endl;
+	}
+
+	return 0;
+}
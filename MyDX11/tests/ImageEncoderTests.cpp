@@ -0,0 +1,362 @@
+#include "TestCheck.h"
+#include "ImageEncoder.h"
+#include "ImageDecoder.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+	struct Image {
+
+		unsigned int width = 0u;
+		unsigned int height = 0u;
+		std::vector<uint32_t> texels;
+
+		PixelKernels::ConstImage GetImage() const noexcept
+		{
+			return { texels.data(),width,width,height };
+		}
+	};
+
+	std::string GetTempPath(const char* name) {
+
+		return (std::filesystem::temp_directory_path() / name).string();
+	}
+
+	std::vector<uint8_t> ReadFile(const std::string& path) {
+
+		std::ifstream file(path, std::ios::binary);
+
+		return { std::istreambuf_iterator<char>(file),std::istreambuf_iterator<char>() };
+	}
+
+	Image Decode(const std::vector<uint8_t>& bytes) {
+
+		Image image;
+
+		ImageDecoder::Decode(bytes.data(), bytes.size(), [&image](unsigned int width, unsigned int height) {
+
+			image.width = width;
+			image.height = height;
+			image.texels.resize((size_t)width * height);
+
+			return image.texels.data();
+		});
+
+		return image;
+	}
+
+	//the tightly packed texels of an image with any pitch, opaque when the alpha isn't stored
+	std::vector<uint32_t> Expected(const PixelKernels::ConstImage& image, bool hasAlpha) {
+
+		std::vector<uint32_t> texels;
+
+		for (unsigned int y = 0; y < image.height; y++) {
+
+			for (unsigned int x = 0; x < image.width; x++) {
+
+				texels.push_back(image.pTexels[y * image.pitch + x] | (hasAlpha ? 0u : 0xFF000000u));
+			}
+		}
+
+		return texels;
+	}
+
+
+	/// reads QOI straight from the format description, which the in tree decoder doesn't cover
+
+	uint32_t GetBigEndian(const uint8_t* p) noexcept {
+
+		return (uint32_t)p[0] << 24u | (uint32_t)p[1] << 16u | (uint32_t)p[2] << 8u | p[3];
+	}
+
+	bool DecodeQoi(const std::vector<uint8_t>& bytes, Image& image, unsigned int& nChannels) {
+
+		constexpr uint8_t endMarker[8] = { 0,0,0,0,0,0,0,1 };
+
+		if (bytes.size() < 14u + sizeof(endMarker) || std::memcmp(bytes.data(), "qoif", 4u) != 0 || bytes[13] != 0u ||
+			std::memcmp(bytes.data() + bytes.size() - sizeof(endMarker), endMarker, sizeof(endMarker)) != 0) {
+
+			return false;
+		}
+
+		image.width = GetBigEndian(bytes.data() + 4u);
+		image.height = GetBigEndian(bytes.data() + 8u);
+		image.texels.resize((size_t)image.width * image.height);
+		nChannels = bytes[12];
+
+		uint8_t index[64][4] = {};
+		uint8_t px[4] = { 0u,0u,0u,255u };
+		size_t p = 14u;
+		const size_t end = bytes.size() - sizeof(endMarker);
+		unsigned int run = 0u;
+
+		for (auto& texel : image.texels) {
+
+			if (run > 0u) {
+
+				run--;
+			}
+			else {
+
+				if (p >= end) {
+
+					return false;
+				}
+
+				const uint8_t op = bytes[p++];
+
+				if (op == 0xFEu || op == 0xFFu) {
+
+					const size_t n = op == 0xFFu ? 4u : 3u;
+
+					if (p + n > end) {
+
+						return false;
+					}
+
+					std::memcpy(px, bytes.data() + p, n);
+					p += n;
+				}
+				else if ((op & 0xC0u) == 0x00u) {
+
+					std::memcpy(px, index[op], 4u);
+				}
+				else if ((op & 0xC0u) == 0x40u) {
+
+					px[0] += ((op >> 4u) & 3u) - 2u;
+					px[1] += ((op >> 2u) & 3u) - 2u;
+					px[2] += (op & 3u) - 2u;
+				}
+				else if ((op & 0xC0u) == 0x80u) {
+
+					if (p >= end) {
+
+						return false;
+					}
+
+					const uint8_t next = bytes[p++];
+					const int dg = (op & 0x3Fu) - 32;
+
+					px[0] += (uint8_t)(dg - 8 + (next >> 4u));
+					px[1] += (uint8_t)dg;
+					px[2] += (uint8_t)(dg - 8 + (next & 0x0Fu));
+				}
+				else {
+
+					run = op & 0x3Fu;
+				}
+
+				std::memcpy(index[(px[0] * 3u + px[1] * 5u + px[2] * 7u + px[3] * 11u) & 63u], px, 4u);
+			}
+
+			texel = (uint32_t)px[3] << 24u | (uint32_t)px[0] << 16u | (uint32_t)px[1] << 8u | px[2];
+		}
+
+		//nothing left over between the last pixel and the end marker
+		return p == end;
+	}
+
+
+	//noise, smooth gradients, flat areas longer than a QOI run and a PNG block, and alpha that changes now and then
+	std::vector<Image> MakeImages() {
+
+		std::mt19937 rng(11u);
+		std::vector<Image> images;
+
+		for (const auto& size : { std::make_pair(1u,1u),std::make_pair(7u,3u),std::make_pair(64u,64u),std::make_pair(333u,171u),std::make_pair(300u,300u) }) {
+
+			Image image;
+			image.width = size.first;
+			image.height = size.second;
+			image.texels.resize((size_t)size.first * size.second);
+
+			for (size_t i = 0; i < image.texels.size(); i++) {
+
+				const size_t x = i % size.first;
+				const size_t y = i / size.first;
+
+				if (y < size.second / 4u) {
+
+					image.texels[i] = rng();
+				}
+				else if (y < size.second / 2u) {
+
+					image.texels[i] = 0xFF000000u | (uint32_t)(x * 0x010203u + y * 0x000102u);
+				}
+				else if (y < size.second * 3u / 4u) {
+
+					image.texels[i] = (rng() % 500u == 0u ? 0x80000000u : 0xFF000000u) | (uint32_t)((x / 40u) * 0x050301u);
+				}
+				else {
+
+					image.texels[i] = 0x40FF8000u;
+				}
+			}
+
+			images.push_back(std::move(image));
+		}
+
+		//the shipped ones, a real photo among them
+		for (const char* path : { "asset/texture/kappa50.png","asset/texture/stonk.jpg","asset/model/nano_textured/glass_dif.png" }) {
+
+			images.push_back(Decode(ReadFile(path)));
+		}
+
+		return images;
+	}
+
+	void TestExtensions() {
+
+		CHECK(ImageEncoder::CanEncode("shot.png"));
+		CHECK(ImageEncoder::CanEncode("frames/0001.QOI"));
+		CHECK(!ImageEncoder::CanEncode("shot.jpg"));
+		CHECK(!ImageEncoder::CanEncode("png"));
+
+		CHECK(ImageEncoder::GetFormat("a.b/shot.PnG") == ImageEncoder::Format::Png);
+		CHECK(ImageEncoder::GetFormat("shot.qoi") == ImageEncoder::Format::Qoi);
+
+		CHECK(std::string(ImageEncoder::GetExtension(ImageEncoder::Format::Png)) == ".png");
+		CHECK(std::string(ImageEncoder::GetExtension(ImageEncoder::Format::Qoi)) == ".qoi");
+	}
+
+	//PNG back through ImageDecoder gives every texel, with and without alpha, from whole images and from crops with a wider pitch
+	void TestPngRoundTrip() {
+
+		std::vector<uint8_t> bytes;
+
+		for (const auto& image : MakeImages()) {
+
+			for (const bool hasAlpha : { false,true }) {
+
+				const auto whole = image.GetImage();
+				const auto crop = whole.Crop(whole.width / 3u, whole.height / 5u, whole.width - whole.width / 2u, whole.height - whole.height / 3u);
+
+				for (const auto& source : { whole,crop }) {
+
+					//one buffer for all of them, as a frame sequence would
+					ImageEncoder::Encode(ImageEncoder::Format::Png, source, hasAlpha, bytes);
+					CHECK(ImageDecoder::IsPng(bytes.data(), bytes.size()));
+
+					const auto decoded = Decode(bytes);
+
+					CHECK(decoded.width == source.width && decoded.height == source.height);
+					CHECK(decoded.texels == Expected(source, hasAlpha));
+				}
+			}
+		}
+	}
+
+	void TestQoiRoundTrip() {
+
+		std::vector<uint8_t> bytes;
+
+		for (const auto& image : MakeImages()) {
+
+			for (const bool hasAlpha : { false,true }) {
+
+				const auto whole = image.GetImage();
+				const auto crop = whole.Crop(whole.width / 3u, whole.height / 5u, whole.width - whole.width / 2u, whole.height - whole.height / 3u);
+
+				for (const auto& source : { whole,crop }) {
+
+					ImageEncoder::Encode(ImageEncoder::Format::Qoi, source, hasAlpha, bytes);
+
+					Image decoded;
+					unsigned int nChannels = 0u;
+
+					CHECK(DecodeQoi(bytes, decoded, nChannels));
+					CHECK(nChannels == (hasAlpha ? 4u : 3u));
+					CHECK(decoded.width == source.width && decoded.height == source.height);
+					CHECK(decoded.texels == Expected(source, hasAlpha));
+				}
+			}
+		}
+	}
+
+	//both formats come out smaller than raw on what they're for
+	void TestSizes() {
+
+		const auto body = Decode(ReadFile("asset/model/nano_textured/body_dif.png"));
+		const size_t raw = body.texels.size() * 4u;
+
+		std::vector<uint8_t> png;
+		std::vector<uint8_t> qoi;
+
+		ImageEncoder::Encode(ImageEncoder::Format::Png, body.GetImage(), false, png);
+		ImageEncoder::Encode(ImageEncoder::Format::Qoi, body.GetImage(), false, qoi);
+
+		CHECK(png.size() < raw / 2u);
+		CHECK(qoi.size() < raw / 2u);
+
+		const Image flat = { 256u,256u,std::vector<uint32_t>(256u * 256u,0xFF102030u) };
+
+		ImageEncoder::Encode(ImageEncoder::Format::Png, flat.GetImage(), true, png);
+		ImageEncoder::Encode(ImageEncoder::Format::Qoi, flat.GetImage(), true, qoi);
+
+		CHECK(png.size() < 2048u);
+		CHECK(qoi.size() < 2048u);
+	}
+
+	template<typename F>
+	bool ThrowsEncoderException(F&& func) {
+
+		try {
+
+			func();
+		}
+		catch (const ImageEncoder::Exception&) {
+
+			return true;
+		}
+
+		return false;
+	}
+
+	void TestFiles() {
+
+		const auto image = Decode(ReadFile("asset/texture/kappa50.png"));
+
+		for (const char* name : { "MyDX11ImageEncoderTests.png","MyDX11ImageEncoderTests.QOI" }) {
+
+			const std::string path = GetTempPath(name);
+			std::remove(path.c_str());
+
+			ImageEncoder::EncodeFile(path, image.GetImage(), true);
+
+			std::vector<uint8_t> bytes;
+			ImageEncoder::Encode(ImageEncoder::GetFormat(path), image.GetImage(), true, bytes);
+
+			CHECK(ReadFile(path) == bytes);
+
+			std::remove(path.c_str());
+		}
+
+		//unknown extensions and missing folders end in ImageEncoder::Exception, nothing is written for the first
+		const std::string unknown = GetTempPath("MyDX11ImageEncoderTests.jpg");
+		std::remove(unknown.c_str());
+
+		CHECK(ThrowsEncoderException([&]() { ImageEncoder::GetFormat(unknown); }));
+		CHECK(ThrowsEncoderException([&]() { ImageEncoder::EncodeFile(unknown, image.GetImage(), true); }));
+		CHECK(!std::filesystem::exists(unknown));
+		CHECK(ThrowsEncoderException([&]() { ImageEncoder::EncodeFile(GetTempPath("MyDX11ImageEncoderTests/missing/shot.png"), image.GetImage(), true); }));
+	}
+}
+
+int main()
+{
+	Test::Run("extensions", TestExtensions);
+	Test::Run("png round trip", TestPngRoundTrip);
+	Test::Run("qoi round trip", TestQoiRoundTrip);
+	Test::Run("sizes", TestSizes);
+	Test::Run("files", TestFiles);
+
+	return Test::Finish();
+}
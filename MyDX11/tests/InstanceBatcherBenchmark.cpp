@@ -0,0 +1,75 @@
+#include "InstanceBatcher.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+
+//frames of 10K and 100K instances over a few hundred meshes, added in scene order (runs of one mesh)
+//and shuffled (a new mesh almost every add), timed from Begin through Pack
+//usage: InstanceBatcherBenchmark [frames]
+int main(int argc, char* argv[])
+{
+	using Clock = std::chrono::steady_clock;
+
+	const int nFrames = argc > 1 ? std::max(1, std::atoi(argv[1])) : 100;
+
+	constexpr size_t nMeshes = 300u;
+	static int meshes[nMeshes];
+
+	InstanceBatcher batcher;
+	std::mt19937 rng(5u);
+
+	std::cout << std::fixed << std::setprecision(2) << sizeof(InstanceData) << " bytes per instance, " << nFrames << " frames" << std::endl;
+
+	for (const size_t nInstances : { 10'000u,100'000u }) {
+
+		for (const bool isShuffled : { false,true }) {
+
+			//the mesh of every add, fixed across frames like a static scene
+			std::vector<unsigned int> order(nInstances);
+
+			for (size_t i = 0; i < nInstances; i++) {
+
+				order[i] = (unsigned int)(i * nMeshes / nInstances);
+			}
+
+			if (isShuffled) {
+
+				std::shuffle(order.begin(), order.end(), rng);
+			}
+
+			double ms = 0.0;
+
+			//the first frame sizes the arrays, like the app's first frame
+			for (int frame = -1; frame < nFrames; frame++) {
+
+				const auto start = Clock::now();
+
+				batcher.Begin();
+
+				for (size_t i = 0; i < nInstances; i++) {
+
+					InstanceData& instance = batcher.Add(&meshes[order[i]]);
+					instance.transform._41 = (float)i;
+					instance.materialColor = { 1.0f,0.5f,0.25f };
+				}
+
+				batcher.Pack();
+
+				if (frame >= 0) {
+
+					ms += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+				}
+			}
+
+			std::cout << std::setw(6) << nInstances << " instances " << (isShuffled ? "shuffled " : "in order ")
+				<< ms / nFrames << " ms per frame, " << batcher.GetGroups().size() << " groups, "
+				<< nInstances * nFrames / ms / 1000.0 << " M instances/s" << std::endl;
+		}
+	}
+
+	return 0;
+}
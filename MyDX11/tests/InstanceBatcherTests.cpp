@@ -0,0 +1,144 @@
+#include "TestCheck.h"
+#include "InstanceBatcher.h"
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+namespace {
+
+	//stand ins for the meshes, only their addresses are keys
+	int meshes[64];
+
+	//tags an instance with the order it was added in and its mesh, so the packed copy can be traced back
+	void Tag(InstanceData& instance, unsigned int sequence, unsigned int mesh) {
+
+		instance.transform._41 = (float)sequence;
+		instance.transform._42 = (float)mesh;
+		instance.specularPower = (float)sequence;
+	}
+
+	void TestGrouping() {
+
+		InstanceBatcher batcher;
+		batcher.Begin();
+
+		//a, b, a, c, b, a in first seen order is a, b, c
+		const unsigned int order[] = { 0u,1u,0u,2u,1u,0u };
+
+		for (unsigned int i = 0; i < 6u; i++) {
+
+			Tag(batcher.Add(&meshes[order[i]]), i, order[i]);
+		}
+
+		batcher.Pack();
+
+		const auto& groups = batcher.GetGroups();
+		CHECK(groups.size() == 3u);
+		CHECK(batcher.GetInstanceCount() == 6u);
+
+		if (groups.size() == 3u) {
+
+			CHECK(groups[0].key == &meshes[0] && groups[0].start == 0u && groups[0].count == 3u);
+			CHECK(groups[1].key == &meshes[1] && groups[1].start == 3u && groups[1].count == 2u);
+			CHECK(groups[2].key == &meshes[2] && groups[2].start == 5u && groups[2].count == 1u);
+		}
+
+		//each group keeps the order its instances were added in
+		const float expected[] = { 0.0f,2.0f,5.0f,1.0f,4.0f,3.0f };
+		const auto& packed = batcher.GetPacked();
+
+		for (size_t i = 0; i < 6u; i++) {
+
+			CHECK(packed[i].transform._41 == expected[i]);
+		}
+
+		//a new frame starts empty, the same key opens a fresh group
+		batcher.Begin();
+		Tag(batcher.Add(&meshes[2]), 0u, 2u);
+		batcher.Pack();
+
+		CHECK(batcher.GetGroups().size() == 1u);
+		CHECK(batcher.GetGroups()[0].key == &meshes[2] && batcher.GetGroups()[0].count == 1u);
+		CHECK(batcher.GetPacked().size() == 1u);
+
+		//and an empty frame packs to nothing
+		batcher.Begin();
+		batcher.Pack();
+		CHECK(batcher.GetGroups().empty() && batcher.GetPacked().empty());
+	}
+
+	//random frames against a map of lists, every instance ends up once in its mesh's range, in order
+	void TestRandomFrames() {
+
+		InstanceBatcher batcher;
+		std::mt19937 rng(3u);
+
+		for (int frame = 0; frame < 50; frame++) {
+
+			const unsigned int nMeshes = 1u + rng() % 64u;
+			const unsigned int nInstances = rng() % 5000u;
+
+			std::vector<unsigned int> firstSeen;
+			std::map<unsigned int, std::vector<unsigned int>> reference;
+
+			unsigned int mesh = 0u;
+
+			batcher.Begin();
+
+			for (unsigned int i = 0; i < nInstances; i++) {
+
+				//runs of the same mesh like a scene walk gives, broken up now and then
+				if (rng() % 4u == 0u) {
+
+					mesh = rng() % nMeshes;
+				}
+
+				if (reference.find(mesh) == reference.end()) {
+
+					firstSeen.push_back(mesh);
+				}
+
+				reference[mesh].push_back(i);
+				Tag(batcher.Add(&meshes[mesh]), i, mesh);
+			}
+
+			batcher.Pack();
+
+			const auto& groups = batcher.GetGroups();
+			const auto& packed = batcher.GetPacked();
+
+			CHECK(groups.size() == firstSeen.size());
+			CHECK(packed.size() == nInstances);
+
+			unsigned int start = 0u;
+			bool isPacked = true;
+
+			for (size_t g = 0; g < groups.size() && g < firstSeen.size(); g++) {
+
+				const auto& list = reference[firstSeen[g]];
+
+				isPacked &= groups[g].key == &meshes[firstSeen[g]] && groups[g].start == start && groups[g].count == list.size();
+
+				for (size_t k = 0; k < list.size() && start + k < packed.size(); k++) {
+
+					const auto& instance = packed[start + k];
+					isPacked &= instance.transform._41 == (float)list[k] && instance.transform._42 == (float)firstSeen[g] && instance.specularPower == (float)list[k];
+				}
+
+				start += groups[g].count;
+			}
+
+			CHECK(isPacked);
+			CHECK(start == nInstances);
+		}
+	}
+}
+
+int main()
+{
+	Test::Run("grouping", TestGrouping);
+	Test::Run("random frames", TestRandomFrames);
+
+	return Test::Finish();
+}
@@ -0,0 +1,145 @@
+#include "JobSystem.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+
+namespace {
+
+	using Clock = std::chrono::steady_clock;
+
+	template<typename F>
+	double TimeMs(int nRounds, F&& func)
+	{
+		const auto start = Clock::now();
+
+		for (int round = 0; round < nRounds; round++) {
+
+			func();
+		}
+
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count() / nRounds;
+	}
+
+	//a few hundred ns of arithmetic per element, roughly what a simulation group costs
+	float Work(const std::vector<float>& data, size_t first, size_t last) noexcept
+	{
+		float sum = 0.0f;
+
+		for (size_t i = first; i < last; i++) {
+
+			float x = data[i];
+
+			for (int k = 0; k < 16; k++) {
+
+				x = std::sqrt(x * x + 1.0f) - 0.5f;
+			}
+
+			sum += x;
+		}
+
+		return sum;
+	}
+}
+
+//the same three loads at every pool size from 1 worker to one per hardware thread:
+//empty jobs through Run and Wait (pure queue overhead), a ParallelFor over 1M elements of arithmetic at a few grain sizes,
+//and a fork join tree of jobs that wait on their children from the workers
+//usage: JobSystemBenchmark [rounds]
+int main(int argc, char* argv[])
+{
+	const int nRounds = argc > 1 ? std::max(1, std::atoi(argv[1])) : 20;
+	const unsigned int nHardware = std::max(1u, std::thread::hardware_concurrency());
+
+	constexpr size_t nElements = 1u << 20;
+	constexpr int nEmptyJobs = 10000;
+
+	std::vector<float> data(nElements);
+
+	for (size_t i = 0; i < nElements; i++) {
+
+		data[i] = (float)(i % 1000u) * 0.01f;
+	}
+
+	//baseline without any pool
+	std::atomic<float> sink = 0.0f;
+	const double serialMs = TimeMs(nRounds, [&]() { sink = Work(data, 0u, nElements); });
+
+	std::cout << std::fixed << std::setprecision(2)
+		<< nHardware << " hardware threads, " << nRounds << " rounds, 1M elements on the calling thread alone " << serialMs << " ms" << std::endl;
+
+	for (unsigned int nWorkers = 1u; nWorkers <= nHardware; nWorkers++) {
+
+		JobSystem jobs(nWorkers);
+
+		//first round wakes and warms every worker
+		jobs.ParallelFor(nElements, 4096u, [&](size_t first, size_t last) { Work(data, first, last); });
+
+		const double emptyMs = TimeMs(nRounds, [&]() {
+
+			JobSystem::Counter counter;
+
+			for (int i = 0; i < nEmptyJobs; i++) {
+
+				jobs.Run([]() {}, counter);
+			}
+
+			jobs.Wait(counter);
+		});
+
+		std::cout << std::setw(3) << nWorkers << " workers, " << jobs.GetThreadCount() << " threads: empty jobs "
+			<< emptyMs * 1'000'000.0 / nEmptyJobs << " ns each";
+
+		for (const size_t grain : { 1024u,16384u,131072u }) {
+
+			const double forMs = TimeMs(nRounds, [&]() {
+
+				std::atomic<float> sum = 0.0f;
+
+				jobs.ParallelFor(nElements, grain, [&](size_t first, size_t last) {
+
+					const float partial = Work(data, first, last);
+					float expected = sum.load();
+
+					while (!sum.compare_exchange_weak(expected, expected + partial)) {}
+				});
+
+				sink = sum.load();
+			});
+
+			std::cout << ", grain " << grain << " " << forMs << " ms (" << serialMs / forMs << "x)";
+		}
+
+		//8 x 8 x 8 leaves of 2K elements each, the same 1M elements
+		std::function<void(int, size_t)> branch = [&](int depth, size_t first) {
+
+			if (depth == 0) {
+
+				sink = Work(data, first, first + 2048u);
+				return;
+			}
+
+			JobSystem::Counter children;
+			const size_t stride = (size_t)2048u << (3 * (depth - 1));
+
+			for (size_t i = 0; i < 8u; i++) {
+
+				jobs.Run([&branch, depth, first, stride, i]() { branch(depth - 1, first + i * stride); }, children);
+			}
+
+			jobs.Wait(children);
+		};
+
+		const double treeMs = TimeMs(nRounds, [&]() { branch(3, 0u); });
+
+		std::cout << ", fork join tree " << treeMs << " ms (" << serialMs / treeMs << "x)" << std::endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,286 @@
+#include "TestCheck.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+	void TestRun() {
+
+		for (const unsigned int nWorkers : { 1u,3u }) {
+
+			JobSystem jobs(nWorkers);
+			CHECK(jobs.GetThreadCount() == nWorkers + 1u);
+
+			JobSystem::Counter counter;
+			CHECK(counter.IsDone());
+
+			std::atomic<int> sum = 0;
+
+			for (int i = 1; i <= 1000; i++) {
+
+				jobs.Run([&sum, i]() { sum += i; }, counter);
+			}
+
+			jobs.Wait(counter);
+			CHECK(counter.IsDone());
+			CHECK(sum == 500500);
+
+			//a counter is reusable once it reaches zero, and waiting on a done one returns straight away
+			jobs.Run([&sum]() { sum = 0; }, counter);
+			jobs.Wait(counter);
+			jobs.Wait(counter);
+			CHECK(sum == 0);
+		}
+	}
+
+	//jobs spawning jobs and waiting on them from the worker threads, three levels of 8
+	void TestNested() {
+
+		JobSystem jobs(3u);
+		JobSystem::Counter counter;
+		std::atomic<int> nLeaves = 0;
+
+		std::function<void(int)> branch = [&](int depth) {
+
+			if (depth == 0) {
+
+				nLeaves++;
+				return;
+			}
+
+			JobSystem::Counter children;
+
+			for (int i = 0; i < 8; i++) {
+
+				jobs.Run([&branch, depth]() { branch(depth - 1); }, children);
+			}
+
+			//waiting runs queued jobs, so workers waiting on children don't starve the pool
+			jobs.Wait(children);
+		};
+
+		for (int i = 0; i < 8; i++) {
+
+			jobs.Run([&branch]() { branch(2); }, counter);
+		}
+
+		jobs.Wait(counter);
+		CHECK(nLeaves == 512);
+
+		//a ParallelFor inside a ParallelFor
+		std::atomic<int> nCells = 0;
+
+		jobs.ParallelFor(16u, 1u, [&](size_t first, size_t last) {
+
+			for (size_t row = first; row < last; row++) {
+
+				jobs.ParallelFor(100u, 7u, [&nCells](size_t first, size_t last) { nCells += (int)(last - first); });
+			}
+		});
+
+		CHECK(nCells == 1600);
+	}
+
+	void TestRunAfter() {
+
+		JobSystem jobs(2u);
+
+		std::mutex mtx;
+		std::vector<int> order;
+		const auto record = [&mtx, &order](int step) {
+
+			std::lock_guard<std::mutex> lock(mtx);
+			order.push_back(step);
+		};
+
+		JobSystem::Counter first;
+		JobSystem::Counter second;
+		JobSystem::Counter third;
+
+		//the first stage is slow so the later ones really are parked as continuations
+		for (int i = 0; i < 4; i++) {
+
+			jobs.Run([&record]() {
+
+				std::this_thread::sleep_for(std::chrono::milliseconds(5));
+				record(1);
+			}, first);
+		}
+
+		jobs.RunAfter(first, [&record]() { record(2); }, second);
+		jobs.RunAfter(second, [&record]() { record(3); }, third);
+
+		//waiting on the last one covers the chain before it has even been queued
+		CHECK(!third.IsDone());
+		jobs.Wait(third);
+
+		CHECK(first.IsDone() && second.IsDone());
+		CHECK((order == std::vector<int>{ 1,1,1,1,2,3 }));
+
+		//a dependency that's already done queues right away
+		JobSystem::Counter done;
+		JobSystem::Counter after;
+		bool isRun = false;
+
+		jobs.RunAfter(done, [&isRun]() { isRun = true; }, after);
+		jobs.Wait(after);
+		CHECK(isRun);
+	}
+
+	//every index exactly once, no range over the grain size, at any count and grain
+	void TestParallelFor() {
+
+		for (const unsigned int nWorkers : { 1u,3u }) {
+
+			JobSystem jobs(nWorkers);
+
+			for (const size_t count : { 0u,1u,7u,64u,1000u }) {
+
+				for (const size_t grain : { 0u,1u,3u,64u,5000u }) {
+
+					std::vector<std::atomic<int>> hits(count);
+					std::atomic<bool> isWithinGrain = true;
+
+					jobs.ParallelFor(count, grain, [&](size_t first, size_t last) {
+
+						isWithinGrain = isWithinGrain && first < last && last - first <= std::max<size_t>(grain, 1u);
+
+						for (size_t i = first; i < last; i++) {
+
+							hits[i]++;
+						}
+					});
+
+					bool isOnce = true;
+
+					for (const auto& hit : hits) {
+
+						isOnce &= hit == 1;
+					}
+
+					CHECK(isOnce);
+					CHECK(isWithinGrain);
+				}
+			}
+		}
+	}
+
+	//jobs queued from one worker end up on the others as well
+	void TestStealing() {
+
+		JobSystem jobs(3u);
+		JobSystem::Counter counter;
+
+		std::mutex mtx;
+		std::set<std::thread::id> threads;
+
+		jobs.Run([&]() {
+
+			JobSystem::Counter children;
+
+			for (int i = 0; i < 64; i++) {
+
+				jobs.Run([&]() {
+
+					//long enough for the sleeping workers to wake up and come looking
+					std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+					std::lock_guard<std::mutex> lock(mtx);
+					threads.insert(std::this_thread::get_id());
+				}, children);
+			}
+
+			jobs.Wait(children);
+		}, counter);
+
+		jobs.Wait(counter);
+		CHECK(threads.size() > 1u);
+	}
+
+	template<typename F>
+	bool ThrowsRuntimeError(F&& func)
+	{
+		try {
+
+			func();
+		}
+		catch (const std::runtime_error&) {
+
+			return true;
+		}
+
+		return false;
+	}
+
+	//a throwing job doesn't take the others down, Wait hands the exception on once everything has finished
+	void TestExceptions() {
+
+		JobSystem jobs(3u);
+		JobSystem::Counter counter;
+		std::atomic<int> nRun = 0;
+
+		for (int i = 0; i < 100; i++) {
+
+			jobs.Run([&nRun, i]() {
+
+				nRun++;
+
+				if (i % 10 == 3) {
+
+					throw std::runtime_error("job failed");
+				}
+			}, counter);
+		}
+
+		CHECK(ThrowsRuntimeError([&]() { jobs.Wait(counter); }));
+		CHECK(counter.IsDone());
+		CHECK(nRun == 100);
+
+		//the error was handed out, the counter is clean for the next batch
+		jobs.Run([&nRun]() { nRun++; }, counter);
+		CHECK(!ThrowsRuntimeError([&]() { jobs.Wait(counter); }));
+		CHECK(nRun == 101);
+
+		//ParallelFor waits for its ranges the same way
+		std::atomic<int> nRanges = 0;
+
+		CHECK(ThrowsRuntimeError([&]() {
+
+			jobs.ParallelFor(40u, 1u, [&nRanges](size_t first, size_t) {
+
+				nRanges++;
+
+				if (first == 17u) {
+
+					throw std::runtime_error("range failed");
+				}
+			});
+		}));
+		CHECK(nRanges == 40);
+
+		//the pool still works afterwards
+		std::atomic<int> nAfter = 0;
+		jobs.ParallelFor(40u, 1u, [&nAfter](size_t, size_t) { nAfter++; });
+		CHECK(nAfter == 40);
+	}
+}
+
+int main()
+{
+	Test::Run("run", TestRun);
+	Test::Run("nested", TestNested);
+	Test::Run("run after", TestRunAfter);
+	Test::Run("parallel for", TestParallelFor);
+	Test::Run("stealing", TestStealing);
+	Test::Run("exceptions", TestExceptions);
+
+	return Test::Finish();
+}
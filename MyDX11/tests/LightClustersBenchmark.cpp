@@ -0,0 +1,102 @@
+#include "LightClusters.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+
+//the app's 16x9x24 grid built from 1K to 16K random lights, each step timed at every kernel level,
+//then whole frames with the slices split across every core
+//usage: LightClustersBenchmark [frames]
+int main(int argc, char* argv[])
+{
+	using Clock = std::chrono::steady_clock;
+
+	const int nFrames = argc > 1 ? std::max(1, std::atoi(argv[1])) : 50;
+
+	//XMMatrixPerspectiveLH(1, 9/16, 0.5, 40) like the app's
+	const float range = 40.0f / 39.5f;
+	const DirectX::XMFLOAT4X4 projection = {
+		1.0f,0.0f,0.0f,0.0f,
+		0.0f,16.0f / 9.0f,0.0f,0.0f,
+		0.0f,0.0f,range,1.0f,
+		0.0f,0.0f,-range * 0.5f,0.0f,
+	};
+
+	LightClusters clusters;
+	clusters.SetProjection(projection);
+
+	JobSystem jobs;
+	std::mt19937 rng(5u);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+	std::cout << std::fixed << std::setprecision(2)
+		<< clusters.GetTilesX() << "x" << clusters.GetTilesY() << "x" << clusters.GetSliceCount() << " clusters, "
+		<< jobs.GetThreadCount() << " threads, " << nFrames << " frames" << std::endl;
+
+	for (const size_t nLights : { 1024u,4096u,16384u }) {
+
+		//spread through the frustum and a little past it, 1 to 4 units across
+		std::vector<LightClusters::Light> lights(nLights);
+
+		for (auto& light : lights) {
+
+			const float z = std::abs(unit(rng)) * 45.0f;
+			light.center = { unit(rng) * z,unit(rng) * z * 0.6f,z };
+			light.radius = 1.0f + std::abs(unit(rng)) * 3.0f;
+		}
+
+		for (const auto isa : { PixelKernels::Isa::Scalar,PixelKernels::Isa::Sse2,PixelKernels::Isa::Avx2 }) {
+
+			if (isa > PixelKernels::GetSupportedIsa()) {
+
+				continue;
+			}
+
+			clusters.SetIsa(isa);
+
+			double beginMs = 0.0;
+			double assignMs = 0.0;
+			double packMs = 0.0;
+
+			for (int frame = 0; frame < nFrames; frame++) {
+
+				const auto t0 = Clock::now();
+				clusters.Begin(lights);
+				const auto t1 = Clock::now();
+				clusters.Assign();
+				const auto t2 = Clock::now();
+				clusters.Pack();
+				const auto t3 = Clock::now();
+
+				beginMs += std::chrono::duration<double, std::milli>(t1 - t0).count();
+				assignMs += std::chrono::duration<double, std::milli>(t2 - t1).count();
+				packMs += std::chrono::duration<double, std::milli>(t3 - t2).count();
+			}
+
+			std::cout << std::setw(5) << nLights << " lights " << std::setw(6) << PixelKernels::GetIsaName(isa)
+				<< " begin " << beginMs / nFrames << " ms, assign " << assignMs / nFrames << " ms, pack " << packMs / nFrames << " ms, "
+				<< clusters.GetStats().indices << " indices, at most " << clusters.GetStats().maxClusterLights << " in a cluster" << std::endl;
+		}
+
+		clusters.SetIsa(PixelKernels::GetSupportedIsa());
+
+		const auto start = Clock::now();
+
+		for (int frame = 0; frame < nFrames; frame++) {
+
+			clusters.Begin(lights);
+			jobs.ParallelFor(clusters.GetSliceCount(), 1u, [&clusters](size_t first, size_t last) { clusters.Assign(first, last); });
+			clusters.Pack();
+		}
+
+		const double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		std::cout << std::setw(5) << nLights << " lights on the jobs " << ms / nFrames << " ms per frame" << std::endl;
+	}
+
+	return 0;
+}
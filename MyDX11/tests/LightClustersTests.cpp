@@ -0,0 +1,405 @@
+#include "TestCheck.h"
+#include "LightClusters.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+	using Light = LightClusters::Light;
+
+	//what XMMatrixPerspectiveLH gives, the app's is 1 x 9/16 at 0.5 to 40
+	DirectX::XMFLOAT4X4 MakePerspective(float width, float height, float nearZ, float farZ) {
+
+		const float range = farZ / (farZ - nearZ);
+
+		return {
+			2.0f * nearZ / width,0.0f,0.0f,0.0f,
+			0.0f,2.0f * nearZ / height,0.0f,0.0f,
+			0.0f,0.0f,range,1.0f,
+			0.0f,0.0f,-range * nearZ,0.0f,
+		};
+	}
+
+	struct Grid {
+
+		unsigned int tilesX;
+		unsigned int tilesY;
+		unsigned int slices;
+		float width;
+		float height;
+		float nearZ;
+		float farZ;
+	};
+
+	//the clusters worked out again from the grid alone, without anything LightClusters keeps
+	class BruteForce {
+
+	public:
+
+		BruteForce(const Grid& grid)
+			:
+			grid(grid)
+		{}
+
+		float GetSliceDepth(float slice) const {
+
+			return grid.nearZ * std::pow(grid.farZ / grid.nearZ, slice / (float)grid.slices);
+		}
+
+		//a view space point at fractions of the way across a cluster's column, row and slice
+		DirectX::XMFLOAT3 GetPoint(unsigned int column, unsigned int row, unsigned int slice, float fx, float fy, float fz) const {
+
+			const float z = GetSliceDepth((float)slice + fz);
+			const float ndcX = -1.0f + 2.0f * ((float)column + fx) / (float)grid.tilesX;
+			const float ndcY = -1.0f + 2.0f * ((float)row + fy) / (float)grid.tilesY;
+
+			return { ndcX * z * grid.width / (2.0f * grid.nearZ),ndcY * z * grid.height / (2.0f * grid.nearZ),z };
+		}
+
+		//does the box around the light overlap the box around the cluster, anything listed has to
+		bool IsNearCluster(const Light& light, unsigned int column, unsigned int row, unsigned int slice) const {
+
+			DirectX::XMFLOAT3 lo = { 1e30f,1e30f,1e30f };
+			DirectX::XMFLOAT3 hi = { -1e30f,-1e30f,-1e30f };
+
+			for (const float fz : { 0.0f,1.0f }) {
+
+				for (const float fy : { 0.0f,1.0f }) {
+
+					for (const float fx : { 0.0f,1.0f }) {
+
+						const auto p = GetPoint(column, row, slice, fx, fy, fz);
+						lo = { std::min(lo.x, p.x),std::min(lo.y, p.y),std::min(lo.z, p.z) };
+						hi = { std::max(hi.x, p.x),std::max(hi.y, p.y),std::max(hi.z, p.z) };
+					}
+				}
+			}
+
+			//slices are tested a hair wide, so the shaders' rounding never loses a light
+			const float margin = hi.z * 1.0e-3f;
+
+			return light.center.x + light.radius >= lo.x - margin && light.center.x - light.radius <= hi.x + margin &&
+				light.center.y + light.radius >= lo.y - margin && light.center.y - light.radius <= hi.y + margin &&
+				light.center.z + light.radius >= lo.z - margin && light.center.z - light.radius <= hi.z + margin;
+		}
+
+	private:
+
+		Grid grid;
+	};
+
+	bool IsInside(const Light& light, const DirectX::XMFLOAT3& p) {
+
+		const float dx = p.x - light.center.x;
+		const float dy = p.y - light.center.y;
+		const float dz = p.z - light.center.z;
+
+		//*a little inside, a point right on the sphere may round either way
+		return dx * dx + dy * dy + dz * dz < light.radius * light.radius * 0.998f;
+	}
+
+	bool IsListed(const LightClusters& clusters, size_t cluster, size_t light) {
+
+		const auto& range = clusters.GetRanges()[cluster];
+		const auto begin = clusters.GetIndices().begin() + range.offset;
+
+		return std::binary_search(begin, begin + range.count, (uint16_t)light);
+	}
+
+	//lights inside the frustum, straddling the near plane, behind the eye, past the far plane and off to the sides
+	std::vector<Light> MakeLights(const Grid& grid, size_t count, std::mt19937& rng) {
+
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+		std::vector<Light> lights(count);
+
+		for (auto& light : lights) {
+
+			const float z = -2.0f + (unit(rng) * 0.5f + 0.5f) * (grid.farZ + 6.0f);
+			const float spread = std::max(z, 1.0f) / grid.nearZ * 0.6f;
+
+			light.center = { unit(rng) * spread * grid.width,unit(rng) * spread * grid.height,z };
+			light.radius = 0.1f + std::abs(unit(rng)) * (std::abs(unit(rng)) < 0.1f ? 12.0f : 3.0f);
+		}
+
+		if (count >= 2u) {
+
+			lights[0] = { { 0.0f,0.0f,grid.nearZ },1.0f };
+			lights[1] = { { 0.0f,0.0f,-5.0f },2.0f };
+		}
+
+		return lights;
+	}
+
+	void Build(LightClusters& clusters, const std::vector<Light>& lights) {
+
+		clusters.Begin(lights);
+		clusters.Assign();
+		clusters.Pack();
+	}
+
+	//every cluster lists at least the lights reaching points inside it, and nothing nowhere near it
+	void TestAgainstBruteForce() {
+
+		const Grid grids[] = {
+			{ 16u,9u,24u,1.0f,9.0f / 16.0f,0.5f,40.0f },
+			{ 32u,32u,8u,1.0f,1.0f,0.1f,100.0f },
+			{ 7u,3u,5u,2.5f,0.8f,1.0f,20.0f },
+			{ 1u,1u,1u,1.0f,1.0f,0.5f,10.0f },
+		};
+
+		std::mt19937 rng(5u);
+		//cluster points at fractions away from the edges
+		const float fractions[] = { 0.1f,0.5f,0.9f };
+
+		for (const auto& grid : grids) {
+
+			LightClusters clusters(grid.tilesX, grid.tilesY, grid.slices);
+			clusters.SetProjection(MakePerspective(grid.width, grid.height, grid.nearZ, grid.farZ));
+
+			const BruteForce bruteForce(grid);
+
+			for (const size_t nLights : { 0u,1u,60u,300u }) {
+
+				const auto lights = MakeLights(grid, nLights, rng);
+				Build(clusters, lights);
+
+				CHECK(clusters.GetRanges().size() == clusters.GetClusterCount());
+
+				size_t nMissing = 0u;
+				size_t nTooFar = 0u;
+				size_t nNeeded = 0u;
+
+				for (unsigned int slice = 0; slice < grid.slices; slice++) {
+
+					for (unsigned int row = 0; row < grid.tilesY; row++) {
+
+						for (unsigned int column = 0; column < grid.tilesX; column++) {
+
+							const size_t cluster = ((size_t)slice * grid.tilesY + row) * grid.tilesX + column;
+							const auto& range = clusters.GetRanges()[cluster];
+
+							for (uint32_t k = 0; k < range.count; k++) {
+
+								nTooFar += !bruteForce.IsNearCluster(lights[clusters.GetIndices()[range.offset + k]], column, row, slice);
+							}
+
+							for (const float fz : fractions) {
+
+								for (const float fy : fractions) {
+
+									for (const float fx : fractions) {
+
+										const auto p = bruteForce.GetPoint(column, row, slice, fx, fy, fz);
+
+										//the shaders' lookup finds this cluster
+										CHECK(clusters.GetClusterIndex(p) == cluster);
+
+										for (size_t i = 0; i < lights.size(); i++) {
+
+											if (IsInside(lights[i], p)) {
+
+												nNeeded++;
+												nMissing += !IsListed(clusters, cluster, i);
+											}
+										}
+									}
+								}
+							}
+						}
+					}
+				}
+
+				CHECK(nMissing == 0u);
+				CHECK(nTooFar == 0u);
+				CHECK(nLights < 60u || nNeeded > 0u);
+			}
+		}
+	}
+
+	//points anywhere in a light and in view find it in the cluster they look up
+	void TestPointsInLights() {
+
+		const Grid grid = { 16u,9u,24u,1.0f,9.0f / 16.0f,0.5f,40.0f };
+		LightClusters clusters;
+		clusters.SetProjection(MakePerspective(grid.width, grid.height, grid.nearZ, grid.farZ));
+
+		std::mt19937 rng(7u);
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+		const auto lights = MakeLights(grid, 500u, rng);
+		Build(clusters, lights);
+
+		const auto scale = clusters.GetProjectionScale();
+		size_t nTested = 0u;
+		size_t nMissing = 0u;
+
+		for (size_t i = 0; i < lights.size(); i++) {
+
+			const Light& light = lights[i];
+
+			for (int k = 0; k < 200; k++) {
+
+				const DirectX::XMFLOAT3 p = {
+					light.center.x + unit(rng) * light.radius,
+					light.center.y + unit(rng) * light.radius,
+					light.center.z + unit(rng) * light.radius,
+				};
+
+				const bool isInView = p.z >= grid.nearZ && p.z <= grid.farZ && std::abs(p.x * scale.x / p.z) <= 1.0f && std::abs(p.y * scale.y / p.z) <= 1.0f;
+
+				if (!isInView || !IsInside(light, p)) {
+
+					continue;
+				}
+
+				nTested++;
+				nMissing += !IsListed(clusters, clusters.GetClusterIndex(p), i);
+			}
+		}
+
+		CHECK(nTested > 10000u);
+		CHECK(nMissing == 0u);
+	}
+
+	//lists ascend without repeats, ranges follow each other through the index list, and the stats add up
+	void TestLists() {
+
+		const Grid grid = { 16u,9u,24u,1.0f,9.0f / 16.0f,0.5f,40.0f };
+		LightClusters clusters;
+		clusters.SetProjection(MakePerspective(grid.width, grid.height, grid.nearZ, grid.farZ));
+
+		std::mt19937 rng(9u);
+		const auto lights = MakeLights(grid, 1000u, rng);
+		Build(clusters, lights);
+
+		const auto& ranges = clusters.GetRanges();
+		const auto& indices = clusters.GetIndices();
+		const auto& stats = clusters.GetStats();
+
+		uint32_t offset = 0u;
+		uint32_t maxCount = 0u;
+		std::vector<bool> isUsed(lights.size(), false);
+
+		for (const auto& range : ranges) {
+
+			CHECK(range.offset == offset);
+			CHECK(std::adjacent_find(indices.begin() + range.offset, indices.begin() + range.offset + range.count,
+				[](uint16_t a, uint16_t b) { return a >= b; }) == indices.begin() + range.offset + range.count);
+
+			for (uint32_t k = 0; k < range.count; k++) {
+
+				isUsed[indices[range.offset + k]] = true;
+			}
+
+			offset += range.count;
+			maxCount = std::max(maxCount, range.count);
+		}
+
+		CHECK(offset == indices.size());
+		CHECK(stats.lights == lights.size());
+		CHECK(stats.indices == indices.size());
+		CHECK(stats.maxClusterLights == maxCount);
+		CHECK(stats.visibleLights >= (size_t)std::count(isUsed.begin(), isUsed.end(), true));
+
+		//the light behind the eye is nowhere
+		CHECK(!isUsed[1]);
+
+		//nothing left over from a bigger frame
+		Build(clusters, {});
+		CHECK(clusters.GetIndices().empty());
+		CHECK(clusters.GetStats().maxClusterLights == 0u);
+	}
+
+	//every kernel level and any split of the slices give the same lists
+	void TestSameEverywhere() {
+
+		const Grid grid = { 16u,9u,24u,1.0f,9.0f / 16.0f,0.5f,40.0f };
+		LightClusters clusters;
+		clusters.SetProjection(MakePerspective(grid.width, grid.height, grid.nearZ, grid.farZ));
+
+		std::mt19937 rng(11u);
+		const auto lights = MakeLights(grid, 2000u, rng);
+
+		clusters.SetIsa(PixelKernels::Isa::Scalar);
+		Build(clusters, lights);
+
+		const auto ranges = clusters.GetRanges();
+		const auto indices = clusters.GetIndices();
+
+		const auto isSame = [&]() {
+
+			return clusters.GetIndices() == indices && std::equal(ranges.begin(), ranges.end(), clusters.GetRanges().begin(),
+				[](const LightClusters::Range& a, const LightClusters::Range& b) { return a.offset == b.offset && a.count == b.count; });
+		};
+
+		for (const auto isa : { PixelKernels::Isa::Sse2,PixelKernels::Isa::Avx2 }) {
+
+			clusters.SetIsa(isa);
+			Build(clusters, lights);
+			CHECK(isSame());
+		}
+
+		clusters.Begin(lights);
+		clusters.Assign(0u, 10u);
+		clusters.Assign(10u, 24u);
+		clusters.Pack();
+		CHECK(isSame());
+
+		JobSystem jobs(4u);
+		clusters.Begin(lights);
+		jobs.ParallelFor(clusters.GetSliceCount(), 1u, [&clusters](size_t first, size_t last) { clusters.Assign(first, last); });
+		clusters.Pack();
+		CHECK(isSame());
+	}
+
+	template<typename F>
+	bool ThrowsClustersException(F&& func) {
+
+		try {
+
+			func();
+		}
+		catch (const LightClusters::Exception&) {
+
+			return true;
+		}
+
+		return false;
+	}
+
+	void TestErrors() {
+
+		LightClusters clusters;
+
+		CHECK(ThrowsClustersException([&]() { clusters.Resize(33u, 4u, 4u); }));
+		CHECK(ThrowsClustersException([&]() { clusters.Resize(4u, 0u, 4u); }));
+		CHECK(ThrowsClustersException([&]() { clusters.Resize(4u, 4u, 0u); }));
+
+		//an orthographic projection has no perspective divide to slice by
+		const DirectX::XMFLOAT4X4 orthographic = {
+			1.0f,0.0f,0.0f,0.0f,
+			0.0f,1.0f,0.0f,0.0f,
+			0.0f,0.0f,0.1f,0.0f,
+			0.0f,0.0f,0.0f,1.0f,
+		};
+
+		CHECK(ThrowsClustersException([&]() { clusters.SetProjection(orthographic); }));
+		CHECK(ThrowsClustersException([&]() { clusters.Begin(std::vector<Light>(LightClusters::maxLights + 1u, Light{ { 0.0f,0.0f,5.0f },1.0f })); }));
+
+		//a failed resize leaves the grid as it was
+		CHECK(clusters.GetClusterCount() == 16u * 9u * 24u);
+	}
+}
+
+int main()
+{
+	Test::Run("against brute force", TestAgainstBruteForce);
+	Test::Run("points in lights", TestPointsInLights);
+	Test::Run("lists", TestLists);
+	Test::Run("same everywhere", TestSameEverywhere);
+	Test::Run("errors", TestErrors);
+
+	return Test::Finish();
+}
@@ -0,0 +1,69 @@
+#include "MipFilter.h"
+#include "JobSystem.h"
+#include "ImageDecoder.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+//full sRGB mip chains of one of the nanosuit's 1024x1024 textures, rows split across every core
+//usage: MipFilterBenchmark [chains]
+int main(int argc, char* argv[])
+{
+	const int nChains = argc > 1 ? std::max(1, std::atoi(argv[1])) : 20;
+
+	std::vector<uint32_t> top;
+	unsigned int width = 0u;
+	unsigned int height = 0u;
+
+	ImageDecoder::DecodeFile("asset/model/nano_textured/body_dif.png", [&](unsigned int w, unsigned int h) {
+
+		width = w;
+		height = h;
+		top.resize((size_t)w * h);
+
+		return top.data();
+	});
+
+	JobSystem jobs;
+	std::vector<uint32_t> level;
+	std::vector<uint32_t> next;
+	size_t nTexels = 0u;
+
+	const auto start = std::chrono::steady_clock::now();
+
+	for (int chain = 0; chain < nChains; chain++) {
+
+		level = top;
+		unsigned int levelWidth = width;
+		unsigned int levelHeight = height;
+
+		while (levelWidth > 1u || levelHeight > 1u) {
+
+			const MipFilter filter(levelWidth, levelHeight, true);
+			next.resize((size_t)filter.GetDstWidth() * filter.GetDstHeight());
+
+			//about 64K texels per job
+			jobs.ParallelFor(filter.GetDstHeight(), std::max(1u, 65536u / filter.GetDstWidth()), [&](size_t first, size_t last) {
+
+				filter.Run(level.data(), next.data(), (unsigned int)first, (unsigned int)last);
+			});
+
+			nTexels += (size_t)levelWidth * levelHeight;
+			levelWidth = filter.GetDstWidth();
+			levelHeight = filter.GetDstHeight();
+			level.swap(next);
+		}
+	}
+
+	const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	std::cout << std::fixed << std::setprecision(2)
+		<< width << "x" << height << " sRGB chain, " << MipFilter::CountLevels(width, height) << " levels, "
+		<< jobs.GetThreadCount() << " threads, " << nChains << " chains" << std::endl
+		<< ms / nChains << " ms per chain, " << nTexels / ms / 1000.0 << " Mtexel/s read" << std::endl;
+
+	return 0;
+}
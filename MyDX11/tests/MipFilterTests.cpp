@@ -0,0 +1,174 @@
+#include "TestCheck.h"
+#include "MipFilter.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+	double DecodeSrgb(int c) noexcept {
+
+		const double x = c / 255.0;
+
+		return x <= 0.04045 ? x / 12.92 : std::pow((x + 0.055) / 1.055, 2.4);
+	}
+
+	int EncodeSrgb(double linear) noexcept {
+
+		linear = std::clamp(linear, 0.0, 1.0);
+		const double c = linear <= 0.0031308 ? linear * 12.92 : 1.055 * std::pow(linear, 1.0 / 2.4) - 0.055;
+
+		return (int)std::floor(c * 255.0 + 0.5);
+	}
+
+	//reference output: every destination texel is the exact area weighted average of what it covers, in doubles
+	std::vector<uint32_t> ReferenceReduce(const std::vector<uint32_t>& src, unsigned int srcWidth, unsigned int srcHeight,
+		unsigned int dstWidth, unsigned int dstHeight, bool isSrgb) {
+
+		std::vector<uint32_t> dst((size_t)dstWidth * dstHeight);
+
+		for (unsigned int y = 0; y < dstHeight; y++) {
+
+			for (unsigned int x = 0; x < dstWidth; x++) {
+
+				const double y0 = (double)y * srcHeight / dstHeight;
+				const double y1 = (double)(y + 1u) * srcHeight / dstHeight;
+				const double x0 = (double)x * srcWidth / dstWidth;
+				const double x1 = (double)(x + 1u) * srcWidth / dstWidth;
+				const double area = (y1 - y0) * (x1 - x0);
+
+				double sum[4] = {};
+
+				for (unsigned int sy = (unsigned int)y0; sy < srcHeight && sy < y1; sy++) {
+
+					for (unsigned int sx = (unsigned int)x0; sx < srcWidth && sx < x1; sx++) {
+
+						const double weight = (std::min(y1, sy + 1.0) - std::max(y0, (double)sy)) * (std::min(x1, sx + 1.0) - std::max(x0, (double)sx)) / area;
+						const uint32_t texel = src[(size_t)sy * srcWidth + sx];
+
+						for (int c = 0; c < 4; c++) {
+
+							const int value = (texel >> (8 * c)) & 0xFF;
+							sum[c] += weight * (c < 3 && isSrgb ? DecodeSrgb(value) : value / 255.0);
+						}
+					}
+				}
+
+				uint32_t texel = 0u;
+
+				for (int c = 0; c < 4; c++) {
+
+					const int value = c < 3 && isSrgb ? EncodeSrgb(sum[c]) : (int)std::floor(std::min(1.0, sum[c]) * 255.0 + 0.5);
+					texel |= (uint32_t)value << (8 * c);
+				}
+
+				dst[(size_t)y * dstWidth + x] = texel;
+			}
+		}
+
+		return dst;
+	}
+
+	int GetMaxDifference(uint32_t a, uint32_t b) noexcept {
+
+		int difference = 0;
+
+		for (int shift = 0; shift < 32; shift += 8) {
+
+			difference = std::max(difference, std::abs((int)((a >> shift) & 0xFFu) - (int)((b >> shift) & 0xFFu)));
+		}
+
+		return difference;
+	}
+
+	void TestSizes() {
+
+		CHECK(MipFilter::NextSize(1u) == 1u);
+		CHECK(MipFilter::NextSize(2u) == 1u);
+		CHECK(MipFilter::NextSize(7u) == 3u);
+		CHECK(MipFilter::NextSize(1024u) == 512u);
+
+		CHECK(MipFilter::CountLevels(1u, 1u) == 1u);
+		CHECK(MipFilter::CountLevels(3u, 1u) == 2u);
+		CHECK(MipFilter::CountLevels(1024u, 1000u) == 11u);
+		CHECK(MipFilter::CountLevels(1u, 4096u) == 13u);
+	}
+
+	//odd, even, thin and square sizes against the reference, rows split across threads in uneven ranges
+	void TestAgainstReference() {
+
+		std::mt19937 rng(3u);
+		JobSystem jobs(3u);
+
+		const unsigned int sizes[][2] = { { 1u,1u },{ 2u,1u },{ 3u,3u },{ 5u,7u },{ 17u,4u },{ 64u,64u },{ 255u,129u },{ 1u,9u },{ 300u,200u } };
+
+		for (const auto& size : sizes) {
+
+			for (const bool isSrgb : { false,true }) {
+
+				std::vector<uint32_t> src((size_t)size[0] * size[1]);
+				std::generate(src.begin(), src.end(), [&rng]() { return (uint32_t)rng(); });
+
+				const MipFilter filter(size[0], size[1], isSrgb);
+				std::vector<uint32_t> dst((size_t)filter.GetDstWidth() * filter.GetDstHeight());
+
+				CHECK(filter.GetDstWidth() == MipFilter::NextSize(size[0]));
+				CHECK(filter.GetDstHeight() == MipFilter::NextSize(size[1]));
+
+				jobs.ParallelFor(filter.GetDstHeight(), 7u, [&](size_t first, size_t last) {
+
+					filter.Run(src.data(), dst.data(), (unsigned int)first, (unsigned int)last);
+				});
+
+				const auto reference = ReferenceReduce(src, size[0], size[1], filter.GetDstWidth(), filter.GetDstHeight(), isSrgb);
+				int maxDifference = 0;
+
+				for (size_t i = 0; i < dst.size(); i++) {
+
+					maxDifference = std::max(maxDifference, GetMaxDifference(dst[i], reference[i]));
+				}
+
+				//single precision against double may round the other way, never more than a step
+				CHECK(maxDifference <= 1);
+			}
+		}
+	}
+
+	//gamma correct: black and white average to the linear midpoint, not 128
+	void TestSrgbAverage() {
+
+		const std::vector<uint32_t> src = { 0xFF000000u,0xFFFFFFFFu,0xFF000000u,0xFFFFFFFFu };
+		uint32_t dst = 0u;
+
+		MipFilter(2u, 2u, true).Run(src.data(), &dst, 0u, 1u);
+		CHECK((dst & 0xFFu) == (uint32_t)EncodeSrgb(0.5));
+		CHECK((dst >> 24u) == 0xFFu);
+
+		MipFilter(2u, 2u, false).Run(src.data(), &dst, 0u, 1u);
+		CHECK((dst & 0xFFu) == 128u);
+	}
+
+	//alpha is always averaged linearly, even in an sRGB image
+	void TestAlphaIsLinear() {
+
+		const std::vector<uint32_t> src = { 0x00808080u,0xFF808080u };
+		uint32_t dst = 0u;
+
+		MipFilter(2u, 1u, true).Run(src.data(), &dst, 0u, 1u);
+		CHECK((dst >> 24u) == 128u);
+		CHECK((dst & 0xFFu) == 0x80u);
+	}
+}
+
+int main()
+{
+	Test::Run("level sizes", TestSizes);
+	Test::Run("matches the reference filter", TestAgainstReference);
+	Test::Run("srgb average", TestSrgbAverage);
+	Test::Run("alpha is linear", TestAlphaIsLinear);
+
+	return Test::Finish();
+}
@@ -0,0 +1,441 @@
+#include "TestCheck.h"
+#include "MipStreamer.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+	//1024x1024 at a byte per texel, 32x32 and below always resident
+	constexpr unsigned int mipCount = 11u;
+	constexpr unsigned int lowestMip = 5u;
+
+	constexpr size_t MipBytes(unsigned int mip) noexcept
+	{
+		return (size_t)(1024u >> mip) * (size_t)(1024u >> mip);
+	}
+
+	//bytes of mip and every level below it
+	size_t ResidentBytes(unsigned int mip) noexcept
+	{
+		size_t bytes = 0u;
+
+		for (unsigned int i = mip; i < mipCount; i++) {
+
+			bytes += MipBytes(i);
+		}
+
+		return bytes;
+	}
+
+	//what the app's streamer does with the transitions: each runs as a job and is completed a few frames later,
+	//every fifth load fails and leaves the texture as it was
+	struct Flight {
+
+		MipStreamer::Id id;
+		unsigned int mip;
+		int doneFrame;
+		bool isFailing;
+	};
+
+	//a row of streamed objects along x and a camera flying past them, all checks run after every frame
+	class Scene {
+
+	public:
+
+		static constexpr size_t objectCount = 32u;
+		static constexpr float spacing = 10.0f;
+		static constexpr float drawDistance = 60.0f;
+		static constexpr float radius = 1.0f;
+
+		//1080 pixels high, proj._22 of 1, the texture spread over 8 world units
+		static constexpr float pixelsPerUnit = 540.0f;
+		static constexpr float texelsPerUnit = 128.0f;
+
+		static constexpr int loadLatency = 3;
+		static constexpr int evictLatency = 1;
+
+	public:
+
+		explicit Scene(size_t budget)
+			:
+			m_streamer(MakeConfig(budget)),
+			m_lastDrawn(objectCount, -1)
+		{
+			for (size_t i = 0; i < objectCount; i++) {
+
+				std::vector<size_t> mipBytes;
+
+				for (unsigned int mip = 0; mip < mipCount; mip++) {
+
+					mipBytes.push_back(MipBytes(mip));
+				}
+
+				CHECK(m_streamer.Register(std::move(mipBytes), lowestMip) == i);
+			}
+
+			CHECK(m_streamer.GetCommittedBytes() == objectCount * ResidentBytes(lowestMip));
+		}
+
+		unsigned int GetExpectedMip(size_t object) const noexcept
+		{
+			const float x = object * spacing;
+			const float distance = std::sqrt((x - m_cameraX) * (x - m_cameraX) + 25.0f);
+
+			if (distance >= drawDistance) {
+
+				return MipStreamer::none;
+			}
+
+			return std::min(MipStreamer::ComputeRequiredMip(texelsPerUnit, pixelsPerUnit, distance, radius, mipCount), lowestMip);
+		}
+
+		void SetBudget(size_t budget) noexcept
+		{
+			m_streamer.SetBudget(budget);
+			m_shrinkFrame = m_frame;
+		}
+
+		//one frame of the app, camera at x on the line, objects 5 units off to the side
+		void Frame(float cameraX)
+		{
+			m_cameraX = cameraX;
+			m_frame++;
+
+			//finished jobs first, like TextureStreamer::Update
+			for (auto i = m_flights.begin(); i != m_flights.end();) {
+
+				if (i->doneFrame > m_frame) {
+
+					i++;
+					continue;
+				}
+
+				const auto status = m_streamer.GetStatus(i->id);
+				m_streamer.Complete(i->id, i->isFailing ? status.residentMip : i->mip);
+				i = m_flights.erase(i);
+			}
+
+			std::vector<bool> isDrawn(objectCount, false);
+
+			for (size_t i = 0; i < objectCount; i++) {
+
+				const unsigned int mip = GetExpectedMip(i);
+
+				if (mip != MipStreamer::none) {
+
+					//two draws of the same texture, the more detailed one wins
+					m_streamer.Request(i, std::min(mip + 1u, lowestMip));
+					m_streamer.Request(i, mip);
+
+					isDrawn[i] = true;
+					m_lastDrawn[i] = m_frame;
+				}
+			}
+
+			const auto& transitions = m_streamer.Update();
+
+			for (const auto& transition : transitions) {
+
+				const auto status = m_streamer.GetStatus(transition.id);
+				const bool isLoad = transition.mip < status.residentMip;
+
+				//one transition per texture at a time, matching what the policy reports as pending
+				m_isValid &= !IsInFlight(transition.id) && status.pendingMip == transition.mip;
+
+				if (isLoad) {
+
+					//only drawn textures load, and never more detail than they asked for
+					m_isValid &= isDrawn[transition.id] && transition.mip >= GetExpectedMip(transition.id);
+					m_nLoads++;
+				}
+				else {
+
+					//evictions never go past the floor
+					m_isValid &= transition.mip > status.residentMip && transition.mip <= lowestMip;
+					m_nEvictions++;
+				}
+
+				m_flights.push_back({ transition.id,transition.mip,m_frame + (isLoad ? loadLatency : evictLatency),isLoad && m_nLoads % 5u == 0u });
+			}
+
+			CheckBooks();
+			CheckEvictionOrder(transitions);
+			CheckLoadSlots(isDrawn);
+		}
+
+		bool IsValid() const noexcept
+		{
+			return m_isValid && m_isCapped && m_isLeastRecentFirst && m_isLoading;
+		}
+
+		bool IsCapped() const noexcept
+		{
+			return m_isCapped;
+		}
+
+		bool IsLeastRecentFirst() const noexcept
+		{
+			return m_isLeastRecentFirst;
+		}
+
+		unsigned int GetEvictionCount() const noexcept
+		{
+			return m_nEvictions;
+		}
+
+		unsigned int GetLoadCount() const noexcept
+		{
+			return m_nLoads;
+		}
+
+		const MipStreamer& GetStreamer() const noexcept
+		{
+			return m_streamer;
+		}
+
+		bool IsIdle() const noexcept
+		{
+			return m_flights.empty();
+		}
+
+	private:
+
+		static MipStreamer::Config MakeConfig(size_t budget) noexcept
+		{
+			MipStreamer::Config config;
+			config.budget = budget;
+			config.maxLoadsInFlight = 4u;
+
+			return config;
+		}
+
+		bool IsInFlight(MipStreamer::Id id) const noexcept
+		{
+			return std::any_of(m_flights.begin(), m_flights.end(), [id](const Flight& flight) { return flight.id == id; });
+		}
+
+		//committed bytes are what every texture holds once its transition lands, and stay under the budget
+		void CheckBooks()
+		{
+			size_t committed = 0u;
+			unsigned int nLoads = 0u;
+
+			for (size_t i = 0; i < objectCount; i++) {
+
+				const auto status = m_streamer.GetStatus(i);
+
+				m_isValid &= status.residentBytes == ResidentBytes(status.residentMip);
+				m_isValid &= (status.pendingMip != MipStreamer::none) == IsInFlight(i);
+
+				if (status.pendingMip != MipStreamer::none) {
+
+					committed += ResidentBytes(status.pendingMip);
+					nLoads += status.pendingMip < status.residentMip ? 1u : 0u;
+				}
+				else {
+
+					committed += ResidentBytes(status.residentMip);
+				}
+			}
+
+			m_isValid &= committed == m_streamer.GetCommittedBytes();
+			m_isValid &= nLoads <= 4u;
+
+			//a shrink can't take back loads already in flight, it holds once they have landed
+			if (m_frame > m_shrinkFrame + loadLatency) {
+
+				m_isCapped &= committed <= m_streamer.GetBudget();
+			}
+		}
+
+		//nothing is evicted while a texture drawn longer ago still holds more than its floor
+		void CheckEvictionOrder(const std::vector<MipStreamer::Transition>& transitions)
+		{
+			for (const auto& eviction : transitions) {
+
+				if (m_streamer.GetStatus(eviction.id).pendingMip < m_streamer.GetStatus(eviction.id).residentMip) {
+
+					continue;
+				}
+
+				for (size_t i = 0; i < objectCount; i++) {
+
+					const auto status = m_streamer.GetStatus(i);
+
+					if (m_lastDrawn[i] < m_lastDrawn[eviction.id] && status.pendingMip == MipStreamer::none) {
+
+						m_isLeastRecentFirst &= status.residentMip == lowestMip;
+					}
+				}
+			}
+		}
+
+		//a drawn texture short of detail is loading, or all the load slots are taken, or the budget is spent
+		void CheckLoadSlots(const std::vector<bool>& isDrawn)
+		{
+			unsigned int nLoads = 0u;
+
+			for (size_t i = 0; i < objectCount; i++) {
+
+				const auto status = m_streamer.GetStatus(i);
+				nLoads += status.pendingMip < status.residentMip ? 1u : 0u;
+			}
+
+			for (size_t i = 0; i < objectCount; i++) {
+
+				const auto status = m_streamer.GetStatus(i);
+
+				if (isDrawn[i] && status.pendingMip == MipStreamer::none && GetExpectedMip(i) < status.residentMip) {
+
+					const size_t nextMip = ResidentBytes(status.residentMip - 1u) - ResidentBytes(status.residentMip);
+					m_isLoading &= nLoads == 4u || m_streamer.GetCommittedBytes() + nextMip > m_streamer.GetBudget();
+				}
+			}
+		}
+
+	private:
+
+		MipStreamer m_streamer;
+		std::vector<Flight> m_flights;
+		std::vector<int> m_lastDrawn;
+
+		float m_cameraX = 0.0f;
+		int m_frame = 0;
+		int m_shrinkFrame = -100;
+		unsigned int m_nLoads = 0u;
+		unsigned int m_nEvictions = 0u;
+
+		bool m_isValid = true;
+		bool m_isCapped = true;
+		bool m_isLeastRecentFirst = true;
+		bool m_isLoading = true;
+	};
+
+	void TestRequiredMip() {
+
+		//a texel per pixel or bigger needs the top mip
+		CHECK(MipStreamer::ComputeRequiredMip(512.0f, 540.0f, 1.5f, 1.0f, mipCount) == 0u);
+		CHECK(MipStreamer::ComputeRequiredMip(512.0f, 540.0f, 0.0f, 1.0f, mipCount) == 0u);
+
+		//every doubling of the distance to the nearest point drops a level
+		CHECK(MipStreamer::ComputeRequiredMip(540.0f, 540.0f, 5.0f, 1.0f, mipCount) == 2u);
+		CHECK(MipStreamer::ComputeRequiredMip(540.0f, 540.0f, 9.0f, 1.0f, mipCount) == 3u);
+
+		//never past the smallest level
+		CHECK(MipStreamer::ComputeRequiredMip(540.0f, 540.0f, 1e6f, 1.0f, mipCount) == mipCount - 1u);
+	}
+
+	//enough budget for everything, the textures along the path follow the camera
+	void TestFlyPast() {
+
+		Scene scene(64u * 1024u * 1024u);
+
+		for (int frame = 0; frame < 200; frame++) {
+
+			scene.Frame(-30.0f + frame * 0.9f);
+		}
+
+		//parked, everything settles at what is drawn from here
+		for (int frame = 0; frame < 40; frame++) {
+
+			scene.Frame(150.0f);
+		}
+
+		CHECK(scene.IsValid());
+		CHECK(scene.IsIdle());
+		CHECK(scene.GetLoadCount() > 0u);
+		CHECK(scene.GetEvictionCount() == 0u);
+
+		bool isSettled = true;
+
+		for (size_t i = 0; i < Scene::objectCount; i++) {
+
+			const auto status = scene.GetStreamer().GetStatus(i);
+			const unsigned int expected = scene.GetExpectedMip(i);
+
+			//the ones ahead hold what they ask for, the ones passed keep the extra detail while there is room for it
+			if (expected != MipStreamer::none) {
+
+				isSettled &= status.requestedMip == expected;
+				isSettled &= i * Scene::spacing >= 150.0f ? status.residentMip == expected : status.residentMip <= expected;
+			}
+		}
+
+		CHECK(isSettled);
+	}
+
+	//the budget drops under what the parked camera asks for, then the camera flies back on the small budget
+	void TestTightBudget() {
+
+		Scene scene(64u * 1024u * 1024u);
+
+		for (int frame = 0; frame < 200; frame++) {
+
+			scene.Frame(-30.0f + frame * 1.75f);
+		}
+
+		for (int frame = 0; frame < 20; frame++) {
+
+			scene.Frame(150.0f);
+		}
+
+		//a little over the floors of every texture
+		const size_t floors = Scene::objectCount * ResidentBytes(lowestMip);
+		const size_t budget = floors + 2u * 1024u * 1024u;
+
+		scene.SetBudget(budget);
+
+		for (int frame = 0; frame < 20; frame++) {
+
+			scene.Frame(150.0f);
+		}
+
+		CHECK(scene.IsCapped());
+		CHECK(scene.IsLeastRecentFirst());
+		CHECK(scene.IsIdle());
+		CHECK(scene.GetEvictionCount() > 0u);
+		CHECK(scene.GetStreamer().GetCommittedBytes() <= budget);
+
+		//everything out of sight is back at its floor, and only then did the drawn ones give up detail
+		bool isDrained = true;
+
+		for (size_t i = 0; i < Scene::objectCount; i++) {
+
+			if (scene.GetExpectedMip(i) == MipStreamer::none) {
+
+				isDrained &= scene.GetStreamer().GetStatus(i).residentMip == lowestMip;
+			}
+		}
+
+		CHECK(isDrained);
+
+		for (int frame = 0; frame < 200; frame++) {
+
+			scene.Frame(320.0f - frame * 1.75f);
+		}
+
+		CHECK(scene.IsValid());
+		CHECK(scene.GetStreamer().GetCommittedBytes() <= budget);
+
+		//floors alone over the budget, the floors stay and nothing loads
+		scene.SetBudget(floors / 2u);
+
+		for (int frame = 0; frame < 20; frame++) {
+
+			scene.Frame(100.0f);
+		}
+
+		CHECK(scene.IsIdle());
+		CHECK(scene.GetStreamer().GetCommittedBytes() == floors);
+	}
+}
+
+int main()
+{
+	Test::Run("required mip", TestRequiredMip);
+	Test::Run("fly past", TestFlyPast);
+	Test::Run("tight budget", TestTightBudget);
+
+	return Test::Finish();
+}
@@ -0,0 +1,121 @@
+#include "ObjectSimulation.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <random>
+
+//1M random objects stepped and turned into world matrices, each kernel on its own on one thread,
+//then whole frames (one step, blended emit, cull) split into the app's job ranges across every core
+//usage: ObjectSimulationBenchmark [frames]
+int main(int argc, char* argv[])
+{
+	using Clock = std::chrono::steady_clock;
+
+	const int nFrames = argc > 1 ? std::max(1, std::atoi(argv[1])) : 20;
+
+	constexpr size_t nObjects = 1'000'000u;
+	constexpr size_t groupsPerJob = 1024u;
+	constexpr float dt = 1.0f / 60.0f;
+
+	ObjectSimulation sim;
+	std::mt19937 rng(5u);
+	std::uniform_real_distribution<float> angle(-3.14159265f, 3.14159265f);
+	std::uniform_real_distribution<float> rate(-2.0f, 2.0f);
+	std::uniform_real_distribution<float> radius(2.0f, 60.0f);
+
+	for (size_t i = 0; i < nObjects; i++) {
+
+		ObjectSimulation::Motion motion;
+		motion.r = radius(rng);
+		motion.roll = angle(rng);
+		motion.pitch = angle(rng);
+		motion.yaw = angle(rng);
+		motion.theta = angle(rng);
+		motion.phi = angle(rng);
+		motion.chi = angle(rng);
+		motion.droll = rate(rng);
+		motion.dpitch = rate(rng);
+		motion.dyaw = rate(rng);
+		motion.dtheta = rate(rng);
+		motion.dphi = rate(rng);
+		motion.dchi = rate(rng);
+		sim.Spawn(motion);
+	}
+
+	//XMMatrixPerspectiveLH(1, 9/16, 0.5, 40) like the app's, looking down +z from the origin
+	const float range = 40.0f / 39.5f;
+	const DirectX::XMFLOAT4X4 viewProj = {
+		1.0f,0.0f,0.0f,0.0f,
+		0.0f,16.0f / 9.0f,0.0f,0.0f,
+		0.0f,0.0f,range,1.0f,
+		0.0f,0.0f,-range * 0.5f,0.0f,
+	};
+
+	JobSystem jobs;
+
+	std::cout << std::fixed << std::setprecision(2)
+		<< nObjects << " objects, " << jobs.GetThreadCount() << " threads, " << nFrames << " frames" << std::endl;
+
+	const auto time = [nFrames](const auto& func) {
+
+		//one untimed frame first so every page of the streams is touched
+		func();
+
+		const auto start = Clock::now();
+
+		for (int frame = 0; frame < nFrames; frame++) {
+
+			func();
+		}
+
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count() / nFrames;
+	};
+
+	const size_t nGroups = sim.GetGroupCount();
+
+	const double updateMs = time([&]() { sim.Update(dt); });
+	const double emitMs = time([&]() { sim.EmitTransforms(); });
+	const double blendMs = time([&]() { sim.EmitTransforms(0.5f, 0u, nGroups); });
+	const double cullMs = time([&]() { sim.Cull(viewProj, 0u, nGroups); });
+
+	std::cout << "update          " << updateMs << " ms, " << nObjects / updateMs / 1000.0 << " M objects/s" << std::endl;
+	std::cout << "emit            " << emitMs << " ms, " << nObjects / emitMs / 1000.0 << " M objects/s" << std::endl;
+	std::cout << "emit blended    " << blendMs << " ms, " << nObjects / blendMs / 1000.0 << " M objects/s" << std::endl;
+	std::cout << "cull            " << cullMs << " ms, " << nObjects / cullMs / 1000.0 << " M objects/s" << std::endl;
+
+	const auto frame = [&]() {
+
+		sim.Update(dt, 0u, nGroups);
+		sim.EmitTransforms(0.5f, 0u, nGroups);
+		sim.Cull(viewProj, 0u, nGroups);
+	};
+
+	const auto jobFrame = [&]() {
+
+		jobs.ParallelFor(nGroups, groupsPerJob, [&](size_t first, size_t last) {
+
+			sim.Update(dt, first, last);
+			sim.EmitTransforms(0.5f, first, last);
+			sim.Cull(viewProj, first, last);
+		});
+	};
+
+	const double frameMs = time(frame);
+	const double jobFrameMs = time(jobFrame);
+
+	size_t nVisible = 0u;
+
+	for (size_t i = 0; i < sim.GetCount(); i++) {
+
+		nVisible += sim.IsVisible(i) ? 1u : 0u;
+	}
+
+	std::cout << "frame, 1 thread " << frameMs << " ms" << std::endl;
+	std::cout << "frame, " << jobs.GetThreadCount() << " threads " << jobFrameMs << " ms, "
+		<< frameMs / jobFrameMs << "x, " << nVisible << " visible" << std::endl;
+
+	return 0;
+}
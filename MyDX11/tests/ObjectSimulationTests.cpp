@@ -0,0 +1,429 @@
+#include "TestCheck.h"
+#include "ObjectSimulation.h"
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+	constexpr double pi = 3.14159265358979323846;
+
+	using Matrix = double[4][4];
+
+	void Multiply(const Matrix& a, const Matrix& b, Matrix& out) {
+
+		for (int row = 0; row < 4; row++) {
+
+			for (int col = 0; col < 4; col++) {
+
+				out[row][col] = 0.0;
+
+				for (int k = 0; k < 4; k++) {
+
+					out[row][col] += a[row][k] * b[k][col];
+				}
+			}
+		}
+	}
+
+	//XMMatrixRotationRollPitchYaw spelled out, roll about z, then pitch about x, then yaw about y, row vectors
+	void RollPitchYaw(double pitch, double yaw, double roll, Matrix& out) {
+
+		const Matrix rz = {
+			{ std::cos(roll),std::sin(roll),0.0,0.0 },
+			{ -std::sin(roll),std::cos(roll),0.0,0.0 },
+			{ 0.0,0.0,1.0,0.0 },
+			{ 0.0,0.0,0.0,1.0 },
+		};
+		const Matrix rx = {
+			{ 1.0,0.0,0.0,0.0 },
+			{ 0.0,std::cos(pitch),std::sin(pitch),0.0 },
+			{ 0.0,-std::sin(pitch),std::cos(pitch),0.0 },
+			{ 0.0,0.0,0.0,1.0 },
+		};
+		const Matrix ry = {
+			{ std::cos(yaw),0.0,-std::sin(yaw),0.0 },
+			{ 0.0,1.0,0.0,0.0 },
+			{ std::sin(yaw),0.0,std::cos(yaw),0.0 },
+			{ 0.0,0.0,0.0,1.0 },
+		};
+
+		Matrix zx;
+		Multiply(rz, rx, zx);
+		Multiply(zx, ry, out);
+	}
+
+	//RotationRollPitchYaw(pitch,yaw,roll) * Translation(r,0,0) * RotationRollPitchYaw(theta,phi,chi) in doubles
+	void Reference(double r, const double angles[6], Matrix& out) {
+
+		Matrix local;
+		RollPitchYaw(angles[1], angles[2], angles[0], local);
+		local[3][0] += r;
+
+		Matrix orbit;
+		RollPitchYaw(angles[3], angles[4], angles[5], orbit);
+		Multiply(local, orbit, out);
+	}
+
+	void Angles(const ObjectSimulation::Motion& motion, double angles[6]) {
+
+		angles[0] = motion.roll;
+		angles[1] = motion.pitch;
+		angles[2] = motion.yaw;
+		angles[3] = motion.theta;
+		angles[4] = motion.phi;
+		angles[5] = motion.chi;
+	}
+
+	//rotation elements absolutely, the translation row relative to the orbit radius
+	bool IsNear(const DirectX::XMFLOAT4X4& transform, const Matrix& expected, double r, double tolerance) {
+
+		for (int row = 0; row < 4; row++) {
+
+			const double scale = row == 3 ? 1.0 + r : 1.0;
+
+			for (int col = 0; col < 4; col++) {
+
+				if (std::abs(transform.m[row][col] - expected[row][col]) > tolerance * scale) {
+
+					return false;
+				}
+			}
+		}
+
+		return true;
+	}
+
+	ObjectSimulation::Motion RandomMotion(std::mt19937& rng, float angleRange) {
+
+		std::uniform_real_distribution<float> angle(-angleRange, angleRange);
+		std::uniform_real_distribution<float> rate(-4.0f, 4.0f);
+		std::uniform_real_distribution<float> radius(0.0f, 20.0f);
+
+		ObjectSimulation::Motion motion;
+		motion.r = radius(rng);
+		motion.roll = angle(rng);
+		motion.pitch = angle(rng);
+		motion.yaw = angle(rng);
+		motion.theta = angle(rng);
+		motion.phi = angle(rng);
+		motion.chi = angle(rng);
+		motion.droll = rate(rng);
+		motion.dpitch = rate(rng);
+		motion.dyaw = rate(rng);
+		motion.dtheta = rate(rng);
+		motion.dphi = rate(rng);
+		motion.dchi = rate(rng);
+
+		return motion;
+	}
+
+	//a count that leaves a partly filled last group
+	void TestMatrices() {
+
+		ObjectSimulation sim;
+		std::mt19937 rng(3u);
+
+		for (int i = 0; i < 1001; i++) {
+
+			sim.Spawn(RandomMotion(rng, 10.0f));
+		}
+
+		sim.EmitTransforms();
+
+		bool isNear = true;
+
+		for (size_t i = 0; i < sim.GetCount(); i++) {
+
+			const auto motion = sim.GetMotion(sim.GetHandle(i));
+
+			double angles[6];
+			Angles(motion, angles);
+
+			Matrix expected;
+			Reference(motion.r, angles, expected);
+
+			isNear &= IsNear(sim.GetTransform(i), expected, motion.r, 2e-5);
+		}
+
+		CHECK(isNear);
+
+		//the edges of the folded sine/cosine ranges
+		const float edges[] = { 0.0f,1.5707963f,-1.5707963f,3.1415927f,-3.1415927f,4.712389f,6.2831853f,-6.2831853f,100.0f };
+
+		for (const float edge : edges) {
+
+			ObjectSimulation one;
+			ObjectSimulation::Motion motion;
+			motion.r = 1.0f;
+			motion.roll = edge;
+			motion.pitch = edge * 0.5f;
+			motion.yaw = -edge;
+			motion.theta = edge;
+			motion.phi = edge * 0.25f;
+			motion.chi = -edge * 0.5f;
+			one.Spawn(motion);
+			one.EmitTransforms();
+
+			double angles[6];
+			Angles(motion, angles);
+
+			Matrix expected;
+			Reference(motion.r, angles, expected);
+
+			CHECK(IsNear(one.GetTransform(0u), expected, motion.r, 2e-5));
+		}
+	}
+
+	//many steps wrap every angle, the matrices still follow the unwrapped angles
+	void TestWrap() {
+
+		ObjectSimulation sim;
+		std::mt19937 rng(5u);
+		std::vector<ObjectSimulation::Motion> start;
+
+		for (int i = 0; i < 257; i++) {
+
+			start.push_back(RandomMotion(rng, 3.0f));
+			sim.Spawn(start.back());
+		}
+
+		constexpr int nSteps = 300;
+		constexpr float dt = 1.0f / 60.0f;
+
+		for (int step = 0; step < nSteps; step++) {
+
+			sim.Update(dt);
+		}
+
+		sim.EmitTransforms();
+
+		bool isWrapped = true;
+		bool isNear = true;
+
+		for (size_t i = 0; i < sim.GetCount(); i++) {
+
+			const auto motion = sim.GetMotion(sim.GetHandle(i));
+			const float wrapped[6] = { motion.roll,motion.pitch,motion.yaw,motion.theta,motion.phi,motion.chi };
+
+			const auto& s = start[i];
+			const double rates[6] = { s.droll,s.dpitch,s.dyaw,s.dtheta,s.dphi,s.dchi };
+			const double origins[6] = { s.roll,s.pitch,s.yaw,s.theta,s.phi,s.chi };
+
+			double angles[6];
+
+			for (int a = 0; a < 6; a++) {
+
+				angles[a] = origins[a] + rates[a] * (double)dt * nSteps;
+
+				//inside [-PI,PI] and the same point on the circle as the unwrapped angle
+				isWrapped &= std::abs(wrapped[a]) <= (float)pi;
+				isWrapped &= std::abs(std::remainder(wrapped[a] - angles[a], 2.0 * pi)) < 1e-4;
+			}
+
+			Matrix expected;
+			Reference(s.r, angles, expected);
+
+			isNear &= IsNear(sim.GetTransform(i), expected, s.r, 1e-4);
+		}
+
+		CHECK(isWrapped);
+		CHECK(isNear);
+
+		//no time, no change
+		const auto before = sim.GetMotion(sim.GetHandle(0u));
+		sim.Update(0.0f);
+		CHECK(sim.GetMotion(sim.GetHandle(0u)).roll == before.roll);
+	}
+
+	//alpha blends from the state before the last step, the short way around through PI
+	void TestBlend() {
+
+		ObjectSimulation sim;
+
+		ObjectSimulation::Motion motion;
+		motion.r = 2.0f;
+		motion.roll = 3.0f;
+		motion.droll = 1.0f;
+		motion.phi = -0.5f;
+		motion.dphi = -0.4f;
+		sim.Spawn(motion);
+
+		sim.Update(0.5f);
+
+		for (const float alpha : { 0.0f,0.25f,0.5f,0.75f }) {
+
+			sim.EmitTransforms(alpha, 0u, sim.GetGroupCount());
+
+			const double angles[6] = { 3.0 + 0.5 * alpha,0.0,0.0,0.0,-0.5 - 0.2 * alpha,0.0 };
+
+			Matrix expected;
+			Reference(motion.r, angles, expected);
+
+			CHECK(IsNear(sim.GetTransform(0u), expected, motion.r, 2e-5));
+		}
+
+		//setting the motion snaps instead of sweeping from the old state
+		motion.roll = -1.0f;
+		sim.SetMotion(sim.GetHandle(0u), motion);
+		sim.EmitTransforms(0.5f, 0u, sim.GetGroupCount());
+
+		double angles[6];
+		Angles(motion, angles);
+
+		Matrix expected;
+		Reference(motion.r, angles, expected);
+
+		CHECK(IsNear(sim.GetTransform(0u), expected, motion.r, 2e-5));
+	}
+
+	void TestHandles() {
+
+		ObjectSimulation sim;
+		CHECK(sim.GetCount() == 0u && sim.GetGroupCount() == 0u);
+
+		std::vector<ObjectSimulation::Handle> handles;
+
+		for (int i = 0; i < 6; i++) {
+
+			ObjectSimulation::Motion motion;
+			motion.r = (float)i;
+			handles.push_back(sim.Spawn(motion, (float)i + 0.5f));
+		}
+
+		CHECK(sim.GetCount() == 6u && sim.GetGroupCount() == 2u);
+
+		//the last object fills the hole
+		CHECK(sim.Despawn(handles[1]) == 1u);
+		CHECK(!sim.IsValid(handles[1]));
+		CHECK(sim.GetIndex(handles[5]) == 1u);
+		CHECK(sim.GetHandle(1u) == handles[5]);
+		CHECK(sim.GetMotion(handles[5]).r == 5.0f);
+		CHECK(sim.GetBoundingRadius(1u) == 5.5f);
+
+		//the freed slot comes back with a new generation
+		const auto reused = sim.Spawn({});
+		CHECK(reused.index == handles[1].index && !(reused == handles[1]));
+		CHECK(sim.IsValid(reused) && !sim.IsValid(handles[1]));
+		CHECK(sim.GetIndex(reused) == 5u);
+
+		for (size_t i = 0; i < sim.GetCount(); i++) {
+
+			CHECK(sim.GetIndex(sim.GetHandle(i)) == i);
+		}
+
+		sim.Clear();
+		CHECK(sim.GetCount() == 0u);
+		CHECK(!sim.IsValid(handles[0]) && !sim.IsValid(reused));
+	}
+
+	//D3D style perspective with a 90 degree field of view looking down +z, near 1 and far 100
+	DirectX::XMFLOAT4X4 ViewProjection() {
+
+		constexpr float zn = 1.0f;
+		constexpr float zf = 100.0f;
+
+		return {
+			1.0f,0.0f,0.0f,0.0f,
+			0.0f,1.0f,0.0f,0.0f,
+			0.0f,0.0f,zf / (zf - zn),1.0f,
+			0.0f,0.0f,-zn * zf / (zf - zn),0.0f,
+		};
+	}
+
+	//the orbit yaw puts an object at radius r on the xz plane, phi -PI/2 is straight ahead
+	ObjectSimulation::Motion At(float r, float phi) {
+
+		ObjectSimulation::Motion motion;
+		motion.r = r;
+		motion.phi = phi;
+		return motion;
+	}
+
+	void TestCull() {
+
+		ObjectSimulation sim;
+		const auto viewProj = ViewProjection();
+
+		sim.Spawn(At(10.0f, -0.5f * (float)pi), 1.0f);		//ahead
+		sim.Spawn(At(10.0f, 0.5f * (float)pi), 1.0f);		//behind
+		sim.Spawn(At(150.0f, -0.5f * (float)pi), 1.0f);		//past the far plane
+		sim.Spawn(At(0.5f, -0.5f * (float)pi), 1.0f);		//straddling the near plane
+		sim.Spawn(At(10.0f, -0.25f * (float)pi + 0.3f), 3.0f);	//outside the right plane by 2.96, reaching in
+		sim.Spawn(At(10.0f, -0.25f * (float)pi + 0.3f), 2.9f);	//same center, not reaching in
+
+		sim.EmitTransforms();
+		sim.Cull(viewProj, 0u, sim.GetGroupCount());
+
+		CHECK(sim.IsVisible(0u));
+		CHECK(!sim.IsVisible(1u));
+		CHECK(!sim.IsVisible(2u));
+		CHECK(sim.IsVisible(3u));
+		CHECK(sim.IsVisible(4u));
+		CHECK(!sim.IsVisible(5u));
+
+		//random spheres against the six planes in doubles, skipping the ones that just touch a plane
+		std::mt19937 rng(7u);
+		std::uniform_real_distribution<float> radius(0.1f, 10.0f);
+
+		ObjectSimulation many;
+
+		for (int i = 0; i < 2000; i++) {
+
+			many.Spawn(RandomMotion(rng, 3.0f), radius(rng));
+		}
+
+		many.EmitTransforms();
+		many.Cull(viewProj, 0u, many.GetGroupCount());
+
+		const double invSqrt2 = 1.0 / std::sqrt(2.0);
+		bool isCulled = true;
+		int nVisible = 0;
+
+		for (size_t i = 0; i < many.GetCount(); i++) {
+
+			const auto& t = many.GetTransform(i);
+			const double x = t._41;
+			const double y = t._42;
+			const double z = t._43;
+
+			const double distances[6] = {
+				(z + x) * invSqrt2,
+				(z - x) * invSqrt2,
+				(z + y) * invSqrt2,
+				(z - y) * invSqrt2,
+				z - 1.0,
+				100.0 - z,
+			};
+
+			bool isVisible = true;
+			bool isClose = false;
+
+			for (const double d : distances) {
+
+				isVisible &= d >= -many.GetBoundingRadius(i);
+				isClose |= std::abs(d + many.GetBoundingRadius(i)) < 1e-3;
+			}
+
+			if (!isClose) {
+
+				isCulled &= many.IsVisible(i) == isVisible;
+				nVisible += isVisible ? 1 : 0;
+			}
+		}
+
+		CHECK(isCulled);
+		CHECK(nVisible > 0 && nVisible < 2000);
+	}
+}
+
+int main()
+{
+	Test::Run("matrices", TestMatrices);
+	Test::Run("wrap", TestWrap);
+	Test::Run("blend", TestBlend);
+	Test::Run("handles", TestHandles);
+	Test::Run("cull", TestCull);
+
+	return Test::Finish();
+}
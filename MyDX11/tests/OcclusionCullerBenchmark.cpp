@@ -0,0 +1,184 @@
+#include "OcclusionCuller.h"
+#include "RenderScene.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+namespace {
+
+	namespace dx = DirectX;
+
+	using Clock = std::chrono::steady_clock;
+	using OccluderMesh = OcclusionCuller::OccluderMesh;
+
+	double MsSince(Clock::time_point start) noexcept
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	//row vectors, a * b
+	dx::XMFLOAT4X4 Multiply(const dx::XMFLOAT4X4& a, const dx::XMFLOAT4X4& b) noexcept
+	{
+		dx::XMFLOAT4X4 result;
+
+		for (int r = 0; r < 4; r++) {
+
+			for (int c = 0; c < 4; c++) {
+
+				result.m[r][c] = a.m[r][0] * b.m[0][c] + a.m[r][1] * b.m[1][c] + a.m[r][2] * b.m[2][c] + a.m[r][3] * b.m[3][c];
+			}
+		}
+
+		return result;
+	}
+
+	//a sphere stretched to an ellipsoid with those half sizes around the center
+	OccluderMesh MakePart(const dx::XMFLOAT3& center, const dx::XMFLOAT3& half)
+	{
+		const auto sphere = RenderScene::MakeSphere(1.0f, 32u, 64u);
+		OccluderMesh part;
+
+		for (const auto& p : sphere.positions) {
+
+			part.vertices.push_back({ center.x + p.x * half.x,center.y + p.y * half.y,center.z + p.z * half.z });
+		}
+
+		part.indices.assign(sphere.indices.begin(), sphere.indices.end());
+
+		return part;
+	}
+
+	//helmet, body, arms, hands and legs of a figure 2 high standing on the origin, each a mesh of its own like the nanosuit's
+	std::vector<OccluderMesh> MakeSuit()
+	{
+		return {
+			MakePart({ 0.0f,1.8f,0.0f },{ 0.15f,0.2f,0.17f }),
+			MakePart({ 0.0f,1.25f,0.0f },{ 0.3f,0.4f,0.18f }),
+			MakePart({ -0.45f,1.25f,0.0f },{ 0.1f,0.4f,0.1f }),
+			MakePart({ 0.45f,1.25f,0.0f },{ 0.1f,0.4f,0.1f }),
+			MakePart({ -0.45f,0.75f,0.0f },{ 0.08f,0.1f,0.06f }),
+			MakePart({ 0.45f,0.75f,0.0f },{ 0.08f,0.1f,0.06f }),
+			MakePart({ -0.15f,0.45f,0.0f },{ 0.13f,0.45f,0.13f }),
+			MakePart({ 0.15f,0.45f,0.0f },{ 0.13f,0.45f,0.13f }),
+		};
+	}
+}
+
+//the culler's frame at its default size with a row of nanosuit sized figures in front of the engine's camera: drawing the
+//occluders and asking about a field of boxes behind them, with the source meshes and with what Simplify makes of them,
+//at every level this machine runs, on one thread
+//usage: OcclusionCullerBenchmark [frames]
+int main(int argc, char* argv[])
+{
+	const int nFrames = argc > 1 ? std::max(1, std::atoi(argv[1])) : 100;
+
+	constexpr unsigned int cells = 24u;
+	constexpr int nSuits = 5;
+	constexpr int boxesPerSide = 40;
+
+	auto source = MakeSuit();
+	std::vector<OccluderMesh> simplified;
+
+	size_t nSourceTriangles = 0u;
+	size_t nSimplifiedTriangles = 0u;
+	const auto simplifyStart = Clock::now();
+
+	for (const auto& part : source) {
+
+		simplified.push_back(OccluderMesh::Simplify(part.vertices, part.indices, cells));
+	}
+
+	const double simplifyMs = MsSince(simplifyStart);
+
+	for (size_t i = 0; i < source.size(); i++) {
+
+		nSourceTriangles += source[i].GetTriangleCount();
+		nSimplifiedTriangles += simplified[i].GetTriangleCount();
+	}
+
+	std::cout << std::fixed << std::setprecision(2) << nFrames << " frames, " << nSuits << " figures of " << source.size() << " meshes, "
+		<< nSourceTriangles << " triangles each, simplified onto " << cells << " cells to " << nSimplifiedTriangles << " in " << simplifyMs << " ms" << std::endl;
+
+	//the figures a little apart across the middle of the scene, twice the size
+	std::vector<dx::XMFLOAT4X4> worlds;
+
+	for (int s = 0; s < nSuits; s++) {
+
+		auto world = RenderScene::Translation((s - (nSuits - 1) * 0.5f) * 1.6f, -0.5f, 0.0f);
+		world._11 = world._22 = world._33 = 2.0f;
+		worlds.push_back(world);
+	}
+
+	//a field of small boxes standing behind them, some hidden and some not
+	std::vector<std::pair<dx::XMFLOAT3, dx::XMFLOAT3>> boxes;
+
+	for (int z = 0; z < boxesPerSide; z++) {
+
+		for (int x = 0; x < boxesPerSide; x++) {
+
+			const float bx = (x - boxesPerSide * 0.5f) * 0.5f;
+			const float bz = 1.0f + z * 0.5f;
+
+			boxes.push_back({ { bx,0.0f,bz },{ bx + 0.3f,0.6f,bz + 0.3f } });
+		}
+	}
+
+	const auto viewProj = Multiply(RenderScene::MakeView(), RenderScene::MakeProjection());
+	OcclusionCuller culler;
+
+	for (const auto isa : { PixelKernels::Isa::Scalar,PixelKernels::Isa::Sse2,PixelKernels::Isa::Avx2 }) {
+
+		if (isa > PixelKernels::GetSupportedIsa()) {
+
+			continue;
+		}
+
+		culler.SetIsa(isa);
+
+		for (const auto* pMeshes : { &source,&simplified }) {
+
+			double drawMs = 0.0;
+			double queryMs = 0.0;
+			size_t nHidden = 0u;
+
+			for (int frame = 0; frame < nFrames; frame++) {
+
+				const auto drawStart = Clock::now();
+
+				culler.Begin(viewProj);
+
+				for (const auto& world : worlds) {
+
+					for (const auto& mesh : *pMeshes) {
+
+						culler.AddOccluder(mesh, world);
+					}
+				}
+
+				culler.Rasterize();
+				drawMs += MsSince(drawStart);
+
+				const auto queryStart = Clock::now();
+				nHidden = 0u;
+
+				for (const auto& box : boxes) {
+
+					nHidden += culler.IsVisible(box.first, box.second) ? 0u : 1u;
+				}
+
+				queryMs += MsSince(queryStart);
+			}
+
+			const auto& stats = culler.GetStats();
+
+			std::cout << std::setw(6) << PixelKernels::GetIsaName(isa) << (pMeshes == &source ? " source: " : " simplified: ")
+				<< stats.triangles << " triangles (" << stats.drawnTriangles << " drawn) in " << drawMs / nFrames << " ms, "
+				<< boxes.size() << " boxes (" << nHidden << " hidden) in " << queryMs / nFrames << " ms" << std::endl;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,700 @@
+#include "TestCheck.h"
+#include "OcclusionCuller.h"
+#include "RenderScene.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+	namespace dx = DirectX;
+
+	using OccluderMesh = OcclusionCuller::OccluderMesh;
+
+	constexpr double pi = 3.14159265358979323846;
+
+	//row vectors, a * b
+	dx::XMFLOAT4X4 Multiply(const dx::XMFLOAT4X4& a, const dx::XMFLOAT4X4& b) noexcept {
+
+		dx::XMFLOAT4X4 result;
+
+		for (int r = 0; r < 4; r++) {
+
+			for (int c = 0; c < 4; c++) {
+
+				result.m[r][c] = a.m[r][0] * b.m[0][c] + a.m[r][1] * b.m[1][c] + a.m[r][2] * b.m[2][c] + a.m[r][3] * b.m[3][c];
+			}
+		}
+
+		return result;
+	}
+
+	//MakeBox stretched to the box [min,max]
+	dx::XMFLOAT4X4 BoxWorld(const dx::XMFLOAT3& min, const dx::XMFLOAT3& max) noexcept {
+
+		auto world = RenderScene::Translation((min.x + max.x) * 0.5f, (min.y + max.y) * 0.5f, (min.z + max.z) * 0.5f);
+		world._11 = max.x - min.x;
+		world._22 = max.y - min.y;
+		world._33 = max.z - min.z;
+
+		return world;
+	}
+
+
+	/// a 128x64 buffer looking down +z from the origin, near 1, where pixel (px,py) at depth z is world (px - 64, 32 - py) * z / 64,
+	/// so walls and boxes can be placed on exact pixels and tile edges (tiles are 32x8, 4 across and 8 down)
+
+	constexpr unsigned int width = 128u;
+	constexpr unsigned int height = 64u;
+
+	dx::XMFLOAT4X4 ScreenViewProj() noexcept {
+
+		return RenderScene::PerspectiveLH(2.0f, 1.0f, 1.0f, 100.0f);
+	}
+
+	float WorldX(float px, float z) noexcept {
+
+		return (px - 64.0f) * z / 64.0f;
+	}
+
+	float WorldY(float py, float z) noexcept {
+
+		return (32.0f - py) * z / 64.0f;
+	}
+
+	//a thin box whose near face covers the pixel centers in [left,right) x [top,bottom) at depth z
+	void AddWall(OcclusionCuller& culler, float left, float right, float top, float bottom, float z) {
+
+		culler.AddOccluder(OccluderMesh::MakeBox(), BoxWorld({ WorldX(left,z),WorldY(bottom,z),z }, { WorldX(right,z),WorldY(top,z),z + 0.01f }));
+	}
+
+	//a box that touches exactly the pixels [left,right) x [top,bottom), from depth z a little way back
+	bool IsVisible(const OcclusionCuller& culler, float left, float right, float top, float bottom, float z) {
+
+		const float back = z * 1.001f;
+
+		return culler.IsVisible(
+			dx::XMFLOAT3{ WorldX(left + 0.5f,z),WorldY(bottom - 0.5f,z),z },
+			dx::XMFLOAT3{ WorldX(right - 0.5f,z),WorldY(top + 0.5f,z),back });
+	}
+
+	void TestFullyHidden() {
+
+		OcclusionCuller culler(width, height);
+		culler.Begin(ScreenViewProj());
+
+		//nothing drawn hides nothing
+		culler.Rasterize();
+		CHECK(IsVisible(culler, 10.0f, 20.0f, 10.0f, 20.0f, 5.0f));
+
+		culler.Begin(ScreenViewProj());
+		AddWall(culler, -10.0f, 138.0f, -10.0f, 74.0f, 2.0f);
+		culler.Rasterize();
+
+		CHECK(culler.GetStats().occluders == 1u);
+		CHECK(culler.GetStats().triangles == 12u);
+		//the near face, the rest face away or lie off screen
+		CHECK(culler.GetStats().drawnTriangles == 2u);
+
+		//behind it, wherever and however large
+		CHECK(!IsVisible(culler, 10.0f, 20.0f, 10.0f, 20.0f, 5.0f));
+		CHECK(!IsVisible(culler, 0.0f, 128.0f, 0.0f, 64.0f, 50.0f));
+		CHECK(!culler.IsVisible(dx::XMFLOAT3{ 0.0f,0.0f,10.0f }, 1.0f));
+
+		//in front of it
+		CHECK(IsVisible(culler, 10.0f, 20.0f, 10.0f, 20.0f, 1.5f));
+
+		//off screen counts as not visible, the frustum test has it anyway
+		CHECK(!culler.IsVisible(dx::XMFLOAT3{ 100.0f,0.0f,5.0f }, 1.0f));
+
+		//the depth buffer is the wall's 1/w everywhere
+		std::vector<float> depth;
+		culler.ResolveDepth(depth);
+
+		CHECK(depth.size() == (size_t)width * height);
+		CHECK(std::all_of(depth.begin(), depth.end(), [](float z) { return std::abs(z - 0.5f) < 1e-6f; }));
+	}
+
+	void TestPartlyVisible() {
+
+		OcclusionCuller culler(width, height);
+		culler.Begin(ScreenViewProj());
+
+		//the left half, and the top of the screen from row 20 down
+		AddWall(culler, -10.0f, 64.0f, 20.0f, 74.0f, 2.0f);
+		culler.Rasterize();
+
+		CHECK(!IsVisible(culler, 10.0f, 60.0f, 24.0f, 60.0f, 5.0f));
+
+		//one pixel column past the wall's edge
+		CHECK(IsVisible(culler, 10.0f, 65.0f, 24.0f, 60.0f, 5.0f));
+		CHECK(IsVisible(culler, 70.0f, 80.0f, 24.0f, 60.0f, 5.0f));
+
+		//peeking over the top by one row
+		CHECK(IsVisible(culler, 10.0f, 60.0f, 19.0f, 60.0f, 5.0f));
+		CHECK(!IsVisible(culler, 10.0f, 60.0f, 20.0f, 60.0f, 5.0f));
+
+		//a sphere half behind it
+		CHECK(culler.IsVisible(dx::XMFLOAT3{ 0.0f,-1.0f,10.0f }, 0.5f));
+		CHECK(!culler.IsVisible(dx::XMFLOAT3{ -3.0f,-2.0f,10.0f }, 0.5f));
+	}
+
+	void TestNearPlane() {
+
+		OcclusionCuller culler(width, height);
+		culler.Begin(ScreenViewProj());
+
+		//a floor from behind the camera into the distance, its triangles are clipped where they cross the near plane
+		culler.AddOccluder(OccluderMesh::MakeBox(), BoxWorld({ -50.0f,-1.1f,-5.0f }, { 50.0f,-1.0f,50.0f }));
+		culler.Rasterize();
+
+		CHECK(culler.GetStats().drawnTriangles >= 2u);
+
+		//under the floor, rows 52 to 61 where the floor is at most 4 away
+		CHECK(!culler.IsVisible(dx::XMFLOAT3{ -0.5f,-2.8f,6.0f }, dx::XMFLOAT3{ 0.5f,-2.2f,7.0f }));
+		//above it
+		CHECK(culler.IsVisible(dx::XMFLOAT3{ -0.5f,-0.8f,6.0f }, dx::XMFLOAT3{ 0.5f,-0.2f,7.0f }));
+
+		//the floor covers the bottom rows, the last tile row no farther than its top row (about 2.7 away)
+		std::vector<float> depth;
+		culler.ResolveDepth(depth);
+
+		CHECK(depth[(size_t)(height - 1u) * width + width / 2u] > 0.35f);
+		CHECK(depth[(size_t)(height / 4u) * width + width / 2u] == 0.0f);
+
+		//boxes across the near plane or behind the camera are always visible, even behind a wall
+		OcclusionCuller wall(width, height);
+		wall.Begin(ScreenViewProj());
+		AddWall(wall, -10.0f, 138.0f, -10.0f, 74.0f, 2.0f);
+		wall.Rasterize();
+
+		CHECK(wall.IsVisible(dx::XMFLOAT3{ -0.1f,-0.1f,0.5f }, dx::XMFLOAT3{ 0.1f,0.1f,5.0f }));
+		CHECK(wall.IsVisible(dx::XMFLOAT3{ -0.1f,-0.1f,-5.0f }, dx::XMFLOAT3{ 0.1f,0.1f,-4.0f }));
+		CHECK(!wall.IsVisible(dx::XMFLOAT3{ -0.1f,-0.1f,3.0f }, dx::XMFLOAT3{ 0.1f,0.1f,5.0f }));
+
+		//a wall crossing the near plane still hides what's behind the part in front of the camera
+		OcclusionCuller side(width, height);
+		side.Begin(ScreenViewProj());
+		side.AddOccluder(OccluderMesh::MakeBox(), BoxWorld({ -20.0f,-10.0f,-1.0f }, { -0.5f,10.0f,6.0f }));
+		side.Rasterize();
+
+		CHECK(!side.IsVisible(dx::XMFLOAT3{ -2.2f,-0.2f,9.8f }, dx::XMFLOAT3{ -1.8f,0.2f,10.2f }));
+		CHECK(side.IsVisible(dx::XMFLOAT3{ 1.8f,-0.2f,9.8f }, dx::XMFLOAT3{ 2.2f,0.2f,10.2f }));
+	}
+
+	//coverage ends exactly where a wall does, on a tile edge or inside a tile, and walls meeting add up
+	void TestTileEdges() {
+
+		OcclusionCuller culler(width, height);
+
+		//the first tile column
+		culler.Begin(ScreenViewProj());
+		AddWall(culler, -10.0f, 32.0f, -10.0f, 74.0f, 2.0f);
+		culler.Rasterize();
+
+		CHECK(!IsVisible(culler, 0.0f, 32.0f, 2.0f, 60.0f, 4.0f));
+		CHECK(IsVisible(culler, 28.0f, 33.0f, 2.0f, 60.0f, 4.0f));
+
+		//two walls meeting inside the second tile column, the same depth and then different ones
+		culler.Begin(ScreenViewProj());
+		AddWall(culler, -10.0f, 40.0f, -10.0f, 74.0f, 2.0f);
+		AddWall(culler, 40.0f, 70.0f, -10.0f, 74.0f, 2.0f);
+		culler.Rasterize();
+
+		CHECK(!IsVisible(culler, 30.0f, 50.0f, 2.0f, 60.0f, 4.0f));
+		CHECK(!IsVisible(culler, 0.0f, 70.0f, 2.0f, 60.0f, 4.0f));
+		CHECK(IsVisible(culler, 36.0f, 71.0f, 2.0f, 60.0f, 4.0f));
+
+		culler.Begin(ScreenViewProj());
+		AddWall(culler, -10.0f, 40.0f, -10.0f, 74.0f, 2.0f);
+		AddWall(culler, 40.0f, 70.0f, -10.0f, 74.0f, 3.0f);
+		culler.Rasterize();
+
+		CHECK(!IsVisible(culler, 36.0f, 44.0f, 2.0f, 60.0f, 4.0f));
+		CHECK(IsVisible(culler, 36.0f, 44.0f, 2.0f, 60.0f, 2.5f));
+
+		//rows, on the edge of a tile row and past it
+		culler.Begin(ScreenViewProj());
+		AddWall(culler, -10.0f, 138.0f, -10.0f, 8.0f, 2.0f);
+		culler.Rasterize();
+
+		CHECK(!IsVisible(culler, 10.0f, 20.0f, 0.0f, 8.0f, 4.0f));
+		CHECK(IsVisible(culler, 10.0f, 20.0f, 4.0f, 9.0f, 4.0f));
+
+		culler.Begin(ScreenViewProj());
+		AddWall(culler, -10.0f, 138.0f, -10.0f, 12.0f, 2.0f);
+		culler.Rasterize();
+
+		CHECK(!IsVisible(culler, 10.0f, 20.0f, 4.0f, 12.0f, 4.0f));
+		CHECK(IsVisible(culler, 10.0f, 20.0f, 4.0f, 13.0f, 4.0f));
+
+		//four tiles around the corner at (32,8), then with the one down and to the right left open
+		culler.Begin(ScreenViewProj());
+		AddWall(culler, -10.0f, 138.0f, -10.0f, 74.0f, 2.0f);
+		culler.Rasterize();
+
+		CHECK(!IsVisible(culler, 28.0f, 36.0f, 4.0f, 12.0f, 4.0f));
+
+		culler.Begin(ScreenViewProj());
+		AddWall(culler, -10.0f, 138.0f, -10.0f, 8.0f, 2.0f);
+		AddWall(culler, -10.0f, 32.0f, 8.0f, 74.0f, 2.0f);
+		culler.Rasterize();
+
+		CHECK(!IsVisible(culler, 28.0f, 36.0f, 4.0f, 8.0f, 4.0f));
+		CHECK(!IsVisible(culler, 28.0f, 32.0f, 4.0f, 12.0f, 4.0f));
+		CHECK(IsVisible(culler, 28.0f, 36.0f, 4.0f, 12.0f, 4.0f));
+		CHECK(IsVisible(culler, 32.0f, 33.0f, 8.0f, 9.0f, 4.0f));
+	}
+
+	//random walls and boxes, every coverage level and any split of the tile rows agree
+	void TestLevelsAndRows() {
+
+		std::mt19937 rng(5u);
+		std::uniform_real_distribution<float> px(-20.0f, 148.0f);
+		std::uniform_real_distribution<float> py(-10.0f, 74.0f);
+		std::uniform_real_distribution<float> pz(1.5f, 20.0f);
+
+		std::vector<std::array<float, 5>> walls(60);
+
+		for (auto& wall : walls) {
+
+			const auto [left, right] = std::minmax(px(rng), px(rng));
+			const auto [top, bottom] = std::minmax(py(rng), py(rng));
+			wall = { left,right,top,bottom,pz(rng) };
+		}
+
+		std::vector<float> reference;
+		std::vector<bool> referenceVisible;
+
+		for (const auto isa : { PixelKernels::Isa::Scalar,PixelKernels::Isa::Sse2,PixelKernels::Isa::Avx2 }) {
+
+			if (isa > PixelKernels::GetSupportedIsa()) {
+
+				continue;
+			}
+
+			for (const size_t rowsPerRange : { 1u,3u,8u }) {
+
+				OcclusionCuller culler(width, height);
+				culler.SetIsa(isa);
+				CHECK(culler.GetIsa() == isa);
+
+				culler.Begin(ScreenViewProj());
+
+				for (const auto& wall : walls) {
+
+					AddWall(culler, wall[0], wall[1], wall[2], wall[3], wall[4]);
+				}
+
+				for (size_t row = 0; row < culler.GetTileRowCount(); row += rowsPerRange) {
+
+					culler.Rasterize(row, row + rowsPerRange);
+				}
+
+				std::vector<float> depth;
+				culler.ResolveDepth(depth);
+
+				std::vector<bool> visible;
+				std::mt19937 boxRng(9u);
+
+				for (int i = 0; i < 2000; i++) {
+
+					const float x = std::uniform_real_distribution<float>(-10.0f, 10.0f)(boxRng);
+					const float y = std::uniform_real_distribution<float>(-5.0f, 5.0f)(boxRng);
+					const float z = std::uniform_real_distribution<float>(2.0f, 30.0f)(boxRng);
+					const float r = std::uniform_real_distribution<float>(0.05f, 1.0f)(boxRng);
+
+					visible.push_back(culler.IsVisible(dx::XMFLOAT3{ x,y,z }, r));
+				}
+
+				if (reference.empty()) {
+
+					reference = depth;
+					referenceVisible = visible;
+
+					//the walls hide some of the boxes but not all of them
+					CHECK(std::count(visible.begin(), visible.end(), false) > 100);
+					CHECK(std::count(visible.begin(), visible.end(), true) > 100);
+				}
+				else {
+
+					CHECK(depth == reference);
+					CHECK(visible == referenceVisible);
+				}
+			}
+		}
+	}
+
+	template<typename F>
+	bool ThrowsCullerException(F&& func) {
+
+		try {
+
+			func();
+		}
+		catch (const OcclusionCuller::Exception&) {
+
+			return true;
+		}
+
+		return false;
+	}
+
+	void TestErrors() {
+
+		CHECK(ThrowsCullerException([]() { OcclusionCuller culler(100u, 64u); }));
+		CHECK(ThrowsCullerException([]() { OcclusionCuller culler(128u, 60u); }));
+		CHECK(ThrowsCullerException([]() { OcclusionCuller culler(0u, 64u); }));
+
+		OcclusionCuller culler(width, height);
+		CHECK(ThrowsCullerException([&]() { culler.Resize(width, 4u); }));
+
+		culler.Resize(64u, 16u);
+		CHECK(culler.GetWidth() == 64u && culler.GetHeight() == 16u && culler.GetTileRowCount() == 2u);
+
+		culler.Begin(ScreenViewProj());
+		CHECK(ThrowsCullerException([&]() { culler.AddOccluder({ { { 0.0f,0.0f,1.0f } },{ 0u,0u } }, RenderScene::Identity()); }));
+		CHECK(ThrowsCullerException([&]() { culler.AddOccluder({ { { 0.0f,0.0f,1.0f } },{ 0u,0u,1u } }, RenderScene::Identity()); }));
+
+		const std::vector<dx::XMFLOAT3> vertices = { { 0.0f,0.0f,0.0f },{ 1.0f,0.0f,0.0f },{ 0.0f,1.0f,0.0f } };
+
+		CHECK(ThrowsCullerException([&]() { OccluderMesh::Simplify(vertices, { 0u,1u,2u }, 0u); }));
+		CHECK(ThrowsCullerException([&]() { OccluderMesh::Simplify(vertices, { 0u,1u }, 8u); }));
+		CHECK(ThrowsCullerException([&]() { OccluderMesh::Simplify(vertices, { 0u,1u,3u }, 8u); }));
+	}
+
+
+	/// simplified occluders against their sources, drawn with a plain per pixel rasterizer that samples pixel centers like the culler
+
+	OccluderMesh ToOccluder(const SoftwareRenderer::Mesh& mesh, const dx::XMFLOAT3& offset = { 0.0f,0.0f,0.0f }) {
+
+		OccluderMesh occluder;
+
+		for (const auto& p : mesh.positions) {
+
+			occluder.vertices.push_back({ p.x + offset.x,p.y + offset.y,p.z + offset.z });
+		}
+
+		occluder.indices.assign(mesh.indices.begin(), mesh.indices.end());
+
+		return occluder;
+	}
+
+	void Append(OccluderMesh& mesh, const OccluderMesh& other) {
+
+		const auto first = (uint32_t)mesh.vertices.size();
+
+		mesh.vertices.insert(mesh.vertices.end(), other.vertices.begin(), other.vertices.end());
+
+		for (const uint32_t index : other.indices) {
+
+			mesh.indices.push_back(first + index);
+		}
+	}
+
+	//a box with divisions x divisions quads on every face
+	OccluderMesh MakeTessellatedBox(const dx::XMFLOAT3& min, const dx::XMFLOAT3& max, unsigned int divisions) {
+
+		OccluderMesh mesh;
+		const float lo[3] = { min.x,min.y,min.z };
+		const float hi[3] = { max.x,max.y,max.z };
+
+		for (int a = 0; a < 3; a++) {
+
+			const int u = (a + 1) % 3;
+			const int v = (a + 2) % 3;
+
+			for (const int side : { -1,1 }) {
+
+				const auto first = (uint32_t)mesh.vertices.size();
+
+				for (unsigned int j = 0; j <= divisions; j++) {
+
+					for (unsigned int i = 0; i <= divisions; i++) {
+
+						float p[3];
+						p[a] = side > 0 ? hi[a] : lo[a];
+						p[u] = lo[u] + (hi[u] - lo[u]) * i / divisions;
+						p[v] = lo[v] + (hi[v] - lo[v]) * j / divisions;
+
+						mesh.vertices.push_back({ p[0],p[1],p[2] });
+					}
+				}
+
+				for (unsigned int j = 0; j < divisions; j++) {
+
+					for (unsigned int i = 0; i < divisions; i++) {
+
+						const uint32_t i0 = first + j * (divisions + 1u) + i;
+						const uint32_t i1 = i0 + 1u;
+						const uint32_t i2 = i1 + divisions + 1u;
+						const uint32_t i3 = i0 + divisions + 1u;
+
+						//u then v is clockwise from the side the axis points to, like MakeBox
+						if (side > 0) {
+
+							mesh.indices.insert(mesh.indices.end(), { i0,i1,i2,i0,i2,i3 });
+						}
+						else {
+
+							mesh.indices.insert(mesh.indices.end(), { i0,i2,i1,i0,i3,i2 });
+						}
+					}
+				}
+			}
+		}
+
+		return mesh;
+	}
+
+	OccluderMesh MakeTorus(float radius, float tube, unsigned int rings, unsigned int segments) {
+
+		OccluderMesh mesh;
+
+		for (unsigned int r = 0; r < rings; r++) {
+
+			const double theta = 2.0 * pi * r / rings;
+
+			for (unsigned int s = 0; s < segments; s++) {
+
+				const double phi = 2.0 * pi * s / segments;
+				const double distance = radius + tube * std::cos(phi);
+
+				mesh.vertices.push_back({ (float)(distance * std::cos(theta)),(float)(tube * std::sin(phi)),(float)(distance * std::sin(theta)) });
+			}
+		}
+
+		for (unsigned int r = 0; r < rings; r++) {
+
+			for (unsigned int s = 0; s < segments; s++) {
+
+				const uint32_t i0 = r * segments + s;
+				const uint32_t i1 = ((r + 1u) % rings) * segments + s;
+				const uint32_t i2 = ((r + 1u) % rings) * segments + (s + 1u) % segments;
+				const uint32_t i3 = r * segments + (s + 1u) % segments;
+
+				mesh.indices.insert(mesh.indices.end(), { i0,i3,i2,i0,i2,i1 });
+			}
+		}
+
+		return mesh;
+	}
+
+	//nearest 1/w of the front faces at every pixel center, 0 where nothing covers it
+	std::vector<double> Raster(const OccluderMesh& mesh, const dx::XMFLOAT4X4& viewProj, unsigned int w, unsigned int h) {
+
+		std::vector<double> depth((size_t)w * h, 0.0);
+
+		struct Vertex {
+
+			double x;
+			double y;
+			double z;
+		};
+
+		std::vector<Vertex> screen;
+
+		for (const auto& p : mesh.vertices) {
+
+			double clip[4];
+
+			for (int c = 0; c < 4; c++) {
+
+				clip[c] = p.x * viewProj.m[0][c] + p.y * viewProj.m[1][c] + p.z * viewProj.m[2][c] + viewProj.m[3][c];
+			}
+
+			screen.push_back({ (clip[0] / clip[3] * 0.5 + 0.5) * w,(0.5 - clip[1] / clip[3] * 0.5) * h,1.0 / clip[3] });
+		}
+
+		for (size_t i = 0; i < mesh.indices.size(); i += 3u) {
+
+			const auto& a = screen[mesh.indices[i]];
+			const auto& b = screen[mesh.indices[i + 1u]];
+			const auto& c = screen[mesh.indices[i + 2u]];
+
+			//clockwise on screen faces the camera
+			const double area = (b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y);
+
+			if (!(area > 0.0)) {
+
+				continue;
+			}
+
+			const int x0 = std::max((int)std::floor(std::min({ a.x,b.x,c.x })), 0);
+			const int x1 = std::min((int)std::ceil(std::max({ a.x,b.x,c.x })), (int)w - 1);
+			const int y0 = std::max((int)std::floor(std::min({ a.y,b.y,c.y })), 0);
+			const int y1 = std::min((int)std::ceil(std::max({ a.y,b.y,c.y })), (int)h - 1);
+
+			for (int y = y0; y <= y1; y++) {
+
+				for (int x = x0; x <= x1; x++) {
+
+					const double px = x + 0.5;
+					const double py = y + 0.5;
+
+					const double wa = ((b.x - px) * (c.y - py) - (c.x - px) * (b.y - py)) / area;
+					const double wb = ((c.x - px) * (a.y - py) - (a.x - px) * (c.y - py)) / area;
+					const double wc = 1.0 - wa - wb;
+
+					if (wa >= -1e-9 && wb >= -1e-9 && wc >= -1e-9) {
+
+						auto& d = depth[(size_t)y * w + x];
+						d = std::max(d, wa * a.z + wb * b.z + wc * c.z);
+					}
+				}
+			}
+		}
+
+		return depth;
+	}
+
+	struct Containment {
+
+		bool isInside = true;
+		size_t nSource = 0u;
+		size_t nOccluder = 0u;
+	};
+
+	//from all around the mesh, every pixel the occluder covers the source covers too, at least as near
+	Containment CheckContainment(const OccluderMesh& source, const OccluderMesh& occluder, float distance) {
+
+		constexpr unsigned int size = 256u;
+		const auto projection = RenderScene::PerspectiveLH(1.0f, 1.0f, 0.5f, 100.0f);
+
+		const dx::XMFLOAT3 directions[] = {
+			{ 1.0f,0.0f,0.0f },{ -1.0f,0.0f,0.0f },{ 0.0f,1.0f,0.0f },{ 0.0f,-1.0f,0.0f },{ 0.0f,0.0f,1.0f },{ 0.0f,0.0f,-1.0f },
+			{ 1.0f,1.0f,1.0f },{ -1.0f,0.5f,2.0f },{ 0.3f,-1.0f,-0.6f },{ 0.05f,0.2f,-1.0f },
+		};
+
+		Containment result;
+
+		for (const auto& direction : directions) {
+
+			const auto d = RenderScene::Normalize(direction);
+			const dx::XMFLOAT3 eye = { d.x * distance,d.y * distance,d.z * distance };
+			const dx::XMFLOAT3 up = std::abs(d.y) > 0.9f ? dx::XMFLOAT3{ 0.0f,0.0f,1.0f } : dx::XMFLOAT3{ 0.0f,1.0f,0.0f };
+			const auto viewProj = Multiply(RenderScene::LookAtLH(eye, { 0.0f,0.0f,0.0f }, up), projection);
+
+			const auto sourceDepth = Raster(source, viewProj, size, size);
+			const auto occluderDepth = Raster(occluder, viewProj, size, size);
+
+			for (size_t i = 0; i < sourceDepth.size(); i++) {
+
+				result.nSource += sourceDepth[i] > 0.0 ? 1u : 0u;
+				result.nOccluder += occluderDepth[i] > 0.0 ? 1u : 0u;
+				result.isInside &= occluderDepth[i] <= sourceDepth[i] * (1.0 + 1e-6);
+			}
+		}
+
+		return result;
+	}
+
+	void TestSimplifyContained() {
+
+		constexpr unsigned int cells = 24u;
+
+		auto sphere = ToOccluder(RenderScene::MakeSphere(1.0f, 24u, 48u));
+		auto torus = MakeTorus(1.0f, 0.35f, 64u, 24u);
+
+		//two blocks a small part of a cell apart, gathering vertices into cells would close the gap
+		auto blocks = MakeTessellatedBox({ -1.025f,-1.0f,-1.0f }, { -0.025f,1.0f,1.0f }, 6u);
+		Append(blocks, MakeTessellatedBox({ 0.025f,-1.0f,-1.0f }, { 1.025f,1.0f,1.0f }, 6u));
+
+		//a box rotated off the grid, a sphere inside a torus, and the torus and blocks together
+		auto turned = MakeTessellatedBox({ -0.8f,-0.3f,-0.5f }, { 0.8f,0.3f,0.5f }, 8u);
+
+		for (auto& v : turned.vertices) {
+
+			const float c = std::cos(0.5f);
+			const float s = std::sin(0.5f);
+			v = { c * v.x - s * v.y,s * v.x + c * v.y,v.z };
+		}
+
+		auto ringed = ToOccluder(RenderScene::MakeSphere(0.5f, 16u, 32u));
+		Append(ringed, torus);
+
+		for (const OccluderMesh* pSource : { &sphere,&torus,&blocks,&turned,&ringed }) {
+
+			const auto occluder = OccluderMesh::Simplify(pSource->vertices, pSource->indices, cells);
+			const auto containment = CheckContainment(*pSource, occluder, 4.0f);
+
+			CHECK(containment.isInside);
+			CHECK(occluder.GetTriangleCount() < pSource->GetTriangleCount());
+			//still worth drawing, it covers most of what the source does
+			CHECK(containment.nOccluder * 2u > containment.nSource);
+		}
+
+		//a tube thinner than a cell has no solid cells, so nothing
+		const auto thin = MakeTorus(1.0f, 0.02f, 64u, 12u);
+		CHECK(OccluderMesh::Simplify(thin.vertices, thin.indices, cells).IsEmpty());
+	}
+
+	void TestSimplifyShapes() {
+
+		//a few triangles are their own occluder
+		const auto box = OccluderMesh::MakeBox();
+		const auto same = OccluderMesh::Simplify(box.vertices, box.indices, 16u);
+
+		CHECK(same.indices == box.indices);
+		CHECK(same.GetTriangleCount() == 12u);
+
+		//a tessellated box on the grid comes back as a box of 12 triangles, one cell in on every side
+		const auto block = MakeTessellatedBox({ 0.0f,0.0f,0.0f }, { 8.0f,8.0f,8.0f }, 8u);
+		const auto simplified = OccluderMesh::Simplify(block.vertices, block.indices, 8u);
+
+		CHECK(simplified.GetTriangleCount() == 12u);
+		CHECK(simplified.vertices.size() == 8u);
+		CHECK(std::all_of(simplified.vertices.begin(), simplified.vertices.end(), [](const dx::XMFLOAT3& v) {
+
+			return (v.x == 1.0f || v.x == 7.0f) && (v.y == 1.0f || v.y == 7.0f) && (v.z == 1.0f || v.z == 7.0f);
+		}));
+
+		//facing out, the same way as the source from every side
+		CHECK(CheckContainment(block, simplified, 30.0f).isInside);
+
+		//an open surface has no inside
+		auto plane = MakeTessellatedBox({ -1.0f,-1.0f,-1.0f }, { 1.0f,1.0f,1.0f }, 8u);
+		plane.indices.resize(plane.indices.size() / 6u);
+		CHECK(OccluderMesh::Simplify(plane.vertices, plane.indices, 16u).IsEmpty());
+
+		//nothing in, nothing out, and a mesh without any extent
+		CHECK(OccluderMesh::Simplify({}, {}, 16u).IsEmpty());
+
+		std::vector<uint32_t> indices(300u, 0u);
+		CHECK(OccluderMesh::Simplify({ { 1.0f,2.0f,3.0f } }, indices, 16u).IsEmpty());
+	}
+
+	//the simplified sphere in the culler still hides what's right behind it, and only that
+	void TestSimplifiedOccludes() {
+
+		const auto sphere = ToOccluder(RenderScene::MakeSphere(1.0f, 24u, 48u));
+		const auto occluder = OccluderMesh::Simplify(sphere.vertices, sphere.indices, 32u);
+
+		OcclusionCuller culler(width, height);
+		culler.Begin(ScreenViewProj());
+		culler.AddOccluder(occluder, RenderScene::Translation(0.0f, 0.0f, 4.0f));
+		culler.Rasterize();
+
+		CHECK(culler.GetStats().drawnTriangles > 0u);
+		CHECK(!culler.IsVisible(dx::XMFLOAT3{ 0.0f,0.0f,8.0f }, 0.5f));
+		CHECK(culler.IsVisible(dx::XMFLOAT3{ 0.0f,0.0f,4.0f }, 1.2f));
+		CHECK(culler.IsVisible(dx::XMFLOAT3{ 3.0f,0.0f,8.0f }, 0.5f));
+	}
+}
+
+int main()
+{
+	Test::Run("fully hidden", TestFullyHidden);
+	Test::Run("partly visible", TestPartlyVisible);
+	Test::Run("near plane", TestNearPlane);
+	Test::Run("tile edges", TestTileEdges);
+	Test::Run("levels and rows", TestLevelsAndRows);
+	Test::Run("errors", TestErrors);
+	Test::Run("simplify contained", TestSimplifyContained);
+	Test::Run("simplify shapes", TestSimplifyShapes);
+	Test::Run("simplified occludes", TestSimplifiedOccludes);
+
+	return Test::Finish();
+}
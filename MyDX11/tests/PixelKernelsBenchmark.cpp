@@ -0,0 +1,94 @@
+#include "PixelKernels.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+
+namespace {
+
+	using Clock = std::chrono::steady_clock;
+
+	template<typename F>
+	double TimeMs(int nRounds, F&& func)
+	{
+		const auto start = Clock::now();
+
+		for (int round = 0; round < nRounds; round++) {
+
+			func();
+		}
+
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count() / nRounds;
+	}
+}
+
+//every kernel on a 2048x2048 image at every level this machine runs, in millions of texels per second
+//(of the destination for the resamples), on one thread
+//usage: PixelKernelsBenchmark [rounds]
+int main(int argc, char* argv[])
+{
+	const int nRounds = argc > 1 ? std::max(1, std::atoi(argv[1])) : 10;
+
+	constexpr unsigned int size = 2048u;
+	constexpr size_t nTexels = (size_t)size * size;
+
+	std::vector<uint32_t> src(nTexels);
+	std::vector<uint32_t> dst(nTexels);
+	std::vector<float> linear(nTexels * 4u);
+	std::mt19937 rng(1u);
+
+	for (auto& texel : src) {
+
+		texel = rng();
+	}
+
+	const PixelKernels::ConstImage from(src.data(), size, size, size);
+	const PixelKernels::Image to(dst.data(), size, size, size);
+
+	const PixelKernels::Resampler down(size, size, size / 2u, size / 2u, PixelKernels::Filter::Lanczos3, true);
+	const PixelKernels::Resampler up(size / 2u, size / 2u, size, size, PixelKernels::Filter::Mitchell, true);
+
+	std::cout << std::fixed << std::setprecision(2) << nRounds << " rounds of " << size << "x" << size << std::endl;
+
+	for (const auto isa : { PixelKernels::Isa::Scalar,PixelKernels::Isa::Sse2,PixelKernels::Isa::Avx2 }) {
+
+		if (isa > PixelKernels::GetSupportedIsa()) {
+
+			continue;
+		}
+
+		PixelKernels::SetIsa(isa);
+
+		const auto rate = [&](double ms, size_t count) { return count / (ms * 1000.0); };
+
+		const double fillMs = TimeMs(nRounds, [&]() { PixelKernels::Fill(to, 0xFF808080u); });
+		const double blitMs = TimeMs(nRounds, [&]() { PixelKernels::Blit(from, to); });
+		const double swizzleMs = TimeMs(nRounds, [&]() { PixelKernels::SwizzleRB(from, to); });
+		const double toLinearMs = TimeMs(nRounds, [&]() { PixelKernels::ToLinear(from, linear.data(), (size_t)size * 4u, true); });
+		const double fromLinearMs = TimeMs(nRounds, [&]() { PixelKernels::FromLinear(linear.data(), (size_t)size * 4u, to, true); });
+		const double premultiplyMs = TimeMs(nRounds, [&]() {
+
+			PixelKernels::Blit(from, to);
+			PixelKernels::Premultiply(to, true);
+		}) - blitMs;
+		const double downMs = TimeMs(nRounds, [&]() { down.Run(from, PixelKernels::Image(dst.data(), size / 2u, size / 2u, size / 2u), 0u, size / 2u); });
+		const double upMs = TimeMs(nRounds, [&]() { up.Run(PixelKernels::ConstImage(src.data(), size / 2u, size / 2u, size / 2u), to, 0u, size); });
+
+		std::cout << std::setw(6) << PixelKernels::GetIsaName(isa)
+			<< ": fill " << rate(fillMs, nTexels)
+			<< ", blit " << rate(blitMs, nTexels)
+			<< ", swizzle " << rate(swizzleMs, nTexels)
+			<< ", to linear " << rate(toLinearMs, nTexels)
+			<< ", from linear " << rate(fromLinearMs, nTexels)
+			<< ", premultiply " << rate(premultiplyMs, nTexels)
+			<< ", lanczos down " << rate(downMs, nTexels / 4u)
+			<< ", mitchell up " << rate(upMs, nTexels) << " Mtexels/s" << std::endl;
+	}
+
+	PixelKernels::SetIsa(PixelKernels::GetSupportedIsa());
+
+	return 0;
+}
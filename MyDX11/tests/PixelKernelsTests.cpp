@@ -0,0 +1,395 @@
+#include "TestCheck.h"
+#include "PixelKernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <vector>
+
+namespace {
+
+	using Isa = PixelKernels::Isa;
+
+	//widths around every vector width so the scalar tails run too, each in a buffer with a wider pitch
+	//and a guard value around it, so writes outside the image show up
+	constexpr unsigned int widths[] = { 1u,2u,3u,4u,5u,7u,8u,9u,15u,16u,17u,31u,33u,64u,67u };
+	constexpr unsigned int height = 5u;
+	constexpr unsigned int padding = 3u;
+	constexpr uint32_t guard = 0xDEADBEEFu;
+
+	struct Buffer {
+
+		explicit Buffer(unsigned int width)
+			:
+			width(width),
+			texels((size_t)(width + padding) * height, guard)
+		{}
+
+		PixelKernels::Image GetImage() noexcept
+		{
+			return PixelKernels::Image(texels.data(), width + padding, width, height);
+		}
+
+		bool IsGuardIntact() const noexcept
+		{
+			for (unsigned int y = 0; y < height; y++) {
+
+				for (unsigned int x = width; x < width + padding; x++) {
+
+					if (texels[y * (width + padding) + x] != guard) {
+
+						return false;
+					}
+				}
+			}
+
+			return true;
+		}
+
+		unsigned int width;
+		std::vector<uint32_t> texels;
+	};
+
+	Buffer RandomBuffer(unsigned int width, std::mt19937& rng) {
+
+		Buffer buffer(width);
+
+		for (unsigned int y = 0; y < height; y++) {
+
+			for (unsigned int x = 0; x < width; x++) {
+
+				//a few texels at the alpha extremes, premultiply and unpremultiply treat those specially
+				const uint32_t texel = rng();
+				const unsigned int pick = rng() % 8u;
+
+				buffer.texels[y * (width + padding) + x] = pick == 0u ? texel & 0x00FFFFFFu : pick == 1u ? texel | 0xFF000000u : texel;
+			}
+		}
+
+		return buffer;
+	}
+
+	//runs the same kernel at every level this machine has and hands back each level's output next to the scalar one
+	template<typename F>
+	void ForEachIsa(F&& run) {
+
+		for (const Isa isa : { Isa::Sse2,Isa::Avx2 }) {
+
+			if (isa > PixelKernels::GetSupportedIsa()) {
+
+				continue;
+			}
+
+			run(isa);
+		}
+
+		PixelKernels::SetIsa(PixelKernels::GetSupportedIsa());
+	}
+
+	template<typename T>
+	T RunAt(Isa isa, const std::function<T()>& kernel) {
+
+		PixelKernels::SetIsa(isa);
+		return kernel();
+	}
+
+	//largest difference of any byte of two texel arrays
+	int MaxByteDifference(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
+
+		int largest = a.size() == b.size() ? 0 : 256;
+
+		for (size_t i = 0; i < std::min(a.size(), b.size()); i++) {
+
+			for (unsigned int shift = 0; shift < 32u; shift += 8u) {
+
+				largest = std::max(largest, std::abs((int)((a[i] >> shift) & 0xFFu) - (int)((b[i] >> shift) & 0xFFu)));
+			}
+		}
+
+		return largest;
+	}
+
+	void TestLevels() {
+
+		CHECK(PixelKernels::GetSupportedIsa() >= Isa::Sse2);
+
+		//clamped to what the machine runs
+		PixelKernels::SetIsa(Isa::Avx2);
+		CHECK(PixelKernels::GetIsa() == PixelKernels::GetSupportedIsa());
+
+		PixelKernels::SetIsa(Isa::Scalar);
+		CHECK(PixelKernels::GetIsa() == Isa::Scalar);
+
+		PixelKernels::SetIsa(PixelKernels::GetSupportedIsa());
+	}
+
+	//bit exact at every level, and nothing written past the image's width
+	void TestFillBlitSwizzle() {
+
+		std::mt19937 rng(3u);
+
+		for (const unsigned int width : widths) {
+
+			const Buffer source = RandomBuffer(width, rng);
+
+			const std::function<std::vector<uint32_t>()> fill = [&]() {
+
+				Buffer buffer = source;
+				PixelKernels::Fill(buffer.GetImage().Crop(1u, 1u, width, height - 2u), 0x80402010u);
+				CHECK(buffer.IsGuardIntact());
+				return buffer.texels;
+			};
+
+			const std::function<std::vector<uint32_t>()> blit = [&]() {
+
+				Buffer buffer(width);
+				Buffer from = source;
+				PixelKernels::Blit(from.GetImage(), buffer.GetImage());
+				CHECK(buffer.IsGuardIntact());
+				return buffer.texels;
+			};
+
+			const std::function<std::vector<uint32_t>()> swizzle = [&]() {
+
+				//out of place, then back in place, which has to give the source again
+				Buffer buffer(width);
+				Buffer from = source;
+				PixelKernels::SwizzleRB(from.GetImage(), buffer.GetImage());
+				std::vector<uint32_t> texels = buffer.texels;
+
+				PixelKernels::SwizzleRB(buffer.GetImage(), buffer.GetImage());
+				CHECK(buffer.texels == source.texels);
+				CHECK(buffer.IsGuardIntact());
+
+				return texels;
+			};
+
+			const auto fillScalar = RunAt(Isa::Scalar, fill);
+			const auto blitScalar = RunAt(Isa::Scalar, blit);
+			const auto swizzleScalar = RunAt(Isa::Scalar, swizzle);
+
+			//the scalar versions against what they mean
+			bool isFilled = true;
+			bool isSwizzled = true;
+
+			for (unsigned int y = 0; y < height; y++) {
+
+				for (unsigned int x = 0; x < width; x++) {
+
+					const size_t i = y * (width + padding) + x;
+					const uint32_t t = source.texels[i];
+
+					isFilled &= fillScalar[i] == (x >= 1u && y >= 1u && y < height - 1u ? 0x80402010u : t);
+					isSwizzled &= swizzleScalar[i] == ((t & 0xFF00FF00u) | ((t >> 16) & 0xFFu) | ((t & 0xFFu) << 16));
+				}
+			}
+
+			CHECK(isFilled);
+			CHECK(isSwizzled);
+			CHECK(blitScalar == source.texels);
+
+			ForEachIsa([&](Isa isa) {
+
+				CHECK(RunAt(isa, fill) == fillScalar);
+				CHECK(RunAt(isa, blit) == blitScalar);
+				CHECK(RunAt(isa, swizzle) == swizzleScalar);
+			});
+		}
+	}
+
+	//texels to floats and back, with and without the sRGB curve, bit exact at every level
+	void TestLinear() {
+
+		std::mt19937 rng(5u);
+		std::uniform_real_distribution<float> value(-0.2f, 1.2f);
+
+		for (const unsigned int width : widths) {
+
+			const Buffer source = RandomBuffer(width, rng);
+			const size_t linearPitch = (size_t)(width + padding) * 4u;
+
+			//out of range values and alphas of exactly zero and one as well
+			std::vector<float> floats(linearPitch * height);
+
+			for (size_t i = 0; i < floats.size(); i++) {
+
+				const unsigned int pick = rng() % 16u;
+				floats[i] = pick == 0u ? 0.0f : pick == 1u ? 1.0f : value(rng);
+			}
+
+			for (const bool isSrgb : { false,true }) {
+
+				const std::function<std::vector<float>()> toLinear = [&]() {
+
+					std::vector<float> linear(linearPitch * height, -1.0f);
+					Buffer from = source;
+					PixelKernels::ToLinear(from.GetImage(), linear.data(), linearPitch, isSrgb);
+					return linear;
+				};
+
+				const std::function<std::vector<uint32_t>()> fromLinear = [&]() {
+
+					Buffer buffer(width);
+					PixelKernels::FromLinear(floats.data(), linearPitch, buffer.GetImage(), isSrgb);
+					CHECK(buffer.IsGuardIntact());
+					return buffer.texels;
+				};
+
+				const std::function<std::vector<uint32_t>()> premultiply = [&]() {
+
+					Buffer buffer = source;
+					PixelKernels::Premultiply(buffer.GetImage(), isSrgb);
+					CHECK(buffer.IsGuardIntact());
+					return buffer.texels;
+				};
+
+				const auto toLinearScalar = RunAt(Isa::Scalar, toLinear);
+				const auto fromLinearScalar = RunAt(Isa::Scalar, fromLinear);
+				const auto premultiplyScalar = RunAt(Isa::Scalar, premultiply);
+
+				//decoding then encoding gives every byte back
+				{
+					PixelKernels::SetIsa(Isa::Scalar);
+					Buffer back(width);
+					PixelKernels::FromLinear(toLinearScalar.data(), linearPitch, back.GetImage(), isSrgb);
+
+					bool isSame = true;
+
+					for (unsigned int y = 0; y < height; y++) {
+
+						for (unsigned int x = 0; x < width; x++) {
+
+							isSame &= back.texels[y * (width + padding) + x] == source.texels[y * (width + padding) + x];
+						}
+					}
+
+					CHECK(isSame);
+				}
+
+				ForEachIsa([&](Isa isa) {
+
+					CHECK(RunAt(isa, toLinear) == toLinearScalar);
+					CHECK(RunAt(isa, fromLinear) == fromLinearScalar);
+					CHECK(RunAt(isa, premultiply) == premultiplyScalar);
+				});
+			}
+		}
+
+		//a few values off the curve
+		PixelKernels::SetIsa(Isa::Scalar);
+
+		uint32_t texels[] = { 0xFF000000u,0xFFFFFFFFu,0xFFBCBCBCu,0x80FFFFFFu };
+		float linear[16];
+		PixelKernels::ToLinear(PixelKernels::ConstImage(texels, 4u, 4u, 1u), linear, 16u, true);
+
+		CHECK(linear[0] == 0.0f && linear[3] == 1.0f);
+		CHECK(linear[4] == 1.0f && linear[7] == 1.0f);
+		CHECK(std::abs(linear[8] - 0.5029f) < 1e-3f);
+		CHECK(std::abs(linear[15] - 128.0f / 255.0f) < 1e-6f);
+
+		//half coverage of white is half as bright in linear light, which is 188 in sRGB
+		PixelKernels::Premultiply(PixelKernels::Image(texels, 4u, 4u, 1u), true);
+		CHECK(texels[3] == 0x80BCBCBCu);
+
+		PixelKernels::SetIsa(PixelKernels::GetSupportedIsa());
+	}
+
+	//SSE2 adds the taps in the scalar order, AVX2 adds them two texels at a time so its sums round differently,
+	//which is allowed to move a channel by one level
+	void TestResample() {
+
+		std::mt19937 rng(7u);
+
+		const unsigned int sizes[][4] = {
+			{ 67u,33u,16u,9u },
+			{ 16u,9u,67u,33u },
+			{ 33u,33u,33u,33u },
+			{ 1u,1u,5u,3u },
+			{ 40u,7u,3u,17u },
+		};
+
+		for (const auto& size : sizes) {
+
+			std::vector<uint32_t> src((size_t)size[0] * size[1]);
+
+			for (auto& texel : src) {
+
+				texel = rng();
+			}
+
+			for (const auto filter : { PixelKernels::Filter::Lanczos3,PixelKernels::Filter::Mitchell }) {
+
+				for (const bool isSrgb : { false,true }) {
+
+					const PixelKernels::Resampler resampler(size[0], size[1], size[2], size[3], filter, isSrgb);
+					const PixelKernels::ConstImage from(src.data(), size[0], size[0], size[1]);
+
+					const std::function<std::vector<uint32_t>()> resample = [&]() {
+
+						std::vector<uint32_t> dst((size_t)size[2] * size[3], guard);
+						resampler.Run(from, PixelKernels::Image(dst.data(), size[2], size[2], size[3]), 0u, size[3]);
+						return dst;
+					};
+
+					//rows in independent ranges come out the same as all at once
+					const std::function<std::vector<uint32_t>()> resampleInRanges = [&]() {
+
+						std::vector<uint32_t> dst((size_t)size[2] * size[3], guard);
+						const PixelKernels::Image to(dst.data(), size[2], size[2], size[3]);
+
+						for (unsigned int first = 0; first < size[3]; first += 2u) {
+
+							resampler.Run(from, to, first, std::min(first + 2u, size[3]));
+						}
+
+						return dst;
+					};
+
+					const auto scalar = RunAt(Isa::Scalar, resample);
+
+					CHECK(std::find(scalar.begin(), scalar.end(), guard) == scalar.end());
+					CHECK(RunAt(Isa::Scalar, resampleInRanges) == scalar);
+
+					ForEachIsa([&](Isa isa) {
+
+						const auto result = RunAt(isa, resample);
+
+						if (isa == Isa::Sse2) {
+
+							CHECK(result == scalar);
+						}
+						else {
+
+							CHECK(MaxByteDifference(result, scalar) <= 1);
+						}
+
+						CHECK(RunAt(isa, resampleInRanges) == result);
+					});
+				}
+			}
+		}
+
+		//a flat image stays flat whatever the filter rings
+		PixelKernels::SetIsa(Isa::Scalar);
+
+		std::vector<uint32_t> flat(64u * 64u, 0xFF336699u);
+		std::vector<uint32_t> small(17u * 23u);
+		const PixelKernels::Resampler resampler(64u, 64u, 17u, 23u, PixelKernels::Filter::Lanczos3, true);
+		resampler.Run(PixelKernels::ConstImage(flat.data(), 64u, 64u, 64u), PixelKernels::Image(small.data(), 17u, 17u, 23u), 0u, 23u);
+
+		CHECK(MaxByteDifference(small, std::vector<uint32_t>(small.size(), 0xFF336699u)) <= 1);
+
+		PixelKernels::SetIsa(PixelKernels::GetSupportedIsa());
+	}
+}
+
+int main()
+{
+	Test::Run("levels", TestLevels);
+	Test::Run("fill, blit, swizzle", TestFillBlitSwizzle);
+	Test::Run("linear", TestLinear);
+	Test::Run("resample", TestResample);
+
+	return Test::Finish();
+}
@@ -0,0 +1,508 @@
+#include "TestCheck.h"
+#include "RenderGraph.h"
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+	using State = RenderGraph::State;
+	using LoadOp = RenderGraph::LoadOp;
+	constexpr size_t npos = RenderGraph::npos;
+
+	const RenderGraph::TextureDesc hdrDesc = { 1280u,720u,TextureFormat::R16G16B16A16Float };
+	const RenderGraph::TextureDesc halfDesc = { 640u,360u,TextureFormat::R16G16B16A16Float };
+	const RenderGraph::TextureDesc depthDesc = { 1280u,720u,TextureFormat::D32Float };
+	const RenderGraph::TextureDesc backBufferDesc = { 1280u,720u,TextureFormat::B8G8R8A8Unorm };
+
+	std::vector<std::string> GetStepNames(const RenderGraph& graph) {
+
+		std::vector<std::string> names;
+
+		for (const auto& step : graph.GetSteps()) {
+
+			names.push_back(graph.GetPasses()[step.pass].GetName());
+		}
+
+		return names;
+	}
+
+	std::string MakeName(char prefix, size_t index) {
+
+		std::string name(1u, prefix);
+		name += std::to_string(index);
+
+		return name;
+	}
+
+	template<typename F>
+	bool ThrowsGraphException(F&& func) {
+
+		try {
+
+			func();
+		}
+		catch (const RenderGraph::Exception&) {
+
+			return true;
+		}
+
+		return false;
+	}
+
+	//depth prepass, scene, a bloom chain, tonemap to the back buffer, a readback and the ui on top
+	//plus a debug view nothing reads, which goes
+	void TestFrame() {
+
+		int backBuffer = 0;
+		RenderGraph graph;
+
+		graph.ImportTexture("BackBuffer", backBufferDesc, &backBuffer);
+		graph.MarkOutput("BackBuffer");
+		graph.CreateTexture("Depth", depthDesc);
+		graph.CreateTexture("HDR", hdrDesc);
+		graph.CreateTexture("BloomA", halfDesc);
+		graph.CreateTexture("BloomB", halfDesc);
+		graph.CreateTexture("Tonemapped", hdrDesc);
+		graph.CreateTexture("Debug", hdrDesc);
+		graph.CreateTexture("Unused", hdrDesc);
+
+		graph.AddPass("Prepass").ClearDepth("Depth");
+		graph.AddPass("Debug").Clear("Debug", { 0.0f,0.0f,0.0f,0.0f }).Read("Depth");
+		graph.AddPass("Scene").Clear("HDR", { 0.0f,0.0f,0.0f,1.0f }).Write("Depth", State::DepthWrite);
+		graph.AddPass("BloomDown").Write("BloomA", State::RenderTarget, LoadOp::Discard).Read("HDR");
+		graph.AddPass("BloomBlur").Write("BloomB", State::RenderTarget, LoadOp::Discard).Read("BloomA");
+		graph.AddPass("Tonemap").Write("Tonemapped", State::RenderTarget, LoadOp::Discard).Read("HDR", State::ShaderResource, 0u).Read("BloomB", State::ShaderResource, 1u);
+		graph.AddPass("Final").Write("BackBuffer", State::RenderTarget, LoadOp::Discard).Read("Tonemapped");
+		graph.AddPass("Readback").Read("BackBuffer", State::CopySource).KeepAlive();
+		graph.AddPass("Imgui").Write("BackBuffer");
+
+		CHECK(!graph.IsCompiled());
+		graph.Compile();
+		CHECK(graph.IsCompiled());
+
+		CHECK(GetStepNames(graph) == (std::vector<std::string>{ "Prepass","Scene","BloomDown","BloomBlur","Tonemap","Final","Readback","Imgui" }));
+		CHECK(graph.IsCulled(1u));
+		CHECK(!graph.IsCulled(0u));
+
+		//lifetimes in steps, nothing for what no pass left uses
+		const auto& hdr = graph.GetResources()[graph.FindResource("HDR")];
+		CHECK(hdr.firstStep == 1u && hdr.lastStep == 4u);
+		CHECK(graph.GetResources()[graph.FindResource("Debug")].firstStep == npos);
+		CHECK(graph.GetResources()[graph.FindResource("Unused")].allocation == npos);
+		CHECK(graph.GetResources()[graph.FindResource("BackBuffer")].allocation == npos);
+		CHECK(graph.FindResource("Nothing") == npos);
+
+		//the tonemap binds its two inputs at their registers and clears nothing
+		const auto& tonemap = graph.GetSteps()[4];
+		CHECK(tonemap.shaderResources.size() == 2u);
+		CHECK(tonemap.shaderResources[1].slot == 1u && tonemap.shaderResources[1].resource == graph.FindResource("BloomB"));
+		CHECK(tonemap.clears.empty());
+		CHECK(tonemap.renderTargets == std::vector<size_t>{ graph.FindResource("Tonemapped") });
+
+		//the scene clears color and writes the depth the prepass cleared
+		const auto& scene = graph.GetSteps()[1];
+		CHECK(scene.clears.size() == 1u && scene.depthStencil == graph.FindResource("Depth") && !scene.isDepthReadOnly);
+
+		//the back buffer goes render target, copy source and back
+		const auto& imgui = graph.GetSteps()[7];
+		CHECK(imgui.transitions.size() == 1u);
+		CHECK(imgui.transitions[0].before == State::CopySource && imgui.transitions[0].after == State::RenderTarget);
+
+		CHECK(!graph.Describe().empty());
+
+		//adding a pass needs another compile
+		graph.AddPass("Late").Write("BackBuffer");
+		CHECK(!graph.IsCompiled());
+	}
+
+	//a ping pong chain of same sized targets fits in two textures, the handover starts from the old owner's state
+	void TestAliasing() {
+
+		int backBuffer = 0;
+		RenderGraph graph;
+
+		graph.ImportTexture("BackBuffer", backBufferDesc, &backBuffer);
+		graph.MarkOutput("BackBuffer");
+		graph.CreateTexture("Depth", depthDesc);
+		graph.CreateTexture("Scene", hdrDesc);
+
+		graph.AddPass("Scene").Clear("Scene", {}).ClearDepth("Depth");
+
+		for (int i = 0; i < 6; i++) {
+
+			const auto name = "Blur" + std::to_string(i);
+			graph.CreateTexture(name, hdrDesc);
+			graph.AddPass(name).Write(name, State::RenderTarget, LoadOp::Discard).Read(i == 0 ? "Scene" : "Blur" + std::to_string(i - 1));
+		}
+
+		graph.AddPass("Final").Write("BackBuffer", State::RenderTarget, LoadOp::Discard).Read("Blur5");
+		graph.Compile();
+
+		//depth is another format and never shares
+		CHECK(graph.GetAllocations().size() == 3u);
+
+		const size_t colorBytes = RenderGraph::GetTextureBytes(hdrDesc);
+		CHECK(colorBytes == 1280u * 720u * 8u);
+		CHECK(graph.GetTransientBytes() == 7u * colorBytes + RenderGraph::GetTextureBytes(depthDesc));
+		CHECK(graph.GetAllocatedBytes() == 2u * colorBytes + RenderGraph::GetTextureBytes(depthDesc));
+
+		const auto& scene = graph.GetResources()[graph.FindResource("Scene")];
+		const auto& blur1 = graph.GetResources()[graph.FindResource("Blur1")];
+		CHECK(scene.allocation == blur1.allocation);
+		CHECK(graph.GetAllocations()[scene.allocation].isRenderTarget && graph.GetAllocations()[scene.allocation].isShaderResource);
+
+		//Blur1 takes the texture over from Scene, which was last read
+		const auto& transitions = graph.GetSteps()[2].transitions;
+		CHECK(std::any_of(transitions.begin(), transitions.end(), [&graph](const RenderGraph::Transition& t) {
+
+			return t.resource == graph.FindResource("Blur1") && t.before == State::ShaderResource && t.after == State::RenderTarget;
+		}));
+	}
+
+	//of the passes that could go next, the one drawing to the same target goes first
+	void TestSameTargetsFirst() {
+
+		RenderGraph graph;
+		graph.CreateTexture("X", hdrDesc);
+		graph.CreateTexture("Y", hdrDesc);
+
+		graph.AddPass("A").Clear("X", {});
+		graph.AddPass("B").Clear("Y", {}).KeepAlive();
+		graph.AddPass("C").Write("X").KeepAlive();
+		graph.Compile();
+
+		CHECK(GetStepNames(graph) == (std::vector<std::string>{ "A","C","B" }));
+
+		//X is done before Y starts, so they share
+		CHECK(graph.GetAllocations().size() == 1u);
+	}
+
+	//a culled write between a read and a later write still keeps the read first
+	void TestCulledWriteKeepsOrder() {
+
+		RenderGraph graph;
+		graph.CreateTexture("X", hdrDesc);
+		graph.CreateTexture("Y", hdrDesc);
+
+		graph.AddPass("A").Clear("X", {});
+		graph.AddPass("B").Clear("Y", {}).Read("X").KeepAlive();
+		graph.AddPass("C").Clear("X", { 1.0f,1.0f,1.0f,1.0f });
+		graph.AddPass("D").Clear("X", { 0.5f,0.0f,0.0f,0.0f }).KeepAlive();
+		graph.Compile();
+
+		CHECK(graph.IsCulled(2u));
+		CHECK(GetStepNames(graph) == (std::vector<std::string>{ "A","B","D" }));
+	}
+
+	void TestErrors() {
+
+		//reading or loading what nothing wrote
+		CHECK(ThrowsGraphException([]() {
+
+			RenderGraph graph;
+			graph.CreateTexture("A", hdrDesc);
+			graph.AddPass("x").Read("A").KeepAlive();
+			graph.Compile();
+		}));
+
+		CHECK(ThrowsGraphException([]() {
+
+			RenderGraph graph;
+			graph.CreateTexture("A", hdrDesc);
+			graph.AddPass("x").Write("A").KeepAlive();
+			graph.Compile();
+		}));
+
+		//states that don't fit the call or the format, and a texture used twice by a pass
+		CHECK(ThrowsGraphException([]() {
+
+			RenderGraph graph;
+			graph.CreateTexture("A", hdrDesc);
+			graph.AddPass("x").Write("A", State::DepthWrite);
+		}));
+
+		CHECK(ThrowsGraphException([]() {
+
+			RenderGraph graph;
+			graph.CreateTexture("A", hdrDesc);
+			graph.AddPass("x").Read("A", State::RenderTarget);
+		}));
+
+		CHECK(ThrowsGraphException([]() {
+
+			RenderGraph graph;
+			graph.CreateTexture("A", hdrDesc);
+			graph.AddPass("x").Clear("A", {}).Read("A");
+		}));
+
+		//targets of different sizes, and more than the OM has slots for
+		CHECK(ThrowsGraphException([]() {
+
+			RenderGraph graph;
+			graph.CreateTexture("A", hdrDesc);
+			graph.CreateTexture("B", halfDesc);
+			graph.AddPass("x").Clear("A", {}).Clear("B", {}).KeepAlive();
+			graph.Compile();
+		}));
+
+		CHECK(ThrowsGraphException([]() {
+
+			RenderGraph graph;
+			auto& pass = graph.AddPass("x");
+
+			for (int i = 0; i < 9; i++) {
+
+				graph.CreateTexture(std::to_string(i), hdrDesc);
+				pass.Clear(std::to_string(i), {});
+			}
+
+			pass.KeepAlive();
+			graph.Compile();
+		}));
+
+		//outputs nothing writes, unknown, repeated and empty textures
+		CHECK(ThrowsGraphException([]() {
+
+			RenderGraph graph;
+			graph.CreateTexture("A", hdrDesc);
+			graph.MarkOutput("A");
+			graph.Compile();
+		}));
+
+		CHECK(ThrowsGraphException([]() {
+
+			RenderGraph graph;
+			graph.AddPass("x").Read("A");
+		}));
+
+		CHECK(ThrowsGraphException([]() {
+
+			RenderGraph graph;
+			graph.CreateTexture("A", hdrDesc);
+			graph.CreateTexture("A", halfDesc);
+		}));
+
+		CHECK(ThrowsGraphException([]() {
+
+			RenderGraph graph;
+			graph.CreateTexture("A", {});
+		}));
+	}
+
+	//random graphs against what the rules say, worked out here on their own:
+	//which passes live, that every use of a texture keeps its order where a write is involved,
+	//the lifetimes, that aliased resources never overlap, and that the transitions leave every use in its state
+	void TestRandomGraphs() {
+
+		std::mt19937 rng(45u);
+		const RenderGraph::TextureDesc descs[] = { hdrDesc,{ 1280u,720u,TextureFormat::R8G8B8A8Unorm } };
+
+		for (int iteration = 0; iteration < 300; iteration++) {
+
+			RenderGraph graph;
+			int backBuffer = 0;
+
+			const size_t nTextures = 2u + rng() % 6u;
+			std::vector<size_t> textureDesc;
+
+			for (size_t t = 0; t < nTextures; t++) {
+
+				textureDesc.push_back(rng() % 2u);
+				graph.CreateTexture(MakeName('T', t), descs[textureDesc.back()]);
+			}
+
+			graph.ImportTexture("Out", backBufferDesc, &backBuffer);
+			graph.MarkOutput("Out");
+
+			struct Use {
+
+				size_t texture;
+				bool isWrite;
+				//reads, and writes that load, depend on the last write before them
+				bool isDependent;
+			};
+
+			const size_t nPasses = 3u + rng() % 12u;
+			std::vector<std::vector<Use>> uses(nPasses);
+			std::vector<bool> isKeptAlive(nPasses, false);
+			std::vector<bool> isWritten(nTextures, false);
+
+			for (size_t p = 0; p < nPasses; p++) {
+
+				auto& pass = graph.AddPass(MakeName('P', p));
+				const bool isLast = p + 1u == nPasses;
+
+				//one target, the output for the last pass
+				const size_t target = isLast ? nTextures : rng() % nTextures;
+				const bool isLoad = !isLast && isWritten[target] && rng() % 3u == 0u;
+
+				//up to two reads of other textures already written
+				std::vector<size_t> reads;
+
+				for (int n = (int)(rng() % 3u); n > 0; n--) {
+
+					const size_t t = rng() % nTextures;
+
+					if (t != target && isWritten[t] && std::find(reads.begin(), reads.end(), t) == reads.end()) {
+
+						reads.push_back(t);
+					}
+				}
+
+				for (const size_t t : reads) {
+
+					pass.Read(MakeName('T', t));
+					uses[p].push_back({ t,false,true });
+				}
+
+				pass.Write(isLast ? "Out" : MakeName('T', target), State::RenderTarget, isLoad ? LoadOp::Load : rng() % 2u ? LoadOp::Clear : LoadOp::Discard);
+				uses[p].push_back({ target,true,isLoad });
+
+				if (!isLast) {
+
+					isWritten[target] = true;
+				}
+
+				if (rng() % 6u == 0u) {
+
+					pass.KeepAlive();
+					isKeptAlive[p] = true;
+				}
+			}
+
+			graph.Compile();
+
+			//a pass lives if it's kept alive, writes the output last, or a live pass reads or loads what it wrote
+			std::vector<bool> isLive(nPasses, false);
+			isLive[nPasses - 1u] = true;
+
+			for (size_t p = nPasses; p-- > 0u;) {
+
+				isLive[p] = isLive[p] || isKeptAlive[p];
+
+				if (!isLive[p]) {
+
+					continue;
+				}
+
+				for (const auto& use : uses[p]) {
+
+					if (!use.isDependent) {
+
+						continue;
+					}
+
+					for (size_t q = p; q-- > 0u;) {
+
+						const auto write = std::find_if(uses[q].begin(), uses[q].end(), [&use](const Use& u) { return u.texture == use.texture && u.isWrite; });
+
+						if (write != uses[q].end()) {
+
+							isLive[q] = true;
+							break;
+						}
+					}
+				}
+			}
+
+			std::vector<size_t> stepOf(nPasses, npos);
+
+			for (size_t s = 0; s < graph.GetSteps().size(); s++) {
+
+				stepOf[graph.GetSteps()[s].pass] = s;
+			}
+
+			for (size_t p = 0; p < nPasses; p++) {
+
+				CHECK(graph.IsCulled(p) == !isLive[p]);
+				CHECK((stepOf[p] != npos) == isLive[p]);
+			}
+
+			//uses of one texture by live passes run in the order they were added whenever one of the two writes
+			for (size_t t = 0; t <= nTextures; t++) {
+
+				std::vector<std::pair<size_t, bool>> live;
+
+				for (size_t p = 0; p < nPasses; p++) {
+
+					for (const auto& use : uses[p]) {
+
+						if (use.texture == t && isLive[p]) {
+
+							live.push_back({ p,use.isWrite });
+						}
+					}
+				}
+
+				size_t first = npos;
+				size_t last = npos;
+
+				for (size_t i = 0; i < live.size(); i++) {
+
+					first = std::min(first, stepOf[live[i].first]);
+					last = last == npos ? stepOf[live[i].first] : std::max(last, stepOf[live[i].first]);
+
+					for (size_t j = i + 1u; j < live.size(); j++) {
+
+						if (live[i].second || live[j].second) {
+
+							CHECK(stepOf[live[i].first] < stepOf[live[j].first]);
+						}
+					}
+				}
+
+				const auto& resource = graph.GetResources()[graph.FindResource(t == nTextures ? "Out" : MakeName('T', t))];
+				CHECK(resource.firstStep == first && resource.lastStep == last);
+				CHECK((resource.allocation != npos) == (t < nTextures && first != npos));
+			}
+
+			//aliased resources are alike and never alive at once
+			for (const auto& allocation : graph.GetAllocations()) {
+
+				for (size_t i = 0; i < allocation.resources.size(); i++) {
+
+					const auto& a = graph.GetResources()[allocation.resources[i]];
+					CHECK(a.desc == allocation.desc);
+
+					for (size_t j = i + 1u; j < allocation.resources.size(); j++) {
+
+						const auto& b = graph.GetResources()[allocation.resources[j]];
+						CHECK(a.lastStep < b.firstStep || b.lastStep < a.firstStep);
+					}
+				}
+			}
+
+			CHECK(graph.GetAllocatedBytes() <= graph.GetTransientBytes());
+
+			//replaying the transitions puts every texture a step uses in the state it's used in
+			std::vector<State> states(graph.GetResources().size(), State::None);
+
+			for (const auto& step : graph.GetSteps()) {
+
+				for (const auto& transition : step.transitions) {
+
+					states[transition.resource] = transition.after;
+				}
+
+				for (const auto& use : graph.GetPasses()[step.pass].GetUses()) {
+
+					CHECK(states[use.resource] == use.state);
+				}
+			}
+		}
+	}
+}
+
+int main()
+{
+	Test::Run("frame", TestFrame);
+	Test::Run("aliasing", TestAliasing);
+	Test::Run("same targets first", TestSameTargetsFirst);
+	Test::Run("culled write keeps order", TestCulledWriteKeepsOrder);
+	Test::Run("errors", TestErrors);
+	Test::Run("random graphs", TestRandomGraphs);
+
+	return Test::Finish();
+}
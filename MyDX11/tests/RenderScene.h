@@ -0,0 +1,286 @@
+#pragma once
+
+#include "SoftwareRenderer.h"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
+
+//the scene the software renderer's golden image test and benchmark draw
+//*the nanosuit's .obj isn't in the repo and assimp isn't built on Linux, so it's made up of generated meshes
+//using the nanosuit's textures and the same three shading paths instead
+namespace RenderScene {
+
+	namespace dx = DirectX;
+
+	inline dx::XMFLOAT3 Subtract(const dx::XMFLOAT3& a, const dx::XMFLOAT3& b) noexcept {
+
+		return { a.x - b.x,a.y - b.y,a.z - b.z };
+	}
+
+	inline dx::XMFLOAT3 Cross(const dx::XMFLOAT3& a, const dx::XMFLOAT3& b) noexcept {
+
+		return { a.y * b.z - a.z * b.y,a.z * b.x - a.x * b.z,a.x * b.y - a.y * b.x };
+	}
+
+	inline float Dot(const dx::XMFLOAT3& a, const dx::XMFLOAT3& b) noexcept {
+
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	inline dx::XMFLOAT3 Normalize(const dx::XMFLOAT3& a) noexcept {
+
+		const float invLength = 1.0f / std::sqrt(Dot(a, a));
+
+		return { a.x * invLength,a.y * invLength,a.z * invLength };
+	}
+
+	inline dx::XMFLOAT4X4 Identity() noexcept {
+
+		return {
+			1.0f,0.0f,0.0f,0.0f,
+			0.0f,1.0f,0.0f,0.0f,
+			0.0f,0.0f,1.0f,0.0f,
+			0.0f,0.0f,0.0f,1.0f,
+		};
+	}
+
+	inline dx::XMFLOAT4X4 Translation(float x, float y, float z) noexcept {
+
+		auto m = Identity();
+		m._41 = x;
+		m._42 = y;
+		m._43 = z;
+
+		return m;
+	}
+
+	//XMMatrixPerspectiveLH
+	inline dx::XMFLOAT4X4 PerspectiveLH(float width, float height, float nearZ, float farZ) noexcept {
+
+		const float range = farZ / (farZ - nearZ);
+
+		return {
+			2.0f * nearZ / width,0.0f,0.0f,0.0f,
+			0.0f,2.0f * nearZ / height,0.0f,0.0f,
+			0.0f,0.0f,range,1.0f,
+			0.0f,0.0f,-range * nearZ,0.0f,
+		};
+	}
+
+	//XMMatrixLookAtLH
+	inline dx::XMFLOAT4X4 LookAtLH(const dx::XMFLOAT3& eye, const dx::XMFLOAT3& target, const dx::XMFLOAT3& up) noexcept {
+
+		const auto z = Normalize(Subtract(target, eye));
+		const auto x = Normalize(Cross(up, z));
+		const auto y = Cross(z, x);
+
+		return {
+			x.x,y.x,z.x,0.0f,
+			x.y,y.y,z.y,0.0f,
+			x.z,y.z,z.z,0.0f,
+			-Dot(x,eye),-Dot(y,eye),-Dot(z,eye),1.0f,
+		};
+	}
+
+	//adds a triangle facing along normal, the renderer culls counter clockwise ones like d3d does
+	inline void AddTriangle(SoftwareRenderer::Mesh& mesh, unsigned short a, unsigned short b, unsigned short c, const dx::XMFLOAT3& normal) {
+
+		const auto& pa = mesh.positions[a];
+		const auto& pb = mesh.positions[b];
+		const auto& pc = mesh.positions[c];
+
+		if (Dot(Cross(Subtract(pb, pa), Subtract(pc, pa)), normal) < 0.0f) {
+
+			std::swap(b, c);
+		}
+
+		mesh.indices.push_back(a);
+		mesh.indices.push_back(b);
+		mesh.indices.push_back(c);
+	}
+
+	//divisions x divisions quads in the xz plane facing up, texcoords repeat tiling times
+	inline SoftwareRenderer::Mesh MakePlane(float size, unsigned int divisions, float tiling) {
+
+		SoftwareRenderer::Mesh mesh;
+		const unsigned int nSide = divisions + 1u;
+
+		for (unsigned int z = 0; z < nSide; z++) {
+
+			for (unsigned int x = 0; x < nSide; x++) {
+
+				const float u = (float)x / divisions;
+				const float v = (float)z / divisions;
+
+				mesh.positions.push_back({ (u - 0.5f) * size,0.0f,(v - 0.5f) * size });
+				mesh.normals.push_back({ 0.0f,1.0f,0.0f });
+				mesh.texcoords.push_back({ u * tiling,(1.0f - v) * tiling });
+			}
+		}
+
+		for (unsigned int z = 0; z < divisions; z++) {
+
+			for (unsigned int x = 0; x < divisions; x++) {
+
+				const auto i = (unsigned short)(z * nSide + x);
+
+				AddTriangle(mesh, i, (unsigned short)(i + nSide), (unsigned short)(i + 1u), { 0.0f,1.0f,0.0f });
+				AddTriangle(mesh, (unsigned short)(i + 1u), (unsigned short)(i + nSide), (unsigned short)(i + nSide + 1u), { 0.0f,1.0f,0.0f });
+			}
+		}
+
+		mesh.transform = Identity();
+
+		return mesh;
+	}
+
+	//unit cube, every face gets the whole texture
+	inline SoftwareRenderer::Mesh MakeBox(float size) {
+
+		SoftwareRenderer::Mesh mesh;
+		const float h = size * 0.5f;
+
+		const dx::XMFLOAT3 normals[6] = {
+			{ 1.0f,0.0f,0.0f },{ -1.0f,0.0f,0.0f },
+			{ 0.0f,1.0f,0.0f },{ 0.0f,-1.0f,0.0f },
+			{ 0.0f,0.0f,1.0f },{ 0.0f,0.0f,-1.0f },
+		};
+
+		for (const auto& n : normals) {
+
+			//two axes across the face
+			const dx::XMFLOAT3 u = n.x != 0.0f ? dx::XMFLOAT3{ 0.0f,0.0f,1.0f } : dx::XMFLOAT3{ 1.0f,0.0f,0.0f };
+			const auto v = Cross(n, u);
+			const auto first = (unsigned short)mesh.positions.size();
+
+			for (int corner = 0; corner < 4; corner++) {
+
+				const float su = corner & 1 ? 1.0f : -1.0f;
+				const float sv = corner & 2 ? 1.0f : -1.0f;
+
+				mesh.positions.push_back({
+					(n.x + u.x * su + v.x * sv) * h,
+					(n.y + u.y * su + v.y * sv) * h,
+					(n.z + u.z * su + v.z * sv) * h
+				});
+				mesh.normals.push_back(n);
+				mesh.texcoords.push_back({ (su + 1.0f) * 0.5f,(1.0f - sv) * 0.5f });
+			}
+
+			AddTriangle(mesh, first, (unsigned short)(first + 1u), (unsigned short)(first + 2u), n);
+			AddTriangle(mesh, (unsigned short)(first + 1u), (unsigned short)(first + 3u), (unsigned short)(first + 2u), n);
+		}
+
+		mesh.transform = Identity();
+
+		return mesh;
+	}
+
+	//latitude / longitude sphere, rings * segments * 2 triangles
+	inline SoftwareRenderer::Mesh MakeSphere(float radius, unsigned int rings, unsigned int segments) {
+
+		SoftwareRenderer::Mesh mesh;
+		constexpr float pi = 3.14159265f;
+
+		for (unsigned int r = 0; r <= rings; r++) {
+
+			const float theta = pi * r / rings;
+
+			for (unsigned int s = 0; s <= segments; s++) {
+
+				const float phi = 2.0f * pi * s / segments;
+				const dx::XMFLOAT3 n = { std::sin(theta) * std::cos(phi),std::cos(theta),std::sin(theta) * std::sin(phi) };
+
+				mesh.positions.push_back({ n.x * radius,n.y * radius,n.z * radius });
+				mesh.normals.push_back(n);
+				mesh.texcoords.push_back({ (float)s / segments,(float)r / rings });
+			}
+		}
+
+		for (unsigned int r = 0; r < rings; r++) {
+
+			for (unsigned int s = 0; s < segments; s++) {
+
+				const auto i = (unsigned short)(r * (segments + 1u) + s);
+				const auto below = (unsigned short)(i + segments + 1u);
+
+				//outward at the quad, the poles' slivers included
+				const auto& p = mesh.normals[i];
+				const auto& q = mesh.normals[below + 1u];
+				const auto n = Normalize({ p.x + q.x,p.y + q.y,p.z + q.z });
+
+				AddTriangle(mesh, i, below, (unsigned short)(i + 1u), n);
+				AddTriangle(mesh, (unsigned short)(i + 1u), below, (unsigned short)(below + 1u), n);
+			}
+		}
+
+		mesh.transform = Identity();
+
+		return mesh;
+	}
+
+	//PointLight::Reset's light
+	inline SoftwareRenderer::LightData MakeLight() noexcept {
+
+		SoftwareRenderer::LightData light = {};
+		light.pos = { 1.5f,6.0f,-4.5f };
+		light.ambient = { 0.05f,0.05f,0.05f };
+		light.diffuseColor = { 1.0f,1.0f,1.0f };
+		light.diffuseIntensity = 1.0f;
+		light.attConst = 1.0f;
+		light.attLin = 0.045f;
+		light.attQuad = 0.0075f;
+
+		return light;
+	}
+
+	//the engine's projection (1 by 9/16 at the near plane) and a camera looking down at the middle of the scene
+	inline dx::XMFLOAT4X4 MakeProjection() noexcept {
+
+		return PerspectiveLH(1.0f, 9.0f / 16.0f, 0.5f, 40.0f);
+	}
+
+	inline dx::XMFLOAT4X4 MakeView() noexcept {
+
+		return LookAtLH({ 0.0f,4.0f,-9.0f }, { 0.0f,0.5f,0.0f }, { 0.0f,1.0f,0.0f });
+	}
+
+	//textured ground (ModelPhong), a spec mapped box (ModelPhongSpecMap) and flat spheres (Phong)
+	//*the spheres' rings and segments set how heavy the scene is, a grid of them stands in for the nanosuit's triangles
+	inline void Build(SoftwareRenderer& renderer, unsigned int sphereRings, unsigned int sphereSegments, unsigned int nSpheresPerSide) {
+
+		const auto pGround = std::make_shared<SoftwareRenderer::Texture>(SoftwareRenderer::Texture::FromFile("asset/texture/stonk.jpg"));
+		const auto pBody = std::make_shared<SoftwareRenderer::Texture>(SoftwareRenderer::Texture::FromFile("asset/model/nano_textured/body_dif.png"));
+		const auto pBodySpec = std::make_shared<SoftwareRenderer::Texture>(SoftwareRenderer::Texture::FromFile("asset/model/nano_textured/body_showroom_spec.png"));
+
+		auto ground = MakePlane(24.0f, 16u, 6.0f);
+		ground.material.shading = SoftwareRenderer::Shading::ModelPhong;
+		ground.material.specularIntensity = 0.8f;
+		ground.material.specularPower = 35.0f;
+		ground.material.pDiffuse = pGround;
+		renderer.AddMesh(std::move(ground));
+
+		auto box = MakeBox(2.5f);
+		box.material.shading = SoftwareRenderer::Shading::ModelPhongSpecMap;
+		box.material.pDiffuse = pBody;
+		box.material.pSpecular = pBodySpec;
+		box.transform = Translation(-1.8f, 1.25f, 0.5f);
+		renderer.AddMesh(std::move(box));
+
+		const float spacing = 3.0f / nSpheresPerSide;
+		const float radius = spacing * 0.4f;
+
+		for (unsigned int z = 0; z < nSpheresPerSide; z++) {
+
+			for (unsigned int x = 0; x < nSpheresPerSide; x++) {
+
+				auto sphere = MakeSphere(radius, sphereRings, sphereSegments);
+				sphere.material.shading = SoftwareRenderer::Shading::Phong;
+				sphere.material.color = { 1.0f,0.35f + 0.5f * x / nSpheresPerSide,0.2f + 0.6f * z / nSpheresPerSide };
+				sphere.transform = Translation(0.5f + spacing * (x + 0.5f), radius, -1.0f + spacing * (z + 0.5f));
+				renderer.AddMesh(std::move(sphere));
+			}
+		}
+	}
+}
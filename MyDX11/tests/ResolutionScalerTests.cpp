@@ -0,0 +1,269 @@
+#include "TestCheck.h"
+#include "ResolutionScaler.h"
+#include "FrameStats.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+	constexpr uint64_t targetNs = 16'666'667u;
+
+	//a GPU whose frame time is a fixed cost plus a load that grows with the pixels drawn
+	struct SimulatedGpu {
+
+		double baseMs = 4.0;
+		double loadMs = 20.0;
+		double noiseMs = 0.0;
+		std::mt19937 rng{ 3u };
+
+		uint64_t Draw(float scale) {
+
+			std::normal_distribution<double> noise(0.0, noiseMs);
+			const double ms = baseMs + loadMs * scale * scale + (noiseMs > 0.0 ? noise(rng) : 0.0);
+
+			return (uint64_t)(std::max(ms, 0.1) * 1'000'000.0);
+		}
+
+		//the frame time at a scale without the noise
+		double GetMs(float scale) const {
+
+			return baseMs + loadMs * scale * scale;
+		}
+	};
+
+	bool IsOnStep(float scale, float step) {
+
+		const float steps = scale / step;
+
+		return std::abs(steps - std::round(steps)) < 1e-3f;
+	}
+
+	//the loop settles wherever the load puts it, close to the target or pinned at the end of the range that helps most
+	void TestClosedLoop() {
+
+		struct Phase {
+
+			double loadMs;
+			int nFrames;
+		};
+
+		//*at 45 ms neither step around the target is inside the deadband
+		const Phase phases[] = { { 20.0,600 },{ 35.0,300 },{ 10.0,300 },{ 80.0,300 },{ 45.0,400 },{ 20.0,400 } };
+
+		ResolutionScaler scaler;
+		const auto& settings = scaler.GetSettings();
+		SimulatedGpu gpu;
+		gpu.noiseMs = 0.6;
+
+		float scale = scaler.GetScale();
+
+		for (const auto& phase : phases) {
+
+			gpu.loadMs = phase.loadMs;
+			unsigned int nSteadyChanges = 0u;
+
+			for (int i = 0; i < phase.nFrames; i++) {
+
+				const unsigned int nChanges = scaler.GetChangeCount();
+				scale = scaler.Update(gpu.Draw(scale));
+
+				CHECK(scale >= settings.minScale && scale <= settings.maxScale);
+				CHECK(IsOnStep(scale, settings.step));
+
+				//the second half of a phase is steady, the scale shouldn't hunt
+				if (i >= phase.nFrames / 2) {
+
+					nSteadyChanges += scaler.GetChangeCount() - nChanges;
+				}
+			}
+
+			CHECK(nSteadyChanges <= 2u);
+
+			//within the deadband plus the half step the scale may sit off by, or at a bound
+			const double errorMs = gpu.GetMs(scale) - targetNs / 1'000'000.0;
+			const double stepMs = gpu.GetMs(std::min(scale + settings.step, 1.0f)) - gpu.GetMs(scale);
+			const double toleranceMs = targetNs / 1'000'000.0 * settings.deadband + stepMs;
+
+			const bool isSettled = std::abs(errorMs) <= toleranceMs;
+			const bool isPinnedLow = scale == settings.minScale && errorMs > 0.0;
+			const bool isPinnedHigh = scale == settings.maxScale && errorMs < 0.0;
+
+			CHECK(isSettled || isPinnedLow || isPinnedHigh);
+		}
+
+		//too light to fill the budget at full size, too heavy to make it at the smallest
+		CHECK(scaler.GetChangeCount() >= 4u);
+	}
+
+	//the scale is held for the cooldown after every change
+	void TestCooldown() {
+
+		ResolutionScaler::Settings settings;
+		settings.cooldownFrames = 10u;
+
+		ResolutionScaler scaler(settings);
+		SimulatedGpu gpu;
+		gpu.loadMs = 60.0;
+
+		float scale = scaler.GetScale();
+		int lastChange = -1;
+		int nChanges = 0;
+
+		for (int i = 0; i < 400; i++) {
+
+			const float next = scaler.Update(gpu.Draw(scale));
+
+			if (next != scale) {
+
+				CHECK(lastChange < 0 || i - lastChange > (int)settings.cooldownFrames);
+				lastChange = i;
+				nChanges++;
+			}
+
+			//alternating light and heavy loads keep it moving
+			if (i % 100 == 99) {
+
+				gpu.loadMs = gpu.loadMs > 30.0 ? 5.0 : 60.0;
+			}
+
+			scale = next;
+		}
+
+		CHECK(nChanges >= 4);
+		CHECK(scaler.GetChangeCount() == (unsigned int)nChanges);
+	}
+
+	//frame times wandering inside the deadband never move the scale
+	void TestDeadband() {
+
+		ResolutionScaler::Settings settings;
+		settings.maxScale = 0.8f;
+
+		ResolutionScaler scaler(settings);
+		std::mt19937 rng(5u);
+		const double band = (double)targetNs * settings.deadband * 0.9;
+
+		for (int i = 0; i < 2000; i++) {
+
+			const double offset = ((double)(rng() % 2001u) / 1000.0 - 1.0) * band;
+			CHECK(scaler.Update((uint64_t)((double)targetNs + offset)) == 0.8f);
+		}
+
+		CHECK(scaler.GetChangeCount() == 0u);
+	}
+
+	//a replayed trace is what a scaler fed the same frames one by one would have given
+	void TestReplay() {
+
+		const ResolutionScaler::Settings settings;
+
+		//a constant 30 ms frame drives it to the smallest scale
+		const auto slow = ResolutionScaler::Replay(std::vector<uint64_t>(100u, 30'000'000u), settings);
+		CHECK(slow.size() == 100u);
+		CHECK(slow.back().scale == settings.minScale);
+		CHECK(slow.front().filteredNs == 30'000'000.0);
+
+		std::mt19937_64 rng(9u);
+		std::vector<uint64_t> framesNs;
+
+		for (int i = 0; i < 1000; i++) {
+
+			const uint64_t loadNs = (i / 150) % 2 == 0 ? 12'000'000u : 24'000'000u;
+			framesNs.push_back(loadNs + rng() % 4'000'000u);
+		}
+
+		const auto samples = ResolutionScaler::Replay(framesNs, settings);
+		ResolutionScaler scaler(settings);
+
+		CHECK(samples.size() == framesNs.size());
+
+		for (size_t i = 0; i < framesNs.size(); i++) {
+
+			const float scale = scaler.Update(framesNs[i]);
+			CHECK(samples[i].frameNs == framesNs[i]);
+			CHECK(samples[i].scale == scale);
+			CHECK(samples[i].filteredNs == scaler.GetFilteredNs());
+		}
+	}
+
+	//a trace saved by FrameStats comes back as the frame times that went in
+	void TestParseTrace() {
+
+		FrameStats stats([]() { return (uint64_t)0u; }, 64u);
+		std::vector<uint64_t> framesNs;
+		std::mt19937_64 rng(1u);
+
+		for (int i = 0; i < 50; i++) {
+
+			framesNs.push_back(10'000'000u + rng() % 30'000'000u);
+			stats.AddFrame(framesNs.back());
+		}
+
+		CHECK(ResolutionScaler::ParseTrace(stats.MakeCsv()) == framesNs);
+
+		//windows line ends and blank lines
+		const auto crlf = ResolutionScaler::ParseTrace("frame,end_ns,duration_ns,hitch\r\n0,100,16000000,0\r\n\r\n1,200,30000000,1\r\n");
+		CHECK(crlf == std::vector<uint64_t>({ 16'000'000u,30'000'000u }));
+
+		//one number per line, and a header naming the column somewhere else
+		CHECK(ResolutionScaler::ParseTrace("16000000\n17000000\n") == std::vector<uint64_t>({ 16'000'000u,17'000'000u }));
+		CHECK(ResolutionScaler::ParseTrace("duration_ns,frame\n5,0\n6,1") == std::vector<uint64_t>({ 5u,6u }));
+		CHECK(ResolutionScaler::ParseTrace("").empty());
+	}
+
+	void TestSettings() {
+
+		ResolutionScaler scaler;
+		ResolutionScaler::Settings settings;
+
+		//a range outside (0,1] and a step too small to matter are pulled back in
+		settings.minScale = -1.0f;
+		settings.maxScale = 3.0f;
+		settings.step = 0.0f;
+		scaler.SetSettings(settings);
+
+		CHECK(scaler.GetSettings().step == 0.01f);
+		CHECK(scaler.GetSettings().minScale == 0.01f);
+		CHECK(scaler.GetSettings().maxScale == 1.0f);
+
+		//narrowing the range moves the scale into it
+		settings.minScale = 0.5f;
+		settings.maxScale = 0.7f;
+		settings.step = 0.1f;
+		scaler.SetSettings(settings);
+		CHECK(std::abs(scaler.GetScale() - 0.7f) < 1e-6f);
+
+		//Reset lands on a step inside the range and drops the filter
+		for (int i = 0; i < 20; i++) {
+
+			scaler.Update(40'000'000u);
+		}
+
+		scaler.Reset(0.63f);
+		CHECK(std::abs(scaler.GetScale() - 0.6f) < 1e-6f);
+		CHECK(std::abs(scaler.GetRawScale() - 0.6f) < 1e-6f);
+		CHECK(scaler.GetFilteredNs() == 0.0);
+
+		scaler.Reset(0.1f);
+		CHECK(scaler.GetScale() == 0.5f);
+
+		CHECK(ResolutionScaler::ScaleSize(1600u, 0.55f) == 880u);
+		CHECK(ResolutionScaler::ScaleSize(1u, 0.3f) == 1u);
+		CHECK(ResolutionScaler::ScaleSize(900u, 1.0f) == 900u);
+	}
+}
+
+int main()
+{
+	Test::Run("closed loop", TestClosedLoop);
+	Test::Run("cooldown", TestCooldown);
+	Test::Run("deadband", TestDeadband);
+	Test::Run("replay", TestReplay);
+	Test::Run("parse trace", TestParseTrace);
+	Test::Run("settings", TestSettings);
+
+	return Test::Finish();
+}
@@ -0,0 +1,210 @@
+#include "TestCheck.h"
+#include "RingAllocator.h"
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace {
+
+	void TestAlignment() {
+
+		RingAllocator ring(1024u, 256u);
+
+		CHECK(ring.Allocate(1u) == 0u);
+		CHECK(ring.Allocate(256u) == 256u);
+		CHECK(ring.Allocate(257u) == 512u);
+		CHECK(ring.GetUsedBytes() == 1024u);
+
+		//nothing left, and an empty request never gets a block
+		CHECK(!ring.Allocate(1u));
+		CHECK(!RingAllocator(1024u, 256u).Allocate(0u));
+	}
+
+	void TestFenceReuse() {
+
+		RingAllocator ring(1024u, 256u);
+
+		CHECK(ring.Allocate(512u) == 0u);
+		ring.Fence(1u);
+		CHECK(ring.Allocate(512u) == 512u);
+		ring.Fence(2u);
+
+		//full until the GPU is done with a frame
+		CHECK(!ring.Allocate(256u));
+		CHECK(ring.GetOldestFence() == 1u);
+
+		//retiring an older value than any pending frame gives nothing back
+		ring.Retire(0u);
+		CHECK(ring.GetUsedBytes() == 1024u);
+
+		ring.Retire(1u);
+		CHECK(ring.GetUsedBytes() == 512u);
+		CHECK(ring.GetOldestFence() == 2u);
+		CHECK(ring.Allocate(512u) == 0u);
+		ring.Fence(3u);
+
+		//one completed value retires every frame up to it
+		ring.Retire(3u);
+		CHECK(ring.GetUsedBytes() == 0u);
+		CHECK(!ring.HasPendingFences());
+	}
+
+	void TestEmptyFrameFence() {
+
+		RingAllocator ring(1024u, 256u);
+
+		//a frame without allocations leaves no fence to wait on
+		ring.Fence(1u);
+		CHECK(!ring.HasPendingFences());
+
+		CHECK(ring.Allocate(256u) == 0u);
+		ring.Fence(2u);
+		ring.Fence(3u);
+		CHECK(ring.GetOldestFence() == 2u);
+		ring.Retire(2u);
+		CHECK(!ring.HasPendingFences());
+	}
+
+	void TestWraparound() {
+
+		RingAllocator ring(1024u, 256u);
+
+		CHECK(ring.Allocate(512u) == 0u);
+		ring.Fence(1u);
+		CHECK(ring.Allocate(256u) == 512u);
+		ring.Fence(2u);
+		ring.Retire(1u);
+
+		//512 free at the front but only 256 at the end, the block wraps and the end is skipped
+		CHECK(ring.Allocate(512u) == 0u);
+		CHECK(ring.GetUsedBytes() == 1024u);
+		ring.Fence(3u);
+
+		//the skipped end comes back with the frame that skipped it
+		ring.Retire(2u);
+		CHECK(ring.GetUsedBytes() == 768u);
+		CHECK(ring.Allocate(256u) == 512u);
+		ring.Fence(4u);
+		ring.Retire(4u);
+		CHECK(ring.GetUsedBytes() == 0u);
+
+		//an empty ring starts over at the front so the biggest block fits
+		CHECK(ring.Allocate(1024u) == 0u);
+	}
+
+	void TestBlockNeverStraddlesTheEnd() {
+
+		RingAllocator ring(1024u, 256u);
+
+		CHECK(ring.Allocate(512u) == 0u);
+		ring.Fence(1u);
+		CHECK(ring.Allocate(256u) == 512u);
+		ring.Fence(2u);
+		ring.Retire(1u);
+
+		//768 bytes are free, but as 256 at the end and 512 at the front
+		CHECK(ring.GetUsedBytes() == 256u);
+		CHECK(!ring.Allocate(768u));
+		CHECK(ring.Allocate(512u) == 0u);
+	}
+
+	void TestReset() {
+
+		RingAllocator ring(1024u, 256u);
+
+		ring.Allocate(768u);
+		ring.Fence(1u);
+		ring.Reset();
+
+		CHECK(ring.GetUsedBytes() == 0u);
+		CHECK(!ring.HasPendingFences());
+		CHECK(ring.Allocate(1024u) == 0u);
+	}
+
+	//random frames against a byte by byte owner map, no live block may ever overlap another
+	void TestRandomFrames() {
+
+		std::mt19937 rng(1u);
+
+		for (int trial = 0; trial < 100; trial++) {
+
+			const size_t capacity = 256u * (1u + rng() % 64u);
+			RingAllocator ring(capacity, 256u);
+
+			std::vector<bool> isOwned(capacity, false);
+			std::map<unsigned long long, std::vector<std::pair<size_t, size_t>>> frames;
+			std::vector<std::pair<size_t, size_t>> current;
+			unsigned long long fence = 1u;
+			unsigned long long completed = 0u;
+
+			for (int step = 0; step < 1000; step++) {
+
+				const auto op = rng() % 10u;
+
+				if (op < 6u) {
+
+					const size_t size = 1u + rng() % (capacity / 2u + 1u);
+					const size_t alignedSize = (size + 255u) & ~size_t(255u);
+					const auto offset = ring.Allocate(size);
+
+					if (!offset) {
+
+						//an empty ring has to fit anything up to its capacity
+						CHECK(ring.GetUsedBytes() != 0u);
+						continue;
+					}
+
+					CHECK(*offset % 256u == 0u);
+					CHECK(*offset + alignedSize <= capacity);
+
+					for (size_t i = *offset; i < std::min(*offset + alignedSize, capacity); i++) {
+
+						CHECK(!isOwned[i]);
+						isOwned[i] = true;
+					}
+
+					current.emplace_back(*offset, alignedSize);
+				}
+				else if (op < 8u) {
+
+					ring.Fence(fence);
+					frames[fence++] = std::move(current);
+					current.clear();
+				}
+				else if (completed + 1u < fence) {
+
+					completed += 1u + rng() % (fence - 1u - completed);
+					ring.Retire(completed);
+
+					for (auto i = frames.begin(); i != frames.end() && i->first <= completed; i = frames.erase(i)) {
+
+						for (const auto& [offset, size] : i->second) {
+
+							std::fill(isOwned.begin() + offset, isOwned.begin() + offset + size, false);
+						}
+					}
+				}
+			}
+
+			ring.Fence(fence);
+			ring.Retire(fence);
+
+			CHECK(ring.GetUsedBytes() == 0u);
+			CHECK(!ring.HasPendingFences());
+		}
+	}
+}
+
+int main()
+{
+	Test::Run("alignment", TestAlignment);
+	Test::Run("fence reuse", TestFenceReuse);
+	Test::Run("empty frame fence", TestEmptyFrameFence);
+	Test::Run("wraparound", TestWraparound);
+	Test::Run("block never straddles the end", TestBlockNeverStraddlesTheEnd);
+	Test::Run("reset", TestReset);
+	Test::Run("random frames", TestRandomFrames);
+
+	return Test::Finish();
+}
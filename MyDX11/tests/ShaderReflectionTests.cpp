@@ -0,0 +1,319 @@
+#include "TestCheck.h"
+#include "ShaderReflection.h"
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+	struct Shader {
+
+		std::string name;
+		std::vector<uint8_t> bytes;
+	};
+
+	//every compiled shader shipped next to the hlsl, by file name without the extension
+	std::vector<Shader> LoadShippedShaders() {
+
+		std::vector<Shader> shaders;
+
+		for (const auto& entry : std::filesystem::directory_iterator(".")) {
+
+			if (entry.path().extension() != ".cso") {
+
+				continue;
+			}
+
+			std::ifstream file(entry.path(), std::ios::binary);
+
+			Shader shader;
+			shader.name = entry.path().stem().string();
+			shader.bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+			shaders.push_back(std::move(shader));
+		}
+
+		std::sort(shaders.begin(), shaders.end(), [](const Shader& a, const Shader& b) { return a.name < b.name; });
+
+		return shaders;
+	}
+
+	bool IsVertexShaderName(const std::string& name) {
+
+		return name.find("VS") != std::string::npos || name == "VertexShader";
+	}
+
+	//semantics match without regard to case, like D3D does when linking stages
+	bool IsSameSemantic(const std::string& a, const std::string& b) {
+
+		return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+
+			return std::toupper((unsigned char)x) == std::toupper((unsigned char)y);
+		});
+	}
+
+	//every shader parses, the stage matches the name and the layouts hold together
+	void TestShippedShaders() {
+
+		const auto shaders = LoadShippedShaders();
+		CHECK(shaders.size() >= 20u);
+
+		for (const auto& shader : shaders) {
+
+			const ShaderReflection reflection(shader.bytes.data(), shader.bytes.size());
+			std::cout << shader.name << ": " << reflection.GetInputSignature().size() << " inputs, "
+				<< reflection.GetCbuffers().size() << " cbuffers, " << reflection.GetBindings().size() << " bindings" << std::endl;
+
+			const bool isVertexShader = IsVertexShaderName(shader.name);
+			CHECK(reflection.GetStage() == (isVertexShader ? ShaderReflection::Stage::Vertex : ShaderReflection::Stage::Pixel));
+			CHECK(reflection.GetMajorVersion() >= 4u);
+			CHECK(!reflection.GetOutputSignature().empty());
+
+			//a vertex shader accepts the layout made from it, with nothing to warn about
+			if (isVertexShader) {
+
+				const auto layout = reflection.MakeInputLayout();
+				const auto problems = reflection.CheckInputLayout(layout);
+
+				CHECK(problems.empty());
+				CHECK(std::count_if(reflection.GetInputSignature().begin(), reflection.GetInputSignature().end(),
+					[](const ShaderReflection::Parameter& p) { return !p.IsSystemValue(); }) == (long)layout.size());
+			}
+
+			//registers are whole, variables inside and in order, each buffer bound at its slot
+			for (const auto& cbuffer : reflection.GetCbuffers()) {
+
+				CHECK(cbuffer.size > 0u && cbuffer.size % 16u == 0u);
+
+				unsigned int end = 0u;
+
+				for (const auto& variable : cbuffer.variables) {
+
+					CHECK(variable.offset >= end);
+					CHECK(variable.offset + variable.size <= cbuffer.size);
+
+					//no variable straddles a 16 byte register unless it starts one
+					CHECK(variable.offset % 16u == 0u || variable.offset / 16u == (variable.offset + variable.size - 1u) / 16u);
+
+					end = variable.offset + variable.size;
+				}
+
+				CHECK(reflection.FindCbuffer(cbuffer.slot) == &cbuffer);
+				CHECK(std::any_of(reflection.GetBindings().begin(), reflection.GetBindings().end(), [&cbuffer](const ShaderReflection::Binding& b) {
+
+					return b.type == ShaderReflection::BindingType::Cbuffer && b.slot == cbuffer.slot && b.name == cbuffer.name;
+				}));
+			}
+		}
+	}
+
+	//each pixel shader's inputs are written by the vertex shader it's paired with (XxxPS with XxxVS)
+	void TestStagesLink() {
+
+		const auto shaders = LoadShippedShaders();
+		std::map<std::string, ShaderReflection> vertexShaders;
+
+		for (const auto& shader : shaders) {
+
+			if (IsVertexShaderName(shader.name)) {
+
+				vertexShaders.emplace(shader.name, ShaderReflection(shader.bytes.data(), shader.bytes.size()));
+			}
+		}
+
+		size_t nLinked = 0u;
+
+		for (const auto& shader : shaders) {
+
+			if (IsVertexShaderName(shader.name)) {
+
+				continue;
+			}
+
+			//ModelPhongPSSpecMap goes with ModelPhongVS, PixelShader with VertexShader
+			//*the compiled IndexedPhongPS is the one from before instancing, drawn with PhongVS
+			const auto ps = shader.name.find("PS");
+			const auto vsName = shader.name == "IndexedPhongPS" ? std::string("PhongVS") :
+				ps == std::string::npos ? std::string("VertexShader") : shader.name.substr(0u, ps) + "VS";
+			const auto vs = vertexShaders.find(vsName);
+
+			CHECK(vs != vertexShaders.end());
+
+			if (vs == vertexShaders.end()) {
+
+				continue;
+			}
+
+			const ShaderReflection reflection(shader.bytes.data(), shader.bytes.size());
+
+			//*system values like SV_PrimitiveID come from the rasterizer, not the vertex shader
+			for (const auto& input : reflection.GetInputSignature()) {
+
+				if (input.IsSystemValue()) {
+
+					continue;
+				}
+
+				const auto& outputs = vs->second.GetOutputSignature();
+				const auto output = std::find_if(outputs.begin(), outputs.end(), [&input](const ShaderReflection::Parameter& o) {
+
+					return IsSameSemantic(o.semanticName, input.semanticName) && o.semanticIndex == input.semanticIndex;
+				});
+
+				CHECK(output != outputs.end());
+
+				if (output != outputs.end()) {
+
+					CHECK(output->registerIndex == input.registerIndex);
+					CHECK(output->componentType == input.componentType);
+					CHECK((output->mask & input.usedMask) == input.usedMask);
+				}
+			}
+
+			nLinked++;
+		}
+
+		CHECK(nLinked >= 10u);
+	}
+
+	//the light every lit pixel shader reads is packed the way PointLight::Bind packs it
+	void TestLightCbuffer() {
+
+		const std::vector<ShaderReflection::CbufferField> light = {
+			{ "lightPos",0u,12u },{ "ambient",16u,12u },{ "diffuseColor",32u,12u },
+			{ "diffuseIntensity",44u,4u },{ "attConst",48u,4u },{ "attLin",52u,4u },{ "attQuad",56u,4u },
+		};
+
+		size_t nLit = 0u;
+
+		for (const auto& shader : LoadShippedShaders()) {
+
+			const ShaderReflection reflection(shader.bytes.data(), shader.bytes.size());
+			const auto pCbuffer = reflection.FindCbuffer("LightCBuf");
+
+			if (pCbuffer != nullptr) {
+
+				CHECK(pCbuffer->slot == 0u);
+				CHECK(ShaderReflection::CheckCbuffer(*pCbuffer, light).empty());
+				nLit++;
+			}
+		}
+
+		CHECK(nLit >= 5u);
+	}
+
+	//what the checks catch when the c++ side is wrong
+	void TestProblemsFound() {
+
+		const ShaderReflection vs("ModelPhongVS.cso");
+
+		const auto fine = vs.CheckInputLayout({
+			{ "Position",0u,VertexFormat::R32G32B32Float,0u,0u },
+			{ "Normal",0u,VertexFormat::R32G32B32Float,0u,12u },
+			{ "Texcoord",0u,VertexFormat::R32G32Float,0u,24u },
+		});
+
+		CHECK(fine.empty());
+
+		//a repeated element and a missing one are errors, an integer read as float only a warning
+		const auto broken = vs.CheckInputLayout({
+			{ "Position",0u,VertexFormat::R32G32B32Float,0u,0u },
+			{ "Normal",0u,VertexFormat::R32G32B32Uint,0u,12u },
+			{ "Position",0u,VertexFormat::R32G32Float,0u,24u },
+		});
+
+		CHECK(broken.size() == 3u);
+		CHECK(ShaderReflection::HasError(broken));
+		CHECK(std::count_if(broken.begin(), broken.end(), [](const ShaderReflection::Problem& p) { return !p.isError; }) == 1);
+
+		const auto typeOnly = vs.CheckInputLayout({
+			{ "Position",0u,VertexFormat::R32G32B32Float,0u,0u },
+			{ "Normal",0u,VertexFormat::R32G32B32Sint,0u,12u },
+			{ "Texcoord",0u,VertexFormat::R32G32Float,0u,24u },
+		});
+
+		CHECK(typeOnly.size() == 1u && !ShaderReflection::HasError(typeOnly));
+
+		//materialColor is a float3[6] array, six registers less the last one's padding
+		const ShaderReflection ps("IndexedPhongPS.cso");
+		const auto pObject = ps.FindCbuffer(1u);
+
+		CHECK(pObject != nullptr);
+
+		if (pObject != nullptr) {
+
+			const auto pColors = pObject->FindVariable("materialColor");
+
+			CHECK(pColors != nullptr && pColors->elements == 6u && pColors->size == 92u);
+
+			const auto misplaced = ShaderReflection::CheckCbuffer(*pObject, { { "materialColor",0u,92u },{ "specularIntensity",92u,4u },{ "specularPower",96u,4u } });
+			CHECK(std::count_if(misplaced.begin(), misplaced.end(), [](const ShaderReflection::Problem& p) { return p.isError; }) == 2);
+		}
+
+		bool hasThrown = false;
+
+		try {
+
+			ShaderReflection missing("NoSuchShader.cso");
+		}
+		catch (const ShaderReflection::Exception&) {
+
+			hasThrown = true;
+		}
+
+		CHECK(hasThrown);
+	}
+
+	//cut short or damaged bytecode only ever ends in ShaderReflection::Exception
+	void TestCorruptBytecode() {
+
+		std::mt19937 rng(3u);
+
+		for (const auto& shader : LoadShippedShaders()) {
+
+			for (size_t size = 0u; size < shader.bytes.size(); size += 13u) {
+
+				try {
+
+					ShaderReflection reflection(shader.bytes.data(), size);
+				}
+				catch (const ShaderReflection::Exception&) {
+				}
+			}
+
+			for (int i = 0; i < 300; i++) {
+
+				auto bytes = shader.bytes;
+
+				for (int n = 0; n < 3; n++) {
+
+					bytes[rng() % bytes.size()] ^= (uint8_t)(1u + rng() % 255u);
+				}
+
+				try {
+
+					ShaderReflection reflection(bytes.data(), bytes.size());
+				}
+				catch (const ShaderReflection::Exception&) {
+				}
+			}
+		}
+	}
+}
+
+int main()
+{
+	Test::Run("shipped shaders", TestShippedShaders);
+	Test::Run("vertex and pixel shaders link", TestStagesLink);
+	Test::Run("light cbuffer", TestLightCbuffer);
+	Test::Run("problems found", TestProblemsFound);
+	Test::Run("corrupt bytecode", TestCorruptBytecode);
+
+	return Test::Finish();
+}
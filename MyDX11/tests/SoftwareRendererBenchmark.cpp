@@ -0,0 +1,58 @@
+#include "RenderScene.h"
+#include "SoftwareRenderer.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+//frames of the test scene at the engine's 1600x900 on every core
+//usage: SoftwareRendererBenchmark [frames]
+int main(int argc, char* argv[])
+{
+	const int nFrames = argc > 1 ? std::max(1, std::atoi(argv[1])) : 100;
+
+	JobSystem jobs;
+	SoftwareRenderer renderer(jobs, 1600u, 900u);
+	SoftwareRenderer::FrameBuffer frame(1600u, 900u);
+
+	//about the nanosuit's triangle count in spheres, plus the textured ground and box filling the rest of the screen
+	RenderScene::Build(renderer, 32u, 64u, 4u);
+
+	const auto view = RenderScene::MakeView();
+	const auto projection = RenderScene::MakeProjection();
+	const auto light = RenderScene::MakeLight();
+
+	//first frame warms the caches and sizes the bins
+	renderer.Render(frame, view, projection, light, 0xFF000000u);
+
+	std::vector<float> totals;
+	SoftwareRenderer::FrameStats sum;
+
+	for (int i = 0; i < nFrames; i++) {
+
+		renderer.Render(frame, view, projection, light, 0xFF000000u);
+
+		const auto& stats = renderer.GetFrameStats();
+		totals.push_back(stats.totalMs);
+		sum.vertexMs += stats.vertexMs;
+		sum.binningMs += stats.binningMs;
+		sum.rasterMs += stats.rasterMs;
+		sum.totalMs += stats.totalMs;
+	}
+
+	std::sort(totals.begin(), totals.end());
+
+	const auto& stats = renderer.GetFrameStats();
+
+	std::cout << std::fixed << std::setprecision(2)
+		<< "1600x900, " << stats.trianglesIn << " triangles (" << stats.trianglesBinned << " binned), "
+		<< renderer.GetThreadCount() << " threads, " << nFrames << " frames" << std::endl
+		<< "vertex " << sum.vertexMs / nFrames << " ms, binning " << sum.binningMs / nFrames
+		<< " ms, raster " << sum.rasterMs / nFrames << " ms" << std::endl
+		<< "frame mean " << sum.totalMs / nFrames << " ms, median " << totals[totals.size() / 2u]
+		<< " ms, max " << totals.back() << " ms (" << 1000.0f / totals[totals.size() / 2u] << " fps)" << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,174 @@
+#include "TestCheck.h"
+#include "RenderScene.h"
+#include "SoftwareRenderer.h"
+#include "JobSystem.h"
+#include "ImageDecoder.h"
+#include "ImageEncoder.h"
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+#include <vector>
+
+namespace {
+
+	constexpr unsigned int goldenWidth = 320u;
+	constexpr unsigned int goldenHeight = 180u;
+	constexpr uint32_t clearColor = 0xFF102030u;
+	const char* goldenPath = "tests/golden/SoftwareRenderer.png";
+
+	void RenderGoldenScene(JobSystem& jobs, SoftwareRenderer::FrameBuffer& target) {
+
+		SoftwareRenderer renderer(jobs, goldenWidth, goldenHeight);
+		RenderScene::Build(renderer, 16u, 32u, 2u);
+		renderer.Render(target, RenderScene::MakeView(), RenderScene::MakeProjection(), RenderScene::MakeLight(), clearColor);
+	}
+
+	//largest difference of any channel of the two texels
+	int GetDifference(uint32_t a, uint32_t b) noexcept {
+
+		int difference = 0;
+
+		for (int shift = 0; shift < 32; shift += 8) {
+
+			difference = std::max(difference, std::abs((int)((a >> shift) & 0xFFu) - (int)((b >> shift) & 0xFFu)));
+		}
+
+		return difference;
+	}
+
+	void TestGoldenImage() {
+
+		JobSystem jobs;
+		SoftwareRenderer::FrameBuffer frame(goldenWidth, goldenHeight);
+		RenderGoldenScene(jobs, frame);
+
+		//a missing golden image is written instead of compared, set MYDX11_UPDATE_GOLDEN to rewrite it after an intended change
+		if (std::getenv("MYDX11_UPDATE_GOLDEN") != nullptr || !std::filesystem::exists(goldenPath)) {
+
+			std::filesystem::create_directories(std::filesystem::path(goldenPath).parent_path());
+			ImageEncoder::EncodeFile(goldenPath, frame.GetImage(), false);
+			std::cout << "wrote " << goldenPath << std::endl;
+			return;
+		}
+
+		std::vector<uint32_t> golden;
+		unsigned int width = 0u;
+		unsigned int height = 0u;
+
+		ImageDecoder::DecodeFile(goldenPath, [&](unsigned int w, unsigned int h) {
+
+			width = w;
+			height = h;
+			golden.resize((size_t)w * h);
+
+			return golden.data();
+		});
+
+		CHECK(width == goldenWidth);
+		CHECK(height == goldenHeight);
+
+		if (golden.size() != (size_t)goldenWidth * goldenHeight) {
+
+			return;
+		}
+
+		//rounding may move a channel a step or two between compilers, anything more is a real change
+		size_t nMismatched = 0u;
+		int maxDifference = 0;
+
+		for (size_t i = 0; i < golden.size(); i++) {
+
+			const int difference = GetDifference(golden[i], frame.GetColorPtr()[i]);
+
+			maxDifference = std::max(maxDifference, difference);
+			nMismatched += difference > 2 ? 1u : 0u;
+		}
+
+		std::cout << nMismatched << " pixels differ from the golden image, by at most " << maxDifference << std::endl;
+		CHECK(nMismatched <= golden.size() / 1000u);
+	}
+
+	void TestDeterministicAcrossThreads() {
+
+		JobSystem single(1u);
+		JobSystem several(4u);
+		SoftwareRenderer::FrameBuffer a(goldenWidth, goldenHeight);
+		SoftwareRenderer::FrameBuffer b(goldenWidth, goldenHeight);
+
+		RenderGoldenScene(single, a);
+		RenderGoldenScene(several, b);
+
+		CHECK(std::memcmp(a.GetColorPtr(), b.GetColorPtr(), (size_t)goldenWidth * goldenHeight * sizeof(uint32_t)) == 0);
+		CHECK(std::memcmp(a.GetDepthPtr(), b.GetDepthPtr(), a.GetDepthPitch() * goldenHeight * sizeof(float)) == 0);
+	}
+
+	void TestDepthAndClear() {
+
+		JobSystem jobs;
+		SoftwareRenderer::FrameBuffer frame(goldenWidth, goldenHeight);
+		RenderGoldenScene(jobs, frame);
+
+		//the sky is left cleared, the ground fills the bottom of the screen in front of the far plane
+		CHECK(frame.GetColorPtr()[0] == clearColor);
+		CHECK(frame.GetDepthPtr()[0] == 1.0f);
+
+		const float bottom = frame.GetDepthPtr()[(goldenHeight - 1u) * frame.GetDepthPitch() + goldenWidth / 2u];
+		CHECK(bottom > 0.0f && bottom < 1.0f);
+		CHECK(frame.GetColorPtr()[(goldenHeight - 1u) * goldenWidth + goldenWidth / 2u] != clearColor);
+	}
+
+	void TestBackFacesCulled() {
+
+		JobSystem jobs(1u);
+		SoftwareRenderer renderer(jobs, 64u, 64u);
+
+		//the plane seen from below shows only its back faces
+		renderer.AddMesh(RenderScene::MakePlane(4.0f, 2u, 1.0f));
+
+		SoftwareRenderer::FrameBuffer frame(64u, 64u);
+		renderer.Render(frame, RenderScene::LookAtLH({ 0.0f,-3.0f,-0.1f }, { 0.0f,0.0f,0.0f }, { 0.0f,1.0f,0.0f }),
+			RenderScene::MakeProjection(), RenderScene::MakeLight(), clearColor);
+
+		CHECK(renderer.GetFrameStats().trianglesIn == 8u);
+		CHECK(std::all_of(frame.GetColorPtr(), frame.GetColorPtr() + 64u * 64u, [](uint32_t c) { return c == clearColor; }));
+
+		//and from above all of it
+		renderer.Render(frame, RenderScene::LookAtLH({ 0.0f,3.0f,-0.1f }, { 0.0f,0.0f,0.0f }, { 0.0f,1.0f,0.0f }),
+			RenderScene::MakeProjection(), RenderScene::MakeLight(), clearColor);
+
+		CHECK(frame.GetColorPtr()[32u * 64u + 32u] != clearColor);
+	}
+
+	void TestBilinearWrap() {
+
+		//Surface::Color texels: red, green / blue, white
+		const SoftwareRenderer::Texture texture(2u, 2u, { 0xFFFF0000u,0xFF00FF00u,0xFF0000FFu,0xFFFFFFFFu });
+
+		//texel centers come back as they are
+		const auto red = texture.Sample(0.25f, 0.25f);
+		CHECK(red.x == 1.0f && red.y == 0.0f && red.z == 0.0f && red.w == 1.0f);
+
+		//the corner is between all four texels once wrapped
+		const auto corner = texture.Sample(0.0f, 0.0f);
+		CHECK(std::abs(corner.x - 0.5f) < 1e-6f);
+		CHECK(std::abs(corner.y - 0.5f) < 1e-6f);
+		CHECK(std::abs(corner.z - 0.5f) < 1e-6f);
+
+		//whole repeats land on the same texel
+		const auto repeated = texture.Sample(3.75f, -1.75f);
+		const auto green = texture.Sample(0.75f, 0.25f);
+		CHECK(std::abs(repeated.y - green.y) < 1e-5f && std::abs(repeated.x - green.x) < 1e-5f);
+	}
+}
+
+int main()
+{
+	Test::Run("golden image", TestGoldenImage);
+	Test::Run("same frame on any thread count", TestDeterministicAcrossThreads);
+	Test::Run("depth and clear", TestDepthAndClear);
+	Test::Run("back faces culled", TestBackFacesCulled);
+	Test::Run("bilinear wrap sampling", TestBilinearWrap);
+
+	return Test::Finish();
+}
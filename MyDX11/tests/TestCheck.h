@@ -0,0 +1,51 @@
+#pragma once
+
+#include <exception>
+#include <iostream>
+
+//just enough of a test framework for the portable units' tests
+//a failed check is printed and the test goes on, main returns Test::Finish() so ctest sees the failures
+namespace Test {
+
+	inline int& GetFailureCount() noexcept {
+
+		static int failures = 0;
+		return failures;
+	}
+
+	inline void Check(bool passed, const char* expression, const char* file, int line) {
+
+		if (!passed) {
+
+			std::cerr << file << "(" << line << "): check failed: " << expression << std::endl;
+			GetFailureCount()++;
+		}
+	}
+
+	//an exception escaping a test counts as a failure of that test only
+	template<typename F>
+	void Run(const char* name, F&& test) {
+
+		const int before = GetFailureCount();
+
+		try {
+
+			test();
+		}
+		catch (const std::exception& e) {
+
+			std::cerr << name << ": threw " << e.what() << std::endl;
+			GetFailureCount()++;
+		}
+
+		std::cout << (GetFailureCount() == before ? "[pass] " : "[FAIL] ") << name << std::endl;
+	}
+
+	inline int Finish() {
+
+		std::cout << GetFailureCount() << " failed checks" << std::endl;
+		return GetFailureCount() == 0 ? 0 : 1;
+	}
+}
+
+#define CHECK(expression) Test::Check(static_cast<bool>(expression), #expression, __FILE__, __LINE__)
@@ -0,0 +1,491 @@
+#include "TestCheck.h"
+#include "TexturePacker.h"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+	std::string GetTempPath(const std::string& name) {
+
+		return (std::filesystem::temp_directory_path() / name).string();
+	}
+
+	TexturePacker::Item MakeItem(unsigned int width, unsigned int height, unsigned int mipLevels, DdsFormat format, uint32_t key = 0u) {
+
+		TexturePacker::Item item;
+		item.width = width;
+		item.height = height;
+		item.mipLevels = mipLevels;
+		item.format = format;
+		item.key = key;
+
+		return item;
+	}
+
+	//every item is in exactly the group its placement names, at the slice it names
+	bool IsEveryItemOnce(const TexturePacker& packer, size_t nItems) {
+
+		std::vector<int> seen(nItems, 0);
+		const auto& groups = packer.GetGroups();
+
+		for (size_t g = 0; g < groups.size(); g++) {
+
+			for (size_t k = 0; k < groups[g].items.size(); k++) {
+
+				const size_t i = groups[g].items[k];
+				const auto& placement = packer.GetPlacement(i);
+
+				seen[i]++;
+
+				if (placement.group != g || (!groups[g].isAtlas && placement.slice != k)) {
+
+					return false;
+				}
+			}
+		}
+
+		for (size_t i = 0; i < nItems; i++) {
+
+			if (seen[i] != (packer.GetPlacement(i).group == TexturePacker::none ? 0 : 1)) {
+
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	//same size, format, key and mip count share an array, in first appearance order
+	void TestArrays() {
+
+		std::vector<TexturePacker::Item> items = {
+			MakeItem(256u,256u,9u,DdsFormat::BC1Unorm),
+			MakeItem(256u,256u,9u,DdsFormat::BC3Unorm),
+			MakeItem(256u,256u,9u,DdsFormat::BC1Unorm),
+			MakeItem(256u,256u,9u,DdsFormat::BC1Unorm,1u),
+			MakeItem(256u,256u,8u,DdsFormat::BC1Unorm),
+			MakeItem(256u,256u,9u,DdsFormat::BC1Unorm),
+			MakeItem(256u,256u,9u,DdsFormat::BC3Unorm),
+			MakeItem(256u,128u,9u,DdsFormat::BC1Unorm),
+		};
+
+		TexturePacker packer;
+		packer.Pack(items);
+
+		const auto& groups = packer.GetGroups();
+
+		CHECK(IsEveryItemOnce(packer, items.size()));
+		CHECK(groups.size() >= 2u);
+
+		if (groups.size() >= 2u) {
+
+			CHECK(!groups[0].isAtlas && groups[0].format == DdsFormat::BC1Unorm && groups[0].mipLevels == 9u);
+			CHECK((groups[0].items == std::vector<size_t>{ 0u,2u,5u }));
+			CHECK(!groups[1].isAtlas && groups[1].format == DdsFormat::BC3Unorm);
+			CHECK((groups[1].items == std::vector<size_t>{ 1u,6u }));
+		}
+
+		//an array keeps the item's uvs
+		const auto& uv = packer.GetPlacement(5u).uv;
+		CHECK(uv.scaleU == 1.0f && uv.scaleV == 1.0f && uv.offsetU == 0.0f && uv.offsetV == 0.0f);
+
+		//past the array size limit a second array starts
+		std::vector<TexturePacker::Item> many(2050u, MakeItem(64u,64u,7u,DdsFormat::R8G8B8A8Unorm));
+		packer.Pack(many);
+
+		CHECK(packer.GetGroups().size() == 2u);
+		CHECK(packer.GetGroups()[0].items.size() == 2048u && packer.GetGroups()[1].items.size() == 2u);
+		CHECK(packer.GetPlacement(2049u).group == 1u && packer.GetPlacement(2049u).slice == 1u);
+		CHECK(IsEveryItemOnce(packer, many.size()));
+	}
+
+	//random sizes over many pages: cells on the gutter grid, gutters never shared, everything placed somewhere
+	void TestPages() {
+
+		TexturePacker::Config config;
+		config.maxAtlasSize = 1024u;
+		config.gutter = 32u;
+
+		TexturePacker packer(config);
+		std::mt19937 rng(3u);
+
+		std::vector<TexturePacker::Item> items;
+
+		for (int i = 0; i < 300; i++) {
+
+			//two formats and two keys so the buckets split, a few too big for any page
+			const DdsFormat format = i % 3 == 0 ? DdsFormat::BC3Unorm : DdsFormat::BC1Unorm;
+			const unsigned int largest = i % 50 == 7 ? 2048u : 300u;
+
+			items.push_back(MakeItem(4u + rng() % largest / 4u * 4u,4u + rng() % largest / 4u * 4u,1u + rng() % 10u,format,(uint32_t)(i % 2)));
+		}
+
+		packer.Pack(items);
+
+		const auto& groups = packer.GetGroups();
+		const unsigned int gutter = config.gutter;
+
+		CHECK(IsEveryItemOnce(packer, items.size()));
+
+		bool isInside = true;
+		bool isApart = true;
+		bool isSameBucket = true;
+		bool isMapped = true;
+		size_t nPages = 0u;
+
+		for (size_t g = 0; g < groups.size(); g++) {
+
+			const auto& group = groups[g];
+
+			if (!group.isAtlas) {
+
+				continue;
+			}
+
+			nPages++;
+
+			isInside &= group.width == group.height && (group.width & (group.width - 1u)) == 0u && group.width <= config.maxAtlasSize;
+
+			for (size_t a = 0; a < group.items.size(); a++) {
+
+				const auto& item = items[group.items[a]];
+				const auto& p = packer.GetPlacement(group.items[a]);
+
+				isSameBucket &= item.format == group.format && item.key == group.key && item.mipLevels >= group.mipLevels;
+
+				//on the gutter grid with a whole gutter to the page edges
+				isInside &= p.x % gutter == 0u && p.y % gutter == 0u;
+				isInside &= p.x >= gutter && p.y >= gutter && p.x + item.width + gutter <= group.width && p.y + item.height + gutter <= group.height;
+
+				const float size = (float)group.width;
+				isMapped &= p.uv.offsetU == p.x / size && p.uv.offsetV == p.y / size;
+				isMapped &= p.uv.scaleU == item.width / size && p.uv.scaleV == item.height / size;
+
+				//grown by half the gutter each side, the rectangles never touch
+				for (size_t b = a + 1u; b < group.items.size(); b++) {
+
+					const auto& other = items[group.items[b]];
+					const auto& q = packer.GetPlacement(group.items[b]);
+					const unsigned int half = gutter / 2u;
+
+					const bool isSeparateX = p.x + item.width + half <= q.x - half || q.x + other.width + half <= p.x - half;
+					const bool isSeparateY = p.y + item.height + half <= q.y - half || q.y + other.height + half <= p.y - half;
+
+					isApart &= isSeparateX || isSeparateY;
+				}
+			}
+		}
+
+		CHECK(isInside);
+		CHECK(isApart);
+		CHECK(isSameBucket);
+		CHECK(isMapped);
+
+		//far more than one page worth per bucket, so they spill onto new ones
+		CHECK(nPages >= 4u);
+
+		//only items too big for a page with their gutters, or at most the last one of each of the four buckets, stay alone
+		size_t nAlone = 0u;
+
+		for (size_t i = 0; i < items.size(); i++) {
+
+			const bool isTooBig = items[i].width + 2u * gutter > config.maxAtlasSize || items[i].height + 2u * gutter > config.maxAtlasSize;
+
+			if (packer.GetPlacement(i).group == TexturePacker::none && !isTooBig) {
+
+				nAlone++;
+			}
+		}
+
+		CHECK(nAlone <= 4u);
+
+		//the same list packs the same way every time
+		TexturePacker again(config);
+		again.Pack(items);
+
+		bool isSame = again.GetGroups().size() == groups.size();
+
+		for (size_t i = 0; i < items.size() && isSame; i++) {
+
+			isSame &= again.GetPlacement(i).group == packer.GetPlacement(i).group &&
+				again.GetPlacement(i).x == packer.GetPlacement(i).x && again.GetPlacement(i).y == packer.GetPlacement(i).y;
+		}
+
+		CHECK(isSame);
+	}
+
+	//BCn atlases keep two blocks of gutter on every level, which leaves three levels of a 32 texel gutter
+	void TestAtlasMips() {
+
+		const auto mipsOf = [](DdsFormat format, unsigned int gutter, unsigned int mipLevels) {
+
+			TexturePacker::Config config;
+			config.gutter = gutter;
+
+			TexturePacker packer(config);
+			packer.Pack({ MakeItem(100u,60u,mipLevels,format),MakeItem(64u,200u,mipLevels,format) });
+
+			return packer.GetGroups().size() == 1u && packer.GetGroups()[0].isAtlas ? packer.GetGroups()[0].mipLevels : 0u;
+		};
+
+		CHECK(mipsOf(DdsFormat::BC1Unorm, 32u, 10u) == 3u);
+		CHECK(mipsOf(DdsFormat::BC7Unorm, 32u, 10u) == 3u);
+		CHECK(mipsOf(DdsFormat::BC1Unorm, 64u, 10u) == 4u);
+		CHECK(mipsOf(DdsFormat::BC1Unorm, 8u, 10u) == 1u);
+		CHECK(mipsOf(DdsFormat::BC1Unorm, 4u, 10u) == 1u);
+		CHECK(mipsOf(DdsFormat::R8G8B8A8Unorm, 32u, 10u) == 5u);
+
+		//never more than the items have
+		CHECK(mipsOf(DdsFormat::BC1Unorm, 32u, 2u) == 2u);
+	}
+
+	//source textures whose every texel (4x4 block for BCn) names its item, level and position
+	struct Source {
+
+		std::string path;
+		std::unique_ptr<DdsFile> pFile;
+	};
+
+	Source WriteSource(const TexturePacker::Item& item, unsigned int index) {
+
+		const bool isCompressed = DdsFile::IsBlockCompressed(item.format);
+		const size_t unitBytes = isCompressed ? DdsFile::GetBitsPerTexel(item.format) * 2u : DdsFile::GetBitsPerTexel(item.format) / 8u;
+
+		std::vector<std::vector<uint8_t>> levels;
+		std::vector<DdsFile::Subresource> subresources;
+
+		for (unsigned int mip = 0; mip < item.mipLevels; mip++) {
+
+			const unsigned int width = std::max(1u, item.width >> mip);
+			const unsigned int height = std::max(1u, item.height >> mip);
+			const size_t rowPitch = DdsFile::GetRowPitch(item.format, width);
+			const unsigned int rows = DdsFile::GetRowCount(item.format, height);
+
+			levels.emplace_back(rowPitch * rows, (uint8_t)0u);
+
+			for (unsigned int row = 0; row < rows; row++) {
+
+				for (size_t column = 0; column < rowPitch / unitBytes; column++) {
+
+					uint8_t* p = levels.back().data() + row * rowPitch + column * unitBytes;
+					p[0] = (uint8_t)index;
+					p[1] = (uint8_t)mip;
+					p[2] = (uint8_t)column;
+					p[3] = (uint8_t)row;
+				}
+			}
+
+			subresources.push_back({ levels.back().data(),width,height,rowPitch,levels.back().size() });
+		}
+
+		DdsFile::Description desc;
+		desc.format = item.format;
+		desc.width = item.width;
+		desc.height = item.height;
+		desc.mipLevels = item.mipLevels;
+
+		Source source;
+		source.path = GetTempPath("MyDX11TexturePackerTests" + std::to_string(index) + ".dds");
+
+		DdsFile::Write(source.path, desc, subresources);
+		source.pFile = std::make_unique<DdsFile>(source.path);
+
+		return source;
+	}
+
+	//composes a page and reads it back: items copied whole, their edges repeated half a gutter out on every level,
+	//and the remapped uvs of the item's corners and edges land on texels of that item (or its repeated edge)
+	//for every texel a bilinear tap can reach
+	void CheckComposed(DdsFormat format, const std::vector<TexturePacker::Item>& items) {
+
+		TexturePacker packer;
+		packer.Pack(items);
+
+		CHECK(packer.GetGroups().size() == 1u);
+
+		if (packer.GetGroups().size() != 1u || !packer.GetGroups()[0].isAtlas) {
+
+			return;
+		}
+
+		const auto& group = packer.GetGroups()[0];
+
+		std::vector<Source> sources;
+		std::vector<const DdsFile*> files;
+
+		for (const auto i : group.items) {
+
+			sources.push_back(WriteSource(items[i], (unsigned int)i));
+			files.push_back(sources.back().pFile.get());
+		}
+
+		const std::string path = GetTempPath("MyDX11TexturePackerTestsAtlas.dds");
+		packer.Bake(0u, files, path);
+
+		bool isCopied = true;
+		bool isSampled = true;
+
+		{
+			const DdsFile atlas(path);
+			const auto& desc = atlas.GetDescription();
+
+			CHECK(desc.format == format && desc.width == group.width && desc.mipLevels == group.mipLevels);
+
+			const bool isCompressed = DdsFile::IsBlockCompressed(format);
+			const unsigned int unit = isCompressed ? 4u : 1u;
+			const size_t unitBytes = isCompressed ? DdsFile::GetBitsPerTexel(format) * 2u : DdsFile::GetBitsPerTexel(format) / 8u;
+
+			for (unsigned int mip = 0; mip < group.mipLevels; mip++) {
+
+				const auto& level = atlas.GetSubresource(mip);
+				const unsigned int spread = std::max(1u, (32u >> mip) / unit / 2u);
+
+				//the tag at a texel (block) of the composed level
+				const auto at = [&](int column, int row) {
+
+					const uint8_t* p = level.pData + row * level.rowPitch + column * unitBytes;
+					return std::vector<uint8_t>(p, p + 4);
+				};
+
+				for (const auto i : group.items) {
+
+					const auto& p = packer.GetPlacement(i);
+					const int left = (int)((p.x >> mip) / unit);
+					const int top = (int)((p.y >> mip) / unit);
+					const int columns = (int)DdsFile::GetRowCount(format, std::max(1u, items[i].width >> mip));
+					const int rows = (int)DdsFile::GetRowCount(format, std::max(1u, items[i].height >> mip));
+
+					//the repeated edge runs to the end of the item's cell (its size rounded up to the gutter) plus half the gutter
+					const int right = (int)(((items[i].width + 31u) / 32u * 32u >> mip) / unit + spread) + left;
+					const int bottom = (int)(((items[i].height + 31u) / 32u * 32u >> mip) / unit + spread) + top;
+
+					//the item and its repeated edge, clamped like a sampler would
+					for (int row = top - (int)spread; row < bottom; row++) {
+
+						for (int column = left - (int)spread; column < right; column++) {
+
+							const int sourceColumn = std::clamp(column - left, 0, columns - 1);
+							const int sourceRow = std::clamp(row - top, 0, rows - 1);
+
+							isCopied &= at(column, row) == std::vector<uint8_t>{ (uint8_t)i,(uint8_t)mip,(uint8_t)sourceColumn,(uint8_t)sourceRow };
+						}
+					}
+
+					//corners, edges and wrapped uvs, every bilinear tap inside what was just checked
+					const float uvs[] = { 0.0f,1e-4f,0.5f,0.9999f,1.0f,-0.25f,2.75f };
+					const float levelSize = (float)std::max(1u, group.width >> mip);
+
+					for (const float u0 : uvs) {
+
+						for (const float v0 : uvs) {
+
+							float u = u0;
+							float v = v0;
+							TexturePacker::RemapUv(p.uv, u, v);
+
+							const float x = u * levelSize - 0.5f;
+							const float y = v * levelSize - 0.5f;
+							const int firstColumn = (int)std::floor(x) / (int)unit;
+							const int lastColumn = ((int)std::floor(x) + 1) / (int)unit;
+							const int firstRow = (int)std::floor(y) / (int)unit;
+							const int lastRow = ((int)std::floor(y) + 1) / (int)unit;
+
+							const bool isInReach = firstColumn >= left - (int)spread && lastColumn < right &&
+								firstRow >= top - (int)spread && lastRow < bottom;
+
+							isSampled &= isInReach;
+
+							if (!isInReach) {
+
+								continue;
+							}
+
+							//the nearest texel is the one the item's own uv points at, either side when it falls right on a texel edge
+							const float itemU = (u0 - std::floor(u0)) * items[i].width / (float)(1u << mip);
+							const float itemV = (v0 - std::floor(v0)) * items[i].height / (float)(1u << mip);
+							const auto nearest = at((int)std::floor(u * levelSize) / (int)unit, (int)std::floor(v * levelSize) / (int)unit);
+
+							bool isNearest = false;
+
+							for (const float du : { -1e-3f,1e-3f }) {
+
+								for (const float dv : { -1e-3f,1e-3f }) {
+
+									const int column = std::clamp((int)std::floor(itemU + du) / (int)unit, 0, columns - 1);
+									const int row = std::clamp((int)std::floor(itemV + dv) / (int)unit, 0, rows - 1);
+
+									isNearest |= nearest == std::vector<uint8_t>{ (uint8_t)i,(uint8_t)mip,(uint8_t)column,(uint8_t)row };
+								}
+							}
+
+							isSampled &= isNearest;
+						}
+					}
+				}
+			}
+		}
+
+		CHECK(isCopied);
+		CHECK(isSampled);
+
+		//files that don't match what was packed are refused
+		std::reverse(files.begin(), files.end());
+		bool isRefused = false;
+
+		try {
+
+			packer.Bake(0u, files, path);
+		}
+		catch (const DdsFile::Exception&) {
+
+			isRefused = true;
+		}
+
+		CHECK(isRefused);
+
+		sources.clear();
+
+		for (const auto i : group.items) {
+
+			std::filesystem::remove(GetTempPath("MyDX11TexturePackerTests" + std::to_string(i) + ".dds"));
+		}
+
+		std::filesystem::remove(path);
+	}
+
+	void TestCompose() {
+
+		CheckComposed(DdsFormat::R8G8B8A8Unorm, {
+			MakeItem(100u,60u,7u,DdsFormat::R8G8B8A8Unorm),
+			MakeItem(64u,200u,8u,DdsFormat::R8G8B8A8Unorm),
+			MakeItem(33u,33u,6u,DdsFormat::R8G8B8A8Unorm),
+			MakeItem(128u,16u,8u,DdsFormat::R8G8B8A8Unorm),
+		});
+
+		CheckComposed(DdsFormat::BC1Unorm, {
+			MakeItem(128u,64u,8u,DdsFormat::BC1Unorm),
+			MakeItem(64u,256u,9u,DdsFormat::BC1Unorm),
+			MakeItem(36u,100u,7u,DdsFormat::BC1Unorm),
+		});
+
+		CheckComposed(DdsFormat::BC3Unorm, {
+			MakeItem(96u,96u,7u,DdsFormat::BC3Unorm),
+			MakeItem(32u,64u,7u,DdsFormat::BC3Unorm),
+		});
+	}
+}
+
+int main()
+{
+	Test::Run("arrays", TestArrays);
+	Test::Run("pages", TestPages);
+	Test::Run("atlas mips", TestAtlasMips);
+	Test::Run("compose", TestCompose);
+
+	return Test::Finish();
+}